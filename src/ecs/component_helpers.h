@@ -1,5 +1,9 @@
 #pragma once
 
+#include <filesystem>
+#include <functional>
+#include <system_error>
+
 #include "components.h"
 
 // Pure helper functions for ECS components
@@ -139,4 +143,152 @@ inline void setLineWidthLimit(LayoutComponent& layout, float chars) {
 
 }  // namespace layout
 
+namespace document {
+
+// Copy the live layout into the settings that are saved with the document
+inline void syncSettingsFromLayout(DocumentComponent& doc, const LayoutComponent& layout) {
+    doc.docSettings.textStyle = doc.buffer.textStyle();
+    doc.docSettings.pageSettings.mode = layout.pageMode;
+    doc.docSettings.pageSettings.pageWidth = layout.pageWidth;
+    doc.docSettings.pageSettings.pageHeight = layout.pageHeight;
+    doc.docSettings.pageSettings.pageMargin = layout.pageMargin;
+    doc.docSettings.pageSettings.lineWidthLimit = layout.lineWidthLimit;
+}
+
+// Snapshot the document and queue it for writing on the save thread.
+// Returns false for a large file, which is read-only.
+inline bool requestSave(DocumentComponent& doc, const LayoutComponent& layout,
+                        const std::string& path, SaveKind kind) {
+    if (doc.large) {
+        return false;
+    }
+    // Never save half a document
+    if (doc.loader && !doc.loader->done()) {
+        doc.loader->finish(doc.buffer);
+    }
+    syncSettingsFromLayout(doc, layout);
+    if (!doc.saver) {
+        doc.saver = std::make_unique<BackgroundSaver>();
+    }
+    doc.saver->requestSave(doc.buffer, doc.docSettings, path, kind);
+    return true;
+}
+
+// Export a snapshot of the document on the export thread; exportCall runs
+// there with a copy of the settings. Returns false if an export is already
+// running. ExportCompletionSystem reports the result.
+using ExportCall = std::function<DocumentResult(const TextBuffer& snapshot,
+                                                const DocumentSettings& settings,
+                                                const std::string& path,
+                                                ExportProgress& progress)>;
+inline bool startExport(DocumentComponent& doc, const LayoutComponent& layout,
+                        const std::string& path, ExportCall exportCall) {
+    if (doc.exporter && doc.exporter->isRunning()) {
+        return false;
+    }
+    // Never export half a document
+    if (doc.loader && !doc.loader->done()) {
+        doc.loader->finish(doc.buffer);
+    }
+    syncSettingsFromLayout(doc, layout);
+    if (!doc.exporter) {
+        doc.exporter = std::make_unique<BackgroundExporter>();
+    }
+    return doc.exporter->start(
+        doc.buffer, path,
+        [settings = doc.docSettings, path, exportCall = std::move(exportCall)](
+            const TextBuffer& snapshot, ExportProgress& progress) {
+            return exportCall(snapshot, settings, path, progress);
+        });
+}
+
+// Restart the journal against a full autosave of the current text. The old
+// journal stays as .prev until SaveCompletionSystem sees the write land.
+inline void checkpointJournal(DocumentComponent& doc, const LayoutComponent& layout) {
+    doc.journal->rebase(doc.buffer, doc.autoSavePath, true);
+    requestSave(doc, layout, doc.autoSavePath, SaveKind::AutoSave);
+}
+
+// Restart the journal for a document that matches what is on disk: its own
+// file, or nothing at all for an empty untitled document
+inline void rebaseJournalOnFile(DocumentComponent& doc, const LayoutComponent& layout) {
+    std::error_code ec;
+    if (!doc.filePath.empty() && std::filesystem::exists(doc.filePath, ec)) {
+        doc.journal->rebase(doc.buffer, doc.filePath, false);
+    } else if (doc.buffer.lineCount() == 1 && doc.buffer.lineSpan(0).length == 0) {
+        doc.journal->rebase(doc.buffer, "", false);
+    } else {
+        checkpointJournal(doc, layout);
+    }
+}
+
+// Leave large-file mode (for New, or once another file is open)
+inline void closeLargeFile(DocumentComponent& doc) {
+    if (doc.large) {
+        doc.large.reset();
+        doc.buffer.setReadOnly(false);
+    }
+}
+
+// Open a file of LargeDocument::THRESHOLD bytes or more read-only: the
+// buffer shows a window of its lines, moved by LargeFileSystem
+inline DocumentResult openLargeFile(DocumentComponent& doc, const std::string& path) {
+    DocumentResult result;
+    auto large = std::make_unique<LargeDocument>();
+    if (!large->open(path)) {
+        result.error = large->error();
+        return result;
+    }
+    if (doc.loader) {
+        doc.loader->cancel();
+    }
+    doc.buffer.setReadOnly(true);
+    large->loadWindow(doc.buffer, 0);
+    doc.large = std::move(large);
+    result.success = true;
+    result.usedFallback = true;
+    return result;
+}
+
+// Load path into the document: the first screen now, the rest over the
+// next frames (ProgressiveLoadSystem). Loaded text is not an edit, so the
+// journal is dropped and AutoSaveSystem starts a new one on the file once
+// loading is done.
+inline DocumentResult openDocument(DocumentComponent& doc, const std::string& path) {
+    doc.buffer.setEditListener(nullptr);
+    doc.journal.reset();
+    if (LargeDocument::wantsFile(path)) {
+        return openLargeFile(doc, path);
+    }
+    if (!doc.loader) {
+        doc.loader = std::make_unique<ProgressiveLoader>();
+    }
+    DocumentResult result = doc.loader->start(doc.buffer, doc.docSettings, path, &doc.images);
+    // A failed open leaves the large file (and its read-only window) alone
+    if (result.success) {
+        closeLargeFile(doc);
+    }
+    return result;
+}
+
+}  // namespace document
+
+namespace find_in_files {
+
+// Search menu.findInFilesFolder for menu.findInFilesTerm, replacing a search
+// still running without waiting for its workers. Returns false for a bad
+// pattern (see menu.findInFiles->error()).
+inline bool start(MenuComponent& menu) {
+    if (!menu.findInFiles) {
+        menu.findInFiles = std::make_shared<FindInFiles>();
+    }
+    menu.findInFilesResults.clear();
+    menu.findInFilesScrollOffset = 0;
+    FindInFilesOptions options;
+    options.find = menu.findOptions;
+    return menu.findInFiles->start(menu.findInFilesFolder, menu.findInFilesTerm, options);
+}
+
+}  // namespace find_in_files
+
 }  // namespace ecs
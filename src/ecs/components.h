@@ -1,12 +1,23 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "../editor/background_saver.h"
 #include "../editor/document_settings.h"
 #include "../editor/drawing.h"
+#include "../editor/edit_journal.h"
 #include "../editor/equation.h"
+#include "../editor/export/export_pipeline.h"
+#include "../editor/find_in_files.h"
 #include "../editor/image.h"
+#include "../editor/incremental_checker.h"
+#include "../editor/large_document.h"
+#include "../editor/progressive_loader.h"
 #include "../editor/table.h"
 #include "../editor/text_buffer.h"
 #include "../input/action_map.h"
@@ -32,6 +43,28 @@ struct ScrollComponent : public afterhours::BaseComponent {
     int secondaryOffset = 0;  // Secondary scroll offset for split view
 };
 
+// Pixel spans of the squiggles under each drawn row, relative to the row's
+// text start. renderTextBuffer measures a row once and reuses it until the
+// checker results, the text or the tab width change.
+struct SquiggleSpan {
+    int startX = 0;
+    int endX = 0;
+    SquiggleKind kind = SquiggleKind::Spelling;
+};
+
+struct SquiggleLayoutCache {
+    struct Row {
+        int fontSize = 0;  // 0 until measured
+        std::vector<SquiggleSpan> spans;
+    };
+    static constexpr std::size_t MAX_ROWS = 1024;
+
+    std::uint64_t resultsVersion = 0;
+    std::uint64_t bufferVersion = 0;
+    int tabWidth = 0;
+    std::unordered_map<std::size_t, Row> rows;
+};
+
 // Component for document state
 struct DocumentComponent : public afterhours::BaseComponent {
     TextBuffer buffer;
@@ -51,9 +84,40 @@ struct DocumentComponent : public afterhours::BaseComponent {
     // Auto-save state
     bool autoSaveEnabled = true;
     double lastAutoSaveTime = 0.0;
-    double autoSaveIntervalSeconds = 60.0;
+    // Was 60 s when this rewrote the whole document. The journal below now
+    // keeps every edit (synced to disk each second), so a full checkpoint
+    // is only needed every 5 minutes.
+    double autoSaveIntervalSeconds = 300.0;
     std::string autoSavePath = "output/autosave.wpdoc";
 
+    // Edits since the last checkpoint, appended to <autoSavePath>.journal
+    // every frame (created by AutoSaveSystem). The full document is only
+    // rewritten every autoSaveIntervalSeconds or once the journal passes
+    // autoSaveJournalLimit bytes.
+    std::unique_ptr<EditJournal> journal;
+    std::uint64_t autoSaveJournalLimit = 4 * 1024 * 1024;
+    double lastJournalSyncTime = 0.0;
+
+    // Saves run on a worker thread (created on first save); results are
+    // picked up by SaveCompletionSystem
+    std::unique_ptr<BackgroundSaver> saver;
+
+    // Opens large files a screen at a time (see document::openDocument);
+    // ProgressiveLoadSystem appends the rest while the UI runs
+    std::unique_ptr<ProgressiveLoader> loader;
+
+    // Exports run on a worker thread against a snapshot (created on first
+    // export); ExportCompletionSystem reports the result
+    std::unique_ptr<BackgroundExporter> exporter;
+
+    // Set while a file too big for the buffer is open read-only; the buffer
+    // then holds a window of its lines (see LargeFileSystem)
+    std::unique_ptr<LargeDocument> large;
+
+    // Background spell/grammar checking (created lazily by SpellCheckSystem)
+    bool spellCheckEnabled = true;
+    std::unique_ptr<IncrementalChecker> checker;
+
     // Tables embedded in the document (indexed by position in text)
     // Each table is associated with a line number where it appears
     std::vector<std::pair<std::size_t, Table>> tables;
@@ -95,10 +159,6 @@ struct DocumentComponent : public afterhours::BaseComponent {
         images.addImage(image);
     }
     
-    DocumentImage* imageById(std::size_t id) {
-        return images.getImage(id);
-    }
-    
     const DocumentImage* imageById(std::size_t id) const {
         return images.getImage(id);
     }
@@ -112,16 +172,19 @@ struct DocumentComponent : public afterhours::BaseComponent {
     
     // Equations embedded in the document
     EquationCollection equations;
+
+    // Scratch for renderImages/renderDrawings: the indices culled to the
+    // view, kept here so its capacity is reused from frame to frame
+    std::vector<std::size_t> visibleAnchored;
+
+    // Measured squiggle spans for renderTextBuffer
+    SquiggleLayoutCache squiggleLayout;
     
     // Drawing helper methods
     void insertDrawing(const DocumentDrawing& drawing) {
         drawings.addDrawing(drawing);
     }
     
-    DocumentDrawing* drawingById(std::size_t id) {
-        return drawings.getDrawing(id);
-    }
-    
     const DocumentDrawing* drawingById(std::size_t id) const {
         return drawings.getDrawing(id);
     }
@@ -174,6 +237,17 @@ struct MenuComponent : public afterhours::BaseComponent {
     char findInputBuffer[256] = {0};
     char replaceInputBuffer[256] = {0};
 
+    // Find in Files: search runs on worker threads, results are drained into
+    // findInFilesResults each frame while the dialog is open
+    bool showFindInFilesDialog = false;
+    std::string findInFilesFolder;
+    std::string findInFilesTerm;  // For afterhours text_input
+    std::shared_ptr<FindInFiles> findInFiles;
+    std::vector<FileMatch> findInFilesResults;
+    int findInFilesScrollOffset = 0;  // First result row shown
+    // Result picked in the dialog, opened by MenuSystem like a menu click
+    std::optional<FileMatch> findInFilesPicked;
+
     // Word count dialog
     bool showWordCountDialog = false;
 
@@ -12,8 +12,10 @@
 #include "../rl.h"
 #include "../settings.h"
 // test_input:: available via rl.h -> external.h
+#include "../ui/menu_setup.h"
 #include "../ui/theme.h"
 #include "../ui/ui_context.h"  // for toast_notify
+#include "../util/logging.h"
 #include "component_helpers.h"
 #include "components.h"
 
@@ -163,6 +165,7 @@ struct KeyboardShortcutSystem
 
         // New document
         if (actionMap_.isActionPressed(Action::New)) {
+            document::closeLargeFile(doc);
             doc.buffer.setText("");
             doc.filePath.clear();
             doc.isDirty = false;
@@ -176,35 +179,16 @@ struct KeyboardShortcutSystem
         if (actionMap_.isActionPressed(Action::Save)) {
             std::string savePath =
                 doc.filePath.empty() ? doc.defaultPath : doc.filePath;
-            // Sync layout settings to document settings before save
-            doc.docSettings.textStyle = doc.buffer.textStyle();
-            doc.docSettings.pageSettings.mode = layout.pageMode;
-            doc.docSettings.pageSettings.pageWidth = layout.pageWidth;
-            doc.docSettings.pageSettings.pageHeight = layout.pageHeight;
-            doc.docSettings.pageSettings.pageMargin = layout.pageMargin;
-            doc.docSettings.pageSettings.lineWidthLimit = layout.lineWidthLimit;
-            // Save document with all settings
-            auto result = saveDocumentEx(doc.buffer, doc.docSettings, savePath);
-            if (result.success) {
-                doc.isDirty = false;
-                doc.filePath = savePath;
-                if (!doc.autoSavePath.empty()) {
-                    std::filesystem::remove(doc.autoSavePath);
-                }
-                Settings::get().add_recent_file(savePath);
-                toast_notify::success(
-                    "Saved: " +
-                        std::filesystem::path(savePath).filename().string());
-            } else {
-                toast_notify::error("Save failed: " + result.error);
+            // Written on the save thread; SaveCompletionSystem reports back
+            if (!document::requestSave(doc, layout, savePath, SaveKind::Manual)) {
+                toast_notify::warning("Large files are read-only");
             }
         }
 
         // Open
         if (actionMap_.isActionPressed(Action::Open)) {
             // Load document with settings
-            auto result =
-                loadDocumentEx(doc.buffer, doc.docSettings, doc.defaultPath);
+            auto result = document::openDocument(doc, doc.defaultPath);
             if (result.success) {
                 doc.filePath = doc.defaultPath;
                 doc.isDirty = false;
@@ -529,12 +513,18 @@ struct NavigationSystem
 
         // Home/End with Ctrl for document start/end
         if (actionMap_.isActionPressedRepeat(Action::MoveDocumentStart)) {
-            navigateWithSelection([&]() { doc.buffer.moveToDocumentStart(); });
+            navigateWithSelection([&]() {
+                if (doc.large) doc.large->goToLine(doc.buffer, 0);
+                doc.buffer.moveToDocumentStart();
+            });
         } else if (actionMap_.isActionPressedRepeat(Action::MoveLineStart)) {
             navigateWithSelection([&]() { doc.buffer.moveToLineStart(); });
         }
         if (actionMap_.isActionPressedRepeat(Action::MoveDocumentEnd)) {
-            navigateWithSelection([&]() { doc.buffer.moveToDocumentEnd(); });
+            navigateWithSelection([&]() {
+                if (doc.large) doc.large->goToLine(doc.buffer, doc.large->lineCount() - 1);
+                doc.buffer.moveToDocumentEnd();
+            });
         } else if (actionMap_.isActionPressedRepeat(Action::MoveLineEnd)) {
             navigateWithSelection([&]() { doc.buffer.moveToLineEnd(); });
         }
@@ -591,43 +581,216 @@ struct NavigationSystem
     }
 };
 
-// System for auto-saving documents periodically
+// System for moving a large file's window as the view nears its edges.
+// Runs after NavigationSystem so it sees this frame's scroll offset.
+struct LargeFileSystem
+    : public afterhours::System<DocumentComponent, ScrollComponent> {
+    void for_each_with(afterhours::Entity& /*entity*/, DocumentComponent& doc,
+                       ScrollComponent& scroll, const float) override {
+        if (!doc.large) {
+            return;
+        }
+        std::ptrdiff_t shift = doc.large->followView(
+            doc.buffer, static_cast<std::size_t>(std::max(scroll.offset, 0)),
+            static_cast<std::size_t>(scroll.visibleLines));
+        if (shift != 0) {
+            scroll.offset += static_cast<int>(shift);
+            scroll::clamp(scroll, static_cast<int>(doc.buffer.lineCount()));
+        }
+    }
+};
+
+// System for crash protection: journals edits every frame and checkpoints
+// the whole document periodically
 struct AutoSaveSystem
     : public afterhours::System<DocumentComponent, LayoutComponent> {
     void for_each_with(afterhours::Entity& /*entity*/, DocumentComponent& doc,
                        LayoutComponent& layout,
                        const float) override {
-        if (!doc.autoSaveEnabled || !doc.isDirty) {
+        if (!doc.autoSaveEnabled) {
             return;
         }
+        if (doc.autoSavePath.empty()) {
+            doc.autoSavePath = "output/autosave.wpdoc";
+        }
+        if (doc.loader && !doc.loader->done()) {
+            return;  // The journal starts once the whole file is in
+        }
+        if (doc.large) {
+            return;  // Read-only: nothing to recover
+        }
 
         double now = raylib::GetTime();
-        if ((now - doc.lastAutoSaveTime) < doc.autoSaveIntervalSeconds) {
+        bool fresh = !doc.journal;
+        if (fresh) {
+            doc.journal = std::make_unique<EditJournal>(doc.autoSavePath + ".journal");
+            doc.buffer.setEditListener(doc.journal.get());
+        }
+
+        if (!doc.isDirty) {
+            // Nothing to recover while the document matches its file
+            if (fresh || doc.journal->recordCount() > 0) {
+                document::rebaseJournalOnFile(doc, layout);
+            }
             return;
         }
+        if (fresh) {
+            // Recovered or otherwise unsaved text: it needs a checkpoint
+            doc.lastAutoSaveTime = now;
+            document::checkpointJournal(doc, layout);
+        }
 
-        if (doc.autoSavePath.empty()) {
-            doc.autoSavePath = "output/autosave.wpdoc";
+        // Appending the frame's keystrokes is a few bytes of I/O
+        if (!doc.journal->flush()) {
+            LOG_WARNING("Journal write failed: %s", doc.journal->error().c_str());
+        }
+        if (now - doc.lastJournalSyncTime >= 1.0) {
+            doc.journal->sync();
+            doc.lastJournalSyncTime = now;
         }
 
-        std::filesystem::create_directories(
-            std::filesystem::path(doc.autoSavePath).parent_path());
+        bool intervalElapsed = (now - doc.lastAutoSaveTime) >= doc.autoSaveIntervalSeconds;
+        bool journalFull = doc.journal->bytesWritten() >= doc.autoSaveJournalLimit;
+        if (doc.journal->recordCount() == 0 || !(intervalElapsed || journalFull)) {
+            return;
+        }
+        // One checkpoint at a time, so the journal chain stays one link long
+        if (doc.journal->hasPrevious() ||
+            (doc.saver && doc.saver->isSaving(doc.autoSavePath))) {
+            return;
+        }
 
-        // Sync layout settings to document settings before save
-        doc.docSettings.textStyle = doc.buffer.textStyle();
-        doc.docSettings.pageSettings.mode = layout.pageMode;
-        doc.docSettings.pageSettings.pageWidth = layout.pageWidth;
-        doc.docSettings.pageSettings.pageHeight = layout.pageHeight;
-        doc.docSettings.pageSettings.pageMargin = layout.pageMargin;
-        doc.docSettings.pageSettings.lineWidthLimit = layout.lineWidthLimit;
+        // Snapshot now and write on the save thread. The timer restarts at
+        // the request so a slow disk never queues a second autosave.
+        doc.lastAutoSaveTime = now;
+        document::checkpointJournal(doc, layout);
+    }
+};
 
-        auto result = saveDocumentEx(doc.buffer, doc.docSettings, doc.autoSavePath);
-        if (result.success) {
-            doc.lastAutoSaveTime = now;
-            toast_notify::info("Auto-saved", 2.0f);
+// System for appending the rest of a document opened a screen at a time.
+// Each frame takes the batches the loader thread has ready.
+struct ProgressiveLoadSystem : public afterhours::System<DocumentComponent> {
+    void for_each_with(afterhours::Entity& /*entity*/, DocumentComponent& doc,
+                       const float) override {
+        if (!doc.loader || doc.loader->done()) {
+            return;
+        }
+        if (doc.loader->pump(doc.buffer)) {
+            return;
+        }
+        LOG_INFO("load first_screen_ms=%.2f,total_ms=%.2f,lines=%zu",
+                 doc.loader->firstScreenMs(), doc.loader->totalMs(), doc.buffer.lineCount());
+        if (!doc.loader->error().empty()) {
+            toast_notify::error("Open incomplete: " + doc.loader->error());
+        }
+    }
+};
+
+// System for reporting background saves once they finish. Runs every frame;
+// only touches the document when the save thread has results.
+struct SaveCompletionSystem
+    : public afterhours::System<DocumentComponent, MenuComponent> {
+    void for_each_with(afterhours::Entity& /*entity*/, DocumentComponent& doc,
+                       MenuComponent& menu, const float) override {
+        if (!doc.saver) {
+            return;
+        }
+        for (const SaveOutcome& outcome : doc.saver->takeCompleted()) {
+            LOG_INFO("save path=%s,kind=%s,success=%s,latency_ms=%.2f,write_ms=%.2f,queue=%zu",
+                     outcome.path.c_str(),
+                     outcome.kind == SaveKind::Manual ? "manual" : "autosave",
+                     outcome.result.success ? "true" : "false", outcome.latencyMs,
+                     outcome.writeMs, doc.saver->queueDepth());
+
+            if (outcome.kind == SaveKind::AutoSave) {
+                bool checkpoint = doc.journal && outcome.path == doc.autoSavePath;
+                if (outcome.result.success) {
+                    if (checkpoint) doc.journal->dropPrevious();
+                    toast_notify::info("Auto-saved", 2.0f);
+                } else {
+                    // Keep journaling against the last checkpoint that exists
+                    if (checkpoint) doc.journal->abandonRebase();
+                    toast_notify::error("Auto-save failed: " + outcome.result.error);
+                }
+                continue;
+            }
+
+            if (!outcome.result.success) {
+                toast_notify::error("Save failed: " + outcome.result.error);
+                continue;
+            }
+            // Edits made while the save was in flight keep the document dirty
+            if (doc.buffer.version() == outcome.bufferVersion) {
+                doc.isDirty = false;
+                // The saved file is the new base; the journal starts empty
+                if (doc.journal) doc.journal->rebase(doc.buffer, outcome.path, false);
+            }
+            doc.filePath = outcome.path;
+            if (!doc.autoSavePath.empty()) {
+                std::error_code ec;
+                std::filesystem::remove(doc.autoSavePath, ec);
+            }
+            Settings::get().add_recent_file(outcome.path);
+            menu.menus = menu_setup::createMenuBar(Settings::get().get_recent_files());
+            menu.recentFilesCount =
+                static_cast<int>(Settings::get().get_recent_files().size());
+            if (doc.trackChangesEnabled && menu.menus.size() > 1 &&
+                menu.menus[1].items.size() > 3) {
+                menu.menus[1].items[3].mark = win95::MenuMark::Checkmark;
+            }
+            toast_notify::success(
+                "Saved: " + std::filesystem::path(outcome.path).filename().string());
+        }
+    }
+};
+
+// System for exports running on the export thread: Escape cancels one in
+// progress, and the result is reported once the thread is done
+struct ExportCompletionSystem : public afterhours::System<DocumentComponent> {
+    void for_each_with(afterhours::Entity& /*entity*/, DocumentComponent& doc,
+                       const float) override {
+        if (!doc.exporter) {
+            return;
+        }
+        if (doc.exporter->isRunning()) {
+            if (IsKeyPressed(raylib::KEY_ESCAPE)) {
+                doc.exporter->cancel();
+            }
+            return;
+        }
+        std::optional<DocumentResult> result = doc.exporter->takeResult();
+        if (!result) {
+            return;
+        }
+        const ExportProgress& progress = doc.exporter->progress();
+        LOG_INFO("export path=%s,success=%s,ms=%.2f,rows=%zu,pages=%zu",
+                 doc.exporter->path().c_str(), result->success ? "true" : "false",
+                 doc.exporter->elapsedMs(), progress.rowsDone.load(),
+                 progress.pagesWritten.load());
+        std::string name = std::filesystem::path(doc.exporter->path()).filename().string();
+        if (result->success) {
+            toast_notify::success("Exported: " + name);
+        } else if (progress.cancelled()) {
+            toast_notify::info("Export cancelled", 2.0f);
         } else {
-            toast_notify::error("Auto-save failed: " + result.error);
+            toast_notify::error("Export failed: " + result->error);
+        }
+    }
+};
+
+// System for feeding edits to the background spell/grammar checker.
+// Only dirty paragraphs are re-hashed here; checking happens off-thread.
+struct SpellCheckSystem : public afterhours::System<DocumentComponent> {
+    void for_each_with(afterhours::Entity& /*entity*/, DocumentComponent& doc,
+                       const float) override {
+        if (!doc.spellCheckEnabled) {
+            doc.checker.reset();
+            return;
+        }
+        if (!doc.checker) {
+            doc.checker = std::make_unique<IncrementalChecker>();
         }
+        doc.checker->update(doc.buffer);
     }
 };
 
@@ -8,10 +8,12 @@
 #include <afterhours/src/plugins/modal.h>
 #include <afterhours/src/plugins/ui/text_input/text_input.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <sstream>
 
+#include "component_helpers.h"
 #include "components.h"
 #include "../input_mapping.h"  // For InputAction enum
 // test_input:: available via rl.h -> external.h
@@ -325,6 +327,110 @@ struct MenuUISystem : System<UIContext<InputAction>> {
             }
         }
         
+        // Find in Files - pulls matches from the worker threads each frame so
+        // hits appear while the search is still running
+        if (menu.showFindInFilesDialog) {
+            std::string status = "Enter text to search for in " + menu.findInFilesFolder;
+            if (menu.findInFiles) {
+                menu.findInFiles->drainResults(menu.findInFilesResults);
+                FindInFilesStats stats = menu.findInFiles->stats();
+                status = menu.findInFiles->isRunning()
+                    ? std::format("Searching {}... {}/{} files", menu.findInFilesFolder,
+                                  stats.filesSearched, stats.filesTotal)
+                    : std::format("{} matches in {} of {} files ({:.0f} ms)",
+                                  stats.matches, stats.filesWithMatches,
+                                  stats.filesTotal, stats.elapsedMs);
+            }
+
+            // Mouse wheel scrolls the result list
+            constexpr int VISIBLE_RESULTS = 12;
+            int resultCount = static_cast<int>(menu.findInFilesResults.size());
+            float wheel = GetMouseWheelMove();
+            if (wheel != 0.0f) {
+                menu.findInFilesScrollOffset -= static_cast<int>(wheel * 3);
+            }
+            menu.findInFilesScrollOffset = std::clamp(
+                menu.findInFilesScrollOffset, 0, std::max(0, resultCount - VISIBLE_RESULTS));
+
+            constexpr int FIND_IN_FILES_MODAL_ID = 50010;
+            auto result = afterhours::modal(ctx, mk(entity, FIND_IN_FILES_MODAL_ID),
+                menu.showFindInFilesDialog,
+                afterhours::ModalConfig{}
+                    .with_size(afterhours::ui::h720(560), afterhours::ui::h720(440))
+                    .with_title("Find in Files")
+                    .with_show_close_button(false));
+
+            if (result) {
+                using namespace afterhours::ui;
+                using namespace afterhours::ui::imm;
+                constexpr int CONTENT_LAYER = 1001;
+
+                afterhours::text_input::text_input(ctx, mk(result.ent(), 0),
+                    menu.findInFilesTerm,
+                    ComponentConfig{}
+                        .with_size(ComponentSize{percent(1.0f), h720(32)})
+                        .with_background(Theme::Usage::Surface)
+                        .with_render_layer(CONTENT_LAYER));
+
+                div(ctx, mk(result.ent(), 1),
+                    ComponentConfig{}
+                        .with_label(status)
+                        .with_size(ComponentSize{percent(1.0f), h720(24)})
+                        .with_padding(Spacing::xs)
+                        .with_render_layer(CONTENT_LAYER));
+
+                // Picking a result opens its file at the match
+                int last = std::min(resultCount,
+                                    menu.findInFilesScrollOffset + VISIBLE_RESULTS);
+                for (int i = menu.findInFilesScrollOffset; i < last; ++i) {
+                    const FileMatch& match =
+                        menu.findInFilesResults[static_cast<std::size_t>(i)];
+                    std::string label = std::format(
+                        "{}:{}: {}",
+                        std::filesystem::path(match.path).filename().string(),
+                        match.line + 1, match.preview);
+                    if (button(ctx, mk(result.ent(), 10 + (i - menu.findInFilesScrollOffset)),
+                        ComponentConfig{}
+                            .with_label(label)
+                            .with_size(ComponentSize{percent(1.0f), h720(20)})
+                            .with_render_layer(CONTENT_LAYER))) {
+                        menu.findInFilesPicked = match;
+                    }
+                }
+
+                auto button_row = div(ctx, mk(result.ent(), 2),
+                    ComponentConfig{}
+                        .with_size(ComponentSize{percent(1.0f), h720(44)})
+                        .with_flex_direction(FlexDirection::Row)
+                        .with_justify_content(JustifyContent::Center)
+                        .with_align_items(AlignItems::Center)
+                        .with_render_layer(CONTENT_LAYER));
+
+                if (button_row) {
+                    if (button(ctx, mk(button_row.ent(), 0),
+                        ComponentConfig{}
+                            .with_label("Search")
+                            .with_size(ComponentSize{h720(100), h720(32)})
+                            .with_background(Theme::Usage::Primary)
+                            .with_margin(Margin{.right = DefaultSpacing::small()})
+                            .with_render_layer(CONTENT_LAYER)) &&
+                        !menu.findInFilesTerm.empty()) {
+                        if (!find_in_files::start(menu)) {
+                            toast_notify::error("Find in Files: " + menu.findInFiles->error());
+                        }
+                    }
+                    if (button(ctx, mk(button_row.ent(), 1),
+                        ComponentConfig{}
+                            .with_label("Close")
+                            .with_size(ComponentSize{h720(100), h720(32)})
+                            .with_render_layer(CONTENT_LAYER))) {
+                        if (menu.findInFiles) menu.findInFiles->cancel();
+                        menu.showFindInFilesDialog = false;
+                    }
+                }
+            }
+        }
+
         // Comment input dialog
         if (menu.showCommentDialog) {
             constexpr int COMMENT_MODAL_ID = 50002;
@@ -8,9 +8,12 @@
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <limits>
 #include <sstream>
+#include <unordered_map>
 
 #include "../../vendor/afterhours/src/core/system.h"
+#include <afterhours/src/plugins/files.h>
 #include "../util/clipboard.h"
 #include "../editor/document_io.h"
 #include "../editor/export/export_html.h"
@@ -55,6 +58,150 @@ inline void drawTextExWithRegistry(raylib::Font font, const char* text,
     test_input::registerVisibleText(text);
 }
 
+// ============================================================================
+// Embedded images
+// ============================================================================
+
+// GPU textures made for ImageCache, by the handle given back to it
+inline std::unordered_map<ImageCache::TextureHandle, raylib::Texture2D>& imageTextures() {
+    static std::unordered_map<ImageCache::TextureHandle, raylib::Texture2D> textures;
+    return textures;
+}
+
+// raylib's loader wants a file type; embedded images have only bytes
+inline const char* imageFileType(const std::vector<std::uint8_t>& bytes) {
+    auto startsWith = [&bytes](std::string_view magic) {
+        return bytes.size() >= magic.size() &&
+               std::equal(magic.begin(), magic.end(), bytes.begin(),
+                          [](char m, std::uint8_t b) { return static_cast<std::uint8_t>(m) == b; });
+    };
+    if (startsWith("\x89PNG")) return ".png";
+    if (startsWith("\xFF\xD8")) return ".jpg";
+    if (startsWith("GIF8")) return ".gif";
+    if (startsWith("BM")) return ".bmp";
+    if (startsWith("qoif")) return ".qoi";
+    return nullptr;
+}
+
+// Decode with raylib and upload textures through it
+inline void installImageCodecs(ImageCache& cache) {
+    cache.setDecoder([](const std::vector<std::uint8_t>& bytes, ImagePixels& out) {
+        const char* fileType = imageFileType(bytes);
+        if (!fileType) return false;
+        raylib::Image image = raylib::LoadImageFromMemory(fileType, bytes.data(),
+                                                          static_cast<int>(bytes.size()));
+        if (!image.data) return false;
+        raylib::ImageFormat(&image, raylib::PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+        out.width = image.width;
+        out.height = image.height;
+        const auto* data = static_cast<const std::uint8_t*>(image.data);
+        out.rgba.assign(data, data + static_cast<std::size_t>(image.width) *
+                                         static_cast<std::size_t>(image.height) * 4);
+        raylib::UnloadImage(image);
+        return true;
+    });
+    cache.setTextureHooks(
+        {[](const ImagePixels& pixels) -> ImageCache::TextureHandle {
+             raylib::Image image{const_cast<std::uint8_t*>(pixels.rgba.data()), pixels.width,
+                                 pixels.height, 1, raylib::PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+             raylib::Texture2D texture = raylib::LoadTextureFromImage(image);
+             if (texture.id == 0) return 0;
+             imageTextures()[texture.id] = texture;
+             return texture.id;
+         },
+         [](ImageCache::TextureHandle handle) {
+             auto it = imageTextures().find(handle);
+             if (it == imageTextures().end()) return;
+             // The cache can outlive the window at shutdown
+             if (raylib::IsWindowReady()) raylib::UnloadTexture(it->second);
+             imageTextures().erase(it);
+         }});
+}
+
+// Images whose rectangles reach into the visible rows, including tall ones
+// anchored above them. Only these are decoded and uploaded; endFrame()
+// then lets textures of images scrolled away go over budget.
+// visible is scratch space for the culled indices, kept by the caller so
+// drawing does not allocate from frame to frame.
+inline void renderImages(ImageCollection& images, const LayoutComponent::Rect& area,
+                         int scrollOffset, int lineHeight, float zoomLevel,
+                         std::vector<std::size_t>& visible) {
+    ImageCache& cache = images.cache();
+    if (!images.isEmpty() && lineHeight > 0) {
+        const ImageCollection& placed = images;
+        float padding = static_cast<float>(theme::layout::TEXT_PADDING);
+        float rowHeight = static_cast<float>(lineHeight);
+        float viewTop = static_cast<float>(std::max(0, scrollOffset)) * rowHeight;
+        placed.imagesOverlapping(viewTop, viewTop + area.height, rowHeight, zoomLevel, visible);
+        for (std::size_t index : visible) {
+            const DocumentImage* image = &placed.images()[index];
+            float width = image->displayWidth * zoomLevel;
+            float height = image->displayHeight * zoomLevel;
+            if (width <= 0.0f || height <= 0.0f) continue;
+            raylib::Rectangle dest = {
+                area.x + padding + image->offsetX * zoomLevel,
+                area.y + padding + static_cast<float>(image->anchorLine) * rowHeight - viewTop +
+                    image->offsetY * zoomLevel,
+                width, height};
+
+            ImageCache::TextureHandle handle =
+                image->contentKey != 0 ? cache.texture(image->contentKey, width, height) : 0;
+            auto it = imageTextures().find(handle);
+            if (it != imageTextures().end()) {
+                const raylib::Texture2D& texture = it->second;
+                raylib::DrawTexturePro(texture,
+                                       {0.0f, 0.0f, static_cast<float>(texture.width),
+                                        static_cast<float>(texture.height)},
+                                       dest, {0.0f, 0.0f}, 0.0f,
+                                       raylib::Color{255, 255, 255, 255});
+            } else {
+                // No data (placeholder) or it did not decode
+                raylib::DrawRectangleRec(dest, raylib::Color{230, 230, 230, 255});
+                raylib::DrawRectangleLinesEx(dest, 1.0f, theme::BORDER_DARK);
+                drawTextWithRegistry(image->altText.c_str(), static_cast<int>(dest.x) + 4,
+                                     static_cast<int>(dest.y) + 4, 10, theme::TEXT_COLOR);
+            }
+        }
+    }
+    cache.endFrame();
+}
+
+// Drawings whose bounds reach into the visible rows, from their cached
+// triangles (drawing_geometry.h): a frame only tessellates drawings that
+// were edited or zoomed into another bucket since the last one.
+// visible is scratch space as for renderImages.
+inline void renderDrawings(const DrawingCollection& drawings, const LayoutComponent::Rect& area,
+                           int scrollOffset, int lineHeight, float zoomLevel,
+                           std::vector<std::size_t>& visible) {
+    if (drawings.isEmpty() || lineHeight <= 0) return;
+    float padding = static_cast<float>(theme::layout::TEXT_PADDING);
+    float rowHeight = static_cast<float>(lineHeight);
+    float viewTop = static_cast<float>(std::max(0, scrollOffset)) * rowHeight;
+    drawings.drawingsOverlapping(viewTop, viewTop + area.height, rowHeight, zoomLevel, visible);
+
+    auto drawTriangles = [zoomLevel](const std::vector<drawing_geometry::Vertex>& vertices,
+                                     float originX, float originY, DrawingColor color) {
+        if (color.isTransparent()) return;
+        raylib::Color tint{color.r, color.g, color.b, color.a};
+        for (std::size_t i = 0; i + 2 < vertices.size(); i += 3) {
+            auto screen = [&](const drawing_geometry::Vertex& v) {
+                return raylib::Vector2{originX + v.x * zoomLevel, originY + v.y * zoomLevel};
+            };
+            raylib::DrawTriangle(screen(vertices[i]), screen(vertices[i + 1]),
+                                 screen(vertices[i + 2]), tint);
+        }
+    };
+    for (std::size_t index : visible) {
+        const DocumentDrawing& drawing = drawings.drawings()[index];
+        const drawing_geometry::Mesh& mesh = drawings.geometry(index, zoomLevel);
+        float originX = area.x + padding;
+        float originY =
+            area.y + padding + static_cast<float>(drawing.anchorLine) * rowHeight - viewTop;
+        drawTriangles(mesh.fill, originX, originY, drawing.fillColor);
+        drawTriangles(mesh.stroke, originX, originY, drawing.strokeColor);
+    }
+}
+
 // Draw a page background with shadow (for paged mode)
 // Uses afterhours draw_rectangle via draw:: wrapper
 inline void drawPageBackground(const LayoutComponent& layout) {
@@ -114,20 +261,32 @@ inline void drawPageBackground(const LayoutComponent& layout) {
 }
 
 // Render a table at a specific position
+// clipTop/clipBottom: screen rows outside this range are not drawn
 inline void renderTable(const Table& table, float tableX, float tableY, 
-                        CellPosition currentCell, bool isEditing) {
+                        CellPosition currentCell, bool isEditing,
+                        float clipTop = -std::numeric_limits<float>::infinity(),
+                        float clipBottom = std::numeric_limits<float>::infinity()) {
     if (table.isEmpty()) return;
     
-    // Draw table cells
-    for (std::size_t row = 0; row < table.rowCount(); ++row) {
+    // Draw table cells, only in the rows that overlap the clip range
+    Table::RowRange rows = table.visibleRows(clipTop - tableY, clipBottom - tableY);
+    for (std::size_t row = rows.first; row < rows.last; ++row) {
         for (std::size_t col = 0; col < table.colCount(); ++col) {
-            const TableCell& cell = table.cell(row, col);
+            CellPosition pos{row, col};
+            const TableCell* covered = &table.cell(pos);
             
-            // Skip cells that are part of a merge (not the parent)
-            if (cell.isMerged) continue;
+            // Skip cells that are part of a merge (not the parent), unless
+            // the parent's row is scrolled off: then the first visible row
+            // draws it in its place
+            if (covered->isMerged) {
+                CellPosition parent = covered->mergeParent;
+                if (row != rows.first || parent.row >= rows.first || parent.col != col) continue;
+                pos = parent;
+            }
+            const TableCell& cell = table.cell(pos);
             
             // Get cell bounds
-            Table::CellBounds bounds = table.cellBounds({row, col});
+            Table::CellBounds bounds = table.cellBounds(pos);
             float cellX = tableX + bounds.x;
             float cellY = tableY + bounds.y;
             float cellW = bounds.width;
@@ -225,7 +384,7 @@ inline void renderTable(const Table& table, float tableX, float tableY,
             }
             
             // Highlight current cell if editing
-            if (isEditing && row == currentCell.row && col == currentCell.col) {
+            if (isEditing && pos == currentCell) {
                 raylib::DrawRectangleLinesEx(
                     {cellX, cellY, cellW, cellH}, 2.0f, 
                     raylib::Color{0, 120, 215, 255});  // Blue highlight
@@ -252,19 +411,28 @@ inline void renderDocumentTables(const std::vector<std::pair<std::size_t, Table>
         if (y > static_cast<int>(textArea.y + textArea.height)) continue;
         
         bool isEditing = (lineNum == editingLine);
-        renderTable(table, static_cast<float>(x), static_cast<float>(y), currentCell, isEditing);
+        renderTable(table, static_cast<float>(x), static_cast<float>(y), currentCell, isEditing,
+                    textArea.y, textArea.y + textArea.height);
     }
 }
 
 // Render the text buffer with caret and selection
 // Now supports per-line paragraph styles (H1-H6, Title, Subtitle)
 // showLineNumbers: if true, draws line numbers in a gutter on the left
+// checker: if set, draws its spelling/grammar squiggles under each row
+// firstLineNumber: number shown for row 0 (a large file's window starts
+// part way through the file)
+// squiggleLayout: if set, keeps each row's measured squiggle spans between
+// frames
 inline void renderTextBuffer(const TextBuffer& buffer,
                              const LayoutComponent::Rect& textArea,
                              bool caretVisible, int baseFontSize, int baseLineHeight,
                              int scrollOffset, bool showLineNumbers = false,
                              float lineNumberGutterWidth = 50.0f,
-                             int tabWidth = 4, float zoomLevel = 1.0f) {
+                             int tabWidth = 4, float zoomLevel = 1.0f,
+                             const IncrementalChecker* checker = nullptr,
+                             std::size_t firstLineNumber = 1,
+                             SquiggleLayoutCache* squiggleLayout = nullptr) {
     std::size_t lineCount = buffer.lineCount();
     CaretPosition caret = buffer.caret();
     bool hasSelection = buffer.hasSelection();
@@ -279,8 +447,19 @@ inline void renderTextBuffer(const TextBuffer& buffer,
     std::size_t startRow = static_cast<std::size_t>(scrollOffset);
     if (startRow >= lineCount) startRow = lineCount > 0 ? lineCount - 1 : 0;
 
+    // Measured spans hold while the results, the text and the tab width do
+    if (checker && squiggleLayout &&
+        (squiggleLayout->resultsVersion != checker->resultsVersion() ||
+         squiggleLayout->bufferVersion != buffer.version() ||
+         squiggleLayout->tabWidth != tabWidth)) {
+        squiggleLayout->rows.clear();
+        squiggleLayout->resultsVersion = checker->resultsVersion();
+        squiggleLayout->bufferVersion = buffer.version();
+        squiggleLayout->tabWidth = tabWidth;
+    }
+
     for (std::size_t row = startRow; row < lineCount; ++row) {
-        LineSpan span = buffer.lineSpan(row);
+        LineExtent span = buffer.lineExtent(row);
         int baseX = static_cast<int>(textArea.x) + theme::layout::TEXT_PADDING + gutterOffset;
         int availableWidth = static_cast<int>(textArea.width) - 2 * theme::layout::TEXT_PADDING;
 
@@ -352,9 +531,9 @@ inline void renderTextBuffer(const TextBuffer& buffer,
         
         // Draw line number in gutter if enabled
         if (showLineNumbers) {
-            int lineNum = static_cast<int>(row + 1);  // 1-based line numbers
-            char lineNumStr[16];
-            std::snprintf(lineNumStr, sizeof(lineNumStr), "%d", lineNum);
+            std::size_t lineNum = row + firstLineNumber;  // 1-based line numbers
+            char lineNumStr[24];
+            std::snprintf(lineNumStr, sizeof(lineNumStr), "%zu", lineNum);
             
             // Measure line number text to right-align in gutter
             int numWidth = raylib::MeasureText(lineNumStr, 14);
@@ -449,6 +628,51 @@ inline void renderTextBuffer(const TextBuffer& buffer,
             }
         }
 
+        // Draw spelling (red) and grammar (blue) squiggles under the text.
+        // Measuring them expands tabs and calls MeasureText twice per
+        // squiggle, so the spans are kept in squiggleLayout when given.
+        if (checker && !line.empty() && !checker->squigglesForRow(row).empty()) {
+            const std::vector<Squiggle>& squiggles = checker->squigglesForRow(row);
+            SquiggleLayoutCache::Row uncached;
+            SquiggleLayoutCache::Row* measured = &uncached;
+            if (squiggleLayout) {
+                if (squiggleLayout->rows.size() >= SquiggleLayoutCache::MAX_ROWS &&
+                    !squiggleLayout->rows.count(row)) {
+                    squiggleLayout->rows.clear();
+                }
+                measured = &squiggleLayout->rows[row];
+            }
+            if (measured->fontSize != lineFontSize) {
+                measured->fontSize = lineFontSize;
+                measured->spans.clear();
+                for (const Squiggle& squiggle : squiggles) {
+                    if (squiggle.column >= line.size()) continue;
+                    std::size_t length = std::min(squiggle.length, line.size() - squiggle.column);
+                    int startX = raylib::MeasureText(
+                        expandTabs(line.substr(0, squiggle.column)).c_str(), lineFontSize);
+                    int endX = raylib::MeasureText(
+                        expandTabs(line.substr(0, squiggle.column + length)).c_str(),
+                        lineFontSize);
+                    measured->spans.push_back({startX, endX, squiggle.kind});
+                }
+            }
+
+            int squiggleY = y + lineFontSize + 2;
+            for (const SquiggleSpan& span : measured->spans) {
+                int startX = x + span.startX;
+                int endX = x + span.endX;
+                raylib::Color color = span.kind == SquiggleKind::Spelling
+                                          ? raylib::Color{220, 0, 0, 255}
+                                          : raylib::Color{0, 90, 220, 255};
+                for (int px = startX; px < endX; px += 4) {
+                    int nextX = std::min(px + 2, endX);
+                    raylib::DrawLine(px, squiggleY + 1, nextX, squiggleY - 1, color);
+                    raylib::DrawLine(nextX, squiggleY - 1, std::min(px + 4, endX),
+                                     squiggleY + 1, color);
+                }
+            }
+        }
+
         // Draw text with paragraph style applied
         if (!line.empty()) {
             // Register document text for E2E tests
@@ -540,6 +764,8 @@ inline void renderTextBuffer(const TextBuffer& buffer,
 void handleMenuActionImpl(int menuResult, DocumentComponent& doc,
                           MenuComponent& menu,
                           LayoutComponent& layout);
+void openFindInFilesMatchImpl(const FileMatch& match, DocumentComponent& doc,
+                              MenuComponent& menu, LayoutComponent& layout);
 void drawHelpWindowImpl(MenuComponent& menu, const LayoutComponent& layout);
 
 // System for rendering the complete editor UI
@@ -684,6 +910,7 @@ struct EditorRenderSystem
         int fontSize = std::max(8, static_cast<int>(std::round(style.fontSize * layout.zoomLevel)));
         int lineHeight = fontSize + 4;
         LayoutComponent::Rect effectiveArea = layout::effectiveTextArea(layout);
+        std::size_t firstLineNumber = doc.large ? doc.large->windowFirst() + 1 : 1;
 
         if (layout.splitViewEnabled) {
             float splitHeight = effectiveArea.height * 0.5f;
@@ -694,11 +921,13 @@ struct EditorRenderSystem
             renderTextBuffer(doc.buffer, topArea, caret.visible, fontSize,
                              lineHeight, scroll.offset, layout.showLineNumbers,
                              layout.lineNumberGutterWidth, doc.docSettings.tabWidth,
-                             layout.zoomLevel);
+                             layout.zoomLevel, doc.checker.get(), firstLineNumber,
+                             &mutableDoc.squiggleLayout);
             renderTextBuffer(doc.buffer, bottomArea, caret.visible, fontSize,
                              lineHeight, scroll.secondaryOffset, layout.showLineNumbers,
                              layout.lineNumberGutterWidth, doc.docSettings.tabWidth,
-                             layout.zoomLevel);
+                             layout.zoomLevel, doc.checker.get(), firstLineNumber,
+                             &mutableDoc.squiggleLayout);
 
             // Split divider
             raylib::DrawLine(static_cast<int>(effectiveArea.x),
@@ -710,9 +939,15 @@ struct EditorRenderSystem
             renderTextBuffer(doc.buffer, effectiveArea, caret.visible, fontSize,
                              lineHeight, scroll.offset, layout.showLineNumbers,
                              layout.lineNumberGutterWidth, doc.docSettings.tabWidth,
-                             layout.zoomLevel);
+                             layout.zoomLevel, doc.checker.get(), firstLineNumber,
+                             &mutableDoc.squiggleLayout);
         }
 
+        renderImages(mutableDoc.images, effectiveArea, scroll.offset, lineHeight,
+                     layout.zoomLevel, mutableDoc.visibleAnchored);
+        renderDrawings(doc.drawings, effectiveArea, scroll.offset, lineHeight, layout.zoomLevel,
+                       mutableDoc.visibleAnchored);
+
         // Draw comment markers in the right margin
         if (!doc.comments.empty()) {
             for (const auto& comment : doc.comments) {
@@ -738,16 +973,37 @@ struct EditorRenderSystem
             CaretPosition caretPos = doc.buffer.caret();
             ParagraphStyle paraStyle = doc.buffer.currentParagraphStyle();
             TextStats stats = doc.buffer.stats();
-            std::string statusText = std::format(
-                "Ln {}, Col {} | {} | {}{}{}{}| {}pt | {} | Words: {} | Zoom: {}%",
-                caretPos.row + 1, caretPos.column + 1,
-                paragraphStyleName(paraStyle),
-                style.bold ? "B " : "",
-                style.italic ? "I " : "",
-                style.underline ? "U " : "",
-                style.strikethrough ? "S " : "",
-                style.fontSize, style.font, stats.words,
-                static_cast<int>(layout.zoomLevel * 100.0f));
+            std::string statusText;
+            if (doc.large) {
+                // Rows and the line count are the file's, not the window's
+                statusText = std::format(
+                    "Ln {} of {}{} | Read-only | {}pt | {} | Zoom: {}%",
+                    doc.large->windowFirst() + caretPos.row + 1, doc.large->lineCount(),
+                    doc.large->indexed() ? "" : "+", style.fontSize, style.font,
+                    static_cast<int>(layout.zoomLevel * 100.0f));
+            } else {
+                statusText = std::format(
+                    "Ln {}, Col {} | {} | {}{}{}{}| {}pt | {} | Words: {} | Zoom: {}%",
+                    caretPos.row + 1, caretPos.column + 1,
+                    paragraphStyleName(paraStyle),
+                    style.bold ? "B " : "",
+                    style.italic ? "I " : "",
+                    style.underline ? "U " : "",
+                    style.strikethrough ? "S " : "",
+                    style.fontSize, style.font, stats.words,
+                    static_cast<int>(layout.zoomLevel * 100.0f));
+            }
+            if (doc.loader && !doc.loader->done()) {
+                statusText = std::format("Loading {}% | ",
+                                         static_cast<int>(doc.loader->progress() * 100.0)) +
+                             statusText;
+            }
+            if (doc.exporter && doc.exporter->isRunning()) {
+                statusText = std::format("Exporting {}% (Esc to cancel) | ",
+                                         static_cast<int>(doc.exporter->progress().fraction() *
+                                                          100.0)) +
+                             statusText;
+            }
             drawTextWithRegistry(
                 statusText.c_str(), 4,
                 layout.screenHeight - theme::layout::STATUS_BAR_HEIGHT + 2,
@@ -811,6 +1067,13 @@ struct MenuSystem
             handleMenuAction(menuResult, doc, menu, layout);
         }
 
+        // A result picked in the Find in Files dialog
+        if (menu.findInFilesPicked) {
+            FileMatch match = std::move(*menu.findInFilesPicked);
+            menu.findInFilesPicked.reset();
+            openFindInFilesMatchImpl(match, doc, menu, layout);
+        }
+
         // Note: About, Word Count, Comment, Template, and Tab Width dialogs
         // are now rendered by MenuUISystem using afterhours modal.h
 
@@ -838,6 +1101,63 @@ struct MenuSystem
     }
 };
 
+// Open path in place of the current document, as File > Recent does.
+// Returns false (after reporting why) if it could not be opened.
+inline bool openDocumentImpl(const std::string& path, DocumentComponent& doc,
+                             MenuComponent& menu, LayoutComponent& layout) {
+    auto result = document::openDocument(doc, path);
+    if (!result.success) {
+        toast_notify::error("Open failed: " + result.error);
+        return false;
+    }
+    doc.filePath = path;
+    doc.isDirty = false;
+    doc.comments.clear();
+    doc.revisions.clear();
+    layout.pageMode = doc.docSettings.pageSettings.mode;
+    layout.pageWidth = doc.docSettings.pageSettings.pageWidth;
+    layout.pageHeight = doc.docSettings.pageSettings.pageHeight;
+    layout.pageMargin = doc.docSettings.pageSettings.pageMargin;
+    layout.lineWidthLimit = doc.docSettings.pageSettings.lineWidthLimit;
+    Settings::get().add_recent_file(path);
+    menu.menus = menu_setup::createMenuBar(Settings::get().get_recent_files());
+    menu.recentFilesCount = static_cast<int>(Settings::get().get_recent_files().size());
+    if (doc.trackChangesEnabled && menu.menus.size() > 1 && menu.menus[1].items.size() > 3) {
+        menu.menus[1].items[3].mark = win95::MenuMark::Checkmark;
+    }
+    toast_notify::success("Opened: " + std::filesystem::path(path).filename().string());
+    return true;
+}
+
+// Show a Find in Files hit: open its file (unless it is the one being
+// edited, whose unsaved changes are kept) and select the match.
+// NavigationSystem then scrolls the caret into view.
+inline void openFindInFilesMatchImpl(const FileMatch& match, DocumentComponent& doc,
+                                     MenuComponent& menu, LayoutComponent& layout) {
+    std::error_code ec;
+    bool alreadyOpen = !doc.filePath.empty() &&
+                       std::filesystem::equivalent(doc.filePath, match.path, ec);
+    if (!alreadyOpen && !openDocumentImpl(match.path, doc, menu, layout)) {
+        return;
+    }
+
+    if (doc.large) {
+        doc.large->goToLine(doc.buffer, match.line, match.column);
+    } else {
+        // The match may lie past what the progressive load has reached
+        if (match.line >= doc.buffer.lineCount() && doc.loader && !doc.loader->done()) {
+            doc.loader->finish(doc.buffer);
+        }
+        std::size_t row = std::min(match.line, doc.buffer.lineCount() - 1);
+        doc.buffer.setCaret({row, std::min(match.column, doc.buffer.lineSpan(row).length)});
+    }
+    CaretPosition start = doc.buffer.caret();
+    doc.buffer.setSelectionAnchor(start);
+    doc.buffer.setCaret(
+        {start.row, std::min(start.column + match.length, doc.buffer.lineSpan(start.row).length)});
+    doc.buffer.updateSelectionToCaret();
+}
+
 // Implementation of menu action handler (called by both EditorRenderSystem and MenuSystem)
 inline void handleMenuActionImpl(int menuResult, DocumentComponent& doc,
                           MenuComponent& menu,
@@ -851,34 +1171,7 @@ inline void handleMenuActionImpl(int menuResult, DocumentComponent& doc,
                 const std::string& label = menu.menus[0].items[itemIndex].label;
                 if (label.rfind("Recent: ", 0) == 0) {
                     std::string path = label.substr(std::string("Recent: ").size());
-                    auto result = loadDocumentEx(doc.buffer, doc.docSettings, path);
-                    if (result.success) {
-                        doc.filePath = path;
-                        doc.isDirty = false;
-                        doc.comments.clear();
-                        doc.revisions.clear();
-                        layout.pageMode = doc.docSettings.pageSettings.mode;
-                        layout.pageWidth = doc.docSettings.pageSettings.pageWidth;
-                        layout.pageHeight = doc.docSettings.pageSettings.pageHeight;
-                        layout.pageMargin = doc.docSettings.pageSettings.pageMargin;
-                        layout.lineWidthLimit =
-                            doc.docSettings.pageSettings.lineWidthLimit;
-                        Settings::get().add_recent_file(path);
-                        menu.menus = menu_setup::createMenuBar(
-                            Settings::get().get_recent_files());
-                        menu.recentFilesCount = static_cast<int>(
-                            Settings::get().get_recent_files().size());
-                        if (doc.trackChangesEnabled &&
-                            menu.menus.size() > 1 &&
-                            menu.menus[1].items.size() > 3) {
-                            menu.menus[1].items[3].mark =
-                                win95::MenuMark::Checkmark;
-                        }
-                        toast_notify::success(
-                            "Opened: " + std::filesystem::path(path).filename().string());
-                    } else {
-                        toast_notify::error("Open failed: " + result.error);
-                    }
+                    openDocumentImpl(path, doc, menu, layout);
                     return;
                 }
                 if (label == "Exit") {
@@ -887,6 +1180,7 @@ inline void handleMenuActionImpl(int menuResult, DocumentComponent& doc,
             }
             switch (itemIndex) {
                 case 0:  // New
+                    document::closeLargeFile(doc);
                     doc.buffer.setText("");
                     doc.filePath.clear();
                     doc.isDirty = false;
@@ -901,8 +1195,7 @@ inline void handleMenuActionImpl(int menuResult, DocumentComponent& doc,
                 {
                     // Load document with settings (document settings saved with
                     // file)
-                    auto result = loadDocumentEx(doc.buffer, doc.docSettings,
-                                                 doc.defaultPath);
+                    auto result = document::openDocument(doc, doc.defaultPath);
                     if (result.success) {
                         doc.filePath = doc.defaultPath;
                         doc.isDirty = false;
@@ -941,40 +1234,10 @@ inline void handleMenuActionImpl(int menuResult, DocumentComponent& doc,
                 {
                     std::string savePath =
                         doc.filePath.empty() ? doc.defaultPath : doc.filePath;
-                    // Sync layout settings to document settings before save
-                    doc.docSettings.textStyle = doc.buffer.textStyle();
-                    doc.docSettings.pageSettings.mode = layout.pageMode;
-                    doc.docSettings.pageSettings.pageWidth = layout.pageWidth;
-                    doc.docSettings.pageSettings.pageHeight = layout.pageHeight;
-                    doc.docSettings.pageSettings.pageMargin = layout.pageMargin;
-                    doc.docSettings.pageSettings.lineWidthLimit =
-                        layout.lineWidthLimit;
-                    // Save document with all settings
-                    auto result =
-                        saveDocumentEx(doc.buffer, doc.docSettings, savePath);
-                    if (result.success) {
-                        doc.isDirty = false;
-                        doc.filePath = savePath;
-                        if (!doc.autoSavePath.empty()) {
-                            std::filesystem::remove(doc.autoSavePath);
-                        }
-                        Settings::get().add_recent_file(savePath);
-                        menu.menus = menu_setup::createMenuBar(
-                            Settings::get().get_recent_files());
-                        menu.recentFilesCount = static_cast<int>(
-                            Settings::get().get_recent_files().size());
-                        if (doc.trackChangesEnabled &&
-                            menu.menus.size() > 1 &&
-                            menu.menus[1].items.size() > 3) {
-                            menu.menus[1].items[3].mark =
-                                win95::MenuMark::Checkmark;
-                        }
-                        toast_notify::success(
-                            "Saved: " + std::filesystem::path(savePath)
-                                                    .filename()
-                                                    .string());
-                    } else {
-                        toast_notify::error("Save failed: " + result.error);
+                    // Written on the save thread; SaveCompletionSystem
+                    // updates the recent files menu and reports the result
+                    if (!document::requestSave(doc, layout, savePath, SaveKind::Manual)) {
+                        toast_notify::warning("Large files are read-only");
                     }
                 } break;
                 case 6:  // Export PDF
@@ -982,13 +1245,20 @@ inline void handleMenuActionImpl(int menuResult, DocumentComponent& doc,
                     std::filesystem::path basePath =
                         doc.filePath.empty() ? doc.defaultPath : doc.filePath;
                     basePath.replace_extension(".pdf");
-                    auto result = exportDocumentPdf(doc.buffer, doc.docSettings,
-                                                    basePath.string());
-                    if (result.success) {
-                        toast_notify::success(
-                            "Exported PDF: " + basePath.filename().string());
-                    } else {
-                        toast_notify::error("Export PDF failed: " + result.error);
+                    PdfExportOptions pdfOptions;
+                    pdfOptions.fontDirectory =
+                        afterhours::files::get_resource_path("fonts", "").string();
+                    // Written on the export thread; ExportCompletionSystem
+                    // reports the result
+                    bool started = document::startExport(
+                        doc, layout, basePath.string(),
+                        [pdfOptions](const TextBuffer& snapshot, const DocumentSettings& settings,
+                                     const std::string& path, ExportProgress& progress) mutable {
+                            pdfOptions.progress = &progress;
+                            return exportDocumentPdf(snapshot, settings, path, pdfOptions);
+                        });
+                    if (!started) {
+                        toast_notify::warning("An export is already running");
                     }
                 } break;
                 case 7:  // Export HTML
@@ -996,13 +1266,18 @@ inline void handleMenuActionImpl(int menuResult, DocumentComponent& doc,
                     std::filesystem::path basePath =
                         doc.filePath.empty() ? doc.defaultPath : doc.filePath;
                     basePath.replace_extension(".html");
-                    auto result = exportDocumentHtml(doc.buffer, doc.docSettings,
-                                                     basePath.string());
-                    if (result.success) {
-                        toast_notify::success(
-                            "Exported HTML: " + basePath.filename().string());
-                    } else {
-                        toast_notify::error("Export HTML failed: " + result.error);
+                    bool started = document::startExport(
+                        doc, layout, basePath.string(),
+                        [tables = doc.tables](const TextBuffer& snapshot,
+                                              const DocumentSettings& settings,
+                                              const std::string& path, ExportProgress& progress) {
+                            ExportOptions htmlOptions;
+                            htmlOptions.progress = &progress;
+                            return exportDocumentHtml(snapshot, settings, tables, path,
+                                                      htmlOptions);
+                        });
+                    if (!started) {
+                        toast_notify::warning("An export is already running");
                     }
                 } break;
                 case 8:  // Export RTF
@@ -1010,13 +1285,18 @@ inline void handleMenuActionImpl(int menuResult, DocumentComponent& doc,
                     std::filesystem::path basePath =
                         doc.filePath.empty() ? doc.defaultPath : doc.filePath;
                     basePath.replace_extension(".rtf");
-                    auto result = exportDocumentRtf(doc.buffer, doc.docSettings,
-                                                    basePath.string());
-                    if (result.success) {
-                        toast_notify::success(
-                            "Exported RTF: " + basePath.filename().string());
-                    } else {
-                        toast_notify::error("Export RTF failed: " + result.error);
+                    bool started = document::startExport(
+                        doc, layout, basePath.string(),
+                        [tables = doc.tables](const TextBuffer& snapshot,
+                                              const DocumentSettings& settings,
+                                              const std::string& path, ExportProgress& progress) {
+                            ExportOptions rtfOptions;
+                            rtfOptions.progress = &progress;
+                            return exportDocumentRtf(snapshot, settings, tables, path,
+                                                     rtfOptions);
+                        });
+                    if (!started) {
+                        toast_notify::warning("An export is already running");
                     }
                 } break;
                 case 10:  // Page Setup
@@ -1101,7 +1381,11 @@ inline void handleMenuActionImpl(int menuResult, DocumentComponent& doc,
                     break;
                 case 14:  // Find Next
                     if (!menu.lastSearchTerm.empty()) {
-                        FindResult result = doc.buffer.findNext(menu.lastSearchTerm, menu.findOptions);
+                        // A large file is searched whole, not just its window
+                        FindResult result =
+                            doc.large ? doc.large->findNext(doc.buffer, menu.lastSearchTerm,
+                                                            menu.findOptions)
+                                      : doc.buffer.findNext(menu.lastSearchTerm, menu.findOptions);
                         if (result.found) {
                             doc.buffer.setCaret(result.start);
                             doc.buffer.setSelectionAnchor(result.start);
@@ -1115,7 +1399,11 @@ inline void handleMenuActionImpl(int menuResult, DocumentComponent& doc,
                     break;
                 case 15:  // Find Previous
                     if (!menu.lastSearchTerm.empty()) {
-                        FindResult result = doc.buffer.findPrevious(menu.lastSearchTerm, menu.findOptions);
+                        FindResult result =
+                            doc.large ? doc.large->findPrevious(doc.buffer, menu.lastSearchTerm,
+                                                                menu.findOptions)
+                                      : doc.buffer.findPrevious(menu.lastSearchTerm,
+                                                                menu.findOptions);
                         if (result.found) {
                             doc.buffer.setCaret(result.start);
                             doc.buffer.setSelectionAnchor(result.start);
@@ -1132,6 +1420,22 @@ inline void handleMenuActionImpl(int menuResult, DocumentComponent& doc,
                     menu.findReplaceMode = true;
                     toast_notify::info("Replace mode");
                     break;
+                case 19: {  // Find in Files...
+                    // Search the folder containing the current document
+                    std::filesystem::path folder = doc.filePath.empty()
+                        ? std::filesystem::current_path()
+                        : std::filesystem::path(doc.filePath).parent_path();
+                    if (folder.empty()) folder = std::filesystem::current_path();
+                    menu.findInFilesFolder = folder.string();
+                    if (menu.findInFilesTerm.empty()) {
+                        menu.findInFilesTerm = menu.lastSearchTerm;
+                    }
+                    menu.showFindInFilesDialog = true;
+                    // With no term yet the dialog opens empty for one to be typed
+                    if (!menu.findInFilesTerm.empty() && !find_in_files::start(menu)) {
+                        toast_notify::error("Find in Files: " + menu.findInFiles->error());
+                    }
+                } break;
                 default:
                     break;
             }
@@ -0,0 +1,54 @@
+#include "anchor_index.h"
+
+void AnchorBounds::reset(std::uint64_t generation, float lineHeight, float zoom) {
+    boxes_.clear();
+    maxBottom_.clear();
+    order_.clear();
+    generation_ = generation;
+    lineHeight_ = lineHeight;
+    zoom_ = zoom;
+    built_ = false;
+}
+
+void AnchorBounds::finish() {
+    std::stable_sort(boxes_.begin(), boxes_.end(),
+                     [](const Box& a, const Box& b) { return a.top < b.top; });
+    maxBottom_.resize(boxes_.size());
+    order_.resize(boxes_.size());
+    float reach = 0.0f;
+    for (std::size_t i = 0; i < boxes_.size(); ++i) {
+        reach = i == 0 ? boxes_[i].bottom : std::max(reach, boxes_[i].bottom);
+        maxBottom_[i] = reach;
+        order_[boxes_[i].index] = boxes_[i].order;
+    }
+    built_ = true;
+}
+
+std::size_t AnchorBounds::firstReaching(float y) const {
+    auto it = std::upper_bound(maxBottom_.begin(), maxBottom_.end(), y);
+    return static_cast<std::size_t>(it - maxBottom_.begin());
+}
+
+void AnchorBounds::overlapping(float top, float bottom, std::vector<std::size_t>& out) const {
+    out.clear();
+    for (std::size_t i = firstReaching(top); i < boxes_.size() && boxes_[i].top < bottom; ++i) {
+        if (boxes_[i].bottom > top) out.push_back(boxes_[i].index);
+    }
+    std::sort(out.begin(), out.end(),
+              [this](std::size_t a, std::size_t b) { return order_[a] < order_[b]; });
+}
+
+std::size_t AnchorBounds::hit(float x, float y) const {
+    std::size_t found = NONE;
+    // Edges count as inside, like DocumentDrawing::containsPoint
+    auto it = std::lower_bound(maxBottom_.begin(), maxBottom_.end(), y);
+    for (auto i = static_cast<std::size_t>(it - maxBottom_.begin());
+         i < boxes_.size() && boxes_[i].top <= y; ++i) {
+        const Box& box = boxes_[i];
+        if (y <= box.bottom && x >= box.left && x <= box.right &&
+            (found == NONE || box.order > order_[found])) {
+            found = box.index;
+        }
+    }
+    return found;
+}
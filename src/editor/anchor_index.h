@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Shared indexing for objects anchored to text lines (images, drawings,
+// equations).
+//
+// The collections keep their objects sorted by anchorLine (insertion order
+// within a line), so the objects on a line or a run of lines are one
+// contiguous span found by binary search, and an edit only touches the
+// objects at or after it. Anchors must therefore only be moved with
+// shiftAnchors (the collections' shiftAnchorsFrom), not by writing
+// anchorLine on an object already in a collection.
+//
+// Sorting by line is only for lookup: objects are still drawn and hit
+// tested in the order they were added (their ids), so moving text never
+// changes which of two overlapping objects is on top. AnchorBounds indexes
+// the objects' laid-out rectangles for culling and hit testing in that
+// order; see below.
+namespace anchor_index {
+
+// Index of the first object anchored at or after line
+template <typename T>
+std::size_t firstAtOrAfter(const std::vector<T>& items, std::size_t line) {
+    auto it = std::partition_point(items.begin(), items.end(),
+                                   [line](const T& item) { return item.anchorLine < line; });
+    return static_cast<std::size_t>(it - items.begin());
+}
+
+// Objects anchored on lines first..last (inclusive)
+template <typename T>
+std::span<T> inLines(std::vector<T>& items, std::size_t first, std::size_t last) {
+    if (last < first) return {};
+    std::size_t begin = firstAtOrAfter(items, first);
+    std::size_t end = last == static_cast<std::size_t>(-1) ? items.size()
+                                                           : firstAtOrAfter(items, last + 1);
+    return std::span<T>(items.data() + begin, end - begin);
+}
+
+template <typename T>
+std::span<const T> inLines(const std::vector<T>& items, std::size_t first, std::size_t last) {
+    if (last < first) return {};
+    std::size_t begin = firstAtOrAfter(items, first);
+    std::size_t end = last == static_cast<std::size_t>(-1) ? items.size()
+                                                           : firstAtOrAfter(items, last + 1);
+    return std::span<const T>(items.data() + begin, end - begin);
+}
+
+// Insert after every object anchored on the same or an earlier line
+template <typename T>
+T& insert(std::vector<T>& items, T item) {
+    std::size_t at = firstAtOrAfter(items, item.anchorLine + 1);
+    return *items.insert(items.begin() + static_cast<std::ptrdiff_t>(at), std::move(item));
+}
+
+// Move every anchor at or after line by delta lines (not below line 0).
+// Only that tail of the vector is visited; when lines are removed it is
+// merged back among the objects it moved up past.
+template <typename T>
+void shiftAnchors(std::vector<T>& items, std::size_t line, std::ptrdiff_t delta) {
+    std::size_t from = firstAtOrAfter(items, line);
+    if (from == items.size() || delta == 0) return;
+    for (std::size_t i = from; i < items.size(); ++i) {
+        std::ptrdiff_t moved = static_cast<std::ptrdiff_t>(items[i].anchorLine) + delta;
+        items[i].anchorLine = static_cast<std::size_t>(std::max(std::ptrdiff_t(0), moved));
+    }
+    if (delta > 0 || from == 0) return;
+    auto split = items.begin() + static_cast<std::ptrdiff_t>(from);
+    auto mergeFrom = std::partition_point(items.begin(), split, [&](const T& item) {
+        return item.anchorLine <= split->anchorLine;
+    });
+    std::inplace_merge(mergeFrom, split, items.end(), [](const T& a, const T& b) {
+        return a.anchorLine < b.anchorLine;
+    });
+}
+
+}  // namespace anchor_index
+
+// Laid-out rectangles of a collection's objects, for culling and hit
+// testing. Boxes are sorted by top edge with a running maximum of bottom
+// edges (an interval index): the first box that can reach below y is a
+// binary search away, and a scan from there stops at the first box whose
+// top is past the range.
+//
+// A collection rebuilds it only when its objects or the layout inputs
+// (line height, zoom) changed since the last build, tracked by a
+// generation number the collection bumps on every mutation.
+class AnchorBounds {
+   public:
+    struct Box {
+        float left = 0.0f;
+        float top = 0.0f;
+        float right = 0.0f;
+        float bottom = 0.0f;
+        std::size_t index = 0;  // Position in the collection
+        std::size_t order = 0;  // Drawing order (the object's id): later is on top
+    };
+
+    bool isCurrent(std::uint64_t generation, float lineHeight, float zoom) const {
+        return built_ && generation == generation_ && lineHeight == lineHeight_ &&
+               zoom == zoom_;
+    }
+    // Start a rebuild for this generation and layout; add() every object,
+    // then finish()
+    void reset(std::uint64_t generation, float lineHeight, float zoom);
+    void add(const Box& box) { boxes_.push_back(box); }
+    void finish();
+
+    // Replace out with the indices of boxes overlapping rows [top, bottom),
+    // in drawing order. out keeps its capacity between calls.
+    void overlapping(float top, float bottom, std::vector<std::size_t>& out) const;
+
+    // Index of the topmost (last-drawn) box containing (x, y), or NONE
+    static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+    std::size_t hit(float x, float y) const;
+
+   private:
+    // First box whose running maximum bottom reaches past y
+    std::size_t firstReaching(float y) const;
+
+    std::vector<Box> boxes_;
+    std::vector<float> maxBottom_;  // maxBottom_[i] = max bottom of boxes_[0..i]
+    std::vector<std::size_t> order_;  // Drawing order by collection index
+    std::uint64_t generation_ = 0;
+    float lineHeight_ = 0.0f;
+    float zoom_ = 0.0f;
+    bool built_ = false;
+};
@@ -0,0 +1,200 @@
+#include "atomic_file.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define WORDPROC_HAS_POSIX_IO 1
+#endif
+
+namespace {
+
+std::string uniqueTempPath(const std::string& path) {
+    // Hidden sibling of the target so the rename stays on one filesystem
+    static std::atomic<unsigned> counter{0};
+    std::filesystem::path target(path);
+    std::string name = "." + target.filename().string() + ".tmp";
+#ifdef WORDPROC_HAS_POSIX_IO
+    name += "." + std::to_string(::getpid());
+#endif
+    name += "." + std::to_string(counter.fetch_add(1));
+    return (target.parent_path() / name).string();
+}
+
+}  // namespace
+
+bool AtomicFileWriter::open(const std::string& path) {
+    abort();
+    failed_ = false;
+    error_.clear();
+
+    // Saving through a symlink replaces the file it points at, not the link
+    std::error_code ec;
+    path_ = path;
+    if (std::filesystem::is_symlink(path, ec)) {
+        std::filesystem::path resolved = std::filesystem::canonical(path, ec);
+        if (!ec) path_ = resolved.string();
+    }
+    tempPath_ = uniqueTempPath(path_);
+
+#ifdef WORDPROC_HAS_POSIX_IO
+    fd_ = ::open(tempPath_.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_TRUNC, 0666);
+    if (fd_ < 0) {
+        fail("Could not create temporary file: " + tempPath_);
+        tempPath_.clear();
+        return false;
+    }
+    // Keep the permissions of the file being replaced
+    struct stat st {};
+    if (::stat(path_.c_str(), &st) == 0) {
+        ::fchmod(fd_, st.st_mode & 07777);
+    }
+#else
+    file_ = std::fopen(tempPath_.c_str(), "wb");
+    if (!file_) {
+        fail("Could not create temporary file: " + tempPath_);
+        tempPath_.clear();
+        return false;
+    }
+#endif
+
+    buffer_.resize(BUFFER_SIZE);
+    used_ = 0;
+    return true;
+}
+
+bool AtomicFileWriter::isOpen() const { return fd_ >= 0 || file_ != nullptr; }
+
+void AtomicFileWriter::write(const char* data, std::size_t len) {
+    if (len <= buffer_.size() - used_) {
+        std::memcpy(buffer_.data() + used_, data, len);
+        used_ += len;
+        return;
+    }
+    if (!flushBuffer()) return;
+    if (len < buffer_.size()) {
+        std::memcpy(buffer_.data(), data, len);
+        used_ = len;
+        return;
+    }
+
+    // Large writes skip the buffer
+#ifdef WORDPROC_HAS_POSIX_IO
+    while (len > 0) {
+        ssize_t n = ::write(fd_, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            fail("Failed to write to file: " + path_);
+            return;
+        }
+        data += n;
+        len -= static_cast<std::size_t>(n);
+    }
+#else
+    if (std::fwrite(data, 1, len, file_) != len) {
+        fail("Failed to write to file: " + path_);
+    }
+#endif
+}
+
+bool AtomicFileWriter::flushBuffer() {
+    if (failed_ || !isOpen()) {
+        used_ = 0;
+        return false;
+    }
+    std::size_t len = used_;
+    used_ = 0;
+    std::size_t written = 0;
+#ifdef WORDPROC_HAS_POSIX_IO
+    while (written < len) {
+        ssize_t n = ::write(fd_, buffer_.data() + written, len - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            fail("Failed to write to file: " + path_);
+            return false;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+#else
+    written = std::fwrite(buffer_.data(), 1, len, file_);
+    if (written != len) {
+        fail("Failed to write to file: " + path_);
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool AtomicFileWriter::commit() {
+    if (!isOpen()) {
+        if (error_.empty()) error_ = "No file open for writing";
+        return false;
+    }
+    flushBuffer();
+
+#ifdef WORDPROC_HAS_POSIX_IO
+    // The data must be on disk before the rename makes it visible
+    if (!failed_ && ::fsync(fd_) != 0) fail("Failed to sync file: " + path_);
+#else
+    if (!failed_ && std::fflush(file_) != 0) fail("Failed to write to file: " + path_);
+#endif
+    closeHandle();
+    if (failed_) {
+        abort();
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath_, path_, ec);
+    if (ec) {
+        fail("Could not replace " + path_ + ": " + ec.message());
+        abort();
+        return false;
+    }
+    tempPath_.clear();
+
+#ifdef WORDPROC_HAS_POSIX_IO
+    // Persist the directory entry too (best effort)
+    std::string dir = std::filesystem::path(path_).parent_path().string();
+    int dirFd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (dirFd >= 0) {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+#endif
+    return true;
+}
+
+void AtomicFileWriter::abort() {
+    closeHandle();
+    if (!tempPath_.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(tempPath_, ec);
+        tempPath_.clear();
+    }
+    used_ = 0;
+}
+
+void AtomicFileWriter::fail(const std::string& message) {
+    if (!failed_) error_ = message;
+    failed_ = true;
+}
+
+void AtomicFileWriter::closeHandle() {
+#ifdef WORDPROC_HAS_POSIX_IO
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+#endif
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
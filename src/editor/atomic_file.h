@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Buffered writer that replaces a file atomically.
+// Output goes to a temporary file next to the target. commit() flushes,
+// fsyncs and renames it over the target, so readers (and a crash mid-save)
+// only ever see the old or the new contents. A writer that is destroyed or
+// aborted without committing removes its temporary file.
+class AtomicFileWriter {
+   public:
+    static constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+
+    AtomicFileWriter() = default;
+    explicit AtomicFileWriter(const std::string& path) { open(path); }
+    ~AtomicFileWriter() { abort(); }
+
+    AtomicFileWriter(const AtomicFileWriter&) = delete;
+    AtomicFileWriter& operator=(const AtomicFileWriter&) = delete;
+
+    // Create the temporary file. Returns false and sets error() on failure.
+    bool open(const std::string& path);
+    bool isOpen() const;
+
+    // Writes are buffered; a failed write is sticky and reported by good()
+    // and commit()
+    void write(const char* data, std::size_t len);
+    void write(std::string_view text) { write(text.data(), text.size()); }
+    void put(char ch) {
+        if (used_ == buffer_.size() && !flushBuffer()) return;
+        buffer_[used_++] = ch;
+    }
+
+    // Flush, fsync and rename over the target
+    bool commit();
+    // Drop the temporary file, leaving the target untouched
+    void abort();
+
+    bool good() const { return !failed_; }
+    const std::string& error() const { return error_; }
+    const std::string& tempPath() const { return tempPath_; }
+
+   private:
+    bool flushBuffer();
+    void fail(const std::string& message);
+    void closeHandle();
+
+    std::string path_;
+    std::string tempPath_;
+    std::string error_;
+    std::vector<char> buffer_;
+    std::size_t used_ = 0;
+    bool failed_ = false;
+    int fd_ = -1;                  // POSIX
+    std::FILE* file_ = nullptr;    // Elsewhere
+};
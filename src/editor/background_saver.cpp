@@ -0,0 +1,114 @@
+#include "background_saver.h"
+
+#include <algorithm>
+
+BackgroundSaver::BackgroundSaver() {
+    worker_ = std::thread([this] { workerLoop(); });
+}
+
+BackgroundSaver::~BackgroundSaver() {
+    {
+        // Unlike checking, pending saves are user data: finish them
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (worker_.joinable()) worker_.join();
+}
+
+void BackgroundSaver::requestSave(const TextBuffer& buffer, const DocumentSettings& settings,
+                                  const std::string& path, SaveKind kind) {
+    Job job;
+    job.path = path;
+    job.kind = kind;
+    job.bufferVersion = buffer.version();
+    job.text = buffer.getText();
+    job.settings = settings;
+    job.requestedAt = Clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.requested++;
+        auto queued = std::find_if(jobs_.begin(), jobs_.end(),
+                                   [&](const Job& other) { return other.path == path; });
+        if (queued != jobs_.end()) {
+            // Not started yet: write the newer snapshot in its place. A
+            // manual save stays manual so its confirmation is not lost.
+            if (queued->kind == SaveKind::Manual) job.kind = SaveKind::Manual;
+            job.requestedAt = queued->requestedAt;
+            *queued = std::move(job);
+            stats_.coalesced++;
+            return;
+        }
+        jobs_.push_back(std::move(job));
+    }
+    wake_.notify_one();
+}
+
+void BackgroundSaver::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+        if (jobs_.empty()) return;  // Stopping with nothing left to write
+
+        Job job = std::move(jobs_.front());
+        jobs_.pop_front();
+        busy_ = true;
+        activePath_ = job.path;
+        lock.unlock();
+
+        auto writeStart = Clock::now();
+        SaveOutcome outcome;
+        outcome.result = saveDocumentSnapshot(job.text, job.settings, job.path);
+        auto writeEnd = Clock::now();
+        outcome.path = std::move(job.path);
+        outcome.kind = job.kind;
+        outcome.bufferVersion = job.bufferVersion;
+        outcome.writeMs = std::chrono::duration<double, std::milli>(writeEnd - writeStart).count();
+        outcome.latencyMs =
+            std::chrono::duration<double, std::milli>(writeEnd - job.requestedAt).count();
+
+        lock.lock();
+        busy_ = false;
+        activePath_.clear();
+        if (outcome.result.success) {
+            stats_.completed++;
+        } else {
+            stats_.failed++;
+        }
+        stats_.lastLatencyMs = outcome.latencyMs;
+        stats_.maxLatencyMs = std::max(stats_.maxLatencyMs, outcome.latencyMs);
+        stats_.lastWriteMs = outcome.writeMs;
+        done_.push_back(std::move(outcome));
+        if (jobs_.empty()) idle_.notify_all();
+    }
+}
+
+std::vector<SaveOutcome> BackgroundSaver::takeCompleted() {
+    std::vector<SaveOutcome> finished;
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished.swap(done_);
+    return finished;
+}
+
+void BackgroundSaver::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return jobs_.empty() && !busy_; });
+}
+
+std::size_t BackgroundSaver::queueDepth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return jobs_.size() + (busy_ ? 1 : 0);
+}
+
+bool BackgroundSaver::isSaving(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (busy_ && activePath_ == path) return true;
+    return std::any_of(jobs_.begin(), jobs_.end(),
+                       [&](const Job& job) { return job.path == path; });
+}
+
+BackgroundSaverStats BackgroundSaver::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
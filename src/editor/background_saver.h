@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "document_io.h"
+#include "document_settings.h"
+#include "text_buffer.h"
+
+enum class SaveKind { Manual, AutoSave };
+
+// A finished background save, handed back to the UI thread
+struct SaveOutcome {
+    std::string path;
+    SaveKind kind = SaveKind::Manual;
+    std::uint64_t bufferVersion = 0;  // TextBuffer::version() of the snapshot
+    DocumentResult result;
+    double latencyMs = 0.0;  // From the (first coalesced) request to completion
+    double writeMs = 0.0;    // Serialization and disk I/O on the worker
+};
+
+struct BackgroundSaverStats {
+    std::size_t requested = 0;  // requestSave calls
+    std::size_t coalesced = 0;  // Requests folded into an already queued save
+    std::size_t completed = 0;  // Saves written successfully
+    std::size_t failed = 0;
+    double lastLatencyMs = 0.0;
+    double maxLatencyMs = 0.0;
+    double lastWriteMs = 0.0;
+};
+
+// Saves documents on a worker thread so the frame never waits on disk I/O.
+//
+// requestSave() snapshots the text and settings on the UI thread (one
+// memcpy of the text) and queues the write. If a save of the same path is
+// still waiting in the queue it is replaced by the newer snapshot, so a
+// burst of Ctrl+S presses or an autosave landing on a manual save costs one
+// write. Results are collected with takeCompleted() once per frame.
+// Destroying the saver finishes any queued saves first.
+class BackgroundSaver {
+   public:
+    BackgroundSaver();
+    ~BackgroundSaver();
+    BackgroundSaver(const BackgroundSaver&) = delete;
+    BackgroundSaver& operator=(const BackgroundSaver&) = delete;
+
+    void requestSave(const TextBuffer& buffer, const DocumentSettings& settings,
+                     const std::string& path, SaveKind kind);
+
+    // Saves finished since the last call, in completion order
+    std::vector<SaveOutcome> takeCompleted();
+
+    // Block until every queued save has been written. For tests and shutdown.
+    void waitIdle();
+
+    // Saves queued or being written
+    std::size_t queueDepth() const;
+    bool isSaving(const std::string& path) const;
+
+    BackgroundSaverStats stats() const;
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        std::string path;
+        SaveKind kind = SaveKind::Manual;
+        std::uint64_t bufferVersion = 0;
+        std::string text;
+        DocumentSettings settings;
+        Clock::time_point requestedAt;
+    };
+
+    void workerLoop();
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::deque<Job> jobs_;
+    std::string activePath_;  // Path being written, empty when idle
+    bool busy_ = false;
+    bool stopping_ = false;
+    std::vector<SaveOutcome> done_;
+    BackgroundSaverStats stats_;
+    std::thread worker_;
+};
@@ -0,0 +1,327 @@
+#include "binary_document.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "lz_block.h"
+
+namespace {
+
+constexpr char kMagic[4] = {'W', 'P', 'D', 'B'};
+constexpr std::size_t kHeaderSize = 8;
+constexpr std::size_t kEntrySize = 48;
+constexpr std::size_t kTrailerSize = 16;
+
+std::uint32_t fnv1a32(std::string_view bytes) {
+    std::uint32_t hash = 2166136261u;
+    for (char ch : bytes) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void putFixed(std::string& out, std::uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+std::uint64_t getFixed(const char* in, int bytes) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    return value;
+}
+
+void putVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+}  // namespace
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+bool BinaryDocumentWriter::open(const std::string& path) {
+    toc_.clear();
+    if (!out_.open(path)) return false;
+    std::string header(kMagic, sizeof(kMagic));
+    putFixed(header, VERSION, 4);
+    out_.write(header);
+    offset_ = header.size();
+    return true;
+}
+
+void BinaryDocumentWriter::addSection(WpdbSection type, std::string_view bytes,
+                                      std::uint64_t firstLine, std::uint64_t lineCount) {
+    WpdbSectionEntry entry;
+    entry.type = type;
+    entry.rawSize = bytes.size();
+    entry.firstLine = firstLine;
+    entry.lineCount = lineCount;
+
+    // Keep compressed bytes only when they pay for the decode
+    std::string packed;
+    std::string_view stored = bytes;
+    if (compress_ && bytes.size() >= 64) {
+        packed = lz_block::compress(bytes);
+        if (packed.size() < bytes.size() - bytes.size() / 8) {
+            stored = packed;
+            entry.codec = WpdbCodec::Lz;
+        }
+    }
+    entry.offset = offset_;
+    entry.storedSize = stored.size();
+    entry.checksum = fnv1a32(stored);
+    out_.write(stored);
+    offset_ += stored.size();
+    toc_.push_back(entry);
+}
+
+void BinaryDocumentWriter::addText(const std::vector<std::string_view>& text) {
+    std::string chunk;
+    chunk.reserve(TEXT_CHUNK_SIZE + 1024);
+    std::string lineIndex;
+    std::uint64_t firstLine = 0;
+    std::uint64_t lineNumber = 0;
+    std::size_t lineLength = 0;
+
+    for (std::string_view view : text) {
+        while (!view.empty()) {
+            const void* found = std::memchr(view.data(), '\n', view.size());
+            std::size_t take = found ? static_cast<std::size_t>(
+                                           static_cast<const char*>(found) - view.data()) + 1
+                                     : view.size();
+            chunk.append(view.data(), take);
+            view.remove_prefix(take);
+            if (!found) {
+                lineLength += take;
+                continue;
+            }
+            putVarint(lineIndex, lineLength + take - 1);
+            lineLength = 0;
+            ++lineNumber;
+            // Chunks end after a newline so every line sits in one chunk
+            if (chunk.size() >= TEXT_CHUNK_SIZE) {
+                addSection(WpdbSection::TextChunk, chunk, firstLine, lineNumber - firstLine);
+                firstLine = lineNumber;
+                chunk.clear();
+            }
+        }
+    }
+    // The last line (possibly empty) has no newline
+    putVarint(lineIndex, lineLength);
+    addSection(WpdbSection::TextChunk, chunk, firstLine, lineNumber + 1 - firstLine);
+    addSection(WpdbSection::LineIndex, lineIndex, 0, lineNumber + 1);
+}
+
+bool BinaryDocumentWriter::commit() {
+    std::string toc;
+    toc.reserve(toc_.size() * kEntrySize);
+    for (const WpdbSectionEntry& entry : toc_) {
+        toc.push_back(static_cast<char>(entry.type));
+        toc.push_back(static_cast<char>(entry.codec));
+        putFixed(toc, 0, 2);
+        putFixed(toc, entry.checksum, 4);
+        putFixed(toc, entry.offset, 8);
+        putFixed(toc, entry.storedSize, 8);
+        putFixed(toc, entry.rawSize, 8);
+        putFixed(toc, entry.firstLine, 8);
+        putFixed(toc, entry.lineCount, 8);
+    }
+    std::string trailer;
+    putFixed(trailer, offset_, 8);
+    putFixed(trailer, toc_.size(), 4);
+    putFixed(trailer, fnv1a32(toc), 4);
+    out_.write(toc);
+    out_.write(trailer);
+    return out_.commit();
+}
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+bool BinaryDocumentReader::hasMagic(std::string_view bytes) {
+    return bytes.size() >= sizeof(kMagic) && std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) == 0;
+}
+
+bool BinaryDocumentReader::open(const std::string& path) {
+    sections_.clear();
+    textChunks_.clear();
+    lineCount_ = 0;
+    textSize_ = 0;
+    decoded_ = 0;
+    if (!file_.open(path)) {
+        error_ = file_.error();
+        return false;
+    }
+    std::string_view bytes = file_.view();
+    if (bytes.size() < kHeaderSize + kTrailerSize || !hasMagic(bytes)) {
+        error_ = "Not a .wpdb file";
+        return false;
+    }
+    if (getFixed(bytes.data() + 4, 4) != BinaryDocumentWriter::VERSION) {
+        error_ = "Unsupported .wpdb version";
+        return false;
+    }
+
+    const char* trailer = bytes.data() + bytes.size() - kTrailerSize;
+    std::uint64_t tocOffset = getFixed(trailer, 8);
+    std::uint64_t count = getFixed(trailer + 8, 4);
+    std::uint64_t tocEnd = bytes.size() - kTrailerSize;
+    if (tocOffset < kHeaderSize || tocOffset > tocEnd || (tocEnd - tocOffset) != count * kEntrySize ||
+        fnv1a32(bytes.substr(tocOffset, tocEnd - tocOffset)) != getFixed(trailer + 12, 4)) {
+        error_ = "Damaged .wpdb table of contents";
+        return false;
+    }
+
+    sections_.reserve(count);
+    std::uint64_t decodedSize = 0;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        const char* raw = bytes.data() + tocOffset + i * kEntrySize;
+        WpdbSectionEntry entry;
+        entry.type = static_cast<WpdbSection>(static_cast<unsigned char>(raw[0]));
+        entry.codec = static_cast<WpdbCodec>(static_cast<unsigned char>(raw[1]));
+        entry.checksum = static_cast<std::uint32_t>(getFixed(raw + 4, 4));
+        entry.offset = getFixed(raw + 8, 8);
+        entry.storedSize = getFixed(raw + 16, 8);
+        entry.rawSize = getFixed(raw + 24, 8);
+        entry.firstLine = getFixed(raw + 32, 8);
+        entry.lineCount = getFixed(raw + 40, 8);
+        // Sizes are checked here, before anything is allocated from them
+        bool sizeOk = entry.codec == WpdbCodec::None
+                          ? entry.rawSize == entry.storedSize
+                          : entry.codec == WpdbCodec::Lz &&
+                                entry.rawSize <= lz_block::maxDecompressedSize(entry.storedSize);
+        if (entry.offset < kHeaderSize || entry.offset > tocOffset ||
+            entry.storedSize > tocOffset - entry.offset || !sizeOk ||
+            entry.rawSize > MAX_DECODED_SIZE - decodedSize) {
+            error_ = "Damaged .wpdb section entry";
+            return false;
+        }
+        decodedSize += entry.rawSize;
+        if (entry.type == WpdbSection::TextChunk) {
+            textChunks_.push_back(sections_.size());
+            textSize_ += entry.rawSize;
+        }
+        sections_.push_back(entry);
+    }
+
+    std::sort(textChunks_.begin(), textChunks_.end(), [this](std::size_t a, std::size_t b) {
+        return sections_[a].firstLine < sections_[b].firstLine;
+    });
+    for (std::size_t index : textChunks_) {
+        const WpdbSectionEntry& chunk = sections_[index];
+        if (chunk.firstLine != lineCount_ || chunk.lineCount == 0) {
+            error_ = "Text chunks of the .wpdb do not line up";
+            return false;
+        }
+        lineCount_ += chunk.lineCount;
+    }
+    if (textChunks_.empty()) lineCount_ = 1;  // Empty document
+    return true;
+}
+
+bool BinaryDocumentReader::decodeInto(const WpdbSectionEntry& entry, char* out) const {
+    std::string_view stored = file_.view().substr(entry.offset, entry.storedSize);
+    if (fnv1a32(stored) != entry.checksum) return false;
+    ++decoded_;
+    switch (entry.codec) {
+        case WpdbCodec::None:
+            std::memcpy(out, stored.data(), stored.size());
+            return true;
+        case WpdbCodec::Lz:
+            return lz_block::decompress(stored, out, entry.rawSize);
+    }
+    return false;
+}
+
+bool BinaryDocumentReader::readSection(std::size_t index, std::string& out) const {
+    if (index >= sections_.size()) return false;
+    out.resize(sections_[index].rawSize);
+    return decodeInto(sections_[index], out.data());
+}
+
+bool BinaryDocumentReader::readLines(std::size_t first, std::size_t count,
+                                     std::string& out) const {
+    out.clear();
+    if (first >= lineCount_ || count == 0) return first < lineCount_ || count == 0;
+    std::size_t last = std::min(lineCount_, first + count);  // Exclusive
+
+    // Chunks are contiguous, so the covering ones decode into one run
+    std::string text;
+    std::size_t textFirstLine = 0;
+    for (std::size_t index : textChunks_) {
+        const WpdbSectionEntry& chunk = sections_[index];
+        if (chunk.firstLine + chunk.lineCount <= first) continue;
+        if (chunk.firstLine >= last) break;
+        if (text.empty()) textFirstLine = chunk.firstLine;
+        std::size_t at = text.size();
+        text.resize(at + chunk.rawSize);
+        if (!decodeInto(chunk, text.data() + at)) return false;
+    }
+
+    // Skip to line `first`, then take up to the newline ending line last - 1
+    std::size_t begin = 0;
+    for (std::size_t line = textFirstLine; line < first; ++line) {
+        std::size_t newline = text.find('\n', begin);
+        if (newline == std::string::npos) return false;  // Line counts lie
+        begin = newline + 1;
+    }
+    std::size_t end = begin;
+    for (std::size_t line = first; line < last; ++line) {
+        if (line > first) ++end;  // Past the previous line's newline
+        std::size_t newline = text.find('\n', end);
+        end = newline == std::string::npos ? text.size() : newline;
+    }
+    out.assign(text, begin, end - begin);
+    return true;
+}
+
+bool BinaryDocumentReader::readText(TextBuffer& buffer) const {
+    return buffer.setTextFrom(textSize_, [this](char* out) {
+        std::size_t written = 0;
+        for (std::size_t index : textChunks_) {
+            const WpdbSectionEntry& chunk = sections_[index];
+            if (!decodeInto(chunk, out + written)) return std::string::npos;
+            written += chunk.rawSize;
+        }
+        return written;
+    });
+}
+
+bool BinaryDocumentReader::readLineLengths(std::vector<std::size_t>& lengths) const {
+    lengths.clear();
+    auto found = std::find_if(sections_.begin(), sections_.end(), [](const WpdbSectionEntry& e) {
+        return e.type == WpdbSection::LineIndex;
+    });
+    std::string index;
+    if (found == sections_.end() ||
+        !readSection(static_cast<std::size_t>(found - sections_.begin()), index)) {
+        return false;
+    }
+    lengths.reserve(lineCount_);
+    std::uint64_t value = 0;
+    int shift = 0;
+    for (char ch : index) {
+        auto byte = static_cast<unsigned char>(ch);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if (byte & 0x80) {
+            shift += 7;
+            if (shift >= 64) return false;
+            continue;
+        }
+        lengths.push_back(static_cast<std::size_t>(value));
+        value = 0;
+        shift = 0;
+    }
+    return shift == 0 && lengths.size() == lineCount_;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "atomic_file.h"
+#include "mapped_file.h"
+#include "text_buffer.h"
+
+// Compact binary document container (.wpdb).
+//
+//   "WPDB" u32 version | section bytes ... | table of contents | trailer
+//
+// The trailer (last 16 bytes) holds the table of contents' offset, entry
+// count and checksum. Each entry (48 bytes, little-endian) gives a
+// section's type, codec, checksum, offset, stored and raw size, and for
+// text the range of lines it holds. Text is split into chunks of whole
+// lines, so a reader decodes only the lines it shows; settings and each
+// table are separate sections holding the same JSON as .wpdoc, which keeps
+// the two formats losslessly convertible (see document_io.h).
+enum class WpdbSection : std::uint8_t {
+    Settings = 1,   // documentSettingsJson, without tables
+    LineIndex = 2,  // Varint length of every line: line count without text
+    TextChunk = 3,  // Lines [firstLine, firstLine + lineCount), '\n'-joined
+    Table = 4,      // {"line": n, "table": {...}}
+};
+
+enum class WpdbCodec : std::uint8_t { None = 0, Lz = 1 };
+
+struct WpdbSectionEntry {
+    WpdbSection type = WpdbSection::Settings;
+    WpdbCodec codec = WpdbCodec::None;
+    std::uint32_t checksum = 0;  // FNV-1a of the stored bytes
+    std::uint64_t offset = 0;
+    std::uint64_t storedSize = 0;
+    std::uint64_t rawSize = 0;
+    std::uint64_t firstLine = 0;
+    std::uint64_t lineCount = 0;
+};
+
+class BinaryDocumentWriter {
+   public:
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::size_t TEXT_CHUNK_SIZE = 64 * 1024;
+
+    // Sections are written as they are added; nothing is visible at path
+    // until commit()
+    bool open(const std::string& path);
+    void setCompression(bool enabled) { compress_ = enabled; }
+
+    void addSection(WpdbSection type, std::string_view bytes, std::uint64_t firstLine = 0,
+                    std::uint64_t lineCount = 0);
+    // Split text (the concatenation of the views) into TextChunk sections
+    // and add its LineIndex
+    void addText(const std::vector<std::string_view>& text);
+
+    bool commit();
+    const std::string& error() const { return out_.error(); }
+
+   private:
+    AtomicFileWriter out_;
+    std::uint64_t offset_ = 0;
+    std::vector<WpdbSectionEntry> toc_;
+    bool compress_ = true;
+};
+
+class BinaryDocumentReader {
+   public:
+    // Largest total of decoded section sizes (text included) open()
+    // accepts; well past anything the editor writes (plain files of
+    // LargeDocument::THRESHOLD or more open read-only), so a bigger total in
+    // the table of contents is damage
+    static constexpr std::uint64_t MAX_DECODED_SIZE = 1ull << 30;
+
+    // Map the file and read its table of contents (no section is decoded)
+    bool open(const std::string& path);
+    const std::string& error() const { return error_; }
+
+    const std::vector<WpdbSectionEntry>& sections() const { return sections_; }
+    std::size_t lineCount() const { return lineCount_; }
+    std::uint64_t textSize() const { return textSize_; }
+
+    // Decoded bytes of sections()[index]
+    bool readSection(std::size_t index, std::string& out) const;
+
+    // Lines [first, first + count) joined by '\n', decoding only the text
+    // chunks that hold them. count is clamped to the document.
+    bool readLines(std::size_t first, std::size_t count, std::string& out) const;
+    // All text, decoded straight into the buffer's storage
+    bool readText(TextBuffer& buffer) const;
+    // The text chunks in line order, one at a time
+    std::size_t textChunkCount() const { return textChunks_.size(); }
+    bool readTextChunk(std::size_t chunk, std::string& out) const {
+        return chunk < textChunks_.size() && readSection(textChunks_[chunk], out);
+    }
+    // Length of every line, without decoding any text
+    bool readLineLengths(std::vector<std::size_t>& lengths) const;
+
+    // Sections decoded so far (to check that loading stayed lazy)
+    std::size_t sectionsDecoded() const { return decoded_; }
+
+    static bool hasMagic(std::string_view bytes);
+
+   private:
+    bool decodeInto(const WpdbSectionEntry& entry, char* out) const;
+
+    MappedFile file_;
+    std::vector<WpdbSectionEntry> sections_;
+    std::vector<std::size_t> textChunks_;  // Section indices in line order
+    std::size_t lineCount_ = 0;
+    std::uint64_t textSize_ = 0;
+    mutable std::size_t decoded_ = 0;
+    std::string error_;
+};
@@ -0,0 +1,428 @@
+#include "dictionary.h"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+constexpr char DAWG_MAGIC[8] = {'W', 'P', 'D', 'A', 'W', 'G', '0', '1'};
+constexpr std::size_t HEADER_SIZE = 32;
+
+std::uint32_t readU32(const char* base, std::size_t index) {
+    std::uint32_t value;
+    std::memcpy(&value, base + index * sizeof(std::uint32_t), sizeof(value));
+    return value;
+}
+
+void appendU32(std::vector<char>& out, std::uint32_t value) {
+    char bytes[sizeof(value)];
+    std::memcpy(bytes, &value, sizeof(value));
+    out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+// Mutable node used only while building
+struct BuildNode {
+    bool final = false;
+    std::vector<std::pair<unsigned char, std::uint32_t>> edges;
+};
+
+}  // namespace
+
+// ============================================================================
+// Construction
+// ============================================================================
+
+Dictionary::Dictionary(Dictionary&& other) noexcept { *this = std::move(other); }
+
+Dictionary& Dictionary::operator=(Dictionary&& other) noexcept {
+    if (this == &other) return *this;
+    file_ = std::move(other.file_);
+    owned_ = std::move(other.owned_);
+    error_ = std::move(other.error_);
+    std::string_view bytes = file_.isOpen() ? file_.view()
+                                            : std::string_view(owned_.data(), owned_.size());
+    nodes_ = nullptr;
+    targets_ = nullptr;
+    labels_ = nullptr;
+    nodeCount_ = edgeCount_ = wordCount_ = 0;
+    root_ = NO_NODE;
+    bytes_ = {};
+    if (!bytes.empty()) attach(bytes);
+    other.bytes_ = {};
+    other.nodes_ = nullptr;
+    other.targets_ = nullptr;
+    other.labels_ = nullptr;
+    other.nodeCount_ = other.edgeCount_ = other.wordCount_ = 0;
+    other.root_ = NO_NODE;
+    return *this;
+}
+
+bool Dictionary::load(const std::string& path) {
+    *this = Dictionary{};
+    if (!file_.open(path)) {
+        error_ = file_.error();
+        return false;
+    }
+    if (!attach(file_.view())) {
+        file_.close();
+        return false;
+    }
+    return true;
+}
+
+Dictionary Dictionary::fromWords(std::vector<std::string> words) {
+    Dictionary dict;
+    dict.owned_ = build(std::move(words));
+    dict.attach(std::string_view(dict.owned_.data(), dict.owned_.size()));
+    return dict;
+}
+
+bool Dictionary::attach(std::string_view bytes) {
+    if (bytes.size() < HEADER_SIZE || std::memcmp(bytes.data(), DAWG_MAGIC, 8) != 0) {
+        error_ = "Not a dictionary file (bad magic)";
+        return false;
+    }
+    const char* header = bytes.data() + 8;
+    std::uint32_t version = readU32(header, 0);
+    std::uint32_t nodeCount = readU32(header, 1);
+    std::uint32_t edgeCount = readU32(header, 2);
+    std::uint32_t wordCount = readU32(header, 3);
+    std::uint32_t root = readU32(header, 4);
+    std::uint32_t byteOrder = readU32(header, 5);
+    if (byteOrder == std::byteswap(BYTE_ORDER_MARK)) {
+        error_ = "Dictionary was built on a machine with the other byte order";
+        return false;
+    }
+    if (version != FORMAT_VERSION) {
+        error_ = "Unsupported dictionary version " + std::to_string(version);
+        return false;
+    }
+
+    std::size_t nodesBytes = (static_cast<std::size_t>(nodeCount) + 1) * 4;
+    std::size_t required = HEADER_SIZE + nodesBytes + static_cast<std::size_t>(edgeCount) * 5;
+    if (byteOrder != BYTE_ORDER_MARK || bytes.size() < required ||
+        (nodeCount > 0 && root >= nodeCount)) {
+        error_ = "Dictionary file is truncated or corrupt";
+        return false;
+    }
+
+    // Lookups trust every edge range and target, so check them all once:
+    // node n's edges end where node n + 1's begin, the last range ends
+    // within the edges, and every edge leads to a node
+    const char* nodes = bytes.data() + HEADER_SIZE;
+    const char* targets = nodes + nodesBytes;
+    std::uint32_t previous = 0;
+    for (std::size_t node = 0; node <= nodeCount; ++node) {
+        std::uint32_t begin = readU32(nodes, node) & EDGE_MASK;
+        if (begin < previous || begin > edgeCount) {
+            error_ = "Dictionary file is truncated or corrupt";
+            return false;
+        }
+        previous = begin;
+    }
+    for (std::size_t edge = 0; edge < edgeCount; ++edge) {
+        if (readU32(targets, edge) >= nodeCount) {
+            error_ = "Dictionary file is truncated or corrupt";
+            return false;
+        }
+    }
+
+    bytes_ = bytes;
+    nodes_ = nodes;
+    targets_ = targets;
+    labels_ = reinterpret_cast<const unsigned char*>(targets_ +
+                                                     static_cast<std::size_t>(edgeCount) * 4);
+    nodeCount_ = nodeCount;
+    edgeCount_ = edgeCount;
+    wordCount_ = wordCount;
+    root_ = nodeCount > 0 ? root : NO_NODE;
+    return true;
+}
+
+std::vector<char> Dictionary::build(std::vector<std::string> words) {
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    words.erase(std::remove(words.begin(), words.end(), std::string()), words.end());
+
+    // Incremental construction of a minimal automaton from sorted input
+    // (Daciuk et al. 2000). Nodes on the path of the previous word stay
+    // "unchecked" until the next word diverges; they are then merged with an
+    // equivalent registered node or registered themselves.
+    std::vector<BuildNode> nodes(1);
+    std::unordered_map<std::string, std::uint32_t> registry;
+    struct Unchecked {
+        std::uint32_t parent;
+        std::uint32_t child;
+    };
+    std::vector<Unchecked> unchecked;
+
+    auto signature = [&](std::uint32_t id) {
+        const BuildNode& node = nodes[id];
+        std::string sig;
+        sig.reserve(1 + node.edges.size() * 5);
+        sig.push_back(node.final ? '1' : '0');
+        for (const auto& [label, target] : node.edges) {
+            sig.push_back(static_cast<char>(label));
+            sig.append(reinterpret_cast<const char*>(&target), sizeof(target));
+        }
+        return sig;
+    };
+
+    auto minimize = [&](std::size_t downTo) {
+        while (unchecked.size() > downTo) {
+            Unchecked entry = unchecked.back();
+            unchecked.pop_back();
+            std::string sig = signature(entry.child);
+            auto it = registry.find(sig);
+            if (it != registry.end()) {
+                // The child is always the most recently added edge
+                nodes[entry.parent].edges.back().second = it->second;
+            } else {
+                registry.emplace(std::move(sig), entry.child);
+            }
+        }
+    };
+
+    std::string_view previous;
+    for (const std::string& word : words) {
+        std::size_t common = 0;
+        std::size_t limit = std::min(word.size(), previous.size());
+        while (common < limit && word[common] == previous[common]) ++common;
+
+        minimize(common);
+        std::uint32_t node = unchecked.empty() ? 0 : unchecked.back().child;
+        for (std::size_t i = common; i < word.size(); ++i) {
+            auto child = static_cast<std::uint32_t>(nodes.size());
+            nodes.emplace_back();
+            nodes[node].edges.emplace_back(static_cast<unsigned char>(word[i]), child);
+            unchecked.push_back({node, child});
+            node = child;
+        }
+        nodes[node].final = true;
+        previous = word;
+    }
+    minimize(0);
+
+    // Renumber reachable nodes breadth-first so the root is node 0 and
+    // merged-away nodes are dropped.
+    std::vector<std::uint32_t> remap(nodes.size(), NO_NODE);
+    std::vector<std::uint32_t> order;
+    order.reserve(registry.size() + 1);
+    remap[0] = 0;
+    order.push_back(0);
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        for (const auto& edge : nodes[order[i]].edges) {
+            if (remap[edge.second] == NO_NODE) {
+                remap[edge.second] = static_cast<std::uint32_t>(order.size());
+                order.push_back(edge.second);
+            }
+        }
+    }
+
+    std::uint32_t edgeCount = 0;
+    for (std::uint32_t id : order) {
+        edgeCount += static_cast<std::uint32_t>(nodes[id].edges.size());
+    }
+    auto nodeCount = static_cast<std::uint32_t>(order.size());
+
+    std::vector<char> out;
+    out.reserve(HEADER_SIZE + (nodeCount + 1) * 4 + edgeCount * 5);
+    out.insert(out.end(), DAWG_MAGIC, DAWG_MAGIC + 8);
+    appendU32(out, FORMAT_VERSION);
+    appendU32(out, nodeCount);
+    appendU32(out, edgeCount);
+    appendU32(out, static_cast<std::uint32_t>(words.size()));
+    appendU32(out, 0);  // root
+    appendU32(out, BYTE_ORDER_MARK);
+
+    std::uint32_t firstEdge = 0;
+    for (std::uint32_t id : order) {
+        appendU32(out, firstEdge | (nodes[id].final ? FINAL_BIT : 0u));
+        firstEdge += static_cast<std::uint32_t>(nodes[id].edges.size());
+    }
+    appendU32(out, firstEdge);  // Sentinel bounding the last node's edges
+    for (std::uint32_t id : order) {
+        for (const auto& edge : nodes[id].edges) appendU32(out, remap[edge.second]);
+    }
+    for (std::uint32_t id : order) {
+        for (const auto& edge : nodes[id].edges) out.push_back(static_cast<char>(edge.first));
+    }
+    return out;
+}
+
+bool Dictionary::buildFile(std::vector<std::string> words, const std::string& path,
+                           std::string* error) {
+    std::vector<char> bytes = build(std::move(words));
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        if (error) *error = "Failed to open file for writing: " + path;
+        return false;
+    }
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out.good()) {
+        if (error) *error = "Failed to write dictionary: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool Dictionary::isCurrent(const std::string& path, const std::string& wordListPath) {
+    std::error_code ec;
+    auto built = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    auto source = std::filesystem::last_write_time(wordListPath, ec);
+    return ec || source <= built;
+}
+
+std::vector<std::string> Dictionary::readWordList(
+    const std::string& path, const std::function<std::string(const std::string&)>& normalize) {
+    std::vector<std::string> words;
+    std::ifstream in(path);
+    if (!in) return words;
+
+    auto notSpace = [](unsigned char ch) { return !std::isspace(ch); };
+    std::string line;
+    while (std::getline(in, line)) {
+        line.erase(line.begin(), std::find_if(line.begin(), line.end(), notSpace));
+        line.erase(std::find_if(line.rbegin(), line.rend(), notSpace).base(), line.end());
+        if (line.empty() || line[0] == '#') continue;
+        std::string word = normalize ? normalize(line) : line;
+        if (!word.empty()) words.push_back(std::move(word));
+    }
+    return words;
+}
+
+// ============================================================================
+// Queries
+// ============================================================================
+
+std::uint32_t Dictionary::nodeEntry(NodeId node) const { return readU32(nodes_, node); }
+
+Dictionary::NodeId Dictionary::edgeTarget(std::uint32_t edge) const {
+    return readU32(targets_, edge);
+}
+
+Dictionary::NodeId Dictionary::step(NodeId node, char ch) const {
+    auto label = static_cast<unsigned char>(ch);
+    std::uint32_t end = edgeEnd(node);
+    // Fan-out is at most the alphabet size, so a linear scan over the
+    // contiguous label bytes beats a binary search here.
+    for (std::uint32_t e = edgeBegin(node); e < end; ++e) {
+        if (labels_[e] == label) return edgeTarget(e);
+        if (labels_[e] > label) break;
+    }
+    return NO_NODE;
+}
+
+bool Dictionary::contains(std::string_view word) const {
+    if (root_ == NO_NODE || word.empty()) return false;
+    NodeId node = root_;
+    for (char ch : word) {
+        node = step(node, ch);
+        if (node == NO_NODE) return false;
+    }
+    return isFinal(node);
+}
+
+bool Dictionary::hasPrefix(std::string_view prefix) const {
+    if (root_ == NO_NODE) return false;
+    NodeId node = root_;
+    for (char ch : prefix) {
+        node = step(node, ch);
+        if (node == NO_NODE) return false;
+    }
+    return true;
+}
+
+void Dictionary::forEachWithPrefix(std::string_view prefix,
+                                   const std::function<bool(std::string_view)>& visit) const {
+    if (root_ == NO_NODE) return;
+    NodeId start = root_;
+    for (char ch : prefix) {
+        start = step(start, ch);
+        if (start == NO_NODE) return;
+    }
+
+    std::string word(prefix);
+    struct Frame {
+        NodeId node;
+        std::uint32_t nextEdge;
+    };
+    std::vector<Frame> stack;
+    if (isFinal(start) && !word.empty() && !visit(word)) return;
+    stack.push_back({start, edgeBegin(start)});
+
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (frame.nextEdge >= edgeEnd(frame.node)) {
+            stack.pop_back();
+            if (word.size() > prefix.size()) word.pop_back();
+            continue;
+        }
+        std::uint32_t edge = frame.nextEdge++;
+        NodeId child = edgeTarget(edge);
+        word.push_back(edgeLabel(edge));
+        if (isFinal(child) && !visit(word)) return;
+        stack.push_back({child, edgeBegin(child)});
+    }
+}
+
+void Dictionary::searchWithinDistance(std::string_view word, std::size_t maxDistance,
+                                      const DistanceVisitor& visit) const {
+    if (root_ == NO_NODE) return;
+
+    const std::size_t cols = word.size() + 1;
+    const std::size_t maxDepth = word.size() + maxDistance;
+    // rows[d] holds edit distances between the current depth-d prefix and
+    // every prefix of word; one allocation per search.
+    std::vector<std::size_t> rows((maxDepth + 1) * cols);
+    for (std::size_t j = 0; j < cols; ++j) rows[j] = j;
+    std::string prefix;
+    prefix.reserve(maxDepth);
+
+    struct Frame {
+        NodeId node;
+        std::uint32_t nextEdge;
+    };
+    std::vector<Frame> stack;
+    stack.reserve(maxDepth + 1);
+    stack.push_back({root_, edgeBegin(root_)});
+
+    std::size_t limit = maxDistance;
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        if (frame.nextEdge >= edgeEnd(frame.node)) {
+            stack.pop_back();
+            if (!prefix.empty()) prefix.pop_back();
+            continue;
+        }
+        std::uint32_t edge = frame.nextEdge++;
+        std::size_t depth = stack.size();  // Depth of the child
+        if (depth > maxDepth) continue;
+
+        char label = edgeLabel(edge);
+        const std::size_t* prev = &rows[(depth - 1) * cols];
+        std::size_t* row = &rows[depth * cols];
+        row[0] = prev[0] + 1;
+        std::size_t best = row[0];
+        for (std::size_t j = 1; j < cols; ++j) {
+            std::size_t cost = word[j - 1] == label ? 0 : 1;
+            row[j] = std::min({prev[j] + 1, row[j - 1] + 1, prev[j - 1] + cost});
+            best = std::min(best, row[j]);
+        }
+        if (best > limit) continue;
+
+        NodeId child = edgeTarget(edge);
+        prefix.push_back(label);
+        if (isFinal(child) && row[cols - 1] <= limit) {
+            limit = visit(prefix, row[cols - 1]);
+        }
+        stack.push_back({child, edgeBegin(child)});
+    }
+}
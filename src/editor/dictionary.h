@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+
+// Compact read-only word list stored as a minimal acyclic automaton (DAWG).
+//
+// Shared prefixes and suffixes are merged, so a 500k-word list fits in a
+// few MB instead of one heap node per word. The on-disk layout is the
+// in-memory layout: a .dawg file is memory-mapped and used directly with no
+// parsing at startup. Lookups walk the automaton and never allocate.
+//
+// File layout (native byte order, recorded by the byte-order mark):
+//   Header   magic "WPDAWG01", version, nodeCount, edgeCount, wordCount, root,
+//            byte-order mark BYTE_ORDER_MARK
+//   Nodes    uint32[nodeCount + 1]  bit 31 = final, bits 0-30 = first edge
+//                                   (entry n+1 bounds node n's edge range)
+//   Targets  uint32[edgeCount]      destination node of each edge
+//   Labels   uint8[edgeCount]       edge byte; sorted ascending per node
+//
+// Words are stored exactly as given; SpellChecker stores normalized
+// (lowercase, apostrophe-free) words.
+class Dictionary {
+   public:
+    using NodeId = std::uint32_t;
+    static constexpr NodeId NO_NODE = 0xFFFFFFFFu;
+    static constexpr std::uint32_t FORMAT_VERSION = 2;
+    static constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304u;
+
+    Dictionary() = default;
+    Dictionary(const Dictionary&) = delete;
+    Dictionary& operator=(const Dictionary&) = delete;
+    Dictionary(Dictionary&& other) noexcept;
+    Dictionary& operator=(Dictionary&& other) noexcept;
+
+    // Map a .dawg file. Returns false (and sets error()) if the file is
+    // missing, truncated or not a dictionary.
+    bool load(const std::string& path);
+
+    // Build in memory from an unsorted word list (duplicates allowed)
+    static Dictionary fromWords(std::vector<std::string> words);
+
+    // Serialize a word list into the .dawg format
+    static std::vector<char> build(std::vector<std::string> words);
+    static bool buildFile(std::vector<std::string> words, const std::string& path,
+                          std::string* error = nullptr);
+
+    // True when the .dawg at path exists and is at least as new as the word
+    // list it is compiled from (or that list is gone). A stale one must not
+    // hide edits to the list.
+    static bool isCurrent(const std::string& path, const std::string& wordListPath);
+
+    // Read a plain word list (one per line, '#' comments) and normalize each
+    // entry with normalize (if provided)
+    static std::vector<std::string> readWordList(
+        const std::string& path,
+        const std::function<std::string(const std::string&)>& normalize = {});
+
+    bool contains(std::string_view word) const;
+    bool hasPrefix(std::string_view prefix) const;
+
+    // Visit words starting with prefix in lexicographic order.
+    // Return false from visit to stop.
+    void forEachWithPrefix(std::string_view prefix,
+                           const std::function<bool(std::string_view)>& visit) const;
+
+    // Visit every word within maxDistance Levenshtein edits of word, in
+    // lexicographic order. The DP row for each prefix is shared by all
+    // words below it, and subtrees whose best row entry already exceeds the
+    // limit are skipped. visit(candidate, distance) returns the limit to
+    // continue with, so callers can tighten it as results come in.
+    using DistanceVisitor = std::function<std::size_t(std::string_view, std::size_t)>;
+    void searchWithinDistance(std::string_view word, std::size_t maxDistance,
+                              const DistanceVisitor& visit) const;
+
+    bool empty() const { return wordCount_ == 0; }
+    std::size_t size() const { return wordCount_; }
+    std::size_t nodeCount() const { return nodeCount_; }
+    std::size_t edgeCount() const { return edgeCount_; }
+    std::size_t memoryBytes() const { return bytes_.size(); }
+    bool isMapped() const { return file_.isMapped(); }
+    const std::string& error() const { return error_; }
+
+    // Low-level traversal (used by the suggestion search)
+    NodeId root() const { return root_; }
+    bool isFinal(NodeId node) const { return (nodeEntry(node) & FINAL_BIT) != 0; }
+    std::uint32_t edgeBegin(NodeId node) const { return nodeEntry(node) & EDGE_MASK; }
+    std::uint32_t edgeEnd(NodeId node) const { return nodeEntry(node + 1) & EDGE_MASK; }
+    char edgeLabel(std::uint32_t edge) const { return static_cast<char>(labels_[edge]); }
+    NodeId edgeTarget(std::uint32_t edge) const;
+    // Follow the edge labelled ch, or NO_NODE
+    NodeId step(NodeId node, char ch) const;
+
+   private:
+    static constexpr std::uint32_t FINAL_BIT = 0x80000000u;
+    static constexpr std::uint32_t EDGE_MASK = 0x7FFFFFFFu;
+
+    bool attach(std::string_view bytes);
+    std::uint32_t nodeEntry(NodeId node) const;
+
+    MappedFile file_;            // Backing store when loaded from disk
+    std::vector<char> owned_;    // Backing store when built in memory
+    std::string_view bytes_;
+    const char* nodes_ = nullptr;
+    const char* targets_ = nullptr;
+    const unsigned char* labels_ = nullptr;
+    std::uint32_t nodeCount_ = 0;
+    std::uint32_t edgeCount_ = 0;
+    std::uint32_t wordCount_ = 0;
+    NodeId root_ = NO_NODE;
+    std::string error_;
+};
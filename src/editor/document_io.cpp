@@ -2,10 +2,13 @@
 
 #include <algorithm>
 #include <filesystem>
-#include <fstream>
 #include <nlohmann/json.hpp>
-#include <sstream>
 
+#include "atomic_file.h"
+#include "binary_document.h"
+#include "json_scan.h"
+#include "mapped_file.h"
+#include "office_import.h"
 #include "table.h"
 
 // Helper to convert PageMode to string
@@ -83,6 +86,9 @@ static CellAlignment cellAlignmentFromString(const std::string &str) {
 static nlohmann::json serializeCell(const TableCell &cell) {
     nlohmann::json j;
     j["content"] = cell.content;
+    // A formula cell keeps its source next to the value in content, so the
+    // table shows (and exports) without being recalculated on load
+    if (!cell.formula.empty()) j["formula"] = cell.formula;
     j["rowSpan"] = cell.span.rowSpan;
     j["colSpan"] = cell.span.colSpan;
     j["alignment"] = cellAlignmentToString(cell.alignment);
@@ -109,6 +115,7 @@ static nlohmann::json serializeCell(const TableCell &cell) {
 static TableCell deserializeCell(const nlohmann::json &j) {
     TableCell cell;
     if (j.contains("content")) cell.content = j["content"].get<std::string>();
+    if (j.contains("formula")) cell.formula = j["formula"].get<std::string>();
     if (j.contains("rowSpan")) cell.span.rowSpan = j["rowSpan"].get<std::size_t>();
     if (j.contains("colSpan")) cell.span.colSpan = j["colSpan"].get<std::size_t>();
     if (j.contains("alignment")) cell.alignment = cellAlignmentFromString(j["alignment"].get<std::string>());
@@ -201,10 +208,18 @@ static Table deserializeTable(const nlohmann::json &j) {
             }
         }
     }
+    table.rebuildFormulas();
     
     return table;
 }
 
+static std::string lowercaseExtension(const std::string &path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    return extension;
+}
+
 bool saveTextFile(const TextBuffer &buffer, const std::string &path) {
     auto result = saveTextFileEx(buffer, path);
     return result.success;
@@ -223,28 +238,14 @@ DocumentResult saveTextFileEx(const TextBuffer &buffer,
     return saveDocumentEx(buffer, settings, path);
 }
 
-DocumentResult saveDocumentEx(const TextBuffer &buffer,
-                              const DocumentSettings &settings,
-                              const std::string &path) {
-    DocumentResult result;
-
-    std::filesystem::path output_path(path);
-    if (!output_path.parent_path().empty()) {
-        std::filesystem::create_directories(output_path.parent_path());
-    }
-
-    std::ofstream ofs(output_path);
-    if (!ofs.is_open()) {
-        result.error = "Could not open file for writing: " + path;
-        return result;
-    }
-
+// Everything except the text: small, so still built with nlohmann::json
+static nlohmann::json documentSettingsJson(const DocumentSettings &settings,
+                                           const TableList *tables) {
     const TextStyle &style = settings.textStyle;
     const PageSettings &page = settings.pageSettings;
 
     nlohmann::json doc;
     doc["version"] = DocumentSettings::VERSION;
-    doc["text"] = buffer.getText();
 
     // Style settings (document-specific, saved with file)
     doc["style"] = {
@@ -294,9 +295,147 @@ DocumentResult saveDocumentEx(const TextBuffer &buffer,
         doc["fontRequirements"] = fonts_array;
     }
 
-    ofs << doc.dump(2);
-    if (!ofs.good()) {
-        result.error = "Failed to write to file: " + path;
+    // Serialize tables
+    if (tables && !tables->empty()) {
+        nlohmann::json tables_array = nlohmann::json::array();
+        for (const auto &[lineNum, table] : *tables) {
+            nlohmann::json table_entry;
+            table_entry["line"] = lineNum;
+            table_entry["table"] = serializeTable(table);
+            tables_array.push_back(table_entry);
+        }
+        doc["tables"] = tables_array;
+    }
+
+    return doc;
+}
+
+// Write text as a JSON string literal, escaping the same characters as
+// nlohmann::json::dump. Runs that need no escaping are copied as is.
+static void writeJsonString(AtomicFileWriter &out, const std::vector<std::string_view> &text) {
+    out.put('"');
+    for (std::string_view chunk : text) {
+        std::size_t runStart = 0;
+        for (std::size_t i = 0; i < chunk.size(); ++i) {
+            auto ch = static_cast<unsigned char>(chunk[i]);
+            if (ch >= 0x20 && ch != '"' && ch != '\\') continue;
+
+            out.write(chunk.data() + runStart, i - runStart);
+            runStart = i + 1;
+            switch (ch) {
+                case '"': out.write("\\\"", 2); break;
+                case '\\': out.write("\\\\", 2); break;
+                case '\b': out.write("\\b", 2); break;
+                case '\f': out.write("\\f", 2); break;
+                case '\n': out.write("\\n", 2); break;
+                case '\r': out.write("\\r", 2); break;
+                case '\t': out.write("\\t", 2); break;
+                default: {
+                    static const char hex[] = "0123456789abcdef";
+                    const char escaped[6] = {'\\', 'u', '0', '0', hex[ch >> 4], hex[ch & 0xF]};
+                    out.write(escaped, sizeof(escaped));
+                    break;
+                }
+            }
+        }
+        out.write(chunk.data() + runStart, chunk.size() - runStart);
+    }
+    out.put('"');
+}
+
+// .wpdb: the same settings and table JSON as .wpdoc, in their own sections,
+// with the text stored raw in line-aligned chunks
+static DocumentResult saveBinaryDocument(const std::vector<std::string_view> &text,
+                                         const DocumentSettings &settings,
+                                         const TableList *tables, const std::string &path) {
+    DocumentResult result;
+    BinaryDocumentWriter out;
+    if (!out.open(path)) {
+        result.error = "Could not open file for writing: " + path;
+        return result;
+    }
+    out.addSection(WpdbSection::Settings, documentSettingsJson(settings, nullptr).dump());
+    out.addText(text);
+    if (tables) {
+        for (const auto &[lineNum, table] : *tables) {
+            nlohmann::json table_entry;
+            table_entry["line"] = lineNum;
+            table_entry["table"] = serializeTable(table);
+            out.addSection(WpdbSection::Table, table_entry.dump(), lineNum);
+        }
+    }
+    if (!out.commit()) {
+        result.error = "Failed to write to file: " + path + " (" + out.error() + ")";
+        return result;
+    }
+    result.success = true;
+    return result;
+}
+
+// Shared by the save functions (tables may be null). The output matches
+// nlohmann's dump(2) of the whole document, but the text is escaped chunk by
+// chunk straight from its storage (the gap buffer's two runs, or a snapshot)
+// instead of being copied into a DOM and then into a dump string. The file
+// is written to a temporary sibling and renamed over the target once it is
+// on disk.
+static DocumentResult saveDocumentToFile(const std::vector<std::string_view> &text,
+                                         const DocumentSettings &settings,
+                                         const TableList *tables, const std::string &path) {
+    DocumentResult result;
+
+    std::filesystem::path output_path(path);
+    if (!output_path.parent_path().empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(output_path.parent_path(), ec);
+    }
+    if (lowercaseExtension(path) == ".wpdb") {
+        return saveBinaryDocument(text, settings, tables, path);
+    }
+
+    AtomicFileWriter out;
+    if (!out.open(path)) {
+        result.error = "Could not open file for writing: " + path;
+        return result;
+    }
+
+    // Members come out in nlohmann's (sorted) key order with "text" slotted
+    // in, so files look exactly as they did when the whole DOM was dumped
+    nlohmann::json doc = documentSettingsJson(settings, tables);
+    bool first = true;
+    bool textWritten = false;
+    auto writeKey = [&](std::string_view key) {
+        out.write(first ? "\n  \"" : ",\n  \"");
+        out.write(key);
+        out.write("\": ");
+        first = false;
+    };
+    out.put('{');
+    for (auto it = doc.begin(); it != doc.end(); ++it) {
+        if (!textWritten && it.key() > "text") {
+            writeKey("text");
+            writeJsonString(out, text);
+            textWritten = true;
+        }
+        writeKey(it.key());
+        // Nested values are one level deeper than a standalone dump
+        std::string value = it.value().dump(2);
+        std::size_t runStart = 0;
+        for (std::size_t nl = value.find('\n'); nl != std::string::npos;
+             nl = value.find('\n', nl + 1)) {
+            out.write(value.data() + runStart, nl + 1 - runStart);
+            out.write("  ");
+            runStart = nl + 1;
+        }
+        out.write(value.data() + runStart, value.size() - runStart);
+    }
+    if (!textWritten) {
+        writeKey("text");
+        writeJsonString(out, text);
+    }
+    out.write("\n}");
+
+    if (!out.commit()) {
+        result.error = "Failed to write to file: " + path + " (" + out.error() + ")";
         return result;
     }
 
@@ -304,295 +443,349 @@ DocumentResult saveDocumentEx(const TextBuffer &buffer,
     return result;
 }
 
+static std::vector<std::string_view> textChunks(const TextBuffer &buffer) {
+    std::vector<std::string_view> chunks;
+    buffer.forEachTextChunk([&chunks](std::string_view chunk) { chunks.push_back(chunk); });
+    return chunks;
+}
+
+DocumentResult saveDocumentEx(const TextBuffer &buffer,
+                              const DocumentSettings &settings,
+                              const std::string &path) {
+    return saveDocumentToFile(textChunks(buffer), settings, nullptr, path);
+}
+
+DocumentResult saveDocumentSnapshot(std::string_view text, const DocumentSettings &settings,
+                                    const std::string &path) {
+    return saveDocumentToFile({text}, settings, nullptr, path);
+}
+
 DocumentResult loadTextFileEx(TextBuffer &buffer, const std::string &path) {
     // Use the new function with default settings (discards loaded settings)
     DocumentSettings settings;
     return loadDocumentEx(buffer, settings, path);
 }
 
-DocumentResult loadDocumentEx(TextBuffer &buffer, DocumentSettings &settings,
-                              const std::string &path) {
-    DocumentResult result;
-
-    std::ifstream ifs(path);
-    if (!ifs.is_open()) {
-        result.error = "Could not open file: " + path;
-        return result;
+// Read the settings members of a parsed document (every member but "text"
+// and "tables"). Shared by the .wpdoc and .wpdb loaders.
+static void readDocumentSettings(const nlohmann::json &doc, DocumentSettings &settings,
+                                 DocumentResult &result) {
+    // Check version
+    if (doc.contains("version")) {
+        int version = doc.at("version").get<int>();
+        if (version != DocumentSettings::VERSION) {
+            result.error =
+                "Unsupported document version: " + std::to_string(version);
+            result.usedFallback = true;
+            // Still try to load
+        }
     }
 
-    std::ostringstream contents;
-    contents << ifs.rdbuf();
-    std::string raw = contents.str();
-
-    const std::filesystem::path input_path(path);
-    std::string extension = input_path.extension().string();
-    std::transform(extension.begin(), extension.end(), extension.begin(),
-                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
-    if (extension == ".txt" || extension == ".md") {
-        buffer.setText(raw);
-        result.success = true;
-        result.usedFallback = true;
-        return result;
+    // Load text style (document-specific settings)
+    if (doc.contains("style")) {
+        TextStyle &style = settings.textStyle;
+        const nlohmann::json &style_json = doc.at("style");
+        if (style_json.contains("bold")) {
+            style.bold = style_json.at("bold").get<bool>();
+        }
+        if (style_json.contains("italic")) {
+            style.italic = style_json.at("italic").get<bool>();
+        }
+        if (style_json.contains("underline")) {
+            style.underline = style_json.at("underline").get<bool>();
+        }
+        if (style_json.contains("strikethrough")) {
+            style.strikethrough = style_json.at("strikethrough").get<bool>();
+        }
+        if (style_json.contains("superscript")) {
+            style.superscript = style_json.at("superscript").get<bool>();
+        }
+        if (style_json.contains("subscript")) {
+            style.subscript = style_json.at("subscript").get<bool>();
+        }
+        if (style_json.contains("font")) {
+            style.font = style_json.at("font").get<std::string>();
+        }
+        if (style_json.contains("fontSize")) {
+            int fontSize = style_json.at("fontSize").get<int>();
+            // Clamp to valid range
+            style.fontSize = std::max(8, std::min(72, fontSize));
+        }
+        if (style_json.contains("textColor")) {
+            const nlohmann::json &color = style_json.at("textColor");
+            if (color.contains("r")) style.textColor.r = color.at("r").get<unsigned char>();
+            if (color.contains("g")) style.textColor.g = color.at("g").get<unsigned char>();
+            if (color.contains("b")) style.textColor.b = color.at("b").get<unsigned char>();
+            if (color.contains("a")) style.textColor.a = color.at("a").get<unsigned char>();
+        }
+        if (style_json.contains("highlightColor")) {
+            const nlohmann::json &color = style_json.at("highlightColor");
+            if (color.contains("r")) style.highlightColor.r = color.at("r").get<unsigned char>();
+            if (color.contains("g")) style.highlightColor.g = color.at("g").get<unsigned char>();
+            if (color.contains("b")) style.highlightColor.b = color.at("b").get<unsigned char>();
+            if (color.contains("a")) style.highlightColor.a = color.at("a").get<unsigned char>();
+        }
     }
 
-    try {
-        nlohmann::json doc = nlohmann::json::parse(raw);
-
-        // Check version
-        if (doc.contains("version")) {
-            int version = doc.at("version").get<int>();
-            if (version != DocumentSettings::VERSION) {
-                result.error =
-                    "Unsupported document version: " + std::to_string(version);
-                result.usedFallback = true;
-                // Still try to load
-            }
+    // Load text options
+    if (doc.contains("options")) {
+        const nlohmann::json &opts = doc.at("options");
+        if (opts.contains("smartQuotesEnabled")) {
+            settings.smartQuotesEnabled = opts.at("smartQuotesEnabled").get<bool>();
         }
-
-        if (doc.contains("text")) {
-            buffer.setText(doc.at("text").get<std::string>());
-        } else {
-            // JSON but no text field - use raw
-            buffer.setText(raw);
-            result.usedFallback = true;
+        if (opts.contains("tabWidth")) {
+            settings.tabWidth = opts.at("tabWidth").get<int>();
         }
+    }
 
-        // Load text style (document-specific settings)
-        if (doc.contains("style")) {
-            TextStyle &style = settings.textStyle;
-            const nlohmann::json &style_json = doc.at("style");
-            if (style_json.contains("bold")) {
-                style.bold = style_json.at("bold").get<bool>();
-            }
-            if (style_json.contains("italic")) {
-                style.italic = style_json.at("italic").get<bool>();
-            }
-            if (style_json.contains("underline")) {
-                style.underline = style_json.at("underline").get<bool>();
-            }
-            if (style_json.contains("strikethrough")) {
-                style.strikethrough = style_json.at("strikethrough").get<bool>();
-            }
-            if (style_json.contains("superscript")) {
-                style.superscript = style_json.at("superscript").get<bool>();
-            }
-            if (style_json.contains("subscript")) {
-                style.subscript = style_json.at("subscript").get<bool>();
-            }
-            if (style_json.contains("font")) {
-                style.font = style_json.at("font").get<std::string>();
-            }
-            if (style_json.contains("fontSize")) {
-                int fontSize = style_json.at("fontSize").get<int>();
-                // Clamp to valid range
-                style.fontSize = std::max(8, std::min(72, fontSize));
-            }
-            if (style_json.contains("textColor")) {
-                const nlohmann::json &color = style_json.at("textColor");
-                if (color.contains("r")) style.textColor.r = color.at("r").get<unsigned char>();
-                if (color.contains("g")) style.textColor.g = color.at("g").get<unsigned char>();
-                if (color.contains("b")) style.textColor.b = color.at("b").get<unsigned char>();
-                if (color.contains("a")) style.textColor.a = color.at("a").get<unsigned char>();
-            }
-            if (style_json.contains("highlightColor")) {
-                const nlohmann::json &color = style_json.at("highlightColor");
-                if (color.contains("r")) style.highlightColor.r = color.at("r").get<unsigned char>();
-                if (color.contains("g")) style.highlightColor.g = color.at("g").get<unsigned char>();
-                if (color.contains("b")) style.highlightColor.b = color.at("b").get<unsigned char>();
-                if (color.contains("a")) style.highlightColor.a = color.at("a").get<unsigned char>();
-            }
-            buffer.setTextStyle(style);
+    // Load page layout settings (document-specific settings)
+    if (doc.contains("pageLayout")) {
+        PageSettings &page = settings.pageSettings;
+        const nlohmann::json &page_json = doc.at("pageLayout");
+        if (page_json.contains("mode")) {
+            page.mode =
+                pageModeFromString(page_json.at("mode").get<std::string>());
+        }
+        if (page_json.contains("pageWidth")) {
+            page.pageWidth = page_json.at("pageWidth").get<float>();
+        }
+        if (page_json.contains("pageHeight")) {
+            page.pageHeight = page_json.at("pageHeight").get<float>();
+        }
+        if (page_json.contains("pageMargin")) {
+            page.pageMargin = page_json.at("pageMargin").get<float>();
+        }
+        if (page_json.contains("lineWidthLimit")) {
+            page.lineWidthLimit =
+                page_json.at("lineWidthLimit").get<float>();
         }
+    }
 
-        // Load text options
-        if (doc.contains("options")) {
-            const nlohmann::json &opts = doc.at("options");
-            if (opts.contains("smartQuotesEnabled")) {
-                settings.smartQuotesEnabled = opts.at("smartQuotesEnabled").get<bool>();
+    // Load font requirements (for lazy CJK font loading)
+    if (doc.contains("fontRequirements")) {
+        settings.fontRequirements.clear();
+        for (const auto &font_json : doc.at("fontRequirements")) {
+            FontRequirement req;
+            if (font_json.contains("fontId")) {
+                req.fontId = font_json.at("fontId").get<std::string>();
             }
-            if (opts.contains("tabWidth")) {
-                settings.tabWidth = opts.at("tabWidth").get<int>();
+            if (font_json.contains("scripts")) {
+                for (const auto &script_str : font_json.at("scripts")) {
+                    req.scripts.push_back(
+                        parseScriptRequirement(script_str.get<std::string>()));
+                }
             }
+            settings.fontRequirements.push_back(req);
         }
+    }
+}
 
-        // Load page layout settings (document-specific settings)
-        if (doc.contains("pageLayout")) {
-            PageSettings &page = settings.pageSettings;
-            const nlohmann::json &page_json = doc.at("pageLayout");
-            if (page_json.contains("mode")) {
-                page.mode =
-                    pageModeFromString(page_json.at("mode").get<std::string>());
-            }
-            if (page_json.contains("pageWidth")) {
-                page.pageWidth = page_json.at("pageWidth").get<float>();
-            }
-            if (page_json.contains("pageHeight")) {
-                page.pageHeight = page_json.at("pageHeight").get<float>();
-            }
-            if (page_json.contains("pageMargin")) {
-                page.pageMargin = page_json.at("pageMargin").get<float>();
-            }
-            if (page_json.contains("lineWidthLimit")) {
-                page.lineWidthLimit =
-                    page_json.at("lineWidthLimit").get<float>();
-            }
+DocumentResult loadBinaryDocumentSettings(const BinaryDocumentReader &reader,
+                                          DocumentSettings &settings) {
+    DocumentResult result;
+    const auto &sections = reader.sections();
+    for (std::size_t i = 0; i < sections.size(); ++i) {
+        if (sections[i].type != WpdbSection::Settings) continue;
+        std::string bytes;
+        if (!reader.readSection(i, bytes)) {
+            result.error = "Damaged settings section";
+            return result;
+        }
+        try {
+            readDocumentSettings(nlohmann::json::parse(bytes), settings, result);
+        } catch (const std::exception &e) {
+            result.error = std::string("Damaged settings section: ") + e.what();
+            return result;
         }
+        break;
+    }
+    result.success = true;
+    return result;
+}
 
-        // Load font requirements (for lazy CJK font loading)
-        if (doc.contains("fontRequirements")) {
-            settings.fontRequirements.clear();
-            for (const auto &font_json : doc.at("fontRequirements")) {
-                FontRequirement req;
-                if (font_json.contains("fontId")) {
-                    req.fontId = font_json.at("fontId").get<std::string>();
-                }
-                if (font_json.contains("scripts")) {
-                    for (const auto &script_str : font_json.at("scripts")) {
-                        req.scripts.push_back(
-                            parseScriptRequirement(script_str.get<std::string>()));
-                    }
-                }
-                settings.fontRequirements.push_back(req);
+DocumentResult loadBinaryDocumentTables(const BinaryDocumentReader &reader, TableList &tables) {
+    DocumentResult result;
+    tables.clear();
+    const auto &sections = reader.sections();
+    for (std::size_t i = 0; i < sections.size(); ++i) {
+        if (sections[i].type != WpdbSection::Table) continue;
+        std::string bytes;
+        try {
+            if (!reader.readSection(i, bytes)) throw std::runtime_error("bad checksum");
+            nlohmann::json table_entry = nlohmann::json::parse(bytes);
+            std::size_t lineNum = table_entry.value("line", 0);
+            if (table_entry.contains("table")) {
+                tables.emplace_back(lineNum, deserializeTable(table_entry["table"]));
             }
+        } catch (const std::exception &e) {
+            // Like .wpdoc: a damaged table is skipped, the rest still load
+            result.error = std::string("Damaged table section: ") + e.what();
         }
-
-        result.success = true;
-    } catch (const std::exception &e) {
-        // JSON parse failed - load as plain text
-        buffer.setText(raw);
-        result.success = true;
-        result.usedFallback = true;
-        result.error =
-            "Loaded as plain text (JSON parse error: " + std::string(e.what()) +
-            ")";
     }
+    result.success = true;
+    return result;
+}
 
+static DocumentResult loadBinaryDocument(TextBuffer &buffer, DocumentSettings &settings,
+                                         TableList *tables, const std::string &path) {
+    DocumentResult result;
+    BinaryDocumentReader reader;
+    if (!reader.open(path)) {
+        result.error = reader.error() + ": " + path;
+        return result;
+    }
+    if (!reader.readText(buffer)) {
+        result.error = "Damaged text in " + path;
+        return result;
+    }
+    result = loadBinaryDocumentSettings(reader, settings);
+    if (!result.success) return result;
+    buffer.setTextStyle(settings.textStyle);
+    if (tables) {
+        DocumentResult tableResult = loadBinaryDocumentTables(reader, *tables);
+        if (result.error.empty()) result.error = tableResult.error;
+    }
     return result;
 }
 
-DocumentResult saveDocumentWithTables(const TextBuffer &buffer,
-                                      const DocumentSettings &settings,
-                                      const TableList &tables,
-                                      const std::string &path) {
+// Shared by loadDocumentEx and loadDocumentWithTables (tables and images
+// may be null).
+// The file is walked with json_scan instead of being parsed into one big
+// DOM: the "text" string is decoded straight into the buffer's storage, and
+// only the small settings members (and each table entry, one at a time) go
+// through nlohmann::json. Peak memory is the mapped file plus the text.
+static DocumentResult loadDocumentFromFile(TextBuffer &buffer, DocumentSettings &settings,
+                                           TableList *tables, ImageCollection *images,
+                                           const std::string &path) {
     DocumentResult result;
 
-    std::filesystem::path output_path(path);
-    if (!output_path.parent_path().empty()) {
-        std::filesystem::create_directories(output_path.parent_path());
+    // Map the file instead of streaming it into a string: plain text goes
+    // from the mapped pages into the buffer in one copy
+    MappedFile file;
+    if (!file.open(path)) {
+        result.error = "Could not open file: " + path;
+        return result;
     }
+    std::string_view raw = file.view();
 
-    std::ofstream ofs(output_path);
-    if (!ofs.is_open()) {
-        result.error = "Could not open file for writing: " + path;
+    std::string extension = lowercaseExtension(path);
+    if (isOfficeDocumentPath(path)) {
+        file.close();
+        TableList scratch;
+        return importOfficeDocument(buffer, settings, tables ? *tables : scratch, images, path);
+    }
+    // No other format carries images, so the previous document's go
+    if (images) images->clear();
+    if (extension == ".txt" || extension == ".md") {
+        buffer.setText(raw);
+        result.success = true;
+        result.usedFallback = true;
         return result;
     }
+    if (BinaryDocumentReader::hasMagic(raw)) {
+        file.close();
+        return loadBinaryDocument(buffer, settings, tables, path);
+    }
 
-    const TextStyle &style = settings.textStyle;
-    const PageSettings &page = settings.pageSettings;
-
-    nlohmann::json doc;
-    doc["version"] = DocumentSettings::VERSION;
-    doc["text"] = buffer.getText();
-
-    // Style settings
-    doc["style"] = {
-        {"bold", style.bold},
-        {"italic", style.italic},
-        {"underline", style.underline},
-        {"strikethrough", style.strikethrough},
-        {"font", style.font},
-        {"fontSize", style.fontSize},
-        {"textColor", {{"r", style.textColor.r}, {"g", style.textColor.g},
-                       {"b", style.textColor.b}, {"a", style.textColor.a}}},
-        {"highlightColor", {{"r", style.highlightColor.r}, {"g", style.highlightColor.g},
-                            {"b", style.highlightColor.b}, {"a", style.highlightColor.a}}},
+    auto loadAsPlainText = [&](const std::string &reason) {
+        buffer.setText(raw);
+        result.success = true;
+        result.usedFallback = true;
+        result.error = "Loaded as plain text (JSON parse error: " + reason + ")";
+        return result;
     };
 
-    // Page layout settings
-    doc["pageLayout"] = {
-        {"mode", pageModeToString(page.mode)},
-        {"pageWidth", page.pageWidth},
-        {"pageHeight", page.pageHeight},
-        {"pageMargin", page.pageMargin},
-        {"lineWidthLimit", page.lineWidthLimit},
-    };
+    try {
+        // Settings members are small; collect them into a little DOM so they
+        // are read below exactly as before
+        nlohmann::json doc = nlohmann::json::object();
+        bool hasText = false;
+        const char *textError = nullptr;
+        std::size_t tablesBegin = json_scan::npos;
+
+        bool wellFormed = json_scan::forEachMember(
+            raw, [&](std::string_view key, std::size_t valueBegin, std::size_t valueEnd) {
+                if (key == "text") {
+                    if (raw[valueBegin] != '"') {
+                        textError = "\"text\" is not a string";
+                        return false;
+                    }
+                    hasText = buffer.setTextFrom(valueEnd - valueBegin, [&](char *out) {
+                        std::size_t written = 0;
+                        std::size_t end = json_scan::decodeString(raw, valueBegin, out, written);
+                        return end == json_scan::npos ? end : written;
+                    });
+                    if (!hasText) {
+                        textError = "invalid string in \"text\"";
+                        return false;
+                    }
+                } else if (key == "tables") {
+                    tablesBegin = valueBegin;  // Read after the settings
+                } else {
+                    doc[std::string(key)] = nlohmann::json::parse(raw.data() + valueBegin,
+                                                                  raw.data() + valueEnd);
+                }
+                return true;
+            });
+        if (textError) return loadAsPlainText(textError);
+        if (!wellFormed) return loadAsPlainText("malformed document");
 
-    // Font requirements
-    if (!settings.fontRequirements.empty()) {
-        nlohmann::json fonts_array = nlohmann::json::array();
-        for (const auto &req : settings.fontRequirements) {
-            nlohmann::json font_obj;
-            font_obj["fontId"] = req.fontId;
-            nlohmann::json scripts_array = nlohmann::json::array();
-            for (const auto &script : req.scripts) {
-                scripts_array.push_back(scriptRequirementId(script));
-            }
-            font_obj["scripts"] = scripts_array;
-            fonts_array.push_back(font_obj);
+        if (!hasText) {
+            // JSON but no text field - use raw
+            buffer.setText(raw);
+            result.usedFallback = true;
         }
-        doc["fontRequirements"] = fonts_array;
-    }
 
-    // Serialize tables
-    if (!tables.empty()) {
-        nlohmann::json tables_array = nlohmann::json::array();
-        for (const auto &[lineNum, table] : tables) {
-            nlohmann::json table_entry;
-            table_entry["line"] = lineNum;
-            table_entry["table"] = serializeTable(table);
-            tables_array.push_back(table_entry);
+        readDocumentSettings(doc, settings, result);
+        if (doc.contains("style")) {
+            buffer.setTextStyle(settings.textStyle);
         }
-        doc["tables"] = tables_array;
-    }
 
-    ofs << doc.dump(2);
-    if (!ofs.good()) {
-        result.error = "Failed to write to file: " + path;
-        return result;
+        // Tables are parsed one entry at a time
+        if (tables && tablesBegin != json_scan::npos) {
+            tables->clear();
+            try {
+                json_scan::forEachElementAt(
+                    raw, tablesBegin, [&](std::size_t entryBegin, std::size_t entryEnd) {
+                        nlohmann::json table_entry = nlohmann::json::parse(
+                            raw.data() + entryBegin, raw.data() + entryEnd);
+                        std::size_t lineNum = table_entry.value("line", 0);
+                        if (table_entry.contains("table")) {
+                            Table table = deserializeTable(table_entry["table"]);
+                            tables->emplace_back(lineNum, std::move(table));
+                        }
+                        return true;
+                    });
+            } catch (const std::exception &) {
+                // Ignore errors - remaining tables just won't be loaded
+            }
+        }
+
+        result.success = true;
+    } catch (const std::exception &e) {
+        // JSON parse failed - load as plain text
+        return loadAsPlainText(e.what());
     }
 
-    result.success = true;
     return result;
 }
 
+DocumentResult loadDocumentEx(TextBuffer &buffer, DocumentSettings &settings,
+                              const std::string &path, ImageCollection *images) {
+    return loadDocumentFromFile(buffer, settings, nullptr, images, path);
+}
+
+DocumentResult saveDocumentWithTables(const TextBuffer &buffer,
+                                      const DocumentSettings &settings,
+                                      const TableList &tables,
+                                      const std::string &path) {
+    return saveDocumentToFile(textChunks(buffer), settings, &tables, path);
+}
+
 DocumentResult loadDocumentWithTables(TextBuffer &buffer, 
                                       DocumentSettings &settings,
                                       TableList &tables,
-                                      const std::string &path) {
-    // First load the basic document
-    DocumentResult result = loadDocumentEx(buffer, settings, path);
-    
-    if (!result.success && !result.usedFallback) {
-        return result;
-    }
-    
-    // Now try to load tables from the file
-    std::ifstream ifs(path);
-    if (!ifs.is_open()) {
-        return result;  // Return previous result
-    }
-    
-    std::ostringstream contents;
-    contents << ifs.rdbuf();
-    std::string raw = contents.str();
-    
-    try {
-        nlohmann::json doc = nlohmann::json::parse(raw);
-        
-        // Load tables
-        if (doc.contains("tables")) {
-            tables.clear();
-            for (const auto &table_entry : doc["tables"]) {
-                std::size_t lineNum = table_entry.value("line", 0);
-                if (table_entry.contains("table")) {
-                    Table table = deserializeTable(table_entry["table"]);
-                    tables.emplace_back(lineNum, std::move(table));
-                }
-            }
-        }
-    } catch (const std::exception &) {
-        // Ignore errors - tables just won't be loaded
-    }
-    
-    return result;
+                                      const std::string &path,
+                                      ImageCollection *images) {
+    return loadDocumentFromFile(buffer, settings, &tables, images, path);
 }
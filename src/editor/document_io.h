@@ -2,13 +2,17 @@
 #define WORDPROC_EDITOR_DOCUMENT_IO_H
 
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include "binary_document.h"
 #include "document_settings.h"
 #include "table.h"
 #include "text_buffer.h"
 
+class ImageCollection;
+
 // Load/save result with error information
 struct DocumentResult {
     bool success = false;
@@ -29,8 +33,15 @@ DocumentResult loadTextFileEx(TextBuffer &buffer, const std::string &path);
 DocumentResult saveDocumentEx(const TextBuffer &buffer,
                               const DocumentSettings &settings,
                               const std::string &path);
+// Images are only carried by imported .docx/.odt files; when images is
+// given it is replaced with the file's pictures (emptied for other formats)
 DocumentResult loadDocumentEx(TextBuffer &buffer, DocumentSettings &settings,
-                              const std::string &path);
+                              const std::string &path, ImageCollection *images = nullptr);
+
+// Same format as saveDocumentEx, from a copy of the text (e.g. a snapshot
+// taken on the UI thread and written by BackgroundSaver)
+DocumentResult saveDocumentSnapshot(std::string_view text, const DocumentSettings &settings,
+                                    const std::string &path);
 
 // Type alias for table storage (line number -> table)
 using TableList = std::vector<std::pair<std::size_t, Table>>;
@@ -43,6 +54,15 @@ DocumentResult saveDocumentWithTables(const TextBuffer &buffer,
 DocumentResult loadDocumentWithTables(TextBuffer &buffer, 
                                       DocumentSettings &settings,
                                       TableList &tables,
-                                      const std::string &path);
+                                      const std::string &path,
+                                      ImageCollection *images = nullptr);
+
+// Saving to a path ending in .wpdb writes the binary container (see
+// binary_document.h), and every loader recognises it by its header. For a
+// .wpdb opened with BinaryDocumentReader the pieces can also be read one
+// at a time, e.g. settings and the visible lines before anything else.
+DocumentResult loadBinaryDocumentSettings(const BinaryDocumentReader &reader,
+                                          DocumentSettings &settings);
+DocumentResult loadBinaryDocumentTables(const BinaryDocumentReader &reader, TableList &tables);
 
 #endif  // WORDPROC_EDITOR_DOCUMENT_IO_H
@@ -5,11 +5,11 @@
 std::size_t DrawingCollection::addDrawing(const DocumentDrawing& drawing) {
     DocumentDrawing drw = drawing;
     drw.id = nextId_++;
-    drawings_.push_back(drw);
-    return drw.id;
+    ++generation_;
+    return anchor_index::insert(drawings_, std::move(drw)).id;
 }
 
-DocumentDrawing* DrawingCollection::getDrawing(std::size_t id) {
+DocumentDrawing* DrawingCollection::find(std::size_t id) {
     auto it = std::find_if(drawings_.begin(), drawings_.end(),
                            [id](const DocumentDrawing& drw) { return drw.id == id; });
     return it != drawings_.end() ? &(*it) : nullptr;
@@ -25,57 +25,60 @@ bool DrawingCollection::removeDrawing(std::size_t id) {
     auto it = std::find_if(drawings_.begin(), drawings_.end(),
                            [id](const DocumentDrawing& drw) { return drw.id == id; });
     if (it != drawings_.end()) {
+        geometry_.erase(id);
         drawings_.erase(it);
+        ++generation_;
         return true;
     }
     return false;
 }
 
-std::vector<DocumentDrawing*> DrawingCollection::drawingsAtLine(std::size_t line) {
-    std::vector<DocumentDrawing*> result;
-    for (auto& drw : drawings_) {
-        if (drw.anchorLine == line) {
-            result.push_back(&drw);
-        }
-    }
-    return result;
+std::span<const DocumentDrawing> DrawingCollection::drawingsAtLine(std::size_t line) const {
+    return anchor_index::inLines(drawings_, line, line);
 }
 
-std::vector<const DocumentDrawing*> DrawingCollection::drawingsAtLine(std::size_t line) const {
-    std::vector<const DocumentDrawing*> result;
-    for (const auto& drw : drawings_) {
-        if (drw.anchorLine == line) {
-            result.push_back(&drw);
-        }
-    }
-    return result;
+std::span<const DocumentDrawing> DrawingCollection::drawingsInRange(std::size_t startLine,
+                                                                    std::size_t endLine) const {
+    return anchor_index::inLines(drawings_, startLine, endLine);
 }
 
-std::vector<const DocumentDrawing*> DrawingCollection::drawingsInRange(
-    std::size_t startLine, std::size_t endLine) const {
-    std::vector<const DocumentDrawing*> result;
-    for (const auto& drw : drawings_) {
-        if (drw.anchorLine >= startLine && drw.anchorLine <= endLine) {
-            result.push_back(&drw);
-        }
-    }
-    return result;
+void DrawingCollection::shiftAnchorsFrom(std::size_t line, std::ptrdiff_t linesDelta) {
+    anchor_index::shiftAnchors(drawings_, line, linesDelta);
+    ++generation_;
 }
 
-void DrawingCollection::shiftAnchorsFrom(std::size_t line, std::ptrdiff_t linesDelta) {
-    for (auto& drw : drawings_) {
-        if (drw.anchorLine >= line) {
-            if (linesDelta < 0 && static_cast<std::size_t>(-linesDelta) > drw.anchorLine) {
-                drw.anchorLine = 0;
-            } else {
-                drw.anchorLine = static_cast<std::size_t>(
-                    static_cast<std::ptrdiff_t>(drw.anchorLine) + linesDelta);
-            }
-        }
+const AnchorBounds& DrawingCollection::bounds(float lineHeight, float zoom) const {
+    if (bounds_.isCurrent(generation_, lineHeight, zoom)) return bounds_;
+    bounds_.reset(generation_, lineHeight, zoom);
+    for (std::size_t i = 0; i < drawings_.size(); ++i) {
+        // Everything that is drawn: points, rotation, stroke and heads
+        drawing_geometry::Extent extent = drawing_geometry::extent(drawings_[i]);
+        float lineTop = static_cast<float>(drawings_[i].anchorLine) * lineHeight;
+        bounds_.add({extent.left * zoom, lineTop + extent.top * zoom, extent.right * zoom,
+                     lineTop + extent.bottom * zoom, i, drawings_[i].id});
     }
+    bounds_.finish();
+    return bounds_;
+}
+
+void DrawingCollection::drawingsOverlapping(float top, float bottom, float lineHeight, float zoom,
+                                            std::vector<std::size_t>& out) const {
+    bounds(lineHeight, zoom).overlapping(top, bottom, out);
+}
+
+const DocumentDrawing* DrawingCollection::drawingAt(float x, float y, float lineHeight,
+                                                    float zoom) const {
+    std::size_t index = bounds(lineHeight, zoom).hit(x, y);
+    return index == AnchorBounds::NONE ? nullptr : &drawings_[index];
+}
+
+const drawing_geometry::Mesh& DrawingCollection::geometry(std::size_t index, float zoom) const {
+    return geometry_.mesh(drawings_[index], zoom, generation_);
 }
 
 void DrawingCollection::clear() {
     drawings_.clear();
+    geometry_.clear();
+    ++generation_;
     nextId_ = 1;
 }
@@ -1,9 +1,14 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string>
 #include <vector>
 
+#include "anchor_index.h"
+#include "drawing_geometry.h"
+
 // Shape types for document drawings
 enum class ShapeType {
     Line,         // Simple line segment
@@ -183,7 +188,8 @@ struct DocumentDrawing {
     }
 };
 
-// Drawing collection in a document
+// Drawing collection in a document, kept sorted by anchor line
+// (anchor_index.h)
 class DrawingCollection {
 public:
     DrawingCollection() = default;
@@ -191,23 +197,51 @@ public:
     // Add a drawing at the specified anchor position
     std::size_t addDrawing(const DocumentDrawing& drawing);
     
-    // Get drawing by ID
-    DocumentDrawing* getDrawing(std::size_t id);
+    // Get drawing by ID (change it with editDrawing)
     const DocumentDrawing* getDrawing(std::size_t id) const;
+
+    // Change drawing id in place: edit(DocumentDrawing&) runs on it, then
+    // the layout index is invalidated and its mesh is checked on next use.
+    // False if there is no such drawing. Move anchors with
+    // shiftAnchorsFrom, not through edit.
+    template <typename Edit>
+    bool editDrawing(std::size_t id, Edit&& edit) {
+        DocumentDrawing* drawing = find(id);
+        if (!drawing) return false;
+        edit(*drawing);
+        ++generation_;
+        return true;
+    }
     
     // Remove drawing by ID
     bool removeDrawing(std::size_t id);
     
-    // Get all drawings
+    // Get all drawings, in anchor line order (drawing order is the order
+    // they were added; see anchor_index.h)
     const std::vector<DocumentDrawing>& drawings() const { return drawings_; }
-    std::vector<DocumentDrawing>& drawings() { return drawings_; }
     
     // Get drawings anchored at a specific line
-    std::vector<DocumentDrawing*> drawingsAtLine(std::size_t line);
-    std::vector<const DocumentDrawing*> drawingsAtLine(std::size_t line) const;
+    std::span<const DocumentDrawing> drawingsAtLine(std::size_t line) const;
     
-    // Get drawings in a line range
-    std::vector<const DocumentDrawing*> drawingsInRange(std::size_t startLine, std::size_t endLine) const;
+    // Get drawings anchored on lines startLine..endLine
+    std::span<const DocumentDrawing> drawingsInRange(std::size_t startLine, std::size_t endLine) const;
+    
+    // Drawings whose drawn extent (drawing_geometry::extent: points,
+    // rotation, stroke and arrowheads) overlaps rows [top, bottom), as indices into
+    // drawings() in drawing order. Coordinates are pixels from the text
+    // area's top left at line 0: a drawing's x/y are relative to its
+    // anchor line's top, and x, y and size are scaled by zoom. out is
+    // cleared first.
+    void drawingsOverlapping(float top, float bottom, float lineHeight, float zoom,
+                             std::vector<std::size_t>& out) const;
+    // Topmost drawing whose extent contains (x, y), same coordinates; null if none
+    const DocumentDrawing* drawingAt(float x, float y, float lineHeight, float zoom) const;
+    
+    // Triangles of drawings()[index] for drawing at zoom (drawing_geometry.h).
+    // Cached: only tessellated again after the drawing is edited or zoom
+    // moves to another bucket.
+    const drawing_geometry::Mesh& geometry(std::size_t index, float zoom) const;
+    const DrawingGeometryCache& geometryCache() const { return geometry_; }
     
     // Update anchor positions after text edits
     void shiftAnchorsFrom(std::size_t line, std::ptrdiff_t linesDelta);
@@ -220,6 +254,12 @@ public:
     bool isEmpty() const { return drawings_.empty(); }
     
 private:
+    DocumentDrawing* find(std::size_t id);
+    const AnchorBounds& bounds(float lineHeight, float zoom) const;
+
     std::vector<DocumentDrawing> drawings_;
     std::size_t nextId_ = 1;
+    std::uint64_t generation_ = 0;  // Bumped whenever drawings_ changes
+    mutable AnchorBounds bounds_;
+    mutable DrawingGeometryCache geometry_;
 };
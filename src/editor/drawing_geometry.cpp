@@ -0,0 +1,501 @@
+#include "drawing_geometry.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numbers>
+#include <span>
+
+#include "drawing.h"
+
+namespace drawing_geometry {
+
+namespace {
+
+constexpr float TOLERANCE = 0.25f;  // Largest chord error, in screen pixels
+constexpr float MITER_LIMIT = 4.0f;  // Longest miter, in half stroke widths
+constexpr int MIN_CIRCLE_SEGMENTS = 8;
+constexpr int MAX_CIRCLE_SEGMENTS = 256;
+constexpr float PI = std::numbers::pi_v<float>;
+
+Vertex operator+(Vertex a, Vertex b) { return {a.x + b.x, a.y + b.y}; }
+Vertex operator-(Vertex a, Vertex b) { return {a.x - b.x, a.y - b.y}; }
+Vertex operator*(Vertex a, float s) { return {a.x * s, a.y * s}; }
+bool operator==(Vertex a, Vertex b) { return a.x == b.x && a.y == b.y; }
+float dot(Vertex a, Vertex b) { return a.x * b.x + a.y * b.y; }
+float cross(Vertex a, Vertex b) { return a.x * b.y - a.y * b.x; }
+float length(Vertex a) { return std::sqrt(dot(a, a)); }
+Vertex perpendicular(Vertex a) { return {-a.y, a.x}; }
+
+Vertex unit(Vertex a) {
+    float len = length(a);
+    return len > 0.0f ? a * (1.0f / len) : Vertex{};
+}
+
+float bucketZoom(int bucket) { return std::exp2(static_cast<float>(bucket) * 0.5f); }
+
+// Segments for a whole circle of this radius (drawing units) at zoom
+int circleSegments(float radius, float zoom) {
+    float screenRadius = radius * zoom;
+    if (screenRadius <= TOLERANCE) return MIN_CIRCLE_SEGMENTS;
+    float step = 2.0f * std::acos(1.0f - TOLERANCE / screenRadius);
+    int segments = static_cast<int>(std::ceil(2.0f * PI / step));
+    return std::clamp(segments, MIN_CIRCLE_SEGMENTS, MAX_CIRCLE_SEGMENTS);
+}
+
+// Append a triangle, reordered to wind counter-clockwise on screen;
+// degenerate ones are dropped
+void triangle(std::vector<Vertex>& out, Vertex a, Vertex b, Vertex c) {
+    float area = cross(b - a, c - a);
+    if (area == 0.0f) return;
+    if (area > 0.0f) std::swap(b, c);
+    out.push_back(a);
+    out.push_back(b);
+    out.push_back(c);
+}
+
+void pushDistinct(std::vector<Vertex>& path, Vertex v) {
+    if (path.empty() || !(path.back() == v)) path.push_back(v);
+}
+
+// Points from angle start to start + sweep on an ellipse (y down, so
+// positive angles turn clockwise on screen), both ends included
+void appendArc(std::vector<Vertex>& path, Vertex center, float rx, float ry, float start,
+               float sweep, int segments) {
+    for (int i = 0; i <= segments; ++i) {
+        float angle = start + sweep * static_cast<float>(i) / static_cast<float>(segments);
+        pushDistinct(path, {center.x + rx * std::cos(angle), center.y + ry * std::sin(angle)});
+    }
+}
+
+// Outline of a shape, without repeated points; closed shapes do not repeat
+// their first point at the end
+void outline(const DocumentDrawing& drawing, float zoom, std::vector<Vertex>& path) {
+    float x = drawing.x;
+    float y = drawing.y;
+    float w = drawing.width;
+    float h = drawing.height;
+    switch (drawing.shapeType) {
+        case ShapeType::Line:
+        case ShapeType::Arrow:
+            pushDistinct(path, {x, y});
+            pushDistinct(path, {x + w, y + h});
+            break;
+        case ShapeType::Rectangle:
+            pushDistinct(path, {x, y});
+            pushDistinct(path, {x + w, y});
+            pushDistinct(path, {x + w, y + h});
+            pushDistinct(path, {x, y + h});
+            break;
+        case ShapeType::Triangle:
+            pushDistinct(path, {x + w / 2.0f, y});
+            pushDistinct(path, {x + w, y + h});
+            pushDistinct(path, {x, y + h});
+            break;
+        case ShapeType::Ellipse: {
+            float rx = std::abs(w) / 2.0f;
+            float ry = std::abs(h) / 2.0f;
+            int segments = circleSegments(std::max(rx, ry), zoom);
+            float step = 2.0f * PI / static_cast<float>(segments);
+            Vertex center{x + w / 2.0f, y + h / 2.0f};
+            for (int i = 0; i < segments; ++i) {
+                float angle = step * static_cast<float>(i);
+                pushDistinct(path, {center.x + rx * std::cos(angle),
+                                    center.y + ry * std::sin(angle)});
+            }
+            break;
+        }
+        case ShapeType::RoundedRect: {
+            float left = std::min(x, x + w);
+            float top = std::min(y, y + h);
+            float right = std::max(x, x + w);
+            float bottom = std::max(y, y + h);
+            float r = std::min({std::max(drawing.cornerRadius, 0.0f), (right - left) / 2.0f,
+                                (bottom - top) / 2.0f});
+            int segments = std::max(2, circleSegments(r, zoom) / 4);
+            appendArc(path, {right - r, top + r}, r, r, -PI / 2.0f, PI / 2.0f, segments);
+            appendArc(path, {right - r, bottom - r}, r, r, 0.0f, PI / 2.0f, segments);
+            appendArc(path, {left + r, bottom - r}, r, r, PI / 2.0f, PI / 2.0f, segments);
+            appendArc(path, {left + r, top + r}, r, r, PI, PI / 2.0f, segments);
+            break;
+        }
+        case ShapeType::FreeformLine:
+            for (const DrawingPoint& point : drawing.points) pushDistinct(path, {point.x, point.y});
+            break;
+    }
+    bool closed = drawing.shapeType != ShapeType::Line && drawing.shapeType != ShapeType::Arrow &&
+                  drawing.shapeType != ShapeType::FreeformLine;
+    if (closed && path.size() > 1 && path.front() == path.back()) path.pop_back();
+}
+
+// Stroke a path of distinct points as a strip of quads with mitered joins
+// (butt ends when open). offsets is scratch space.
+void strokePath(std::span<const Vertex> path, bool closed, float halfWidth,
+                std::vector<Vertex>& out, std::vector<Vertex>& offsets) {
+    std::size_t n = path.size();
+    if (n < 2) return;
+    if (n < 3) closed = false;
+    auto normal = [&](std::size_t i) {
+        return perpendicular(unit(path[(i + 1) % n] - path[i]));
+    };
+    offsets.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        bool hasPrev = closed || i > 0;
+        bool hasNext = closed || i + 1 < n;
+        if (!hasPrev) {
+            offsets[i] = normal(0) * halfWidth;
+        } else if (!hasNext) {
+            offsets[i] = normal(n - 2) * halfWidth;
+        } else {
+            Vertex before = normal((i + n - 1) % n);
+            Vertex after = normal(i);
+            Vertex miter = before + after;
+            float len = length(miter);
+            if (len < 1e-4f) {  // Doubles straight back
+                offsets[i] = after * halfWidth;
+                continue;
+            }
+            miter = miter * (1.0f / len);
+            float scale = halfWidth / std::max(dot(miter, after), 1.0f / MITER_LIMIT);
+            offsets[i] = miter * scale;
+        }
+    }
+    std::size_t segments = closed ? n : n - 1;
+    for (std::size_t i = 0; i < segments; ++i) {
+        std::size_t j = (i + 1) % n;
+        Vertex leftA = path[i] + offsets[i];
+        Vertex rightA = path[i] - offsets[i];
+        Vertex leftB = path[j] + offsets[j];
+        Vertex rightB = path[j] - offsets[j];
+        triangle(out, leftA, rightA, leftB);
+        triangle(out, rightA, rightB, leftB);
+    }
+}
+
+// On/off lengths of a line style, in stroke widths; empty for solid
+std::span<const float> dashPattern(LineStyle style) {
+    static constexpr float DASHED[] = {4.0f, 2.0f};
+    static constexpr float DOTTED[] = {1.0f, 1.0f};
+    static constexpr float DASH_DOT[] = {4.0f, 1.5f, 1.0f, 1.5f};
+    switch (style) {
+        case LineStyle::Dashed: return DASHED;
+        case LineStyle::Dotted: return DOTTED;
+        case LineStyle::DashDot: return DASH_DOT;
+        default: return {};
+    }
+}
+
+// Stroke a path in dashes: each "on" stretch of the pattern, corners
+// included, is stroked as its own open path
+void dashPath(std::span<const Vertex> path, bool closed, std::span<const float> pattern,
+              float unitLength, float halfWidth, std::vector<Vertex>& out,
+              std::vector<Vertex>& piece, std::vector<Vertex>& offsets) {
+    if (path.size() < 2) return;
+    std::size_t phase = 0;
+    float left = pattern[0] * unitLength;
+    bool on = true;
+    piece.clear();
+    piece.push_back(path[0]);
+    std::size_t segments = closed && path.size() > 2 ? path.size() : path.size() - 1;
+    for (std::size_t i = 0; i < segments; ++i) {
+        Vertex a = path[i];
+        Vertex b = path[(i + 1) % path.size()];
+        float len = length(b - a);
+        float pos = 0.0f;
+        while (len - pos > left) {
+            pos += left;
+            Vertex at = a + (b - a) * (pos / len);
+            if (on) {
+                pushDistinct(piece, at);
+                strokePath(piece, false, halfWidth, out, offsets);
+            }
+            piece.clear();
+            piece.push_back(at);
+            on = !on;
+            phase = (phase + 1) % pattern.size();
+            left = pattern[phase] * unitLength;
+        }
+        left -= len - pos;
+        if (on) pushDistinct(piece, b);
+    }
+    if (on) strokePath(piece, false, halfWidth, out, offsets);
+}
+
+// Fill a convex outline as a fan
+void fillConvex(std::span<const Vertex> path, std::vector<Vertex>& out) {
+    for (std::size_t i = 1; i + 1 < path.size(); ++i) triangle(out, path[0], path[i], path[i + 1]);
+}
+
+// Fill a simple polygon of any shape by ear clipping. Freehand outlines
+// may cross themselves; when no ear is left the next corner is clipped
+// anyway, so the fill degrades instead of stopping.
+void fillPolygon(std::span<const Vertex> polygon, std::vector<Vertex>& out,
+                 std::vector<std::size_t>& ring) {
+    std::size_t n = polygon.size();
+    if (n > 1 && polygon.front() == polygon.back()) --n;  // Drawn back to its start
+    if (n < 3) return;
+    double area = 0.0;
+    for (std::size_t i = 0; i < n; ++i) area += cross(polygon[i], polygon[(i + 1) % n]);
+    if (area == 0.0) return;
+    float orientation = area > 0.0 ? 1.0f : -1.0f;
+
+    ring.resize(n);
+    for (std::size_t i = 0; i < n; ++i) ring[i] = i;
+    auto isEar = [&](std::size_t at) {
+        std::size_t m = ring.size();
+        Vertex a = polygon[ring[(at + m - 1) % m]];
+        Vertex b = polygon[ring[at]];
+        Vertex c = polygon[ring[(at + 1) % m]];
+        if (cross(b - a, c - b) * orientation < 0.0f) return false;  // Reflex corner
+        for (std::size_t k = 0; k < m; ++k) {
+            Vertex p = polygon[ring[k]];
+            if (p == a || p == b || p == c) continue;
+            if (cross(b - a, p - a) * orientation > 0.0f &&
+                cross(c - b, p - b) * orientation > 0.0f &&
+                cross(a - c, p - c) * orientation > 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    };
+    std::size_t at = 0;
+    std::size_t misses = 0;
+    while (ring.size() > 3) {
+        std::size_t m = ring.size();
+        if (misses < m && !isEar(at)) {
+            at = (at + 1) % m;
+            ++misses;
+            continue;
+        }
+        triangle(out, polygon[ring[(at + m - 1) % m]], polygon[ring[at]],
+                 polygon[ring[(at + 1) % m]]);
+        ring.erase(ring.begin() + static_cast<std::ptrdiff_t>(at));
+        at %= ring.size();
+        misses = 0;
+    }
+    triangle(out, polygon[ring[0]], polygon[ring[1]], polygon[ring[2]]);
+}
+
+// Length of an arrowhead from tip to base; it is half as wide
+float arrowLength(float strokeWidth) { return std::max(8.0f, strokeWidth * 4.0f); }
+
+// Draw an arrowhead whose tip is at tip, pointing along direction (unit).
+// Returns how far the line should stop short of the tip.
+float arrowhead(ArrowStyle style, Vertex tip, Vertex direction, float strokeWidth, float zoom,
+                std::vector<Vertex>& out, std::vector<Vertex>& offsets) {
+    float len = arrowLength(strokeWidth);
+    float halfWidth = len / 2.0f;
+    Vertex across = perpendicular(direction) * halfWidth;
+    Vertex base = tip - direction * len;
+    switch (style) {
+        case ArrowStyle::Standard:
+            triangle(out, tip, base + across, base - across);
+            return len;
+        case ArrowStyle::Open: {
+            Vertex wings[] = {base + across, tip, base - across};
+            strokePath(wings, false, strokeWidth / 2.0f, out, offsets);
+            return 0.0f;
+        }
+        case ArrowStyle::Diamond: {
+            Vertex middle = tip - direction * (len / 2.0f);
+            triangle(out, tip, middle + across, base);
+            triangle(out, tip, base, middle - across);
+            return len;
+        }
+        case ArrowStyle::Circle: {
+            Vertex center = tip - direction * halfWidth;
+            int segments = circleSegments(halfWidth, zoom);
+            float step = 2.0f * PI / static_cast<float>(segments);
+            for (int i = 0; i < segments; ++i) {
+                float a0 = step * static_cast<float>(i);
+                float a1 = step * static_cast<float>(i + 1);
+                triangle(out, center,
+                         center + Vertex{std::cos(a0), std::sin(a0)} * halfWidth,
+                         center + Vertex{std::cos(a1), std::sin(a1)} * halfWidth);
+            }
+            return halfWidth;
+        }
+        default:
+            return 0.0f;
+    }
+}
+
+void rotate(std::vector<Vertex>& vertices, Vertex center, float degrees) {
+    float radians = degrees * PI / 180.0f;
+    float c = std::cos(radians);
+    float s = std::sin(radians);
+    for (Vertex& v : vertices) {
+        Vertex d = v - center;
+        v = {center.x + d.x * c - d.y * s, center.y + d.x * s + d.y * c};
+    }
+}
+
+// FNV-1a over the bytes of each value
+class KeyHasher {
+   public:
+    void add(std::uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            hash_ ^= (value >> (i * 8)) & 0xff;
+            hash_ *= 1099511628211ull;
+        }
+    }
+    void add(float value) { add(static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(value))); }
+    std::uint64_t hash() const { return hash_; }
+
+   private:
+    std::uint64_t hash_ = 14695981039346656037ull;
+};
+
+}  // namespace
+
+int zoomBucket(float zoom) {
+    if (!(zoom > 0.0f)) return 0;
+    return static_cast<int>(std::ceil(std::log2(zoom) * 2.0f));
+}
+
+std::uint64_t shapeKey(const DocumentDrawing& drawing) {
+    KeyHasher key;
+    key.add(static_cast<std::uint64_t>(drawing.shapeType));
+    key.add(drawing.x);
+    key.add(drawing.y);
+    key.add(drawing.width);
+    key.add(drawing.height);
+    key.add(drawing.strokeWidth);
+    key.add(static_cast<std::uint64_t>(drawing.lineStyle));
+    key.add(static_cast<std::uint64_t>(drawing.filled));
+    key.add(static_cast<std::uint64_t>(drawing.startArrow));
+    key.add(static_cast<std::uint64_t>(drawing.endArrow));
+    key.add(drawing.cornerRadius);
+    key.add(drawing.rotation);
+    key.add(static_cast<std::uint64_t>(drawing.points.size()));
+    for (const DrawingPoint& point : drawing.points) {
+        key.add(point.x);
+        key.add(point.y);
+    }
+    return key.hash();
+}
+
+void tessellate(const DocumentDrawing& drawing, float zoom, Mesh& out) {
+    out.clear();
+    float detailZoom = bucketZoom(zoomBucket(zoom));
+    std::vector<Vertex> path;
+    std::vector<Vertex> piece;
+    std::vector<Vertex> offsets;
+    outline(drawing, detailZoom, path);
+
+    bool open = drawing.shapeType == ShapeType::Line || drawing.shapeType == ShapeType::Arrow ||
+                drawing.shapeType == ShapeType::FreeformLine;
+    if (drawing.filled) {
+        if (drawing.shapeType == ShapeType::FreeformLine) {
+            std::vector<std::size_t> ring;
+            fillPolygon(path, out.fill, ring);
+        } else if (!open) {
+            fillConvex(path, out.fill);
+        }
+    }
+
+    if (drawing.strokeWidth > 0.0f && path.size() >= 2) {
+        float halfWidth = drawing.strokeWidth / 2.0f;
+        std::span<const Vertex> line = path;
+        Vertex trimmed[2];
+        if (drawing.shapeType == ShapeType::Arrow) {
+            // Heads are solid whatever the line style; the line stops at
+            // their base so it does not show through
+            Vertex start = path.front();
+            Vertex end = path.back();
+            Vertex direction = unit(end - start);
+            float total = length(end - start);
+            float cutEnd = arrowhead(drawing.endArrow, end, direction, drawing.strokeWidth,
+                                     detailZoom, out.stroke, offsets);
+            float cutStart = arrowhead(drawing.startArrow, start, direction * -1.0f,
+                                       drawing.strokeWidth, detailZoom, out.stroke, offsets);
+            if (cutStart + cutEnd >= total) {
+                line = {};
+            } else {
+                trimmed[0] = start + direction * cutStart;
+                trimmed[1] = end - direction * cutEnd;
+                line = trimmed;
+            }
+        }
+        std::span<const float> pattern = dashPattern(drawing.lineStyle);
+        if (pattern.empty()) {
+            strokePath(line, !open, halfWidth, out.stroke, offsets);
+        } else {
+            dashPath(line, !open, pattern, std::max(drawing.strokeWidth, 1.0f), halfWidth,
+                     out.stroke, piece, offsets);
+        }
+    }
+
+    if (drawing.rotation != 0.0f) {
+        Vertex center{drawing.x + drawing.width / 2.0f, drawing.y + drawing.height / 2.0f};
+        rotate(out.fill, center, drawing.rotation);
+        rotate(out.stroke, center, drawing.rotation);
+    }
+}
+
+Extent extent(const DocumentDrawing& drawing) {
+    float x = drawing.x;
+    float y = drawing.y;
+    float w = drawing.width;
+    float h = drawing.height;
+    Extent box{std::min(x, x + w), std::min(y, y + h), std::max(x, x + w), std::max(y, y + h)};
+    if (drawing.shapeType == ShapeType::FreeformLine && !drawing.points.empty()) {
+        // The outline is the points alone, wherever they are
+        box = {drawing.points[0].x, drawing.points[0].y, drawing.points[0].x,
+               drawing.points[0].y};
+        for (const DrawingPoint& point : drawing.points) {
+            box.left = std::min(box.left, point.x);
+            box.top = std::min(box.top, point.y);
+            box.right = std::max(box.right, point.x);
+            box.bottom = std::max(box.bottom, point.y);
+        }
+    }
+
+    // A miter reaches at most MITER_LIMIT half widths from its corner; a
+    // head reaches its length back from the tip (past the other end of a
+    // short line) and is stroked when open
+    float stroke = std::max(drawing.strokeWidth, 0.0f);
+    float margin = stroke / 2.0f * MITER_LIMIT;
+    if (drawing.shapeType == ShapeType::Arrow &&
+        (drawing.startArrow != ArrowStyle::None || drawing.endArrow != ArrowStyle::None)) {
+        margin += arrowLength(stroke);
+    }
+    box = {box.left - margin, box.top - margin, box.right + margin, box.bottom + margin};
+
+    if (drawing.rotation != 0.0f) {
+        std::vector<Vertex> corners{{box.left, box.top},
+                                    {box.right, box.top},
+                                    {box.right, box.bottom},
+                                    {box.left, box.bottom}};
+        rotate(corners, {x + w / 2.0f, y + h / 2.0f}, drawing.rotation);
+        box = {corners[0].x, corners[0].y, corners[0].x, corners[0].y};
+        for (const Vertex& corner : corners) {
+            box.left = std::min(box.left, corner.x);
+            box.top = std::min(box.top, corner.y);
+            box.right = std::max(box.right, corner.x);
+            box.bottom = std::max(box.bottom, corner.y);
+        }
+    }
+    return box;
+}
+
+}  // namespace drawing_geometry
+
+const drawing_geometry::Mesh& DrawingGeometryCache::mesh(const DocumentDrawing& drawing,
+                                                         float zoom, std::uint64_t generation) {
+    int bucket = drawing_geometry::zoomBucket(zoom);
+    auto [it, added] = entries_.try_emplace(drawing.id);
+    Entry& entry = it->second;
+    if (!added && entry.generation == generation && entry.bucket == bucket) return entry.mesh;
+
+    // Something in the collection changed; rebuild only if it was this one
+    std::uint64_t key = drawing_geometry::shapeKey(drawing);
+    if (added || entry.key != key || entry.bucket != bucket) {
+        drawing_geometry::tessellate(drawing, zoom, entry.mesh);
+        entry.key = key;
+        entry.bucket = bucket;
+        ++builds_;
+    }
+    entry.generation = generation;
+    return entry.mesh;
+}
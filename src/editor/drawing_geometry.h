@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct DocumentDrawing;
+
+// Triangles for drawing a DocumentDrawing: the fill, and the stroke with
+// its dashes, joins and arrowheads, all in the drawing's own coordinates
+// (the units of its x, y, size and points). The renderer scales them by
+// zoom and offsets them to the anchor line, so scrolling, moving anchors
+// and zooming within a bucket reuse them.
+namespace drawing_geometry {
+
+struct Vertex {
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+// Three vertices per triangle, wound counter-clockwise on screen (y down),
+// as raylib's DrawTriangle wants
+struct Mesh {
+    std::vector<Vertex> fill;    // In fillColor
+    std::vector<Vertex> stroke;  // In strokeColor, arrowheads included
+
+    void clear() {
+        fill.clear();
+        stroke.clear();
+    }
+};
+
+// Zooms are grouped in half-octave buckets. Curves are tessellated for the
+// largest zoom of a bucket, so they stay within a quarter pixel of the true
+// curve for every zoom in it.
+int zoomBucket(float zoom);
+
+// Hash of everything that shapes the geometry (not colors or anchor)
+std::uint64_t shapeKey(const DocumentDrawing& drawing);
+
+// Replace out with the triangles of drawing as drawn at zoom
+void tessellate(const DocumentDrawing& drawing, float zoom, Mesh& out);
+
+// Box around every triangle tessellate can produce for drawing at any zoom
+// (freehand points, rotation, stroke miters and arrowheads included), in
+// the same coordinates. For culling and hit testing without a mesh.
+struct Extent {
+    float left = 0.0f;
+    float top = 0.0f;
+    float right = 0.0f;
+    float bottom = 0.0f;
+};
+Extent extent(const DocumentDrawing& drawing);
+
+}  // namespace drawing_geometry
+
+// Meshes of a collection's drawings by id, so a frame only tessellates the
+// drawings that were edited or zoomed into another bucket since the last.
+//
+// The owning collection passes its generation (bumped on every mutation).
+// While it is unchanged an entry is used as is; after a change the entry's
+// shapeKey is compared, and only a different one is tessellated again.
+class DrawingGeometryCache {
+   public:
+    const drawing_geometry::Mesh& mesh(const DocumentDrawing& drawing, float zoom,
+                                       std::uint64_t generation);
+
+    void erase(std::size_t id) { entries_.erase(id); }
+    void clear() { entries_.clear(); }
+    std::size_t size() const { return entries_.size(); }
+
+    // Number of times mesh() had to tessellate
+    std::size_t builds() const { return builds_; }
+
+   private:
+    struct Entry {
+        std::uint64_t key = 0;
+        std::uint64_t generation = 0;
+        int bucket = 0;
+        drawing_geometry::Mesh mesh;
+    };
+
+    std::unordered_map<std::size_t, Entry> entries_;
+    std::size_t builds_ = 0;
+};
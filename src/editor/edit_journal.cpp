@@ -0,0 +1,751 @@
+#include "edit_journal.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+#include "document_io.h"
+#include "mapped_file.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define WORDPROC_HAS_FSYNC 1
+#endif
+
+namespace {
+
+constexpr char kMagic[4] = {'W', 'P', 'J', '1'};
+
+// Record types
+constexpr std::uint8_t kInsert = 'I';
+constexpr std::uint8_t kErase = 'E';
+constexpr std::uint8_t kReset = 'R';
+constexpr std::uint8_t kStyle = 'S';
+constexpr std::uint8_t kFormat = 'P';       // One row's paragraph format
+constexpr std::uint8_t kAnchors = 'A';      // Every hyperlink and bookmark
+constexpr std::uint8_t kBaseFormats = 'F';  // All non-default rows, at rebase
+constexpr std::uint8_t kBaseAnchors = 'a';  // kAnchors, at rebase
+
+void putVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool getVarint(std::string_view in, std::size_t& pos, std::uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+        auto byte = static_cast<unsigned char>(in[pos++]);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+void putFixed(std::string& out, std::uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+std::uint64_t getFixed(std::string_view in, std::size_t pos, int bytes) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[pos + i])) << (8 * i);
+    }
+    return value;
+}
+
+// Signed values (indents may be negative), zigzag coded
+void putInt(std::string& out, int value) {
+    auto wide = static_cast<std::int64_t>(value);
+    putVarint(out, static_cast<std::uint64_t>((wide << 1) ^ (wide >> 63)));
+}
+
+bool getInt(std::string_view in, std::size_t& pos, int& value) {
+    std::uint64_t raw = 0;
+    if (!getVarint(in, pos, raw)) return false;
+    value = static_cast<int>(static_cast<std::int64_t>(raw >> 1) ^ -static_cast<std::int64_t>(raw & 1));
+    return true;
+}
+
+void putString(std::string& out, std::string_view text) {
+    putVarint(out, text.size());
+    out += text;
+}
+
+bool getString(std::string_view in, std::size_t& pos, std::string& text) {
+    std::uint64_t length = 0;
+    if (!getVarint(in, pos, length) || length > in.size() - pos) return false;
+    text.assign(in.substr(pos, length));
+    pos += length;
+    return true;
+}
+
+std::uint32_t recordChecksum(std::uint8_t type, std::string_view payload) {
+    char typeByte = static_cast<char>(type);
+    std::uint64_t hash = EditJournal::hashText(std::string_view(&typeByte, 1));
+    return static_cast<std::uint32_t>(EditJournal::hashText(payload, hash));
+}
+
+std::string encodeStyle(const TextStyle& style) {
+    std::string out;
+    out.push_back(static_cast<char>((style.bold ? 1 : 0) | (style.italic ? 2 : 0) |
+                                    (style.underline ? 4 : 0) | (style.strikethrough ? 8 : 0) |
+                                    (style.superscript ? 16 : 0) | (style.subscript ? 32 : 0)));
+    putVarint(out, static_cast<std::uint64_t>(std::max(0, style.fontSize)));
+    putVarint(out, style.font.size());
+    out += style.font;
+    for (const TextColor& color : {style.textColor, style.highlightColor}) {
+        out.push_back(static_cast<char>(color.r));
+        out.push_back(static_cast<char>(color.g));
+        out.push_back(static_cast<char>(color.b));
+        out.push_back(static_cast<char>(color.a));
+    }
+    return out;
+}
+
+bool decodeStyle(std::string_view in, TextStyle& style) {
+    if (in.empty()) return false;
+    auto flags = static_cast<unsigned char>(in[0]);
+    std::size_t pos = 1;
+    std::uint64_t fontSize = 0;
+    std::uint64_t fontLen = 0;
+    if (!getVarint(in, pos, fontSize) || !getVarint(in, pos, fontLen)) return false;
+    if (fontLen > in.size() - pos || in.size() - pos - fontLen != 8) return false;
+
+    style.bold = flags & 1;
+    style.italic = flags & 2;
+    style.underline = flags & 4;
+    style.strikethrough = flags & 8;
+    style.superscript = flags & 16;
+    style.subscript = flags & 32;
+    style.fontSize = static_cast<int>(fontSize);
+    style.font.assign(in.substr(pos, fontLen));
+    pos += fontLen;
+    for (TextColor* color : {&style.textColor, &style.highlightColor}) {
+        color->r = static_cast<unsigned char>(in[pos++]);
+        color->g = static_cast<unsigned char>(in[pos++]);
+        color->b = static_cast<unsigned char>(in[pos++]);
+        color->a = static_cast<unsigned char>(in[pos++]);
+    }
+    return true;
+}
+
+void encodeFormat(std::string& out, const ParagraphFormat& format) {
+    out.push_back(static_cast<char>(format.style));
+    out.push_back(static_cast<char>(format.alignment));
+    out.push_back(static_cast<char>(format.listType));
+    out.push_back(static_cast<char>((format.hasPageBreakBefore ? 1 : 0) |
+                                    (format.hasDropCap ? 2 : 0)));
+    std::uint32_t spacing = 0;
+    std::memcpy(&spacing, &format.lineSpacing, sizeof(spacing));
+    putFixed(out, spacing, 4);
+    for (int value : {format.leftIndent, format.firstLineIndent, format.spaceBefore,
+                      format.spaceAfter, format.listLevel, format.listNumber,
+                      format.dropCapLines}) {
+        putInt(out, value);
+    }
+}
+
+bool decodeFormat(std::string_view in, std::size_t& pos, ParagraphFormat& format) {
+    if (in.size() - pos < 8) return false;
+    auto style = static_cast<unsigned char>(in[pos]);
+    auto alignment = static_cast<unsigned char>(in[pos + 1]);
+    auto listType = static_cast<unsigned char>(in[pos + 2]);
+    auto flags = static_cast<unsigned char>(in[pos + 3]);
+    if (style > static_cast<unsigned char>(ParagraphStyle::Heading6) ||
+        alignment > static_cast<unsigned char>(TextAlignment::Justify) ||
+        listType > static_cast<unsigned char>(ListType::Numbered)) {
+        return false;
+    }
+    format.style = static_cast<ParagraphStyle>(style);
+    format.alignment = static_cast<TextAlignment>(alignment);
+    format.listType = static_cast<ListType>(listType);
+    format.hasPageBreakBefore = flags & 1;
+    format.hasDropCap = flags & 2;
+    auto spacing = static_cast<std::uint32_t>(getFixed(in, pos + 4, 4));
+    std::memcpy(&format.lineSpacing, &spacing, sizeof(spacing));
+    pos += 8;
+    for (int* value : {&format.leftIndent, &format.firstLineIndent, &format.spaceBefore,
+                       &format.spaceAfter, &format.listLevel, &format.listNumber,
+                       &format.dropCapLines}) {
+        if (!getInt(in, pos, *value)) return false;
+    }
+    return true;
+}
+
+std::string encodeAnchors(const std::vector<Hyperlink>& links,
+                          const std::vector<Bookmark>& bookmarks) {
+    std::string out;
+    putVarint(out, links.size());
+    for (const Hyperlink& link : links) {
+        putVarint(out, link.startOffset);
+        putVarint(out, link.endOffset);
+        putString(out, link.url);
+        putString(out, link.tooltip);
+    }
+    putVarint(out, bookmarks.size());
+    for (const Bookmark& bookmark : bookmarks) {
+        putString(out, bookmark.name);
+        putVarint(out, bookmark.offset);
+        putString(out, bookmark.displayName);
+    }
+    return out;
+}
+
+bool decodeAnchors(std::string_view in, std::vector<Hyperlink>& links,
+                   std::vector<Bookmark>& bookmarks) {
+    std::size_t pos = 0;
+    std::uint64_t count = 0;
+    links.clear();
+    bookmarks.clear();
+    if (!getVarint(in, pos, count) || count > in.size()) return false;
+    links.resize(count);
+    for (Hyperlink& link : links) {
+        std::uint64_t start = 0;
+        std::uint64_t end = 0;
+        if (!getVarint(in, pos, start) || !getVarint(in, pos, end) ||
+            !getString(in, pos, link.url) || !getString(in, pos, link.tooltip)) {
+            return false;
+        }
+        link.startOffset = start;
+        link.endOffset = end;
+    }
+    if (!getVarint(in, pos, count) || count > in.size()) return false;
+    bookmarks.resize(count);
+    for (Bookmark& bookmark : bookmarks) {
+        std::uint64_t offset = 0;
+        if (!getString(in, pos, bookmark.name) || !getVarint(in, pos, offset) ||
+            !getString(in, pos, bookmark.displayName)) {
+            return false;
+        }
+        bookmark.offset = offset;
+    }
+    return pos == in.size();
+}
+
+bool sameStyle(const TextStyle& a, const TextStyle& b) {
+    return a.bold == b.bold && a.italic == b.italic && a.underline == b.underline &&
+           a.strikethrough == b.strikethrough && a.superscript == b.superscript &&
+           a.subscript == b.subscript && a.font == b.font && a.fontSize == b.fontSize &&
+           a.textColor == b.textColor && a.highlightColor == b.highlightColor;
+}
+
+struct JournalHeader {
+    std::uint64_t baseHash = 0;
+    std::string basePath;
+    std::size_t recordsStart = 0;
+};
+
+std::string encodeHeader(std::uint64_t baseHash, const std::string& basePath) {
+    std::string out(kMagic, sizeof(kMagic));
+    putFixed(out, baseHash, 8);
+    putVarint(out, basePath.size());
+    out += basePath;
+    return out;
+}
+
+bool parseHeader(std::string_view data, JournalHeader& header) {
+    if (data.size() < sizeof(kMagic) + 8 || std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0) {
+        return false;
+    }
+    header.baseHash = getFixed(data, sizeof(kMagic), 8);
+    std::size_t pos = sizeof(kMagic) + 8;
+    std::uint64_t pathLen = 0;
+    if (!getVarint(data, pos, pathLen) || pathLen > data.size() - pos) return false;
+    header.basePath.assign(data.substr(pos, pathLen));
+    header.recordsStart = pos + pathLen;
+    return true;
+}
+
+// What replay rebuilds. Formats are kept sparsely (few rows are not
+// default), sorted by row.
+struct ReplayState {
+    GapBuffer text;
+    TextStyle style;
+    std::vector<std::pair<std::size_t, ParagraphFormat>> formats;
+    std::vector<Hyperlink> links;
+    std::vector<Bookmark> bookmarks;
+};
+
+// Row holding offset. Only needed when a newline comes or goes while some
+// row has a format, so the count over the text is rare.
+std::size_t rowAt(const GapBuffer& text, std::size_t offset) {
+    std::string_view before = text.beforeGap();
+    std::string_view after = text.afterGap();
+    std::size_t inBefore = std::min(offset, before.size());
+    auto row = static_cast<std::size_t>(std::count(before.begin(), before.begin() + inBefore, '\n'));
+    if (offset > before.size()) {
+        auto inAfter = static_cast<std::ptrdiff_t>(offset - before.size());
+        row += static_cast<std::size_t>(std::count(after.begin(), after.begin() + inAfter, '\n'));
+    }
+    return row;
+}
+
+// Move formatted rows for `lines` newlines inserted (positive) or erased
+// (negative) in row. Like TextBuffer, new rows follow row and erased ones
+// are the rows after it.
+void shiftFormats(ReplayState& state, std::size_t row, std::ptrdiff_t lines) {
+    auto& formats = state.formats;
+    if (lines < 0) {
+        std::size_t lastErased = row + static_cast<std::size_t>(-lines);
+        formats.erase(std::remove_if(formats.begin(), formats.end(),
+                                     [&](const auto& entry) {
+                                         return entry.first > row && entry.first <= lastErased;
+                                     }),
+                      formats.end());
+    }
+    for (auto& entry : formats) {
+        if (entry.first > row) {
+            entry.first = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(entry.first) + lines);
+        }
+    }
+}
+
+void setFormat(ReplayState& state, std::size_t row, const ParagraphFormat& format) {
+    auto& formats = state.formats;
+    auto it = std::lower_bound(formats.begin(), formats.end(), row,
+                               [](const auto& entry, std::size_t r) { return entry.first < r; });
+    bool present = it != formats.end() && it->first == row;
+    if (format.isDefault()) {
+        if (present) formats.erase(it);
+    } else if (present) {
+        it->second = format;
+    } else {
+        formats.insert(it, {row, format});
+    }
+}
+
+// Apply records to state until the end or the first damaged record.
+// Returns the number of edit records applied (restated base formats and
+// anchors are not edits).
+std::size_t replayRecords(std::string_view data, std::size_t pos, ReplayState& state) {
+    GapBuffer& text = state.text;
+    std::size_t applied = 0;
+    while (pos < data.size()) {
+        auto type = static_cast<std::uint8_t>(data[pos]);
+        std::size_t cursor = pos + 1;
+        std::uint64_t length = 0;
+        if (!getVarint(data, cursor, length) || length > data.size() - cursor ||
+            data.size() - cursor - length < 4) {
+            break;  // Torn write at the end of the file
+        }
+        std::string_view payload = data.substr(cursor, length);
+        cursor += length;
+        if (getFixed(data, cursor, 4) != recordChecksum(type, payload)) break;
+        pos = cursor + 4;
+
+        std::size_t at = 0;
+        std::uint64_t offset = 0;
+        std::uint64_t count = 0;
+        switch (type) {
+            case kInsert: {
+                if (!getVarint(payload, at, offset) || offset > text.size()) return applied;
+                std::string_view inserted = payload.substr(at);
+                auto newlines = std::count(inserted.begin(), inserted.end(), '\n');
+                if (newlines > 0 && !state.formats.empty()) {
+                    shiftFormats(state, rowAt(text, offset), newlines);
+                }
+                text.insertString(offset, inserted.data(), inserted.size());
+                break;
+            }
+            case kErase:
+                if (!getVarint(payload, at, offset) || !getVarint(payload, at, count) ||
+                    offset > text.size() || count > text.size() - offset) {
+                    return applied;
+                }
+                if (!state.formats.empty()) {
+                    std::size_t first = rowAt(text, offset);
+                    std::size_t last = rowAt(text, offset + count);
+                    if (last > first) {
+                        shiftFormats(state, first, -static_cast<std::ptrdiff_t>(last - first));
+                    }
+                }
+                text.erase(offset, count);
+                break;
+            case kReset:
+                text.setContent(payload.data(), payload.size());
+                state.formats.clear();  // setText leaves every row default
+                break;
+            case kStyle:
+                if (!decodeStyle(payload, state.style)) return applied;
+                break;
+            case kFormat: {
+                ParagraphFormat format;
+                if (!getVarint(payload, at, offset) || !decodeFormat(payload, at, format)) {
+                    return applied;
+                }
+                setFormat(state, offset, format);
+                break;
+            }
+            case kBaseFormats: {
+                std::vector<std::pair<std::size_t, ParagraphFormat>> formats;
+                if (!getVarint(payload, at, count) || count > payload.size()) return applied;
+                for (std::uint64_t i = 0; i < count; ++i) {
+                    ParagraphFormat format;
+                    if (!getVarint(payload, at, offset) || !decodeFormat(payload, at, format)) {
+                        return applied;
+                    }
+                    formats.emplace_back(offset, format);
+                }
+                state.formats = std::move(formats);
+                continue;
+            }
+            case kAnchors:
+            case kBaseAnchors:
+                if (!decodeAnchors(payload, state.links, state.bookmarks)) return applied;
+                if (type == kBaseAnchors) continue;
+                break;
+            default:
+                return applied;
+        }
+        ++applied;
+    }
+    return applied;
+}
+
+bool loadBase(const std::string& basePath, std::uint64_t baseHash, std::string& text,
+              DocumentSettings& settings) {
+    if (basePath.empty()) {
+        text.clear();
+        return EditJournal::hashText(text) == baseHash;
+    }
+    TextBuffer base;
+    DocumentSettings baseSettings;
+    DocumentResult loaded = loadDocumentEx(base, baseSettings, basePath);
+    if (!loaded.success || EditJournal::hashText(base) != baseHash) return false;
+    text = base.getText();
+    settings = baseSettings;
+    return true;
+}
+
+}  // namespace
+
+// ============================================================================
+// Writing
+// ============================================================================
+
+EditJournal::EditJournal(std::string path) : path_(std::move(path)) {}
+
+EditJournal::~EditJournal() {
+    flush();
+    closeFile();
+}
+
+std::uint64_t EditJournal::hashText(std::string_view text, std::uint64_t hash) {
+    // FNV-1a
+    for (char ch : text) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::uint64_t EditJournal::hashText(const TextBuffer& buffer) {
+    std::uint64_t hash = kHashSeed;
+    buffer.forEachTextChunk([&hash](std::string_view chunk) { hash = hashText(chunk, hash); });
+    return hash;
+}
+
+bool EditJournal::rebase(const TextBuffer& buffer, const std::string& basePath,
+                         bool keepPrevious) {
+    flush();
+    closeFile();
+    pendingKind_ = PendingKind::None;
+    out_.clear();
+
+    std::error_code ec;
+    if (keepPrevious && std::filesystem::exists(path_, ec)) {
+        std::filesystem::rename(path_, previousPath(), ec);
+    } else {
+        std::filesystem::remove(path_, ec);
+        std::filesystem::remove(previousPath(), ec);
+    }
+
+    std::filesystem::path parent = std::filesystem::path(path_).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+    file_ = std::fopen(path_.c_str(), "wb");
+    if (!file_) {
+        error_ = "Could not create journal: " + path_;
+        return false;
+    }
+    out_ = encodeHeader(hashText(buffer), basePath);
+    records_ = 0;
+    bytesWritten_ = 0;
+    lastStyle_ = buffer.textStyle();
+    haveStyle_ = true;
+
+    // The base file keeps neither, so restate them
+    std::string formats;
+    std::size_t formatted = 0;
+    for (std::size_t row = 0; row < buffer.lineCount(); ++row) {
+        ParagraphFormat format = buffer.lineFormat(row);
+        if (format.isDefault()) continue;
+        putVarint(formats, row);
+        encodeFormat(formats, format);
+        ++formatted;
+    }
+    std::string payload;
+    putVarint(payload, formatted);
+    payload += formats;
+    appendRecord(kBaseFormats, payload, false);
+    appendRecord(kBaseAnchors, encodeAnchors(buffer.hyperlinks(), buffer.bookmarks()), false);
+    anchorsPending_ = false;
+    return sync();
+}
+
+void EditJournal::dropPrevious() {
+    std::error_code ec;
+    std::filesystem::remove(previousPath(), ec);
+}
+
+bool EditJournal::hasPrevious() const {
+    std::error_code ec;
+    return std::filesystem::exists(previousPath(), ec);
+}
+
+bool EditJournal::abandonRebase() {
+    if (!hasPrevious()) return true;
+    flush();
+    closeFile();
+
+    // .prev + this journal's records replay from .prev's base
+    std::string records;
+    {
+        MappedFile current(path_);
+        JournalHeader header;
+        if (current.isOpen() && parseHeader(current.view(), header)) {
+            records.assign(current.view().substr(header.recordsStart));
+        }
+    }
+    std::FILE* prev = std::fopen(previousPath().c_str(), "ab");
+    bool ok = prev && std::fwrite(records.data(), 1, records.size(), prev) == records.size();
+    if (prev) ok = (std::fclose(prev) == 0) && ok;
+    std::error_code ec;
+    if (ok) std::filesystem::rename(previousPath(), path_, ec);
+    if (!ok || ec) {
+        error_ = "Could not restore journal: " + path_;
+        openForAppend();
+        return false;
+    }
+    return openForAppend();
+}
+
+bool EditJournal::openForAppend() {
+    file_ = std::fopen(path_.c_str(), "ab");
+    if (!file_) error_ = "Could not open journal: " + path_;
+    return file_ != nullptr;
+}
+
+void EditJournal::discard() {
+    closeFile();
+    pendingKind_ = PendingKind::None;
+    out_.clear();
+    std::error_code ec;
+    std::filesystem::remove(path_, ec);
+    std::filesystem::remove(previousPath(), ec);
+}
+
+bool EditJournal::flush() {
+    closePending();
+    if (anchorsPending_) {
+        appendRecord(kAnchors, encodeAnchors(pendingLinks_, pendingBookmarks_));
+        anchorsPending_ = false;
+    }
+    if (out_.empty() || !file_) return file_ != nullptr;
+    bool ok = std::fwrite(out_.data(), 1, out_.size(), file_) == out_.size() &&
+              std::fflush(file_) == 0;
+    if (!ok) error_ = "Failed to write journal: " + path_;
+    bytesWritten_ += out_.size();
+    out_.clear();
+    unsynced_ = true;
+    return ok;
+}
+
+bool EditJournal::sync() {
+    if (!flush()) return false;
+#ifdef WORDPROC_HAS_FSYNC
+    if (unsynced_ && ::fsync(::fileno(file_)) != 0) {
+        error_ = "Failed to sync journal: " + path_;
+        return false;
+    }
+#endif
+    unsynced_ = false;
+    return true;
+}
+
+void EditJournal::closeFile() {
+    if (file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+void EditJournal::appendRecord(std::uint8_t type, std::string_view payload, bool counted) {
+    out_.push_back(static_cast<char>(type));
+    putVarint(out_, payload.size());
+    out_.append(payload);
+    putFixed(out_, recordChecksum(type, payload), 4);
+    if (counted) ++records_;
+}
+
+void EditJournal::closePending() {
+    if (pendingKind_ == PendingKind::None) return;
+    std::string payload;
+    putVarint(payload, pendingOffset_);
+    if (pendingKind_ == PendingKind::Insert) {
+        payload += pendingText_;
+        appendRecord(kInsert, payload);
+    } else {
+        putVarint(payload, pendingCount_);
+        appendRecord(kErase, payload);
+    }
+    pendingKind_ = PendingKind::None;
+    pendingText_.clear();
+}
+
+void EditJournal::onInsert(std::size_t offset, std::string_view text) {
+    if (pendingKind_ == PendingKind::Insert && offset == pendingOffset_ + pendingText_.size()) {
+        pendingText_.append(text);  // Typing continues where it left off
+        return;
+    }
+    closePending();
+    pendingKind_ = PendingKind::Insert;
+    pendingOffset_ = offset;
+    pendingText_.assign(text);
+}
+
+void EditJournal::onErase(std::size_t offset, std::size_t count) {
+    if (pendingKind_ == PendingKind::Insert && offset >= pendingOffset_ &&
+        offset + count == pendingOffset_ + pendingText_.size()) {
+        // Backspacing over text typed since the last flush
+        pendingText_.resize(offset - pendingOffset_);
+        if (pendingText_.empty()) pendingKind_ = PendingKind::None;
+        return;
+    }
+    if (pendingKind_ == PendingKind::Erase) {
+        if (offset + count == pendingOffset_) {  // Backspace
+            pendingOffset_ = offset;
+            pendingCount_ += count;
+            return;
+        }
+        if (offset == pendingOffset_) {  // Forward delete
+            pendingCount_ += count;
+            return;
+        }
+    }
+    closePending();
+    pendingKind_ = PendingKind::Erase;
+    pendingOffset_ = offset;
+    pendingCount_ = count;
+}
+
+void EditJournal::onReset(const TextBuffer& buffer) {
+    pendingKind_ = PendingKind::None;
+    pendingText_.clear();
+    std::string text;
+    buffer.forEachTextChunk([&text](std::string_view chunk) { text.append(chunk); });
+    appendRecord(kReset, text);
+    onAnchorsChanged(buffer);  // setText drops the hyperlinks
+}
+
+void EditJournal::onStyleChanged(const TextStyle& style) {
+    if (haveStyle_ && sameStyle(style, lastStyle_)) return;
+    closePending();
+    lastStyle_ = style;
+    haveStyle_ = true;
+    appendRecord(kStyle, encodeStyle(style));
+}
+
+void EditJournal::onLineFormatChanged(std::size_t row, const ParagraphFormat& format) {
+    closePending();  // The row may be one the pending insert creates
+    std::string payload;
+    putVarint(payload, row);
+    encodeFormat(payload, format);
+    appendRecord(kFormat, payload);
+}
+
+void EditJournal::onAnchorsChanged(const TextBuffer& buffer) {
+    // Typing ahead of a link moves it on every keystroke; only the state at
+    // the next flush is written
+    pendingLinks_ = buffer.hyperlinks();
+    pendingBookmarks_ = buffer.bookmarks();
+    anchorsPending_ = true;
+}
+
+// ============================================================================
+// Recovery
+// ============================================================================
+
+JournalRecovery recoverFromJournal(const std::string& journalPath,
+                                   const std::string& checkpointPath, TextBuffer& buffer,
+                                   DocumentSettings& settings) {
+    JournalRecovery recovery;
+    MappedFile current(journalPath);
+    JournalHeader header;
+    if (!current.isOpen() || !parseHeader(current.view(), header)) {
+        recovery.error = "No journal at " + journalPath;
+        return recovery;
+    }
+
+    std::string baseText;
+    DocumentSettings recovered = settings;
+    ReplayState state;
+    if (loadBase(header.basePath, header.baseHash, baseText, recovered)) {
+        recovery.basePath = header.basePath;
+        state.text.setContent(baseText.data(), baseText.size());
+        state.style = recovered.textStyle;
+    } else {
+        // The new base never made it to disk: start from the older base and
+        // replay the journal that leads up to it
+        MappedFile previous(journalPath + ".prev");
+        JournalHeader prevHeader;
+        if (!previous.isOpen() || !parseHeader(previous.view(), prevHeader) ||
+            !loadBase(prevHeader.basePath, prevHeader.baseHash, baseText, recovered)) {
+            recovery.error = "Journal base is missing or changed: " + header.basePath;
+            return recovery;
+        }
+        state.text.setContent(baseText.data(), baseText.size());
+        state.style = recovered.textStyle;
+        // Leaves the text at the current journal's base
+        recovery.recordsReplayed +=
+            replayRecords(previous.view(), prevHeader.recordsStart, state);
+        recovery.basePath = prevHeader.basePath;
+        recovery.usedPrevious = true;
+    }
+
+    recovery.recordsReplayed += replayRecords(current.view(), header.recordsStart, state);
+
+    std::string text = state.text.toString();
+    buffer.setText(text);
+    buffer.setTextStyle(state.style);
+    for (const auto& [row, format] : state.formats) buffer.setLineFormat(row, format);
+    // A torn tail can leave anchors past the end of the shorter text
+    std::erase_if(state.links, [&](const Hyperlink& link) {
+        return link.startOffset >= link.endOffset || link.endOffset > text.size();
+    });
+    std::erase_if(state.bookmarks,
+                  [&](const Bookmark& bookmark) { return bookmark.offset > text.size(); });
+    buffer.restoreAnchors(std::move(state.links), std::move(state.bookmarks));
+    recovered.textStyle = state.style;
+    settings = recovered;
+    recovery.recovered = recovery.recordsReplayed > 0 ||
+                         (!checkpointPath.empty() && recovery.basePath == checkpointPath);
+    return recovery;
+}
+
+bool setAsideJournal(const std::string& journalPath) {
+    bool ok = true;
+    for (const std::string& path : {journalPath, journalPath + ".prev"}) {
+        std::error_code ec;
+        if (!std::filesystem::exists(path, ec)) continue;
+        std::filesystem::rename(path, path + ".unrecovered", ec);
+        ok = ok && !ec;
+    }
+    return ok;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "document_settings.h"
+#include "text_buffer.h"
+
+// Append-only write-ahead log of edits, for crash recovery.
+//
+// A journal file starts with a header naming its base: a document on disk
+// (the autosave checkpoint, or the file the user last saved) plus a hash of
+// the text it must contain. Every edit after that is appended as a compact
+// binary record: insert, erase, full reset, document style, a row's
+// paragraph format, or the hyperlinks and bookmarks. Adjacent keystrokes
+// are merged into one record before each flush; anchors are written once
+// per flush, as a snapshot of all of them, when they changed. Each record
+// carries a checksum, so a record torn by a crash ends replay without
+// corrupting what came before.
+//
+// Base files do not keep paragraph formats or anchors (.wpdoc has no place
+// for them), so the records after the header restate the buffer's at the
+// time of the rebase. Replay tracks rows through inserted and erased
+// newlines the way TextBuffer does, so later format records land on the
+// right line.
+//
+// rebase() starts a new journal against a fresh base. The previous journal
+// is kept as <path>.prev until the new base is known to be on disk. If the
+// crash comes first, recovery replays old base + .prev, which reproduces
+// the new base's text.
+class EditJournal : public TextEditListener {
+   public:
+    explicit EditJournal(std::string path);
+    ~EditJournal() override;
+    EditJournal(const EditJournal&) = delete;
+    EditJournal& operator=(const EditJournal&) = delete;
+
+    // Start a new journal whose base is basePath holding buffer's current
+    // text. An empty basePath means the base is an empty document. With
+    // keepPrevious the current journal becomes <path>.prev (call
+    // dropPrevious() once basePath has been written); otherwise it is
+    // discarded along with any older .prev.
+    bool rebase(const TextBuffer& buffer, const std::string& basePath, bool keepPrevious);
+    void dropPrevious();
+    // The new base could not be written: fold this journal back onto .prev
+    // so the chain again starts from a base that exists
+    bool abandonRebase();
+    bool hasPrevious() const;
+
+    // Write merged records to the file (cheap when nothing changed; call
+    // once per frame). sync() also forces them to disk.
+    bool flush();
+    bool sync();
+
+    // Remove the journal files (e.g. the document was closed cleanly)
+    void discard();
+
+    const std::string& path() const { return path_; }
+    std::string previousPath() const { return path_ + ".prev"; }
+    bool isOpen() const { return file_ != nullptr; }
+    const std::string& error() const { return error_; }
+
+    // Since the last rebase
+    std::size_t recordCount() const { return records_; }
+    std::uint64_t bytesWritten() const { return bytesWritten_; }
+
+    static std::uint64_t hashText(const TextBuffer& buffer);
+    static std::uint64_t hashText(std::string_view text, std::uint64_t hash = kHashSeed);
+    static constexpr std::uint64_t kHashSeed = 14695981039346656037ull;
+
+    // TextEditListener
+    void onInsert(std::size_t offset, std::string_view text) override;
+    void onErase(std::size_t offset, std::size_t count) override;
+    void onReset(const TextBuffer& buffer) override;
+    void onStyleChanged(const TextStyle& style) override;
+    void onLineFormatChanged(std::size_t row, const ParagraphFormat& format) override;
+    void onAnchorsChanged(const TextBuffer& buffer) override;
+
+   private:
+    enum class PendingKind { None, Insert, Erase };
+
+    void closePending();
+    // Records that restate the base (counted is false) do not count as edits
+    void appendRecord(std::uint8_t type, std::string_view payload, bool counted = true);
+    bool openForAppend();
+    void closeFile();
+
+    std::string path_;
+    std::string error_;
+    std::FILE* file_ = nullptr;
+    std::string out_;  // Encoded records waiting for flush()
+
+    // The edit still being merged with neighbouring keystrokes
+    PendingKind pendingKind_ = PendingKind::None;
+    std::size_t pendingOffset_ = 0;
+    std::size_t pendingCount_ = 0;  // Erase length
+    std::string pendingText_;       // Insert bytes
+
+    TextStyle lastStyle_;
+    bool haveStyle_ = false;
+    // Anchors as of the latest change, written at the next flush
+    std::vector<Hyperlink> pendingLinks_;
+    std::vector<Bookmark> pendingBookmarks_;
+    bool anchorsPending_ = false;
+    std::size_t records_ = 0;
+    std::uint64_t bytesWritten_ = 0;
+    bool unsynced_ = false;
+};
+
+struct JournalRecovery {
+    bool recovered = false;           // Buffer holds unsaved work from the journal
+    std::string basePath;             // Document the replay started from
+    std::size_t recordsReplayed = 0;
+    bool usedPrevious = false;        // Base was not written; replayed .prev too
+    std::string error;
+};
+
+// Rebuild the last session's text from the journal at journalPath and its
+// base. recovered is set when records were replayed or the base is the
+// checkpoint itself (its contents were never saved by the user). On
+// failure the buffer and settings are left untouched.
+JournalRecovery recoverFromJournal(const std::string& journalPath,
+                                   const std::string& checkpointPath, TextBuffer& buffer,
+                                   DocumentSettings& settings);
+
+// Move a journal that could not be recovered (and its .prev) to
+// <path>.unrecovered, so the next session's rebase does not delete it
+bool setAsideJournal(const std::string& journalPath);
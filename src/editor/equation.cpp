@@ -7,8 +7,7 @@ std::size_t EquationCollection::addEquation(const DocumentEquation& eq) {
     if (newEq.id == 0) {
         newEq.id = nextId_++;
     }
-    equations_.push_back(newEq);
-    return newEq.id;
+    return anchor_index::insert(equations_, std::move(newEq)).id;
 }
 
 bool EquationCollection::removeEquation(std::size_t id) {
@@ -35,29 +34,21 @@ const DocumentEquation* EquationCollection::getEquation(std::size_t id) const {
     return nullptr;
 }
 
-std::vector<DocumentEquation*> EquationCollection::equationsAtLine(std::size_t line) {
-    std::vector<DocumentEquation*> result;
-    for (auto& eq : equations_) {
-        if (eq.anchorLine == line) result.push_back(&eq);
-    }
-    return result;
+std::span<DocumentEquation> EquationCollection::equationsAtLine(std::size_t line) {
+    return anchor_index::inLines(equations_, line, line);
 }
 
-std::vector<const DocumentEquation*> EquationCollection::equationsAtLine(std::size_t line) const {
-    std::vector<const DocumentEquation*> result;
-    for (const auto& eq : equations_) {
-        if (eq.anchorLine == line) result.push_back(&eq);
-    }
-    return result;
+std::span<const DocumentEquation> EquationCollection::equationsAtLine(std::size_t line) const {
+    return anchor_index::inLines(equations_, line, line);
+}
+
+std::span<const DocumentEquation> EquationCollection::equationsInRange(
+    std::size_t startLine, std::size_t endLine) const {
+    return anchor_index::inLines(equations_, startLine, endLine);
 }
 
 void EquationCollection::shiftAnchorsFrom(std::size_t line, std::ptrdiff_t linesDelta) {
-    for (auto& eq : equations_) {
-        if (eq.anchorLine >= line) {
-            auto newLine = static_cast<std::ptrdiff_t>(eq.anchorLine) + linesDelta;
-            eq.anchorLine = static_cast<std::size_t>(std::max(std::ptrdiff_t(0), newLine));
-        }
-    }
+    anchor_index::shiftAnchors(equations_, line, linesDelta);
 }
 
 void EquationCollection::clear() {
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <cstddef>
+#include <span>
 #include <string>
 #include <vector>
 
+#include "anchor_index.h"
+
 // Equation display style
 enum class EquationStyle {
     Inline,   // Displayed within text flow
@@ -43,7 +46,9 @@ struct DocumentEquation {
     bool isInline() const { return style == EquationStyle::Inline; }
 };
 
-// Equation collection for a document
+// Equation collection for a document, kept sorted by anchor line
+// (anchor_index.h). Equations have no laid-out size of their own, so
+// there is no bounds index here; cull them by line with equationsInRange.
 class EquationCollection {
 public:
     EquationCollection() = default;
@@ -58,13 +63,17 @@ public:
     // Remove equation by ID
     bool removeEquation(std::size_t id);
     
-    // Get all equations
+    // Get all equations, in anchor line order
     const std::vector<DocumentEquation>& equations() const { return equations_; }
     std::vector<DocumentEquation>& equations() { return equations_; }
     
     // Get equations at a line
-    std::vector<DocumentEquation*> equationsAtLine(std::size_t line);
-    std::vector<const DocumentEquation*> equationsAtLine(std::size_t line) const;
+    std::span<DocumentEquation> equationsAtLine(std::size_t line);
+    std::span<const DocumentEquation> equationsAtLine(std::size_t line) const;
+    
+    // Get equations anchored on lines startLine..endLine
+    std::span<const DocumentEquation> equationsInRange(std::size_t startLine,
+                                                       std::size_t endLine) const;
     
     // Update anchor positions after text edits
     void shiftAnchorsFrom(std::size_t line, std::ptrdiff_t linesDelta);
@@ -0,0 +1,269 @@
+#include "batch_convert.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "export_html.h"
+#include "export_pdf.h"
+#include "export_rtf.h"
+
+namespace {
+
+bool hasWildcard(std::string_view text) {
+    return text.find_first_of("*?") != std::string_view::npos;
+}
+
+bool hasExtension(const std::filesystem::path& path, const std::vector<std::string>& extensions) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    return std::find(extensions.begin(), extensions.end(), ext) != extensions.end();
+}
+
+// Where a glob's fixed leading directories end: "docs/2024/*.wpdoc" walks
+// from "docs/2024"
+std::string globBase(const std::string& pattern) {
+    std::size_t wildcard = pattern.find_first_of("*?");
+    std::size_t slash = pattern.rfind('/', wildcard);
+    if (slash == std::string::npos) return ".";
+    if (slash == 0) return "/";
+    return pattern.substr(0, slash);
+}
+
+std::string relativeTo(const std::filesystem::path& path, const std::filesystem::path& base) {
+    std::error_code ec;
+    std::filesystem::path relative = std::filesystem::relative(path, base, ec);
+    if (ec || relative.empty()) return path.filename().generic_string();
+    return relative.generic_string();
+}
+
+std::string outputPathFor(const ConvertInput& input, const ConvertOptions& options) {
+    std::filesystem::path output = options.outputDir.empty()
+                                       ? std::filesystem::path(input.path)
+                                       : std::filesystem::path(options.outputDir) / input.relative;
+    output.replace_extension(convertFormatExtension(options.format));
+    return output.string();
+}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+ConvertResult convertOne(const ConvertInput& input, const ConvertOptions& options) {
+    ConvertResult converted;
+    converted.input = input.path;
+    converted.output = outputPathFor(input, options);
+    std::error_code ec;
+    converted.inputBytes = static_cast<std::size_t>(std::filesystem::file_size(input.path, ec));
+
+    TextBuffer buffer;
+    DocumentSettings settings;
+    TableList tables;
+    auto start = std::chrono::steady_clock::now();
+    converted.result = loadDocumentWithTables(buffer, settings, tables, input.path);
+    converted.loadMs = msSince(start);
+    if (!converted.result.success) return converted;
+
+    std::filesystem::path parent = std::filesystem::path(converted.output).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+
+    // Files are already spread over every core, so each export runs on
+    // the worker that loaded it
+    start = std::chrono::steady_clock::now();
+    switch (options.format) {
+        case ConvertFormat::Pdf: {
+            PdfExportOptions pdfOptions;
+            pdfOptions.threadCount = 1;
+            pdfOptions.fontDirectory = options.fontDirectory;
+            converted.result = exportDocumentPdf(buffer, settings, converted.output, pdfOptions);
+        } break;
+        case ConvertFormat::Html: {
+            ExportOptions htmlOptions;
+            htmlOptions.threadCount = 1;
+            converted.result =
+                exportDocumentHtml(buffer, settings, tables, converted.output, htmlOptions);
+        } break;
+        case ConvertFormat::Rtf:
+            converted.result = exportDocumentRtf(buffer, settings, tables, converted.output);
+            break;
+    }
+    converted.exportMs = msSince(start);
+    if (converted.result.success) {
+        converted.outputBytes =
+            static_cast<std::size_t>(std::filesystem::file_size(converted.output, ec));
+    }
+    return converted;
+}
+
+}  // namespace
+
+bool parseConvertFormat(std::string_view name, ConvertFormat& format) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    if (lower == "pdf") {
+        format = ConvertFormat::Pdf;
+    } else if (lower == "html") {
+        format = ConvertFormat::Html;
+    } else if (lower == "rtf") {
+        format = ConvertFormat::Rtf;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* convertFormatExtension(ConvertFormat format) {
+    switch (format) {
+        case ConvertFormat::Pdf: return ".pdf";
+        case ConvertFormat::Html: return ".html";
+        case ConvertFormat::Rtf: return ".rtf";
+    }
+    return ".pdf";
+}
+
+bool globMatch(std::string_view pattern, std::string_view path) {
+    std::size_t p = 0, s = 0;
+    while (p < pattern.size()) {
+        if (pattern[p] == '*') {
+            bool anyDepth = p + 1 < pattern.size() && pattern[p + 1] == '*';
+            std::string_view rest = pattern.substr(p + (anyDepth ? 2 : 1));
+            // "**/" also matches no directories at all
+            if (anyDepth && !rest.empty() && rest[0] == '/' &&
+                globMatch(rest.substr(1), path.substr(s))) {
+                return true;
+            }
+            for (std::size_t i = s;; ++i) {
+                if (globMatch(rest, path.substr(i))) return true;
+                if (i == path.size() || (!anyDepth && path[i] == '/')) return false;
+            }
+        }
+        if (s == path.size() ||
+            (pattern[p] != path[s] && (pattern[p] != '?' || path[s] == '/'))) {
+            return false;
+        }
+        p++;
+        s++;
+    }
+    return s == path.size();
+}
+
+std::vector<ConvertInput> collectConvertInputs(const std::vector<std::string>& arguments,
+                                               const ConvertOptions& options,
+                                               std::vector<std::string>* unmatched) {
+    std::vector<ConvertInput> inputs;
+    std::set<std::string> seen;
+    bool matched = false;
+    auto add = [&](const std::filesystem::path& path, std::string relative) {
+        matched = true;
+        std::error_code ec;
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(path, ec);
+        if (!seen.insert(ec ? path.string() : canonical.string()).second) return;
+        inputs.push_back({path.string(), std::move(relative)});
+    };
+    auto dirOptions = std::filesystem::directory_options::skip_permission_denied;
+
+    for (const std::string& argument : arguments) {
+        matched = false;
+        std::error_code ec;
+        std::string pattern = std::filesystem::path(argument).generic_string();
+        if (hasWildcard(pattern)) {
+            std::string base = globBase(pattern);
+            // Matched against paths spelled the way the pattern is
+            std::string prefix = base == "." && pattern.rfind("./", 0) != 0 ? "" : base + "/";
+            for (std::filesystem::recursive_directory_iterator it(base, dirOptions, ec), end;
+                 !ec && it != end; it.increment(ec)) {
+                std::error_code entryEc;
+                if (!it->is_regular_file(entryEc)) continue;
+                std::string relative = relativeTo(it->path(), base);
+                if (globMatch(pattern, prefix + relative)) add(it->path(), relative);
+            }
+        } else if (std::filesystem::is_directory(argument, ec)) {
+            auto consider = [&](const std::filesystem::directory_entry& entry) {
+                std::error_code entryEc;
+                if (entry.is_regular_file(entryEc) &&
+                    hasExtension(entry.path(), options.extensions)) {
+                    add(entry.path(), relativeTo(entry.path(), argument));
+                }
+            };
+            if (options.recursive) {
+                for (std::filesystem::recursive_directory_iterator it(argument, dirOptions, ec), end;
+                     !ec && it != end; it.increment(ec)) {
+                    consider(*it);
+                }
+            } else {
+                for (std::filesystem::directory_iterator it(argument, dirOptions, ec), end;
+                     !ec && it != end; it.increment(ec)) {
+                    consider(*it);
+                }
+            }
+        } else if (std::filesystem::is_regular_file(argument, ec)) {
+            add(argument, std::filesystem::path(argument).filename().string());
+        }
+        if (!matched && unmatched) unmatched->push_back(argument);
+    }
+
+    std::sort(inputs.begin(), inputs.end(),
+              [](const ConvertInput& a, const ConvertInput& b) { return a.path < b.path; });
+    return inputs;
+}
+
+ConvertStats convertFiles(const std::vector<ConvertInput>& inputs, const ConvertOptions& options,
+                          const ConvertResultCallback& onResult) {
+    ConvertStats stats;
+    auto start = std::chrono::steady_clock::now();
+    unsigned int threadCount = options.threadCount;
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    threadCount = std::max(1u, std::min<unsigned int>(threadCount,
+                                                       static_cast<unsigned int>(inputs.size())));
+
+    std::atomic<std::size_t> nextFile{0};
+    std::mutex mutex;
+    auto work = [&] {
+        for (std::size_t i = nextFile++; i < inputs.size(); i = nextFile++) {
+            ConvertResult converted = convertOne(inputs[i], options);
+            converted.peakRssKb = peakResidentKb();
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.files++;
+            if (!converted.result.success) stats.failed++;
+            stats.inputBytes += converted.inputBytes;
+            stats.outputBytes += converted.outputBytes;
+            if (onResult) onResult(converted);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount);
+    for (unsigned int i = 1; i < threadCount; ++i) workers.emplace_back(work);
+    work();  // The calling thread takes a share too
+    for (std::thread& worker : workers) worker.join();
+
+    stats.peakRssKb = peakResidentKb();
+    stats.elapsedMs = msSince(start);
+    return stats;
+}
+
+std::size_t peakResidentKb() {
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+    return static_cast<std::size_t>(usage.ru_maxrss) / 1024;  // Bytes on macOS
+#else
+    return static_cast<std::size_t>(usage.ru_maxrss);
+#endif
+#else
+    return 0;
+#endif
+}
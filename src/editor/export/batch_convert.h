@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../document_io.h"
+
+// Headless conversion of many documents at once (main.cpp's --convert).
+// Each file is loaded with loadDocumentWithTables and written by one of
+// the exporters; files are spread over a pool of worker threads, one file
+// per thread at a time, so no window or GL context is involved.
+
+enum class ConvertFormat { Pdf, Html, Rtf };
+
+// "pdf", "html" or "rtf" (any case). False for anything else.
+bool parseConvertFormat(std::string_view name, ConvertFormat& format);
+const char* convertFormatExtension(ConvertFormat format);  // ".pdf" etc.
+
+struct ConvertOptions {
+    ConvertFormat format = ConvertFormat::Pdf;
+    // Empty = each output next to its input. Otherwise outputs go here,
+    // keeping their path below the directory or glob they were found under.
+    std::string outputDir;
+    // Files picked up from directories (files named outright are always used)
+    std::vector<std::string> extensions = {".wpdoc", ".txt", ".md", ".docx", ".odt"};
+    bool recursive = true;
+    unsigned int threadCount = 0;  // 0 = std::thread::hardware_concurrency()
+    std::string fontDirectory = "resources/fonts";  // For PDF
+};
+
+struct ConvertInput {
+    std::string path;
+    std::string relative;  // Path below the directory or glob base it came from
+};
+
+// Expand files, directories and glob patterns (*, ? and ** for any number
+// of directories) into a sorted list without duplicates. Arguments that
+// match nothing are added to unmatched.
+std::vector<ConvertInput> collectConvertInputs(const std::vector<std::string>& arguments,
+                                               const ConvertOptions& options,
+                                               std::vector<std::string>* unmatched = nullptr);
+
+// Whether path matches pattern; both use '/' separators
+bool globMatch(std::string_view pattern, std::string_view path);
+
+struct ConvertResult {
+    std::string input;
+    std::string output;
+    DocumentResult result;
+    double loadMs = 0.0;
+    double exportMs = 0.0;
+    std::size_t inputBytes = 0;
+    std::size_t outputBytes = 0;
+    std::size_t peakRssKb = 0;  // Process high-water mark once this file was done
+};
+
+struct ConvertStats {
+    std::size_t files = 0;
+    std::size_t failed = 0;
+    std::size_t inputBytes = 0;
+    std::size_t outputBytes = 0;
+    std::size_t peakRssKb = 0;
+    double elapsedMs = 0.0;
+};
+
+// Convert every input, blocking until all are done. onResult is called
+// once per file as it finishes, one call at a time (from worker threads).
+using ConvertResultCallback = std::function<void(const ConvertResult&)>;
+ConvertStats convertFiles(const std::vector<ConvertInput>& inputs, const ConvertOptions& options,
+                          const ConvertResultCallback& onResult = {});
+
+// Peak resident set size of this process in KB (0 where unsupported)
+std::size_t peakResidentKb();
@@ -0,0 +1,22 @@
+#include "export_anchors.h"
+
+ExportAnchors::ExportAnchors(const TextBuffer& buffer, const TableList& tableList)
+    : bookmarks(&buffer.bookmarks()) {
+    links.reserve(buffer.hyperlinks().size());
+    for (const Hyperlink& link : buffer.hyperlinks()) links.push_back(&link);
+    std::sort(links.begin(), links.end(), [](const Hyperlink* a, const Hyperlink* b) {
+        return a->startOffset < b->startOffset;
+    });
+    tables.reserve(tableList.size());
+    for (const auto& table : tableList) tables.push_back(&table);
+    // Tables at the same line keep their order
+    std::stable_sort(tables.begin(), tables.end(), [](const TableAnchor* a, const TableAnchor* b) {
+        return a->first < b->first;
+    });
+}
+
+std::vector<const ExportAnchors::TableAnchor*>::const_iterator ExportAnchors::firstTableFrom(
+    std::size_t row) const {
+    return std::lower_bound(tables.begin(), tables.end(), row,
+                            [](const TableAnchor* t, std::size_t r) { return t->first < r; });
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "../document_io.h"
+#include "../table.h"
+#include "../text_buffer.h"
+
+// Hyperlinks, bookmarks and tables in document order, shared by the
+// exporters that write them inline (HTML and RTF). Each exporter walks a
+// paragraph with walkInline and writes its own markup for the events.
+struct ExportAnchors {
+    using TableAnchor = std::pair<std::size_t, Table>;
+
+    std::vector<const Hyperlink*> links;  // By startOffset; links never overlap
+    const std::vector<Bookmark>* bookmarks = nullptr;  // Kept sorted by TextBuffer
+    std::vector<const TableAnchor*> tables;            // By line
+
+    // buffer and tables must outlive the anchors
+    ExportAnchors(const TextBuffer& buffer, const TableList& tables);
+
+    // First table at or after row
+    std::vector<const TableAnchor*>::const_iterator firstTableFrom(std::size_t row) const;
+};
+
+// Walks the tables from a starting row as the export reaches each line.
+// Tables sit at their line, ahead of its text.
+class TableCursor {
+   public:
+    TableCursor(const ExportAnchors& anchors, std::size_t firstRow)
+        : next_(anchors.firstTableFrom(firstRow)), end_(anchors.tables.end()) {}
+
+    // emit(const Table&) for each table at row
+    template <typename Emit>
+    void forEachAt(std::size_t row, Emit&& emit) {
+        for (; next_ != end_ && (*next_)->first == row; ++next_) emit((*next_)->second);
+    }
+
+    // The rest, for tables anchored past the last line
+    template <typename Emit>
+    void forEachRemaining(Emit&& emit) {
+        for (; next_ != end_; ++next_) emit((*next_)->second);
+    }
+
+   private:
+    std::vector<const ExportAnchors::TableAnchor*>::const_iterator next_;
+    std::vector<const ExportAnchors::TableAnchor*>::const_iterator end_;
+};
+
+// Split the paragraph at document offsets [lineStart, lineEnd) into events
+// on sink, in order:
+//   sink.text(from, to)            a non-empty run of the paragraph's text
+//   sink.bookmark(const Bookmark&) a bookmark at the current position
+//   sink.linkStart(const Hyperlink&) / sink.linkEnd()  around a link's text
+// A link running over a paragraph break is reported once per paragraph. A
+// bookmark on the break itself belongs to the paragraph it ends.
+template <typename Sink>
+void walkInline(const ExportAnchors& anchors, std::size_t lineStart, std::size_t lineEnd,
+                Sink& sink) {
+    const std::vector<Bookmark>& bookmarks = *anchors.bookmarks;
+    auto bookmark = std::lower_bound(bookmarks.begin(), bookmarks.end(), lineStart,
+                                     [](const Bookmark& b, std::size_t offset) {
+                                         return b.offset < offset;
+                                     });
+    // Text [from, to) with the bookmarks inside it; one at to only atEnd
+    auto run = [&](std::size_t from, std::size_t to, bool atEnd) {
+        while (bookmark != bookmarks.end() &&
+               (bookmark->offset < to || (atEnd && bookmark->offset == to))) {
+            std::size_t at = std::max(bookmark->offset, from);
+            if (at > from) sink.text(from, at);
+            from = at;
+            sink.bookmark(*bookmark);
+            ++bookmark;
+        }
+        if (to > from) sink.text(from, to);
+    };
+
+    // Links are sorted and disjoint, so their ends are sorted too
+    auto link = std::lower_bound(anchors.links.begin(), anchors.links.end(), lineStart,
+                                 [](const Hyperlink* l, std::size_t offset) {
+                                     return l->endOffset <= offset;
+                                 });
+    std::size_t pos = lineStart;
+    for (; link != anchors.links.end() && (*link)->startOffset < lineEnd; ++link) {
+        std::size_t start = std::max((*link)->startOffset, lineStart);
+        std::size_t end = std::min((*link)->endOffset, lineEnd);
+        run(pos, start, false);
+        sink.linkStart(**link);
+        run(start, end, false);
+        sink.linkEnd();
+        pos = end;
+    }
+    run(pos, lineEnd, true);
+}
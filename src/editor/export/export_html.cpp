@@ -1,11 +1,22 @@
 #include "export_html.h"
 
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <cstdio>
 
-static std::string escapeHtml(const std::string& text) {
-    std::string out;
-    out.reserve(text.size());
+#include "../atomic_file.h"
+#include "export_anchors.h"
+
+namespace {
+
+// Paragraphs per encoding job: enough work to be worth a thread, small
+// enough that the jobs in flight stay a few hundred KB
+constexpr std::size_t kRowsPerChunk = 2048;
+
+// The lists open around the current paragraph, outermost first. Each one
+// has an open <li> once an item has been written into it.
+using ListStack = std::vector<ListType>;
+
+void appendEscapedHtml(std::string& out, std::string_view text) {
     for (char ch : text) {
         switch (ch) {
             case '&': out += "&amp;"; break;
@@ -15,35 +26,363 @@ static std::string escapeHtml(const std::string& text) {
             default: out += ch; break;
         }
     }
-    return out;
+}
+
+void appendPx(std::string& out, const char* property, int px) {
+    out += property;
+    out += ':';
+    out += std::to_string(px);
+    out += "px;";
+}
+
+void appendColor(std::string& out, const char* property, const TextColor& color) {
+    char hex[8];
+    std::snprintf(hex, sizeof(hex), "#%02x%02x%02x", color.r, color.g, color.b);
+    out += property;
+    out += ':';
+    out += hex;
+    out += ';';
+}
+
+// The element for a paragraph; list items are always <li>
+const char* paragraphTag(ParagraphStyle style) {
+    switch (style) {
+        case ParagraphStyle::Title: return "h1";
+        case ParagraphStyle::Heading1: return "h1";
+        case ParagraphStyle::Heading2: return "h2";
+        case ParagraphStyle::Heading3: return "h3";
+        case ParagraphStyle::Heading4: return "h4";
+        case ParagraphStyle::Heading5: return "h5";
+        case ParagraphStyle::Heading6: return "h6";
+        case ParagraphStyle::Subtitle:
+        case ParagraphStyle::Normal:
+        case ParagraphStyle::Count:
+        default: return "p";
+    }
+}
+
+const char* listTag(ListType type) { return type == ListType::Numbered ? "ol" : "ul"; }
+
+// Open and close lists to go from the previous paragraph to one with
+// format. out may be null to only track the stack (the layout thread does
+// this to hand each chunk the lists open at its start).
+void updateListStack(ListStack& stack, const ParagraphFormat& format, std::string* out) {
+    std::size_t depth =
+        format.listType == ListType::None ? 0 : static_cast<std::size_t>(format.listLevel) + 1;
+    auto close = [&] {
+        if (out) {
+            *out += "</li></";
+            *out += listTag(stack.back());
+            *out += ">\n";
+        }
+        stack.pop_back();
+    };
+    while (stack.size() > depth) close();
+    if (depth == 0) return;
+    if (stack.size() == depth) {
+        if (stack.back() == format.listType) {
+            if (out) *out += "</li>\n";
+            return;
+        }
+        close();
+    }
+    while (stack.size() < depth) {
+        if (out) {
+            *out += '<';
+            *out += listTag(format.listType);
+            // Numbering picks up where the paragraph says it does
+            if (format.listType == ListType::Numbered && format.listNumber != 1 &&
+                stack.size() + 1 == depth) {
+                *out += " start=\"" + std::to_string(format.listNumber) + "\"";
+            }
+            *out += '>';
+            // Levels skipped over still need an item to hold the next list
+            if (stack.size() + 1 < depth) *out += "<li class=\"nested\">";
+        }
+        stack.push_back(format.listType);
+    }
+}
+
+// Open tag for a paragraph, with its format as inline CSS. List items are
+// closed by updateListStack rather than by the caller.
+void appendParagraphOpen(std::string& out, const char* tag, const ParagraphFormat& format) {
+    out += '<';
+    out += tag;
+    std::string classes;
+    if (format.style == ParagraphStyle::Title) classes = "title";
+    if (format.style == ParagraphStyle::Subtitle) classes = "subtitle";
+    if (format.hasDropCap) classes += classes.empty() ? "dropcap" : " dropcap";
+    if (!classes.empty()) out += " class=\"" + classes + "\"";
+
+    std::string style;
+    switch (format.alignment) {
+        case TextAlignment::Center: style += "text-align:center;"; break;
+        case TextAlignment::Right: style += "text-align:right;"; break;
+        case TextAlignment::Justify: style += "text-align:justify;"; break;
+        case TextAlignment::Left:
+        default: break;
+    }
+    if (format.leftIndent != 0) appendPx(style, "margin-left", format.leftIndent);
+    if (format.firstLineIndent != 0) appendPx(style, "text-indent", format.firstLineIndent);
+    if (format.spaceBefore != 0) appendPx(style, "margin-top", format.spaceBefore);
+    if (format.spaceAfter != 0) appendPx(style, "margin-bottom", format.spaceAfter);
+    if (format.lineSpacing != 1.0f) {
+        char spacing[32];
+        std::snprintf(spacing, sizeof(spacing), "line-height:%g;",
+                      static_cast<double>(format.lineSpacing));
+        style += spacing;
+    }
+    if (format.hasPageBreakBefore) style += "page-break-before:always;";
+    if (!style.empty()) {
+        out += " style=\"";
+        out += style;
+        out += '"';
+    }
+    out += '>';
+}
+
+// One paragraph's text (starting at document offset lineStart), with links
+// and bookmarks
+void appendInline(std::string& out, std::string_view text, std::size_t lineStart,
+                  const ExportAnchors& anchors) {
+    struct Sink {
+        std::string& out;
+        std::string_view line;
+        std::size_t lineStart;
+
+        void text(std::size_t from, std::size_t to) {
+            appendEscapedHtml(out, line.substr(from - lineStart, to - from));
+        }
+        void bookmark(const Bookmark& bookmark) {
+            out += "<span id=\"";
+            appendEscapedHtml(out, bookmark.name);
+            out += "\"></span>";
+        }
+        void linkStart(const Hyperlink& link) {
+            out += "<a href=\"";
+            appendEscapedHtml(out, link.url);
+            out += '"';
+            if (!link.tooltip.empty()) {
+                out += " title=\"";
+                appendEscapedHtml(out, link.tooltip);
+                out += '"';
+            }
+            out += '>';
+        }
+        void linkEnd() { out += "</a>"; }
+    };
+    Sink sink{out, text, lineStart};
+    walkInline(anchors, lineStart, lineStart + text.size(), sink);
+}
+
+void appendBorder(std::string& out, const char* side, BorderStyle border) {
+    out += "border-";
+    out += side;
+    out += ':';
+    switch (border) {
+        case BorderStyle::None: out += "none"; break;
+        case BorderStyle::Thin: out += "1px solid"; break;
+        case BorderStyle::Medium: out += "2px solid"; break;
+        case BorderStyle::Thick: out += "3px solid"; break;
+        case BorderStyle::Double: out += "3px double"; break;
+        case BorderStyle::Dashed: out += "1px dashed"; break;
+        case BorderStyle::Dotted: out += "1px dotted"; break;
+    }
+    out += ';';
+}
+
+void appendTable(std::string& out, const Table& table) {
+    if (table.isEmpty()) return;
+    out += "<table>\n<colgroup>";
+    for (std::size_t col = 0; col < table.colCount(); ++col) {
+        out += "<col style=\"";
+        appendPx(out, "width", static_cast<int>(table.colWidth(col)));
+        out += "\">";
+    }
+    out += "</colgroup>\n";
+
+    const TableCell defaults;
+    for (std::size_t row = 0; row < table.rowCount(); ++row) {
+        out += "<tr>";
+        for (std::size_t col = 0; col < table.colCount(); ++col) {
+            const TableCell& cell = table.cell(row, col);
+            if (cell.isMerged) continue;  // Covered by another cell's span
+            out += "<td";
+            if (cell.span.rowSpan > 1) out += " rowspan=\"" + std::to_string(cell.span.rowSpan) + "\"";
+            if (cell.span.colSpan > 1) out += " colspan=\"" + std::to_string(cell.span.colSpan) + "\"";
+
+            std::string style;
+            int column = static_cast<int>(cell.alignment) % 3;
+            int band = static_cast<int>(cell.alignment) / 3;
+            if (column == 1) style += "text-align:center;";
+            if (column == 2) style += "text-align:right;";
+            style += band == 0 ? "vertical-align:top;"
+                               : (band == 1 ? "vertical-align:middle;" : "vertical-align:bottom;");
+            if (!(cell.backgroundColor == defaults.backgroundColor)) {
+                appendColor(style, "background", cell.backgroundColor);
+            }
+            if (cell.textStyle.bold) style += "font-weight:bold;";
+            if (cell.textStyle.italic) style += "font-style:italic;";
+            if (cell.borders.top != defaults.borders.top) appendBorder(style, "top", cell.borders.top);
+            if (cell.borders.bottom != defaults.borders.bottom) {
+                appendBorder(style, "bottom", cell.borders.bottom);
+            }
+            if (cell.borders.left != defaults.borders.left) {
+                appendBorder(style, "left", cell.borders.left);
+            }
+            if (cell.borders.right != defaults.borders.right) {
+                appendBorder(style, "right", cell.borders.right);
+            }
+            out += " style=\"";
+            out += style;
+            out += "\">";
+
+            std::string_view content = cell.content;
+            for (std::size_t nl; (nl = content.find('\n')) != std::string_view::npos;) {
+                appendEscapedHtml(out, content.substr(0, nl));
+                out += "<br>";
+                content.remove_prefix(nl + 1);
+            }
+            appendEscapedHtml(out, content);
+            out += "</td>";
+        }
+        out += "</tr>\n";
+    }
+    out += "</table>\n";
+}
+
+// Paragraphs [first, last) as HTML, starting with lists open as in stack
+std::string encodeRows(const TextBuffer& buffer, const ExportAnchors& anchors,
+                       std::size_t first, std::size_t last, ListStack stack) {
+    std::string html;
+    TableCursor tables(anchors, first);
+    for (std::size_t row = first; row < last; ++row) {
+        ParagraphFormat format = buffer.lineFormat(row);
+        updateListStack(stack, format, &html);
+        tables.forEachAt(row, [&](const Table& table) { appendTable(html, table); });
+
+        const char* tag = format.listType == ListType::None ? paragraphTag(format.style) : "li";
+        appendParagraphOpen(html, tag, format);
+        std::string text = buffer.lineString(row);
+        appendInline(html, text, buffer.lineExtent(row).offset, anchors);
+        if (text.empty()) html += "<br>";  // Keep blank paragraphs from collapsing
+        if (format.listType == ListType::None) {
+            html += "</";
+            html += tag;
+            html += ">\n";
+        }
+    }
+    return html;
+}
+
+void writeHead(AtomicFileWriter& out, const DocumentSettings& settings) {
+    const TextStyle& text = settings.textStyle;
+    std::string head =
+        "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\"/>\n"
+        "<title>Wordproc Export</title>\n<style>\nbody{font-family:'";
+    appendEscapedHtml(head, text.font);
+    head += "',serif;";
+    appendPx(head, "font-size", text.fontSize);
+    appendColor(head, "color", text.textColor);
+    if (text.bold) head += "font-weight:bold;";
+    if (text.italic) head += "font-style:italic;";
+    head += "}\np,li,h1,h2,h3,h4,h5,h6{white-space:pre-wrap;margin:0 0 0.5em 0;}\n";
+    // Heading sizes relative to the body, as the editor draws them
+    const ParagraphStyle styles[] = {ParagraphStyle::Heading1, ParagraphStyle::Heading2,
+                                     ParagraphStyle::Heading3, ParagraphStyle::Heading4,
+                                     ParagraphStyle::Heading5, ParagraphStyle::Heading6};
+    for (ParagraphStyle style : styles) {
+        head += paragraphTag(style);
+        head += '{';
+        appendPx(head, "font-size", text.fontSize * paragraphStyleFontSize(style) / 16);
+        head += paragraphStyleIsBold(style) ? "font-weight:bold;" : "font-weight:normal;";
+        head += "}\n";
+    }
+    head += "h1.title{";
+    appendPx(head, "font-size",
+             text.fontSize * paragraphStyleFontSize(ParagraphStyle::Title) / 16);
+    head += "}\np.subtitle{";
+    appendPx(head, "font-size",
+             text.fontSize * paragraphStyleFontSize(ParagraphStyle::Subtitle) / 16);
+    head += "}\n.dropcap::first-letter{float:left;font-size:3em;line-height:1;}\n"
+            "li.nested{list-style:none;}\n"
+            "table{border-collapse:collapse;margin:0.5em 0;}\n"
+            "td{border:1px solid;padding:4px 6px;}\n"
+            "</style>\n</head>\n<body>\n";
+    out.write(head);
+}
+
+}  // namespace
+
+DocumentResult exportDocumentHtml(const TextBuffer& buffer,
+                                  const DocumentSettings& settings,
+                                  const std::string& path,
+                                  const ExportOptions& options) {
+    return exportDocumentHtml(buffer, settings, TableList{}, path, options);
 }
 
 DocumentResult exportDocumentHtml(const TextBuffer& buffer,
                                   const DocumentSettings& settings,
-                                  const std::string& path) {
+                                  const TableList& tables,
+                                  const std::string& path,
+                                  const ExportOptions& options) {
     DocumentResult result;
-    std::ofstream out(path);
-    if (!out.is_open()) {
-        result.success = false;
-        result.error = "Failed to open file for writing";
+    AtomicFileWriter out;
+    if (!out.open(path)) {
+        result.error = out.error();
         return result;
     }
 
-    std::ostringstream body;
-    std::vector<std::string> lines = buffer.lines();
-    for (const auto& line : lines) {
-        body << escapeHtml(line) << "\n";
+    ExportAnchors anchors(buffer, tables);
+
+    writeHead(out, settings);
+
+    // Runs of paragraphs are encoded on the encoder's threads and written
+    // in order; the buffer is only read while the export runs. The lists
+    // open at the start of each run are worked out here, from the formats
+    // alone, so the runs are independent.
+    ExportProgress* progress = options.progress;
+    std::size_t rows = buffer.lineCount();
+    if (progress) progress->rowsTotal.store(rows, std::memory_order_relaxed);
+    OrderedEncoder encoder(options.threadCount);
+    std::string chunk;
+    auto writeReady = [&](std::size_t keep) {
+        while (encoder.pending() > keep && encoder.next(chunk)) out.write(chunk);
+    };
+    ListStack lists;
+    for (std::size_t first = 0; first < rows; first += kRowsPerChunk) {
+        if (progress) {
+            if (progress->cancelled()) {
+                out.abort();
+                result.error = "Export cancelled";
+                return result;
+            }
+            progress->rowsDone.store(first, std::memory_order_relaxed);
+        }
+        std::size_t last = std::min(rows, first + kRowsPerChunk);
+        encoder.submit([&buffer, &anchors, first, last, lists] {
+            return encodeRows(buffer, anchors, first, last, lists);
+        });
+        for (std::size_t row = first; row < last; ++row) {
+            updateListStack(lists, buffer.lineFormat(row), nullptr);
+        }
+        writeReady(encoder.window());
     }
+    writeReady(0);
+    if (progress) progress->rowsDone.store(rows, std::memory_order_relaxed);
 
-    out << "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\"/>\n";
-    out << "<title>Wordproc Export</title>\n";
-    out << "<style>body{font-family:sans-serif;font-size:"
-        << settings.textStyle.fontSize << "px;white-space:pre-wrap;}</style>\n";
-    out << "</head>\n<body>\n";
-    out << body.str();
-    out << "\n</body>\n</html>\n";
+    // Close any list the document ends in, and tables anchored past the end
+    std::string tail;
+    updateListStack(lists, ParagraphFormat{}, &tail);
+    TableCursor(anchors, rows).forEachRemaining(
+        [&](const Table& table) { appendTable(tail, table); });
+    tail += "</body>\n</html>\n";
+    out.write(tail);
 
+    if (!out.commit()) {
+        result.error = out.error();
+        return result;
+    }
     result.success = true;
     return result;
 }
-
@@ -5,8 +5,21 @@
 #include "../document_io.h"
 #include "../document_settings.h"
 #include "../text_buffer.h"
+#include "export_pipeline.h"
 
+// Write the document as HTML: a heading, <p> or list item per paragraph
+// with its alignment, indents and spacing as inline CSS, <a> for
+// hyperlinks, an element id per bookmark, and each table at its line.
+// Output streams through AtomicFileWriter's fixed buffer, so only the runs
+// of paragraphs being encoded are held in memory.
 DocumentResult exportDocumentHtml(const TextBuffer& buffer,
                                   const DocumentSettings& settings,
-                                  const std::string& path);
+                                  const TableList& tables,
+                                  const std::string& path,
+                                  const ExportOptions& options = {});
 
+// A document without tables
+DocumentResult exportDocumentHtml(const TextBuffer& buffer,
+                                  const DocumentSettings& settings,
+                                  const std::string& path,
+                                  const ExportOptions& options = {});
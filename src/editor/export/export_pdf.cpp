@@ -1,83 +1,582 @@
 #include "export_pdf.h"
 
-#include <fstream>
-#include <iomanip>
-#include <sstream>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <string_view>
 #include <vector>
 
-static std::string escapePdfText(const std::string& text) {
-    std::string escaped;
-    escaped.reserve(text.size());
-    for (char ch : text) {
-        if (ch == '(' || ch == ')' || ch == '\\') {
-            escaped.push_back('\\');
+#include "../../fonts/font_loader.h"
+#include "../flate.h"
+#include "pdf_writer.h"
+#include "ttf_font.h"
+
+namespace {
+
+using ObjectId = PdfWriter::ObjectId;
+
+// Helvetica advance widths (1/1000 em) for ASCII 32-126, from its AFM
+constexpr std::array<std::uint16_t, 95> kHelveticaWidths = {
+    278, 278, 355, 556, 556, 889, 667, 191, 333, 333, 389, 584, 278, 333, 278, 278,
+    556, 556, 556, 556, 556, 556, 556, 556, 556, 556, 278, 278, 584, 584, 584, 556,
+    1015, 667, 667, 722, 722, 667, 611, 778, 722, 278, 500, 667, 556, 833, 722, 778,
+    667, 778, 722, 667, 611, 722, 667, 944, 667, 667, 611, 278, 278, 278, 469, 556,
+    333, 556, 556, 500, 556, 556, 278, 556, 556, 222, 222, 500, 222, 833, 556, 556,
+    556, 556, 333, 500, 278, 556, 500, 722, 500, 500, 500, 334, 260, 334, 584};
+
+// Height of a line as a multiple of the font size, before line spacing
+constexpr float kLeading = 1.2f;
+// Room for a list item's bullet or number, per nesting level
+constexpr float kListIndent = 18.0f;
+
+void appendNumber(std::string& out, double value) {
+    char text[32];
+    int length = std::snprintf(text, sizeof(text), "%.2f", value);
+    // Trailing zeros (and a bare point) only take up space
+    while (length > 0 && text[length - 1] == '0') --length;
+    if (length > 0 && text[length - 1] == '.') --length;
+    std::string_view number(text, static_cast<std::size_t>(length));
+    out.append(number == "-0" ? "0" : number);
+}
+
+void appendHex4(std::string& out, std::uint32_t value) {
+    static constexpr char kDigits[] = "0123456789ABCDEF";
+    for (int shift = 12; shift >= 0; shift -= 4) out.push_back(kDigits[(value >> shift) & 0xF]);
+}
+
+// UTF-8 to codepoints; malformed bytes become U+FFFD and tabs become spaces
+void decodeUtf8(std::string_view text, std::u32string& out) {
+    out.clear();
+    for (std::size_t i = 0; i < text.size();) {
+        auto lead = static_cast<unsigned char>(text[i]);
+        std::size_t length = lead < 0x80 ? 1 : (lead >> 5) == 0x6 ? 2 : (lead >> 4) == 0xE ? 3
+                             : (lead >> 3) == 0x1E ? 4 : 0;
+        if (length == 0 || i + length > text.size()) {
+            out.push_back(0xFFFD);
+            ++i;
+            continue;
         }
-        escaped.push_back(ch);
+        char32_t cp = length == 1 ? lead : lead & (0x7F >> length);
+        bool valid = true;
+        for (std::size_t j = 1; j < length; ++j) {
+            auto next = static_cast<unsigned char>(text[i + j]);
+            valid = valid && (next & 0xC0) == 0x80;
+            cp = (cp << 6) | (next & 0x3F);
+        }
+        if (!valid) {
+            out.push_back(0xFFFD);
+            ++i;
+            continue;
+        }
+        out.push_back(cp == '\t' ? U' ' : cp);
+        i += length;
     }
-    return escaped;
 }
 
+// The document font as the PDF sees it: an embedded TrueType subset, or
+// Helvetica when no font file could be used
+class PdfFont {
+   public:
+    bool loadTrueType(const std::string& path) {
+        if (!ttf_.loadFile(path)) return false;
+        used_.assign(ttf_.glyphCount(), false);
+        unicode_.assign(ttf_.glyphCount(), 0);
+        return true;
+    }
+
+    bool embedded() const { return ttf_.valid(); }
+
+    bool hasGlyph(char32_t cp) const {
+        return embedded() ? ttf_.glyphFor(cp) != 0 : cp >= 32 && cp < 127;
+    }
+
+    // Advance in 1/1000 em
+    float width(char32_t cp) const {
+        if (embedded()) {
+            return static_cast<float>(ttf_.advance(ttf_.glyphFor(cp))) * 1000.0f /
+                   static_cast<float>(ttf_.unitsPerEm());
+        }
+        if (cp < 32 || cp >= 127) cp = '?';
+        return kHelveticaWidths[cp - 32];
+    }
+
+    float width(std::u32string_view text) const {
+        float total = 0.0f;
+        for (char32_t cp : text) total += width(cp);
+        return total;
+    }
+
+    // Record the glyphs text uses, for the subset. Called while laying out,
+    // on the exporting thread.
+    void markUsed(std::u32string_view text) {
+        if (!embedded()) return;
+        for (char32_t cp : text) {
+            TrueTypeFont::GlyphId glyph = ttf_.glyphFor(cp);
+            if (!used_[glyph]) {
+                used_[glyph] = true;
+                unicode_[glyph] = cp;
+            }
+        }
+    }
+
+    // The operand for Tj: glyph ids for the embedded font, WinAnsi for
+    // Helvetica (which only covers ASCII here). Safe to call from several
+    // encoding threads at once.
+    void appendText(std::string& content, std::u32string_view text) const {
+        if (embedded()) {
+            content.push_back('<');
+            for (char32_t cp : text) appendHex4(content, ttf_.glyphFor(cp));
+            content.push_back('>');
+            return;
+        }
+        content.push_back('(');
+        for (char32_t cp : text) {
+            char ch = cp >= 32 && cp < 127 ? static_cast<char>(cp) : '?';
+            if (ch == '(' || ch == ')' || ch == '\\') content.push_back('\\');
+            content.push_back(ch);
+        }
+        content.push_back(')');
+    }
+
+    void write(PdfWriter& writer, ObjectId fontId, bool compress) const {
+        if (!embedded()) {
+            writer.writeObject(fontId,
+                               "<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica "
+                               "/Encoding /WinAnsiEncoding >>");
+            return;
+        }
+        ObjectId cidFont = writer.reserveObject();
+        ObjectId descriptor = writer.reserveObject();
+        ObjectId fontFile = writer.reserveObject();
+        ObjectId toUnicode = writer.reserveObject();
+        std::string name = "/" + subsetTag() + "+" +
+                           (ttf_.postScriptName().empty() ? "Font" : ttf_.postScriptName());
+        auto ref = [](ObjectId id) { return " " + std::to_string(id) + " 0 R"; };
+
+        writer.writeObject(fontId, "<< /Type /Font /Subtype /Type0 /BaseFont " + name +
+                                       " /Encoding /Identity-H /DescendantFonts [" +
+                                       ref(cidFont) + " ] /ToUnicode" + ref(toUnicode) + " >>");
+
+        // Widths of the glyphs used, in runs of consecutive ids
+        writer.beginObject(cidFont);
+        writer.write("<< /Type /Font /Subtype /CIDFontType2 /BaseFont " + name +
+                     " /CIDSystemInfo << /Registry (Adobe) /Ordering (Identity) /Supplement 0 >>"
+                     " /FontDescriptor" + ref(descriptor) + " /CIDToGIDMap /Identity /W [");
+        std::string run;
+        for (std::size_t glyph = 0; glyph < used_.size(); ++glyph) {
+            if (!used_[glyph]) continue;
+            if (glyph == 0 || !used_[glyph - 1]) run += "\n" + std::to_string(glyph) + " [";
+            appendNumber(run, scaled(ttf_.advance(static_cast<TrueTypeFont::GlyphId>(glyph))));
+            if (glyph + 1 == used_.size() || !used_[glyph + 1]) {
+                run += "]";
+                writer.write(run);
+                run.clear();
+            } else {
+                run += " ";
+            }
+        }
+        writer.write(" ] >>");
+        writer.endObject();
+
+        const int* box = ttf_.boundingBox();
+        std::string info = "<< /Type /FontDescriptor /FontName " + name + " /Flags ";
+        info += std::to_string(4 | (ttf_.isFixedPitch() ? 1 : 0) |
+                               (ttf_.italicAngle() != 0.0f ? 64 : 0));
+        info += " /FontBBox [";
+        for (int i = 0; i < 4; ++i) {
+            info += " ";
+            appendNumber(info, scaled(box[i]));
+        }
+        info += " ] /ItalicAngle ";
+        appendNumber(info, ttf_.italicAngle());
+        info += " /Ascent ";
+        appendNumber(info, scaled(ttf_.ascender()));
+        info += " /Descent ";
+        appendNumber(info, scaled(ttf_.descender()));
+        info += " /CapHeight ";
+        appendNumber(info, scaled(ttf_.capHeight()));
+        info += " /StemV 80 /FontFile2" + ref(fontFile) + " >>";
+        writer.writeObject(descriptor, info);
+
+        std::string subset = ttf_.subset(used_);
+        writer.writeStream(fontFile, subset, "/Length1 " + std::to_string(subset.size()),
+                           compress);
+        writer.writeStream(toUnicode, toUnicodeCMap(), {}, compress);
+    }
+
+   private:
+    float scaled(int fontUnits) const {
+        return static_cast<float>(fontUnits) * 1000.0f / static_cast<float>(ttf_.unitsPerEm());
+    }
+
+    // Six capitals naming this subset, as the PDF spec asks for
+    std::string subsetTag() const {
+        std::uint64_t hash = 14695981039346656037ull;  // FNV-1a of the used glyph ids
+        for (std::size_t glyph = 0; glyph < used_.size(); ++glyph) {
+            if (!used_[glyph]) continue;
+            hash ^= glyph;
+            hash *= 1099511628211ull;
+        }
+        std::string tag;
+        for (int i = 0; i < 6; ++i) {
+            tag.push_back(static_cast<char>('A' + hash % 26));
+            hash /= 26;
+        }
+        return tag;
+    }
+
+    // Maps glyph ids back to text, so the PDF can be searched and copied from
+    std::string toUnicodeCMap() const {
+        std::string cmap =
+            "/CIDInit /ProcSet findresource begin\n12 dict begin\nbegincmap\n"
+            "/CIDSystemInfo << /Registry (Adobe) /Ordering (UCS) /Supplement 0 >> def\n"
+            "/CMapName /Adobe-Identity-UCS def\n/CMapType 2 def\n"
+            "1 begincodespacerange\n<0000> <FFFF>\nendcodespacerange\n";
+        std::vector<std::size_t> glyphs;
+        for (std::size_t glyph = 1; glyph < used_.size(); ++glyph) {
+            if (used_[glyph] && unicode_[glyph] != 0) glyphs.push_back(glyph);
+        }
+        // At most 100 entries per block
+        for (std::size_t start = 0; start < glyphs.size(); start += 100) {
+            std::size_t end = std::min(glyphs.size(), start + 100);
+            cmap += std::to_string(end - start) + " beginbfchar\n";
+            for (std::size_t i = start; i < end; ++i) {
+                cmap += "<";
+                appendHex4(cmap, static_cast<std::uint32_t>(glyphs[i]));
+                cmap += "> <";
+                char32_t cp = unicode_[glyphs[i]];
+                if (cp > 0xFFFF) {  // UTF-16 surrogate pair
+                    appendHex4(cmap, 0xD800 + ((cp - 0x10000) >> 10));
+                    appendHex4(cmap, 0xDC00 + ((cp - 0x10000) & 0x3FF));
+                } else {
+                    appendHex4(cmap, cp);
+                }
+                cmap += ">\n";
+            }
+            cmap += "endbfchar\n";
+        }
+        cmap += "endcmap\nCMapName currentdict /CMap defineresource pop\nend\nend\n";
+        return cmap;
+    }
+
+    TrueTypeFont ttf_;
+    std::vector<bool> used_;         // By glyph id
+    std::vector<char32_t> unicode_;  // First codepoint drawn with each glyph
+};
+
+// One line of text placed on a page, as layout leaves it for encoding
+struct PlacedText {
+    std::size_t start = 0;  // Into PageDisplay::text
+    std::size_t length = 0;
+    float x = 0.0f;
+    float baseline = 0.0f;
+    float size = 0.0f;
+    bool bold = false;
+    bool italic = false;
+};
+
+// Everything on a page, ready to become its content stream
+struct PageDisplay {
+    std::u32string text;
+    std::vector<PlacedText> lines;
+};
+
+// Draw one line of text with its baseline at (x, y)
+void showText(std::string& content, const PdfFont& font, std::u32string_view text,
+              const PlacedText& line) {
+    if (line.bold) {
+        // No bold face to embed: stroke the outlines as well as filling
+        // them. q/Q keep the render mode from carrying over to later lines.
+        content += "q ";
+        appendNumber(content, line.size * 0.03f);
+        content += " w BT 2 Tr ";
+    } else {
+        content += "BT ";
+    }
+    content += "/F1 ";
+    appendNumber(content, line.size);
+    content += " Tf ";
+    content += line.italic ? "1 0 0.2 1 " : "1 0 0 1 ";
+    appendNumber(content, line.x);
+    content += " ";
+    appendNumber(content, line.baseline);
+    content += " Tm ";
+    font.appendText(content, text);
+    content += line.bold ? " Tj ET Q\n" : " Tj ET\n";
+}
+
+// Fills pages top to bottom with lines. A full page's content stream is
+// encoded and compressed on the encoder's threads while layout carries on,
+// and pages are written in order as they come back, so only the pages in
+// flight are ever held.
+class PageStream {
+   public:
+    PageStream(PdfWriter& writer, const PageSettings& page, ObjectId pages, ObjectId font,
+               const PdfFont& pdfFont, const TextColor& color, const PdfExportOptions& options)
+        : writer_(writer),
+          page_(page),
+          pages_(pages),
+          font_(font),
+          pdfFont_(pdfFont),
+          compress_(options.compress),
+          progress_(options.progress),
+          encoder_(options.threadCount) {
+        appendNumber(color_, color.r / 255.0);
+        color_ += " ";
+        appendNumber(color_, color.g / 255.0);
+        color_ += " ";
+        appendNumber(color_, color.b / 255.0);
+        color_ = color_ + " rg " + color_ + " RG\n";
+    }
+
+    // Start a new page, unless nothing has been put on this one yet
+    void breakPage() {
+        if (open_ && !display_.lines.empty()) finishPage();
+    }
+
+    // Make room for a line of the given height (moving to a new page if it
+    // does not fit) and return its top
+    float placeLine(float height) {
+        if (open_ && !display_.lines.empty() && y_ - height < page_.marginBottom) finishPage();
+        if (!open_) openPage();
+        float top = y_;
+        y_ -= height;
+        return top;
+    }
+
+    // Paragraph spacing; dropped at the top of a page
+    void addSpace(float height) {
+        if (open_ && !display_.lines.empty()) y_ -= height;
+    }
+
+    void addText(std::u32string_view text, PlacedText line) {
+        line.start = display_.text.size();
+        line.length = text.size();
+        display_.text.append(text);
+        display_.lines.push_back(line);
+    }
+
+    // Write the last page (a blank one for an empty document), the pages
+    // still being encoded, and the page tree that lists them all
+    void finish() {
+        if (!open_) openPage();
+        finishPage();
+        writeReady(0);
+        writer_.beginObject(pages_);
+        writer_.write("<< /Type /Pages /Count " + std::to_string(pageIds_.size()) + " /Kids [");
+        std::string kids;
+        for (ObjectId id : pageIds_) {
+            kids += " " + std::to_string(id) + " 0 R";
+            if (kids.size() > 4096) {
+                writer_.write(kids);
+                kids.clear();
+            }
+        }
+        writer_.write(kids);
+        writer_.write(" ] >>");
+        writer_.endObject();
+    }
+
+    std::size_t pageCount() const { return pageIds_.size(); }
+
+   private:
+    void openPage() {
+        open_ = true;
+        y_ = page_.pageHeight - page_.marginTop;
+        display_ = {};
+    }
+
+    void finishPage() {
+        encoder_.submit([this, display = std::move(display_)] {
+            std::string content = color_;
+            for (const PlacedText& line : display.lines) {
+                showText(content, pdfFont_,
+                         std::u32string_view(display.text).substr(line.start, line.length), line);
+            }
+            return compress_ ? flate::compress(content) : content;
+        });
+        open_ = false;
+        writeReady(encoder_.window());
+    }
+
+    // Write finished pages out until at most keep are in flight
+    void writeReady(std::size_t keep) {
+        std::string content;
+        while (encoder_.pending() > keep && encoder_.next(content)) {
+            ObjectId contents = writer_.reserveObject();
+            ObjectId pageId = writer_.reserveObject();
+            writer_.writeEncodedStream(contents, content, {}, compress_);
+            std::string page = "<< /Type /Page /Parent " + std::to_string(pages_) +
+                               " 0 R /MediaBox [0 0 ";
+            appendNumber(page, page_.pageWidth);
+            page += " ";
+            appendNumber(page, page_.pageHeight);
+            page += "] /Contents " + std::to_string(contents) +
+                    " 0 R /Resources << /Font << /F1 " + std::to_string(font_) + " 0 R >> >> >>";
+            writer_.writeObject(pageId, page);
+            pageIds_.push_back(pageId);
+            if (progress_) progress_->pagesWritten.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    PdfWriter& writer_;
+    const PageSettings& page_;
+    ObjectId pages_;
+    ObjectId font_;
+    const PdfFont& pdfFont_;
+    bool compress_;
+    ExportProgress* progress_;
+    std::string color_;
+    PageDisplay display_;
+    std::vector<ObjectId> pageIds_;  // The one thing kept per page
+    float y_ = 0.0f;
+    bool open_ = false;
+    // Last, so its threads stop before anything they use goes away
+    OrderedEncoder encoder_;
+};
+
+std::u32string listMarker(const ParagraphFormat& format, const PdfFont& font) {
+    std::u32string marker;
+    if (format.listType == ListType::Numbered) {
+        for (char ch : std::to_string(format.listNumber) + ".") marker.push_back(ch);
+        return marker;
+    }
+    decodeUtf8(bulletForLevel(format.listLevel), marker);
+    if (!font.hasGlyph(marker[0])) marker = U"-";
+    return marker;
+}
+
+}  // namespace
+
 DocumentResult exportDocumentPdf(const TextBuffer& buffer,
                                  const DocumentSettings& settings,
-                                 const std::string& path) {
+                                 const std::string& path,
+                                 const PdfExportOptions& options) {
     DocumentResult result;
-    std::ofstream out(path, std::ios::binary);
-    if (!out.is_open()) {
-        result.success = false;
-        result.error = "Failed to open file for writing";
+    const PageSettings& page = settings.pageSettings;
+    const TextStyle& style = settings.textStyle;
+    float baseSize = style.fontSize > 0 ? static_cast<float>(style.fontSize) : 12.0f;
+    float contentWidth = page.pageWidth - page.marginLeft - page.marginRight;
+    if (contentWidth <= 0.0f || page.pageHeight - page.marginTop - page.marginBottom <= 0.0f) {
+        result.error = "Page margins leave no room for text";
+        return result;
+    }
+
+    // The document's font, else the default one, else Helvetica
+    PdfFont font;
+    fonts::FontLoader& loader = fonts::FontLoader::get();
+    for (const std::string& id : {style.font, loader.getDefaultFontId()}) {
+        auto info = loader.getFontInfo(id);
+        std::string file = info ? info->filename : id + ".ttf";
+        if (font.loadTrueType(options.fontDirectory + "/" + file)) break;
+    }
+
+    PdfWriter writer;
+    if (!writer.open(path)) {
+        result.error = writer.error();
         return result;
     }
+    ObjectId catalog = writer.reserveObject();
+    ObjectId pages = writer.reserveObject();
+    ObjectId fontId = writer.reserveObject();
+    ObjectId info = writer.reserveObject();
+    writer.writeObject(catalog, "<< /Type /Catalog /Pages " + std::to_string(pages) + " 0 R >>");
+    writer.writeObject(info, "<< /Producer (Wordproc) >>");
+
+    ExportProgress* progress = options.progress;
+    if (progress) progress->rowsTotal.store(buffer.lineCount(), std::memory_order_relaxed);
+    PageStream stream(writer, page, pages, fontId, font, style.textColor, options);
+    std::u32string text;
+    std::u32string marker;
+    for (std::size_t row = 0; row < buffer.lineCount() && writer.good(); ++row) {
+        if (progress) {
+            if (progress->cancelled()) {
+                writer.abort();
+                result.error = "Export cancelled";
+                return result;
+            }
+            progress->rowsDone.store(row, std::memory_order_relaxed);
+        }
+        ParagraphFormat format = buffer.lineFormat(row);
+        decodeUtf8(buffer.lineString(row), text);
 
-    int fontSize = settings.textStyle.fontSize;
-    if (fontSize <= 0) fontSize = 12;
-    int lineHeight = fontSize + 4;
+        float size = baseSize * static_cast<float>(paragraphStyleFontSize(format.style)) / 16.0f;
+        float lineHeight = size * kLeading * (format.lineSpacing > 0 ? format.lineSpacing : 1.0f);
+        bool bold = style.bold || paragraphStyleIsBold(format.style);
+        bool italic = style.italic || paragraphStyleIsItalic(format.style);
+        // Glyph advances are per 1000 em
+        float scale = size / 1000.0f;
 
-    std::vector<std::string> lines = buffer.lines();
-    std::ostringstream content;
-    content << "BT\n/F1 " << fontSize << " Tf\n";
-    content << "72 720 Td\n";
-    for (std::size_t i = 0; i < lines.size(); ++i) {
-        std::string line = escapePdfText(lines[i]);
-        content << "(" << line << ") Tj\n";
-        if (i + 1 < lines.size()) {
-            content << "0 -" << lineHeight << " Td\n";
+        if (format.hasPageBreakBefore) stream.breakPage();
+        stream.addSpace(static_cast<float>(format.spaceBefore));
+
+        float left = page.marginLeft + static_cast<float>(format.leftIndent);
+        if (format.listType != ListType::None) {
+            left += kListIndent * static_cast<float>(format.listLevel + 1);
+            marker = listMarker(format, font);
         }
-    }
-    content << "ET\n";
-    std::string contentStr = content.str();
+        float right = page.marginLeft + contentWidth;
 
-    std::vector<std::string> objects;
-    objects.push_back("1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
-    objects.push_back("2 0 obj\n<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n");
-    objects.push_back("3 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [0 0 612 792] "
-                      "/Contents 5 0 R /Resources << /Font << /F1 4 0 R >> >> >>\nendobj\n");
-    objects.push_back("4 0 obj\n<< /Type /Font /Subtype /Type1 /BaseFont /Helvetica >>\nendobj\n");
+        // Greedy wrap at spaces; a word wider than the line is split
+        std::size_t start = 0;
+        bool firstLine = true;
+        do {
+            float x = left + (firstLine ? static_cast<float>(format.firstLineIndent) : 0.0f);
+            float available = std::max(right - x, size);
+            float width = 0.0f;
+            std::size_t lastSpace = std::u32string::npos;
+            std::size_t end = start;
+            for (; end < text.size(); ++end) {
+                float advance = font.width(text[end]) * scale;
+                if (width + advance > available && end > start) break;
+                if (text[end] == U' ') lastSpace = end;
+                width += advance;
+            }
+            if (end < text.size() && text[end] != U' ' && lastSpace != std::u32string::npos &&
+                lastSpace > start) {
+                end = lastSpace;
+            }
+            std::size_t next = end;
+            while (end > start && text[end - 1] == U' ') --end;
+            while (next < text.size() && text[next] == U' ') ++next;
+            std::u32string_view line = std::u32string_view(text).substr(start, end - start);
 
-    std::ostringstream contentsObj;
-    contentsObj << "5 0 obj\n<< /Length " << contentStr.size() << " >>\nstream\n"
-                << contentStr << "endstream\nendobj\n";
-    objects.push_back(contentsObj.str());
+            float lineWidth = font.width(line) * scale;
+            if (format.alignment == TextAlignment::Center) {
+                x += (right - x - lineWidth) / 2.0f;
+            } else if (format.alignment == TextAlignment::Right) {
+                x = right - lineWidth;
+            }
 
-    out << "%PDF-1.4\n";
-    std::vector<std::streamoff> offsets;
-    offsets.reserve(objects.size() + 1);
-    offsets.push_back(0);
+            PlacedText placed;
+            placed.baseline = stream.placeLine(lineHeight) - size;
+            placed.size = size;
+            placed.bold = bold;
+            placed.italic = italic;
+            if (firstLine && format.listType != ListType::None) {
+                placed.x = left - font.width(marker) * scale - size * 0.4f;
+                font.markUsed(marker);
+                stream.addText(marker, placed);
+            }
+            if (!line.empty()) {
+                placed.x = x;
+                font.markUsed(line);
+                stream.addText(line, placed);
+            }
+            start = next;
+            firstLine = false;
+        } while (start < text.size());
 
-    for (const auto& obj : objects) {
-        offsets.push_back(out.tellp());
-        out << obj;
+        stream.addSpace(static_cast<float>(format.spaceAfter));
     }
+    stream.finish();
+    font.write(writer, fontId, options.compress);
+    if (progress) progress->rowsDone.store(buffer.lineCount(), std::memory_order_relaxed);
 
-    std::streamoff xrefOffset = out.tellp();
-    out << "xref\n0 " << (objects.size() + 1) << "\n";
-    out << "0000000000 65535 f \n";
-    for (std::size_t i = 1; i < offsets.size(); ++i) {
-        out << std::setw(10) << std::setfill('0') << offsets[i] << " 00000 n \n";
+    if (!writer.finish(catalog, info)) {
+        result.error = writer.error();
+        return result;
     }
-    out << "trailer\n<< /Size " << (objects.size() + 1) << " /Root 1 0 R >>\n";
-    out << "startxref\n" << xrefOffset << "\n%%EOF\n";
-
     result.success = true;
     return result;
 }
-
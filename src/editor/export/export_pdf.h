@@ -5,8 +5,22 @@
 #include "../document_io.h"
 #include "../document_settings.h"
 #include "../text_buffer.h"
+#include "export_pipeline.h"
 
+struct PdfExportOptions : ExportOptions {
+    // Where the file for TextStyle::font is looked up
+    std::string fontDirectory = "resources/fonts";
+    // Flate-compress page contents and the embedded font
+    bool compress = true;
+};
+
+// Lay the document out on pages of settings.pageSettings' size and margins
+// and write it as PDF. Each full page is encoded and compressed on a worker
+// thread while layout continues, and pages are written in order as they
+// finish, so memory use does not grow with the page count. The document
+// font is embedded as a subset (only the glyphs used); if its file cannot
+// be read as TrueType the standard Helvetica is used instead.
 DocumentResult exportDocumentPdf(const TextBuffer& buffer,
                                  const DocumentSettings& settings,
-                                 const std::string& path);
-
+                                 const std::string& path,
+                                 const PdfExportOptions& options = {});
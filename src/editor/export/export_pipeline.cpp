@@ -0,0 +1,155 @@
+#include "export_pipeline.h"
+
+#include <chrono>
+
+// ============================================================================
+// ExportProgress
+// ============================================================================
+
+void ExportProgress::reset() {
+    rowsDone.store(0, std::memory_order_relaxed);
+    rowsTotal.store(0, std::memory_order_relaxed);
+    pagesWritten.store(0, std::memory_order_relaxed);
+    cancelRequested.store(false, std::memory_order_relaxed);
+}
+
+double ExportProgress::fraction() const {
+    std::size_t total = rowsTotal.load(std::memory_order_relaxed);
+    if (total == 0) return 0.0;
+    return static_cast<double>(rowsDone.load(std::memory_order_relaxed)) /
+           static_cast<double>(total);
+}
+
+// ============================================================================
+// OrderedEncoder
+// ============================================================================
+
+OrderedEncoder::OrderedEncoder(unsigned int threadCount) {
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    threadCount_ = threadCount > 0 ? threadCount : 1;
+    // Enough queued to keep every worker busy while the caller writes
+    window_ = threadCount_ * 2;
+    if (threadCount_ == 1) return;
+    workers_.reserve(threadCount_);
+    for (unsigned int i = 0; i < threadCount_; ++i) {
+        workers_.emplace_back([this] { workerLoop(); });
+    }
+}
+
+OrderedEncoder::~OrderedEncoder() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        jobs_.clear();
+    }
+    workReady_.notify_all();
+    for (std::thread& worker : workers_) worker.join();
+}
+
+void OrderedEncoder::submit(Job job) {
+    if (workers_.empty()) {
+        results_.push_back({job(), true});
+        nextJob_++;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.emplace_back(nextJob_++, std::move(job));
+        results_.emplace_back();
+    }
+    workReady_.notify_one();
+}
+
+bool OrderedEncoder::next(std::string& out) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (results_.empty()) return false;
+    resultReady_.wait(lock, [this] { return results_.front().done; });
+    out = std::move(results_.front().result);
+    results_.pop_front();
+    firstResult_++;
+    return true;
+}
+
+std::size_t OrderedEncoder::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return results_.size();
+}
+
+void OrderedEncoder::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        workReady_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+        if (stopping_) return;
+        auto [sequence, job] = std::move(jobs_.front());
+        jobs_.pop_front();
+        lock.unlock();
+        std::string result = job();
+        lock.lock();
+        // Results are only taken once done, so this slot is still queued
+        Slot& slot = results_[static_cast<std::size_t>(sequence - firstResult_)];
+        slot.result = std::move(result);
+        slot.done = true;
+        resultReady_.notify_all();
+    }
+}
+
+// ============================================================================
+// BackgroundExporter
+// ============================================================================
+
+BackgroundExporter::~BackgroundExporter() {
+    cancel();
+    join();
+}
+
+bool BackgroundExporter::start(const TextBuffer& buffer, const std::string& path,
+                               ExportFunction exportFn) {
+    if (isRunning()) return false;
+    join();
+
+    snapshot_.setText(buffer.getText());
+    for (std::size_t row = 0; row < buffer.lineCount(); ++row) {
+        ParagraphFormat format = buffer.lineFormat(row);
+        if (!format.isDefault()) snapshot_.setLineFormat(row, format);
+    }
+    for (const Hyperlink& link : buffer.hyperlinks()) {
+        snapshot_.addHyperlinkAt(link.startOffset, link.endOffset, link.url, link.tooltip);
+    }
+    snapshot_.clearBookmarks();
+    for (const Bookmark& bookmark : buffer.bookmarks()) {
+        snapshot_.addBookmarkAt(bookmark.name, bookmark.offset);
+    }
+    progress_.reset();
+    path_ = path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        result_.reset();
+    }
+    running_.store(true, std::memory_order_release);
+    worker_ = std::thread([this, exportFn = std::move(exportFn)] {
+        auto started = std::chrono::steady_clock::now();
+        DocumentResult result = exportFn(snapshot_, progress_);
+        elapsedMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                                                               started)
+                         .count();
+        snapshot_.setText({});  // Nothing to keep it for
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            result_ = std::move(result);
+        }
+        running_.store(false, std::memory_order_release);
+    });
+    return true;
+}
+
+std::optional<DocumentResult> BackgroundExporter::takeResult() {
+    if (isRunning()) return std::nullopt;
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::optional<DocumentResult> result = std::move(result_);
+    result_.reset();
+    return result;
+}
+
+void BackgroundExporter::join() {
+    if (worker_.joinable()) worker_.join();
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../document_io.h"
+#include "../text_buffer.h"
+
+// Progress of an export, written by the thread doing it and read by the UI
+struct ExportProgress {
+    std::atomic<std::size_t> rowsDone{0};
+    std::atomic<std::size_t> rowsTotal{0};
+    std::atomic<std::size_t> pagesWritten{0};
+    std::atomic<bool> cancelRequested{false};
+
+    void reset();
+    void cancel() { cancelRequested.store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return cancelRequested.load(std::memory_order_relaxed); }
+    // 0..1, by lines laid out
+    double fraction() const;
+};
+
+// Options every exporter takes
+struct ExportOptions {
+    unsigned int threadCount = 0;      // 0 = std::thread::hardware_concurrency()
+    ExportProgress* progress = nullptr;  // Optional; also how an export is cancelled
+};
+
+// Runs the expensive part of an export (encoding and compressing a page or
+// a run of paragraphs) on worker threads while the caller lays out the next
+// piece, and hands the results back in the order they were submitted so the
+// caller can write them straight out.
+//
+// The caller should write results out once pending() reaches window(); that
+// keeps a bounded number of pieces in memory however long the document is.
+// With one thread, jobs run inline in submit().
+class OrderedEncoder {
+   public:
+    using Job = std::function<std::string()>;
+
+    explicit OrderedEncoder(unsigned int threadCount = 0);
+    ~OrderedEncoder();  // Drops jobs not started yet
+    OrderedEncoder(const OrderedEncoder&) = delete;
+    OrderedEncoder& operator=(const OrderedEncoder&) = delete;
+
+    void submit(Job job);
+    // The oldest result, waiting for it if needed. False if none are pending.
+    bool next(std::string& out);
+
+    std::size_t pending() const;
+    std::size_t window() const { return window_; }
+    unsigned int threadCount() const { return threadCount_; }
+
+   private:
+    struct Slot {
+        std::string result;
+        bool done = false;
+    };
+
+    void workerLoop();
+
+    unsigned int threadCount_ = 1;
+    std::size_t window_ = 1;
+    mutable std::mutex mutex_;
+    std::condition_variable workReady_;
+    std::condition_variable resultReady_;
+    std::deque<std::pair<std::uint64_t, Job>> jobs_;
+    std::deque<Slot> results_;  // From the oldest not yet taken
+    std::uint64_t firstResult_ = 0;
+    std::uint64_t nextJob_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+// Runs one export at a time on a worker thread so the editor keeps drawing.
+// start() snapshots the text, paragraph formats, hyperlinks and bookmarks
+// on the UI thread; the export then reads only the snapshot, so editing can
+// carry on.
+class BackgroundExporter {
+   public:
+    using ExportFunction =
+        std::function<DocumentResult(const TextBuffer& snapshot, ExportProgress& progress)>;
+
+    BackgroundExporter() = default;
+    ~BackgroundExporter();  // Cancels a running export and waits for it
+    BackgroundExporter(const BackgroundExporter&) = delete;
+    BackgroundExporter& operator=(const BackgroundExporter&) = delete;
+
+    // False if an export is already running
+    bool start(const TextBuffer& buffer, const std::string& path, ExportFunction exportFn);
+    void cancel() { progress_.cancel(); }
+
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+    const ExportProgress& progress() const { return progress_; }
+    const std::string& path() const { return path_; }
+
+    // The result of a finished export, once
+    std::optional<DocumentResult> takeResult();
+    double elapsedMs() const { return elapsedMs_; }
+
+   private:
+    void join();
+
+    TextBuffer snapshot_;
+    ExportProgress progress_;
+    std::string path_;
+    std::thread worker_;
+    std::atomic<bool> running_{false};
+    std::mutex mutex_;
+    std::optional<DocumentResult> result_;
+    double elapsedMs_ = 0.0;
+};
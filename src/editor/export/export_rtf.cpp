@@ -1,41 +1,479 @@
 #include "export_rtf.h"
 
-#include <fstream>
+#include <algorithm>
+#include <cmath>
 
-static std::string escapeRtf(const std::string& text) {
-    std::string out;
-    out.reserve(text.size());
-    for (char ch : text) {
-        switch (ch) {
-            case '\\': out += "\\\\"; break;
-            case '{': out += "\\{"; break;
-            case '}': out += "\\}"; break;
-            case '\n': out += "\\par\n"; break;
-            default: out += ch; break;
+#include "../atomic_file.h"
+#include "export_anchors.h"
+
+namespace {
+
+// Rows between progress updates and cancellation checks
+constexpr std::size_t kRowsPerUpdate = 4096;
+// Hanging indent per list level, as the PDF export lays lists out (18pt)
+constexpr int kListIndentTwips = 360;
+// Color table entries written for every document
+constexpr int kTextColor = 1;
+constexpr int kLinkColor = 2;
+constexpr TextColor kLinkBlue{0, 0, 238, 255};
+
+// Lengths in the document are points; RTF wants twentieths of a point
+int twips(float points) { return static_cast<int>(std::lround(points * 20.0f)); }
+int twips(int points) { return points * 20; }
+
+// Escapes text into the file as it goes: \, { and } are escaped, tabs
+// become \tab and anything outside ASCII becomes \uN with a '?' fallback.
+// Runs of plain ASCII are written in one go. A UTF-8 sequence split across
+// two writes (the gap in the buffer can fall anywhere) is carried over.
+class RtfEscaper {
+   public:
+    explicit RtfEscaper(AtomicFileWriter& out) : out_(out) {}
+
+    void write(std::string_view text) {
+        std::size_t run = 0;
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            auto byte = static_cast<unsigned char>(text[i]);
+            if (pending_ == 0 && byte < 0x80 && byte != '\\' && byte != '{' && byte != '}' &&
+                byte != '\t' && byte != '\r') {
+                continue;
+            }
+            out_.write(text.substr(run, i - run));
+            run = i + 1;
+            escape(byte);
+        }
+        out_.write(text.substr(run));
+    }
+
+    // Drop a sequence cut off at the end of a paragraph
+    void finish() {
+        if (pending_ != 0) out_.put('?');
+        pending_ = 0;
+    }
+
+   private:
+    void escape(unsigned char byte) {
+        if (pending_ > 0) {
+            if ((byte & 0xC0) == 0x80) {
+                codepoint_ = (codepoint_ << 6) | (byte & 0x3Fu);
+                if (--pending_ == 0) writeUnicode(codepoint_);
+                return;
+            }
+            finish();  // Malformed; fall through to handle byte afresh
+        }
+        switch (byte) {
+            case '\\': out_.write("\\\\"); return;
+            case '{': out_.write("\\{"); return;
+            case '}': out_.write("\\}"); return;
+            case '\t': out_.write("\\tab "); return;
+            case '\r': return;
+            default: break;
+        }
+        if (byte >= 0xF8) {
+            out_.put('?');
+        } else if (byte >= 0xF0) {
+            codepoint_ = byte & 0x07u;
+            pending_ = 3;
+        } else if (byte >= 0xE0) {
+            codepoint_ = byte & 0x0Fu;
+            pending_ = 2;
+        } else if (byte >= 0xC0) {
+            codepoint_ = byte & 0x1Fu;
+            pending_ = 1;
+        } else {
+            out_.put('?');
+        }
+    }
+
+    void writeUnit(std::uint32_t unit) {
+        // \u takes a signed 16-bit value
+        int value = unit > 0x7FFF ? static_cast<int>(unit) - 0x10000 : static_cast<int>(unit);
+        out_.write("\\u");
+        out_.write(std::to_string(value));
+        out_.put('?');
+    }
+
+    void writeUnicode(std::uint32_t codepoint) {
+        if (codepoint > 0xFFFF) {
+            codepoint -= 0x10000;
+            writeUnit(0xD800 + (codepoint >> 10));
+            writeUnit(0xDC00 + (codepoint & 0x3FF));
+        } else {
+            writeUnit(codepoint);
+        }
+    }
+
+    AtomicFileWriter& out_;
+    std::uint32_t codepoint_ = 0;
+    int pending_ = 0;  // Continuation bytes still to come
+};
+
+// The buffer's text as the (at most two) runs either side of the gap, so
+// any range of it can be escaped without copying it out
+class TextChunks {
+   public:
+    explicit TextChunks(const TextBuffer& buffer) {
+        buffer.forEachTextChunk([this](std::string_view chunk) { parts_[count_++] = chunk; });
+    }
+
+    // Visit [from, to) as one or two views
+    template <typename Visit>
+    void slice(std::size_t from, std::size_t to, Visit&& visit) const {
+        std::size_t base = 0;
+        for (std::size_t i = 0; i < count_ && from < to; ++i) {
+            std::size_t end = base + parts_[i].size();
+            if (from < end) {
+                std::size_t stop = std::min(to, end);
+                visit(parts_[i].substr(from - base, stop - from));
+                from = stop;
+            }
+            base = end;
+        }
+    }
+
+   private:
+    std::string_view parts_[2];
+    std::size_t count_ = 0;
+};
+
+// Colors referenced by \cfN / \clcbpatN, in color table order from 1
+class ColorTable {
+   public:
+    int indexOf(const TextColor& color) {
+        for (std::size_t i = 0; i < colors_.size(); ++i) {
+            if (colors_[i] == color) return static_cast<int>(i) + 1;
+        }
+        colors_.push_back(color);
+        return static_cast<int>(colors_.size());
+    }
+
+    std::string rtf() const {
+        std::string table = "{\\colortbl;";
+        for (const TextColor& color : colors_) {
+            table += "\\red" + std::to_string(color.r) + "\\green" + std::to_string(color.g) +
+                     "\\blue" + std::to_string(color.b) + ';';
+        }
+        table += "}\n";
+        return table;
+    }
+
+   private:
+    std::vector<TextColor> colors_;
+};
+
+struct RtfContext {
+    const TextBuffer& buffer;
+    const DocumentSettings& settings;
+    AtomicFileWriter& out;
+    RtfEscaper escaper;
+    TextChunks chunks;
+    ColorTable colors;
+    ExportAnchors anchors;
+
+    RtfContext(const TextBuffer& b, const DocumentSettings& s, const TableList& t,
+               AtomicFileWriter& o)
+        : buffer(b), settings(s), out(o), escaper(o), chunks(b), anchors(b, t) {}
+
+    void text(std::string_view plain) {
+        escaper.write(plain);
+        escaper.finish();
+    }
+};
+
+int styleHalfPoints(const DocumentSettings& settings, ParagraphStyle style) {
+    return settings.textStyle.fontSize * paragraphStyleFontSize(style) * 2 / 16;
+}
+
+bool isHeading(ParagraphStyle style) {
+    return style >= ParagraphStyle::Heading1 && style <= ParagraphStyle::Heading6;
+}
+
+// Character formatting a paragraph of style starts with, after \plain
+std::string characterDefaults(const DocumentSettings& settings, ParagraphStyle style) {
+    const TextStyle& text = settings.textStyle;
+    std::string rtf = "\\f0\\fs" + std::to_string(styleHalfPoints(settings, style));
+    if (text.bold || paragraphStyleIsBold(style)) rtf += "\\b";
+    if (text.italic) rtf += "\\i";
+    if (text.underline) rtf += "\\ul";
+    if (text.strikethrough) rtf += "\\strike";
+    if (!(text.textColor == TextColors::Black)) rtf += "\\cf" + std::to_string(kTextColor);
+    return rtf;
+}
+
+void writeHeader(RtfContext& rtf) {
+    const DocumentSettings& settings = rtf.settings;
+    const PageSettings& page = settings.pageSettings;
+    rtf.out.write("{\\rtf1\\ansi\\ansicpg1252\\deff0\\uc1\n{\\fonttbl{\\f0\\fnil ");
+    rtf.text(settings.textStyle.font);
+    rtf.out.write(";}}\n");
+    rtf.out.write(rtf.colors.rtf());
+
+    // One style per ParagraphStyle, numbered by its value
+    rtf.out.write("{\\stylesheet\n");
+    for (int i = 0; i < static_cast<int>(ParagraphStyle::Count); ++i) {
+        auto style = static_cast<ParagraphStyle>(i);
+        std::string entry = "{\\s" + std::to_string(i);
+        if (isHeading(style)) {
+            entry += "\\outlinelevel" + std::to_string(i - static_cast<int>(ParagraphStyle::Heading1));
+        }
+        entry += characterDefaults(settings, style) + "\\sbasedon0\\snext0 ";
+        rtf.out.write(entry);
+        rtf.text(paragraphStyleName(style));
+        rtf.out.write(";}\n");
+    }
+    rtf.out.write("}\n");
+
+    rtf.out.write("\\paperw" + std::to_string(twips(page.pageWidth)) + "\\paperh" +
+                  std::to_string(twips(page.pageHeight)) + "\\margl" +
+                  std::to_string(twips(page.marginLeft)) + "\\margr" +
+                  std::to_string(twips(page.marginRight)) + "\\margt" +
+                  std::to_string(twips(page.marginTop)) + "\\margb" +
+                  std::to_string(twips(page.marginBottom)) + "\n");
+}
+
+// \pard and everything that applies to the paragraph as a whole
+void writeParagraphStart(RtfContext& rtf, const ParagraphFormat& format) {
+    std::string props = "\\pard\\plain\\s" + std::to_string(static_cast<int>(format.style));
+    if (isHeading(format.style)) {
+        props += "\\outlinelevel" +
+                 std::to_string(static_cast<int>(format.style) -
+                                static_cast<int>(ParagraphStyle::Heading1));
+    }
+    switch (format.alignment) {
+        case TextAlignment::Center: props += "\\qc"; break;
+        case TextAlignment::Right: props += "\\qr"; break;
+        case TextAlignment::Justify: props += "\\qj"; break;
+        case TextAlignment::Left:
+        default: props += "\\ql"; break;
+    }
+    int left = twips(format.leftIndent);
+    int first = twips(format.firstLineIndent);
+    if (format.listType != ListType::None) {
+        // The marker hangs in the list indent
+        left += kListIndentTwips * (format.listLevel + 1);
+        first -= kListIndentTwips;
+    }
+    if (left != 0) props += "\\li" + std::to_string(left);
+    if (first != 0) props += "\\fi" + std::to_string(first);
+    if (format.spaceBefore != 0) props += "\\sb" + std::to_string(twips(format.spaceBefore));
+    if (format.spaceAfter != 0) props += "\\sa" + std::to_string(twips(format.spaceAfter));
+    if (format.lineSpacing != 1.0f) {
+        props += "\\sl" + std::to_string(static_cast<int>(std::lround(format.lineSpacing * 240.0f))) +
+                 "\\slmult1";
+    }
+    if (format.hasPageBreakBefore) props += "\\pagebb";
+    props += characterDefaults(rtf.settings, format.style);
+    rtf.out.write(props);
+
+    if (format.listType == ListType::None) {
+        rtf.out.put(' ');
+        return;
+    }
+    // \pn for readers that number lists themselves, \pntext for the rest
+    std::string marker = format.listType == ListType::Numbered
+                             ? std::to_string(format.listNumber) + "."
+                             : bulletForLevel(format.listLevel);
+    rtf.out.write("{\\pntext\\f0 ");
+    rtf.text(marker);
+    rtf.out.write("\\tab}{\\*\\pn\\pnlvl");
+    if (format.listType == ListType::Numbered) {
+        rtf.out.write("body\\pndec\\pnstart" + std::to_string(format.listNumber) +
+                      "\\pnindent" + std::to_string(kListIndentTwips) + "{\\pntxta .}}");
+    } else {
+        rtf.out.write("blt\\pnf0\\pnindent" + std::to_string(kListIndentTwips) + "{\\pntxtb ");
+        rtf.text(marker);
+        rtf.out.write("}}");
+    }
+}
+
+// A bookmark is a point: an empty start/end pair
+void writeBookmark(RtfContext& rtf, const Bookmark& bookmark) {
+    rtf.out.write("{\\*\\bkmkstart ");
+    rtf.text(bookmark.name);
+    rtf.out.write("}{\\*\\bkmkend ");
+    rtf.text(bookmark.name);
+    rtf.out.write("}");
+}
+
+void writeFieldUrl(RtfContext& rtf, const std::string& url) {
+    // Links to a bookmark use the \l switch; quotes cannot appear inside
+    // the quoted target
+    std::string target = url;
+    std::replace(target.begin(), target.end(), '"', '\'');
+    if (!target.empty() && target[0] == '#') {
+        rtf.out.write("HYPERLINK \\\\l \"");
+        rtf.text(std::string_view(target).substr(1));
+    } else {
+        rtf.out.write("HYPERLINK \"");
+        rtf.text(target);
+    }
+    rtf.out.write("\"");
+}
+
+// One paragraph's text, with links as HYPERLINK fields and bookmarks
+void writeInline(RtfContext& rtf, std::size_t lineStart, std::size_t lineEnd) {
+    struct Sink {
+        RtfContext& rtf;
+
+        void text(std::size_t from, std::size_t to) {
+            rtf.chunks.slice(from, to, [&](std::string_view part) { rtf.escaper.write(part); });
+            rtf.escaper.finish();
+        }
+        void bookmark(const Bookmark& bookmark) { writeBookmark(rtf, bookmark); }
+        void linkStart(const Hyperlink& link) {
+            rtf.out.write("{\\field{\\*\\fldinst{");
+            writeFieldUrl(rtf, link.url);
+            rtf.out.write("}}{\\fldrslt{\\ul\\cf" + std::to_string(kLinkColor) + " ");
         }
+        void linkEnd() { rtf.out.write("}}}"); }
+    };
+    Sink sink{rtf};
+    walkInline(rtf.anchors, lineStart, lineEnd, sink);
+}
+
+const char* borderControl(BorderStyle border) {
+    switch (border) {
+        case BorderStyle::None: return "\\brdrnone";
+        case BorderStyle::Thin: return "\\brdrs\\brdrw10";
+        case BorderStyle::Medium: return "\\brdrs\\brdrw20";
+        case BorderStyle::Thick: return "\\brdrs\\brdrw30";
+        case BorderStyle::Double: return "\\brdrdb\\brdrw10";
+        case BorderStyle::Dashed: return "\\brdrdash\\brdrw10";
+        case BorderStyle::Dotted: return "\\brdrdot\\brdrw10";
     }
-    return out;
+    return "\\brdrs\\brdrw10";
+}
+
+void writeTable(RtfContext& rtf, const Table& table) {
+    if (table.isEmpty()) return;
+    const TableCell defaults;
+    for (std::size_t row = 0; row < table.rowCount(); ++row) {
+        // Row definition: each cell's borders, shading and merge state,
+        // then its right edge
+        std::string definition = "\\trowd\\trgaph108\\trleft0";
+        float right = 0.0f;
+        for (std::size_t col = 0; col < table.colCount(); ++col) {
+            const TableCell& cell = table.cell(row, col);
+            const TableCell& owner = cell.isMerged ? table.cell(cell.mergeParent) : cell;
+            if (cell.isMerged && cell.mergeParent.row < row) {
+                definition += "\\clvmrg";
+            } else if (!cell.isMerged && cell.span.rowSpan > 1) {
+                definition += "\\clvmgf";
+            }
+            if (cell.isMerged && cell.mergeParent.col < col) {
+                definition += "\\clmrg";
+            } else if (owner.span.colSpan > 1) {
+                definition += "\\clmgf";
+            }
+            int band = static_cast<int>(owner.alignment) / 3;
+            definition += band == 0 ? "\\clvertalt" : (band == 1 ? "\\clvertalc" : "\\clvertalb");
+            definition += "\\clbrdrt";
+            definition += borderControl(owner.borders.top);
+            definition += "\\clbrdrl";
+            definition += borderControl(owner.borders.left);
+            definition += "\\clbrdrb";
+            definition += borderControl(owner.borders.bottom);
+            definition += "\\clbrdrr";
+            definition += borderControl(owner.borders.right);
+            if (!(owner.backgroundColor == defaults.backgroundColor)) {
+                definition += "\\clcbpat" + std::to_string(rtf.colors.indexOf(owner.backgroundColor));
+            }
+            right += table.colWidth(col);
+            definition += "\\cellx" + std::to_string(twips(right));
+        }
+        rtf.out.write(definition);
+        rtf.out.put('\n');
+
+        for (std::size_t col = 0; col < table.colCount(); ++col) {
+            const TableCell& cell = table.cell(row, col);
+            rtf.out.write("\\pard\\intbl\\plain");
+            int column = static_cast<int>(cell.alignment) % 3;
+            rtf.out.write(column == 0 ? "\\ql" : (column == 1 ? "\\qc" : "\\qr"));
+            rtf.out.write(characterDefaults(rtf.settings, ParagraphStyle::Normal));
+            if (cell.textStyle.bold) rtf.out.write("\\b");
+            if (cell.textStyle.italic) rtf.out.write("\\i");
+            rtf.out.put(' ');
+            if (!cell.isMerged) {
+                std::string_view content = cell.content;
+                for (std::size_t nl; (nl = content.find('\n')) != std::string_view::npos;) {
+                    rtf.text(content.substr(0, nl));
+                    rtf.out.write("\\line ");
+                    content.remove_prefix(nl + 1);
+                }
+                rtf.text(content);
+            }
+            rtf.out.write("\\cell\n");
+        }
+        rtf.out.write("\\row\n");
+    }
+    rtf.out.write("\\pard\n");
+}
+
+}  // namespace
+
+DocumentResult exportDocumentRtf(const TextBuffer& buffer,
+                                 const DocumentSettings& settings,
+                                 const std::string& path,
+                                 const ExportOptions& options) {
+    return exportDocumentRtf(buffer, settings, TableList{}, path, options);
 }
 
 DocumentResult exportDocumentRtf(const TextBuffer& buffer,
                                  const DocumentSettings& settings,
-                                 const std::string& path) {
+                                 const TableList& tables,
+                                 const std::string& path,
+                                 const ExportOptions& options) {
     DocumentResult result;
-    std::ofstream out(path);
-    if (!out.is_open()) {
-        result.success = false;
-        result.error = "Failed to open file for writing";
+    AtomicFileWriter out;
+    if (!out.open(path)) {
+        result.error = out.error();
         return result;
     }
 
-    std::string text = buffer.getText();
-    out << "{\\rtf1\\ansi\\deff0\n";
-    out << "{\\fonttbl{\\f0 " << settings.textStyle.font << ";}}\n";
-    out << "\\fs" << (settings.textStyle.fontSize * 2) << " ";
-    out << escapeRtf(text);
-    out << "\n}\n";
+    RtfContext rtf(buffer, settings, tables, out);
+
+    // The color table comes first in the file, so every color is known
+    // before anything is written
+    rtf.colors.indexOf(settings.textStyle.textColor);
+    rtf.colors.indexOf(kLinkBlue);
+    const TableCell defaults;
+    for (const auto* table : rtf.anchors.tables) {
+        for (std::size_t row = 0; row < table->second.rowCount(); ++row) {
+            for (std::size_t col = 0; col < table->second.colCount(); ++col) {
+                const TextColor& color = table->second.cell(row, col).backgroundColor;
+                if (!(color == defaults.backgroundColor)) rtf.colors.indexOf(color);
+            }
+        }
+    }
+    writeHeader(rtf);
 
+    ExportProgress* progress = options.progress;
+    std::size_t rows = buffer.lineCount();
+    if (progress) progress->rowsTotal.store(rows, std::memory_order_relaxed);
+    TableCursor tableCursor(rtf.anchors, 0);
+    auto writeTableAt = [&](const Table& table) { writeTable(rtf, table); };
+    for (std::size_t row = 0; row < rows; ++row) {
+        if (progress && row % kRowsPerUpdate == 0) {
+            if (progress->cancelled()) {
+                out.abort();
+                result.error = "Export cancelled";
+                return result;
+            }
+            progress->rowsDone.store(row, std::memory_order_relaxed);
+        }
+        tableCursor.forEachAt(row, writeTableAt);
+        LineExtent extent = buffer.lineExtent(row);
+        writeParagraphStart(rtf, buffer.lineFormat(row));
+        writeInline(rtf, extent.offset, extent.offset + extent.length);
+        out.write("\\par\n");
+    }
+    tableCursor.forEachRemaining(writeTableAt);
+    if (progress) progress->rowsDone.store(rows, std::memory_order_relaxed);
+    out.write("}\n");
+
+    if (!out.commit()) {
+        result.error = out.error();
+        return result;
+    }
     result.success = true;
     return result;
 }
-
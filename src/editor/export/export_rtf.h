@@ -5,8 +5,23 @@
 #include "../document_io.h"
 #include "../document_settings.h"
 #include "../text_buffer.h"
+#include "export_pipeline.h"
 
+// Write the document as RTF: a stylesheet entry per paragraph style, each
+// paragraph's alignment, indents, spacing, list marker and page break,
+// hyperlinks as HYPERLINK fields, bookmarks, and each table at its line.
+// Text is escaped straight from the buffer's storage into
+// AtomicFileWriter's fixed buffer, so nothing the size of the document is
+// built in memory. RTF is written on the calling thread (escaping costs
+// less than handing it off); options supply progress and cancellation.
 DocumentResult exportDocumentRtf(const TextBuffer& buffer,
                                  const DocumentSettings& settings,
-                                 const std::string& path);
+                                 const TableList& tables,
+                                 const std::string& path,
+                                 const ExportOptions& options = {});
 
+// A document without tables
+DocumentResult exportDocumentRtf(const TextBuffer& buffer,
+                                 const DocumentSettings& settings,
+                                 const std::string& path,
+                                 const ExportOptions& options = {});
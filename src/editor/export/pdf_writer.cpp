@@ -0,0 +1,95 @@
+#include "pdf_writer.h"
+
+#include <cstdio>
+
+#include "../flate.h"
+
+bool PdfWriter::open(const std::string& path) {
+    offsets_.clear();
+    position_ = 0;
+    error_.clear();
+    if (!file_.open(path)) return false;
+    // Binary marker on the second line so transfer tools keep it 8-bit
+    write("%PDF-1.5\n%\xE2\xE3\xCF\xD3\n");
+    return good();
+}
+
+PdfWriter::ObjectId PdfWriter::reserveObject() {
+    offsets_.push_back(0);
+    return static_cast<ObjectId>(offsets_.size());
+}
+
+void PdfWriter::writeObject(ObjectId id, std::string_view body) {
+    beginObject(id);
+    write(body);
+    endObject();
+}
+
+void PdfWriter::beginObject(ObjectId id) {
+    if (id == 0 || id > offsets_.size()) {
+        error_ = "PDF object " + std::to_string(id) + " was never reserved";
+        return;
+    }
+    offsets_[id - 1] = position_;
+    write(std::to_string(id));
+    write(" 0 obj\n");
+}
+
+void PdfWriter::write(std::string_view text) {
+    file_.write(text);
+    position_ += text.size();
+}
+
+void PdfWriter::endObject() { write("\nendobj\n"); }
+
+void PdfWriter::writeStream(ObjectId id, std::string_view data, std::string_view dictionary,
+                            bool compress) {
+    if (compress) {
+        writeEncodedStream(id, flate::compress(data), dictionary, true);
+    } else {
+        writeEncodedStream(id, data, dictionary, false);
+    }
+}
+
+void PdfWriter::writeEncodedStream(ObjectId id, std::string_view data,
+                                   std::string_view dictionary, bool flate) {
+    beginObject(id);
+    write("<< /Length ");
+    write(std::to_string(data.size()));
+    if (flate) write(" /Filter /FlateDecode");
+    if (!dictionary.empty()) {
+        write(" ");
+        write(dictionary);
+    }
+    write(" >>\nstream\n");
+    write(data);
+    write("\nendstream");
+    endObject();
+}
+
+bool PdfWriter::finish(ObjectId catalog, ObjectId info) {
+    for (std::size_t i = 0; i < offsets_.size() && error_.empty(); ++i) {
+        if (offsets_[i] == 0) error_ = "PDF object " + std::to_string(i + 1) + " was never written";
+    }
+    if (!good()) {
+        file_.abort();
+        return false;
+    }
+
+    std::uint64_t xrefOffset = position_;
+    write("xref\n0 ");
+    write(std::to_string(offsets_.size() + 1));
+    write("\n0000000000 65535 f \n");
+    char entry[24];
+    for (std::uint64_t offset : offsets_) {
+        std::snprintf(entry, sizeof(entry), "%010llu 00000 n \n",
+                      static_cast<unsigned long long>(offset));
+        write(std::string_view(entry, 20));
+    }
+    std::string trailer = "trailer\n<< /Size " + std::to_string(offsets_.size() + 1) +
+                          " /Root " + std::to_string(catalog) + " 0 R";
+    if (info != 0) trailer += " /Info " + std::to_string(info) + " 0 R";
+    trailer += " >>\nstartxref\n" + std::to_string(xrefOffset) + "\n%%EOF\n";
+    write(trailer);
+    return file_.commit();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../atomic_file.h"
+
+// Writes a PDF file one object at a time.
+//
+// Object numbers are handed out by reserveObject() so objects can refer to
+// ones written later (pages name the font, which is only complete once every
+// page has been laid out). Each object's byte offset is recorded as it is
+// written, so the cross-reference table is ready as soon as the last one is
+// out and the writer holds nothing else: 8 bytes per object.
+//
+// Output goes through AtomicFileWriter, so a failed export leaves any
+// existing file untouched.
+class PdfWriter {
+   public:
+    using ObjectId = std::uint32_t;
+
+    // Create the file and write the header
+    bool open(const std::string& path);
+
+    ObjectId reserveObject();
+
+    // A whole object, body being its value (usually a << dictionary >>)
+    void writeObject(ObjectId id, std::string_view body);
+    // Or piece by piece, for bodies too long to build as one string
+    void beginObject(ObjectId id);
+    void write(std::string_view text);
+    void endObject();
+
+    // A stream object, Flate-compressed if compress is set. dictionary holds
+    // any entries besides /Length and /Filter, without the << >>.
+    void writeStream(ObjectId id, std::string_view data, std::string_view dictionary = {},
+                     bool compress = true);
+    // A stream whose data is already encoded (Flate-compressed if flate is
+    // set), e.g. compressed on another thread
+    void writeEncodedStream(ObjectId id, std::string_view data, std::string_view dictionary,
+                            bool flate);
+
+    // Write the cross-reference table and trailer, then replace the target.
+    // Every reserved object must have been written.
+    bool finish(ObjectId catalog, ObjectId info = 0);
+    void abort() { file_.abort(); }
+
+    bool good() const { return file_.good() && error_.empty(); }
+    const std::string& error() const { return error_.empty() ? file_.error() : error_; }
+    std::uint64_t bytesWritten() const { return position_; }
+    std::size_t objectCount() const { return offsets_.size(); }
+
+   private:
+    AtomicFileWriter file_;
+    std::vector<std::uint64_t> offsets_;  // By object number - 1; 0 = not written yet
+    std::uint64_t position_ = 0;
+    std::string error_;
+};
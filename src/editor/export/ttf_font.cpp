@@ -0,0 +1,364 @@
+#include "ttf_font.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string_view>
+
+namespace {
+
+constexpr std::uint32_t tagValue(const char* tag) {
+    return (static_cast<std::uint32_t>(static_cast<unsigned char>(tag[0])) << 24) |
+           (static_cast<std::uint32_t>(static_cast<unsigned char>(tag[1])) << 16) |
+           (static_cast<std::uint32_t>(static_cast<unsigned char>(tag[2])) << 8) |
+           static_cast<std::uint32_t>(static_cast<unsigned char>(tag[3]));
+}
+
+void appendU16(std::string& out, std::uint32_t value) {
+    out.push_back(static_cast<char>((value >> 8) & 0xFF));
+    out.push_back(static_cast<char>(value & 0xFF));
+}
+
+void appendU32(std::string& out, std::uint32_t value) {
+    appendU16(out, value >> 16);
+    appendU16(out, value & 0xFFFF);
+}
+
+void putU32(std::string& out, std::size_t offset, std::uint32_t value) {
+    for (std::size_t i = 0; i < 4; ++i) {
+        out[offset + i] = static_cast<char>((value >> (24 - 8 * i)) & 0xFF);
+    }
+}
+
+// Sum of big-endian 32-bit words, the last one zero-padded
+std::uint32_t tableChecksum(std::string_view data) {
+    std::uint32_t sum = 0;
+    for (std::size_t i = 0; i < data.size(); i += 4) {
+        std::uint32_t word = 0;
+        for (std::size_t j = 0; j < 4; ++j) {
+            word <<= 8;
+            if (i + j < data.size()) word |= static_cast<unsigned char>(data[i + j]);
+        }
+        sum += word;
+    }
+    return sum;
+}
+
+void padTo4(std::string& out) {
+    while (out.size() % 4 != 0) out.push_back('\0');
+}
+
+}  // namespace
+
+bool TrueTypeFont::loadFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::ostringstream bytes;
+    bytes << in.rdbuf();
+    return load(bytes.str());
+}
+
+bool TrueTypeFont::load(std::string bytes) {
+    data_ = std::move(bytes);
+    tables_.clear();
+    cmap_.clear();
+    glyphCount_ = 0;
+    postScriptName_.clear();
+    if (data_.size() < 12) return false;
+    std::uint32_t version = u32(0);
+    if (version != 0x00010000 && version != tagValue("true")) return false;
+
+    std::size_t tableCount = u16(4);
+    for (std::size_t i = 0; i < tableCount; ++i) {
+        std::size_t record = 12 + 16 * i;
+        Table entry{u32(record + 8), u32(record + 12)};
+        if (record + 16 > data_.size() ||
+            std::size_t{entry.offset} + entry.length > data_.size()) {
+            return false;
+        }
+        tables_[u32(record)] = entry;
+    }
+
+    const Table* head = table("head");
+    const Table* hhea = table("hhea");
+    const Table* maxp = table("maxp");
+    const Table* hmtx = table("hmtx");
+    const Table* loca = table("loca");
+    if (!head || !hhea || !maxp || !hmtx || !loca || !table("glyf") || !table("cmap")) {
+        return false;
+    }
+    if (head->length < 54 || hhea->length < 36 || maxp->length < 6) return false;
+
+    unitsPerEm_ = u16(head->offset + 18);
+    for (std::size_t i = 0; i < 4; ++i) bbox_[i] = s16(head->offset + 36 + 2 * i);
+    longLoca_ = s16(head->offset + 50) != 0;
+    ascender_ = s16(hhea->offset + 4);
+    descender_ = s16(hhea->offset + 6);
+    hMetricCount_ = u16(hhea->offset + 34);
+    std::size_t glyphs = u16(maxp->offset + 4);
+    if (unitsPerEm_ == 0 || glyphs == 0 || hMetricCount_ == 0 || hMetricCount_ > glyphs ||
+        hmtx->length < hMetricCount_ * 4 || loca->length < (glyphs + 1) * (longLoca_ ? 4 : 2)) {
+        return false;
+    }
+
+    capHeight_ = ascender_ * 7 / 10;
+    if (const Table* os2 = table("OS/2"); os2 && os2->length >= 90 && u16(os2->offset) >= 2) {
+        capHeight_ = s16(os2->offset + 88);
+    }
+    if (const Table* post = table("post"); post && post->length >= 16) {
+        italicAngle_ = static_cast<float>(static_cast<std::int32_t>(u32(post->offset + 4))) /
+                       65536.0f;
+        fixedPitch_ = u32(post->offset + 12) != 0;
+    }
+
+    glyphCount_ = glyphs;
+    if (!readCmap()) {
+        glyphCount_ = 0;
+        return false;
+    }
+    readName();
+    return true;
+}
+
+std::uint16_t TrueTypeFont::u16(std::size_t offset) const {
+    if (offset + 2 > data_.size()) return 0;
+    return static_cast<std::uint16_t>((static_cast<unsigned char>(data_[offset]) << 8) |
+                                      static_cast<unsigned char>(data_[offset + 1]));
+}
+
+std::uint32_t TrueTypeFont::u32(std::size_t offset) const {
+    return (static_cast<std::uint32_t>(u16(offset)) << 16) | u16(offset + 2);
+}
+
+const TrueTypeFont::Table* TrueTypeFont::table(const char* tag) const {
+    auto it = tables_.find(tagValue(tag));
+    return it != tables_.end() ? &it->second : nullptr;
+}
+
+TrueTypeFont::Table TrueTypeFont::glyphRange(GlyphId glyph) const {
+    const Table* loca = table("loca");
+    const Table* glyf = table("glyf");
+    if (!loca || !glyf || glyph >= glyphCount_) return {};
+    std::uint32_t start, end;
+    if (longLoca_) {
+        start = u32(loca->offset + 4u * glyph);
+        end = u32(loca->offset + 4u * glyph + 4);
+    } else {
+        start = 2u * u16(loca->offset + 2u * glyph);
+        end = 2u * u16(loca->offset + 2u * glyph + 2);
+    }
+    if (end <= start || end > glyf->length) return {};
+    return {glyf->offset + start, end - start};
+}
+
+TrueTypeFont::GlyphId TrueTypeFont::glyphFor(char32_t codepoint) const {
+    auto it = cmap_.find(codepoint);
+    return it != cmap_.end() ? it->second : 0;
+}
+
+int TrueTypeFont::advance(GlyphId glyph) const {
+    const Table* hmtx = table("hmtx");
+    if (!hmtx || hMetricCount_ == 0) return 0;
+    // Glyphs past the last long metric share its advance
+    std::size_t index = std::min<std::size_t>(glyph, hMetricCount_ - 1);
+    return u16(hmtx->offset + 4 * index);
+}
+
+bool TrueTypeFont::readCmap() {
+    const Table* cmap = table("cmap");
+    std::size_t best = 0;
+    int bestScore = 0;
+    bool symbolFont = false;
+    std::size_t count = u16(cmap->offset + 2);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::size_t record = cmap->offset + 4 + 8 * i;
+        std::uint16_t platform = u16(record);
+        std::uint16_t encoding = u16(record + 2);
+        std::size_t subtable = cmap->offset + u32(record + 4);
+        std::uint16_t format = u16(subtable);
+        bool unicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+        int score = 0;
+        if (format == 12 && unicode) {
+            score = 3;
+        } else if (format == 4 && unicode) {
+            score = 2;
+        } else if (format == 4 && platform == 3 && encoding == 0) {
+            score = 1;
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            best = subtable;
+            symbolFont = score == 1;
+        }
+    }
+    if (bestScore == 0) return false;
+
+    auto map = [this, symbolFont](char32_t codepoint, std::uint32_t glyph) {
+        if (glyph == 0 || glyph >= glyphCount_) return;
+        auto id = static_cast<GlyphId>(glyph);
+        cmap_.emplace(codepoint, id);
+        // Symbol fonts put their glyphs at U+F0xx; also answer for the byte
+        if (symbolFont && codepoint >= 0xF000 && codepoint <= 0xF0FF) {
+            cmap_.emplace(codepoint - 0xF000, id);
+        }
+    };
+
+    if (u16(best) == 12) {
+        std::size_t groups = u32(best + 12);
+        for (std::size_t i = 0; i < groups; ++i) {
+            std::size_t group = best + 16 + 12 * i;
+            if (group + 12 > data_.size()) return false;
+            std::uint32_t first = u32(group);
+            std::uint32_t last = u32(group + 4);
+            std::uint32_t glyph = u32(group + 8);
+            if (last < first || last > 0x10FFFF) continue;
+            for (std::uint32_t cp = first; cp <= last; ++cp) map(cp, glyph + (cp - first));
+        }
+        return true;
+    }
+
+    std::size_t segments = u16(best + 6) / 2;
+    std::size_t ends = best + 14;
+    std::size_t starts = ends + 2 * segments + 2;
+    std::size_t deltas = starts + 2 * segments;
+    std::size_t ranges = deltas + 2 * segments;
+    for (std::size_t s = 0; s < segments; ++s) {
+        std::uint32_t last = u16(ends + 2 * s);
+        std::uint32_t first = u16(starts + 2 * s);
+        std::uint16_t delta = u16(deltas + 2 * s);
+        std::uint16_t rangeOffset = u16(ranges + 2 * s);
+        for (std::uint32_t cp = first; cp <= last && cp != 0xFFFF; ++cp) {
+            std::uint32_t glyph;
+            if (rangeOffset == 0) {
+                glyph = (cp + delta) & 0xFFFF;
+            } else {
+                glyph = u16(ranges + 2 * s + rangeOffset + 2 * (cp - first));
+                if (glyph != 0) glyph = (glyph + delta) & 0xFFFF;
+            }
+            map(cp, glyph);
+        }
+    }
+    return true;
+}
+
+void TrueTypeFont::readName() {
+    const Table* name = table("name");
+    if (!name) return;
+    std::size_t count = u16(name->offset + 2);
+    std::size_t strings = name->offset + u16(name->offset + 4);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::size_t record = name->offset + 6 + 12 * i;
+        std::uint16_t platform = u16(record);
+        if (u16(record + 6) != 6 || platform == 2) continue;  // PostScript name only
+        std::size_t length = u16(record + 8);
+        std::size_t offset = strings + u16(record + 10);
+        if (offset + length > data_.size()) continue;
+        // Windows and Unicode names are UTF-16BE; PostScript names are ASCII
+        bool wide = platform != 1;
+        std::string result;
+        for (std::size_t j = wide ? 1 : 0; j < length; j += wide ? 2 : 1) {
+            char ch = data_[offset + j];
+            if (ch > ' ' && ch < 127 && std::string_view("[](){}<>/%").find(ch) ==
+                                            std::string_view::npos) {
+                result.push_back(ch);
+            }
+        }
+        if (!result.empty()) {
+            postScriptName_ = result;
+            if (platform == 3) return;  // Preferred; keep looking otherwise
+        }
+    }
+}
+
+std::string TrueTypeFont::subset(const std::vector<bool>& used) const {
+    if (!valid()) return {};
+
+    // Used glyphs, .notdef, and the glyphs composites are built from
+    std::vector<bool> keep(glyphCount_, false);
+    std::vector<GlyphId> pending = {0};
+    for (std::size_t glyph = 0; glyph < std::min(used.size(), glyphCount_); ++glyph) {
+        if (used[glyph]) pending.push_back(static_cast<GlyphId>(glyph));
+    }
+    while (!pending.empty()) {
+        GlyphId glyph = pending.back();
+        pending.pop_back();
+        if (keep[glyph]) continue;
+        keep[glyph] = true;
+        Table range = glyphRange(glyph);
+        if (range.length < 10 || s16(range.offset) >= 0) continue;
+        std::size_t pos = range.offset + 10;
+        std::size_t end = std::size_t{range.offset} + range.length;
+        while (pos + 4 <= end) {
+            std::uint16_t flags = u16(pos);
+            GlyphId component = u16(pos + 2);
+            if (component < glyphCount_) pending.push_back(component);
+            pos += 4;
+            pos += (flags & 0x0001) ? 4 : 2;  // Arguments are words
+            if (flags & 0x0008) {
+                pos += 2;  // Scale
+            } else if (flags & 0x0040) {
+                pos += 4;  // X and Y scale
+            } else if (flags & 0x0080) {
+                pos += 8;  // 2x2 transform
+            }
+            if (!(flags & 0x0020)) break;  // No more components
+        }
+    }
+
+    std::string glyf;
+    std::string loca;
+    for (std::size_t glyph = 0; glyph < glyphCount_; ++glyph) {
+        appendU32(loca, static_cast<std::uint32_t>(glyf.size()));
+        if (!keep[glyph]) continue;
+        Table range = glyphRange(static_cast<GlyphId>(glyph));
+        glyf.append(data_, range.offset, range.length);
+        padTo4(glyf);
+    }
+    appendU32(loca, static_cast<std::uint32_t>(glyf.size()));
+
+    // Ordered by tag, as the table directory must be
+    std::map<std::string, std::string> tables;
+    for (const char* tag : {"cmap", "head", "hhea", "hmtx", "maxp", "cvt ", "fpgm", "prep"}) {
+        if (const Table* source = table(tag)) {
+            tables[tag] = data_.substr(source->offset, source->length);
+        }
+    }
+    std::string& head = tables["head"];
+    putU32(head, 8, 0);  // checkSumAdjustment, filled in below
+    head[50] = 0;        // indexToLocFormat: long offsets
+    head[51] = 1;
+    tables["glyf"] = std::move(glyf);
+    tables["loca"] = std::move(loca);
+
+    auto count = static_cast<std::uint32_t>(tables.size());
+    std::uint32_t power = 1;
+    std::uint32_t log2 = 0;
+    while (power * 2 <= count) {
+        power *= 2;
+        ++log2;
+    }
+    std::string font;
+    appendU32(font, 0x00010000);
+    appendU16(font, count);
+    appendU16(font, power * 16);
+    appendU16(font, log2);
+    appendU16(font, count * 16 - power * 16);
+
+    std::size_t offset = 12 + 16 * tables.size();
+    std::size_t headOffset = 0;
+    for (const auto& [tag, data] : tables) {
+        font.append(tag);
+        appendU32(font, tableChecksum(data));
+        appendU32(font, static_cast<std::uint32_t>(offset));
+        appendU32(font, static_cast<std::uint32_t>(data.size()));
+        if (tag == "head") headOffset = offset;
+        offset += (data.size() + 3) / 4 * 4;
+    }
+    for (const auto& [tag, data] : tables) {
+        font.append(data);
+        padTo4(font);
+    }
+    putU32(font, headOffset + 8, 0xB1B0AFBAu - tableChecksum(font));
+    return font;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A TrueType (glyf outline) font file, read far enough to measure text and
+// embed a subset of it in a PDF. CFF-flavoured OpenType (.otf) is not
+// supported; load() fails for it.
+class TrueTypeFont {
+   public:
+    using GlyphId = std::uint16_t;
+
+    bool loadFile(const std::string& path);
+    bool load(std::string bytes);
+    bool valid() const { return glyphCount_ > 0; }
+
+    // 0 (.notdef) if the font has no glyph for the codepoint
+    GlyphId glyphFor(char32_t codepoint) const;
+    // Advance width in font units
+    int advance(GlyphId glyph) const;
+
+    int unitsPerEm() const { return unitsPerEm_; }
+    int ascender() const { return ascender_; }
+    int descender() const { return descender_; }  // Negative
+    int capHeight() const { return capHeight_; }
+    // xMin, yMin, xMax, yMax in font units
+    const int* boundingBox() const { return bbox_; }
+    float italicAngle() const { return italicAngle_; }
+    bool isFixedPitch() const { return fixedPitch_; }
+    std::size_t glyphCount() const { return glyphCount_; }
+    // PostScript name from the name table, or "" if it has none
+    const std::string& postScriptName() const { return postScriptName_; }
+    std::size_t fileSize() const { return data_.size(); }
+
+    // A font file holding only the tables a PDF viewer uses (plus cmap, so
+    // it loads again) and only the outlines of the glyphs marked in used,
+    // .notdef and the parts of composite glyphs. Glyph ids are unchanged,
+    // so text can keep using them; unused glyphs are left empty.
+    std::string subset(const std::vector<bool>& used) const;
+
+   private:
+    struct Table {
+        std::uint32_t offset = 0;
+        std::uint32_t length = 0;
+    };
+
+    std::uint16_t u16(std::size_t offset) const;
+    std::int16_t s16(std::size_t offset) const { return static_cast<std::int16_t>(u16(offset)); }
+    std::uint32_t u32(std::size_t offset) const;
+    const Table* table(const char* tag) const;
+    // Byte range of a glyph's outline within glyf (empty for blank glyphs)
+    Table glyphRange(GlyphId glyph) const;
+    bool readCmap();
+    void readName();
+
+    std::string data_;
+    std::unordered_map<std::uint32_t, Table> tables_;
+    std::unordered_map<char32_t, GlyphId> cmap_;
+    std::size_t glyphCount_ = 0;
+    std::size_t hMetricCount_ = 0;
+    bool longLoca_ = false;
+    int unitsPerEm_ = 1000;
+    int ascender_ = 0;
+    int descender_ = 0;
+    int capHeight_ = 0;
+    int bbox_[4] = {0, 0, 0, 0};
+    float italicAngle_ = 0.0f;
+    bool fixedPitch_ = false;
+    std::string postScriptName_;
+};
@@ -0,0 +1,431 @@
+#include "find_in_files.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <regex>
+
+#include "json_scan.h"
+#include "mapped_file.h"
+
+// ============================================================================
+// Text extraction
+// ============================================================================
+
+namespace {
+
+bool hasExtension(const std::filesystem::path& path,
+                  const std::vector<std::string>& extensions) {
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return std::find(extensions.begin(), extensions.end(), ext) != extensions.end();
+}
+
+bool isWpdocPath(const std::string& path) {
+    std::string ext = std::filesystem::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext == ".wpdoc";
+}
+
+// Same boundary rule as TextBuffer::find (alphanumerics are word characters)
+bool isWordBoundary(std::string_view text, std::size_t pos, bool atStart) {
+    if (atStart) {
+        if (pos == 0) return true;
+        return !std::isalnum(static_cast<unsigned char>(text[pos - 1]));
+    }
+    if (pos >= text.size()) return true;
+    return !std::isalnum(static_cast<unsigned char>(text[pos]));
+}
+
+struct FoldedHash {
+    std::size_t operator()(char c) const {
+        return static_cast<std::size_t>(std::tolower(static_cast<unsigned char>(c)));
+    }
+};
+
+struct FoldedEquals {
+    bool operator()(char a, char b) const {
+        return std::tolower(static_cast<unsigned char>(a)) ==
+               std::tolower(static_cast<unsigned char>(b));
+    }
+};
+
+template <typename Searcher>
+std::size_t searchLiteral(std::string_view text, std::size_t needleLen,
+                          const Searcher& searcher, bool wholeWord,
+                          std::size_t maxMatches, const TextMatchCallback& onMatch) {
+    std::size_t count = 0;
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    const char* cursor = begin;
+    while (count < maxMatches && cursor < end) {
+        auto [first, last] = searcher(cursor, end);
+        if (first == end) break;
+        std::size_t offset = static_cast<std::size_t>(first - begin);
+        if (!wholeWord || (isWordBoundary(text, offset, true) &&
+                           isWordBoundary(text, offset + needleLen, false))) {
+            onMatch(offset, needleLen);
+            ++count;
+        }
+        // Advance by one like TextBuffer::findAll so counts agree
+        cursor = first + 1;
+    }
+    return count;
+}
+
+}  // namespace
+
+std::vector<std::string> collectSearchFiles(const std::string& folder,
+                                            const FindInFilesOptions& options,
+                                            const std::atomic<bool>* cancelled) {
+    std::vector<std::string> files;
+    std::error_code ec;
+    if (!std::filesystem::is_directory(folder, ec)) return files;
+
+    auto consider = [&](const std::filesystem::directory_entry& entry) {
+        std::error_code entryEc;
+        if (entry.is_regular_file(entryEc) && hasExtension(entry.path(), options.extensions)) {
+            files.push_back(entry.path().string());
+        }
+    };
+
+    auto stopped = [cancelled]() {
+        return cancelled && cancelled->load(std::memory_order_relaxed);
+    };
+    auto dirOptions = std::filesystem::directory_options::skip_permission_denied;
+    if (options.recursive) {
+        for (std::filesystem::recursive_directory_iterator it(folder, dirOptions, ec), end;
+             !ec && it != end && !stopped(); it.increment(ec)) {
+            consider(*it);
+        }
+    } else {
+        for (std::filesystem::directory_iterator it(folder, dirOptions, ec), end;
+             !ec && it != end && !stopped(); it.increment(ec)) {
+            consider(*it);
+        }
+    }
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+std::string_view extractSearchableText(const std::string& path, std::string_view raw,
+                                       std::string& scratch) {
+    if (!isWpdocPath(path)) return raw;
+
+    std::size_t valueBegin = 0;
+    std::size_t valueEnd = 0;
+    if (!json_scan::findMember(raw, "text", valueBegin, valueEnd) || raw[valueBegin] != '"') {
+        return raw;
+    }
+    scratch.clear();
+    scratch.reserve(valueEnd - valueBegin);
+    if (json_scan::decodeString(raw, valueBegin, scratch) == json_scan::npos) {
+        return raw;
+    }
+    return scratch;
+}
+
+// ============================================================================
+// Matching
+// ============================================================================
+
+SearchPattern::SearchPattern(const std::string& needle, const FindOptions& options)
+    : needle_(needle), options_(options) {
+    if (needle.empty()) {
+        error_ = "Search term is empty";
+        return;
+    }
+    if (!options.useRegex) return;
+    std::string pattern = options.wholeWord ? ("\\b(?:" + needle + ")\\b") : needle;
+    std::regex_constants::syntax_option_type flags = std::regex_constants::ECMAScript;
+    if (!options.caseSensitive) {
+        flags |= std::regex_constants::icase;
+    }
+    try {
+        regex_.assign(pattern, flags);
+    } catch (const std::regex_error& e) {
+        error_ = std::string("Invalid regular expression: ") + e.what();
+    }
+}
+
+std::size_t SearchPattern::search(std::string_view text, std::size_t maxMatches,
+                                  const TextMatchCallback& onMatch) const {
+    if (!valid() || maxMatches == 0) return 0;
+    const std::string& needle = needle_;
+    const FindOptions& options = options_;
+
+    if (options.useRegex) {
+        std::size_t count = 0;
+        const char* begin = text.data();
+        for (std::cregex_iterator it(begin, begin + text.size(), regex_), end;
+             it != end && count < maxMatches; ++it) {
+            if (it->length() == 0) continue;
+            onMatch(static_cast<std::size_t>(it->position()),
+                    static_cast<std::size_t>(it->length()));
+            ++count;
+        }
+        return count;
+    }
+
+    if (needle.size() > text.size()) return 0;
+
+    if (options.caseSensitive) {
+        std::boyer_moore_horspool_searcher searcher(needle.begin(), needle.end());
+        return searchLiteral(text, needle.size(), searcher, options.wholeWord, maxMatches,
+                             onMatch);
+    }
+    std::boyer_moore_horspool_searcher searcher(needle.begin(), needle.end(), FoldedHash{},
+                                                FoldedEquals{});
+    return searchLiteral(text, needle.size(), searcher, options.wholeWord, maxMatches,
+                         onMatch);
+}
+
+std::size_t searchText(std::string_view text, const std::string& needle,
+                       const FindOptions& options, std::size_t maxMatches,
+                       const TextMatchCallback& onMatch) {
+    return SearchPattern(needle, options).search(text, maxMatches, onMatch);
+}
+
+std::vector<FileMatch> searchFile(const std::string& path, const std::string& needle,
+                                  const FindInFilesOptions& options) {
+    return searchFile(path, SearchPattern(needle, options.find), options);
+}
+
+std::vector<FileMatch> searchFile(const std::string& path, const SearchPattern& pattern,
+                                  const FindInFilesOptions& options) {
+    std::vector<FileMatch> matches;
+    MappedFile file;
+    if (!file.open(path)) return matches;
+
+    std::string scratch;
+    std::string_view text = extractSearchableText(path, file.view(), scratch);
+
+    // Line numbers are computed incrementally: matches arrive in order, so
+    // each newline is counted once no matter how many hits a file has.
+    std::size_t scannedTo = 0;
+    std::size_t line = 0;
+    std::size_t lineStart = 0;
+
+    pattern.search(text, options.maxMatchesPerFile,
+                   [&](std::size_t offset, std::size_t length) {
+                       while (scannedTo < offset) {
+                           const void* nl = std::memchr(text.data() + scannedTo, '\n',
+                                                        offset - scannedTo);
+                           if (!nl) {
+                               scannedTo = offset;
+                               break;
+                           }
+                           ++line;
+                           scannedTo = static_cast<std::size_t>(
+                                           static_cast<const char*>(nl) - text.data()) + 1;
+                           lineStart = scannedTo;
+                       }
+
+                       FileMatch match;
+                       match.path = path;
+                       match.line = line;
+                       match.column = offset - lineStart;
+                       match.offset = offset;
+                       match.length = length;
+
+                       std::size_t lineEnd = text.find('\n', offset);
+                       if (lineEnd == std::string_view::npos) lineEnd = text.size();
+                       // Keep the match visible when the row is longer than the preview
+                       std::size_t previewStart = lineStart;
+                       if (lineEnd - lineStart > options.maxPreviewLength &&
+                           offset - lineStart > options.maxPreviewLength / 2) {
+                           previewStart = offset - options.maxPreviewLength / 2;
+                       }
+                       std::size_t previewLen =
+                           std::min(lineEnd - previewStart, options.maxPreviewLength);
+                       match.preview.assign(text.substr(previewStart, previewLen));
+                       if (!match.preview.empty() && match.preview.back() == '\r') {
+                           match.preview.pop_back();
+                       }
+                       matches.push_back(std::move(match));
+                   });
+    return matches;
+}
+
+// ============================================================================
+// FindInFiles (async)
+// ============================================================================
+
+FindInFiles::~FindInFiles() {
+    cancel();
+    wait();
+}
+
+bool FindInFiles::start(const std::string& folder, const std::string& needle,
+                        const FindInFilesOptions& options) {
+    auto search = std::make_unique<Search>(std::vector<std::string>{}, needle, options);
+    search->folder = folder;
+    search->listFolder = true;
+    return launch(std::move(search));
+}
+
+bool FindInFiles::startFiles(std::vector<std::string> files, const std::string& needle,
+                             const FindInFilesOptions& options) {
+    return launch(std::make_unique<Search>(std::move(files), needle, options));
+}
+
+bool FindInFiles::launch(std::unique_ptr<Search> search) {
+    error_ = search->pattern.error();
+    if (!search->pattern.valid()) return false;
+
+    // Hand the running search (if any) off to finish in the background
+    reapRetired(false);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (current_) {
+            current_->cancelled.store(true, std::memory_order_relaxed);
+            retired_.push_back(std::move(current_));
+        }
+        current_ = std::move(search);
+        pending_.clear();
+        stats_ = FindInFilesStats{};
+        stats_.filesTotal = current_->files.size();
+        startTime_ = std::chrono::steady_clock::now();
+        running_.store(true, std::memory_order_release);
+    }
+
+    Search& started = *current_;
+    started.runner = std::thread([this, &started]() { runSearch(started); });
+    return true;
+}
+
+void FindInFiles::runSearch(Search& search) {
+    if (search.listFolder) {
+        search.files = collectSearchFiles(search.folder, search.options, &search.cancelled);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (&search == current_.get()) stats_.filesTotal = search.files.size();
+    }
+
+    unsigned int threads = search.options.threadCount;
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned int>(
+        std::min<std::size_t>(threads, std::max<std::size_t>(1, search.files.size())));
+
+    // The runner is one of the workers
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned int i = 1; i < threads; ++i) {
+        pool.emplace_back([this, &search]() { workerLoop(search); });
+    }
+    workerLoop(search);
+    for (auto& worker : pool) worker.join();
+    finishSearch(search);
+}
+
+void FindInFiles::workerLoop(Search& search) {
+    while (!search.cancelled.load(std::memory_order_relaxed)) {
+        std::size_t index = search.nextFile.fetch_add(1);
+        if (index >= search.files.size()) break;
+
+        const std::string& path = search.files[index];
+        std::error_code ec;
+        auto size = std::filesystem::file_size(path, ec);
+        bool failed = ec.value() != 0;
+        std::vector<FileMatch> matches;
+        if (!failed) {
+            matches = searchFile(path, search.pattern, search.options);
+        }
+
+        if (!matches.empty() && fileCallback_ && !search.cancelled.load()) {
+            fileCallback_(matches);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (&search != current_.get()) break;  // Replaced by a newer search
+        stats_.filesSearched++;
+        if (failed) {
+            stats_.filesFailed++;
+        } else {
+            stats_.bytesScanned += static_cast<std::size_t>(size);
+        }
+        if (!matches.empty()) {
+            stats_.filesWithMatches++;
+            stats_.matches += matches.size();
+            pending_.insert(pending_.end(), std::make_move_iterator(matches.begin()),
+                            std::make_move_iterator(matches.end()));
+        }
+    }
+}
+
+void FindInFiles::finishSearch(Search& search) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (&search == current_.get()) {
+            stats_.elapsedMs = std::chrono::duration<double, std::milli>(
+                                   std::chrono::steady_clock::now() - startTime_)
+                                   .count();
+            running_.store(false, std::memory_order_release);
+        }
+    }
+    search.finished.store(true, std::memory_order_release);
+}
+
+void FindInFiles::cancel() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (current_) current_->cancelled.store(true, std::memory_order_relaxed);
+}
+
+bool FindInFiles::wasCancelled() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_ && current_->cancelled.load(std::memory_order_relaxed);
+}
+
+void FindInFiles::wait() {
+    if (current_ && current_->runner.joinable()) current_->runner.join();
+    reapRetired(true);
+}
+
+void FindInFiles::reapRetired(bool all) {
+    std::erase_if(retired_, [all](const std::unique_ptr<Search>& search) {
+        if (!all && !search->finished.load(std::memory_order_acquire)) return false;
+        if (search->runner.joinable()) search->runner.join();
+        return true;
+    });
+}
+
+std::size_t FindInFiles::drainResults(std::vector<FileMatch>& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t count = pending_.size();
+    out.insert(out.end(), std::make_move_iterator(pending_.begin()),
+               std::make_move_iterator(pending_.end()));
+    pending_.clear();
+    return count;
+}
+
+FindInFilesStats FindInFiles::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FindInFilesStats result = stats_;
+    if (isRunning()) {
+        result.elapsedMs = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - startTime_)
+                               .count();
+    }
+    return result;
+}
+
+std::vector<FileMatch> findInFiles(const std::string& folder, const std::string& needle,
+                                   const FindInFilesOptions& options,
+                                   FindInFilesStats* outStats) {
+    FindInFiles search;
+    std::vector<FileMatch> results;
+    if (search.start(folder, needle, options)) {
+        search.wait();
+        search.drainResults(results);
+    }
+    std::sort(results.begin(), results.end(), [](const FileMatch& a, const FileMatch& b) {
+        if (a.path != b.path) return a.path < b.path;
+        return a.offset < b.offset;
+    });
+    if (outStats) *outStats = search.stats();
+    return results;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "text_buffer.h"  // FindOptions
+
+// A single hit from a Find in Files search
+struct FileMatch {
+    std::string path;
+    std::size_t line = 0;     // 0-based row in the document text
+    std::size_t column = 0;   // 0-based byte column within the row
+    std::size_t offset = 0;   // Byte offset into the document text
+    std::size_t length = 0;   // Length of the match in bytes
+    std::string preview;      // Text of the matching row (truncated)
+};
+
+struct FindInFilesOptions {
+    // caseSensitive, wholeWord and useRegex are honoured; wrapAround is ignored
+    FindOptions find;
+    std::vector<std::string> extensions = {".wpdoc", ".txt", ".md"};
+    bool recursive = true;
+    std::size_t maxMatchesPerFile = 1000;
+    std::size_t maxPreviewLength = 160;
+    unsigned int threadCount = 0;  // 0 = std::thread::hardware_concurrency()
+};
+
+struct FindInFilesStats {
+    std::size_t filesTotal = 0;
+    std::size_t filesSearched = 0;
+    std::size_t filesWithMatches = 0;
+    std::size_t filesFailed = 0;
+    std::size_t matches = 0;
+    std::size_t bytesScanned = 0;
+    double elapsedMs = 0.0;
+};
+
+// List the files under folder whose extension is in options.extensions,
+// sorted by path so results are reproducible. The walk stops early once
+// *cancelled is set.
+std::vector<std::string> collectSearchFiles(const std::string& folder,
+                                            const FindInFilesOptions& options = {},
+                                            const std::atomic<bool>* cancelled = nullptr);
+
+// Return the searchable document text for a file's raw bytes.
+// For .wpdoc the "text" member is decoded into scratch without building a
+// JSON DOM; anything else (or a .wpdoc that fails to scan, matching the
+// plain-text fallback in loadDocumentEx) is searched as-is with no copy.
+std::string_view extractSearchableText(const std::string& path, std::string_view raw,
+                                       std::string& scratch);
+
+using TextMatchCallback = std::function<void(std::size_t offset, std::size_t length)>;
+
+// A needle made ready for searching. A regular expression is compiled once
+// here, so one pattern serves every file of a search and can be shared by
+// its worker threads (search() is const).
+class SearchPattern {
+   public:
+    SearchPattern(const std::string& needle, const FindOptions& options);
+
+    // False (with error()) for an empty needle or an invalid expression
+    bool valid() const { return error_.empty(); }
+    const std::string& error() const { return error_; }
+
+    // Find matches in text, calling onMatch(offset, length) for each in
+    // order. Returns the number of matches (capped at maxMatches).
+    std::size_t search(std::string_view text, std::size_t maxMatches,
+                       const TextMatchCallback& onMatch) const;
+
+   private:
+    std::string needle_;
+    FindOptions options_;
+    std::regex regex_;
+    std::string error_;
+};
+
+// One-off search of text (compiles the pattern for this call)
+std::size_t searchText(std::string_view text, const std::string& needle,
+                       const FindOptions& options, std::size_t maxMatches,
+                       const TextMatchCallback& onMatch);
+
+// Search one file synchronously
+std::vector<FileMatch> searchFile(const std::string& path, const SearchPattern& pattern,
+                                  const FindInFilesOptions& options = {});
+std::vector<FileMatch> searchFile(const std::string& path, const std::string& needle,
+                                  const FindInFilesOptions& options = {});
+
+// Asynchronous multi-file search.
+// The folder is listed on the search's own thread, so start() returns at
+// once even for a large tree; filesTotal is filled in when the listing is
+// done. Files are memory-mapped and searched on a pool of worker threads. Matches
+// are queued as each file completes so the UI can poll drainResults() every
+// frame and show hits while the search is still running.
+//
+// Starting again while a search runs replaces it without waiting: the old
+// workers stop after their current file, their results are dropped, and
+// they are joined by a later start() once they have finished (or by the
+// destructor).
+class FindInFiles {
+   public:
+    // Invoked on a worker thread once per file that has matches
+    using FileResultCallback = std::function<void(const std::vector<FileMatch>&)>;
+
+    FindInFiles() = default;
+    ~FindInFiles();
+
+    FindInFiles(const FindInFiles&) = delete;
+    FindInFiles& operator=(const FindInFiles&) = delete;
+
+    // Start searching every matching file in folder, replacing any search
+    // still running. Returns false (and sets error()) if the pattern is
+    // invalid; the folder itself is listed on the search thread.
+    bool start(const std::string& folder, const std::string& needle,
+               const FindInFilesOptions& options = {});
+    bool startFiles(std::vector<std::string> files, const std::string& needle,
+                    const FindInFilesOptions& options = {});
+
+    // Optional streaming hook; must be set before start()
+    void setFileResultCallback(FileResultCallback callback) {
+        fileCallback_ = std::move(callback);
+    }
+
+    // Request workers to stop after their current file
+    void cancel();
+    // Block until all workers, including replaced searches', have finished
+    void wait();
+
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+    bool wasCancelled() const;
+    const std::string& error() const { return error_; }
+
+    // Move matches found since the last call into out (appends).
+    // Returns the number of matches moved.
+    std::size_t drainResults(std::vector<FileMatch>& out);
+
+    FindInFilesStats stats() const;
+
+   private:
+    // One started search, owned here and read by its threads until the
+    // runner is joined
+    struct Search {
+        Search(std::vector<std::string> files, const std::string& needle,
+               const FindInFilesOptions& options)
+            : files(std::move(files)), pattern(needle, options.find), options(options) {}
+
+        std::string folder;
+        bool listFolder = false;         // files comes from listing folder on the runner
+        std::vector<std::string> files;  // Written only before the workers start
+        SearchPattern pattern;
+        FindInFilesOptions options;
+        std::thread runner;  // Lists the folder, then runs and joins the workers
+        std::atomic<std::size_t> nextFile{0};
+        std::atomic<bool> cancelled{false};
+        std::atomic<bool> finished{false};
+    };
+
+    bool launch(std::unique_ptr<Search> search);
+    void runSearch(Search& search);
+    void workerLoop(Search& search);
+    void finishSearch(Search& search);
+    // Join the runners of replaced searches; only those already finished
+    // unless all is set
+    void reapRetired(bool all);
+
+    FileResultCallback fileCallback_;
+    std::string error_;
+
+    std::unique_ptr<Search> current_;
+    std::vector<std::unique_ptr<Search>> retired_;  // Replaced, runner not yet joined
+    std::atomic<bool> running_{false};
+
+    mutable std::mutex mutex_;  // Guards current_ (for workers), pending_ and stats_
+    std::vector<FileMatch> pending_;
+    FindInFilesStats stats_;
+    std::chrono::steady_clock::time_point startTime_;
+};
+
+// Blocking convenience wrapper: search folder and return all matches sorted
+// by (path, offset).
+std::vector<FileMatch> findInFiles(const std::string& folder, const std::string& needle,
+                                   const FindInFilesOptions& options = {},
+                                   FindInFilesStats* outStats = nullptr);
@@ -0,0 +1,441 @@
+#include "flate.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace flate {
+
+namespace {
+
+constexpr std::size_t kWindowSize = 32768;
+constexpr std::size_t kMinMatch = 3;
+constexpr std::size_t kMaxMatch = 258;
+constexpr int kHashBits = 15;
+constexpr int kMaxChain = 64;
+constexpr std::size_t kMaxStoredBlock = 65535;
+
+constexpr std::array<std::uint16_t, 29> kLengthBase = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+constexpr std::array<std::uint8_t, 29> kLengthExtra = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+constexpr std::array<std::uint16_t, 30> kDistanceBase = {
+    1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+constexpr std::array<std::uint8_t, 30> kDistanceExtra = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+std::uint32_t adler32(std::string_view data) {
+    std::uint32_t a = 1;
+    std::uint32_t b = 0;
+    std::size_t pos = 0;
+    while (pos < data.size()) {
+        // 5552 bytes is the most that can be summed before b overflows
+        std::size_t end = std::min(data.size(), pos + 5552);
+        for (; pos < end; ++pos) {
+            a += static_cast<unsigned char>(data[pos]);
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+// ============================================================================
+// Compression
+// ============================================================================
+
+// Bits go out least significant first; Huffman codes are reversed so they
+// read most significant first, as the format requires
+class BitWriter {
+   public:
+    explicit BitWriter(std::string& out) : out_(out) {}
+
+    void put(std::uint32_t value, int count) {
+        bits_ |= static_cast<std::uint64_t>(value) << count_;
+        count_ += count;
+        while (count_ >= 8) {
+            out_.push_back(static_cast<char>(bits_ & 0xFF));
+            bits_ >>= 8;
+            count_ -= 8;
+        }
+    }
+
+    void putCode(std::uint32_t code, int length) {
+        std::uint32_t reversed = 0;
+        for (int i = 0; i < length; ++i) {
+            reversed = (reversed << 1) | (code & 1);
+            code >>= 1;
+        }
+        put(reversed, length);
+    }
+
+    void flush() {
+        if (count_ > 0) out_.push_back(static_cast<char>(bits_ & 0xFF));
+        bits_ = 0;
+        count_ = 0;
+    }
+
+   private:
+    std::string& out_;
+    std::uint64_t bits_ = 0;
+    int count_ = 0;
+};
+
+// Fixed literal/length code (RFC 1951 3.2.6)
+void putSymbol(BitWriter& bits, std::uint32_t symbol) {
+    if (symbol < 144) {
+        bits.putCode(0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        bits.putCode(0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        bits.putCode(symbol - 256, 7);
+    } else {
+        bits.putCode(0xC0 + symbol - 280, 8);
+    }
+}
+
+void putMatch(BitWriter& bits, std::size_t length, std::size_t distance) {
+    std::size_t lengthCode = 0;
+    while (lengthCode + 1 < kLengthBase.size() && kLengthBase[lengthCode + 1] <= length) {
+        ++lengthCode;
+    }
+    putSymbol(bits, static_cast<std::uint32_t>(257 + lengthCode));
+    bits.put(static_cast<std::uint32_t>(length - kLengthBase[lengthCode]),
+             kLengthExtra[lengthCode]);
+
+    std::size_t distanceCode = 0;
+    while (distanceCode + 1 < kDistanceBase.size() &&
+           kDistanceBase[distanceCode + 1] <= distance) {
+        ++distanceCode;
+    }
+    bits.putCode(static_cast<std::uint32_t>(distanceCode), 5);
+    bits.put(static_cast<std::uint32_t>(distance - kDistanceBase[distanceCode]),
+             kDistanceExtra[distanceCode]);
+}
+
+std::uint32_t hash3(const unsigned char* p) {
+    std::uint32_t sequence = (std::uint32_t{p[0]} << 16) | (std::uint32_t{p[1]} << 8) | p[2];
+    return (sequence * 2654435761u) >> (32 - kHashBits);
+}
+
+void compressFixed(std::string_view input, std::string& out) {
+    const auto* in = reinterpret_cast<const unsigned char*>(input.data());
+    const std::size_t size = input.size();
+    std::vector<std::int64_t> head(std::size_t{1} << kHashBits, -1);
+    std::vector<std::int64_t> prev(kWindowSize, -1);
+    auto insert = [&](std::size_t pos) {
+        if (pos + kMinMatch > size) return;
+        std::uint32_t hash = hash3(in + pos);
+        prev[pos & (kWindowSize - 1)] = head[hash];
+        head[hash] = static_cast<std::int64_t>(pos);
+    };
+
+    BitWriter bits(out);
+    bits.put(1, 1);  // Final block
+    bits.put(1, 2);  // Fixed Huffman codes
+    std::size_t pos = 0;
+    while (pos < size) {
+        std::size_t bestLength = 0;
+        std::size_t bestDistance = 0;
+        if (pos + kMinMatch <= size) {
+            std::size_t maxLength = std::min(kMaxMatch, size - pos);
+            std::int64_t candidate = head[hash3(in + pos)];
+            for (int chain = 0; candidate >= 0 && chain < kMaxChain; ++chain) {
+                auto from = static_cast<std::size_t>(candidate);
+                std::size_t distance = pos - from;
+                if (distance >= kWindowSize) break;
+                std::size_t length = 0;
+                while (length < maxLength && in[from + length] == in[pos + length]) ++length;
+                if (length > bestLength) {
+                    bestLength = length;
+                    bestDistance = distance;
+                    if (length == maxLength) break;
+                }
+                std::int64_t next = prev[from & (kWindowSize - 1)];
+                if (next >= candidate) break;  // Slot reused by a newer position
+                candidate = next;
+            }
+        }
+        if (bestLength >= kMinMatch) {
+            putMatch(bits, bestLength, bestDistance);
+            for (std::size_t i = 0; i < bestLength; ++i) insert(pos + i);
+            pos += bestLength;
+        } else {
+            putSymbol(bits, in[pos]);
+            insert(pos);
+            ++pos;
+        }
+    }
+    putSymbol(bits, 256);  // End of block
+    bits.flush();
+}
+
+void compressStored(std::string_view input, std::string& out) {
+    std::size_t pos = 0;
+    do {
+        std::size_t length = std::min(kMaxStoredBlock, input.size() - pos);
+        bool last = pos + length == input.size();
+        out.push_back(last ? 1 : 0);  // Block header, padded to the byte
+        out.push_back(static_cast<char>(length & 0xFF));
+        out.push_back(static_cast<char>(length >> 8));
+        out.push_back(static_cast<char>(~length & 0xFF));
+        out.push_back(static_cast<char>((~length >> 8) & 0xFF));
+        out.append(input.substr(pos, length));
+        pos += length;
+    } while (pos < input.size());
+}
+
+// ============================================================================
+// Decompression
+// ============================================================================
+
+class BitReader {
+   public:
+    explicit BitReader(std::string_view in) : in_(in) {}
+
+    std::uint32_t bits(int count) {
+        std::uint64_t value = bits_;
+        while (count_ < count) {
+            if (pos_ >= in_.size()) {
+                overrun_ = true;
+                return 0;
+            }
+            value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in_[pos_++]))
+                     << count_;
+            count_ += 8;
+        }
+        bits_ = value >> count;
+        count_ -= count;
+        return static_cast<std::uint32_t>(value & ((std::uint64_t{1} << count) - 1));
+    }
+
+    // Skip to the next byte boundary and hand over raw bytes
+    bool bytes(std::size_t length, std::string_view& out) {
+        bits_ = 0;
+        count_ = 0;
+        if (in_.size() - pos_ < length) return false;
+        out = in_.substr(pos_, length);
+        pos_ += length;
+        return true;
+    }
+
+    bool overrun() const { return overrun_; }
+
+   private:
+    std::string_view in_;
+    std::size_t pos_ = 0;
+    std::uint64_t bits_ = 0;
+    int count_ = 0;
+    bool overrun_ = false;
+};
+
+// Canonical Huffman decoding table: how many codes of each length, and the
+// symbols in code order
+struct Huffman {
+    std::array<std::uint16_t, 16> count{};
+    std::vector<std::uint16_t> symbol;
+
+    // Returns 0 for a complete code, > 0 for an incomplete one and < 0 if
+    // the lengths are over-subscribed
+    int build(const std::uint8_t* lengths, std::size_t n) {
+        count.fill(0);
+        for (std::size_t i = 0; i < n; ++i) count[lengths[i]]++;
+        if (count[0] == n) return 0;
+        int left = 1;
+        for (std::size_t len = 1; len < 16; ++len) {
+            left <<= 1;
+            left -= count[len];
+            if (left < 0) return left;
+        }
+        std::array<std::uint16_t, 16> offsets{};
+        for (std::size_t len = 1; len < 15; ++len) {
+            offsets[len + 1] = static_cast<std::uint16_t>(offsets[len] + count[len]);
+        }
+        symbol.assign(n, 0);
+        for (std::size_t i = 0; i < n; ++i) {
+            if (lengths[i] != 0) symbol[offsets[lengths[i]]++] = static_cast<std::uint16_t>(i);
+        }
+        return left;
+    }
+
+    int decode(BitReader& in) const {
+        int code = 0;
+        int first = 0;
+        int index = 0;
+        for (std::size_t len = 1; len < 16; ++len) {
+            code |= static_cast<int>(in.bits(1));
+            int n = count[len];
+            if (code - n < first) return symbol[static_cast<std::size_t>(index + (code - first))];
+            index += n;
+            first = (first + n) << 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+};
+
+// Output past `end` (an absolute size of out) fails the stream as soon as
+// it is produced, so a small input cannot expand without bound
+bool inflateCodes(BitReader& in, std::string& out, std::size_t start, std::size_t end,
+                  const Huffman& lengths, const Huffman& distances) {
+    while (true) {
+        int symbol = lengths.decode(in);
+        if (symbol < 0 || in.overrun()) return false;
+        if (symbol < 256) {
+            if (out.size() >= end) return false;
+            out.push_back(static_cast<char>(symbol));
+            continue;
+        }
+        if (symbol == 256) return true;
+        auto lengthCode = static_cast<std::size_t>(symbol - 257);
+        if (lengthCode >= kLengthBase.size()) return false;
+        std::size_t length = kLengthBase[lengthCode] + in.bits(kLengthExtra[lengthCode]);
+        int distanceCode = distances.decode(in);
+        if (distanceCode < 0 || distanceCode >= static_cast<int>(kDistanceBase.size())) {
+            return false;
+        }
+        auto code = static_cast<std::size_t>(distanceCode);
+        std::size_t distance = kDistanceBase[code] + in.bits(kDistanceExtra[code]);
+        if (in.overrun() || distance > out.size() - start) return false;
+        if (length > end - out.size()) return false;
+        // Byte by byte: the source may overlap what is being written
+        std::size_t from = out.size() - distance;
+        for (std::size_t i = 0; i < length; ++i) out.push_back(out[from + i]);
+    }
+}
+
+bool inflateFixed(BitReader& in, std::string& out, std::size_t start, std::size_t end) {
+    static const std::pair<Huffman, Huffman> tables = [] {
+        std::array<std::uint8_t, 288> lengths{};
+        for (std::size_t i = 0; i < 288; ++i) {
+            lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+        }
+        std::array<std::uint8_t, 30> distances;
+        distances.fill(5);
+        std::pair<Huffman, Huffman> result;
+        result.first.build(lengths.data(), lengths.size());
+        result.second.build(distances.data(), distances.size());
+        return result;
+    }();
+    return inflateCodes(in, out, start, end, tables.first, tables.second);
+}
+
+bool inflateDynamic(BitReader& in, std::string& out, std::size_t start, std::size_t end) {
+    static constexpr std::array<std::uint8_t, 19> kOrder = {16, 17, 18, 0, 8,  7, 9,  6, 10, 5,
+                                                            11, 4,  12, 3, 13, 2, 14, 1, 15};
+    std::size_t lengthCount = in.bits(5) + 257;
+    std::size_t distanceCount = in.bits(5) + 1;
+    std::size_t codeCount = in.bits(4) + 4;
+    if (lengthCount > 286 || distanceCount > 30) return false;
+
+    std::array<std::uint8_t, 320> lengths{};
+    for (std::size_t i = 0; i < codeCount; ++i) {
+        lengths[kOrder[i]] = static_cast<std::uint8_t>(in.bits(3));
+    }
+    Huffman codeLengths;
+    if (codeLengths.build(lengths.data(), 19) != 0) return false;
+
+    // Literal/length and distance code lengths, run-length coded
+    std::size_t index = 0;
+    while (index < lengthCount + distanceCount) {
+        int symbol = codeLengths.decode(in);
+        if (symbol < 0 || in.overrun()) return false;
+        if (symbol < 16) {
+            lengths[index++] = static_cast<std::uint8_t>(symbol);
+            continue;
+        }
+        std::uint8_t value = 0;
+        std::size_t repeat = 0;
+        if (symbol == 16) {
+            if (index == 0) return false;
+            value = lengths[index - 1];
+            repeat = 3 + in.bits(2);
+        } else if (symbol == 17) {
+            repeat = 3 + in.bits(3);
+        } else {
+            repeat = 11 + in.bits(7);
+        }
+        if (index + repeat > lengthCount + distanceCount) return false;
+        while (repeat-- > 0) lengths[index++] = value;
+    }
+    if (lengths[256] == 0) return false;  // No end-of-block code
+
+    // Incomplete codes are only allowed when a single code is in use
+    Huffman literals;
+    int left = literals.build(lengths.data(), lengthCount);
+    if (left < 0 || (left > 0 && lengthCount - literals.count[0] != 1)) return false;
+    Huffman distances;
+    left = distances.build(lengths.data() + lengthCount, distanceCount);
+    if (left < 0 || (left > 0 && distanceCount - distances.count[0] != 1)) return false;
+    return inflateCodes(in, out, start, end, literals, distances);
+}
+
+}  // namespace
+
+std::string compress(std::string_view input) {
+    std::string out;
+    out.reserve(input.size() / 2 + 64);
+    out.push_back(static_cast<char>(0x78));  // Deflate, 32 KB window
+    out.push_back(static_cast<char>(0x9C));  // Default level; header % 31 == 0
+    compressFixed(input, out);
+    if (out.size() > input.size() + 2 + (input.size() / kMaxStoredBlock + 1) * 5) {
+        out.resize(2);
+        compressStored(input, out);
+    }
+    std::uint32_t checksum = adler32(input);
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<char>((checksum >> shift) & 0xFF));
+    }
+    return out;
+}
+
+bool decompress(std::string_view input, std::string& out) {
+    if (input.size() < 6) return false;
+    auto cmf = static_cast<unsigned char>(input[0]);
+    auto flags = static_cast<unsigned char>(input[1]);
+    if ((cmf & 0x0F) != 8 || ((cmf << 8) | flags) % 31 != 0) return false;
+    if (flags & 0x20) return false;  // Preset dictionaries are not used by anything we read
+
+    std::size_t start = out.size();
+    if (!inflate(input.substr(2, input.size() - 6), out)) return false;
+    std::uint32_t expected = 0;
+    for (std::size_t i = input.size() - 4; i < input.size(); ++i) {
+        expected = (expected << 8) | static_cast<unsigned char>(input[i]);
+    }
+    return adler32(std::string_view(out).substr(start)) == expected;
+}
+
+bool inflate(std::string_view input, std::string& out, std::size_t maxOutput) {
+    BitReader in(input);
+    std::size_t start = out.size();
+    std::size_t end = maxOutput > out.max_size() - start ? out.max_size() : start + maxOutput;
+    bool last = false;
+    while (!last) {
+        last = in.bits(1) != 0;
+        std::uint32_t type = in.bits(2);
+        if (in.overrun()) return false;
+        if (type == 0) {
+            std::string_view header;
+            if (!in.bytes(4, header)) return false;
+            auto byte = [&](std::size_t i) { return static_cast<unsigned char>(header[i]); };
+            std::size_t length = byte(0) | (byte(1) << 8);
+            std::size_t check = byte(2) | (byte(3) << 8);
+            if (length != (~check & 0xFFFF)) return false;
+            std::string_view data;
+            if (!in.bytes(length, data) || length > end - out.size()) return false;
+            out.append(data);
+        } else if (type == 1) {
+            if (!inflateFixed(in, out, start, end)) return false;
+        } else if (type == 2) {
+            if (!inflateDynamic(in, out, start, end)) return false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace flate
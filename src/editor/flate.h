@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <string_view>
+
+// Deflate (RFC 1951) and its zlib wrapper (RFC 1950), for the formats that
+// require them: PDF FlateDecode streams on the way out, zip-based documents
+// on the way in.
+//
+// compress() finds matches with hash chains over the 32 KB window and
+// codes them with the fixed Huffman tables (one block, or stored blocks if
+// that would not be smaller). That is a good deal simpler than building
+// per-block trees and gives most of the ratio on text and font data.
+// inflate() decodes all three block types.
+namespace flate {
+
+// zlib stream: 2-byte header, deflate data, Adler-32 of the input
+std::string compress(std::string_view input);
+
+// Decode a zlib stream into out. Returns false on malformed input or a
+// checksum mismatch.
+bool decompress(std::string_view input, std::string& out);
+
+// Decode raw deflate data (as stored in zip entries), appending to out.
+// Returns false on malformed input, or as soon as more than maxOutput
+// bytes would be appended.
+bool inflate(std::string_view input, std::string& out,
+             std::size_t maxOutput = std::numeric_limits<std::size_t>::max());
+
+}  // namespace flate
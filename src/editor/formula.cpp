@@ -0,0 +1,736 @@
+#include "formula.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <unordered_set>
+
+namespace formula {
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+bool sameName(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return std::toupper(static_cast<unsigned char>(x)) ==
+                      std::toupper(static_cast<unsigned char>(y));
+           });
+}
+
+}  // namespace
+
+const char* errorText(Error error) {
+    switch (error) {
+        case Error::None: return "";
+        case Error::Value: return "#VALUE!";
+        case Error::DivideByZero: return "#DIV/0!";
+        case Error::Reference: return "#REF!";
+        case Error::Name: return "#NAME?";
+        case Error::Syntax: return "#ERROR!";
+        case Error::Cycle: return "#CYCLE!";
+    }
+    return "";
+}
+
+Value valueOfText(std::string_view text) {
+    text = trim(text);
+    if (text.empty()) return {};
+    double number = 0.0;
+    const char* end = text.data() + text.size();
+    auto [ptr, ec] = std::from_chars(text.data(), end, number);
+    if (ec == std::errc() && ptr == end) return Value::ofNumber(number);
+    if (text.front() == '#') {
+        for (Error error : {Error::Value, Error::DivideByZero, Error::Reference, Error::Name,
+                            Error::Syntax, Error::Cycle}) {
+            if (text == errorText(error)) return Value::ofError(error);
+        }
+    }
+    return {Value::Kind::Text, 0.0, Error::None};
+}
+
+std::string format(const Value& value) {
+    switch (value.kind) {
+        case Value::Kind::Blank:
+        case Value::Kind::Text: return {};
+        case Value::Kind::Error: return errorText(value.error);
+        case Value::Kind::Number: break;
+    }
+    // Avoid printing "-0" for results like -1 * 0
+    double number = value.number == 0.0 ? 0.0 : value.number;
+    char text[32];
+    int length = std::snprintf(text, sizeof(text), "%.15g", number);
+    return std::string(text, static_cast<std::size_t>(std::max(length, 0)));
+}
+
+// ============================================================================
+// Compiler: recursive descent straight to stack code
+// ============================================================================
+
+class Compiler {
+   public:
+    Compiler(std::string_view source, Program& program) : source_(source), program_(program) {}
+
+    bool run(std::string* message) {
+        skipSpace();
+        if (peek() == '=') {
+            ++pos_;
+            skipSpace();
+        }
+        if (atEnd()) fail(Error::Syntax, "Empty formula");
+        if (ok()) expression();
+        skipSpace();
+        if (ok() && !atEnd()) fail(Error::Syntax, "Unexpected '" + std::string(1, peek()) + "'");
+        if (!ok()) {
+            program_.code_.clear();
+            program_.numbers_.clear();
+            program_.references_.clear();
+            program_.written_.clear();
+            program_.error_ = error_;
+            if (message) *message = message_;
+            return false;
+        }
+        return true;
+    }
+
+   private:
+    using Op = Program::Op;
+    using Function = Program::Function;
+
+    bool ok() const { return error_ == Error::None; }
+    bool atEnd() const { return pos_ >= source_.size(); }
+    char peek() const { return atEnd() ? '\0' : source_[pos_]; }
+
+    void skipSpace() {
+        while (!atEnd() && std::isspace(static_cast<unsigned char>(source_[pos_]))) ++pos_;
+    }
+
+    void fail(Error error, std::string message) {
+        if (!ok()) return;
+        error_ = error;
+        message_ = std::move(message);
+    }
+
+    void emit(Op op, std::uint32_t operand = 0) {
+        program_.code_.push_back({op, Function::Sum, 0, operand});
+    }
+
+    bool accept(char c) {
+        skipSpace();
+        if (peek() != c) return false;
+        ++pos_;
+        return true;
+    }
+
+    void expression() {
+        term();
+        while (ok()) {
+            if (accept('+')) {
+                term();
+                emit(Op::Add);
+            } else if (accept('-')) {
+                term();
+                emit(Op::Sub);
+            } else {
+                break;
+            }
+        }
+    }
+
+    void term() {
+        unary();
+        while (ok()) {
+            if (accept('*')) {
+                unary();
+                emit(Op::Mul);
+            } else if (accept('/')) {
+                unary();
+                emit(Op::Div);
+            } else {
+                break;
+            }
+        }
+    }
+
+    void unary() {
+        if (accept('-')) {
+            unary();
+            emit(Op::Neg);
+        } else if (accept('+')) {
+            unary();
+        } else {
+            power();
+        }
+    }
+
+    void power() {
+        primary();
+        if (ok() && accept('^')) {
+            unary();  // Right associative: 2^3^2 is 2^(3^2)
+            emit(Op::Pow);
+        }
+    }
+
+    void primary() {
+        skipSpace();
+        char c = peek();
+        if (c == '(') {
+            ++pos_;
+            expression();
+            if (ok() && !accept(')')) fail(Error::Syntax, "Missing ')'");
+            return;
+        }
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            number();
+            return;
+        }
+        if (c == '#' && sameName(source_.substr(pos_, 5), "#REF!")) {
+            pos_ += 5;
+            emit(Op::RefError);
+            return;
+        }
+        if (std::isalpha(static_cast<unsigned char>(c)) || c == '$') {
+            std::size_t start = pos_;
+            Program::Corner cell;
+            if (reference(cell)) {
+                std::size_t end = pos_;
+                skipSpace();
+                if (peek() == ':') {
+                    fail(Error::Syntax, "Ranges are only allowed as function arguments");
+                    return;
+                }
+                emit(Op::Cell, addReference({start, end, cell, cell, false}));
+                return;
+            }
+            pos_ = start;
+            call();
+            return;
+        }
+        fail(Error::Syntax, atEnd() ? "Unexpected end of formula"
+                                    : "Unexpected '" + std::string(1, c) + "'");
+    }
+
+    void number() {
+        const char* begin = source_.data() + pos_;
+        const char* end = source_.data() + source_.size();
+        double value = 0.0;
+        auto [ptr, ec] = std::from_chars(begin, end, value);
+        if (ec != std::errc()) {
+            fail(Error::Syntax, "Bad number");
+            return;
+        }
+        pos_ += static_cast<std::size_t>(ptr - begin);
+        emit(Op::Number, static_cast<std::uint32_t>(program_.numbers_.size()));
+        program_.numbers_.push_back(value);
+    }
+
+    // A1-style reference ($ allowed before either part). Leaves pos_ after
+    // it and returns true, or returns false with pos_ unspecified.
+    bool reference(Program::Corner& out) {
+        out.absoluteCol = peek() == '$';
+        if (out.absoluteCol) ++pos_;
+        std::size_t col = 0;
+        std::size_t letters = 0;
+        while (std::isalpha(static_cast<unsigned char>(peek())) && letters < 4) {
+            col = col * 26 + static_cast<std::size_t>(
+                                 std::toupper(static_cast<unsigned char>(peek())) - 'A' + 1);
+            ++pos_;
+            ++letters;
+        }
+        if (letters == 0 || letters > 3) return false;
+        out.absoluteRow = peek() == '$';
+        if (out.absoluteRow) ++pos_;
+        std::size_t row = 0;
+        std::size_t digits = 0;
+        while (std::isdigit(static_cast<unsigned char>(peek())) && digits < 8) {
+            row = row * 10 + static_cast<std::size_t>(peek() - '0');
+            ++pos_;
+            ++digits;
+        }
+        if (digits == 0 || digits > 7 || row == 0) return false;
+        // "A1(" or "A1B" is a name, not a reference
+        char next = peek();
+        if (std::isalnum(static_cast<unsigned char>(next)) || next == '(' || next == '_') {
+            return false;
+        }
+        out.row = row - 1;
+        out.col = col - 1;
+        return true;
+    }
+
+    std::uint32_t addReference(const Program::Written& written) {
+        program_.references_.push_back({std::min(written.first.row, written.last.row),
+                                        std::min(written.first.col, written.last.col),
+                                        std::max(written.first.row, written.last.row),
+                                        std::max(written.first.col, written.last.col)});
+        program_.written_.push_back(written);
+        return static_cast<std::uint32_t>(program_.references_.size() - 1);
+    }
+
+    void call() {
+        std::size_t start = pos_;
+        while (std::isalnum(static_cast<unsigned char>(peek())) || peek() == '_') ++pos_;
+        std::string_view name = source_.substr(start, pos_ - start);
+
+        static constexpr std::pair<std::string_view, Function> FUNCTIONS[] = {
+            {"SUM", Function::Sum},     {"AVERAGE", Function::Average},
+            {"MIN", Function::Min},     {"MAX", Function::Max},
+            {"COUNT", Function::Count}, {"PRODUCT", Function::Product},
+            {"ABS", Function::Abs},     {"ROUND", Function::Round},
+        };
+        const Function* function = nullptr;
+        for (const auto& [known, value] : FUNCTIONS) {
+            if (sameName(name, known)) function = &value;
+        }
+        if (!function) {
+            fail(Error::Name, "Unknown name: " + std::string(name));
+            return;
+        }
+        if (!accept('(')) {
+            fail(Error::Syntax, "Expected '(' after " + std::string(name));
+            return;
+        }
+
+        std::size_t argc = 0;
+        if (!accept(')')) {
+            do {
+                argument();
+                ++argc;
+            } while (ok() && (accept(',') || accept(';')));
+            if (ok() && !accept(')')) fail(Error::Syntax, "Missing ')'");
+        }
+        if (!ok()) return;
+
+        std::size_t minArgs = 1;
+        std::size_t maxArgs = 255;
+        if (*function == Function::Abs) maxArgs = 1;
+        if (*function == Function::Round) maxArgs = 2;
+        if (argc < minArgs || argc > maxArgs) {
+            fail(Error::Syntax, "Wrong number of arguments to " + std::string(name));
+            return;
+        }
+        program_.code_.push_back(
+            {Op::Call, *function, static_cast<std::uint16_t>(argc), 0});
+    }
+
+    // A range (A1:B5) or any expression
+    void argument() {
+        skipSpace();
+        std::size_t start = pos_;
+        Program::Corner first;
+        Program::Corner last;
+        if (reference(first)) {
+            skipSpace();
+            if (peek() == ':') {
+                ++pos_;
+                skipSpace();
+                if (!reference(last)) {
+                    fail(Error::Syntax, "Bad range");
+                    return;
+                }
+                emit(Op::Range, addReference({start, pos_, first, last, true}));
+                return;
+            }
+        }
+        pos_ = start;
+        expression();
+    }
+
+    std::string_view source_;
+    Program& program_;
+    std::size_t pos_ = 0;
+    Error error_ = Error::None;
+    std::string message_;
+};
+
+bool Program::compile(std::string_view source, std::string* message) {
+    code_.clear();
+    numbers_.clear();
+    references_.clear();
+    written_.clear();
+    error_ = Error::None;
+    return Compiler(source, *this).run(message);
+}
+
+// ============================================================================
+// Evaluation
+// ============================================================================
+
+namespace {
+
+bool inside(const Range& range, const Cells& cells) {
+    return range.lastRow < cells.rowCount() && range.lastCol < cells.colCount();
+}
+
+// Arithmetic operand: blank counts as 0, text is #VALUE!
+Value operand(const Value& value) {
+    switch (value.kind) {
+        case Value::Kind::Blank: return Value::ofNumber(0.0);
+        case Value::Kind::Number:
+        case Value::Kind::Error: return value;
+        case Value::Kind::Text: return Value::ofError(Error::Value);
+    }
+    return value;
+}
+
+Value checked(double number) {
+    return std::isfinite(number) ? Value::ofNumber(number) : Value::ofError(Error::Value);
+}
+
+}  // namespace
+
+// Function arguments from stack[first] on; ranges are read cell by cell
+Value Program::call(Function function, const std::vector<Item>& stack, std::size_t first,
+                    const Cells& cells) const {
+    if (function == Function::Abs || function == Function::Round) {
+        Value x = operand(stack[first].value);
+        Value digits = stack.size() - first > 1 ? operand(stack[first + 1].value)
+                                                : Value::ofNumber(0.0);
+        if (x.kind == Value::Kind::Error) return x;
+        if (digits.kind == Value::Kind::Error) return digits;
+        if (function == Function::Abs) return Value::ofNumber(std::fabs(x.number));
+        double scale = std::pow(10.0, std::trunc(digits.number));
+        return checked(std::round(x.number * scale) / scale);
+    }
+
+    // Aggregates take numbers only: blank and text cells are skipped, the
+    // first error is passed on
+    double sum = 0.0;
+    double product = 1.0;
+    double low = 0.0;
+    double high = 0.0;
+    std::size_t count = 0;
+    Error error = Error::None;
+    auto add = [&](const Value& value) {
+        if (value.kind == Value::Kind::Number) {
+            low = count == 0 ? value.number : std::min(low, value.number);
+            high = count == 0 ? value.number : std::max(high, value.number);
+            sum += value.number;
+            product *= value.number;
+            ++count;
+        } else if (value.kind == Value::Kind::Error && error == Error::None) {
+            error = value.error;
+        }
+    };
+    for (std::size_t i = first; i < stack.size(); ++i) {
+        if (stack[i].range == NO_RANGE) {
+            add(stack[i].value);
+            continue;
+        }
+        const Range& range = references_[stack[i].range];
+        for (std::size_t row = range.firstRow; row <= range.lastRow; ++row) {
+            for (std::size_t col = range.firstCol; col <= range.lastCol; ++col) {
+                add(cells.value(row, col));
+            }
+        }
+    }
+    if (error != Error::None) return Value::ofError(error);
+
+    switch (function) {
+        case Function::Sum: return checked(sum);
+        case Function::Average:
+            return count == 0 ? Value::ofError(Error::DivideByZero)
+                              : checked(sum / static_cast<double>(count));
+        case Function::Min: return Value::ofNumber(low);
+        case Function::Max: return Value::ofNumber(high);
+        case Function::Count: return Value::ofNumber(static_cast<double>(count));
+        case Function::Product: return count == 0 ? Value::ofNumber(0.0) : checked(product);
+        case Function::Abs:
+        case Function::Round: break;
+    }
+    return Value::ofError(Error::Value);
+}
+
+Value Program::evaluate(const Cells& cells) const {
+    if (error_ != Error::None) return Value::ofError(error_);
+
+    std::vector<Item> stack;
+    stack.reserve(code_.size());
+    auto pop = [&stack]() {
+        Item item = stack.back();
+        stack.pop_back();
+        return item;
+    };
+
+    for (const Instruction& instruction : code_) {
+        switch (instruction.op) {
+            case Op::Number:
+                stack.push_back({Value::ofNumber(numbers_[instruction.operand])});
+                break;
+            case Op::Cell: {
+                const Range& ref = references_[instruction.operand];
+                stack.push_back({inside(ref, cells) ? cells.value(ref.firstRow, ref.firstCol)
+                                                    : Value::ofError(Error::Reference)});
+                break;
+            }
+            case Op::RefError:
+                stack.push_back({Value::ofError(Error::Reference)});
+                break;
+            case Op::Range:
+                if (inside(references_[instruction.operand], cells)) {
+                    stack.push_back({Value{}, instruction.operand});
+                } else {
+                    stack.push_back({Value::ofError(Error::Reference)});
+                }
+                break;
+            case Op::Neg: {
+                Value a = operand(pop().value);
+                stack.push_back({a.kind == Value::Kind::Error ? a : Value::ofNumber(-a.number)});
+                break;
+            }
+            case Op::Add:
+            case Op::Sub:
+            case Op::Mul:
+            case Op::Div:
+            case Op::Pow: {
+                Value b = operand(pop().value);
+                Value a = operand(pop().value);
+                Value result;
+                if (a.kind == Value::Kind::Error) {
+                    result = a;
+                } else if (b.kind == Value::Kind::Error) {
+                    result = b;
+                } else if (instruction.op == Op::Add) {
+                    result = checked(a.number + b.number);
+                } else if (instruction.op == Op::Sub) {
+                    result = checked(a.number - b.number);
+                } else if (instruction.op == Op::Mul) {
+                    result = checked(a.number * b.number);
+                } else if (instruction.op == Op::Div) {
+                    result = b.number == 0.0 ? Value::ofError(Error::DivideByZero)
+                                             : checked(a.number / b.number);
+                } else {
+                    result = checked(std::pow(a.number, b.number));
+                }
+                stack.push_back({result});
+                break;
+            }
+            case Op::Call: {
+                std::size_t first = stack.size() - instruction.argc;
+                stack[first].value = call(instruction.function, stack, first, cells);
+                stack.resize(first + 1);
+                stack[first].range = NO_RANGE;
+                break;
+            }
+        }
+    }
+    return stack.empty() ? Value::ofError(Error::Syntax) : stack.back().value;
+}
+
+// ============================================================================
+// Shifting references
+// ============================================================================
+
+namespace {
+
+void appendColumn(std::string& out, std::size_t col) {
+    char letters[8];
+    std::size_t count = 0;
+    for (std::size_t n = col + 1; n > 0; n = (n - 1) / 26) {
+        letters[count++] = static_cast<char>('A' + (n - 1) % 26);
+    }
+    while (count > 0) out += letters[--count];
+}
+
+}  // namespace
+
+bool Program::shift(const Shift& shift, std::string& source) {
+    if (shift.count == 0 || written_.empty()) return false;
+    auto at = static_cast<std::ptrdiff_t>(shift.at);
+    std::ptrdiff_t deleted = shift.count < 0 ? -shift.count : 0;
+
+    // New coordinate along the shifted axis. The low end of a range stays on
+    // the first row after a deleted block and the high end on the last row
+    // before it, so low > high means nothing is left.
+    auto move = [&](std::size_t value, bool low) {
+        auto v = static_cast<std::ptrdiff_t>(value);
+        if (shift.count > 0) return v >= at ? v + shift.count : v;
+        if (v < at) return v;
+        if (v >= at + deleted) return v - deleted;
+        return low ? at : at - 1;
+    };
+    auto append = [&](std::string& out, const Corner& corner) {
+        if (corner.absoluteCol) out += '$';
+        appendColumn(out, corner.col);
+        if (corner.absoluteRow) out += '$';
+        out += std::to_string(corner.row + 1);
+    };
+
+    bool moved = false;
+    std::string rewritten;
+    std::size_t copied = 0;
+    for (std::size_t i = 0; i < written_.size(); ++i) {
+        const Range& range = references_[i];
+        std::size_t low = shift.rows ? range.firstRow : range.firstCol;
+        std::size_t high = shift.rows ? range.lastRow : range.lastCol;
+        std::ptrdiff_t newLow = move(low, true);
+        std::ptrdiff_t newHigh = move(high, false);
+        if (newLow == static_cast<std::ptrdiff_t>(low) &&
+            newHigh == static_cast<std::ptrdiff_t>(high)) {
+            continue;
+        }
+        moved = true;
+        Written written = written_[i];
+        rewritten.append(source, copied, written.begin - copied);
+        copied = written.end;
+        if (newLow > newHigh) {
+            rewritten += "#REF!";
+            continue;
+        }
+        // A single cell has low == high, so both ends take newLow
+        for (Corner* corner : {&written.first, &written.last}) {
+            std::size_t& value = shift.rows ? corner->row : corner->col;
+            value = static_cast<std::size_t>(value == low ? newLow : newHigh);
+        }
+        append(rewritten, written.first);
+        if (written.range) {
+            rewritten += ':';
+            append(rewritten, written.last);
+        }
+    }
+    if (!moved) return false;
+    rewritten.append(source, copied, std::string::npos);
+    source = std::move(rewritten);
+    // Recompiling keeps code, references and written_ in step with the text
+    compile(source);
+    return true;
+}
+
+// ============================================================================
+// Graph
+// ============================================================================
+
+void Graph::clear() {
+    entries_.clear();
+    dependents_.clear();
+}
+
+Graph::Entry& Graph::set(std::size_t cell, Program program, std::size_t rows, std::size_t cols) {
+    erase(cell);
+    Entry entry;
+    for (const Range& range : program.references()) {
+        if (range.firstRow >= rows || range.firstCol >= cols) continue;
+        std::size_t lastRow = std::min(range.lastRow, rows - 1);
+        std::size_t lastCol = std::min(range.lastCol, cols - 1);
+        for (std::size_t row = range.firstRow; row <= lastRow; ++row) {
+            for (std::size_t col = range.firstCol; col <= lastCol; ++col) {
+                entry.precedents.push_back(row * cols + col);
+            }
+        }
+    }
+    std::sort(entry.precedents.begin(), entry.precedents.end());
+    entry.precedents.erase(std::unique(entry.precedents.begin(), entry.precedents.end()),
+                           entry.precedents.end());
+    for (std::size_t precedent : entry.precedents) dependents_[precedent].push_back(cell);
+    entry.program = std::move(program);
+    return entries_[cell] = std::move(entry);
+}
+
+void Graph::erase(std::size_t cell) {
+    auto it = entries_.find(cell);
+    if (it == entries_.end()) return;
+    for (std::size_t precedent : it->second.precedents) {
+        auto list = dependents_.find(precedent);
+        if (list == dependents_.end()) continue;
+        std::erase(list->second, cell);
+        if (list->second.empty()) dependents_.erase(list);
+    }
+    entries_.erase(it);
+}
+
+Graph::Entry* Graph::find(std::size_t cell) {
+    auto it = entries_.find(cell);
+    return it == entries_.end() ? nullptr : &it->second;
+}
+
+const Graph::Entry* Graph::find(std::size_t cell) const {
+    auto it = entries_.find(cell);
+    return it == entries_.end() ? nullptr : &it->second;
+}
+
+void Graph::dirtyOrder(const std::vector<std::size_t>& changed, std::vector<std::size_t>& order,
+                       std::vector<std::size_t>& cyclic) const {
+    // Everything reachable from the changed cells along dependent edges
+    std::unordered_set<std::size_t> seen;
+    std::vector<std::size_t> dirty;
+    std::vector<std::size_t> pending;
+    auto visit = [&](std::size_t cell) {
+        if (seen.insert(cell).second) {
+            dirty.push_back(cell);
+            pending.push_back(cell);
+        }
+    };
+    auto visitDependents = [&](std::size_t cell) {
+        auto it = dependents_.find(cell);
+        if (it == dependents_.end()) return;
+        for (std::size_t dependent : it->second) visit(dependent);
+    };
+    for (std::size_t cell : changed) {
+        if (entries_.contains(cell)) {
+            visit(cell);
+        } else {
+            visitDependents(cell);
+        }
+    }
+    while (!pending.empty()) {
+        std::size_t cell = pending.back();
+        pending.pop_back();
+        visitDependents(cell);
+    }
+    orderFrom(std::move(dirty), order, cyclic);
+}
+
+void Graph::fullOrder(std::vector<std::size_t>& order, std::vector<std::size_t>& cyclic) const {
+    std::vector<std::size_t> dirty;
+    dirty.reserve(entries_.size());
+    for (const auto& [cell, entry] : entries_) dirty.push_back(cell);
+    // Map order is arbitrary; sorting keeps results (and cycle reports) stable
+    std::sort(dirty.begin(), dirty.end());
+    orderFrom(std::move(dirty), order, cyclic);
+}
+
+// Kahn's algorithm over the dirty formulas: a formula is ready once none
+// of the dirty formulas it reads is still waiting
+void Graph::orderFrom(std::vector<std::size_t> dirty, std::vector<std::size_t>& order,
+                      std::vector<std::size_t>& cyclic) const {
+    order.clear();
+    cyclic.clear();
+    std::unordered_map<std::size_t, std::size_t> waiting;
+    waiting.reserve(dirty.size());
+    for (std::size_t cell : dirty) waiting.emplace(cell, 0);
+    for (std::size_t cell : dirty) {
+        for (std::size_t precedent : entries_.at(cell).precedents) {
+            if (waiting.contains(precedent)) ++waiting[cell];
+        }
+    }
+
+    order.reserve(dirty.size());
+    for (std::size_t cell : dirty) {
+        if (waiting[cell] == 0) order.push_back(cell);
+    }
+    for (std::size_t next = 0; next < order.size(); ++next) {
+        auto it = dependents_.find(order[next]);
+        if (it == dependents_.end()) continue;
+        for (std::size_t dependent : it->second) {
+            auto count = waiting.find(dependent);
+            if (count != waiting.end() && --count->second == 0) order.push_back(dependent);
+        }
+    }
+    if (order.size() == dirty.size()) return;
+    for (std::size_t cell : dirty) {
+        if (waiting[cell] > 0) cyclic.push_back(cell);
+    }
+}
+
+}  // namespace formula
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Spreadsheet-style formulas for table cells ("=SUM(B2:B40)", "=A1*1.2").
+//
+// A formula is compiled once into a small stack program (Program) and run
+// against the table's cells through the Cells interface. Graph keeps the
+// compiled formulas of one table together with the reverse edges from each
+// cell to the formulas that read it, so after an edit only the formulas
+// downstream of the changed cells are evaluated, each after its inputs.
+//
+// Syntax: numbers, A1-style references (optionally with $), ranges (A1:B5,
+// only as function arguments), + - * / ^, unary minus and parentheses, and
+// the functions SUM, AVERAGE, MIN, MAX, COUNT, PRODUCT, ABS and ROUND.
+// Names are case-insensitive. #REF! stands for a reference whose cells were
+// deleted (see Program::shift).
+namespace formula {
+
+enum class Error : std::uint8_t {
+    None,
+    Value,         // #VALUE!  text where a number is needed
+    DivideByZero,  // #DIV/0!
+    Reference,     // #REF!    reference outside the table
+    Name,          // #NAME?   unknown function
+    Syntax,        // #ERROR!  formula does not parse
+    Cycle          // #CYCLE!  in or downstream of a circular reference
+};
+
+// Display text of an error ("#DIV/0!"); empty for Error::None
+const char* errorText(Error error);
+
+struct Value {
+    enum class Kind : std::uint8_t { Blank, Number, Text, Error };
+    Kind kind = Kind::Blank;
+    double number = 0.0;
+    Error error = Error::None;
+
+    static Value ofNumber(double n) { return {Kind::Number, n, Error::None}; }
+    static Value ofError(Error e) { return {Kind::Error, 0.0, e}; }
+};
+
+// Value of a cell holding this text: blank, a number, an error text as
+// written by format(), or other text
+Value valueOfText(std::string_view text);
+
+// Text shown in a formula cell for its value (up to 15 significant digits)
+std::string format(const Value& value);
+
+// A rectangle of cells, inclusive, zero-based
+struct Range {
+    std::size_t firstRow = 0;
+    std::size_t firstCol = 0;
+    std::size_t lastRow = 0;
+    std::size_t lastCol = 0;
+};
+
+// Rows (or columns) inserted before index at, or deleted from it on.
+// count is positive for an insert and negative for a delete.
+struct Shift {
+    bool rows = true;
+    std::size_t at = 0;
+    std::ptrdiff_t count = 0;
+};
+
+// Where a program reads its inputs from
+class Cells {
+   public:
+    virtual ~Cells() = default;
+    virtual std::size_t rowCount() const = 0;
+    virtual std::size_t colCount() const = 0;
+    // Only called for positions inside the table
+    virtual Value value(std::size_t row, std::size_t col) const = 0;
+};
+
+class Program {
+   public:
+    // Compile source, with or without its leading '='. On failure the
+    // program evaluates to the error (Syntax or Name) and false is returned.
+    bool compile(std::string_view source, std::string* message = nullptr);
+
+    Value evaluate(const Cells& cells) const;
+
+    // Every cell and range the program reads, in source order
+    const std::vector<Range>& references() const { return references_; }
+
+    // Follow rows or columns that moved: references after them move with
+    // them, ranges grow or shrink around them, and a reference whose every
+    // cell was deleted becomes #REF!. source (what this program was
+    // compiled from) is rewritten to match, keeping any $. Returns false,
+    // changing nothing, if no reference moved.
+    bool shift(const Shift& shift, std::string& source);
+
+   private:
+    enum class Op : std::uint8_t {
+        Number,
+        Cell,
+        Range,
+        RefError,
+        Add,
+        Sub,
+        Mul,
+        Div,
+        Pow,
+        Neg,
+        Call
+    };
+    enum class Function : std::uint8_t {
+        Sum,
+        Average,
+        Min,
+        Max,
+        Count,
+        Product,
+        Abs,
+        Round
+    };
+    struct Instruction {
+        Op op;
+        Function function = Function::Sum;
+        std::uint16_t argc = 0;
+        std::uint32_t operand = 0;  // Index into numbers_ or references_
+    };
+    static constexpr std::uint32_t NO_RANGE = 0xFFFFFFFF;
+    // Evaluation stack slot: a value, or a range argument
+    struct Item {
+        Value value;
+        std::uint32_t range = NO_RANGE;  // Index into references_
+    };
+    // Where a reference was written, for shift(): its text in the source,
+    // and each end as written (a single cell has first == last)
+    struct Corner {
+        std::size_t row = 0;
+        std::size_t col = 0;
+        bool absoluteRow = false;
+        bool absoluteCol = false;
+    };
+    struct Written {
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        Corner first;
+        Corner last;
+        bool range = false;
+    };
+    friend class Compiler;
+
+    Value call(Function function, const std::vector<Item>& stack, std::size_t first,
+               const Cells& cells) const;
+
+    std::vector<Instruction> code_;
+    std::vector<double> numbers_;
+    std::vector<Range> references_;
+    std::vector<Written> written_;  // Parallel to references_
+    Error error_ = Error::None;
+};
+
+// The formulas of one table, keyed by cell index (row * colCount + col)
+class Graph {
+   public:
+    struct Entry {
+        Program program;
+        std::vector<std::size_t> precedents;  // Cells read, sorted, unique
+        Value value;                          // Last result
+    };
+
+    void clear();
+    bool empty() const { return entries_.empty(); }
+    std::size_t size() const { return entries_.size(); }
+
+    // Add or replace the formula at cell. Its references are resolved
+    // against a table of cols columns and rows rows; cells outside it get
+    // no edge (they evaluate to #REF! anyway).
+    Entry& set(std::size_t cell, Program program, std::size_t rows, std::size_t cols);
+    void erase(std::size_t cell);
+
+    Entry* find(std::size_t cell);
+    const Entry* find(std::size_t cell) const;
+
+    // Formula cells to evaluate after the given cells changed: the changed
+    // cells that hold formulas and everything downstream of any of them,
+    // in an order where each comes after the formulas it reads. Cells that
+    // cannot be ordered (in or behind a cycle) go to cyclic instead.
+    void dirtyOrder(const std::vector<std::size_t>& changed, std::vector<std::size_t>& order,
+                    std::vector<std::size_t>& cyclic) const;
+
+    // dirtyOrder for every formula in the graph
+    void fullOrder(std::vector<std::size_t>& order, std::vector<std::size_t>& cyclic) const;
+
+   private:
+    void orderFrom(std::vector<std::size_t> dirty, std::vector<std::size_t>& order,
+                   std::vector<std::size_t>& cyclic) const;
+
+    std::unordered_map<std::size_t, Entry> entries_;
+    std::unordered_map<std::size_t, std::vector<std::size_t>> dependents_;
+};
+
+}  // namespace formula
@@ -0,0 +1,392 @@
+#include "grammar_rules.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <deque>
+
+#include "spellcheck.h"
+
+namespace {
+// Same as std::tolower in the "C" locale, without the library call
+char lowerAscii(char ch) {
+    return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+// Words compare equal after SpellChecker::normalizeWord (lowercase, no
+// apostrophes), without building the normalized strings
+bool sameNormalizedWord(std::string_view a, std::string_view b, bool& empty) {
+    std::size_t i = 0;
+    std::size_t j = 0;
+    empty = true;
+    while (true) {
+        while (i < a.size() && a[i] == '\'') ++i;
+        while (j < b.size() && b[j] == '\'') ++j;
+        if (i == a.size() || j == b.size()) return i == a.size() && j == b.size();
+        if (lowerAscii(a[i]) != lowerAscii(b[j])) return false;
+        empty = false;
+        ++i;
+        ++j;
+    }
+}
+
+GrammarError makeError(std::string_view text, std::size_t offset, std::size_t length,
+                       std::string message, std::string suggestion,
+                       const std::string& ruleId) {
+    GrammarError error;
+    error.offset = offset;
+    error.length = length;
+    error.text = std::string(text.substr(offset, length));
+    error.message = std::move(message);
+    error.suggestion = std::move(suggestion);
+    error.ruleId = ruleId;
+    return error;
+}
+
+// ============================================================================
+// Built-in rules
+// ============================================================================
+
+class DoubleSpaceRule : public GrammarRule {
+   public:
+    DoubleSpaceRule() : GrammarRule("DOUBLE_SPACE") {}
+
+    void onToken(const GrammarScan& scan, std::size_t index, GrammarRuleState& /*state*/,
+                 std::vector<GrammarError>& errors) const override {
+        const GrammarToken& token = scan.tokens[index];
+        if (token.kind == GrammarTokenKind::Space && token.length >= 2) {
+            errors.push_back(makeError(scan.text, token.offset, token.length,
+                                       "Multiple consecutive spaces", " ", id()));
+        }
+    }
+};
+
+// A lowercase letter after '.', '!' or '?' (or at the start of the text),
+// with only spaces, tabs and newlines in between
+class SentenceCapitalizationRule : public GrammarRule {
+   public:
+    SentenceCapitalizationRule() : GrammarRule("SENTENCE_CAPITALIZATION") {}
+
+    void begin(GrammarRuleState& state) const override { state.flag = true; }
+
+    void onToken(const GrammarScan& scan, std::size_t index, GrammarRuleState& state,
+                 std::vector<GrammarError>& errors) const override {
+        const GrammarToken& token = scan.tokens[index];
+        std::string_view word = scan.tokenText(index);
+        switch (token.kind) {
+            case GrammarTokenKind::Space:
+                return;
+            case GrammarTokenKind::Other: {
+                char ch = word[0];
+                if (ch == '.' || ch == '!' || ch == '?') {
+                    state.flag = true;
+                } else if (ch != '\n' && ch != '\t') {
+                    state.flag = false;
+                }
+                return;
+            }
+            case GrammarTokenKind::Word:
+                break;
+        }
+        if (!state.flag) return;
+        state.flag = false;
+
+        // Words may start with an apostrophe, which ends the sentence start
+        if (!std::islower(static_cast<unsigned char>(word[0]))) return;
+        std::size_t length = 1;
+        while (length < word.size() && word[length] != '\'') ++length;
+        std::string suggestion(word.substr(0, length));
+        suggestion[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(suggestion[0])));
+        errors.push_back(makeError(scan.text, token.offset, length,
+                                   "Sentence should start with capital letter",
+                                   std::move(suggestion), id()));
+    }
+};
+
+class RepeatedWordRule : public GrammarRule {
+   public:
+    RepeatedWordRule() : GrammarRule("REPEATED_WORD") {}
+
+    void onToken(const GrammarScan& scan, std::size_t index, GrammarRuleState& state,
+                 std::vector<GrammarError>& errors) const override {
+        if (scan.tokens[index].kind != GrammarTokenKind::Word) return;
+        std::size_t previous = state.index;
+        state.index = index;
+        if (previous == GrammarRuleState::NONE) return;
+
+        bool empty = true;
+        std::string_view prevWord = scan.tokenText(previous);
+        if (!sameNormalizedWord(prevWord, scan.tokenText(index), empty) || empty) return;
+
+        const GrammarToken& prev = scan.tokens[previous];
+        const GrammarToken& curr = scan.tokens[index];
+        errors.push_back(makeError(scan.text, prev.offset,
+                                   curr.offset + curr.length - prev.offset, "Repeated word",
+                                   std::string(prevWord), id()));
+    }
+};
+}  // namespace
+
+// ============================================================================
+// Tokenizer
+// ============================================================================
+
+void tokenizeForGrammar(std::string_view text, std::vector<GrammarToken>& tokens) {
+    tokens.clear();
+    std::size_t i = 0;
+    while (i < text.size()) {
+        std::size_t start = i;
+        GrammarTokenKind kind = GrammarTokenKind::Other;
+        if (SpellChecker::isWordChar(text[i])) {
+            kind = GrammarTokenKind::Word;
+            while (i < text.size() && SpellChecker::isWordChar(text[i])) ++i;
+        } else if (text[i] == ' ') {
+            kind = GrammarTokenKind::Space;
+            while (i < text.size() && text[i] == ' ') ++i;
+        } else {
+            ++i;
+        }
+        tokens.push_back({static_cast<std::uint32_t>(start),
+                          static_cast<std::uint32_t>(i - start), kind});
+    }
+}
+
+// ============================================================================
+// PhraseMatcher
+// ============================================================================
+
+PhraseMatcher::PhraseMatcher(const std::vector<std::string>& phrases) {
+    // Only bytes that occur in some phrase get their own column; folding
+    // case into the classes means the text never needs lowercasing
+    for (const auto& phrase : phrases) {
+        for (char ch : phrase) {
+            auto lower = static_cast<unsigned char>(lowerAscii(ch));
+            if (byteClass_[lower] != 0) continue;
+            byteClass_[lower] = static_cast<std::uint8_t>(classCount_++);
+            byteClass_[std::toupper(lower)] = byteClass_[lower];
+        }
+    }
+
+    constexpr std::uint32_t NONE = 0xFFFFFFFFu;
+    std::vector<std::uint32_t> table(classCount_, NONE);
+    std::vector<std::vector<std::uint32_t>> matches(1);
+
+    // Trie of all phrases
+    lengths_.reserve(phrases.size());
+    for (std::size_t p = 0; p < phrases.size(); ++p) {
+        lengths_.push_back(phrases[p].size());
+        if (phrases[p].empty()) continue;
+        std::uint32_t node = 0;
+        for (char ch : phrases[p]) {
+            std::size_t cls = byteClass_[static_cast<unsigned char>(lowerAscii(ch))];
+            std::uint32_t& edge = table[node * classCount_ + cls];
+            if (edge == NONE) {
+                edge = static_cast<std::uint32_t>(matches.size());
+                matches.emplace_back();
+                table.resize(table.size() + classCount_, NONE);
+            }
+            node = table[node * classCount_ + cls];
+        }
+        matches[node].push_back(static_cast<std::uint32_t>(p));
+    }
+
+    // Breadth-first: fill missing edges from the failure state so step() is
+    // a single lookup, and inherit the failure state's matches
+    std::vector<std::uint32_t> fail(matches.size(), 0);
+    std::deque<std::uint32_t> queue;
+    for (std::size_t cls = 0; cls < classCount_; ++cls) {
+        std::uint32_t& edge = table[cls];
+        if (edge == NONE) {
+            edge = 0;
+        } else {
+            queue.push_back(edge);
+        }
+    }
+    while (!queue.empty()) {
+        std::uint32_t node = queue.front();
+        queue.pop_front();
+        for (std::size_t cls = 0; cls < classCount_; ++cls) {
+            std::uint32_t& edge = table[node * classCount_ + cls];
+            std::uint32_t viaFail = table[fail[node] * classCount_ + cls];
+            if (edge == NONE) {
+                edge = viaFail;
+            } else {
+                fail[edge] = viaFail;
+                const auto& inherited = matches[viaFail];
+                matches[edge].insert(matches[edge].end(), inherited.begin(), inherited.end());
+                queue.push_back(edge);
+            }
+        }
+    }
+
+    next_ = std::move(table);
+    outputStart_.reserve(matches.size() + 1);
+    for (const auto& list : matches) {
+        outputStart_.push_back(static_cast<std::uint32_t>(outputs_.size()));
+        outputs_.insert(outputs_.end(), list.begin(), list.end());
+    }
+    outputStart_.push_back(static_cast<std::uint32_t>(outputs_.size()));
+}
+
+// ============================================================================
+// PhraseRule
+// ============================================================================
+
+namespace {
+std::vector<std::string> wrongPhrases(const std::vector<GrammarPhrase>& phrases) {
+    std::vector<std::string> wrong;
+    wrong.reserve(phrases.size());
+    for (const auto& phrase : phrases) wrong.push_back(phrase.wrong);
+    return wrong;
+}
+}  // namespace
+
+PhraseRule::PhraseRule(std::string id, std::vector<GrammarPhrase> phrases)
+    : GrammarRule(std::move(id)),
+      phrases_(std::move(phrases)),
+      matcher_(wrongPhrases(phrases_)) {}
+
+void PhraseRule::begin(GrammarRuleState& state) const {
+    state.node = 0;
+    // Earliest start allowed for each phrase: matches of one phrase never
+    // overlap, matching a left-to-right find() that skips past each hit
+    state.positions.assign(phrases_.size(), 0);
+}
+
+void PhraseRule::onToken(const GrammarScan& scan, std::size_t index, GrammarRuleState& state,
+                         std::vector<GrammarError>& errors) const {
+    const GrammarToken& token = scan.tokens[index];
+    const std::string_view text = scan.text;
+    std::uint32_t node = state.node;
+    for (std::size_t pos = token.offset; pos < token.offset + token.length; ++pos) {
+        node = matcher_.step(node, text[pos]);
+        const std::uint32_t* match = matcher_.matchesBegin(node);
+        const std::uint32_t* matchEnd = matcher_.matchesEnd(node);
+        for (; match != matchEnd; ++match) {
+            std::size_t length = matcher_.phraseLength(*match);
+            std::size_t end = pos + 1;
+            std::size_t start = end - length;
+            if (start < state.positions[*match]) continue;
+            state.positions[*match] = end;
+
+            bool startOk = start == 0 || !SpellChecker::isWordChar(text[start - 1]);
+            bool endOk = end >= text.size() || !SpellChecker::isWordChar(text[end]);
+            if (startOk && endOk) {
+                const GrammarPhrase& phrase = phrases_[*match];
+                errors.push_back(
+                    makeError(text, start, length, phrase.message, phrase.correct, id()));
+            }
+        }
+    }
+    state.node = node;
+}
+
+// ============================================================================
+// Defaults
+// ============================================================================
+
+const std::vector<GrammarPhrase>& commonErrorPhrases() {
+    static const std::vector<GrammarPhrase> phrases = {
+        {"your welcome", "you're welcome", "Use \"you're\" (you are)"},
+        {"could of", "could have", "Use \"could have\" instead of \"could of\""},
+        {"should of", "should have", "Use \"should have\" instead of \"should of\""},
+        {"would of", "would have", "Use \"would have\" instead of \"would of\""},
+        {"alot", "a lot", "\"A lot\" should be two words"},
+        {"definately", "definitely", "Correct spelling is \"definitely\""},
+        {"seperate", "separate", "Correct spelling is \"separate\""},
+        {"occured", "occurred", "Correct spelling is \"occurred\""},
+        {"recieve", "receive", "Correct spelling is \"receive\""},
+        {"untill", "until", "Correct spelling is \"until\""},
+        {"wierd", "weird", "Correct spelling is \"weird\""},
+        {"thier", "their", "Correct spelling is \"their\""},
+        {"truely", "truly", "Correct spelling is \"truly\""},
+        {"accomodate", "accommodate", "Correct spelling is \"accommodate\""},
+        {"occurence", "occurrence", "Correct spelling is \"occurrence\""},
+    };
+    return phrases;
+}
+
+std::vector<GrammarRulePtr> defaultGrammarRules() {
+    return {
+        std::make_shared<DoubleSpaceRule>(),
+        std::make_shared<SentenceCapitalizationRule>(),
+        std::make_shared<RepeatedWordRule>(),
+        std::make_shared<PhraseRule>("COMMON_ERRORS", commonErrorPhrases()),
+    };
+}
+
+// ============================================================================
+// Engine
+// ============================================================================
+
+const GrammarRuleTiming* GrammarProfile::find(std::string_view ruleId) const {
+    for (const auto& timing : rules) {
+        if (timing.ruleId == ruleId) return &timing;
+    }
+    return nullptr;
+}
+
+std::vector<GrammarError> runGrammarRules(std::string_view text,
+                                          const std::vector<const GrammarRule*>& rules,
+                                          GrammarProfile* profile) {
+    using Clock = std::chrono::steady_clock;
+    auto elapsedNs = [](Clock::time_point since) {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count());
+    };
+
+    auto tokenizeStart = Clock::now();
+    std::vector<GrammarToken> tokens;
+    tokens.reserve(text.size() / 3 + 1);
+    tokenizeForGrammar(text, tokens);
+    GrammarScan scan{text, tokens};
+
+    std::vector<GrammarRuleState> states(rules.size());
+    std::vector<std::vector<GrammarError>> found(rules.size());
+    for (std::size_t r = 0; r < rules.size(); ++r) rules[r]->begin(states[r]);
+
+    if (profile) {
+        profile->runs++;
+        profile->tokens += tokens.size();
+        profile->tokenizeNanoseconds += elapsedNs(tokenizeStart);
+    }
+    std::vector<std::uint64_t> ruleNanoseconds(profile ? rules.size() : 0, 0);
+
+    // One walk over the stream in cache-sized blocks. Within a block each
+    // rule runs over every token before the next rule starts, which keeps
+    // the virtual call target predictable and lets profiling read the
+    // clock per block rather than per token.
+    constexpr std::size_t BLOCK = 512;
+    for (std::size_t blockStart = 0; blockStart < tokens.size(); blockStart += BLOCK) {
+        std::size_t blockEnd = std::min(tokens.size(), blockStart + BLOCK);
+        for (std::size_t r = 0; r < rules.size(); ++r) {
+            auto ruleStart = profile ? Clock::now() : Clock::time_point{};
+            for (std::size_t t = blockStart; t < blockEnd; ++t) {
+                rules[r]->onToken(scan, t, states[r], found[r]);
+            }
+            if (profile) ruleNanoseconds[r] += elapsedNs(ruleStart);
+        }
+    }
+
+    if (profile) {
+        for (std::size_t r = 0; r < rules.size(); ++r) {
+            auto it = std::find_if(profile->rules.begin(), profile->rules.end(),
+                                   [&](const auto& t) { return t.ruleId == rules[r]->id(); });
+            if (it == profile->rules.end()) {
+                profile->rules.push_back({rules[r]->id(), 0, 0});
+                it = profile->rules.end() - 1;
+            }
+            it->nanoseconds += ruleNanoseconds[r];
+            it->errors += found[r].size();
+        }
+    }
+
+    std::vector<GrammarError> errors;
+    for (auto& list : found) {
+        errors.insert(errors.end(), std::make_move_iterator(list.begin()),
+                      std::make_move_iterator(list.end()));
+    }
+    std::stable_sort(errors.begin(), errors.end(),
+                     [](const auto& a, const auto& b) { return a.offset < b.offset; });
+    return errors;
+}
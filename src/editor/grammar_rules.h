@@ -0,0 +1,166 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Grammar issue reported by a rule
+struct GrammarError {
+    std::size_t offset = 0;
+    std::size_t length = 0;
+    std::string text;              // The problematic text
+    std::string message;           // Description of the issue
+    std::string suggestion;        // Suggested correction
+    std::string ruleId;            // Rule identifier (e.g., "DOUBLE_SPACE")
+};
+
+// ============================================================================
+// Token stream
+// ============================================================================
+
+// Text is split once into words (letters and apostrophes, the same runs as
+// SpellChecker::extractWords), runs of spaces, and single other characters.
+enum class GrammarTokenKind : std::uint8_t { Word, Space, Other };
+
+struct GrammarToken {
+    std::uint32_t offset = 0;
+    std::uint32_t length = 0;
+    GrammarTokenKind kind = GrammarTokenKind::Other;
+};
+
+void tokenizeForGrammar(std::string_view text, std::vector<GrammarToken>& tokens);
+
+// What a rule sees while the engine walks the token stream
+struct GrammarScan {
+    std::string_view text;
+    const std::vector<GrammarToken>& tokens;
+
+    std::string_view tokenText(std::size_t index) const {
+        const GrammarToken& token = tokens[index];
+        return text.substr(token.offset, token.length);
+    }
+};
+
+// Per-text scratch space for one rule. Rules are shared and immutable, so
+// anything that carries from one token to the next lives here.
+struct GrammarRuleState {
+    static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+    bool flag = false;
+    std::size_t index = NONE;
+    std::uint32_t node = 0;
+    std::vector<std::size_t> positions;
+};
+
+// ============================================================================
+// Rules
+// ============================================================================
+
+// A grammar rule is fed every token of the text in order. Rules must not
+// keep state in members (checkers may share them); use GrammarRuleState.
+class GrammarRule {
+   public:
+    explicit GrammarRule(std::string id) : id_(std::move(id)) {}
+    virtual ~GrammarRule() = default;
+
+    const std::string& id() const { return id_; }
+
+    virtual void begin(GrammarRuleState& /*state*/) const {}
+    virtual void onToken(const GrammarScan& scan, std::size_t index,
+                         GrammarRuleState& state,
+                         std::vector<GrammarError>& errors) const = 0;
+
+   private:
+    std::string id_;
+};
+
+// Multi-pattern matcher (Aho–Corasick) over ASCII phrases, ignoring case.
+// The transition table is fully expanded, so matching costs one lookup per
+// byte no matter how many phrases are loaded.
+class PhraseMatcher {
+   public:
+    explicit PhraseMatcher(const std::vector<std::string>& phrases);
+
+    std::uint32_t step(std::uint32_t state, char ch) const {
+        return next_[state * classCount_ + byteClass_[static_cast<unsigned char>(ch)]];
+    }
+
+    // Phrase indices that end at state
+    const std::uint32_t* matchesBegin(std::uint32_t state) const {
+        return outputs_.data() + outputStart_[state];
+    }
+    const std::uint32_t* matchesEnd(std::uint32_t state) const {
+        return outputs_.data() + outputStart_[state + 1];
+    }
+
+    std::size_t phraseCount() const { return lengths_.size(); }
+    std::size_t phraseLength(std::size_t phrase) const { return lengths_[phrase]; }
+    std::size_t stateCount() const { return outputStart_.empty() ? 0 : outputStart_.size() - 1; }
+
+   private:
+    std::uint8_t byteClass_[256] = {};  // Upper and lower case share a class
+    std::size_t classCount_ = 1;  // Class 0 = bytes that appear in no phrase
+    std::vector<std::uint32_t> next_;
+    std::vector<std::uint32_t> outputStart_;
+    std::vector<std::uint32_t> outputs_;
+    std::vector<std::size_t> lengths_;
+};
+
+// Case-insensitive "wrong phrase -> correction" rule. Matches must sit on
+// word boundaries; every phrase in the rule shares one automaton.
+struct GrammarPhrase {
+    std::string wrong;
+    std::string correct;
+    std::string message;
+};
+
+class PhraseRule : public GrammarRule {
+   public:
+    PhraseRule(std::string id, std::vector<GrammarPhrase> phrases);
+
+    void begin(GrammarRuleState& state) const override;
+    void onToken(const GrammarScan& scan, std::size_t index, GrammarRuleState& state,
+                 std::vector<GrammarError>& errors) const override;
+
+    const std::vector<GrammarPhrase>& phrases() const { return phrases_; }
+
+   private:
+    std::vector<GrammarPhrase> phrases_;
+    PhraseMatcher matcher_;
+};
+
+using GrammarRulePtr = std::shared_ptr<const GrammarRule>;
+
+// DOUBLE_SPACE, SENTENCE_CAPITALIZATION, REPEATED_WORD, COMMON_ERRORS
+std::vector<GrammarRulePtr> defaultGrammarRules();
+const std::vector<GrammarPhrase>& commonErrorPhrases();
+
+// ============================================================================
+// Engine
+// ============================================================================
+
+struct GrammarRuleTiming {
+    std::string ruleId;
+    std::uint64_t nanoseconds = 0;
+    std::size_t errors = 0;
+};
+
+// Accumulated cost of grammar checks, filled when a profile is passed to
+// runGrammarRules / GrammarChecker::checkText
+struct GrammarProfile {
+    std::size_t runs = 0;
+    std::size_t tokens = 0;
+    std::uint64_t tokenizeNanoseconds = 0;
+    std::vector<GrammarRuleTiming> rules;
+
+    const GrammarRuleTiming* find(std::string_view ruleId) const;
+    void reset() { *this = GrammarProfile{}; }
+};
+
+// Tokenize text once and feed every token to each rule in turn. Errors are
+// returned sorted by offset (ties keep rule order).
+std::vector<GrammarError> runGrammarRules(std::string_view text,
+                                          const std::vector<const GrammarRule*>& rules,
+                                          GrammarProfile* profile = nullptr);
@@ -5,11 +5,21 @@
 std::size_t ImageCollection::addImage(const DocumentImage& image) {
     DocumentImage img = image;
     img.id = nextId_++;
-    images_.push_back(img);
-    return img.id;
+    if (img.contentKey != 0 && cache_.contains(img.contentKey)) {
+        cache_.retain(img.contentKey);  // A copy of one of ours
+    } else {
+        img.contentKey = 0;
+        if (img.isEmbedded && !img.base64Data.empty()) {
+            // Decoded once here; pixels wait until the image is drawn
+            img.contentKey = cache_.add(img.base64Data);
+            if (img.contentKey != 0) img.base64Data.clear();
+        }
+    }
+    ++generation_;
+    return anchor_index::insert(images_, std::move(img)).id;
 }
 
-DocumentImage* ImageCollection::getImage(std::size_t id) {
+DocumentImage* ImageCollection::find(std::size_t id) {
     auto it = std::find_if(images_.begin(), images_.end(),
                            [id](const DocumentImage& img) { return img.id == id; });
     return it != images_.end() ? &(*it) : nullptr;
@@ -25,57 +35,61 @@ bool ImageCollection::removeImage(std::size_t id) {
     auto it = std::find_if(images_.begin(), images_.end(),
                            [id](const DocumentImage& img) { return img.id == id; });
     if (it != images_.end()) {
+        cache_.release(it->contentKey);
         images_.erase(it);
+        ++generation_;
         return true;
     }
     return false;
 }
 
-std::vector<DocumentImage*> ImageCollection::imagesAtLine(std::size_t line) {
-    std::vector<DocumentImage*> result;
-    for (auto& img : images_) {
-        if (img.anchorLine == line) {
-            result.push_back(&img);
-        }
-    }
-    return result;
+std::span<const DocumentImage> ImageCollection::imagesAtLine(std::size_t line) const {
+    return anchor_index::inLines(images_, line, line);
 }
 
-std::vector<const DocumentImage*> ImageCollection::imagesAtLine(std::size_t line) const {
-    std::vector<const DocumentImage*> result;
-    for (const auto& img : images_) {
-        if (img.anchorLine == line) {
-            result.push_back(&img);
-        }
-    }
-    return result;
+std::span<const DocumentImage> ImageCollection::imagesInRange(std::size_t startLine,
+                                                              std::size_t endLine) const {
+    return anchor_index::inLines(images_, startLine, endLine);
 }
 
-std::vector<const DocumentImage*> ImageCollection::imagesInRange(
-    std::size_t startLine, std::size_t endLine) const {
-    std::vector<const DocumentImage*> result;
-    for (const auto& img : images_) {
-        if (img.anchorLine >= startLine && img.anchorLine <= endLine) {
-            result.push_back(&img);
-        }
-    }
-    return result;
+void ImageCollection::shiftAnchorsFrom(std::size_t line, std::ptrdiff_t linesDelta) {
+    anchor_index::shiftAnchors(images_, line, linesDelta);
+    ++generation_;
 }
 
-void ImageCollection::shiftAnchorsFrom(std::size_t line, std::ptrdiff_t linesDelta) {
-    for (auto& img : images_) {
-        if (img.anchorLine >= line) {
-            if (linesDelta < 0 && static_cast<std::size_t>(-linesDelta) > img.anchorLine) {
-                img.anchorLine = 0;
-            } else {
-                img.anchorLine = static_cast<std::size_t>(
-                    static_cast<std::ptrdiff_t>(img.anchorLine) + linesDelta);
-            }
-        }
+const AnchorBounds& ImageCollection::bounds(float lineHeight, float zoom) const {
+    if (bounds_.isCurrent(generation_, lineHeight, zoom)) return bounds_;
+    bounds_.reset(generation_, lineHeight, zoom);
+    for (std::size_t i = 0; i < images_.size(); ++i) {
+        const DocumentImage& image = images_[i];
+        float left = image.offsetX * zoom;
+        float top = static_cast<float>(image.anchorLine) * lineHeight + image.offsetY * zoom;
+        bounds_.add({left, top, left + image.displayWidth * zoom,
+                     top + image.displayHeight * zoom, i, image.id});
     }
+    bounds_.finish();
+    return bounds_;
+}
+
+void ImageCollection::imagesOverlapping(float top, float bottom, float lineHeight, float zoom,
+                                        std::vector<std::size_t>& out) const {
+    bounds(lineHeight, zoom).overlapping(top, bottom, out);
+}
+
+const DocumentImage* ImageCollection::imageAt(float x, float y, float lineHeight,
+                                              float zoom) const {
+    std::size_t index = bounds(lineHeight, zoom).hit(x, y);
+    return index == AnchorBounds::NONE ? nullptr : &images_[index];
 }
 
 void ImageCollection::clear() {
     images_.clear();
+    ++generation_;
+    cache_.clear();
     nextId_ = 1;
 }
+
+std::string ImageCollection::embeddedBase64(const DocumentImage& image) const {
+    if (!image.base64Data.empty()) return image.base64Data;
+    return cache_.base64(image.contentKey);
+}
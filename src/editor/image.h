@@ -1,9 +1,14 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string>
 #include <vector>
 
+#include "anchor_index.h"
+#include "image_cache.h"
+
 // Image layout modes for text wrapping
 enum class ImageLayoutMode {
     Inline,     // Image is placed inline with text, like a character
@@ -40,6 +45,9 @@ struct DocumentImage {
     std::string filename;    // Original filename (for display and re-loading)
     std::string base64Data;  // Base64-encoded image data (for embedded images)
     bool isEmbedded = true;  // True if image data is embedded, false if external link
+    // The embedded data once it is in an ImageCollection's cache (which
+    // takes it out of base64Data, so copies of the image stay small)
+    ImageCache::Key contentKey = 0;
     
     // Position in document
     std::size_t anchorLine = 0;    // Line number where image is anchored
@@ -79,7 +87,9 @@ struct DocumentImage {
     std::size_t id = 0;
     
     // Helper methods
-    bool hasEmbeddedData() const { return isEmbedded && !base64Data.empty(); }
+    bool hasEmbeddedData() const {
+        return isEmbedded && (!base64Data.empty() || contentKey != 0);
+    }
     bool hasExternalSource() const { return !isEmbedded && !filename.empty(); }
     
     float aspectRatio() const {
@@ -127,31 +137,53 @@ struct DocumentImage {
     }
 };
 
-// Image collection in a document
+// Image collection in a document. Images are kept sorted by anchor line
+// (anchor_index.h), so line lookups return spans without allocating.
 class ImageCollection {
 public:
     ImageCollection() = default;
     
-    // Add an image at the specified anchor position
+    // Add an image at the specified anchor position. Embedded base64 data
+    // moves into cache() (identical images share one entry).
     std::size_t addImage(const DocumentImage& image);
     
-    // Get image by ID
-    DocumentImage* getImage(std::size_t id);
+    // Get image by ID (change it with editImage)
     const DocumentImage* getImage(std::size_t id) const;
+
+    // Change image id in place: edit(DocumentImage&) runs on it, then the
+    // layout index is invalidated. False if there is no such image. Do not
+    // move its anchorLine this way; use shiftAnchorsFrom.
+    template <typename Edit>
+    bool editImage(std::size_t id, Edit&& edit) {
+        DocumentImage* image = find(id);
+        if (!image) return false;
+        edit(*image);
+        ++generation_;
+        return true;
+    }
     
     // Remove image by ID
     bool removeImage(std::size_t id);
     
-    // Get all images
+    // Get all images, in anchor line order (drawing order is the order
+    // they were added; see anchor_index.h)
     const std::vector<DocumentImage>& images() const { return images_; }
-    std::vector<DocumentImage>& images() { return images_; }
     
     // Get images anchored at a specific line
-    std::vector<DocumentImage*> imagesAtLine(std::size_t line);
-    std::vector<const DocumentImage*> imagesAtLine(std::size_t line) const;
+    std::span<const DocumentImage> imagesAtLine(std::size_t line) const;
     
-    // Get images that affect a specific line range (for text wrap calculation)
-    std::vector<const DocumentImage*> imagesInRange(std::size_t startLine, std::size_t endLine) const;
+    // Get images anchored on lines startLine..endLine (for text wrap calculation)
+    std::span<const DocumentImage> imagesInRange(std::size_t startLine, std::size_t endLine) const;
+    
+    // Images whose drawn rectangle overlaps rows [top, bottom), as indices
+    // into images() in drawing order. Coordinates are pixels from the top
+    // left of the text area at line 0, with lines lineHeight apart and
+    // sizes and offsets scaled by zoom, as renderImages draws them. out is
+    // cleared first and can be reused from frame to frame.
+    void imagesOverlapping(float top, float bottom, float lineHeight, float zoom,
+                           std::vector<std::size_t>& out) const;
+    // Topmost image drawn at (x, y), same coordinates; null if none
+    const DocumentImage* imageAt(float x, float y, float lineHeight, float zoom) const;
     
     // Update anchor positions after text edits
     void shiftAnchorsFrom(std::size_t line, std::ptrdiff_t linesDelta);
@@ -162,8 +194,20 @@ public:
     // Count
     std::size_t count() const { return images_.size(); }
     bool isEmpty() const { return images_.empty(); }
+
+    // Decoded pixels and textures of the embedded images
+    ImageCache& cache() { return cache_; }
+    const ImageCache& cache() const { return cache_; }
+    // An image's embedded data as base64 (e.g. for saving)
+    std::string embeddedBase64(const DocumentImage& image) const;
     
 private:
+    DocumentImage* find(std::size_t id);
+    const AnchorBounds& bounds(float lineHeight, float zoom) const;
+
     std::vector<DocumentImage> images_;
     std::size_t nextId_ = 1;
+    ImageCache cache_;
+    std::uint64_t generation_ = 0;  // Bumped whenever images_ changes
+    mutable AnchorBounds bounds_;
 };
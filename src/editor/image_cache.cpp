@@ -0,0 +1,299 @@
+#include "image_cache.h"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+
+constexpr char kBase64Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+std::uint64_t hashBytes(const std::vector<std::uint8_t>& bytes) {
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::uint8_t byte : bytes) {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Size of the thumbnail of a width x height image
+std::pair<int, int> thumbnailSize(int width, int height) {
+    int longest = std::max(width, height);
+    if (longest <= ImageCache::THUMBNAIL_SIZE) return {width, height};
+    double scale = static_cast<double>(ImageCache::THUMBNAIL_SIZE) / longest;
+    return {std::max(1, static_cast<int>(width * scale + 0.5)),
+            std::max(1, static_cast<int>(height * scale + 0.5))};
+}
+
+// Box filter: each thumbnail pixel averages the source pixels it covers
+ImagePixels downsample(const ImagePixels& source, int width, int height) {
+    ImagePixels result;
+    result.width = width;
+    result.height = height;
+    result.rgba.resize(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 4);
+    for (int y = 0; y < height; ++y) {
+        int y0 = y * source.height / height;
+        int y1 = std::max(y0 + 1, (y + 1) * source.height / height);
+        for (int x = 0; x < width; ++x) {
+            int x0 = x * source.width / width;
+            int x1 = std::max(x0 + 1, (x + 1) * source.width / width);
+            std::array<std::uint32_t, 4> sum{};
+            for (int sy = y0; sy < y1; ++sy) {
+                const std::uint8_t* row =
+                    source.rgba.data() + (static_cast<std::size_t>(sy) * source.width) * 4;
+                for (int sx = x0; sx < x1; ++sx) {
+                    for (std::size_t c = 0; c < 4; ++c) sum[c] += row[sx * 4 + c];
+                }
+            }
+            auto count = static_cast<std::uint32_t>((y1 - y0) * (x1 - x0));
+            std::uint8_t* out =
+                result.rgba.data() + (static_cast<std::size_t>(y) * width + x) * 4;
+            for (std::size_t c = 0; c < 4; ++c) {
+                out[c] = static_cast<std::uint8_t>(sum[c] / count);
+            }
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+// ============================================================================
+// Base64
+// ============================================================================
+
+std::optional<std::vector<std::uint8_t>> decodeBase64(std::string_view text) {
+    static const std::array<std::int8_t, 256> values = [] {
+        std::array<std::int8_t, 256> table;
+        table.fill(-1);
+        for (int i = 0; i < 64; ++i) {
+            table[static_cast<unsigned char>(kBase64Alphabet[i])] = static_cast<std::int8_t>(i);
+        }
+        return table;
+    }();
+
+    // Sized for the whole input up front; trimmed to what was written
+    std::vector<std::uint8_t> bytes(text.size() / 4 * 3 + 3);
+    std::uint8_t* out = bytes.data();
+    std::uint32_t bits = 0;
+    int bitCount = 0;
+    std::size_t padding = 0;
+    for (char ch : text) {
+        std::int8_t value = values[static_cast<unsigned char>(ch)];
+        if (value < 0) {
+            if (ch == '=') {
+                ++padding;
+                continue;
+            }
+            if (ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t') continue;
+            return std::nullopt;
+        }
+        if (padding > 0) return std::nullopt;  // Data after padding
+        bits = (bits << 6) | static_cast<std::uint32_t>(value);
+        bitCount += 6;
+        if (bitCount >= 8) {
+            bitCount -= 8;
+            *out++ = static_cast<std::uint8_t>(bits >> bitCount);
+        }
+    }
+    if (padding > 2 || bitCount >= 6) return std::nullopt;
+    bytes.resize(static_cast<std::size_t>(out - bytes.data()));
+    return bytes;
+}
+
+std::string encodeBase64(const std::vector<std::uint8_t>& bytes) {
+    std::string text;
+    text.reserve((bytes.size() + 2) / 3 * 4);
+    std::size_t i = 0;
+    for (; i + 3 <= bytes.size(); i += 3) {
+        std::uint32_t group = (std::uint32_t{bytes[i]} << 16) |
+                              (std::uint32_t{bytes[i + 1]} << 8) | bytes[i + 2];
+        text += kBase64Alphabet[(group >> 18) & 63];
+        text += kBase64Alphabet[(group >> 12) & 63];
+        text += kBase64Alphabet[(group >> 6) & 63];
+        text += kBase64Alphabet[group & 63];
+    }
+    std::size_t rest = bytes.size() - i;
+    if (rest > 0) {
+        std::uint32_t group = std::uint32_t{bytes[i]} << 16;
+        if (rest == 2) group |= std::uint32_t{bytes[i + 1]} << 8;
+        text += kBase64Alphabet[(group >> 18) & 63];
+        text += kBase64Alphabet[(group >> 12) & 63];
+        text += rest == 2 ? kBase64Alphabet[(group >> 6) & 63] : '=';
+        text += '=';
+    }
+    return text;
+}
+
+// ============================================================================
+// ImageCache
+// ============================================================================
+
+ImageCache::~ImageCache() { clear(); }
+
+void ImageCache::setTextureHooks(TextureHooks hooks) {
+    // Textures made by the old hooks go back through them
+    for (auto& [key, entry] : entries_) releaseTexture(entry);
+    hooks_ = std::move(hooks);
+}
+
+ImageCache::Key ImageCache::add(std::string_view base64) {
+    auto bytes = decodeBase64(base64);
+    if (!bytes || bytes->empty()) return 0;
+    return addBytes(std::move(*bytes));
+}
+
+ImageCache::Key ImageCache::addBytes(std::vector<std::uint8_t> bytes) {
+    Key key = std::max<Key>(hashBytes(bytes), 1);
+    // Step past the (unlikely) different image with the same hash
+    for (auto it = entries_.find(key); it != entries_.end(); it = entries_.find(key)) {
+        if (it->second.bytes == bytes) {
+            it->second.refs++;
+            return key;
+        }
+        key = std::max<Key>(key + 1, 1);
+    }
+    Entry& entry = entries_[key];
+    entry.bytes = std::move(bytes);
+    entry.refs = 1;
+    return key;
+}
+
+void ImageCache::retain(Key key) {
+    auto it = entries_.find(key);
+    if (it != entries_.end()) it->second.refs++;
+}
+
+void ImageCache::release(Key key) {
+    auto it = entries_.find(key);
+    if (it == entries_.end()) return;
+    if (--it->second.refs == 0) {
+        releaseTexture(it->second);
+        entries_.erase(it);
+    }
+}
+
+void ImageCache::clear() {
+    for (auto& [key, entry] : entries_) releaseTexture(entry);
+    entries_.clear();
+}
+
+const std::vector<std::uint8_t>* ImageCache::bytes(Key key) const {
+    auto it = entries_.find(key);
+    return it != entries_.end() ? &it->second.bytes : nullptr;
+}
+
+std::string ImageCache::base64(Key key) const {
+    const std::vector<std::uint8_t>* data = bytes(key);
+    return data ? encodeBase64(*data) : std::string();
+}
+
+const ImagePixels* ImageCache::pixels(Key key) {
+    auto it = entries_.find(key);
+    return it != entries_.end() ? decode(it->second) : nullptr;
+}
+
+const ImagePixels* ImageCache::thumbnail(Key key) {
+    auto it = entries_.find(key);
+    return it != entries_.end() ? makeThumbnail(it->second) : nullptr;
+}
+
+const ImagePixels* ImageCache::decode(Entry& entry) {
+    if (entry.pixels) return &*entry.pixels;
+    if (entry.decodeFailed || !decoder_) return nullptr;
+
+    ImagePixels result;
+    decodes_++;
+    bool valid = decoder_(entry.bytes, result) && result.width > 0 && result.height > 0 &&
+                 result.rgba.size() == static_cast<std::size_t>(result.width) *
+                                           static_cast<std::size_t>(result.height) * 4;
+    if (!valid) {
+        entry.decodeFailed = true;  // Not worth retrying every frame
+        return nullptr;
+    }
+    entry.width = result.width;
+    entry.height = result.height;
+    entry.pixels = std::move(result);
+    return &*entry.pixels;
+}
+
+const ImagePixels* ImageCache::makeThumbnail(Entry& entry) {
+    if (entry.thumbnail) return &*entry.thumbnail;
+    bool hadPixels = entry.pixels.has_value();
+    const ImagePixels* full = decode(entry);
+    if (!full) return nullptr;
+    auto [width, height] = thumbnailSize(full->width, full->height);
+    if (width == full->width && height == full->height) return full;  // Already small
+
+    entry.thumbnail = downsample(*full, width, height);
+    // Decoded only to shrink it: the full size can wait until it is drawn
+    if (!hadPixels) entry.pixels.reset();
+    return &*entry.thumbnail;
+}
+
+ImageCache::TextureHandle ImageCache::texture(Key key, float drawWidth, float drawHeight) {
+    auto it = entries_.find(key);
+    if (it == entries_.end() || !hooks_.upload) return 0;
+    Entry& entry = it->second;
+    if (entry.width == 0 && !decode(entry)) return 0;
+
+    auto [thumbWidth, thumbHeight] = thumbnailSize(entry.width, entry.height);
+    bool small = thumbWidth < entry.width && drawWidth <= static_cast<float>(thumbWidth) &&
+                 drawHeight <= static_cast<float>(thumbHeight);
+    entry.lastDrawn = frame_;
+    if (entry.texture != 0 && entry.textureIsThumbnail == small) return entry.texture;
+
+    const ImagePixels* source = small ? makeThumbnail(entry) : decode(entry);
+    if (!source) return 0;
+    TextureHandle handle = hooks_.upload(*source);
+    releaseTexture(entry);
+    if (handle == 0) return 0;
+    entry.texture = handle;
+    entry.textureIsThumbnail = small;
+    entry.textureSize = source->byteSize();
+    textureBytes_ += entry.textureSize;
+    // On the GPU now; the file bytes can decode it again if needed
+    entry.pixels.reset();
+    return handle;
+}
+
+void ImageCache::endFrame() {
+    if (textureBytes_ > textureBudget_) {
+        std::vector<Entry*> resident;
+        for (auto& [key, entry] : entries_) {
+            if (entry.texture != 0 && entry.lastDrawn < frame_) resident.push_back(&entry);
+        }
+        std::sort(resident.begin(), resident.end(),
+                  [](const Entry* a, const Entry* b) { return a->lastDrawn < b->lastDrawn; });
+        for (Entry* entry : resident) {
+            if (textureBytes_ <= textureBudget_) break;
+            releaseTexture(*entry);
+        }
+    }
+    frame_++;
+}
+
+void ImageCache::releaseTexture(Entry& entry) {
+    if (entry.texture == 0) return;
+    if (hooks_.release) hooks_.release(entry.texture);
+    textureBytes_ -= entry.textureSize;
+    entry.texture = 0;
+    entry.textureSize = 0;
+}
+
+std::size_t ImageCache::encodedBytes() const {
+    std::size_t total = 0;
+    for (const auto& [key, entry] : entries_) total += entry.bytes.size();
+    return total;
+}
+
+std::size_t ImageCache::decodedBytes() const {
+    std::size_t total = 0;
+    for (const auto& [key, entry] : entries_) {
+        if (entry.pixels) total += entry.pixels->byteSize();
+        if (entry.thumbnail) total += entry.thumbnail->byteSize();
+    }
+    return total;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// 8-bit RGBA pixels, row-major
+struct ImagePixels {
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint8_t> rgba;
+
+    std::size_t byteSize() const { return rgba.size(); }
+};
+
+// Base64 (RFC 4648, padded). Whitespace is skipped; anything else that is
+// not in the alphabet makes decoding fail.
+std::optional<std::vector<std::uint8_t>> decodeBase64(std::string_view text);
+std::string encodeBase64(const std::vector<std::uint8_t>& bytes);
+
+// Embedded images by content, so a document can refer to them by a small
+// key instead of carrying their base64 around.
+//
+// Each stage is done once and only when something needs it:
+//   add()        base64 -> encoded file bytes (PNG, JPEG, ...); no pixels yet
+//   pixels()     file bytes -> RGBA, the first time the image is drawn
+//   thumbnail()  RGBA -> a copy at most THUMBNAIL_SIZE on its longest side,
+//                for views that draw the image small (zoomed out)
+//   texture()    either of those -> GPU texture, through TextureHooks
+//
+// Textures are kept under a byte budget. endFrame() releases the least
+// recently drawn ones past it. Full-size pixels are dropped once they are
+// on the GPU, since the file bytes can decode them again.
+class ImageCache {
+   public:
+    using Key = std::uint64_t;  // Hash of the file bytes; 0 = none
+    using Decoder = std::function<bool(const std::vector<std::uint8_t>& bytes, ImagePixels& out)>;
+    using TextureHandle = std::uint64_t;  // 0 = none
+
+    struct TextureHooks {
+        std::function<TextureHandle(const ImagePixels&)> upload;
+        std::function<void(TextureHandle)> release;
+    };
+
+    static constexpr int THUMBNAIL_SIZE = 128;
+    static constexpr std::size_t DEFAULT_TEXTURE_BUDGET = 256 * 1024 * 1024;
+
+    ImageCache() = default;
+    ~ImageCache();
+    ImageCache(const ImageCache&) = delete;
+    ImageCache& operator=(const ImageCache&) = delete;
+
+    // Decoding and textures are up to the caller (the editor core has no
+    // image codecs or GPU)
+    void setDecoder(Decoder decoder) { decoder_ = std::move(decoder); }
+    void setTextureHooks(TextureHooks hooks);
+    void setTextureBudget(std::size_t bytes) { textureBudget_ = bytes; }
+
+    // Add an image, or take another reference to an identical one.
+    // Returns 0 if base64 does not decode.
+    Key add(std::string_view base64);
+    Key addBytes(std::vector<std::uint8_t> bytes);
+    // Another reference to an image already here
+    void retain(Key key);
+    // Drop a reference; the last one frees the image and its texture
+    void release(Key key);
+    void clear();
+
+    bool contains(Key key) const { return entries_.count(key) != 0; }
+    const std::vector<std::uint8_t>* bytes(Key key) const;
+    std::string base64(Key key) const;
+
+    // nullptr if the key is unknown or its bytes do not decode. Full-size
+    // pixels stay valid until the next texture() call.
+    const ImagePixels* pixels(Key key);
+    const ImagePixels* thumbnail(Key key);
+
+    // Texture for drawing the image at drawWidth x drawHeight pixels (the
+    // thumbnail's if that is big enough). 0 without hooks or pixels.
+    TextureHandle texture(Key key, float drawWidth, float drawHeight);
+    // Release textures over budget, least recently used first (none that
+    // were drawn this frame)
+    void endFrame();
+
+    std::size_t imageCount() const { return entries_.size(); }
+    std::size_t encodedBytes() const;
+    std::size_t decodedBytes() const;
+    std::size_t textureBytes() const { return textureBytes_; }
+    std::size_t decodeCount() const { return decodes_; }
+
+   private:
+    struct Entry {
+        std::vector<std::uint8_t> bytes;
+        std::size_t refs = 0;
+        std::optional<ImagePixels> pixels;
+        std::optional<ImagePixels> thumbnail;
+        bool decodeFailed = false;
+        int width = 0;  // Known after the first decode
+        int height = 0;
+
+        TextureHandle texture = 0;
+        bool textureIsThumbnail = false;
+        std::size_t textureSize = 0;
+        std::uint64_t lastDrawn = 0;
+    };
+
+    const ImagePixels* decode(Entry& entry);
+    const ImagePixels* makeThumbnail(Entry& entry);
+    void releaseTexture(Entry& entry);
+
+    std::unordered_map<Key, Entry> entries_;
+    Decoder decoder_;
+    TextureHooks hooks_;
+    std::size_t textureBudget_ = DEFAULT_TEXTURE_BUDGET;
+    std::size_t textureBytes_ = 0;
+    std::uint64_t frame_ = 1;
+    std::size_t decodes_ = 0;
+};
@@ -0,0 +1,296 @@
+#include "incremental_checker.h"
+
+#include <algorithm>
+
+namespace {
+const std::vector<Squiggle> kNoSquiggles;
+}
+
+IncrementalChecker::IncrementalChecker() {
+    worker_ = std::thread([this] { workerLoop(); });
+}
+
+IncrementalChecker::~IncrementalChecker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        jobs_.clear();
+    }
+    wake_.notify_all();
+    if (worker_.joinable()) worker_.join();
+}
+
+std::uint64_t IncrementalChecker::hashParagraph(std::string_view text) {
+    // FNV-1a; paragraphs are short and this runs only on dirty rows
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char ch : text) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// ============================================================================
+// Worker thread
+// ============================================================================
+
+void IncrementalChecker::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+        if (stopping_) return;
+
+        Job job = std::move(jobs_.front());
+        jobs_.pop_front();
+        ++busy_;
+        lock.unlock();
+
+        Result result;
+        result.hash = job.hash;
+        result.generation = job.generation;
+        result.check = checkParagraph(job.text);
+
+        lock.lock();
+        --busy_;
+        done_.push_back(std::move(result));
+        if (jobs_.empty() && busy_ == 0) idle_.notify_all();
+    }
+}
+
+ParagraphCheck IncrementalChecker::checkParagraph(const std::string& text) const {
+    ParagraphCheck check;
+    std::lock_guard<std::mutex> lock(checkerMutex_);
+
+    if (spellingEnabled_) {
+        // Only flag words here; suggestions are computed when the user asks
+        SpellChecker::forEachWord(text, [&](std::size_t offset, std::string_view word) {
+            if (!spell_.isCorrect(word)) {
+                check.squiggles.push_back({offset, word.size(), SquiggleKind::Spelling});
+            }
+        });
+    }
+    if (grammarEnabled_) {
+        for (const auto& error : grammar_.checkText(text)) {
+            check.squiggles.push_back({error.offset, error.length, SquiggleKind::Grammar});
+        }
+    }
+
+    std::sort(check.squiggles.begin(), check.squiggles.end(),
+              [](const Squiggle& a, const Squiggle& b) { return a.column < b.column; });
+    return check;
+}
+
+// ============================================================================
+// UI thread
+// ============================================================================
+
+void IncrementalChecker::update(TextBuffer& buffer) {
+    mergeResults();
+
+    std::size_t lineCount = buffer.lineCount();
+    DirtyLines dirty = buffer.takeDirtyLines();
+    if (dirty.any && lineCount > 0) {
+        // Splice the edited rows into the hash table. Anything that does not
+        // line up (first run, setText, buffer swapped) falls back to a full
+        // rehash, which still reuses cached results for unchanged text.
+        auto oldSize = static_cast<std::ptrdiff_t>(rowHashes_.size());
+        auto oldLast = static_cast<std::ptrdiff_t>(dirty.last) - dirty.lineDelta;
+        bool spliceable = !dirty.all && dirty.last < lineCount &&
+                          oldSize + dirty.lineDelta == static_cast<std::ptrdiff_t>(lineCount) &&
+                          oldLast + 1 >= static_cast<std::ptrdiff_t>(dirty.first) &&
+                          oldLast < oldSize;
+        if (spliceable) {
+            // Grow or shrink the edited span in place; typing within a line
+            // leaves the table size alone
+            auto spanEnd = rowHashes_.begin() + oldLast + 1;
+            if (dirty.lineDelta > 0) {
+                rowHashes_.insert(spanEnd, static_cast<std::size_t>(dirty.lineDelta), 0);
+            } else if (dirty.lineDelta < 0) {
+                rowHashes_.erase(spanEnd + dirty.lineDelta, spanEnd);
+            }
+            rehashRows(buffer, dirty.first, dirty.last);
+        } else {
+            rowHashes_.assign(lineCount, 0);
+            rehashRows(buffer, 0, lineCount - 1);
+        }
+        pruneCache();
+        resultsVersion_++;  // Rows now look up different results
+    }
+
+    if (requeueAll_) {
+        requeueAll_ = false;
+        requeueAllRows(buffer);
+    }
+}
+
+void IncrementalChecker::flush(TextBuffer& buffer) {
+    update(buffer);
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return jobs_.empty() && busy_ == 0; });
+    }
+    mergeResults();
+}
+
+bool IncrementalChecker::wantsCheck(std::uint64_t hash) {
+    if (cache_.count(hash) > 0) {
+        stats_.cacheHits++;
+        return false;
+    }
+    return inFlight_.insert(hash).second;
+}
+
+void IncrementalChecker::rehashRows(const TextBuffer& buffer, std::size_t first,
+                                    std::size_t last) {
+    std::vector<Job> jobs;
+    for (std::size_t row = first; row <= last; ++row) {
+        std::string text = buffer.lineString(row);
+        std::uint64_t hash = hashParagraph(text);
+        rowHashes_[row] = hash;
+        if (text.empty()) {
+            cache_.try_emplace(hash);
+        } else if (wantsCheck(hash)) {
+            jobs.push_back({hash, 0, std::move(text)});
+        }
+    }
+    submit(jobs);
+}
+
+void IncrementalChecker::requeueAllRows(const TextBuffer& buffer) {
+    std::vector<Job> jobs;
+    std::size_t rows = std::min(rowHashes_.size(), buffer.lineCount());
+    for (std::size_t row = 0; row < rows; ++row) {
+        std::uint64_t hash = rowHashes_[row];
+        if (cache_.count(hash) > 0 || inFlight_.count(hash) > 0) continue;
+        std::string text = buffer.lineString(row);
+        if (text.empty()) {
+            cache_.try_emplace(hash);
+            continue;
+        }
+        inFlight_.insert(hash);
+        jobs.push_back({hash, 0, std::move(text)});
+    }
+    submit(jobs);
+}
+
+void IncrementalChecker::submit(std::vector<Job>& jobs) {
+    if (jobs.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& job : jobs) {
+            job.generation = generation_;
+            jobs_.push_back(std::move(job));
+        }
+    }
+    stats_.queued += jobs.size();
+    wake_.notify_one();
+}
+
+void IncrementalChecker::mergeResults() {
+    std::vector<Result> finished;
+    std::uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (done_.empty()) return;
+        finished.swap(done_);
+        generation = generation_;
+    }
+    for (auto& result : finished) {
+        if (result.generation != generation) continue;  // Settings changed since
+        inFlight_.erase(result.hash);
+        cache_[result.hash] = std::move(result.check);
+        stats_.paragraphsChecked++;
+    }
+    resultsVersion_++;
+}
+
+void IncrementalChecker::pruneCache() {
+    // Undo and retyping often bring old text back, so keep some history
+    if (cache_.size() <= 2 * rowHashes_.size() + 256) return;
+    std::unordered_set<std::uint64_t> live(rowHashes_.begin(), rowHashes_.end());
+    for (auto it = cache_.begin(); it != cache_.end();) {
+        it = live.count(it->first) > 0 ? std::next(it) : cache_.erase(it);
+    }
+}
+
+void IncrementalChecker::invalidate() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        generation_++;
+        jobs_.clear();
+    }
+    cache_.clear();
+    inFlight_.clear();
+    requeueAll_ = true;
+    resultsVersion_++;
+}
+
+const std::vector<Squiggle>& IncrementalChecker::squigglesForRow(std::size_t row) const {
+    if (row >= rowHashes_.size()) return kNoSquiggles;
+    auto it = cache_.find(rowHashes_[row]);
+    return it != cache_.end() ? it->second.squiggles : kNoSquiggles;
+}
+
+bool IncrementalChecker::isRowPending(std::size_t row) const {
+    return row < rowHashes_.size() && cache_.count(rowHashes_[row]) == 0;
+}
+
+// ============================================================================
+// Configuration
+// ============================================================================
+
+void IncrementalChecker::setSpellingEnabled(bool enabled) {
+    if (enabled == spellingEnabled_) return;
+    {
+        std::lock_guard<std::mutex> lock(checkerMutex_);
+        spellingEnabled_ = enabled;
+    }
+    invalidate();
+}
+
+void IncrementalChecker::setGrammarEnabled(bool enabled) {
+    if (enabled == grammarEnabled_) return;
+    {
+        std::lock_guard<std::mutex> lock(checkerMutex_);
+        grammarEnabled_ = enabled;
+    }
+    invalidate();
+}
+
+void IncrementalChecker::addToUserDictionary(const std::string& word) {
+    {
+        std::lock_guard<std::mutex> lock(checkerMutex_);
+        spell_.addToUserDictionary(word);
+    }
+    invalidate();
+}
+
+void IncrementalChecker::ignoreWord(const std::string& word) {
+    {
+        std::lock_guard<std::mutex> lock(checkerMutex_);
+        spell_.ignoreWord(word);
+    }
+    invalidate();
+}
+
+void IncrementalChecker::setGrammarRuleEnabled(const std::string& ruleId, bool enabled) {
+    {
+        std::lock_guard<std::mutex> lock(checkerMutex_);
+        if (enabled) {
+            grammar_.enableRule(ruleId);
+        } else {
+            grammar_.disableRule(ruleId);
+        }
+    }
+    invalidate();
+}
+
+bool IncrementalChecker::loadDictionary(const std::string& path) {
+    bool loaded = false;
+    {
+        std::lock_guard<std::mutex> lock(checkerMutex_);
+        loaded = spell_.loadDictionary(path);
+    }
+    if (loaded) invalidate();
+    return loaded;
+}
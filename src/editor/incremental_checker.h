@@ -0,0 +1,134 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "spellcheck.h"
+#include "text_buffer.h"
+
+enum class SquiggleKind { Spelling, Grammar };
+
+// Underline range within one row, in byte columns
+struct Squiggle {
+    std::size_t column = 0;
+    std::size_t length = 0;
+    SquiggleKind kind = SquiggleKind::Spelling;
+};
+
+// Results for one paragraph (buffer row), keyed by its content hash
+struct ParagraphCheck {
+    std::vector<Squiggle> squiggles;
+};
+
+struct IncrementalCheckerStats {
+    std::size_t paragraphsChecked = 0;  // Jobs completed by the worker
+    std::size_t cacheHits = 0;          // Dirty rows whose hash was already cached
+    std::size_t queued = 0;             // Jobs handed to the worker
+};
+
+// Background spelling and grammar checking for a TextBuffer.
+//
+// update() runs on the UI thread once per frame. It takes the buffer's dirty
+// row range, rehashes only those rows and queues any paragraph whose hash is
+// not cached. A worker thread checks each queued paragraph against its own
+// copy of the text, so typing never waits on the checkers. Finished results
+// are merged on the next update() and looked up by row hash when rendering.
+//
+// Grammar rules run per paragraph, so sentence capitalization restarts at
+// each line (matching how the editor treats lines as paragraphs).
+class IncrementalChecker {
+   public:
+    IncrementalChecker();
+    ~IncrementalChecker();
+    IncrementalChecker(const IncrementalChecker&) = delete;
+    IncrementalChecker& operator=(const IncrementalChecker&) = delete;
+
+    // Sync with edits and merge finished results. Cheap when nothing changed.
+    void update(TextBuffer& buffer);
+
+    // Block until the worker has drained the queue, then merge results.
+    // For tests and headless use; the editor only calls update().
+    void flush(TextBuffer& buffer);
+
+    // Squiggles for a row as of the last update(); empty while pending
+    const std::vector<Squiggle>& squigglesForRow(std::size_t row) const;
+    bool isRowPending(std::size_t row) const;
+
+    // Bumped whenever merged results change what squigglesForRow returns
+    std::uint64_t resultsVersion() const { return resultsVersion_; }
+
+    void setSpellingEnabled(bool enabled);
+    void setGrammarEnabled(bool enabled);
+    bool spellingEnabled() const { return spellingEnabled_; }
+    bool grammarEnabled() const { return grammarEnabled_; }
+
+    // Checker configuration. Each call drops cached results so every
+    // paragraph is re-checked with the new settings.
+    void addToUserDictionary(const std::string& word);
+    void ignoreWord(const std::string& word);
+    void setGrammarRuleEnabled(const std::string& ruleId, bool enabled);
+    bool loadDictionary(const std::string& path);
+
+    std::size_t cachedParagraphs() const { return cache_.size(); }
+    const IncrementalCheckerStats& stats() const { return stats_; }
+
+    static std::uint64_t hashParagraph(std::string_view text);
+
+   private:
+    struct Job {
+        std::uint64_t hash = 0;
+        std::uint64_t generation = 0;
+        std::string text;
+    };
+    struct Result {
+        std::uint64_t hash = 0;
+        std::uint64_t generation = 0;
+        ParagraphCheck check;
+    };
+
+    void workerLoop();
+    ParagraphCheck checkParagraph(const std::string& text) const;
+    void mergeResults();
+    void rehashRows(const TextBuffer& buffer, std::size_t first, std::size_t last);
+    void requeueAllRows(const TextBuffer& buffer);
+    bool wantsCheck(std::uint64_t hash);
+    void submit(std::vector<Job>& jobs);
+    void invalidate();
+    void pruneCache();
+
+    // Checker configuration (guarded by checkerMutex_; the UI thread only
+    // locks it to change settings, so queueing work never waits on a check)
+    SpellChecker spell_;
+    GrammarChecker grammar_;
+    bool spellingEnabled_ = true;
+    bool grammarEnabled_ = true;
+    mutable std::mutex checkerMutex_;
+
+    // Work queues (guarded by mutex_)
+    std::deque<Job> jobs_;
+    std::vector<Result> done_;
+    std::size_t busy_ = 0;
+    bool stopping_ = false;
+    std::uint64_t generation_ = 0;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::thread worker_;
+
+    // UI-thread state
+    std::vector<std::uint64_t> rowHashes_;
+    std::unordered_map<std::uint64_t, ParagraphCheck> cache_;
+    std::unordered_set<std::uint64_t> inFlight_;
+    bool requeueAll_ = false;
+    std::uint64_t resultsVersion_ = 0;
+    IncrementalCheckerStats stats_;
+};
@@ -0,0 +1,267 @@
+#include "json_scan.h"
+
+#include <cstring>
+
+namespace json_scan {
+
+namespace {
+
+bool isWhitespace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool readHex4(std::string_view json, std::size_t pos, unsigned int& out) {
+    if (pos + 4 > json.size()) return false;
+    out = 0;
+    for (std::size_t i = 0; i < 4; ++i) {
+        int v = hexValue(json[pos + i]);
+        if (v < 0) return false;
+        out = (out << 4) | static_cast<unsigned int>(v);
+    }
+    return true;
+}
+
+// Output targets for decodeString: a growing std::string, or caller-owned
+// storage with room for the raw literal (decoding never lengthens text)
+struct StringOut {
+    std::string& str;
+    void append(const char* data, std::size_t len) { str.append(data, len); }
+    void push_back(char c) { str.push_back(c); }
+};
+
+struct RawOut {
+    char* out;
+    std::size_t written = 0;
+    void append(const char* data, std::size_t len) {
+        std::memcpy(out + written, data, len);
+        written += len;
+    }
+    void push_back(char c) { out[written++] = c; }
+};
+
+template <typename Out>
+void appendUtf8(Out& out, unsigned int cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+template <typename Out>
+std::size_t decodeInto(std::string_view json, std::size_t pos, Out& out) {
+    if (pos >= json.size() || json[pos] != '"') return npos;
+    ++pos;
+
+    std::size_t runStart = pos;
+    while (pos < json.size()) {
+        char c = json[pos];
+        if (c == '"') {
+            out.append(json.data() + runStart, pos - runStart);
+            return pos + 1;
+        }
+        if (static_cast<unsigned char>(c) < 0x20) {
+            return npos;  // Unescaped control characters are invalid JSON
+        }
+        if (c != '\\') {
+            ++pos;
+            continue;
+        }
+
+        out.append(json.data() + runStart, pos - runStart);
+        if (pos + 1 >= json.size()) return npos;
+        char esc = json[pos + 1];
+        pos += 2;
+        switch (esc) {
+            case '"': out.push_back('"'); break;
+            case '\\': out.push_back('\\'); break;
+            case '/': out.push_back('/'); break;
+            case 'b': out.push_back('\b'); break;
+            case 'f': out.push_back('\f'); break;
+            case 'n': out.push_back('\n'); break;
+            case 'r': out.push_back('\r'); break;
+            case 't': out.push_back('\t'); break;
+            case 'u': {
+                unsigned int cp = 0;
+                if (!readHex4(json, pos, cp)) return npos;
+                pos += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    // High surrogate must be followed by \uDC00-\uDFFF
+                    unsigned int low = 0;
+                    if (pos + 1 >= json.size() || json[pos] != '\\' || json[pos + 1] != 'u' ||
+                        !readHex4(json, pos + 2, low) || low < 0xDC00 || low > 0xDFFF) {
+                        return npos;
+                    }
+                    pos += 6;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return npos;
+                }
+                appendUtf8(out, cp);
+                break;
+            }
+            default:
+                return npos;
+        }
+        runStart = pos;
+    }
+    return npos;
+}
+
+}  // namespace
+
+std::size_t skipWhitespace(std::string_view json, std::size_t pos) {
+    while (pos < json.size() && isWhitespace(json[pos])) ++pos;
+    return pos;
+}
+
+std::size_t skipString(std::string_view json, std::size_t pos) {
+    if (pos >= json.size() || json[pos] != '"') return npos;
+    ++pos;
+    while (pos < json.size()) {
+        char c = json[pos];
+        if (c == '"') return pos + 1;
+        if (c == '\\') {
+            pos += 2;
+            continue;
+        }
+        ++pos;
+    }
+    return npos;
+}
+
+std::size_t skipValue(std::string_view json, std::size_t pos) {
+    pos = skipWhitespace(json, pos);
+    if (pos >= json.size()) return npos;
+
+    char c = json[pos];
+    if (c == '"') return skipString(json, pos);
+
+    if (c == '{' || c == '[') {
+        // Track nesting depth; strings are skipped whole so brackets inside
+        // them are ignored.
+        std::size_t depth = 0;
+        while (pos < json.size()) {
+            char ch = json[pos];
+            if (ch == '"') {
+                pos = skipString(json, pos);
+                if (pos == npos) return npos;
+                continue;
+            }
+            if (ch == '{' || ch == '[') {
+                ++depth;
+            } else if (ch == '}' || ch == ']') {
+                if (depth == 0) return npos;
+                if (--depth == 0) return pos + 1;
+            }
+            ++pos;
+        }
+        return npos;
+    }
+
+    // Number or literal: runs until a structural character or whitespace
+    std::size_t start = pos;
+    while (pos < json.size()) {
+        char ch = json[pos];
+        if (ch == ',' || ch == '}' || ch == ']' || ch == ':' || isWhitespace(ch)) break;
+        ++pos;
+    }
+    return pos > start ? pos : npos;
+}
+
+std::size_t decodeString(std::string_view json, std::size_t pos, std::string& out) {
+    StringOut sink{out};
+    return decodeInto(json, pos, sink);
+}
+
+std::size_t decodeString(std::string_view json, std::size_t pos, char* out,
+                         std::size_t& written) {
+    RawOut sink{out};
+    std::size_t end = decodeInto(json, pos, sink);
+    written = sink.written;
+    return end;
+}
+
+bool forEachMemberAt(std::string_view json, std::size_t pos, const MemberVisitor& visit) {
+    pos = skipWhitespace(json, pos);
+    if (pos >= json.size() || json[pos] != '{') return false;
+    pos = skipWhitespace(json, pos + 1);
+    if (pos < json.size() && json[pos] == '}') return true;
+
+    while (pos < json.size()) {
+        if (json[pos] != '"') return false;
+        std::size_t keyEnd = skipString(json, pos);
+        if (keyEnd == npos) return false;
+        std::string_view key = json.substr(pos + 1, keyEnd - pos - 2);
+
+        pos = skipWhitespace(json, keyEnd);
+        if (pos >= json.size() || json[pos] != ':') return false;
+        std::size_t valueBegin = skipWhitespace(json, pos + 1);
+        std::size_t valueEnd = skipValue(json, valueBegin);
+        if (valueEnd == npos) return false;
+
+        if (!visit(key, valueBegin, valueEnd)) return true;
+
+        pos = skipWhitespace(json, valueEnd);
+        if (pos >= json.size()) return false;
+        if (json[pos] == '}') return true;
+        if (json[pos] != ',') return false;
+        pos = skipWhitespace(json, pos + 1);
+    }
+    return false;
+}
+
+bool forEachElementAt(std::string_view json, std::size_t pos, const ElementVisitor& visit) {
+    pos = skipWhitespace(json, pos);
+    if (pos >= json.size() || json[pos] != '[') return false;
+    pos = skipWhitespace(json, pos + 1);
+    if (pos < json.size() && json[pos] == ']') return true;
+
+    while (pos < json.size()) {
+        std::size_t valueEnd = skipValue(json, pos);
+        if (valueEnd == npos) return false;
+
+        if (!visit(pos, valueEnd)) return true;
+
+        pos = skipWhitespace(json, valueEnd);
+        if (pos >= json.size()) return false;
+        if (json[pos] == ']') return true;
+        if (json[pos] != ',') return false;
+        pos = skipWhitespace(json, pos + 1);
+    }
+    return false;
+}
+
+bool forEachMember(std::string_view json, const MemberVisitor& visit) {
+    return forEachMemberAt(json, 0, visit);
+}
+
+bool findMember(std::string_view json, std::string_view key, std::size_t& valueBegin,
+                std::size_t& valueEnd) {
+    bool found = false;
+    forEachMember(json, [&](std::string_view k, std::size_t b, std::size_t e) {
+        if (k != key) return true;
+        valueBegin = b;
+        valueEnd = e;
+        found = true;
+        return false;
+    });
+    return found;
+}
+
+}  // namespace json_scan
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// Minimal forward-only JSON scanner.
+// Used where we only need one or two members of a large document (e.g. the
+// "text" field of a .wpdoc) and building a full nlohmann::json DOM would
+// allocate a node per value plus a second copy of every string. The scanner
+// works directly on a borrowed buffer (typically a MappedFile view) and never
+// allocates unless asked to decode a string.
+//
+// All functions take the position of the first character of a token and
+// return the position just past it, or std::string_view::npos when the
+// input is malformed or truncated.
+namespace json_scan {
+
+constexpr std::size_t npos = std::string_view::npos;
+
+// Skip JSON whitespace (space, tab, CR, LF)
+std::size_t skipWhitespace(std::string_view json, std::size_t pos);
+
+// Skip a string literal; pos must point at the opening quote
+std::size_t skipString(std::string_view json, std::size_t pos);
+
+// Skip any value (string, number, literal, object or array)
+std::size_t skipValue(std::string_view json, std::size_t pos);
+
+// Decode a string literal (pos at the opening quote) and append the UTF-8
+// result to out. Handles all JSON escapes including surrogate pairs.
+std::size_t decodeString(std::string_view json, std::size_t pos, std::string& out);
+
+// Same, writing into caller-owned storage. Decoded text is never longer
+// than the raw literal, so out needs room for (end - pos) bytes; the
+// number of bytes written is stored in written.
+std::size_t decodeString(std::string_view json, std::size_t pos, char* out,
+                         std::size_t& written);
+
+// Visit each member of the top-level object. The key is the raw text
+// between the quotes (escapes are not decoded, which is fine for the ASCII
+// keys our formats use). [valueBegin, valueEnd) spans the raw value.
+// Return false from the callback to stop early.
+// Returns false if the document is not a well-formed object.
+using MemberVisitor = std::function<bool(std::string_view key, std::size_t valueBegin,
+                                         std::size_t valueEnd)>;
+bool forEachMember(std::string_view json, const MemberVisitor& visit);
+
+// Same as forEachMember but for the object starting at pos
+bool forEachMemberAt(std::string_view json, std::size_t pos, const MemberVisitor& visit);
+
+// Visit each element of the array starting at pos. [valueBegin, valueEnd)
+// spans the raw element. Return false from the callback to stop early.
+using ElementVisitor = std::function<bool(std::size_t valueBegin, std::size_t valueEnd)>;
+bool forEachElementAt(std::string_view json, std::size_t pos, const ElementVisitor& visit);
+
+// Locate a top-level member by key. Returns false if absent or malformed.
+bool findMember(std::string_view json, std::string_view key, std::size_t& valueBegin,
+                std::size_t& valueEnd);
+
+}  // namespace json_scan
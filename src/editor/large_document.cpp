@@ -0,0 +1,366 @@
+#include "large_document.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <system_error>
+
+namespace {
+
+constexpr std::uint64_t kSearchChunk = 4 * 1024 * 1024;
+
+std::string lowercaseExtension(const std::string& path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    for (char& ch : extension) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    return extension;
+}
+
+// Same rule as TextBuffer's whole-word search
+bool isWholeWord(std::string_view text, std::size_t pos, std::size_t length) {
+    bool startOk = pos == 0 || !std::isalnum(static_cast<unsigned char>(text[pos - 1]));
+    std::size_t end = pos + length;
+    bool endOk = end >= text.size() || !std::isalnum(static_cast<unsigned char>(text[end]));
+    return startOk && endOk;
+}
+
+using Searcher = std::boyer_moore_horspool_searcher<std::string_view::const_iterator>;
+
+// First (or last) acceptable match starting in [begin, end). Without case
+// sensitivity the region is lowercased into scratch first, which keeps the
+// searcher on its fast byte table; needle is then lowercase already.
+std::uint64_t searchRange(std::string_view text, std::uint64_t begin, std::uint64_t end,
+                          std::string_view needle, const FindOptions& options, bool wantLast,
+                          const Searcher& searcher, std::string& scratch) {
+    std::uint64_t regionEnd = std::min<std::uint64_t>(text.size(), end + needle.size() - 1);
+    std::string_view haystack = text.substr(begin, regionEnd - begin);
+    if (!options.caseSensitive) {
+        scratch.resize(haystack.size());
+        std::transform(haystack.begin(), haystack.end(), scratch.begin(), [](char ch) {
+            return static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+        });
+        haystack = scratch;
+    }
+
+    std::uint64_t last = LargeDocument::npos;
+    auto it = haystack.begin();
+    while (it < haystack.end()) {
+        auto found = std::search(it, haystack.end(), searcher);
+        if (found == haystack.end()) break;
+        std::uint64_t pos = begin + static_cast<std::uint64_t>(found - haystack.begin());
+        if (pos >= end) break;
+        if (!options.wholeWord || isWholeWord(text, pos, needle.size())) {
+            if (!wantLast) return pos;
+            last = pos;
+        }
+        it = found + 1;
+    }
+    return last;
+}
+
+}  // namespace
+
+LargeDocument::~LargeDocument() {
+    stopIndexing_ = true;
+    if (indexer_.joinable()) indexer_.join();
+}
+
+bool LargeDocument::wantsFile(const std::string& path) {
+    std::string extension = lowercaseExtension(path);
+    if (extension == ".wpdoc" || extension == ".wpdb" || extension == ".docx" ||
+        extension == ".odt") {
+        return false;
+    }
+    std::error_code ec;
+    std::uintmax_t size = std::filesystem::file_size(path, ec);
+    return !ec && size >= THRESHOLD;
+}
+
+bool LargeDocument::open(const std::string& path) {
+    if (!file_.open(path)) {
+        error_ = "Could not open file: " + path;
+        return false;
+    }
+    path_ = path;
+    checkpoints_.assign(1, 0);
+    lineCount_ = 1;
+    indexer_ = std::thread([this] { buildIndex(); });
+    return true;
+}
+
+void LargeDocument::waitForIndex() {
+    if (indexer_.joinable()) indexer_.join();
+}
+
+// ============================================================================
+// Line index
+// ============================================================================
+
+void LargeDocument::buildIndex() {
+    const char* data = file_.data();
+    const std::size_t size = file_.size();
+    std::vector<std::uint64_t> pending;
+    std::size_t lines = 1;
+    std::size_t at = 0;
+    while (at < size && !stopIndexing_) {
+        const void* found = std::memchr(data + at, '\n', size - at);
+        if (!found) break;
+        at = static_cast<std::size_t>(static_cast<const char*>(found) - data) + 1;
+        if (lines % CHECKPOINT_LINES == 0) pending.push_back(at);
+        ++lines;
+        // Publish as we go so the window can move while indexing continues
+        if (pending.size() == 64) {
+            std::lock_guard<std::mutex> lock(indexMutex_);
+            checkpoints_.insert(checkpoints_.end(), pending.begin(), pending.end());
+            pending.clear();
+            lineCount_.store(lines, std::memory_order_release);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(indexMutex_);
+        checkpoints_.insert(checkpoints_.end(), pending.begin(), pending.end());
+        checkpoints_.shrink_to_fit();
+    }
+    if (!stopIndexing_) {
+        lineCount_.store(lines, std::memory_order_release);
+        indexed_.store(true, std::memory_order_release);
+    }
+}
+
+std::uint64_t LargeDocument::lineOffset(std::size_t row) const {
+    std::uint64_t at = 0;
+    std::size_t fromRow = 0;
+    {
+        std::lock_guard<std::mutex> lock(indexMutex_);
+        std::size_t checkpoint = std::min(row / CHECKPOINT_LINES, checkpoints_.size() - 1);
+        at = checkpoints_[checkpoint];
+        fromRow = checkpoint * CHECKPOINT_LINES;
+    }
+    const char* data = file_.data();
+    const std::size_t size = file_.size();
+    for (; fromRow < row; ++fromRow) {
+        if (at >= size) return npos;
+        const void* found = std::memchr(data + at, '\n', size - at);
+        if (!found) return npos;
+        at = static_cast<std::uint64_t>(static_cast<const char*>(found) - data) + 1;
+    }
+    return at;
+}
+
+std::size_t LargeDocument::rowOfOffset(std::uint64_t offset) const {
+    std::uint64_t at = 0;
+    std::size_t row = 0;
+    {
+        std::lock_guard<std::mutex> lock(indexMutex_);
+        auto after = std::upper_bound(checkpoints_.begin(), checkpoints_.end(), offset);
+        std::size_t checkpoint = static_cast<std::size_t>(after - checkpoints_.begin()) - 1;
+        at = checkpoints_[checkpoint];
+        row = checkpoint * CHECKPOINT_LINES;
+    }
+    const char* data = file_.data();
+    std::uint64_t end = std::min<std::uint64_t>(offset, file_.size());
+    while (at < end) {
+        const void* found = std::memchr(data + at, '\n', end - at);
+        if (!found) break;
+        at = static_cast<std::uint64_t>(static_cast<const char*>(found) - data) + 1;
+        ++row;
+    }
+    return row;
+}
+
+std::string_view LargeDocument::line(std::size_t row) const {
+    std::uint64_t at = lineOffset(row);
+    if (at == npos) return {};
+    std::string_view rest = file_.view().substr(at);
+    std::size_t length = std::min(rest.find('\n'), rest.size());
+    if (length > 0 && rest[length - 1] == '\r') --length;
+    return rest.substr(0, length);
+}
+
+// ============================================================================
+// Window
+// ============================================================================
+
+void LargeDocument::loadWindow(TextBuffer& buffer, std::size_t firstRow) {
+    captureFormats(buffer);
+
+    std::uint64_t at = lineOffset(firstRow);
+    if (at == npos) {
+        firstRow = 0;
+        at = 0;
+    }
+    std::string text;
+    std::size_t lines = 0;
+    std::string_view bytes = file_.view();
+    while (lines < WINDOW_LINES) {
+        if (lines > 0) text.push_back('\n');
+        std::string_view rest = bytes.substr(at);
+        std::size_t newline = rest.find('\n');
+        std::string_view content = rest.substr(0, std::min(newline, rest.size()));
+        if (!content.empty() && content.back() == '\r') content.remove_suffix(1);
+        if (content.size() > MAX_LINE_BYTES) {
+            std::size_t cut = MAX_LINE_BYTES;
+            while (cut > 0 && (static_cast<unsigned char>(content[cut]) & 0xC0) == 0x80) --cut;
+            content = content.substr(0, cut);
+        }
+        text.append(content);
+        ++lines;
+        if (newline == std::string_view::npos) break;
+        at += newline + 1;
+    }
+
+    buffer.setText(text);
+    windowFirst_ = firstRow;
+    windowLines_ = buffer.lineCount();
+    windowGeneration_ = buffer.loadGeneration();
+    for (auto it = formats_.lower_bound(firstRow);
+         it != formats_.end() && it->first < firstRow + windowLines_; ++it) {
+        buffer.setLineFormat(it->first - firstRow, it->second);
+    }
+}
+
+void LargeDocument::captureFormats(const TextBuffer& buffer) {
+    if (!ownsWindow(buffer)) return;
+    auto first = formats_.lower_bound(windowFirst_);
+    auto last = formats_.lower_bound(windowFirst_ + windowLines_);
+    formats_.erase(first, last);
+    for (std::size_t row = 0; row < windowLines_; ++row) {
+        ParagraphFormat format = buffer.lineFormat(row);
+        if (!format.isDefault()) formats_.emplace(windowFirst_ + row, format);
+    }
+}
+
+ParagraphFormat LargeDocument::lineFormat(std::size_t row) const {
+    auto found = formats_.find(row);
+    return found == formats_.end() ? ParagraphFormat{} : found->second;
+}
+
+std::ptrdiff_t LargeDocument::followView(TextBuffer& buffer, std::size_t topRow,
+                                         std::size_t visibleRows) {
+    if (!ownsWindow(buffer)) return 0;
+    bool nearTop = topRow < visibleRows && windowFirst_ > 0;
+    bool nearBottom = topRow + 2 * visibleRows >= windowLines_ &&
+                      windowFirst_ + windowLines_ < lineCount();
+    if (!nearTop && !nearBottom) return 0;
+
+    std::size_t absoluteTop = windowFirst_ + topRow;
+    std::size_t newFirst = absoluteTop - std::min(absoluteTop, WINDOW_LINES / 2);
+    if (newFirst == windowFirst_) return 0;
+
+    std::size_t oldFirst = windowFirst_;
+    CaretPosition caret = buffer.caret();
+    std::size_t caretRow = oldFirst + caret.row;
+    loadWindow(buffer, newFirst);
+
+    // Keep the caret on its line of the file, or the nearest line shown
+    std::size_t row = std::clamp(caretRow, windowFirst_, windowFirst_ + windowLines_ - 1) -
+                      windowFirst_;
+    buffer.setCaret({row, std::min(caret.column, buffer.lineSpan(row).length)});
+    return static_cast<std::ptrdiff_t>(oldFirst) - static_cast<std::ptrdiff_t>(windowFirst_);
+}
+
+void LargeDocument::goToLine(TextBuffer& buffer, std::size_t row, std::size_t column) {
+    std::size_t total = lineCount();
+    if (total > 0) row = std::min(row, total - 1);
+    // Reload unless the row sits comfortably inside the window already
+    std::size_t margin = WINDOW_LINES / 8;
+    bool inside = ownsWindow(buffer) && row >= windowFirst_ &&
+                  row < windowFirst_ + windowLines_ &&
+                  (row >= windowFirst_ + margin || windowFirst_ == 0) &&
+                  (row + margin < windowFirst_ + windowLines_ ||
+                   windowFirst_ + windowLines_ >= total);
+    if (!inside) {
+        loadWindow(buffer, row - std::min(row, WINDOW_LINES / 2));
+    }
+    std::size_t bufferRow = std::min(row - windowFirst_, windowLines_ - 1);
+    buffer.clearSelection();
+    buffer.setCaret({bufferRow, std::min(column, buffer.lineSpan(bufferRow).length)});
+}
+
+// ============================================================================
+// Find
+// ============================================================================
+
+std::uint64_t LargeDocument::find(std::string_view needle, std::uint64_t from, bool forward,
+                                  const FindOptions& options) const {
+    std::string_view text = file_.view();
+    if (needle.empty() || needle.size() > text.size()) return npos;
+
+    std::string pattern(needle);
+    if (!options.caseSensitive) {
+        for (char& ch : pattern) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    }
+    std::string_view patternView = pattern;
+    Searcher searcher(patternView.begin(), patternView.end());
+    std::string scratch;
+
+    // A chunk at a time, so only the chunk is ever copied
+    if (forward) {
+        for (std::uint64_t begin = from; begin < text.size(); begin += kSearchChunk) {
+            std::uint64_t end = std::min<std::uint64_t>(text.size(), begin + kSearchChunk);
+            std::uint64_t match =
+                searchRange(text, begin, end, patternView, options, false, searcher, scratch);
+            if (match != npos) return match;
+        }
+        return npos;
+    }
+    std::uint64_t end = std::min<std::uint64_t>(from, text.size());
+    while (end > 0) {
+        std::uint64_t begin = end > kSearchChunk ? end - kSearchChunk : 0;
+        std::uint64_t match =
+            searchRange(text, begin, end, patternView, options, true, searcher, scratch);
+        if (match != npos) return match;
+        end = begin;
+    }
+    return npos;
+}
+
+std::uint64_t LargeDocument::offsetOf(CaretPosition pos) const {
+    std::uint64_t start = lineOffset(windowFirst_ + pos.row);
+    return start == npos ? file_.size() : start + pos.column;
+}
+
+FindResult LargeDocument::selectMatch(TextBuffer& buffer, std::uint64_t offset,
+                                      std::size_t length) {
+    std::size_t row = rowOfOffset(offset);
+    std::size_t endRow = rowOfOffset(offset + length);
+    goToLine(buffer, row);
+    if (endRow >= windowFirst_ + windowLines_) endRow = row;  // Past the window
+    auto toBuffer = [&](std::size_t fileRow, std::uint64_t at) {
+        std::size_t bufferRow = fileRow - windowFirst_;
+        std::size_t column = static_cast<std::size_t>(at - lineOffset(fileRow));
+        return CaretPosition{bufferRow, std::min(column, buffer.lineSpan(bufferRow).length)};
+    };
+    return {true, toBuffer(row, offset), toBuffer(endRow, offset + length)};
+}
+
+FindResult LargeDocument::findNext(TextBuffer& buffer, const std::string& needle,
+                                   const FindOptions& options) {
+    if (needle.empty() || options.useRegex || !ownsWindow(buffer)) return {};
+    std::uint64_t start = offsetOf(buffer.hasSelection() ? buffer.selectionEnd() : buffer.caret());
+    if (start < file_.size()) ++start;  // Past the current match
+    std::uint64_t match = find(needle, start, true, options);
+    if (match == npos && options.wrapAround) match = find(needle, 0, true, options);
+    if (match == npos) return {};
+    return selectMatch(buffer, match, needle.size());
+}
+
+FindResult LargeDocument::findPrevious(TextBuffer& buffer, const std::string& needle,
+                                       const FindOptions& options) {
+    if (needle.empty() || options.useRegex || !ownsWindow(buffer)) return {};
+    std::uint64_t start =
+        offsetOf(buffer.hasSelection() ? buffer.selectionStart() : buffer.caret());
+    std::uint64_t match = find(needle, start, false, options);
+    if (match == npos && options.wrapAround) match = find(needle, file_.size(), false, options);
+    if (match == npos) return {};
+    return selectMatch(buffer, match, needle.size());
+}
+
+std::size_t LargeDocument::memoryBytes() const {
+    std::lock_guard<std::mutex> lock(indexMutex_);
+    // A map node is the pair plus about four pointers of bookkeeping
+    return checkpoints_.capacity() * sizeof(std::uint64_t) +
+           formats_.size() * (sizeof(std::pair<const std::size_t, ParagraphFormat>) +
+                              4 * sizeof(void*));
+}
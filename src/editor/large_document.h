@@ -0,0 +1,126 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "mapped_file.h"
+#include "text_buffer.h"
+
+// Read-only view of a file too big for a TextBuffer (logs and transcripts
+// of hundreds of MB or more).
+//
+// The file stays memory-mapped, so the OS pages it in and drops it again
+// as it is read. A worker thread indexes the file once. The index keeps
+// only the byte offset of every CHECKPOINT_LINES-th line (8 bytes per 1024
+// lines). To find any other line, scan forward from its checkpoint.
+//
+// The editor works on a window of at most WINDOW_LINES lines copied into
+// the TextBuffer, which is set read-only. The window moves when the view
+// gets near either edge (followView) or jumps to a line or match (goToLine,
+// findNext, findPrevious). Paragraph formats set inside the window are
+// saved when it moves, but only for lines that differ from the default
+// ParagraphFormat, and they come back when the lines do.
+//
+// Memory use is the index plus at most one window, however big the file
+// is. Lines longer than MAX_LINE_BYTES are shown cut short.
+class LargeDocument {
+   public:
+    static constexpr std::uint64_t THRESHOLD = 256ull * 1024 * 1024;
+    static constexpr std::size_t CHECKPOINT_LINES = 1024;
+    static constexpr std::size_t WINDOW_LINES = 4096;
+    static constexpr std::size_t MAX_LINE_BYTES = 8 * 1024;
+    static constexpr std::uint64_t npos = ~std::uint64_t{0};
+
+    LargeDocument() = default;
+    ~LargeDocument();
+    LargeDocument(const LargeDocument&) = delete;
+    LargeDocument& operator=(const LargeDocument&) = delete;
+
+    // Plain files of THRESHOLD bytes or more (not .wpdoc / .wpdb, and not
+    // .docx / .odt, which are imported)
+    static bool wantsFile(const std::string& path);
+
+    // Map the file and start indexing it in the background
+    bool open(const std::string& path);
+    const std::string& error() const { return error_; }
+    const std::string& path() const { return path_; }
+    std::uint64_t sizeBytes() const { return file_.size(); }
+
+    // Lines indexed so far; all of them once indexed()
+    std::size_t lineCount() const { return lineCount_.load(std::memory_order_acquire); }
+    bool indexed() const { return indexed_.load(std::memory_order_acquire); }
+    void waitForIndex();
+
+    // Byte offset where row starts (npos past the end of the file)
+    std::uint64_t lineOffset(std::size_t row) const;
+    // Row holding the byte at offset
+    std::size_t rowOfOffset(std::uint64_t offset) const;
+    // A line's bytes, without its '\n' (or "\r\n")
+    std::string_view line(std::size_t row) const;
+
+    // Show lines from firstRow on in the buffer (caret at the top)
+    void loadWindow(TextBuffer& buffer, std::size_t firstRow);
+    std::size_t windowFirst() const { return windowFirst_; }
+    std::size_t windowLines() const { return windowLines_; }
+    // Re-centre the window when topRow (a buffer row) is within a screen of
+    // its edge and the file goes on. Returns how far buffer rows moved (add
+    // it to the scroll offset); the caret keeps its place in the file.
+    std::ptrdiff_t followView(TextBuffer& buffer, std::size_t topRow, std::size_t visibleRows);
+    // Put the caret on a row of the file, moving the window if needed
+    void goToLine(TextBuffer& buffer, std::size_t row, std::size_t column = 0);
+
+    // TextBuffer::findNext / findPrevious over the whole file, starting
+    // from the caret. The window moves to the match; the result is in
+    // buffer rows. Regular expressions are not supported here.
+    FindResult findNext(TextBuffer& buffer, const std::string& needle, const FindOptions& options);
+    FindResult findPrevious(TextBuffer& buffer, const std::string& needle,
+                            const FindOptions& options);
+    // Byte offset of the first match at or after from (forward), or of the
+    // last match starting before from (backward); npos if there is none
+    std::uint64_t find(std::string_view needle, std::uint64_t from, bool forward,
+                       const FindOptions& options) const;
+
+    // Format of a line of the file (the window's lines as of its last move)
+    ParagraphFormat lineFormat(std::size_t row) const;
+    // Save the window's formats now (loadWindow does this itself)
+    void captureFormats(const TextBuffer& buffer);
+    std::size_t formattedLines() const { return formats_.size(); }
+
+    // Bytes held besides the mapping and the window's text
+    std::size_t memoryBytes() const;
+
+   private:
+    void buildIndex();
+    // Absolute offset of a buffer position in the current window
+    std::uint64_t offsetOf(CaretPosition pos) const;
+    FindResult selectMatch(TextBuffer& buffer, std::uint64_t offset, std::size_t length);
+    bool ownsWindow(const TextBuffer& buffer) const {
+        return windowLines_ > 0 && buffer.loadGeneration() == windowGeneration_;
+    }
+
+    MappedFile file_;
+    std::string path_;
+    std::string error_;
+
+    // Offset of lines 0, CHECKPOINT_LINES, 2 * CHECKPOINT_LINES, ...
+    mutable std::mutex indexMutex_;
+    std::vector<std::uint64_t> checkpoints_;
+    std::atomic<std::size_t> lineCount_{0};
+    std::atomic<bool> indexed_{false};
+    std::atomic<bool> stopIndexing_{false};
+    std::thread indexer_;
+
+    std::size_t windowFirst_ = 0;
+    std::size_t windowLines_ = 0;
+    std::uint64_t windowGeneration_ = 0;
+
+    // Only lines whose format is not ParagraphFormat{}
+    std::map<std::size_t, ParagraphFormat> formats_;
+};
@@ -0,0 +1,126 @@
+#include "lz_block.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace lz_block {
+
+namespace {
+
+constexpr std::size_t kMinMatch = 4;
+constexpr std::size_t kMaxOffset = 65535;
+constexpr int kHashBits = 16;
+
+std::uint32_t load32(const char* p) {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+std::uint32_t hash4(std::uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - kHashBits);
+}
+
+void putLength(std::string& out, std::size_t extra) {
+    while (extra >= 255) {
+        out.push_back(static_cast<char>(255));
+        extra -= 255;
+    }
+    out.push_back(static_cast<char>(extra));
+}
+
+bool getLength(std::string_view in, std::size_t& pos, std::size_t& length) {
+    while (true) {
+        if (pos >= in.size()) return false;
+        auto byte = static_cast<unsigned char>(in[pos++]);
+        length += byte;
+        if (byte != 255) return true;
+    }
+}
+
+void emitSequence(std::string& out, std::string_view literals, std::size_t offset,
+                  std::size_t matchLength) {
+    std::size_t litCode = literals.size() < 15 ? literals.size() : 15;
+    std::size_t matchCode = 0;
+    if (matchLength > 0) {
+        matchCode = matchLength - kMinMatch < 15 ? matchLength - kMinMatch : 15;
+    }
+    out.push_back(static_cast<char>((litCode << 4) | matchCode));
+    if (litCode == 15) putLength(out, literals.size() - 15);
+    out.append(literals);
+    if (matchLength == 0) return;
+    out.push_back(static_cast<char>(offset & 0xFF));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (matchCode == 15) putLength(out, matchLength - kMinMatch - 15);
+}
+
+}  // namespace
+
+std::string compress(std::string_view input) {
+    std::string out;
+    out.reserve(input.size() / 2 + 16);
+    const char* base = input.data();
+    const std::size_t size = input.size();
+
+    // Most recent position + 1 of each 4-byte hash (0 = none)
+    std::vector<std::uint32_t> recent(std::size_t{1} << kHashBits, 0);
+    std::size_t anchor = 0;
+    std::size_t pos = 0;
+    while (pos + kMinMatch <= size) {
+        std::uint32_t sequence = load32(base + pos);
+        std::uint32_t& slot = recent[hash4(sequence)];
+        std::size_t candidate = slot;
+        slot = static_cast<std::uint32_t>(pos + 1);
+        if (candidate == 0 || pos - (candidate - 1) > kMaxOffset ||
+            load32(base + candidate - 1) != sequence) {
+            ++pos;
+            continue;
+        }
+        std::size_t ref = candidate - 1;
+        std::size_t length = kMinMatch;
+        while (pos + length < size && base[ref + length] == base[pos + length]) ++length;
+
+        emitSequence(out, input.substr(anchor, pos - anchor), pos - ref, length);
+        pos += length;
+        anchor = pos;
+    }
+    emitSequence(out, input.substr(anchor), 0, 0);
+    return out;
+}
+
+bool decompress(std::string_view input, char* out, std::size_t rawSize) {
+    std::size_t pos = 0;
+    std::size_t written = 0;
+    while (pos < input.size()) {
+        auto token = static_cast<unsigned char>(input[pos++]);
+        std::size_t literals = token >> 4;
+        if (literals == 15 && !getLength(input, pos, literals)) return false;
+        if (literals > input.size() - pos || literals > rawSize - written) return false;
+        std::memcpy(out + written, input.data() + pos, literals);
+        pos += literals;
+        written += literals;
+        if (pos == input.size()) break;  // Last sequence: literals only
+
+        if (input.size() - pos < 2) return false;
+        std::size_t offset = static_cast<unsigned char>(input[pos]) |
+                             (static_cast<std::size_t>(static_cast<unsigned char>(input[pos + 1])) << 8);
+        pos += 2;
+        std::size_t length = token & 0x0F;
+        if (length == 15 && !getLength(input, pos, length)) return false;
+        length += kMinMatch;
+        if (offset == 0 || offset > written || length > rawSize - written) return false;
+
+        const char* from = out + written - offset;
+        if (offset >= length) {
+            std::memcpy(out + written, from, length);
+        } else {
+            // Overlapping copy repeats the last `offset` bytes
+            for (std::size_t i = 0; i < length; ++i) out[written + i] = from[i];
+        }
+        written += length;
+    }
+    return written == rawSize;
+}
+
+}  // namespace lz_block
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Small LZ77 block codec (LZ4-style sequences) for .wpdb sections.
+//
+// Each sequence is a token byte (literal count in the high nibble, match
+// length - 4 in the low nibble; 15 means more length bytes follow, 255 at
+// a time), the literals, then a 2-byte little-endian back-reference offset
+// and any extra match-length bytes. The last sequence has literals only.
+// Decoding is a few branches and memcpys per sequence, which is what lazy
+// section loading needs; compression ratio is secondary.
+namespace lz_block {
+
+std::string compress(std::string_view input);
+
+// Decode into out, which must hold exactly rawSize bytes. Returns false on
+// malformed input (never reads or writes out of bounds).
+bool decompress(std::string_view input, char* out, std::size_t rawSize);
+
+// Most bytes inputSize bytes can decode to: every input byte yields at most
+// 255 (a full extra match-length byte), so a larger rawSize is damage
+constexpr std::uint64_t maxDecompressedSize(std::uint64_t inputSize) { return inputSize * 255; }
+
+}  // namespace lz_block
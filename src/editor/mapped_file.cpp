@@ -0,0 +1,97 @@
+#include "mapped_file.h"
+
+#include <fstream>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define WORDPROC_HAS_MMAP 1
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) return *this;
+    close();
+    mapped_ = std::exchange(other.mapped_, nullptr);
+    fallback_ = std::move(other.fallback_);
+    size_ = std::exchange(other.size_, 0);
+    open_ = std::exchange(other.open_, false);
+    error_ = std::move(other.error_);
+    data_ = mapped_ ? static_cast<const char*>(mapped_) : fallback_.data();
+    if (size_ == 0) data_ = nullptr;
+    other.data_ = nullptr;
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#ifdef WORDPROC_HAS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_ = "Failed to open file: " + path;
+        return false;
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ == 0) {
+            ::close(fd);
+            open_ = true;
+            return true;
+        }
+        void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr != MAP_FAILED) {
+#ifdef POSIX_MADV_SEQUENTIAL
+            ::posix_madvise(addr, size_, POSIX_MADV_SEQUENTIAL);
+#endif
+            mapped_ = addr;
+            data_ = static_cast<const char*>(addr);
+            open_ = true;
+            return true;
+        }
+        size_ = 0;
+    } else {
+        ::close(fd);
+    }
+#endif
+
+    // Fallback: read the whole file into an owned buffer
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) {
+        error_ = "Failed to open file: " + path;
+        return false;
+    }
+    ifs.seekg(0, std::ios::end);
+    std::streamoff length = ifs.tellg();
+    ifs.seekg(0, std::ios::beg);
+    if (length > 0) {
+        fallback_.resize(static_cast<std::size_t>(length));
+        ifs.read(fallback_.data(), length);
+        fallback_.resize(static_cast<std::size_t>(ifs.gcount()));
+    }
+    size_ = fallback_.size();
+    data_ = size_ > 0 ? fallback_.data() : nullptr;
+    open_ = true;
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef WORDPROC_HAS_MMAP
+    if (mapped_) {
+        ::munmap(mapped_, size_);
+    }
+#endif
+    mapped_ = nullptr;
+    fallback_.clear();
+    fallback_.shrink_to_fit();
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+    error_.clear();
+}
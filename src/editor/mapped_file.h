@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Read-only view of a file's bytes.
+// On POSIX the file is memory-mapped so large documents are paged in on
+// demand instead of being copied into a std::string. Where mmap is not
+// available (or fails, e.g. on special files) the contents are read into an
+// owned buffer and exposed through the same interface.
+class MappedFile {
+   public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Map (or read) the file. Returns false and sets error() on failure.
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return open_; }
+    bool isMapped() const { return mapped_ != nullptr; }
+    const std::string& error() const { return error_; }
+
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    std::string_view view() const { return {data_, size_}; }
+
+   private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    void* mapped_ = nullptr;       // Non-null when backed by mmap
+    std::vector<char> fallback_;   // Used when mmap is unavailable
+    bool open_ = false;
+    std::string error_;
+};
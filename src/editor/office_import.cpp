@@ -0,0 +1,1249 @@
+#include "office_import.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "image_cache.h"
+#include "xml_scan.h"
+#include "zip_archive.h"
+
+namespace {
+
+// ============================================================================
+// Values
+// ============================================================================
+
+int parseInt(std::string_view text, int fallback = 0) {
+    int value = fallback;
+    if (!text.empty() && text.front() == '+') text.remove_prefix(1);
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() ? value : fallback;
+}
+
+// A repeat or span count: at least 1, at most limit
+std::size_t parseCount(std::string_view text, std::size_t limit = 256) {
+    return static_cast<std::size_t>(std::clamp(parseInt(text, 1), 1, static_cast<int>(limit)));
+}
+
+double parseNumber(std::string_view text, std::size_t& used) {
+    double value = 0.0;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    used = ec == std::errc() ? static_cast<std::size_t>(end - text.data()) : 0;
+    return ec == std::errc() ? value : 0.0;
+}
+
+int roundPx(double value) { return static_cast<int>(std::lround(value)); }
+
+// Word measures paragraph geometry in twentieths of a point and drawings in
+// English Metric Units; both become pixels at 96 dpi
+int twipsToPx(std::string_view twips) { return roundPx(parseInt(twips) / 15.0); }
+float emuToPx(std::string_view emu) {
+    std::size_t used = 0;
+    return static_cast<float>(parseNumber(emu, used) / 9525.0);
+}
+
+// An ODF length ("1.27cm", "0.5in", "12pt") in pixels at 96 dpi
+double odfLengthPx(std::string_view text) {
+    std::size_t used = 0;
+    double value = parseNumber(text, used);
+    std::string_view unit = text.substr(used);
+    if (unit == "cm") return value * 96.0 / 2.54;
+    if (unit == "mm") return value * 96.0 / 25.4;
+    if (unit == "in") return value * 96.0;
+    if (unit == "pt") return value * 96.0 / 72.0;
+    if (unit == "pc") return value * 16.0;
+    return value;  // px, or no unit
+}
+
+bool isTrue(std::string_view value) { return value != "0" && value != "false" && value != "off"; }
+
+ParagraphStyle headingStyle(int level) {
+    level = std::clamp(level, 1, 6);
+    return static_cast<ParagraphStyle>(static_cast<int>(ParagraphStyle::Heading1) + level - 1);
+}
+
+// Style names as either format writes them ("heading 1", "Heading1",
+// "Heading_20_1") to the paragraph style they stand for
+bool paragraphStyleForName(std::string_view name, ParagraphStyle& style) {
+    std::string key;
+    for (std::size_t i = 0; i < name.size(); ++i) {
+        if (name.substr(i, 4) == "_20_") {
+            i += 3;  // ODF's encoding of a space
+        } else if (name[i] != ' ' && name[i] != '_') {
+            key += static_cast<char>(std::tolower(static_cast<unsigned char>(name[i])));
+        }
+    }
+    if (key == "title") {
+        style = ParagraphStyle::Title;
+    } else if (key == "subtitle") {
+        style = ParagraphStyle::Subtitle;
+    } else if (key.size() == 8 && key.starts_with("heading") && key[7] >= '1' && key[7] <= '9') {
+        style = headingStyle(key[7] - '0');
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string zipPathJoin(std::string_view directory, std::string_view target) {
+    // Targets are relative to the part's folder unless they start with '/'
+    if (!target.empty() && target.front() == '/') return std::string(target.substr(1));
+    std::string path(directory);
+    while (target.starts_with("../")) {
+        target.remove_prefix(3);
+        std::size_t slash = path.find_last_of('/', path.empty() ? 0 : path.size() - 2);
+        path = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+    }
+    return path + std::string(target);
+}
+
+// ============================================================================
+// DocumentBuilder - collects text, formats, anchors and tables
+// ============================================================================
+
+// Both importers feed one of these as elements go by. Body text goes into
+// a single string (one line per paragraph) with a ParagraphFormat per line;
+// text inside a table goes into the current cell instead. Nested tables
+// are flattened into the cell of the outermost one.
+class DocumentBuilder {
+   public:
+    struct Cell {
+        std::string text;
+        std::size_t column = 0;
+        std::size_t colSpan = 1;
+        std::size_t rowSpan = 1;
+        bool continuesAbove = false;  // Word's vertical merge
+        bool covered = false;         // ODF's covered cell
+        bool hasParagraph = false;
+    };
+
+    // ---- Paragraphs -------------------------------------------------------
+
+    void beginParagraph(const ParagraphFormat& format) {
+        if (tableDepth_ > 0) {
+            Cell* target = currentCell();
+            if (target && target->hasParagraph) target->text += '\n';
+            if (target) target->hasParagraph = true;
+            scratch_ = format;
+            return;
+        }
+        if (!formats_.empty()) text_ += '\n';
+        formats_.push_back(format);
+        if (pendingPageBreak_) {
+            formats_.back().hasPageBreakBefore = true;
+            pendingPageBreak_ = false;
+        }
+        lineStart_ = text_.size();
+        open_ = true;
+    }
+
+    void endParagraph() {
+        if (tableDepth_ == 0) open_ = false;
+    }
+
+    // The open paragraph's format (a scratch copy inside tables)
+    ParagraphFormat& format() {
+        return tableDepth_ == 0 && open_ ? formats_.back() : scratch_;
+    }
+    bool paragraphEmpty() const {
+        if (tableDepth_ > 0) {
+            const Cell* target = currentCell();
+            return !target || target->text.empty() || target->text.back() == '\n';
+        }
+        return !open_ || text_.size() == lineStart_;
+    }
+
+    void append(std::string_view text) {
+        if (tableDepth_ > 0) {
+            if (Cell* target = currentCell()) target->text.append(text);
+        } else if (open_) {
+            text_.append(text);
+        }
+    }
+
+    // A line break inside a paragraph: a new line with the same format
+    void lineBreak() {
+        if (tableDepth_ > 0 || !open_) {
+            append("\n");
+            return;
+        }
+        ParagraphFormat next = formats_.back();
+        next.listType = ListType::None;
+        next.hasPageBreakBefore = false;
+        next.hasDropCap = false;
+        beginParagraph(next);
+    }
+
+    // A page break: before the open paragraph if nothing is in it yet,
+    // otherwise before the next one
+    void pageBreak() {
+        if (tableDepth_ > 0) return;
+        if (open_ && text_.size() == lineStart_) {
+            formats_.back().hasPageBreakBefore = true;
+        } else {
+            pendingPageBreak_ = true;
+        }
+    }
+
+    // ---- Anchors (body text only) -----------------------------------------
+
+    bool inTable() const { return tableDepth_ > 0; }
+    std::size_t offset() const { return text_.size(); }
+
+    void addLink(std::size_t start, std::string url, std::string tooltip) {
+        if (tableDepth_ > 0 || url.empty() || text_.size() <= start) return;
+        links_.push_back({start, text_.size(), std::move(url), std::move(tooltip)});
+    }
+
+    void addBookmark(std::string name) {
+        if (tableDepth_ > 0 || name.empty()) return;
+        bookmarks_.emplace_back(std::move(name), text_.size());
+    }
+
+    void addImage(DocumentImage image) {
+        if (tableDepth_ > 0) {
+            image.anchorLine = building_.line;
+            image.anchorColumn = 0;
+        } else if (open_) {
+            image.anchorLine = formats_.size() - 1;
+            image.anchorColumn = text_.size() - lineStart_;
+        } else {
+            image.anchorLine = formats_.size();
+            image.anchorColumn = 0;
+        }
+        images_.push_back(std::move(image));
+    }
+
+    // ---- Tables -----------------------------------------------------------
+
+    void beginTable() {
+        if (tableDepth_++ > 0) return;
+        open_ = false;
+        building_ = Building{};
+        building_.line = formats_.size();
+    }
+
+    void endTable() {
+        if (tableDepth_ == 0 || --tableDepth_ > 0) return;
+        Table table = buildTable();
+        if (!table.isEmpty()) tables_.emplace_back(building_.line, std::move(table));
+    }
+
+    void addColumn(float width) {
+        if (tableDepth_ == 1 && building_.colWidths.size() < MAX_COLUMNS) {
+            building_.colWidths.push_back(width);
+        }
+    }
+
+    void beginRow() {
+        if (tableDepth_ != 1) return;
+        building_.rows.emplace_back();
+        building_.column = 0;
+    }
+
+    void skipColumns(std::size_t count) {
+        if (tableDepth_ == 1) building_.column += count;
+    }
+
+    // Word's cells take their span's width in the grid; ODF lists a covered
+    // cell for each column a span covers, so its cells advance by one
+    void setCoveredCellsListed(bool listed) { coveredCellsListed_ = listed; }
+
+    void beginCell() {
+        if (tableDepth_ != 1 || building_.rows.empty()) return;
+        Cell cell;
+        cell.column = building_.column;
+        building_.rows.back().push_back(std::move(cell));
+        inCell_ = true;
+    }
+
+    // The open cell of the outermost table, for its spans to be filled in
+    Cell* cell() { return tableDepth_ == 1 ? currentCell() : nullptr; }
+
+    void endCell() {
+        if (tableDepth_ != 1 || !inCell_) return;
+        building_.column += coveredCellsListed_ ? 1 : currentCell()->colSpan;
+        inCell_ = false;
+    }
+
+    void coveredCell() {
+        beginCell();
+        if (Cell* covered = cell()) covered->covered = true;
+        endCell();
+    }
+
+    // Copy the last cell (ODF's number-columns-repeated), no further than
+    // the columns the table declared
+    void repeatCell(std::size_t times) {
+        if (tableDepth_ != 1 || building_.rows.empty() || building_.rows.back().empty()) return;
+        std::size_t limit = building_.colWidths.empty() ? MAX_COLUMNS : building_.colWidths.size();
+        Cell copy = building_.rows.back().back();
+        for (std::size_t i = 0; i < times && building_.column < limit; ++i) {
+            copy.column = building_.column++;
+            building_.rows.back().push_back(copy);
+        }
+    }
+
+    // ---- Result -----------------------------------------------------------
+
+    void finish(TextBuffer& buffer, TableList& tables, ImageCollection* images) {
+        // Whatever is anchored after the last paragraph gets a line to sit on
+        bool needsLine = formats_.empty();
+        for (const auto& entry : tables_) needsLine |= entry.first >= formats_.size();
+        for (const auto& image : images_) needsLine |= image.anchorLine >= formats_.size();
+        if (needsLine) {
+            tableDepth_ = 0;
+            beginParagraph(ParagraphFormat{});
+        }
+
+        buffer.setText(text_);
+        for (std::size_t row = 0; row < formats_.size(); ++row) {
+            if (!formats_[row].isDefault()) buffer.setLineFormat(row, formats_[row]);
+        }
+        for (const Link& link : links_) {
+            buffer.addHyperlinkAt(link.start, link.end, link.url, link.tooltip);
+        }
+        buffer.clearBookmarks();
+        for (const auto& [name, at] : bookmarks_) buffer.addBookmarkAt(name, at);
+
+        tables = std::move(tables_);
+        if (images) {
+            images->clear();
+            for (const DocumentImage& image : images_) images->addImage(image);
+        }
+    }
+
+   private:
+    static constexpr std::size_t MAX_COLUMNS = 256;
+
+    struct Link {
+        std::size_t start;
+        std::size_t end;
+        std::string url;
+        std::string tooltip;
+    };
+    struct Building {
+        std::size_t line = 0;
+        std::vector<std::vector<Cell>> rows;
+        std::vector<float> colWidths;
+        std::size_t column = 0;
+    };
+
+    Cell* currentCell() {
+        if (!inCell_ || building_.rows.empty() || building_.rows.back().empty()) return nullptr;
+        return &building_.rows.back().back();
+    }
+    const Cell* currentCell() const { return const_cast<DocumentBuilder*>(this)->currentCell(); }
+
+    Table buildTable() {
+        std::size_t cols = building_.colWidths.size();
+        for (const auto& row : building_.rows) {
+            for (const Cell& cell : row) cols = std::max(cols, cell.column + cell.colSpan);
+        }
+        cols = std::min(cols, MAX_COLUMNS);
+        std::size_t rows = building_.rows.size();
+        if (rows == 0 || cols == 0) return Table{};
+
+        auto cellAt = [&](std::size_t row, std::size_t column) -> Cell* {
+            for (Cell& cell : building_.rows[row]) {
+                if (cell.column == column) return &cell;
+            }
+            return nullptr;
+        };
+        // A vertical merge continues the nearest cell above that starts one
+        for (std::size_t row = 1; row < rows; ++row) {
+            for (const Cell& cell : building_.rows[row]) {
+                if (!cell.continuesAbove) continue;
+                for (std::size_t above = row; above-- > 0;) {
+                    Cell* origin = cellAt(above, cell.column);
+                    if (!origin) break;
+                    if (!origin->continuesAbove) {
+                        origin->rowSpan = std::max(origin->rowSpan, row - above + 1);
+                        break;
+                    }
+                }
+            }
+        }
+
+        Table table(rows, cols);
+        for (std::size_t col = 0; col < building_.colWidths.size() && col < cols; ++col) {
+            if (building_.colWidths[col] > 0.0f) table.setColWidth(col, building_.colWidths[col]);
+        }
+        for (std::size_t row = 0; row < rows; ++row) {
+            for (const Cell& cell : building_.rows[row]) {
+                if (cell.continuesAbove || cell.covered || cell.column >= cols) continue;
+                if (!cell.text.empty()) table.setCellContent(row, cell.column, cell.text);
+            }
+        }
+        for (std::size_t row = 0; row < rows; ++row) {
+            for (const Cell& cell : building_.rows[row]) {
+                if (cell.continuesAbove || cell.covered || cell.column >= cols) continue;
+                if (cell.colSpan <= 1 && cell.rowSpan <= 1) continue;
+                CellPosition topLeft{row, cell.column};
+                CellPosition bottomRight{std::min(rows, row + cell.rowSpan) - 1,
+                                         std::min(cols, cell.column + cell.colSpan) - 1};
+                if (table.canMerge(topLeft, bottomRight)) table.mergeCells(topLeft, bottomRight);
+            }
+        }
+        return table;
+    }
+
+    std::string text_;
+    std::vector<ParagraphFormat> formats_;
+    ParagraphFormat scratch_;
+    std::size_t lineStart_ = 0;
+    bool open_ = false;
+    bool pendingPageBreak_ = false;
+
+    std::vector<Link> links_;
+    std::vector<std::pair<std::string, std::size_t>> bookmarks_;
+    std::vector<DocumentImage> images_;
+
+    int tableDepth_ = 0;
+    bool inCell_ = false;
+    bool coveredCellsListed_ = false;
+    Building building_;
+    TableList tables_;
+};
+
+// Skips whole subtrees the importers do not want (notes, comments, text
+// boxes, ...), so their paragraphs do not land in the body
+class SkippingHandler : public xml_scan::Handler {
+   protected:
+    // Call first in startElement / endElement; true while inside a skipped
+    // subtree (or entering one)
+    bool skipStart(std::string_view name, std::initializer_list<std::string_view> skipped) {
+        if (skipDepth_ > 0) {
+            skipDepth_++;
+            return true;
+        }
+        if (std::find(skipped.begin(), skipped.end(), name) != skipped.end()) {
+            skipDepth_ = 1;
+            return true;
+        }
+        return false;
+    }
+    bool skipEnd() {
+        if (skipDepth_ == 0) return false;
+        skipDepth_--;
+        return true;
+    }
+    bool skipping() const { return skipDepth_ > 0; }
+
+   private:
+    int skipDepth_ = 0;
+};
+
+DocumentImage embeddedImage(ZipArchive& zip, const std::string& entry) {
+    DocumentImage image;
+    std::string bytes;
+    if (!zip.read(entry, bytes)) return image;
+    image.filename = std::filesystem::path(entry).filename().string();
+    image.base64Data =
+        encodeBase64(std::vector<std::uint8_t>(bytes.begin(), bytes.end()));
+    image.isEmbedded = true;
+    return image;
+}
+
+// ============================================================================
+// Word (.docx)
+// ============================================================================
+
+struct DocxNumberingLevel {
+    ListType type = ListType::Numbered;
+    int start = 1;
+};
+
+// word/_rels/document.xml.rels: relationship id -> target
+class DocxRelationships : public xml_scan::Handler {
+   public:
+    std::unordered_map<std::string, std::string> targets;
+
+    void startElement(std::string_view name, const xml_scan::Attributes& attributes) override {
+        if (name == "Relationship") {
+            targets[std::string(attributes.get("Id"))] = attributes.text("Target");
+        }
+    }
+};
+
+// word/styles.xml: style id -> paragraph style, list of list styles, and
+// the default font size
+class DocxStyles : public xml_scan::Handler {
+   public:
+    struct Style {
+        std::string basedOn;
+        bool hasStyle = false;
+        ParagraphStyle style = ParagraphStyle::Normal;
+        int numId = 0;
+        int level = 0;
+    };
+    std::unordered_map<std::string, Style> styles;
+    int defaultHalfPoints = 0;
+
+    void startElement(std::string_view name, const xml_scan::Attributes& attributes) override {
+        if (name == "w:docDefaults") {
+            inDefaults_ = true;
+        } else if (name == "w:sz" && inDefaults_) {
+            defaultHalfPoints = parseInt(attributes.get("w:val"));
+        } else if (name == "w:style") {
+            current_ = attributes.get("w:type") == "paragraph"
+                           ? &styles[std::string(attributes.get("w:styleId"))]
+                           : nullptr;
+            if (current_) {
+                current_->hasStyle =
+                    paragraphStyleForName(attributes.get("w:styleId"), current_->style);
+            }
+        } else if (!current_) {
+            return;
+        } else if (name == "w:name") {
+            ParagraphStyle style;
+            if (paragraphStyleForName(attributes.get("w:val"), style)) {
+                current_->style = style;
+                current_->hasStyle = true;
+            }
+        } else if (name == "w:basedOn") {
+            current_->basedOn = std::string(attributes.get("w:val"));
+        } else if (name == "w:numId") {
+            current_->numId = parseInt(attributes.get("w:val"));
+        } else if (name == "w:ilvl") {
+            current_->level = parseInt(attributes.get("w:val"));
+        }
+    }
+
+    void endElement(std::string_view name) override {
+        if (name == "w:docDefaults") inDefaults_ = false;
+        if (name == "w:style") current_ = nullptr;
+    }
+
+    // The style's own mapping, or the nearest one it is based on
+    const Style* resolve(std::string_view id) const {
+        for (int depth = 0; depth < 16 && !id.empty(); ++depth) {
+            auto it = styles.find(std::string(id));
+            if (it == styles.end()) return nullptr;
+            if (it->second.hasStyle || it->second.numId != 0) return &it->second;
+            id = it->second.basedOn;
+        }
+        return nullptr;
+    }
+
+   private:
+    bool inDefaults_ = false;
+    Style* current_ = nullptr;
+};
+
+// word/numbering.xml: numId -> abstract definition -> per-level format
+class DocxNumbering : public xml_scan::Handler {
+   public:
+    std::unordered_map<int, std::array<DocxNumberingLevel, 9>> abstracts;
+    std::unordered_map<int, int> numToAbstract;
+
+    void startElement(std::string_view name, const xml_scan::Attributes& attributes) override {
+        if (name == "w:abstractNum") {
+            abstract_ = &abstracts[parseInt(attributes.get("w:abstractNumId"))];
+            num_ = -1;
+        } else if (name == "w:num") {
+            num_ = parseInt(attributes.get("w:numId"));
+            abstract_ = nullptr;
+        } else if (name == "w:abstractNumId" && num_ >= 0) {
+            numToAbstract[num_] = parseInt(attributes.get("w:val"));
+        } else if (!abstract_) {
+            return;
+        } else if (name == "w:lvl") {
+            level_ = std::clamp(parseInt(attributes.get("w:ilvl")), 0, 8);
+        } else if (name == "w:numFmt") {
+            std::string_view format = attributes.get("w:val");
+            (*abstract_)[static_cast<std::size_t>(level_)].type =
+                format == "bullet" ? ListType::Bulleted
+                : format == "none" ? ListType::None
+                                   : ListType::Numbered;
+        } else if (name == "w:start") {
+            (*abstract_)[static_cast<std::size_t>(level_)].start =
+                parseInt(attributes.get("w:val"), 1);
+        }
+    }
+
+    void endElement(std::string_view name) override {
+        if (name == "w:abstractNum") abstract_ = nullptr;
+        if (name == "w:num") num_ = -1;
+    }
+
+    DocxNumberingLevel level(int numId, int level) const {
+        auto num = numToAbstract.find(numId);
+        if (num == numToAbstract.end()) return {};
+        auto abstract = abstracts.find(num->second);
+        if (abstract == abstracts.end()) return {};
+        return abstract->second[static_cast<std::size_t>(std::clamp(level, 0, 8))];
+    }
+
+   private:
+    std::array<DocxNumberingLevel, 9>* abstract_ = nullptr;
+    int num_ = -1;
+    int level_ = 0;
+};
+
+// word/document.xml
+class DocxBodyHandler : public SkippingHandler {
+   public:
+    DocxBodyHandler(DocumentBuilder& builder, const DocxRelationships& relationships,
+                    const DocxStyles& styles, const DocxNumbering& numbering, ZipArchive& zip,
+                    bool wantImages)
+        : builder_(builder),
+          relationships_(relationships),
+          styles_(styles),
+          numbering_(numbering),
+          zip_(zip),
+          wantImages_(wantImages) {}
+
+    void startElement(std::string_view name, const xml_scan::Attributes& attributes) override {
+        if (skipStart(name, {"w:txbxContent", "mc:Fallback", "w:moveFrom", "w:del",
+                             "w:pPrChange"})) {
+            return;
+        }
+
+        if (name == "w:t") {
+            inText_ = true;
+        } else if (name == "w:r" || name == "w:rPr" || name == "w:sz" || name == "w:rFonts" ||
+                   name == "w:b" || name == "w:i" || name == "w:lang") {
+            // The bulk of a document; nothing to do
+        } else if (name == "w:p") {
+            builder_.beginParagraph(ParagraphFormat{});
+            numId_ = -1;
+            level_ = 0;
+        } else if (name == "w:pPr") {
+            inParagraphProperties_ = true;
+        } else if (inParagraphProperties_) {
+            paragraphProperty(name, attributes);
+        } else if (name == "w:tab") {
+            builder_.append("\t");
+        } else if (name == "w:br" || name == "w:cr") {
+            if (attributes.get("w:type") == "page") {
+                builder_.pageBreak();
+            } else {
+                builder_.lineBreak();
+            }
+        } else if (name == "w:noBreakHyphen") {
+            builder_.append("-");
+        } else if (name == "w:hyperlink") {
+            std::string url;
+            std::string_view id = attributes.get("r:id");
+            auto target = relationships_.targets.find(std::string(id));
+            if (!id.empty() && target != relationships_.targets.end()) {
+                url = target->second;
+            } else if (attributes.has("w:anchor")) {
+                url = "#" + attributes.text("w:anchor");
+            }
+            links_.push_back({builder_.offset(), std::move(url), attributes.text("w:tooltip")});
+        } else if (name == "w:bookmarkStart") {
+            std::string bookmark = attributes.text("w:name");
+            if (bookmark != "_GoBack") builder_.addBookmark(std::move(bookmark));
+        } else if (name == "w:tbl") {
+            builder_.beginTable();
+        } else if (name == "w:gridCol") {
+            builder_.addColumn(static_cast<float>(twipsToPx(attributes.get("w:w"))));
+        } else if (name == "w:tr") {
+            builder_.beginRow();
+        } else if (name == "w:gridBefore") {
+            builder_.skipColumns(parseCount(attributes.get("w:val")));
+        } else if (name == "w:tc") {
+            builder_.beginCell();
+        } else if (name == "w:gridSpan") {
+            if (DocumentBuilder::Cell* cell = builder_.cell()) {
+                cell->colSpan = parseCount(attributes.get("w:val"));
+            }
+        } else if (name == "w:vMerge") {
+            if (DocumentBuilder::Cell* cell = builder_.cell()) {
+                cell->continuesAbove = attributes.get("w:val") != "restart";
+            }
+        } else if (name == "w:drawing") {
+            drawing_ = true;
+            image_ = DocumentImage{};
+            blip_.clear();
+        } else if (drawing_) {
+            drawingProperty(name, attributes);
+        }
+    }
+
+    void endElement(std::string_view name) override {
+        if (skipEnd()) return;
+        if (name == "w:t") {
+            inText_ = false;
+        } else if (name == "w:p") {
+            builder_.endParagraph();
+        } else if (name == "w:pPr") {
+            inParagraphProperties_ = false;
+            applyList();
+        } else if (name == "w:hyperlink") {
+            if (!links_.empty()) {
+                builder_.addLink(links_.back().start, std::move(links_.back().url),
+                                 std::move(links_.back().tooltip));
+                links_.pop_back();
+            }
+        } else if (name == "w:tc") {
+            builder_.endCell();
+        } else if (name == "w:tbl") {
+            builder_.endTable();
+        } else if (name == "w:drawing") {
+            drawing_ = false;
+            auto target = relationships_.targets.find(blip_);
+            if (wantImages_ && target != relationships_.targets.end()) {
+                DocumentImage image = embeddedImage(zip_, zipPathJoin("word/", target->second));
+                if (!image.base64Data.empty()) {
+                    image.altText = std::move(image_.altText);
+                    image.layoutMode = image_.layoutMode;
+                    image.originalWidth = image.displayWidth = image_.displayWidth;
+                    image.originalHeight = image.displayHeight = image_.displayHeight;
+                    builder_.addImage(std::move(image));
+                }
+            }
+        }
+    }
+
+    void characters(std::string_view text) override {
+        if (inText_ && !skipping()) builder_.append(text);
+    }
+
+   private:
+    struct OpenLink {
+        std::size_t start;
+        std::string url;
+        std::string tooltip;
+    };
+
+    void paragraphProperty(std::string_view name, const xml_scan::Attributes& attributes) {
+        ParagraphFormat& format = builder_.format();
+        if (name == "w:pStyle") {
+            if (const DocxStyles::Style* style = styles_.resolve(attributes.get("w:val"))) {
+                format.style = style->style;
+                styleNumId_ = style->hasStyle ? 0 : style->numId;
+                styleLevel_ = style->level;
+            }
+        } else if (name == "w:jc") {
+            std::string_view value = attributes.get("w:val");
+            if (value == "center") {
+                format.alignment = TextAlignment::Center;
+            } else if (value == "right" || value == "end") {
+                format.alignment = TextAlignment::Right;
+            } else if (value == "both" || value == "distribute") {
+                format.alignment = TextAlignment::Justify;
+            }
+        } else if (name == "w:ind") {
+            std::string_view left = attributes.get("w:left");
+            if (left.empty()) left = attributes.get("w:start");
+            format.leftIndent = twipsToPx(left);
+            if (attributes.has("w:hanging")) {
+                format.firstLineIndent = -twipsToPx(attributes.get("w:hanging"));
+            } else {
+                format.firstLineIndent = twipsToPx(attributes.get("w:firstLine"));
+            }
+        } else if (name == "w:spacing") {
+            format.spaceBefore = twipsToPx(attributes.get("w:before"));
+            format.spaceAfter = twipsToPx(attributes.get("w:after"));
+            std::string_view rule = attributes.get("w:lineRule");
+            int line = parseInt(attributes.get("w:line"));
+            if (line > 0 && (rule.empty() || rule == "auto")) {
+                format.lineSpacing = static_cast<float>(line) / 240.0f;
+            }
+        } else if (name == "w:pageBreakBefore") {
+            format.hasPageBreakBefore = isTrue(attributes.get("w:val"));
+        } else if (name == "w:numId") {
+            numId_ = parseInt(attributes.get("w:val"));
+        } else if (name == "w:ilvl") {
+            level_ = parseInt(attributes.get("w:val"));
+        }
+    }
+
+    // List membership comes from the paragraph's numPr, or its style's
+    void applyList() {
+        int numId = numId_ >= 0 ? numId_ : styleNumId_;
+        int level = numId_ >= 0 ? level_ : styleLevel_;
+        styleNumId_ = 0;
+        styleLevel_ = 0;
+        if (numId <= 0 || builder_.inTable()) return;
+        level = std::clamp(level, 0, 8);
+        DocxNumberingLevel definition = numbering_.level(numId, level);
+        if (definition.type == ListType::None) return;
+
+        Counters& counters = counters_[numId];
+        std::size_t at = static_cast<std::size_t>(level);
+        counters.value[at] = counters.active[at] ? counters.value[at] + 1 : definition.start;
+        counters.active[at] = true;
+        for (std::size_t deeper = at + 1; deeper < counters.active.size(); ++deeper) {
+            counters.active[deeper] = false;
+        }
+        ParagraphFormat& format = builder_.format();
+        format.listType = definition.type;
+        format.listLevel = level;
+        format.listNumber = counters.value[at];
+    }
+
+    void drawingProperty(std::string_view name, const xml_scan::Attributes& attributes) {
+        if (name == "wp:inline") {
+            image_.layoutMode = ImageLayoutMode::Inline;
+        } else if (name == "wp:anchor") {
+            image_.layoutMode = isTrue(attributes.get("behindDoc")) ? ImageLayoutMode::Behind
+                                                                    : ImageLayoutMode::WrapSquare;
+        } else if (name == "wp:wrapNone" && image_.layoutMode != ImageLayoutMode::Behind) {
+            image_.layoutMode = ImageLayoutMode::InFront;
+        } else if (name == "wp:wrapTopAndBottom") {
+            image_.layoutMode = ImageLayoutMode::BreakText;
+        } else if (name == "wp:wrapTight" || name == "wp:wrapThrough") {
+            image_.layoutMode = ImageLayoutMode::WrapTight;
+        } else if (name == "wp:extent") {
+            image_.displayWidth = emuToPx(attributes.get("cx"));
+            image_.displayHeight = emuToPx(attributes.get("cy"));
+        } else if (name == "wp:docPr") {
+            image_.altText = attributes.text("descr");
+        } else if (name == "a:blip") {
+            blip_ = std::string(attributes.get("r:embed"));
+        }
+    }
+
+    struct Counters {
+        std::array<int, 9> value{};
+        std::array<bool, 9> active{};
+    };
+
+    DocumentBuilder& builder_;
+    const DocxRelationships& relationships_;
+    const DocxStyles& styles_;
+    const DocxNumbering& numbering_;
+    ZipArchive& zip_;
+    bool wantImages_;
+
+    bool inText_ = false;
+    bool inParagraphProperties_ = false;
+    int numId_ = -1;
+    int level_ = 0;
+    int styleNumId_ = 0;
+    int styleLevel_ = 0;
+    std::unordered_map<int, Counters> counters_;
+    std::vector<OpenLink> links_;
+    bool drawing_ = false;
+    DocumentImage image_;
+    std::string blip_;
+};
+
+// ============================================================================
+// OpenDocument (.odt)
+// ============================================================================
+
+// Handles styles.xml and content.xml: style definitions wherever they are,
+// body content inside office:text
+class OdtHandler : public SkippingHandler {
+   public:
+    OdtHandler(DocumentBuilder& builder, ZipArchive& zip, bool wantImages)
+        : builder_(builder), zip_(zip), wantImages_(wantImages) {
+        builder_.setCoveredCellsListed(true);
+    }
+
+    // Styles read from content.xml are direct formatting (LibreOffice writes
+    // each paragraph's own settings as an automatic style); named styles
+    // only map to a paragraph style
+    void setAutomaticStyles(bool automatic) { automatic_ = automatic; }
+    double defaultFontPoints() const { return defaultFontPoints_; }
+
+    void startElement(std::string_view name, const xml_scan::Attributes& attributes) override {
+        if (!inBody_) {
+            if (name == "office:text") {
+                inBody_ = true;
+            } else {
+                styleElement(name, attributes);
+            }
+            return;
+        }
+        if (skipStart(name, {"text:note", "office:annotation", "text:tracked-changes",
+                             "draw:text-box", "text:sequence-decls"})) {
+            return;
+        }
+
+        if (name == "text:span") {
+            // Character formatting is not imported
+        } else if (name == "text:p" || name == "text:h") {
+            beginParagraph(name == "text:h", attributes);
+        } else if (name == "text:s") {
+            flushSpace();
+            int count = std::max(1, parseInt(attributes.get("text:c"), 1));
+            builder_.append(std::string(static_cast<std::size_t>(std::min(count, 1000)), ' '));
+        } else if (name == "text:tab") {
+            flushSpace();
+            builder_.append("\t");
+        } else if (name == "text:line-break") {
+            builder_.lineBreak();
+            pendingSpace_ = false;
+        } else if (name == "text:a") {
+            flushSpace();
+            links_.push_back({builder_.offset(), attributes.text("xlink:href"),
+                              attributes.text("office:title")});
+        } else if (name == "text:bookmark" || name == "text:bookmark-start") {
+            flushSpace();
+            builder_.addBookmark(attributes.text("text:name"));
+        } else if (name == "text:list") {
+            beginList(attributes);
+        } else if (name == "text:list-item" || name == "text:list-header") {
+            itemFirstParagraph_ = name == "text:list-item";
+            if (itemFirstParagraph_ && attributes.has("text:start-value") && !lists_.empty()) {
+                counters_[lists_.size() - 1] = parseInt(attributes.get("text:start-value"), 1) - 1;
+            }
+        } else if (name == "table:table") {
+            builder_.beginTable();
+        } else if (name == "table:table-column") {
+            std::size_t repeat = parseCount(attributes.get("table:number-columns-repeated"));
+            for (std::size_t i = 0; i < repeat; ++i) builder_.addColumn(0.0f);
+        } else if (name == "table:table-row") {
+            builder_.beginRow();
+        } else if (name == "table:table-cell") {
+            cellRepeat_ = parseCount(attributes.get("table:number-columns-repeated"));
+            builder_.beginCell();
+            if (DocumentBuilder::Cell* cell = builder_.cell()) {
+                cell->colSpan = parseCount(attributes.get("table:number-columns-spanned"));
+                cell->rowSpan = parseCount(attributes.get("table:number-rows-spanned"), 4096);
+            }
+        } else if (name == "table:covered-table-cell") {
+            std::size_t repeat = parseCount(attributes.get("table:number-columns-repeated"));
+            for (std::size_t i = 0; i < repeat; ++i) builder_.coveredCell();
+        } else if (name == "draw:frame") {
+            frame_ = DocumentImage{};
+            frameHref_.clear();
+            inFrame_ = true;
+            frame_.displayWidth = static_cast<float>(odfLengthPx(attributes.get("svg:width")));
+            frame_.displayHeight = static_cast<float>(odfLengthPx(attributes.get("svg:height")));
+            frame_.layoutMode = attributes.get("text:anchor-type") == "as-char"
+                                    ? ImageLayoutMode::Inline
+                                    : ImageLayoutMode::WrapSquare;
+        } else if (name == "draw:image" && inFrame_) {
+            frameHref_ = attributes.text("xlink:href");
+        } else if ((name == "svg:desc" || name == "svg:title") && inFrame_) {
+            altText_ = name == "svg:desc" || frame_.altText.empty() ? &frame_.altText : nullptr;
+            if (altText_) altText_->clear();
+        }
+    }
+
+    void endElement(std::string_view name) override {
+        if (!inBody_) {
+            if (name == "style:style") style_ = nullptr;
+            if (name == "text:list-style") listStyle_ = nullptr;
+            if (name == "style:default-style") inDefaultStyle_ = false;
+            return;
+        }
+        if (skipEnd()) return;
+        if (name == "office:text") {
+            inBody_ = false;
+        } else if (name == "text:p" || name == "text:h") {
+            builder_.endParagraph();
+            pendingSpace_ = false;
+        } else if (name == "text:a") {
+            if (!links_.empty()) {
+                builder_.addLink(links_.back().start, std::move(links_.back().url),
+                                 std::move(links_.back().tooltip));
+                links_.pop_back();
+            }
+        } else if (name == "text:list") {
+            if (!lists_.empty()) lists_.pop_back();
+        } else if (name == "text:list-item" || name == "text:list-header") {
+            itemFirstParagraph_ = false;
+        } else if (name == "table:table-cell") {
+            builder_.endCell();
+            builder_.repeatCell(cellRepeat_ - 1);
+        } else if (name == "table:table") {
+            builder_.endTable();
+        } else if (name == "svg:desc" || name == "svg:title") {
+            altText_ = nullptr;
+        } else if (name == "draw:frame") {
+            inFrame_ = false;
+            if (wantImages_ && !frameHref_.empty() && frameHref_.find("://") == std::string::npos) {
+                std::string entry = frameHref_;
+                if (entry.starts_with("./")) entry.erase(0, 2);
+                DocumentImage image = embeddedImage(zip_, entry);
+                if (!image.base64Data.empty()) {
+                    image.altText = std::move(frame_.altText);
+                    image.layoutMode = frame_.layoutMode;
+                    image.originalWidth = image.displayWidth = frame_.displayWidth;
+                    image.originalHeight = image.displayHeight = frame_.displayHeight;
+                    flushSpace();
+                    builder_.addImage(std::move(image));
+                }
+            }
+        }
+    }
+
+    void characters(std::string_view text) override {
+        if (!inBody_ || skipping()) return;
+        if (inFrame_) {
+            if (altText_) altText_->append(text);
+            return;
+        }
+        // ODF collapses each run of white space to one space, and drops it
+        // at the start and end of a paragraph
+        std::size_t pos = 0;
+        while (pos < text.size()) {
+            std::size_t word = text.find_first_not_of(" \t\r\n", pos);
+            if (word != pos) {
+                pendingSpace_ = pendingSpace_ || !builder_.paragraphEmpty();
+                if (word == std::string_view::npos) break;
+            }
+            std::size_t end = text.find_first_of(" \t\r\n", word);
+            if (end == std::string_view::npos) end = text.size();
+            flushSpace();
+            builder_.append(text.substr(word, end - word));
+            pos = end;
+        }
+    }
+
+   private:
+    struct Style {
+        std::string parent;
+        std::string displayName;
+        bool automatic = false;
+        int outlineLevel = 0;
+        bool hasAlignment = false;
+        TextAlignment alignment = TextAlignment::Left;
+        std::optional<int> marginLeft, textIndent, marginTop, marginBottom;
+        std::optional<float> lineSpacing;
+        bool pageBreakBefore = false;
+    };
+    struct OpenLink {
+        std::size_t start;
+        std::string url;
+        std::string tooltip;
+    };
+    struct OpenList {
+        std::string style;
+    };
+
+    void flushSpace() {
+        if (pendingSpace_ && !builder_.paragraphEmpty()) builder_.append(" ");
+        pendingSpace_ = false;
+    }
+
+    void styleElement(std::string_view name, const xml_scan::Attributes& attributes) {
+        if (name == "style:style") {
+            style_ = nullptr;
+            if (attributes.get("style:family") != "paragraph") return;
+            style_ = &styles_[attributes.text("style:name")];
+            *style_ = Style{};
+            style_->automatic = automatic_;
+            style_->parent = attributes.text("style:parent-style-name");
+            style_->displayName = attributes.text("style:display-name");
+            style_->outlineLevel = parseInt(attributes.get("style:default-outline-level"));
+        } else if (name == "style:default-style") {
+            inDefaultStyle_ = attributes.get("style:family") == "paragraph";
+        } else if (name == "style:text-properties" && inDefaultStyle_) {
+            std::string_view size = attributes.get("fo:font-size");
+            if (size.ends_with("pt")) {
+                std::size_t used = 0;
+                defaultFontPoints_ = parseNumber(size, used);
+            }
+        } else if (name == "style:paragraph-properties" && style_) {
+            std::string_view align = attributes.get("fo:text-align");
+            if (!align.empty()) {
+                style_->hasAlignment = true;
+                style_->alignment = align == "center"                    ? TextAlignment::Center
+                                    : align == "end" || align == "right" ? TextAlignment::Right
+                                    : align == "justify"                 ? TextAlignment::Justify
+                                                                         : TextAlignment::Left;
+            }
+            auto length = [&](std::string_view key, std::optional<int>& into) {
+                std::string_view value = attributes.get(key);
+                if (!value.empty()) into = roundPx(odfLengthPx(value));
+            };
+            length("fo:margin-left", style_->marginLeft);
+            length("fo:text-indent", style_->textIndent);
+            length("fo:margin-top", style_->marginTop);
+            length("fo:margin-bottom", style_->marginBottom);
+            std::string_view lineHeight = attributes.get("fo:line-height");
+            if (lineHeight.ends_with('%')) {
+                std::size_t used = 0;
+                style_->lineSpacing = static_cast<float>(parseNumber(lineHeight, used) / 100.0);
+            }
+            style_->pageBreakBefore = attributes.get("fo:break-before") == "page";
+        } else if (name == "text:list-style") {
+            listStyle_ = &listStyles_[attributes.text("style:name")];
+            listStyle_->fill(ListType::Bulleted);
+        } else if (listStyle_ && name.starts_with("text:list-level-style-")) {
+            int level = std::clamp(parseInt(attributes.get("text:level"), 1), 1, 10);
+            (*listStyle_)[static_cast<std::size_t>(level - 1)] =
+                name == "text:list-level-style-number" ? ListType::Numbered : ListType::Bulleted;
+        }
+    }
+
+    // Named styles give the paragraph style, automatic ones the direct
+    // formatting; a chain is applied from its root down
+    ParagraphFormat resolveStyle(std::string_view name, bool& mapped) const {
+        std::vector<const Style*> chain;
+        std::vector<std::string_view> names;
+        while (!name.empty() && chain.size() < 16) {
+            auto it = styles_.find(std::string(name));
+            if (it == styles_.end()) break;
+            chain.push_back(&it->second);
+            names.push_back(it->first);
+            name = it->second.parent;
+        }
+        ParagraphFormat format;
+        mapped = false;
+        for (std::size_t i = 0; i < chain.size() && !mapped; ++i) {
+            mapped = paragraphStyleForName(chain[i]->displayName, format.style) ||
+                     paragraphStyleForName(names[i], format.style);
+            if (!mapped && chain[i]->outlineLevel > 0 && !chain[i]->automatic) {
+                format.style = headingStyle(chain[i]->outlineLevel);
+                mapped = true;
+            }
+        }
+        for (std::size_t i = chain.size(); i-- > 0;) {
+            const Style& style = *chain[i];
+            if (!style.automatic) continue;
+            if (style.hasAlignment) format.alignment = style.alignment;
+            if (style.marginLeft) format.leftIndent = *style.marginLeft;
+            if (style.textIndent) format.firstLineIndent = *style.textIndent;
+            if (style.marginTop) format.spaceBefore = *style.marginTop;
+            if (style.marginBottom) format.spaceAfter = *style.marginBottom;
+            if (style.lineSpacing) format.lineSpacing = *style.lineSpacing;
+            if (style.pageBreakBefore) format.hasPageBreakBefore = true;
+        }
+        return format;
+    }
+
+    void beginParagraph(bool heading, const xml_scan::Attributes& attributes) {
+        bool mapped = false;
+        ParagraphFormat format = resolveStyle(attributes.get("text:style-name"), mapped);
+        if (heading && (!mapped || format.style == ParagraphStyle::Normal)) {
+            format.style = headingStyle(parseInt(attributes.get("text:outline-level"), 1));
+        }
+        if (itemFirstParagraph_ && !lists_.empty() && !builder_.inTable()) {
+            std::size_t depth = lists_.size() - 1;
+            auto style = listStyles_.find(lists_.back().style);
+            format.listType = style == listStyles_.end()
+                                  ? ListType::Bulleted
+                                  : style->second[std::min<std::size_t>(depth, 9)];
+            format.listLevel = static_cast<int>(depth);
+            format.listNumber = ++counters_[depth];
+            for (std::size_t deeper = depth + 1; deeper < counters_.size(); ++deeper) {
+                counters_[deeper] = 0;
+            }
+        }
+        itemFirstParagraph_ = false;
+        pendingSpace_ = false;
+        builder_.beginParagraph(format);
+    }
+
+    void beginList(const xml_scan::Attributes& attributes) {
+        std::string style = attributes.text("text:style-name");
+        if (style.empty() && !lists_.empty()) style = lists_.back().style;
+        bool continues = attributes.get("text:continue-numbering") == "true" ||
+                         attributes.has("text:continue-list");
+        if (lists_.size() < counters_.size() && !(lists_.empty() && continues)) {
+            counters_[lists_.size()] = 0;
+        }
+        lists_.push_back({std::move(style)});
+    }
+
+    DocumentBuilder& builder_;
+    ZipArchive& zip_;
+    bool wantImages_;
+    bool automatic_ = false;
+
+    std::unordered_map<std::string, Style> styles_;
+    std::unordered_map<std::string, std::array<ListType, 10>> listStyles_;
+    Style* style_ = nullptr;
+    std::array<ListType, 10>* listStyle_ = nullptr;
+    bool inDefaultStyle_ = false;
+    double defaultFontPoints_ = 0.0;
+
+    bool inBody_ = false;
+    bool pendingSpace_ = false;
+    std::vector<OpenLink> links_;
+    std::vector<OpenList> lists_;
+    std::array<int, 10> counters_{};
+    bool itemFirstParagraph_ = false;
+    std::size_t cellRepeat_ = 1;
+    bool inFrame_ = false;
+    DocumentImage frame_;
+    std::string frameHref_;
+    std::string* altText_ = nullptr;
+};
+
+// ============================================================================
+// Import
+// ============================================================================
+
+// Inflate one part and run it through handler. A missing optional part is
+// not an error.
+bool scanPart(ZipArchive& zip, const std::string& name, xml_scan::Handler& handler,
+              std::string& xml, bool required, DocumentResult& result) {
+    if (!zip.contains(name) && !required) return true;
+    if (!zip.read(name, xml)) {
+        result.error = zip.error();
+        return false;
+    }
+    std::string error;
+    if (!xml_scan::parse(xml, handler, &error)) {
+        result.error = "Malformed XML in " + name + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+void applyDefaultFontSize(double points, DocumentSettings& settings, TextBuffer& buffer) {
+    if (points <= 0.0) return;
+    settings.textStyle.fontSize = roundPx(points * 96.0 / 72.0);
+    buffer.setTextStyle(settings.textStyle);
+}
+
+}  // namespace
+
+bool isOfficeDocumentPath(const std::string& path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+    return extension == ".docx" || extension == ".odt";
+}
+
+DocumentResult importOfficeDocument(TextBuffer& buffer, DocumentSettings& settings,
+                                    TableList& tables, ImageCollection* images,
+                                    const std::string& path) {
+    DocumentResult result;
+    ZipArchive zip;
+    if (!zip.open(path)) {
+        result.error = zip.error();
+        return result;
+    }
+
+    DocumentBuilder builder;
+    std::string xml;  // One part at a time, reusing the allocation
+    double defaultFontPoints = 0.0;
+    if (zip.contains("word/document.xml")) {
+        DocxRelationships relationships;
+        DocxStyles styles;
+        DocxNumbering numbering;
+        if (!scanPart(zip, "word/_rels/document.xml.rels", relationships, xml, false, result) ||
+            !scanPart(zip, "word/styles.xml", styles, xml, false, result) ||
+            !scanPart(zip, "word/numbering.xml", numbering, xml, false, result)) {
+            return result;
+        }
+        DocxBodyHandler body(builder, relationships, styles, numbering, zip, images != nullptr);
+        if (!scanPart(zip, "word/document.xml", body, xml, true, result)) return result;
+        defaultFontPoints = styles.defaultHalfPoints / 2.0;
+    } else if (zip.contains("content.xml")) {
+        OdtHandler handler(builder, zip, images != nullptr);
+        if (!scanPart(zip, "styles.xml", handler, xml, false, result)) return result;
+        handler.setAutomaticStyles(true);
+        if (!scanPart(zip, "content.xml", handler, xml, true, result)) return result;
+        defaultFontPoints = handler.defaultFontPoints();
+    } else {
+        result.error = "Not a Word or OpenDocument text file: " + path;
+        return result;
+    }
+
+    builder.finish(buffer, tables, images);
+    applyDefaultFontSize(defaultFontPoints, settings, buffer);
+    result.success = true;
+    return result;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+#include "document_io.h"
+#include "image.h"
+
+// Import of Word (.docx) and OpenDocument Text (.odt) files.
+//
+// Both are zip containers (ZipArchive) whose body is one XML part:
+// word/document.xml or content.xml. That part is inflated and handed to
+// xml_scan, and the handler appends text straight into one string as
+// elements go by; the styles, numbering and relationship parts are read
+// the same way first, into small lookup tables. Mapped:
+//   - paragraphs, with style (Title, Subtitle, Heading 1-6), alignment,
+//     indents, spacing, line spacing and page break before
+//   - bulleted and numbered lists, with their level and number
+//   - hyperlinks (external and to bookmarks) and bookmarks
+//   - tables, with column widths and merged cells; cell text is kept as
+//     plain text, one line per paragraph
+//   - embedded images, with their size, alt text and inline / wrapped
+//     placement
+// Character formatting, headers, footers, notes, comments and text boxes
+// are not imported.
+
+// True for a path ending in .docx or .odt
+bool isOfficeDocumentPath(const std::string& path);
+
+// Replace buffer, tables and (when given) images with the document at
+// path. The format is taken from the container's contents, not the name.
+DocumentResult importOfficeDocument(TextBuffer& buffer, DocumentSettings& settings,
+                                    TableList& tables, ImageCollection* images,
+                                    const std::string& path);
@@ -0,0 +1,254 @@
+#include "progressive_loader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <limits>
+
+#include "image.h"
+
+namespace {
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+std::string lowercaseExtension(const std::string& path) {
+    std::size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) return "";
+    std::string extension = path.substr(dot);
+    for (char& ch : extension) ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    return extension;
+}
+
+// Offsets of every '\n' in text
+void findNewlines(std::string_view text, std::vector<std::size_t>& newlines) {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    for (const char* at = begin; at < end;) {
+        const void* found = std::memchr(at, '\n', static_cast<std::size_t>(end - at));
+        if (!found) break;
+        const char* newline = static_cast<const char*>(found);
+        newlines.push_back(static_cast<std::size_t>(newline - begin));
+        at = newline + 1;
+    }
+}
+
+}  // namespace
+
+// ============================================================================
+// UI thread
+// ============================================================================
+
+DocumentResult ProgressiveLoader::start(TextBuffer& buffer, DocumentSettings& settings,
+                                        const std::string& path, ImageCollection* images) {
+    cancel();
+    started_ = Clock::now();
+    progressive_ = false;
+    error_.clear();
+    readError_.clear();
+    readingDone_ = false;
+    cancelled_ = false;
+    totalBytes_ = 0;
+    loadedBytes_ = 0;
+    totalMs_ = 0.0;
+
+    DocumentResult result;
+    bool plainText = false;
+    bool binary = false;
+    if (file_.open(path)) {
+        std::string extension = lowercaseExtension(path);
+        plainText = (extension == ".txt" || extension == ".md") &&
+                    file_.size() >= PROGRESSIVE_THRESHOLD;
+        binary = !plainText && BinaryDocumentReader::hasMagic(file_.view());
+    }
+    if (binary) {
+        // Compressed, so the threshold applies to the text inside
+        file_.close();
+        reader_ = std::make_unique<BinaryDocumentReader>();
+        binary = reader_->open(path) && reader_->textSize() >= PROGRESSIVE_THRESHOLD;
+        if (!binary) reader_.reset();
+    }
+
+    if (plainText) {
+        // First screen: whole lines up to FIRST_CHUNK (or the chunk itself
+        // when the file starts with one enormous line)
+        std::string_view raw = file_.view();
+        std::string_view head = raw.substr(0, FIRST_CHUNK);
+        std::size_t cut = head.rfind('\n');
+        cut = cut == std::string_view::npos ? head.size() : cut + 1;
+
+        buffer.setText(raw.substr(0, cut));
+        buffer.reserveText(raw.size());
+        totalBytes_ = raw.size();
+        loadedBytes_ = cut;
+        result.success = true;
+        result.usedFallback = true;
+        progressive_ = cut < raw.size();
+        if (progressive_) worker_ = std::thread([this, cut] { readPlainText(cut); });
+    } else if (binary) {
+        std::string first;
+        if (!reader_->readTextChunk(0, first)) {
+            result.error = "Damaged text in " + path;
+        } else {
+            result = loadBinaryDocumentSettings(*reader_, settings);
+        }
+        if (result.success) {
+            buffer.setText(first);
+            buffer.setTextStyle(settings.textStyle);
+            buffer.reserveText(static_cast<std::size_t>(reader_->textSize()));
+            totalBytes_ = static_cast<std::size_t>(reader_->textSize());
+            loadedBytes_ = first.size();
+            progressive_ = reader_->textChunkCount() > 1;
+            if (progressive_) worker_ = std::thread([this] { readBinaryChunks(); });
+        }
+    } else {
+        file_.close();
+        result = loadDocumentEx(buffer, settings, path, images);
+    }
+    // Plain text and .wpdb carry no images
+    if (result.success && (plainText || binary) && images) images->clear();
+
+    firstScreenMs_ = millisecondsSince(started_);
+    if (progressive_) {
+        generation_ = buffer.loadGeneration();
+        done_ = false;
+    } else {
+        complete();
+        totalMs_ = firstScreenMs_;
+    }
+    return result;
+}
+
+bool ProgressiveLoader::pump(TextBuffer& buffer, std::size_t maxBytes) {
+    if (done_) return false;
+    if (buffer.loadGeneration() != generation_) {
+        // The text was replaced under us (New, another Open)
+        cancel();
+        return false;
+    }
+
+    std::size_t appended = 0;
+    while (appended < maxBytes) {
+        Batch batch;
+        bool haveBatch = false;
+        bool finished = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!batches_.empty()) {
+                batch = std::move(batches_.front());
+                batches_.pop_front();
+                haveBatch = true;
+            } else {
+                finished = readingDone_;
+            }
+        }
+        if (!haveBatch) {
+            if (finished) complete();
+            break;
+        }
+        space_.notify_one();
+        buffer.appendLoadedText(batch.text, batch.newlines);
+        loadedBytes_ += batch.inputBytes;
+        appended += batch.text.size();
+    }
+    return !done_;
+}
+
+void ProgressiveLoader::finish(TextBuffer& buffer) {
+    while (!done_) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this] { return !batches_.empty() || readingDone_; });
+        }
+        pump(buffer, std::numeric_limits<std::size_t>::max());
+    }
+}
+
+void ProgressiveLoader::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+    }
+    space_.notify_all();
+    if (worker_.joinable()) worker_.join();
+    batches_.clear();
+    file_.close();
+    reader_.reset();
+    done_ = true;
+}
+
+void ProgressiveLoader::complete() {
+    if (worker_.joinable()) worker_.join();
+    error_ = readError_;
+    file_.close();
+    reader_.reset();
+    done_ = true;
+    totalMs_ = millisecondsSince(started_);
+}
+
+double ProgressiveLoader::progress() const {
+    if (done_ || totalBytes_ == 0) return 1.0;
+    return static_cast<double>(loadedBytes_) / static_cast<double>(totalBytes_);
+}
+
+// ============================================================================
+// Worker thread
+// ============================================================================
+
+bool ProgressiveLoader::push(Batch batch) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_.wait(lock, [this] { return cancelled_ || batches_.size() < MAX_QUEUED; });
+        if (cancelled_) return false;
+        batches_.push_back(std::move(batch));
+    }
+    ready_.notify_one();
+    return true;
+}
+
+void ProgressiveLoader::finishReading(const std::string& error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        readingDone_ = true;
+        readError_ = error;
+    }
+    ready_.notify_all();
+}
+
+void ProgressiveLoader::readPlainText(std::size_t from) {
+    std::string_view raw = file_.view();
+    for (std::size_t pos = from; pos < raw.size(); pos += BATCH_SIZE) {
+        std::string_view input = raw.substr(pos, BATCH_SIZE);
+        Batch batch;
+        batch.inputBytes = input.size();
+        batch.text.reserve(input.size());
+        // Drop CRs as setText does, a run at a time
+        while (!input.empty()) {
+            const void* found = std::memchr(input.data(), '\r', input.size());
+            std::size_t run = found ? static_cast<std::size_t>(static_cast<const char*>(found) -
+                                                               input.data())
+                                    : input.size();
+            batch.text.append(input.data(), run);
+            input.remove_prefix(std::min(input.size(), run + 1));
+        }
+        findNewlines(batch.text, batch.newlines);
+        if (!push(std::move(batch))) return;
+    }
+    finishReading("");
+}
+
+void ProgressiveLoader::readBinaryChunks() {
+    for (std::size_t chunk = 1; chunk < reader_->textChunkCount(); ++chunk) {
+        Batch batch;
+        if (!reader_->readTextChunk(chunk, batch.text)) {
+            finishReading("Damaged text in the document; the rest was not loaded");
+            return;
+        }
+        batch.inputBytes = batch.text.size();
+        findNewlines(batch.text, batch.newlines);
+        if (!push(std::move(batch))) return;
+    }
+    finishReading("");
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "binary_document.h"
+#include "document_io.h"
+#include "document_settings.h"
+#include "mapped_file.h"
+#include "text_buffer.h"
+
+// Opens large documents a screen at a time.
+//
+// start() puts the first FIRST_CHUNK bytes (cut at a line end) into the
+// buffer and returns, so the next frame already shows the top of the file.
+// A worker thread reads the rest in BATCH_SIZE pieces: it drops CRs, finds
+// the newlines and queues the batch. pump() runs on the UI thread once per
+// frame. It appends ready batches with TextBuffer::appendLoadedText, which
+// is a memcpy plus pushing line spans. Line count, scroll extent and stats
+// grow as batches land.
+//
+// Plain text (.txt/.md) files and .wpdb text of PROGRESSIVE_THRESHOLD
+// bytes or more load this way. Everything else is loaded in full by
+// start(), and done() is then true straight away. If the buffer's text is replaced
+// mid-load (New, another Open), the next pump() abandons the load.
+class ProgressiveLoader {
+   public:
+    static constexpr std::size_t FIRST_CHUNK = 64 * 1024;
+    static constexpr std::size_t BATCH_SIZE = 1024 * 1024;
+    static constexpr std::size_t MAX_QUEUED = 8;  // Batches read ahead of pump()
+    static constexpr std::size_t PROGRESSIVE_THRESHOLD = 1024 * 1024;
+
+    ProgressiveLoader() = default;
+    ~ProgressiveLoader() { cancel(); }
+    ProgressiveLoader(const ProgressiveLoader&) = delete;
+    ProgressiveLoader& operator=(const ProgressiveLoader&) = delete;
+
+    // Load settings and the first screen (or the whole of a small file).
+    // Replaces any load still in progress. images, when given, is replaced
+    // as by loadDocumentEx.
+    DocumentResult start(TextBuffer& buffer, DocumentSettings& settings, const std::string& path,
+                         ImageCollection* images = nullptr);
+
+    // Append batches that are ready, up to about maxBytes (one frame's
+    // budget). Returns true while more text is still to come.
+    bool pump(TextBuffer& buffer, std::size_t maxBytes = 8 * BATCH_SIZE);
+    // Block until the whole file is in the buffer (e.g. before saving)
+    void finish(TextBuffer& buffer);
+    // Stop the worker, leaving whatever has been appended
+    void cancel();
+
+    bool done() const { return done_; }
+    bool wasProgressive() const { return progressive_; }
+    const std::string& error() const { return error_; }
+    // Fraction of the file appended so far
+    double progress() const;
+    double firstScreenMs() const { return firstScreenMs_; }
+    double totalMs() const { return totalMs_; }
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Batch {
+        std::string text;
+        std::vector<std::size_t> newlines;
+        std::size_t inputBytes = 0;  // File bytes behind text (CRs included)
+    };
+
+    void readPlainText(std::size_t from);
+    void readBinaryChunks();
+    // Queue a batch, waiting while MAX_QUEUED are pending. False if cancelled.
+    bool push(Batch batch);
+    void finishReading(const std::string& error);
+    void complete();
+
+    // Owned by the worker while it runs
+    MappedFile file_;
+    std::unique_ptr<BinaryDocumentReader> reader_;
+    std::thread worker_;
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::condition_variable space_;
+    std::deque<Batch> batches_;
+    bool readingDone_ = false;
+    bool cancelled_ = false;
+    std::string readError_;
+
+    // UI thread
+    bool done_ = true;
+    bool progressive_ = false;
+    std::uint64_t generation_ = 0;
+    std::size_t totalBytes_ = 0;
+    std::size_t loadedBytes_ = 0;
+    std::string error_;
+    Clock::time_point started_;
+    double firstScreenMs_ = 0.0;
+    double totalMs_ = 0.0;
+};
@@ -13,39 +13,39 @@
 SpellChecker::SpellChecker() { initDefaultDictionary(); }
 
 void SpellChecker::initDefaultDictionary() {
-    const std::filesystem::path dictPath =
-        std::filesystem::current_path() / "resources/dictionaries/en_basic.txt";
-    std::ifstream in(dictPath);
-    if (!in) {
+    // Prefer the automaton the build compiles (make dictionaries; mapped, no
+    // parsing); fall back to compiling the plain word list when it has not
+    // been built or the list was edited since.
+    const std::filesystem::path dictDir =
+        std::filesystem::current_path() / "resources/dictionaries";
+    const std::string compiled = (dictDir / "en_basic.dawg").string();
+    const std::string wordList = (dictDir / "en_basic.txt").string();
+    if (Dictionary::isCurrent(compiled, wordList) && dictionary_.load(compiled)) {
         return;
     }
+    dictionary_ = Dictionary::fromWords(Dictionary::readWordList(
+        wordList,
+        [](const std::string& word) { return normalizeWord(word); }));
+}
 
-    auto trim = [](std::string& value) {
-        auto notSpace = [](unsigned char ch) { return !std::isspace(ch); };
-        value.erase(value.begin(),
-                    std::find_if(value.begin(), value.end(), notSpace));
-        value.erase(std::find_if(value.rbegin(), value.rend(), notSpace).base(),
-                    value.end());
-    };
-
-    std::string line;
-    while (std::getline(in, line)) {
-        trim(line);
-        if (line.empty() || line[0] == '#') {
-            continue;
-        }
-        std::string normalized = normalizeWord(line);
-        if (!normalized.empty()) {
-            dictionary_.insert(std::move(normalized));
-        }
+bool SpellChecker::loadDictionary(const std::string& path) {
+    if (std::filesystem::path(path).extension() == ".dawg") {
+        Dictionary loaded;
+        if (!loaded.load(path)) return false;
+        dictionary_ = std::move(loaded);
+        return true;
     }
+    if (!std::filesystem::exists(path)) return false;
+    dictionary_ = Dictionary::fromWords(Dictionary::readWordList(
+        path, [](const std::string& word) { return normalizeWord(word); }));
+    return true;
 }
 
 bool SpellChecker::isWordChar(char ch) {
     return std::isalpha(static_cast<unsigned char>(ch)) || ch == '\'';
 }
 
-std::string SpellChecker::normalizeWord(const std::string& word) {
+std::string SpellChecker::normalizeWord(std::string_view word) {
     std::string result;
     result.reserve(word.size());
     for (char ch : word) {
@@ -57,9 +57,20 @@ std::string SpellChecker::normalizeWord(const std::string& word) {
     return result;
 }
 
-std::vector<std::pair<std::size_t, std::string>> SpellChecker::extractWords(
-    const std::string& text) {
-    std::vector<std::pair<std::size_t, std::string>> words;
+std::size_t SpellChecker::normalizeWordInto(std::string_view word, char* out,
+                                            std::size_t capacity) {
+    std::size_t length = 0;
+    for (char ch : word) {
+        if (ch == '\'') continue;
+        if (length == capacity) return std::string_view::npos;
+        out[length++] = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    }
+    return length;
+}
+
+void SpellChecker::forEachWord(
+    std::string_view text,
+    const std::function<void(std::size_t, std::string_view)>& visit) {
     std::size_t i = 0;
     while (i < text.size()) {
         // Skip non-word characters
@@ -73,14 +84,20 @@ std::vector<std::pair<std::size_t, std::string>> SpellChecker::extractWords(
         while (i < text.size() && isWordChar(text[i])) {
             ++i;
         }
-        if (i > start) {
-            words.emplace_back(start, text.substr(start, i - start));
-        }
+        visit(start, text.substr(start, i - start));
     }
+}
+
+std::vector<std::pair<std::size_t, std::string>> SpellChecker::extractWords(
+    const std::string& text) {
+    std::vector<std::pair<std::size_t, std::string>> words;
+    forEachWord(text, [&](std::size_t offset, std::string_view word) {
+        words.emplace_back(offset, std::string(word));
+    });
     return words;
 }
 
-bool SpellChecker::isCorrect(const std::string& word) const {
+bool SpellChecker::isCorrect(std::string_view word) const {
     if (word.empty()) return true;
 
     // Skip words that are all uppercase (likely acronyms)
@@ -98,20 +115,30 @@ bool SpellChecker::isCorrect(const std::string& word) const {
         if (std::isdigit(static_cast<unsigned char>(ch))) return true;
     }
 
-    std::string normalized = normalizeWord(word);
+    // Normalize on the stack; only pathological words need the heap
+    char inlineBuffer[MAX_INLINE_WORD];
+    std::string heapBuffer;
+    std::size_t length = normalizeWordInto(word, inlineBuffer, MAX_INLINE_WORD);
+    std::string_view normalized;
+    if (length != std::string_view::npos) {
+        normalized = std::string_view(inlineBuffer, length);
+    } else {
+        heapBuffer = normalizeWord(word);
+        normalized = heapBuffer;
+    }
     if (normalized.empty()) return true;
 
     // Single letters are always correct
     if (normalized.size() == 1) return true;
 
     // Check ignore list first
-    if (ignoreList_.count(normalized)) return true;
+    if (ignoreList_.find(normalized) != ignoreList_.end()) return true;
 
     // Check user dictionary
-    if (userDictionary_.count(normalized)) return true;
+    if (userDictionary_.find(normalized) != userDictionary_.end()) return true;
 
     // Check main dictionary
-    return dictionary_.count(normalized) > 0;
+    return dictionary_.contains(normalized);
 }
 
 std::size_t SpellChecker::editDistance(const std::string& a,
@@ -150,49 +177,63 @@ std::size_t SpellChecker::editDistance(const std::string& a,
 std::vector<std::string> SpellChecker::getSuggestions(
     const std::string& word, std::size_t maxSuggestions) const {
     std::string normalized = normalizeWord(word);
-    if (normalized.empty()) return {};
+    if (normalized.empty() || maxSuggestions == 0) return {};
 
     // If word is already correct, no suggestions needed
     if (isCorrect(word)) return {};
 
-    // Collect candidates with their edit distances
-    std::vector<std::pair<std::size_t, std::string>> candidates;
-
-    // Check dictionary words with reasonable edit distance
     std::size_t maxDistance = std::min<std::size_t>(3, normalized.size() / 2 + 1);
 
-    auto checkDictionary = [&](const std::unordered_set<std::string>& dict) {
-        for (const auto& dictWord : dict) {
-            // Quick length filter
-            if (dictWord.size() > normalized.size() + maxDistance ||
-                dictWord.size() + maxDistance < normalized.size()) {
-                continue;
-            }
+    // Best candidates so far, kept sorted by (distance, word)
+    std::vector<std::pair<std::size_t, std::string>> candidates;
+    candidates.reserve(maxSuggestions + 1);
+    auto offer = [&](std::string_view candidate, std::size_t dist) {
+        if (dist == 0) return;
+        std::pair<std::size_t, std::string_view> key{dist, candidate};
+        auto pos = std::lower_bound(
+            candidates.begin(), candidates.end(), key, [](const auto& a, const auto& b) {
+                return std::pair<std::size_t, std::string_view>(a.first, a.second) < b;
+            });
+        if (pos != candidates.end() && pos->first == dist && pos->second == candidate) return;
+        if (candidates.size() == maxSuggestions && pos == candidates.end()) return;
+        candidates.emplace(pos, dist, std::string(candidate));
+        if (candidates.size() > maxSuggestions) candidates.pop_back();
+    };
 
-            std::size_t dist = editDistance(normalized, dictWord);
-            if (dist > 0 && dist <= maxDistance) {
-                candidates.emplace_back(dist, dictWord);
+    // Search cost grows steeply with the edit radius, so widen it one step at
+    // a time: if radius d already yields maxSuggestions words, nothing
+    // farther away can make the list.
+    for (std::size_t radius = 1; radius <= maxDistance; ++radius) {
+        candidates.clear();
+
+        // The automaton yields words in lexicographic order, so once the
+        // list is full a later word only displaces an entry with a strictly
+        // smaller distance; tighten the search limit accordingly.
+        dictionary_.searchWithinDistance(
+            normalized, radius, [&](std::string_view candidate, std::size_t dist) {
+                offer(candidate, dist);
+                if (candidates.size() < maxSuggestions) return radius;
+                return candidates.back().first - 1;
+            });
+
+        // The user overlay is small; score it directly
+        for (const auto& userWord : userDictionary_) {
+            if (userWord.size() > normalized.size() + radius ||
+                userWord.size() + radius < normalized.size()) {
+                continue;
             }
+            std::size_t dist = editDistance(normalized, userWord);
+            if (dist <= radius) offer(userWord, dist);
         }
-    };
-
-    checkDictionary(dictionary_);
-    checkDictionary(userDictionary_);
 
-    // Sort by edit distance, then alphabetically
-    std::sort(candidates.begin(), candidates.end(),
-              [](const auto& a, const auto& b) {
-                  if (a.first != b.first) return a.first < b.first;
-                  return a.second < b.second;
-              });
+        if (candidates.size() >= maxSuggestions) break;
+    }
 
-    // Return top suggestions
     std::vector<std::string> result;
-    result.reserve(std::min(maxSuggestions, candidates.size()));
-    for (std::size_t i = 0; i < candidates.size() && i < maxSuggestions; ++i) {
-        result.push_back(candidates[i].second);
+    result.reserve(candidates.size());
+    for (auto& candidate : candidates) {
+        result.push_back(std::move(candidate.second));
     }
-
     return result;
 }
 
@@ -287,9 +328,13 @@ bool SpellChecker::saveUserDictionary(const std::string& path) const {
 // GrammarChecker Implementation
 // ============================================================================
 
+GrammarChecker::GrammarChecker() : rules_(defaultGrammarRules()) {}
+
 std::vector<std::string> GrammarChecker::availableRules() const {
-    return {"DOUBLE_SPACE", "SENTENCE_CAPITALIZATION", "REPEATED_WORD",
-            "COMMON_ERRORS"};
+    std::vector<std::string> ids;
+    ids.reserve(rules_.size());
+    for (const auto& rule : rules_) ids.push_back(rule->id());
+    return ids;
 }
 
 bool GrammarChecker::isRuleEnabled(const std::string& ruleId) const {
@@ -304,171 +349,23 @@ void GrammarChecker::disableRule(const std::string& ruleId) {
     disabledRules_.insert(ruleId);
 }
 
-std::vector<GrammarError> GrammarChecker::checkText(
-    const std::string& text) const {
-    std::vector<GrammarError> errors;
-
-    if (isRuleEnabled("DOUBLE_SPACE")) {
-        checkDoubleSpaces(text, errors);
-    }
-    if (isRuleEnabled("SENTENCE_CAPITALIZATION")) {
-        checkCapitalization(text, errors);
-    }
-    if (isRuleEnabled("REPEATED_WORD")) {
-        checkRepeatedWords(text, errors);
-    }
-    if (isRuleEnabled("COMMON_ERRORS")) {
-        checkCommonErrors(text, errors);
-    }
-
-    // Sort by offset
-    std::sort(errors.begin(), errors.end(),
-              [](const auto& a, const auto& b) { return a.offset < b.offset; });
-
-    return errors;
-}
-
-void GrammarChecker::checkDoubleSpaces(const std::string& text,
-                                       std::vector<GrammarError>& errors) const {
-    for (std::size_t i = 0; i + 1 < text.size(); ++i) {
-        if (text[i] == ' ' && text[i + 1] == ' ') {
-            // Count consecutive spaces
-            std::size_t end = i + 2;
-            while (end < text.size() && text[end] == ' ') {
-                ++end;
-            }
-
-            GrammarError error;
-            error.offset = i;
-            error.length = end - i;
-            error.text = text.substr(i, end - i);
-            error.message = "Multiple consecutive spaces";
-            error.suggestion = " ";
-            error.ruleId = "DOUBLE_SPACE";
-            errors.push_back(std::move(error));
-
-            i = end - 1;  // Skip past the spaces
-        }
-    }
-}
-
-void GrammarChecker::checkCapitalization(
-    const std::string& text, std::vector<GrammarError>& errors) const {
-    bool sentenceStart = true;
-
-    for (std::size_t i = 0; i < text.size(); ++i) {
-        char ch = text[i];
-
-        if (ch == '.' || ch == '!' || ch == '?') {
-            sentenceStart = true;
-        } else if (std::isalpha(static_cast<unsigned char>(ch))) {
-            if (sentenceStart) {
-                if (std::islower(static_cast<unsigned char>(ch))) {
-                    // Find word boundary
-                    std::size_t end = i + 1;
-                    while (end < text.size() &&
-                           std::isalpha(static_cast<unsigned char>(text[end]))) {
-                        ++end;
-                    }
-
-                    GrammarError error;
-                    error.offset = i;
-                    error.length = end - i;
-                    error.text = text.substr(i, end - i);
-                    error.message = "Sentence should start with capital letter";
-                    std::string suggestion = error.text;
-                    suggestion[0] = static_cast<char>(
-                        std::toupper(static_cast<unsigned char>(suggestion[0])));
-                    error.suggestion = suggestion;
-                    error.ruleId = "SENTENCE_CAPITALIZATION";
-                    errors.push_back(std::move(error));
-                }
-                sentenceStart = false;
-            }
-        } else if (ch != ' ' && ch != '\n' && ch != '\t') {
-            sentenceStart = false;
-        }
-    }
-}
-
-void GrammarChecker::checkRepeatedWords(
-    const std::string& text, std::vector<GrammarError>& errors) const {
-    auto words = SpellChecker::extractWords(text);
-
-    for (std::size_t i = 1; i < words.size(); ++i) {
-        const auto& prev = words[i - 1];
-        const auto& curr = words[i];
-
-        // Check if same word repeated
-        std::string prevNorm = SpellChecker::normalizeWord(prev.second);
-        std::string currNorm = SpellChecker::normalizeWord(curr.second);
-
-        if (prevNorm == currNorm && !prevNorm.empty()) {
-            GrammarError error;
-            error.offset = prev.first;
-            error.length = curr.first + curr.second.size() - prev.first;
-            error.text = text.substr(error.offset, error.length);
-            error.message = "Repeated word";
-            error.suggestion = prev.second;
-            error.ruleId = "REPEATED_WORD";
-            errors.push_back(std::move(error));
+void GrammarChecker::addRule(GrammarRulePtr rule) {
+    if (!rule) return;
+    for (auto& existing : rules_) {
+        if (existing->id() == rule->id()) {
+            existing = std::move(rule);
+            return;
         }
     }
+    rules_.push_back(std::move(rule));
 }
 
-void GrammarChecker::checkCommonErrors(
-    const std::string& text, std::vector<GrammarError>& errors) const {
-    // Common word pair errors
-    static const struct {
-        const char* wrong;
-        const char* correct;
-        const char* message;
-    } commonErrors[] = {
-        {"your welcome", "you're welcome", "Use \"you're\" (you are)"},
-        {"could of", "could have", "Use \"could have\" instead of \"could of\""},
-        {"should of", "should have", "Use \"should have\" instead of \"should of\""},
-        {"would of", "would have", "Use \"would have\" instead of \"would of\""},
-        {"alot", "a lot", "\"A lot\" should be two words"},
-        {"definately", "definitely", "Correct spelling is \"definitely\""},
-        {"seperate", "separate", "Correct spelling is \"separate\""},
-        {"occured", "occurred", "Correct spelling is \"occurred\""},
-        {"recieve", "receive", "Correct spelling is \"receive\""},
-        {"untill", "until", "Correct spelling is \"until\""},
-        {"wierd", "weird", "Correct spelling is \"weird\""},
-        {"thier", "their", "Correct spelling is \"their\""},
-        {"truely", "truly", "Correct spelling is \"truly\""},
-        {"accomodate", "accommodate", "Correct spelling is \"accommodate\""},
-        {"occurence", "occurrence", "Correct spelling is \"occurrence\""},
-        {nullptr, nullptr, nullptr}  // Sentinel
-    };
-
-    std::string textLower;
-    textLower.reserve(text.size());
-    for (char ch : text) {
-        textLower += static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
-    }
-
-    for (const auto* p = commonErrors; p->wrong; ++p) {
-        std::size_t pos = 0;
-        std::string wrongLower = p->wrong;
-        while ((pos = textLower.find(wrongLower, pos)) != std::string::npos) {
-            // Check word boundaries
-            bool startOk = (pos == 0 ||
-                            !SpellChecker::isWordChar(text[pos - 1]));
-            bool endOk = (pos + wrongLower.size() >= text.size() ||
-                          !SpellChecker::isWordChar(text[pos + wrongLower.size()]));
-
-            if (startOk && endOk) {
-                GrammarError error;
-                error.offset = pos;
-                error.length = wrongLower.size();
-                error.text = text.substr(pos, wrongLower.size());
-                error.message = p->message;
-                error.suggestion = p->correct;
-                error.ruleId = "COMMON_ERRORS";
-                errors.push_back(std::move(error));
-            }
-            pos += wrongLower.size();
-        }
+std::vector<GrammarError> GrammarChecker::checkText(const std::string& text,
+                                                    GrammarProfile* profile) const {
+    std::vector<const GrammarRule*> enabled;
+    enabled.reserve(rules_.size());
+    for (const auto& rule : rules_) {
+        if (isRuleEnabled(rule->id())) enabled.push_back(rule.get());
     }
+    return runGrammarRules(text, enabled, profile);
 }
@@ -3,9 +3,25 @@
 #include <cstddef>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <unordered_set>
 #include <vector>
 
+#include "dictionary.h"
+#include "grammar_rules.h"
+
+// Hash that accepts std::string_view so overlay sets can be probed without
+// building a temporary std::string
+struct TransparentStringHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view value) const {
+        return std::hash<std::string_view>{}(value);
+    }
+};
+
+// Small mutable word set (user dictionary, ignore list)
+using WordSet = std::unordered_set<std::string, TransparentStringHash, std::equal_to<>>;
+
 // Represents a spelling error in the document
 struct SpellingError {
     std::size_t offset = 0;      // Character offset in document
@@ -35,10 +51,13 @@ class SpellChecker {
     SpellChecker();
     ~SpellChecker() = default;
 
-    // Check if a single word is spelled correctly
-    bool isCorrect(const std::string& word) const;
+    // Check if a single word is spelled correctly (does not allocate for
+    // words up to MAX_INLINE_WORD bytes)
+    bool isCorrect(std::string_view word) const;
 
-    // Get spelling suggestions for a word (up to maxSuggestions)
+    // Get spelling suggestions for a word (up to maxSuggestions), ordered by
+    // edit distance then alphabetically. Uses a bounded Levenshtein search
+    // over the dictionary automaton.
     std::vector<std::string> getSuggestions(const std::string& word,
                                             std::size_t maxSuggestions = 5) const;
 
@@ -54,9 +73,7 @@ class SpellChecker {
     void removeFromUserDictionary(const std::string& word);
     bool isInUserDictionary(const std::string& word) const;
     void clearUserDictionary();
-    const std::unordered_set<std::string>& userDictionary() const {
-        return userDictionary_;
-    }
+    const WordSet& userDictionary() const { return userDictionary_; }
 
     // Session-based ignore list (not persisted)
     void ignoreWord(const std::string& word);
@@ -67,14 +84,29 @@ class SpellChecker {
     bool loadUserDictionary(const std::string& path);
     bool saveUserDictionary(const std::string& path) const;
 
+    // Replace the built-in dictionary. A .dawg file is memory-mapped as-is;
+    // any other file is read as a word list and compiled in memory.
+    bool loadDictionary(const std::string& path);
+    const Dictionary& dictionary() const { return dictionary_; }
+
     // Get default dictionary word count
     std::size_t dictionarySize() const { return dictionary_.size(); }
 
     // Word extraction utilities
     static std::vector<std::pair<std::size_t, std::string>> extractWords(
         const std::string& text);
+    // Visit each word as (offset, view into text) without copying it
+    static void forEachWord(
+        std::string_view text,
+        const std::function<void(std::size_t, std::string_view)>& visit);
     static bool isWordChar(char ch);
-    static std::string normalizeWord(const std::string& word);
+    static std::string normalizeWord(std::string_view word);
+    // Normalize into a caller-provided buffer. Returns the normalized length,
+    // or std::string_view::npos if it does not fit in capacity.
+    static std::size_t normalizeWordInto(std::string_view word, char* out,
+                                         std::size_t capacity);
+
+    static constexpr std::size_t MAX_INLINE_WORD = 64;
 
    private:
     // Calculate Levenshtein edit distance between two words
@@ -83,19 +115,9 @@ class SpellChecker {
     // Initialize the built-in dictionary
     void initDefaultDictionary();
 
-    std::unordered_set<std::string> dictionary_;      // Built-in dictionary
-    std::unordered_set<std::string> userDictionary_;  // User-added words
-    std::unordered_set<std::string> ignoreList_;      // Session ignore list
-};
-
-// Grammar checker (basic rules-based approach)
-struct GrammarError {
-    std::size_t offset = 0;
-    std::size_t length = 0;
-    std::string text;              // The problematic text
-    std::string message;           // Description of the issue
-    std::string suggestion;        // Suggested correction
-    std::string ruleId;            // Rule identifier (e.g., "DOUBLE_SPACE")
+    Dictionary dictionary_;  // Built-in dictionary (read-only DAWG)
+    WordSet userDictionary_;  // User-added words (mutable overlay)
+    WordSet ignoreList_;      // Session ignore list
 };
 
 enum class GrammarAction {
@@ -104,32 +126,31 @@ enum class GrammarAction {
     Accept       // Accept the suggestion
 };
 
+// Grammar checker: a set of pluggable rules run by a single-pass engine
+// (see grammar_rules.h)
 class GrammarChecker {
    public:
-    GrammarChecker() = default;
+    GrammarChecker();
     ~GrammarChecker() = default;
 
-    // Check text for grammar issues
-    std::vector<GrammarError> checkText(const std::string& text) const;
+    // Check text for grammar issues. Pass profile to accumulate per-rule
+    // timings across calls.
+    std::vector<GrammarError> checkText(const std::string& text,
+                                        GrammarProfile* profile = nullptr) const;
 
     // Enable/disable specific rules
     void enableRule(const std::string& ruleId);
     void disableRule(const std::string& ruleId);
     bool isRuleEnabled(const std::string& ruleId) const;
 
+    // Add a rule, replacing any existing rule with the same id
+    void addRule(GrammarRulePtr rule);
+    const std::vector<GrammarRulePtr>& rules() const { return rules_; }
+
     // Get all available rule IDs
     std::vector<std::string> availableRules() const;
 
    private:
+    std::vector<GrammarRulePtr> rules_;
     std::unordered_set<std::string> disabledRules_;
-
-    // Individual grammar rules
-    void checkDoubleSpaces(const std::string& text,
-                           std::vector<GrammarError>& errors) const;
-    void checkCapitalization(const std::string& text,
-                             std::vector<GrammarError>& errors) const;
-    void checkRepeatedWords(const std::string& text,
-                            std::vector<GrammarError>& errors) const;
-    void checkCommonErrors(const std::string& text,
-                           std::vector<GrammarError>& errors) const;
 };
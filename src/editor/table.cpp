@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <iterator>
 #include <stdexcept>
 
 Table::Table(std::size_t rows, std::size_t cols) {
@@ -9,19 +10,32 @@ Table::Table(std::size_t rows, std::size_t cols) {
 }
 
 void Table::initializeGrid(std::size_t rows, std::size_t cols) {
-    rows_.clear();
-    rows_.resize(rows);
-    for (auto& row : rows_) {
-        row.resize(cols);
-    }
-    
+    cells_.assign(rows * cols, TableCell{});
     colWidths_.assign(cols, defaultColWidth_);
     rowHeights_.assign(rows, defaultRowHeight_);
+    updateColOffsets(0);
+    updateRowOffsets(0);
     
     currentCell_ = {0, 0};
     hasSelection_ = false;
 }
 
+void Table::updateColOffsets(std::size_t from) {
+    colX_.resize(colWidths_.size() + 1);
+    colX_[0] = 0.0f;
+    for (std::size_t c = from; c < colWidths_.size(); ++c) {
+        colX_[c + 1] = colX_[c] + colWidths_[c];
+    }
+}
+
+void Table::updateRowOffsets(std::size_t from) {
+    rowY_.resize(rowHeights_.size() + 1);
+    rowY_[0] = 0.0f;
+    for (std::size_t r = from; r < rowHeights_.size(); ++r) {
+        rowY_[r + 1] = rowY_[r] + rowHeights_[r];
+    }
+}
+
 bool Table::isValidPosition(CellPosition pos) const {
     return pos.row < rowCount() && pos.col < colCount();
 }
@@ -30,18 +44,112 @@ TableCell& Table::cell(std::size_t row, std::size_t col) {
     if (row >= rowCount() || col >= colCount()) {
         throw std::out_of_range("Cell position out of range");
     }
-    return rows_[row][col];
+    return at(row, col);
 }
 
 const TableCell& Table::cell(std::size_t row, std::size_t col) const {
     if (row >= rowCount() || col >= colCount()) {
         throw std::out_of_range("Cell position out of range");
     }
-    return rows_[row][col];
+    return at(row, col);
 }
 
+namespace {
+
+// A table's cells as formula inputs: formula cells give their last result,
+// others the value of their text
+class TableCells : public formula::Cells {
+   public:
+    TableCells(const Table& table, const formula::Graph& formulas)
+        : table_(table), formulas_(formulas) {}
+
+    std::size_t rowCount() const override { return table_.rowCount(); }
+    std::size_t colCount() const override { return table_.colCount(); }
+    formula::Value value(std::size_t row, std::size_t col) const override {
+        if (const auto* entry = formulas_.find(row * table_.colCount() + col)) {
+            return entry->value;
+        }
+        return formula::valueOfText(table_.cell(row, col).content);
+    }
+
+   private:
+    const Table& table_;
+    const formula::Graph& formulas_;
+};
+
+}  // namespace
+
 void Table::setCellContent(std::size_t row, std::size_t col, const std::string& content) {
-    cell(row, col).content = content;
+    TableCell& target = cell(row, col);
+    std::size_t index = row * colCount() + col;
+    if (content.size() > 1 && content.front() == '=') {
+        target.formula = content;
+        formula::Program program;
+        program.compile(content);
+        formulas_.set(index, std::move(program), rowCount(), colCount());
+    } else {
+        target.formula.clear();
+        target.content = content;
+        formulas_.erase(index);
+    }
+    recalculateFrom({index});
+}
+
+void Table::recalculateFrom(const std::vector<std::size_t>& changed) {
+    if (formulas_.empty()) return;
+    std::vector<std::size_t> order;
+    std::vector<std::size_t> cyclic;
+    formulas_.dirtyOrder(changed, order, cyclic);
+    applyOrder(order, cyclic);
+}
+
+void Table::recalculate() {
+    if (formulas_.empty()) return;
+    std::vector<std::size_t> order;
+    std::vector<std::size_t> cyclic;
+    formulas_.fullOrder(order, cyclic);
+    applyOrder(order, cyclic);
+}
+
+void Table::applyOrder(const std::vector<std::size_t>& order,
+                       const std::vector<std::size_t>& cyclic) {
+    TableCells cells(*this, formulas_);
+    for (std::size_t index : order) {
+        formula::Graph::Entry* entry = formulas_.find(index);
+        entry->value = entry->program.evaluate(cells);
+        cells_[index].content = formula::format(entry->value);
+    }
+    for (std::size_t index : cyclic) {
+        formula::Graph::Entry* entry = formulas_.find(index);
+        entry->value = formula::Value::ofError(formula::Error::Cycle);
+        cells_[index].content = formula::format(entry->value);
+    }
+}
+
+void Table::rebuildFormulas() {
+    formulas_.clear();
+    for (std::size_t index = 0; index < cells_.size(); ++index) {
+        const TableCell& source = cells_[index];
+        if (source.formula.empty()) continue;
+        formula::Program program;
+        program.compile(source.formula);
+        formulas_.set(index, std::move(program), rowCount(), colCount()).value =
+            formula::valueOfText(source.content);
+    }
+}
+
+// Rows or columns moved: point references at where their cells went,
+// rebind every formula to its new cell and re-evaluate
+void Table::structureChanged(const formula::Shift& shift) {
+    if (formulas_.empty()) return;
+    for (TableCell& moved : cells_) {
+        if (moved.formula.empty()) continue;
+        formula::Program program;
+        program.compile(moved.formula);
+        program.shift(shift, moved.formula);
+    }
+    rebuildFormulas();
+    recalculate();
 }
 
 std::string Table::getCellContent(std::size_t row, std::size_t col) const {
@@ -54,12 +162,14 @@ void Table::insertRowAbove(std::size_t row) {
         row = rowCount();
     }
     
-    std::vector<TableCell> newRow(colCount());
-    rows_.insert(rows_.begin() + static_cast<std::ptrdiff_t>(row), newRow);
+    cells_.insert(cells_.begin() + static_cast<std::ptrdiff_t>(row * colCount()), colCount(),
+                  TableCell{});
     rowHeights_.insert(rowHeights_.begin() + static_cast<std::ptrdiff_t>(row), defaultRowHeight_);
+    updateRowOffsets(row);
     
     // Update merge info for cells that span across the new row
     updateMergeInfo();
+    structureChanged({true, row, 1});
 }
 
 void Table::insertRowBelow(std::size_t row) {
@@ -71,8 +181,10 @@ void Table::deleteRow(std::size_t row) {
         return;  // Can't delete if invalid or would leave empty table
     }
     
-    rows_.erase(rows_.begin() + static_cast<std::ptrdiff_t>(row));
+    auto first = cells_.begin() + static_cast<std::ptrdiff_t>(row * colCount());
+    cells_.erase(first, first + static_cast<std::ptrdiff_t>(colCount()));
     rowHeights_.erase(rowHeights_.begin() + static_cast<std::ptrdiff_t>(row));
+    updateRowOffsets(row);
     
     // Adjust current cell if needed
     if (currentCell_.row >= rowCount()) {
@@ -80,6 +192,7 @@ void Table::deleteRow(std::size_t row) {
     }
     
     updateMergeInfo();
+    structureChanged({true, row, -1});
 }
 
 float Table::rowHeight(std::size_t row) const {
@@ -92,6 +205,7 @@ float Table::rowHeight(std::size_t row) const {
 void Table::setRowHeight(std::size_t row, float height) {
     if (row < rowHeights_.size()) {
         rowHeights_[row] = std::max(10.0f, height);
+        updateRowOffsets(row);
     }
 }
 
@@ -101,12 +215,25 @@ void Table::insertColumnLeft(std::size_t col) {
         col = colCount();
     }
     
-    for (auto& row : rows_) {
-        row.insert(row.begin() + static_cast<std::ptrdiff_t>(col), TableCell{});
-    }
+    // Every row gains a cell, so the array is rebuilt rather than shifted
+    // once per row
+    std::size_t oldCols = colCount();
+    std::vector<TableCell> cells;
+    cells.reserve(rowCount() * (oldCols + 1));
+    for (std::size_t r = 0; r < rowCount(); ++r) {
+        auto rowBegin = cells_.begin() + static_cast<std::ptrdiff_t>(r * oldCols);
+        auto split = rowBegin + static_cast<std::ptrdiff_t>(col);
+        cells.insert(cells.end(), std::make_move_iterator(rowBegin), std::make_move_iterator(split));
+        cells.emplace_back();
+        cells.insert(cells.end(), std::make_move_iterator(split),
+                     std::make_move_iterator(rowBegin + static_cast<std::ptrdiff_t>(oldCols)));
+    }
+    cells_ = std::move(cells);
     colWidths_.insert(colWidths_.begin() + static_cast<std::ptrdiff_t>(col), defaultColWidth_);
+    updateColOffsets(col);
     
     updateMergeInfo();
+    structureChanged({false, col, 1});
 }
 
 void Table::insertColumnRight(std::size_t col) {
@@ -118,10 +245,17 @@ void Table::deleteColumn(std::size_t col) {
         return;  // Can't delete if invalid or would leave empty table
     }
     
-    for (auto& row : rows_) {
-        row.erase(row.begin() + static_cast<std::ptrdiff_t>(col));
+    // Compact in place: each kept cell moves left past the removed ones
+    std::size_t oldCols = colCount();
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < cells_.size(); ++i) {
+        if (i % oldCols == col) continue;
+        if (out != i) cells_[out] = std::move(cells_[i]);
+        ++out;
     }
+    cells_.resize(out);
     colWidths_.erase(colWidths_.begin() + static_cast<std::ptrdiff_t>(col));
+    updateColOffsets(col);
     
     // Adjust current cell if needed
     if (currentCell_.col >= colCount()) {
@@ -129,6 +263,7 @@ void Table::deleteColumn(std::size_t col) {
     }
     
     updateMergeInfo();
+    structureChanged({false, col, -1});
 }
 
 float Table::colWidth(std::size_t col) const {
@@ -141,6 +276,7 @@ float Table::colWidth(std::size_t col) const {
 void Table::setColWidth(std::size_t col, float width) {
     if (col < colWidths_.size()) {
         colWidths_[col] = std::max(20.0f, width);
+        updateColOffsets(col);
     }
 }
 
@@ -156,7 +292,7 @@ bool Table::canMerge(CellPosition topLeft, CellPosition bottomRight) const {
     // Check that no cell in the range is already part of a merge
     for (std::size_t r = topLeft.row; r <= bottomRight.row; ++r) {
         for (std::size_t c = topLeft.col; c <= bottomRight.col; ++c) {
-            const auto& cell = rows_[r][c];
+            const auto& cell = at(r, c);
             if (cell.isMerged || cell.span.rowSpan > 1 || cell.span.colSpan > 1) {
                 return false;
             }
@@ -175,7 +311,7 @@ bool Table::mergeCells(CellPosition topLeft, CellPosition bottomRight) {
     std::size_t colSpan = bottomRight.col - topLeft.col + 1;
     
     // Set the top-left cell to span the range
-    auto& masterCell = rows_[topLeft.row][topLeft.col];
+    auto& masterCell = at(topLeft.row, topLeft.col);
     masterCell.span.rowSpan = rowSpan;
     masterCell.span.colSpan = colSpan;
     
@@ -184,27 +320,39 @@ bool Table::mergeCells(CellPosition topLeft, CellPosition bottomRight) {
     for (std::size_t r = topLeft.row; r <= bottomRight.row; ++r) {
         for (std::size_t c = topLeft.col; c <= bottomRight.col; ++c) {
             if (r == topLeft.row && c == topLeft.col) continue;
-            const auto& cell = rows_[r][c];
+            const auto& cell = at(r, c);
             if (!cell.content.empty()) {
                 if (!combinedContent.empty()) combinedContent += " ";
                 combinedContent += cell.content;
             }
         }
     }
+    std::vector<std::size_t> changed;
     if (!combinedContent.empty()) {
         masterCell.content += " " + combinedContent;
+        // The joined text replaces a formula's value, so it is text now
+        std::size_t index = topLeft.row * colCount() + topLeft.col;
+        if (!masterCell.formula.empty()) {
+            masterCell.formula.clear();
+            formulas_.erase(index);
+        }
+        changed.push_back(index);
     }
     
     // Mark other cells as merged
     for (std::size_t r = topLeft.row; r <= bottomRight.row; ++r) {
         for (std::size_t c = topLeft.col; c <= bottomRight.col; ++c) {
             if (r == topLeft.row && c == topLeft.col) continue;
-            auto& cell = rows_[r][c];
+            auto& cell = at(r, c);
             cell.isMerged = true;
             cell.mergeParent = topLeft;
             cell.content.clear();
+            cell.formula.clear();
+            formulas_.erase(r * colCount() + c);
+            changed.push_back(r * colCount() + c);
         }
     }
+    recalculateFrom(changed);
     
     return true;
 }
@@ -214,7 +362,7 @@ bool Table::splitCell(CellPosition pos) {
         return false;
     }
     
-    auto& masterCell = rows_[pos.row][pos.col];
+    auto& masterCell = at(pos.row, pos.col);
     if (masterCell.span.rowSpan == 1 && masterCell.span.colSpan == 1) {
         return false;  // Cell is not merged
     }
@@ -225,7 +373,7 @@ bool Table::splitCell(CellPosition pos) {
     // Reset all cells in the merged range
     for (std::size_t r = pos.row; r <= endRow; ++r) {
         for (std::size_t c = pos.col; c <= endCol; ++c) {
-            auto& cell = rows_[r][c];
+            auto& cell = at(r, c);
             cell.isMerged = false;
             cell.span.rowSpan = 1;
             cell.span.colSpan = 1;
@@ -240,14 +388,14 @@ bool Table::isCellMerged(CellPosition pos) const {
     if (!isValidPosition(pos)) {
         return false;
     }
-    return rows_[pos.row][pos.col].isMerged;
+    return at(pos.row, pos.col).isMerged;
 }
 
 CellPosition Table::getMergeParent(CellPosition pos) const {
     if (!isValidPosition(pos)) {
         return {0, 0};
     }
-    const auto& cell = rows_[pos.row][pos.col];
+    const auto& cell = at(pos.row, pos.col);
     if (cell.isMerged) {
         return cell.mergeParent;
     }
@@ -295,8 +443,8 @@ void Table::selectColumn(std::size_t col) {
 void Table::setCurrentCell(CellPosition pos) {
     if (isValidPosition(pos)) {
         // If the cell is merged, navigate to the parent cell
-        if (rows_[pos.row][pos.col].isMerged) {
-            currentCell_ = rows_[pos.row][pos.col].mergeParent;
+        if (at(pos.row, pos.col).isMerged) {
+            currentCell_ = at(pos.row, pos.col).mergeParent;
         } else {
             currentCell_ = pos;
         }
@@ -310,7 +458,7 @@ void Table::moveToNextCell() {
     std::size_t row = currentCell_.row;
     
     // Handle merged cells by skipping their span
-    const auto& cell = rows_[currentCell_.row][currentCell_.col];
+    const auto& cell = at(currentCell_.row, currentCell_.col);
     col = currentCell_.col + cell.span.colSpan;
     
     if (col >= colCount()) {
@@ -367,65 +515,37 @@ void Table::moveRight() {
 
 // Total dimensions
 float Table::totalWidth() const {
-    float total = 0.0f;
-    for (float w : colWidths_) {
-        total += w;
-    }
-    return total;
+    return colX_.back();
 }
 
 float Table::totalHeight() const {
-    float total = 0.0f;
-    for (float h : rowHeights_) {
-        total += h;
-    }
-    return total;
+    return rowY_.back();
 }
 
 void Table::setTableBorders(const CellBorders& borders) {
     tableBorders_ = borders;
     // Apply to all cells
-    for (auto& row : rows_) {
-        for (auto& cell : row) {
-            cell.borders = borders;
-        }
+    for (auto& cell : cells_) {
+        cell.borders = borders;
     }
 }
 
+namespace {
+
+// Index of the span in offsets (prefix sums, offsets[0] == 0) holding pos;
+// positions past the end land in the last span
+std::size_t spanAt(const std::vector<float>& offsets, float pos) {
+    auto it = std::upper_bound(offsets.begin() + 1, offsets.end() - 1, pos);
+    return static_cast<std::size_t>(it - (offsets.begin() + 1));
+}
+
+}  // namespace
+
 CellPosition Table::cellAtPoint(float x, float y) const {
     if (isEmpty() || x < 0 || y < 0) {
         return {0, 0};
     }
-    
-    // Find column
-    float accX = 0.0f;
-    std::size_t col = 0;
-    for (std::size_t c = 0; c < colCount(); ++c) {
-        if (x < accX + colWidths_[c]) {
-            col = c;
-            break;
-        }
-        accX += colWidths_[c];
-        if (c == colCount() - 1) {
-            col = c;
-        }
-    }
-    
-    // Find row
-    float accY = 0.0f;
-    std::size_t row = 0;
-    for (std::size_t r = 0; r < rowCount(); ++r) {
-        if (y < accY + rowHeights_[r]) {
-            row = r;
-            break;
-        }
-        accY += rowHeights_[r];
-        if (r == rowCount() - 1) {
-            row = r;
-        }
-    }
-    
-    return {row, col};
+    return {spanAt(rowY_, y), spanAt(colX_, x)};
 }
 
 Table::CellBounds Table::cellBounds(CellPosition pos) const {
@@ -433,43 +553,34 @@ Table::CellBounds Table::cellBounds(CellPosition pos) const {
         return {0, 0, 0, 0};
     }
     
-    // Calculate x position
-    float x = 0.0f;
-    for (std::size_t c = 0; c < pos.col; ++c) {
-        x += colWidths_[c];
-    }
-    
-    // Calculate y position
-    float y = 0.0f;
-    for (std::size_t r = 0; r < pos.row; ++r) {
-        y += rowHeights_[r];
-    }
-    
-    // Calculate width and height (accounting for merge span)
-    const auto& cell = rows_[pos.row][pos.col];
-    float width = 0.0f;
-    for (std::size_t c = 0; c < cell.span.colSpan && pos.col + c < colCount(); ++c) {
-        width += colWidths_[pos.col + c];
-    }
-    
-    float height = 0.0f;
-    for (std::size_t r = 0; r < cell.span.rowSpan && pos.row + r < rowCount(); ++r) {
-        height += rowHeights_[pos.row + r];
+    // Width and height account for the merge span, clipped to the table
+    const auto& cell = at(pos.row, pos.col);
+    std::size_t endCol = std::min(pos.col + cell.span.colSpan, colCount());
+    std::size_t endRow = std::min(pos.row + cell.span.rowSpan, rowCount());
+    return {colX_[pos.col], rowY_[pos.row], colX_[endCol] - colX_[pos.col],
+            rowY_[endRow] - rowY_[pos.row]};
+}
+
+Table::RowRange Table::visibleRows(float top, float bottom) const {
+    if (isEmpty() || bottom <= top || bottom <= 0.0f || top >= totalHeight()) {
+        return {};
     }
-    
-    return {x, y, width, height};
+    // First row whose bottom edge is below top, then the first whose top
+    // edge is at or below bottom
+    auto first = std::upper_bound(rowY_.begin() + 1, rowY_.end(), top);
+    auto last = std::lower_bound(first, rowY_.end() - 1, bottom);
+    return {static_cast<std::size_t>(first - (rowY_.begin() + 1)),
+            static_cast<std::size_t>(last - rowY_.begin())};
 }
 
 void Table::updateMergeInfo() {
     // Reset all merge info
-    for (auto& row : rows_) {
-        for (auto& cell : row) {
-            if (!cell.isMerged) {
-                // Reset span for non-merged cells
-                if (cell.span.rowSpan > 1 || cell.span.colSpan > 1) {
-                    // This is a master cell, update its merged children
-                    // (they may have been shifted by row/col insertion)
-                }
+    for (auto& cell : cells_) {
+        if (!cell.isMerged) {
+            // Reset span for non-merged cells
+            if (cell.span.rowSpan > 1 || cell.span.colSpan > 1) {
+                // This is a master cell, update its merged children
+                // (they may have been shifted by row/col insertion)
             }
         }
     }
@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "document_settings.h"
+#include "formula.h"
 
 // Forward declarations
 class TextBuffer;
@@ -60,7 +61,8 @@ struct CellBorders {
 
 // Individual table cell
 struct TableCell {
-    std::string content;           // Text content of the cell
+    std::string content;           // Text content of the cell (a formula's value)
+    std::string formula;           // "=..." source when the cell holds a formula
     CellSpan span;                 // Merge span information
     CellAlignment alignment = CellAlignment::TopLeft;
     TextColor backgroundColor = TextColors::White;
@@ -76,16 +78,29 @@ struct TableCell {
     int paddingRight = 6;
 };
 
-// Table structure with row and column management
+// Table structure with row and column management.
+//
+// Cells are one row-major array (cells_[row * colCount() + col]) so a row
+// is contiguous and a whole table is one allocation. Column x offsets and
+// row y offsets are kept as prefix sums. When a width, a height or the grid
+// changes, only the sums from the changed index onward are recomputed.
+// cellBounds is then O(1) and cellAtPoint / visibleRows are binary searches.
+//
+// Content starting with '=' set through setCellContent is a formula
+// (formula.h): it is compiled once, kept in formulas_, and the cell's
+// content shows its value. Setting a cell re-evaluates only the formulas
+// that depend on it. Inserting or deleting rows and columns rewrites the
+// references of every formula to follow the cells (formula::Program::shift)
+// and recalculates.
 class Table {
 public:
     Table() = default;
     Table(std::size_t rows, std::size_t cols);
     
     // Dimensions
-    std::size_t rowCount() const { return rows_.size(); }
+    std::size_t rowCount() const { return rowHeights_.size(); }
     std::size_t colCount() const { return colWidths_.size(); }
-    bool isEmpty() const { return rows_.empty() || colWidths_.empty(); }
+    bool isEmpty() const { return rowHeights_.empty() || colWidths_.empty(); }
     
     // Cell access
     TableCell& cell(std::size_t row, std::size_t col);
@@ -93,10 +108,18 @@ public:
     TableCell& cell(CellPosition pos) { return cell(pos.row, pos.col); }
     const TableCell& cell(CellPosition pos) const { return cell(pos.row, pos.col); }
     
-    // Cell content
+    // Cell content ("=..." stores a formula; getCellContent returns its value)
     void setCellContent(std::size_t row, std::size_t col, const std::string& content);
     std::string getCellContent(std::size_t row, std::size_t col) const;
     
+    // Formulas
+    bool hasFormulas() const { return !formulas_.empty(); }
+    // Evaluate every formula (e.g. after editing cells through cell())
+    void recalculate();
+    // Recompile every cell's formula text, keeping the values already in
+    // content (used after loading a saved table, whose values are cached)
+    void rebuildFormulas();
+    
     // Row operations
     void insertRowAbove(std::size_t row);
     void insertRowBelow(std::size_t row);
@@ -155,14 +178,34 @@ public:
     };
     CellBounds cellBounds(CellPosition pos) const;
 
+    // Rows that overlap [top, bottom) (relative to table origin), as the
+    // half-open range [first, last). Empty (first == last) if none do.
+    struct RowRange {
+        std::size_t first = 0;
+        std::size_t last = 0;
+    };
+    RowRange visibleRows(float top, float bottom) const;
+
 private:
     void initializeGrid(std::size_t rows, std::size_t cols);
     void updateMergeInfo();
+    void updateColOffsets(std::size_t from);
+    void updateRowOffsets(std::size_t from);
+    void recalculateFrom(const std::vector<std::size_t>& changed);
+    void applyOrder(const std::vector<std::size_t>& order, const std::vector<std::size_t>& cyclic);
+    void structureChanged(const formula::Shift& shift);
     bool isValidPosition(CellPosition pos) const;
+    TableCell& at(std::size_t row, std::size_t col) { return cells_[row * colCount() + col]; }
+    const TableCell& at(std::size_t row, std::size_t col) const {
+        return cells_[row * colCount() + col];
+    }
     
-    std::vector<std::vector<TableCell>> rows_;  // rows_[row][col]
+    std::vector<TableCell> cells_;               // Row-major, rowCount() * colCount()
     std::vector<float> colWidths_;               // Width of each column
     std::vector<float> rowHeights_;              // Height of each row
+    std::vector<float> colX_ = {0.0f};           // colX_[c] = sum of widths before c
+    std::vector<float> rowY_ = {0.0f};           // rowY_[r] = sum of heights before r
+    formula::Graph formulas_;                    // Keyed by row * colCount() + col
     
     CellPosition currentCell_;                   // Current editing cell
     bool hasSelection_ = false;
@@ -116,25 +116,20 @@ const char* GapBuffer::data(std::size_t pos, std::size_t len) const {
 }
 
 void GapBuffer::copyTo(std::size_t pos, std::size_t len, char* out) const {
-    for (std::size_t i = 0; i < len; ++i) {
-        out[i] = at(pos + i);
+    // At most two contiguous runs: before and after the gap
+    std::size_t before = pos < gap_start_ ? std::min(len, gap_start_ - pos) : 0;
+    if (before > 0) std::memcpy(out, &buffer_[pos], before);
+    if (len > before) {
+        std::size_t afterPos = pos + before - gap_start_;
+        std::memcpy(out + before, &buffer_[gap_end_ + afterPos], len - before);
     }
 }
 
 std::string GapBuffer::toString() const {
     std::string result;
     result.reserve(size());
-
-    // Before gap
-    for (std::size_t i = 0; i < gap_start_; ++i) {
-        result.push_back(buffer_[i]);
-    }
-
-    // After gap
-    for (std::size_t i = gap_end_; i < buffer_.size(); ++i) {
-        result.push_back(buffer_[i]);
-    }
-
+    result.append(buffer_.data(), gap_start_);
+    result.append(buffer_.data() + gap_end_, buffer_.size() - gap_end_);
     return result;
 }
 
@@ -182,6 +177,111 @@ void GapBuffer::setContent(const char* data, std::size_t len) {
     gap_end_ = buffer_.size();
 }
 
+void GapBuffer::setContentWithout(const char* data, std::size_t len, char skip) {
+    constexpr std::size_t GAP_SIZE = 4096;
+    buffer_.resize(len + GAP_SIZE);
+
+    // Copy the runs between skipped bytes; memchr finds them a vector at a time
+    char* out = buffer_.data();
+    std::size_t written = 0;
+    const char* cursor = data;
+    const char* end = data + len;
+    while (cursor < end) {
+        const char* hit = static_cast<const char*>(
+            std::memchr(cursor, skip, static_cast<std::size_t>(end - cursor)));
+        const char* runEnd = hit ? hit : end;
+        std::size_t run = static_cast<std::size_t>(runEnd - cursor);
+        std::memcpy(out + written, cursor, run);
+        written += run;
+        if (!hit) break;
+        cursor = hit + 1;
+    }
+    gap_start_ = written;
+    gap_end_ = buffer_.size();
+}
+
+bool GapBuffer::fillContentWithout(std::size_t maxLen, const ContentWriter& write, char skip) {
+    constexpr std::size_t GAP_SIZE = 4096;
+    buffer_.resize(maxLen + GAP_SIZE);
+    gap_start_ = 0;
+    gap_end_ = buffer_.size();
+
+    std::size_t len = write(buffer_.data());
+    if (len == static_cast<std::size_t>(-1) || len > maxLen) return false;
+
+    // Squeeze out skipped bytes, moving the runs between them down
+    char* out = buffer_.data();
+    char* end = out + len;
+    char* hit = static_cast<char*>(std::memchr(out, skip, len));
+    std::size_t written = hit ? static_cast<std::size_t>(hit - out) : len;
+    while (hit) {
+        char* runStart = hit + 1;
+        hit = static_cast<char*>(
+            std::memchr(runStart, skip, static_cast<std::size_t>(end - runStart)));
+        std::size_t run = static_cast<std::size_t>((hit ? hit : end) - runStart);
+        std::memmove(out + written, runStart, run);
+        written += run;
+    }
+    gap_start_ = written;
+    return true;
+}
+
+// ============================================================================
+// ParagraphFormatTable implementation
+// ============================================================================
+
+std::size_t ParagraphFormatTable::Hash::operator()(const ParagraphFormat& format) const {
+    std::size_t h = std::hash<float>{}(format.lineSpacing);
+    auto mix = [&h](std::size_t value) { h ^= value + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2); };
+    mix(static_cast<std::size_t>(format.style));
+    mix(static_cast<std::size_t>(format.alignment));
+    mix(static_cast<std::size_t>(format.leftIndent));
+    mix(static_cast<std::size_t>(format.firstLineIndent));
+    mix(static_cast<std::size_t>(format.spaceBefore));
+    mix(static_cast<std::size_t>(format.spaceAfter));
+    mix(static_cast<std::size_t>(format.listType));
+    mix(static_cast<std::size_t>(format.listLevel));
+    mix(static_cast<std::size_t>(format.listNumber));
+    mix(static_cast<std::size_t>(format.hasPageBreakBefore));
+    mix(static_cast<std::size_t>(format.hasDropCap));
+    mix(static_cast<std::size_t>(format.dropCapLines));
+    return h;
+}
+
+ParagraphFormatTable::Id ParagraphFormatTable::intern(const ParagraphFormat& format) {
+    auto [it, added] = ids_.try_emplace(format, static_cast<Id>(formats_.size()));
+    if (added) {
+        formats_.push_back(format);
+    }
+    return it->second;
+}
+
+void ParagraphFormatTable::clear() {
+    formats_.assign(1, ParagraphFormat{});
+    ids_.clear();
+    ids_.emplace(ParagraphFormat{}, DEFAULT_ID);
+}
+
+void ParagraphFormatTable::compact(std::vector<Id>& lineIds) {
+    constexpr Id UNUSED = ~Id{0};
+    std::vector<Id> remap(formats_.size(), UNUSED);
+    std::vector<ParagraphFormat> kept;
+    remap[DEFAULT_ID] = DEFAULT_ID;
+    kept.push_back(ParagraphFormat{});
+    for (Id& id : lineIds) {
+        if (remap[id] == UNUSED) {
+            remap[id] = static_cast<Id>(kept.size());
+            kept.push_back(formats_[id]);
+        }
+        id = remap[id];
+    }
+    formats_ = std::move(kept);
+    ids_.clear();
+    for (std::size_t i = 0; i < formats_.size(); ++i) {
+        ids_.emplace(formats_[i], static_cast<Id>(i));
+    }
+}
+
 // ============================================================================
 // TextBuffer implementation (SoA with gap buffer)
 // ============================================================================
@@ -194,6 +294,31 @@ LineSpan TextBuffer::lineSpan(std::size_t row) const {
     if (row >= line_spans_.size()) {
         return {0, 0};
     }
+    const LineExtent& extent = line_spans_[row];
+    const ParagraphFormat& format = formatOf(row);
+    LineSpan span;
+    span.offset = extent.offset;
+    span.length = extent.length;
+    span.style = format.style;
+    span.alignment = format.alignment;
+    span.leftIndent = format.leftIndent;
+    span.firstLineIndent = format.firstLineIndent;
+    span.lineSpacing = format.lineSpacing;
+    span.spaceBefore = format.spaceBefore;
+    span.spaceAfter = format.spaceAfter;
+    span.listType = format.listType;
+    span.listLevel = format.listLevel;
+    span.listNumber = format.listNumber;
+    span.hasPageBreakBefore = format.hasPageBreakBefore;
+    span.hasDropCap = format.hasDropCap;
+    span.dropCapLines = format.dropCapLines;
+    return span;
+}
+
+LineExtent TextBuffer::lineExtent(std::size_t row) const {
+    if (row >= line_spans_.size()) {
+        return {};
+    }
     return line_spans_[row];
 }
 
@@ -202,7 +327,7 @@ std::string TextBuffer::lineString(std::size_t row) const {
         return "";
     }
 
-    const LineSpan& span = line_spans_[row];
+    const LineExtent& span = line_spans_[row];
     if (span.length == 0) {
         return "";
     }
@@ -304,7 +429,7 @@ std::string TextBuffer::getSelectedText() const {
 }
 
 bool TextBuffer::deleteSelection() {
-    if (!has_selection_) {
+    if (!has_selection_ || readOnly_) {
         return false;
     }
 
@@ -332,7 +457,7 @@ bool TextBuffer::deleteSelection() {
     }
 
     // Erase the selected range
-    chars_.erase(startOffset, deleteCount);
+    eraseFromStorage(startOffset, deleteCount);
     stats_.total_deletes += deleteCount;
     version_++;
     
@@ -340,8 +465,10 @@ bool TextBuffer::deleteSelection() {
     adjustHyperlinkOffsets(startOffset, -static_cast<std::ptrdiff_t>(deleteCount));
     adjustBookmarkOffsets(startOffset, -static_cast<std::ptrdiff_t>(deleteCount));
 
-    // Rebuild line index since we may have deleted across lines
-    rebuildLineIndex();
+    // The deleted range may have spanned lines
+    collapseLines(start, end, deleteCount);
+    markLinesDirty(start.row, start.row,
+                   -static_cast<std::ptrdiff_t>(end.row - start.row));
 
     // Move caret to start of deleted region
     caret_ = start;
@@ -364,14 +491,14 @@ std::size_t TextBuffer::positionToOffset(const CaretPosition& pos) const {
         return chars_.size();
     }
 
-    const LineSpan& span = line_spans_[pos.row];
+    const LineExtent& span = line_spans_[pos.row];
     std::size_t col = std::min(pos.column, span.length);
     return span.offset + col;
 }
 
 CaretPosition TextBuffer::offsetToPosition(std::size_t offset) const {
     for (std::size_t row = 0; row < line_spans_.size(); ++row) {
-        const LineSpan& span = line_spans_[row];
+        const LineExtent& span = line_spans_[row];
 
         // Include the newline character in line range check
         std::size_t next_line_start = (row + 1 < line_spans_.size())
@@ -394,81 +521,21 @@ CaretPosition TextBuffer::offsetToPosition(std::size_t offset) const {
     return {0, 0};
 }
 
-void TextBuffer::rebuildLineIndex() {
-  struct LineMetaSnapshot {
-    std::size_t offset = 0;
-    ParagraphStyle style = ParagraphStyle::Normal;
-    TextAlignment alignment = TextAlignment::Left;
-    int leftIndent = 0;
-    int firstLineIndent = 0;
-    float lineSpacing = 1.0f;
-    int spaceBefore = 0;
-    int spaceAfter = 0;
-    ListType listType = ListType::None;
-    int listLevel = 0;
-    int listNumber = 1;
-    bool hasPageBreakBefore = false;
-    bool hasDropCap = false;
-    int dropCapLines = 2;
-  };
-
-  std::vector<LineMetaSnapshot> savedMeta;
-  savedMeta.reserve(line_spans_.size());
-  for (const auto& span : line_spans_) {
-    LineMetaSnapshot snapshot;
-    snapshot.offset = span.offset;
-    snapshot.style = span.style;
-    snapshot.alignment = span.alignment;
-    snapshot.leftIndent = span.leftIndent;
-    snapshot.firstLineIndent = span.firstLineIndent;
-    snapshot.lineSpacing = span.lineSpacing;
-    snapshot.spaceBefore = span.spaceBefore;
-    snapshot.spaceAfter = span.spaceAfter;
-    snapshot.listType = span.listType;
-    snapshot.listLevel = span.listLevel;
-    snapshot.listNumber = span.listNumber;
-    snapshot.hasPageBreakBefore = span.hasPageBreakBefore;
-    snapshot.hasDropCap = span.hasDropCap;
-    snapshot.dropCapLines = span.dropCapLines;
-    savedMeta.push_back(snapshot);
-  }
-
-  line_spans_.clear();
-
-  std::size_t total = chars_.size();
-  std::size_t line_start = 0;
-
-  for (std::size_t i = 0; i < total; ++i) {
-    if (chars_.at(i) == '\n') {
-      line_spans_.push_back({line_start, i - line_start});
-      line_start = i + 1;
-    }
-  }
+void TextBuffer::collapseLines(CaretPosition start, CaretPosition end, std::size_t erased) {
+    std::size_t lastRow = line_spans_.size() - 1;
+    if (end.row > lastRow) end = {lastRow, line_spans_[lastRow].length};
+    start.column = std::min(start.column, line_spans_[start.row].length);
+    end.column = std::min(end.column, line_spans_[end.row].length);
 
-  // Add final line (may be empty)
-  line_spans_.push_back({line_start, total - line_start});
-
-  // Restore metadata based on line start offsets
-  for (const auto& snapshot : savedMeta) {
-    for (auto& span : line_spans_) {
-      if (span.offset == snapshot.offset) {
-        span.style = snapshot.style;
-        span.alignment = snapshot.alignment;
-        span.leftIndent = snapshot.leftIndent;
-        span.firstLineIndent = snapshot.firstLineIndent;
-        span.lineSpacing = snapshot.lineSpacing;
-        span.spaceBefore = snapshot.spaceBefore;
-        span.spaceAfter = snapshot.spaceAfter;
-        span.listType = snapshot.listType;
-        span.listLevel = snapshot.listLevel;
-        span.listNumber = snapshot.listNumber;
-        span.hasPageBreakBefore = snapshot.hasPageBreakBefore;
-        span.hasDropCap = snapshot.hasDropCap;
-        span.dropCapLines = snapshot.dropCapLines;
-        break;
-      }
+    // What was left of end's line joins start's, which keeps its format
+    line_spans_[start.row].length = start.column + (line_spans_[end.row].length - end.column);
+    if (end.row > start.row) {
+        auto first = static_cast<std::ptrdiff_t>(start.row + 1);
+        auto last = static_cast<std::ptrdiff_t>(end.row + 1);
+        line_spans_.erase(line_spans_.begin() + first, line_spans_.begin() + last);
+        line_formats_.erase(line_formats_.begin() + first, line_formats_.begin() + last);
     }
-  }
+    shiftLineOffsetsFrom(start.row + 1, -static_cast<std::ptrdiff_t>(erased));
 }
 
 void TextBuffer::shiftLineOffsetsFrom(std::size_t startRow, std::ptrdiff_t delta) {
@@ -478,7 +545,35 @@ void TextBuffer::shiftLineOffsetsFrom(std::size_t startRow, std::ptrdiff_t delta
   }
 }
 
+void TextBuffer::markLinesDirty(std::size_t first, std::size_t last,
+                                std::ptrdiff_t lineDelta) {
+    if (dirty_.all) return;
+    if (!dirty_.any) {
+        dirty_ = {true, false, first, last, lineDelta};
+        return;
+    }
+    // Carry the pending range's end through this edit: rows past the edited
+    // region move by lineDelta, rows inside it collapse onto its end.
+    auto pendingLast = static_cast<std::ptrdiff_t>(dirty_.last);
+    auto editOldLast = static_cast<std::ptrdiff_t>(last) - lineDelta;
+    if (pendingLast > editOldLast) {
+        pendingLast += lineDelta;
+    } else if (pendingLast >= static_cast<std::ptrdiff_t>(first)) {
+        pendingLast = static_cast<std::ptrdiff_t>(last);
+    }
+    dirty_.first = std::min(dirty_.first, first);
+    dirty_.last = std::max(last, static_cast<std::size_t>(pendingLast));
+    dirty_.lineDelta += lineDelta;
+}
+
+DirtyLines TextBuffer::takeDirtyLines() {
+    DirtyLines taken = dirty_;
+    dirty_ = DirtyLines{};
+    return taken;
+}
+
 void TextBuffer::insertChar(char ch) {
+    if (readOnly_) return;
     ensureNonEmpty();
 
     // Delete any selected text first
@@ -491,7 +586,7 @@ void TextBuffer::insertChar(char ch) {
     version_++;  // Content changed - invalidate render cache
 
     std::size_t offset = positionToOffset(caret_);
-    chars_.insert(offset, ch);
+    insertIntoStorage(offset, ch);
     
     // Adjust hyperlink and bookmark offsets for the inserted character
     adjustHyperlinkOffsets(offset, 1);
@@ -500,31 +595,33 @@ void TextBuffer::insertChar(char ch) {
     if (ch == '\n') {
         // Split current line - preserve paragraph styles
         std::size_t splitRow = caret_.row;
-        LineSpan oldSpan = line_spans_[splitRow];
+        LineExtent oldSpan = line_spans_[splitRow];
+        const ParagraphFormat& oldFormat = formatOf(splitRow);
         
         // Current line ends at caret position
         line_spans_[splitRow].length = caret_.column;
         
         // New line starts after newline character
-        LineSpan newSpan;
+        LineExtent newSpan;
         newSpan.offset = offset + 1;
         newSpan.length = (oldSpan.offset + oldSpan.length) - offset;
-        newSpan.style = ParagraphStyle::Normal;  // New line gets Normal style
-        newSpan.alignment = oldSpan.alignment;   // Inherit alignment
-        newSpan.leftIndent = oldSpan.leftIndent; // Inherit indentation
-        newSpan.firstLineIndent = oldSpan.firstLineIndent;
-        newSpan.lineSpacing = oldSpan.lineSpacing;
-        newSpan.listType = oldSpan.listType;     // Inherit list properties
-        newSpan.listLevel = oldSpan.listLevel;
-        if (oldSpan.listType != ListType::None) {
-            newSpan.listNumber = oldSpan.listNumber + 1;
+        ParagraphFormat newFormat;                   // New line gets Normal style
+        newFormat.alignment = oldFormat.alignment;   // Inherit alignment
+        newFormat.leftIndent = oldFormat.leftIndent; // Inherit indentation
+        newFormat.firstLineIndent = oldFormat.firstLineIndent;
+        newFormat.lineSpacing = oldFormat.lineSpacing;
+        newFormat.listType = oldFormat.listType;     // Inherit list properties
+        newFormat.listLevel = oldFormat.listLevel;
+        if (oldFormat.listType != ListType::None) {
+            newFormat.listNumber = oldFormat.listNumber + 1;
         }
         
         // Insert new line span
-        line_spans_.insert(line_spans_.begin() + splitRow + 1, newSpan);
+        insertLine(splitRow + 1, newSpan, formats_.intern(newFormat));
         
         // Shift offsets of subsequent lines
         shiftLineOffsetsFrom(splitRow + 2, 1);
+        markLinesDirty(splitRow, splitRow + 1, 1);
         
         caret_.row += 1;
         caret_.column = 0;
@@ -533,6 +630,7 @@ void TextBuffer::insertChar(char ch) {
     if (caret_.row < line_spans_.size()) {
       line_spans_[caret_.row].length += 1;
       shiftLineOffsetsFrom(caret_.row + 1, 1);
+      markLinesDirty(caret_.row, caret_.row, 0);
     }
     caret_.column += 1;
     }
@@ -549,49 +647,51 @@ void TextBuffer::insertText(const std::string& text) {
     }
 }
 
-void TextBuffer::setText(const std::string& text) {
-    chars_.clear();
-    line_spans_.clear();
+void TextBuffer::setText(std::string_view text) {
+    clearLines();
     hyperlinks_.clear();  // Clear all hyperlinks when setting new text
     version_++;  // Content changed - invalidate render cache
+    loadGeneration_++;
+    dirty_ = {true, true, 0, 0, 0};
 
-    if (!text.empty()) {
-        // Optimized two-pass approach:
-        // Pass 1: Clean CRLF (copies to temp buffer)
-        // Pass 2: Build line index (scans cleaned buffer)
-        // Then bulk load to gap buffer (single memcpy)
-        
-        std::string cleaned;
-        cleaned.reserve(text.size());
-        
-        for (char ch : text) {
-            if (ch != '\r') {
-                cleaned.push_back(ch);
-            }
-        }
-        
-        // Bulk load into gap buffer (single memcpy, no per-char overhead)
-        chars_.setContent(cleaned.data(), cleaned.size());
-        
-        // Build line index in single pass over cleaned data
-        line_spans_.reserve(cleaned.size() / 40 + 1);  // Estimate ~40 chars per line
-        std::size_t line_start = 0;
-        const char* data = cleaned.data();
-        std::size_t len = cleaned.size();
-        
-        for (std::size_t i = 0; i < len; ++i) {
-            if (data[i] == '\n') {
-                line_spans_.push_back({line_start, i - line_start});
-                line_start = i + 1;
-            }
-        }
-        
-        // Add final line (may be empty)
-        line_spans_.push_back({line_start, len - line_start});
-    } else {
-        // Empty document - single empty line
-        line_spans_.push_back({0, 0});
-    }
+    // One copy straight from the source (e.g. mapped file pages) into the
+    // gap buffer, dropping CRs on the way
+    chars_.setContentWithout(text.data(), text.size(), '\r');
+    indexLoadedText();
+    if (editListener_) editListener_->onReset(*this);
+}
+
+bool TextBuffer::setTextFrom(std::size_t maxLength, const GapBuffer::ContentWriter& write) {
+    clearLines();
+    hyperlinks_.clear();
+    version_++;
+    loadGeneration_++;
+    dirty_ = {true, true, 0, 0, 0};
+
+    bool ok = chars_.fillContentWithout(maxLength, write, '\r');
+    indexLoadedText();
+    if (editListener_) editListener_->onReset(*this);
+    return ok;
+}
+
+void TextBuffer::indexLoadedText() {
+    // Freshly loaded content sits contiguous before the gap, so the line
+    // index is built with memchr over it
+    std::size_t len = chars_.size();
+    const char* data = len > 0 ? chars_.data(0, len) : nullptr;
+
+    line_spans_.reserve(len / 40 + 1);  // Estimate ~40 chars per line
+    std::size_t line_start = 0;
+    while (line_start < len) {
+        const void* hit = std::memchr(data + line_start, '\n', len - line_start);
+        if (!hit) break;
+        std::size_t newline = static_cast<std::size_t>(static_cast<const char*>(hit) - data);
+        line_spans_.push_back({line_start, newline - line_start});
+        line_start = newline + 1;
+    }
+    // Add final line (may be empty)
+    line_spans_.push_back({line_start, len - line_start});
+    line_formats_.assign(line_spans_.size(), ParagraphFormatTable::DEFAULT_ID);
 
     // Move caret to end
     if (!line_spans_.empty()) {
@@ -605,14 +705,15 @@ void TextBuffer::setText(const std::string& text) {
 
 std::string TextBuffer::getText() const { return chars_.toString(); }
 
-TextStats TextBuffer::stats() const {
-    TextStats stats;
-    std::string text = getText();
-    stats.lines = line_spans_.size();
+void TextBuffer::forEachTextChunk(const std::function<void(std::string_view)>& visit) const {
+    if (!chars_.beforeGap().empty()) visit(chars_.beforeGap());
+    if (!chars_.afterGap().empty()) visit(chars_.afterGap());
+}
 
-    bool inWord = false;
-    for (std::size_t i = 0; i < text.size(); ++i) {
-        char ch = text[i];
+// Characters, words and sentences of one run of text. inWord carries a
+// word across runs.
+static void accumulateTextStats(std::string_view text, TextStats& stats, bool& inWord) {
+    for (char ch : text) {
         if (ch != '\n') {
             stats.characters++;
         }
@@ -628,6 +729,19 @@ TextStats TextBuffer::stats() const {
             stats.sentences++;
         }
     }
+}
+
+TextStats TextBuffer::stats() const {
+    // The status bar asks every frame; recount only after edits
+    if (statsVersion_ == version_) {
+        return statsCache_;
+    }
+
+    TextStats stats;
+    bool inWord = false;
+    forEachTextChunk(
+        [&](std::string_view chunk) { accumulateTextStats(chunk, stats, inWord); });
+    stats.lines = line_spans_.size();
 
     // Paragraphs: count non-empty lines
     for (const auto& span : line_spans_) {
@@ -636,108 +750,172 @@ TextStats TextBuffer::stats() const {
         }
     }
 
+    statsCache_ = stats;
+    statsVersion_ = version_;
+    statsEndsInWord_ = inWord;
     return stats;
 }
 
+void TextBuffer::appendLoadedText(std::string_view text, const std::vector<std::size_t>& newlines) {
+    if (text.empty()) return;
+    bool statsCurrent = statsVersion_ == version_;
+    std::size_t base = chars_.size();
+    std::size_t firstRow = line_spans_.size() - 1;
+    bool firstRowWasEmpty = line_spans_[firstRow].length == 0;
+
+    chars_.insertString(base, text.data(), text.size());
+
+    // The first newline ends the current last line; each later one ends a
+    // line that starts in text
+    std::size_t lineStart = 0;
+    bool extendingLast = true;
+    for (std::size_t newline : newlines) {
+        if (extendingLast) {
+            line_spans_[firstRow].length += newline;
+            extendingLast = false;
+        } else {
+            line_spans_.push_back({base + lineStart, newline - lineStart});
+        }
+        lineStart = newline + 1;
+    }
+    if (extendingLast) {
+        line_spans_[firstRow].length += text.size();
+    } else {
+        line_spans_.push_back({base + lineStart, text.size() - lineStart});
+    }
+    line_formats_.resize(line_spans_.size(), ParagraphFormatTable::DEFAULT_ID);
+
+    version_++;
+    markLinesDirty(firstRow, line_spans_.size() - 1,
+                   static_cast<std::ptrdiff_t>(newlines.size()));
+    if (statsCurrent) {
+        // Count only what arrived, so the status bar keeps up while loading
+        accumulateTextStats(text, statsCache_, statsEndsInWord_);
+        statsCache_.lines = line_spans_.size();
+        if (firstRowWasEmpty && line_spans_[firstRow].length > 0) {
+            statsCache_.paragraphs++;
+        }
+        for (std::size_t row = firstRow + 1; row < line_spans_.size(); ++row) {
+            if (line_spans_[row].length > 0) statsCache_.paragraphs++;
+        }
+        statsVersion_ = version_;
+    }
+    if (editListener_) editListener_->onInsert(base, text);
+}
+
 TextStyle TextBuffer::textStyle() const { return style_; }
 
-void TextBuffer::setTextStyle(const TextStyle& style) { style_ = style; }
+void TextBuffer::setTextStyle(const TextStyle& style) {
+    style_ = style;
+    if (editListener_) editListener_->onStyleChanged(style_);
+}
+
+void TextBuffer::insertIntoStorage(std::size_t offset, char ch) {
+    chars_.insert(offset, ch);
+    if (editListener_) editListener_->onInsert(offset, std::string_view(&ch, 1));
+}
+
+void TextBuffer::eraseFromStorage(std::size_t offset, std::size_t count) {
+    chars_.erase(offset, count);
+    if (editListener_) editListener_->onErase(offset, count);
+}
 
 ParagraphStyle TextBuffer::currentParagraphStyle() const {
     if (caret_.row < line_spans_.size()) {
-        return line_spans_[caret_.row].style;
+        return formatOf(caret_.row).style;
     }
     return ParagraphStyle::Normal;
 }
 
 void TextBuffer::setCurrentParagraphStyle(ParagraphStyle style) {
     if (caret_.row < line_spans_.size()) {
-        line_spans_[caret_.row].style = style;
+        editFormat(caret_.row, [&](ParagraphFormat& f) { f.style = style; });
         version_++;  // Style change invalidates render cache
     }
 }
 
 ParagraphStyle TextBuffer::lineParagraphStyle(std::size_t row) const {
     if (row < line_spans_.size()) {
-        return line_spans_[row].style;
+        return formatOf(row).style;
     }
     return ParagraphStyle::Normal;
 }
 
 TextAlignment TextBuffer::currentAlignment() const {
     if (caret_.row < line_spans_.size()) {
-        return line_spans_[caret_.row].alignment;
+        return formatOf(caret_.row).alignment;
     }
     return TextAlignment::Left;
 }
 
 void TextBuffer::setCurrentAlignment(TextAlignment align) {
     if (caret_.row < line_spans_.size()) {
-        line_spans_[caret_.row].alignment = align;
+        editFormat(caret_.row, [&](ParagraphFormat& f) { f.alignment = align; });
         version_++;  // Alignment change invalidates render cache
     }
 }
 
 TextAlignment TextBuffer::lineAlignment(std::size_t row) const {
     if (row < line_spans_.size()) {
-        return line_spans_[row].alignment;
+        return formatOf(row).alignment;
     }
     return TextAlignment::Left;
 }
 
 int TextBuffer::currentLeftIndent() const {
     if (caret_.row < line_spans_.size()) {
-        return line_spans_[caret_.row].leftIndent;
+        return formatOf(caret_.row).leftIndent;
     }
     return 0;
 }
 
 int TextBuffer::currentFirstLineIndent() const {
     if (caret_.row < line_spans_.size()) {
-        return line_spans_[caret_.row].firstLineIndent;
+        return formatOf(caret_.row).firstLineIndent;
     }
     return 0;
 }
 
 void TextBuffer::setCurrentLeftIndent(int pixels) {
     if (caret_.row < line_spans_.size()) {
-        line_spans_[caret_.row].leftIndent = std::max(0, pixels);
+        editFormat(caret_.row, [&](ParagraphFormat& f) { f.leftIndent = std::max(0, pixels); });
         version_++;  // Indent change invalidates render cache
     }
 }
 
 void TextBuffer::setCurrentFirstLineIndent(int pixels) {
     if (caret_.row < line_spans_.size()) {
-        line_spans_[caret_.row].firstLineIndent = pixels;  // Can be negative for hanging indent
+        // Can be negative for hanging indent
+        editFormat(caret_.row, [&](ParagraphFormat& f) { f.firstLineIndent = pixels; });
         version_++;
     }
 }
 
 void TextBuffer::increaseIndent(int amount) {
     if (caret_.row < line_spans_.size()) {
-        line_spans_[caret_.row].leftIndent += amount;
+        editFormat(caret_.row, [&](ParagraphFormat& f) { f.leftIndent += amount; });
         version_++;
     }
 }
 
 void TextBuffer::decreaseIndent(int amount) {
     if (caret_.row < line_spans_.size()) {
-        int current = line_spans_[caret_.row].leftIndent;
-        line_spans_[caret_.row].leftIndent = std::max(0, current - amount);
+        editFormat(caret_.row,
+                   [&](ParagraphFormat& f) { f.leftIndent = std::max(0, f.leftIndent - amount); });
         version_++;
     }
 }
 
 int TextBuffer::lineLeftIndent(std::size_t row) const {
     if (row < line_spans_.size()) {
-        return line_spans_[row].leftIndent;
+        return formatOf(row).leftIndent;
     }
     return 0;
 }
 
 int TextBuffer::lineFirstLineIndent(std::size_t row) const {
     if (row < line_spans_.size()) {
-        return line_spans_[row].firstLineIndent;
+        return formatOf(row).firstLineIndent;
     }
     return 0;
 }
@@ -748,21 +926,21 @@ int TextBuffer::lineFirstLineIndent(std::size_t row) const {
 
 float TextBuffer::currentLineSpacing() const {
     if (caret_.row < line_spans_.size()) {
-        return line_spans_[caret_.row].lineSpacing;
+        return formatOf(caret_.row).lineSpacing;
     }
     return 1.0f;
 }
 
 int TextBuffer::currentSpaceBefore() const {
     if (caret_.row < line_spans_.size()) {
-        return line_spans_[caret_.row].spaceBefore;
+        return formatOf(caret_.row).spaceBefore;
     }
     return 0;
 }
 
 int TextBuffer::currentSpaceAfter() const {
     if (caret_.row < line_spans_.size()) {
-        return line_spans_[caret_.row].spaceAfter;
+        return formatOf(caret_.row).spaceAfter;
     }
     return 0;
 }
@@ -770,21 +948,23 @@ int TextBuffer::currentSpaceAfter() const {
 void TextBuffer::setCurrentLineSpacing(float multiplier) {
     if (caret_.row < line_spans_.size()) {
         // Clamp to reasonable range (0.5 to 3.0)
-        line_spans_[caret_.row].lineSpacing = std::max(0.5f, std::min(3.0f, multiplier));
+        editFormat(caret_.row, [&](ParagraphFormat& f) {
+            f.lineSpacing = std::max(0.5f, std::min(3.0f, multiplier));
+        });
         version_++;
     }
 }
 
 void TextBuffer::setCurrentSpaceBefore(int pixels) {
     if (caret_.row < line_spans_.size()) {
-        line_spans_[caret_.row].spaceBefore = std::max(0, pixels);
+        editFormat(caret_.row, [&](ParagraphFormat& f) { f.spaceBefore = std::max(0, pixels); });
         version_++;
     }
 }
 
 void TextBuffer::setCurrentSpaceAfter(int pixels) {
     if (caret_.row < line_spans_.size()) {
-        line_spans_[caret_.row].spaceAfter = std::max(0, pixels);
+        editFormat(caret_.row, [&](ParagraphFormat& f) { f.spaceAfter = std::max(0, pixels); });
         version_++;
     }
 }
@@ -803,42 +983,42 @@ void TextBuffer::setLineSpacingDouble() {
 
 float TextBuffer::lineSpacing(std::size_t row) const {
     if (row < line_spans_.size()) {
-        return line_spans_[row].lineSpacing;
+        return formatOf(row).lineSpacing;
     }
     return 1.0f;
 }
 
 int TextBuffer::lineSpaceBefore(std::size_t row) const {
     if (row < line_spans_.size()) {
-        return line_spans_[row].spaceBefore;
+        return formatOf(row).spaceBefore;
     }
     return 0;
 }
 
 int TextBuffer::lineSpaceAfter(std::size_t row) const {
     if (row < line_spans_.size()) {
-        return line_spans_[row].spaceAfter;
+        return formatOf(row).spaceAfter;
     }
     return 0;
 }
 
 ListType TextBuffer::currentListType() const {
     if (caret_.row < line_spans_.size()) {
-        return line_spans_[caret_.row].listType;
+        return formatOf(caret_.row).listType;
     }
     return ListType::None;
 }
 
 int TextBuffer::currentListLevel() const {
     if (caret_.row < line_spans_.size()) {
-        return line_spans_[caret_.row].listLevel;
+        return formatOf(caret_.row).listLevel;
     }
     return 0;
 }
 
 void TextBuffer::setCurrentListType(ListType type) {
     if (caret_.row < line_spans_.size()) {
-        line_spans_[caret_.row].listType = type;
+        editFormat(caret_.row, [&](ParagraphFormat& f) { f.listType = type; });
         if (type == ListType::Numbered) {
             // Renumber from this line forward
             renumberListsFrom(caret_.row);
@@ -849,11 +1029,13 @@ void TextBuffer::setCurrentListType(ListType type) {
 
 void TextBuffer::toggleBulletedList() {
     if (caret_.row < line_spans_.size()) {
-        if (line_spans_[caret_.row].listType == ListType::Bulleted) {
-            line_spans_[caret_.row].listType = ListType::None;
-            line_spans_[caret_.row].listLevel = 0;
+        if (formatOf(caret_.row).listType == ListType::Bulleted) {
+            editFormat(caret_.row, [](ParagraphFormat& f) {
+                f.listType = ListType::None;
+                f.listLevel = 0;
+            });
         } else {
-            line_spans_[caret_.row].listType = ListType::Bulleted;
+            editFormat(caret_.row, [](ParagraphFormat& f) { f.listType = ListType::Bulleted; });
         }
         version_++;
     }
@@ -861,11 +1043,13 @@ void TextBuffer::toggleBulletedList() {
 
 void TextBuffer::toggleNumberedList() {
     if (caret_.row < line_spans_.size()) {
-        if (line_spans_[caret_.row].listType == ListType::Numbered) {
-            line_spans_[caret_.row].listType = ListType::None;
-            line_spans_[caret_.row].listLevel = 0;
+        if (formatOf(caret_.row).listType == ListType::Numbered) {
+            editFormat(caret_.row, [](ParagraphFormat& f) {
+                f.listType = ListType::None;
+                f.listLevel = 0;
+            });
         } else {
-            line_spans_[caret_.row].listType = ListType::Numbered;
+            editFormat(caret_.row, [](ParagraphFormat& f) { f.listType = ListType::Numbered; });
             renumberListsFrom(caret_.row);
         }
         version_++;
@@ -874,9 +1058,10 @@ void TextBuffer::toggleNumberedList() {
 
 void TextBuffer::increaseListLevel() {
     if (caret_.row < line_spans_.size()) {
-        if (line_spans_[caret_.row].listType != ListType::None) {
-            line_spans_[caret_.row].listLevel = std::min(8, line_spans_[caret_.row].listLevel + 1);
-            if (line_spans_[caret_.row].listType == ListType::Numbered) {
+        if (formatOf(caret_.row).listType != ListType::None) {
+            editFormat(caret_.row,
+                       [](ParagraphFormat& f) { f.listLevel = std::min(8, f.listLevel + 1); });
+            if (formatOf(caret_.row).listType == ListType::Numbered) {
                 renumberListsFrom(caret_.row);
             }
             version_++;
@@ -886,9 +1071,9 @@ void TextBuffer::increaseListLevel() {
 
 void TextBuffer::decreaseListLevel() {
     if (caret_.row < line_spans_.size()) {
-        if (line_spans_[caret_.row].listType != ListType::None && line_spans_[caret_.row].listLevel > 0) {
-            line_spans_[caret_.row].listLevel--;
-            if (line_spans_[caret_.row].listType == ListType::Numbered) {
+        if (formatOf(caret_.row).listType != ListType::None && formatOf(caret_.row).listLevel > 0) {
+            editFormat(caret_.row, [](ParagraphFormat& f) { f.listLevel--; });
+            if (formatOf(caret_.row).listType == ListType::Numbered) {
                 renumberListsFrom(caret_.row);
             }
             version_++;
@@ -898,27 +1083,73 @@ void TextBuffer::decreaseListLevel() {
 
 ListType TextBuffer::lineListType(std::size_t row) const {
     if (row < line_spans_.size()) {
-        return line_spans_[row].listType;
+        return formatOf(row).listType;
     }
     return ListType::None;
 }
 
 int TextBuffer::lineListLevel(std::size_t row) const {
     if (row < line_spans_.size()) {
-        return line_spans_[row].listLevel;
+        return formatOf(row).listLevel;
     }
     return 0;
 }
 
 int TextBuffer::lineListNumber(std::size_t row) const {
     if (row < line_spans_.size()) {
-        return line_spans_[row].listNumber;
+        return formatOf(row).listNumber;
     }
     return 1;
 }
 
+ParagraphFormat TextBuffer::lineFormat(std::size_t row) const {
+    if (row >= line_spans_.size()) {
+        return {};
+    }
+    return formatOf(row);
+}
+
+void TextBuffer::setLineFormat(std::size_t row, const ParagraphFormat& format) {
+    if (row >= line_spans_.size()) {
+        return;
+    }
+    setFormat(row, format);
+    version_++;  // Style change invalidates render cache
+}
+
+void TextBuffer::setFormat(std::size_t row, const ParagraphFormat& format) {
+    line_formats_[row] = formats_.intern(format);
+    if (editListener_) editListener_->onLineFormatChanged(row, format);
+    // Renumbering long lists leaves formats behind; drop them once they
+    // outnumber the lines
+    if (formats_.size() > 1024 && formats_.size() > 2 * line_formats_.size()) {
+        formats_.compact(line_formats_);
+    }
+}
+
+void TextBuffer::insertLine(std::size_t row, LineExtent extent,
+                            ParagraphFormatTable::Id format) {
+    line_spans_.insert(line_spans_.begin() + static_cast<std::ptrdiff_t>(row), extent);
+    line_formats_.insert(line_formats_.begin() + static_cast<std::ptrdiff_t>(row), format);
+    if (editListener_ && format != ParagraphFormatTable::DEFAULT_ID) {
+        editListener_->onLineFormatChanged(row, formats_[format]);
+    }
+}
+
+void TextBuffer::eraseLine(std::size_t row) {
+    line_spans_.erase(line_spans_.begin() + static_cast<std::ptrdiff_t>(row));
+    line_formats_.erase(line_formats_.begin() + static_cast<std::ptrdiff_t>(row));
+}
+
+void TextBuffer::clearLines() {
+    line_spans_.clear();
+    line_formats_.clear();
+    formats_.clear();
+}
+
 // Page break methods
 void TextBuffer::insertPageBreak() {
+    if (readOnly_) return;
     ensureNonEmpty();
     
     // Delete any selected text first
@@ -929,14 +1160,14 @@ void TextBuffer::insertPageBreak() {
     
     // Mark the new line as having a page break before it
     if (caret_.row < line_spans_.size()) {
-        line_spans_[caret_.row].hasPageBreakBefore = true;
+        editFormat(caret_.row, [](ParagraphFormat& f) { f.hasPageBreakBefore = true; });
         version_++;  // Content changed - invalidate render cache
     }
 }
 
 bool TextBuffer::hasPageBreakBefore(std::size_t row) const {
     if (row < line_spans_.size()) {
-        return line_spans_[row].hasPageBreakBefore;
+        return formatOf(row).hasPageBreakBefore;
     }
     return false;
 }
@@ -944,8 +1175,8 @@ bool TextBuffer::hasPageBreakBefore(std::size_t row) const {
 void TextBuffer::togglePageBreak() {
     ensureNonEmpty();
     if (caret_.row < line_spans_.size() && caret_.row > 0) {
-        line_spans_[caret_.row].hasPageBreakBefore = 
-            !line_spans_[caret_.row].hasPageBreakBefore;
+        editFormat(caret_.row,
+                   [](ParagraphFormat& f) { f.hasPageBreakBefore = !f.hasPageBreakBefore; });
         version_++;  // Content changed - invalidate render cache
     }
 }
@@ -953,14 +1184,14 @@ void TextBuffer::togglePageBreak() {
 void TextBuffer::clearPageBreak() {
     ensureNonEmpty();
     if (caret_.row < line_spans_.size()) {
-        line_spans_[caret_.row].hasPageBreakBefore = false;
+        editFormat(caret_.row, [](ParagraphFormat& f) { f.hasPageBreakBefore = false; });
         version_++;  // Content changed - invalidate render cache
     }
 }
 
 bool TextBuffer::currentLineHasDropCap() const {
     if (caret_.row < line_spans_.size()) {
-        return line_spans_[caret_.row].hasDropCap;
+        return formatOf(caret_.row).hasDropCap;
     }
     return false;
 }
@@ -968,16 +1199,18 @@ bool TextBuffer::currentLineHasDropCap() const {
 void TextBuffer::setCurrentLineDropCap(bool enabled, int spanLines) {
     ensureNonEmpty();
     if (caret_.row < line_spans_.size()) {
-        line_spans_[caret_.row].hasDropCap = enabled;
-        line_spans_[caret_.row].dropCapLines = std::max(2, spanLines);
+        editFormat(caret_.row, [&](ParagraphFormat& f) {
+            f.hasDropCap = enabled;
+            f.dropCapLines = std::max(2, spanLines);
+        });
         version_++;  // Invalidate render cache
     }
 }
 
 void TextBuffer::toggleCurrentLineDropCap() {
     if (caret_.row < line_spans_.size()) {
-        bool enabled = !line_spans_[caret_.row].hasDropCap;
-        setCurrentLineDropCap(enabled, line_spans_[caret_.row].dropCapLines);
+        bool enabled = !formatOf(caret_.row).hasDropCap;
+        setCurrentLineDropCap(enabled, formatOf(caret_.row).dropCapLines);
     }
 }
 
@@ -988,19 +1221,20 @@ void TextBuffer::renumberListsFrom(std::size_t startRow) {
     
     // Find the start of this list block (scan backwards)
     std::size_t blockStart = startRow;
-    while (blockStart > 0 && line_spans_[blockStart - 1].listType == ListType::Numbered) {
+    while (blockStart > 0 && formatOf(blockStart - 1).listType == ListType::Numbered) {
         blockStart--;
     }
     
     // Reset counters and renumber from block start
     for (std::size_t row = blockStart; row < line_spans_.size(); row++) {
-        if (line_spans_[row].listType != ListType::Numbered) {
+        if (formatOf(row).listType != ListType::Numbered) {
             // End of numbered list block
             break;
         }
-        int level = line_spans_[row].listLevel;
+        int level = formatOf(row).listLevel;
         levelCounters[static_cast<size_t>(level)]++;
-        line_spans_[row].listNumber = levelCounters[static_cast<size_t>(level)];
+        int number = levelCounters[static_cast<size_t>(level)];
+        editFormat(row, [&](ParagraphFormat& f) { f.listNumber = number; });
         
         // Reset counters for deeper levels when we're at a shallower level
         for (int i = level + 1; i < 9; i++) {
@@ -1024,6 +1258,7 @@ void TextBuffer::resetPerfStats() {
 }
 
 void TextBuffer::backspace() {
+    if (readOnly_) return;
     ensureNonEmpty();
 
     // If there's a selection, delete it instead of single char
@@ -1037,7 +1272,7 @@ void TextBuffer::backspace() {
         char deletedChar = chars_.at(offset - 1);
         CaretPosition deletePos = {caret_.row, caret_.column - 1};
 
-        chars_.erase(offset - 1, 1);
+        eraseFromStorage(offset - 1, 1);
         stats_.total_deletes++;
         version_++;  // Content changed - invalidate render cache
         
@@ -1047,6 +1282,7 @@ void TextBuffer::backspace() {
 
         line_spans_[caret_.row].length -= 1;
         shiftLineOffsetsFrom(caret_.row + 1, -1);
+        markLinesDirty(caret_.row, caret_.row, 0);
         caret_.column -= 1;
 
         // Record for undo
@@ -1067,7 +1303,7 @@ void TextBuffer::backspace() {
         line_spans_[caret_.row - 1].offset + prev_line_len;
     CaretPosition deletePos = {caret_.row - 1, prev_line_len};
 
-    chars_.erase(newline_offset, 1);
+    eraseFromStorage(newline_offset, 1);
     stats_.total_deletes++;
     version_++;
     
@@ -1075,7 +1311,8 @@ void TextBuffer::backspace() {
     adjustHyperlinkOffsets(newline_offset, -1);
     adjustBookmarkOffsets(newline_offset, -1);
 
-    rebuildLineIndex();
+    collapseLines(deletePos, {caret_.row, 0}, 1);
+    markLinesDirty(caret_.row - 1, caret_.row - 1, -1);
 
     caret_.row -= 1;
     caret_.column = prev_line_len;
@@ -1088,6 +1325,7 @@ void TextBuffer::backspace() {
 }
 
 void TextBuffer::del() {
+    if (readOnly_) return;
     ensureNonEmpty();
 
     // If there's a selection, delete it instead of single char
@@ -1095,7 +1333,7 @@ void TextBuffer::del() {
         return;
     }
 
-    const LineSpan& span = line_spans_[caret_.row];
+    const LineExtent& span = line_spans_[caret_.row];
 
     if (caret_.column < span.length) {
         // Delete character at caret
@@ -1103,7 +1341,7 @@ void TextBuffer::del() {
         char deletedChar = chars_.at(offset);
         CaretPosition deletePos = caret_;
 
-        chars_.erase(offset, 1);
+        eraseFromStorage(offset, 1);
         stats_.total_deletes++;
         version_++;
         
@@ -1113,6 +1351,7 @@ void TextBuffer::del() {
 
         line_spans_[caret_.row].length -= 1;
         shiftLineOffsetsFrom(caret_.row + 1, -1);
+        markLinesDirty(caret_.row, caret_.row, 0);
 
         // Record for undo
         if (recordingHistory_) {
@@ -1130,7 +1369,7 @@ void TextBuffer::del() {
     std::size_t newline_offset = span.offset + span.length;
     CaretPosition deletePos = caret_;
 
-    chars_.erase(newline_offset, 1);
+    eraseFromStorage(newline_offset, 1);
     stats_.total_deletes++;
     version_++;
     
@@ -1138,7 +1377,8 @@ void TextBuffer::del() {
     adjustHyperlinkOffsets(newline_offset, -1);
     adjustBookmarkOffsets(newline_offset, -1);
 
-    rebuildLineIndex();
+    collapseLines(deletePos, {caret_.row + 1, 0}, 1);
+    markLinesDirty(caret_.row, caret_.row, -1);
 
     // Record for undo (deleted a newline)
     if (recordingHistory_) {
@@ -1160,7 +1400,7 @@ void TextBuffer::moveLeft() {
 }
 
 void TextBuffer::moveRight() {
-    const LineSpan& span = line_spans_[caret_.row];
+    const LineExtent& span = line_spans_[caret_.row];
     if (caret_.column < span.length) {
         caret_.column += 1;
         return;
@@ -1229,7 +1469,7 @@ void TextBuffer::moveWordRight() {
 
     // Skip current word
     while (caret_.row < totalLines) {
-        const LineSpan& span = line_spans_[caret_.row];
+        const LineExtent& span = line_spans_[caret_.row];
         if (caret_.column >= span.length) {
             // Move to next line
             if (caret_.row + 1 < totalLines) {
@@ -1251,7 +1491,7 @@ void TextBuffer::moveWordRight() {
 
     // Skip whitespace/punctuation
     while (caret_.row < totalLines) {
-        const LineSpan& span = line_spans_[caret_.row];
+        const LineExtent& span = line_spans_[caret_.row];
         if (caret_.column >= span.length) {
             if (caret_.row + 1 < totalLines) {
                 caret_.row++;
@@ -1314,7 +1554,7 @@ void TextBuffer::movePageDown(std::size_t linesPerPage) {
 
 void TextBuffer::ensureNonEmpty() {
     if (line_spans_.empty()) {
-        line_spans_.push_back({0, 0});
+        insertLine(0, {0, 0}, ParagraphFormatTable::DEFAULT_ID);
     }
     clampCaret();
 }
@@ -1424,7 +1664,7 @@ void CommandHistory::redo(TextBuffer& buffer) {
 // ============================================================================
 
 void TextBuffer::undo() {
-    if (!canUndo()) return;
+    if (!canUndo() || readOnly_) return;
     recordingHistory_ = false;
     history_.undo(*this);
     recordingHistory_ = true;
@@ -1432,7 +1672,7 @@ void TextBuffer::undo() {
 }
 
 void TextBuffer::redo() {
-    if (!canRedo()) return;
+    if (!canRedo() || readOnly_) return;
     recordingHistory_ = false;
     history_.redo(*this);
     recordingHistory_ = true;
@@ -1442,27 +1682,28 @@ void TextBuffer::redo() {
 void TextBuffer::insertCharAt(CaretPosition pos, char ch) {
     setCaret(pos);
     std::size_t offset = positionToOffset(pos);
-    chars_.insert(offset, ch);
+    insertIntoStorage(offset, ch);
     version_++;
 
     if (ch == '\n') {
         // Split current line - preserve paragraph styles
         std::size_t splitRow = caret_.row;
-        LineSpan oldSpan = line_spans_[splitRow];
+        LineExtent oldSpan = line_spans_[splitRow];
         
         // Current line ends at caret position
         line_spans_[splitRow].length = caret_.column;
         
         // New line starts after newline character
-        LineSpan newSpan;
+        LineExtent newSpan;
         newSpan.offset = offset + 1;
         newSpan.length = (oldSpan.offset + oldSpan.length) - offset;
-        newSpan.style = ParagraphStyle::Normal;
-        newSpan.alignment = oldSpan.alignment;
+        ParagraphFormat newFormat;
+        newFormat.alignment = formatOf(splitRow).alignment;
         
         // Insert new line span
-        line_spans_.insert(line_spans_.begin() + splitRow + 1, newSpan);
+        insertLine(splitRow + 1, newSpan, formats_.intern(newFormat));
         shiftLineOffsetsFrom(splitRow + 2, 1);
+        markLinesDirty(splitRow, splitRow + 1, 1);
         
         caret_.row += 1;
         caret_.column = 0;
@@ -1470,6 +1711,7 @@ void TextBuffer::insertCharAt(CaretPosition pos, char ch) {
         if (caret_.row < line_spans_.size()) {
             line_spans_[caret_.row].length += 1;
             shiftLineOffsetsFrom(caret_.row + 1, 1);
+            markLinesDirty(caret_.row, caret_.row, 0);
         }
         caret_.column += 1;
     }
@@ -1480,28 +1722,30 @@ void TextBuffer::deleteCharAt(CaretPosition pos) {
     setCaret(pos);
     if (pos.row >= line_spans_.size()) return;
 
-    const LineSpan& span = line_spans_[pos.row];
+    const LineExtent& span = line_spans_[pos.row];
     if (pos.column < span.length) {
         std::size_t offset = positionToOffset(pos);
-        chars_.erase(offset, 1);
+        eraseFromStorage(offset, 1);
         version_++;
         line_spans_[pos.row].length -= 1;
         shiftLineOffsetsFrom(pos.row + 1, -1);
+        markLinesDirty(pos.row, pos.row, 0);
     } else if (pos.row + 1 < line_spans_.size()) {
         // Deleting newline at end of line - merge with next line
         std::size_t offset = span.offset + span.length;
-        chars_.erase(offset, 1);
+        eraseFromStorage(offset, 1);
         version_++;
         
         // Merge next line into current line (keep current line's style)
-        LineSpan& nextSpan = line_spans_[pos.row + 1];
+        LineExtent& nextSpan = line_spans_[pos.row + 1];
         line_spans_[pos.row].length += nextSpan.length;
         
         // Remove the next line span
-        line_spans_.erase(line_spans_.begin() + pos.row + 1);
+        eraseLine(pos.row + 1);
         
         // Shift subsequent lines
         shiftLineOffsetsFrom(pos.row + 1, -1);
+        markLinesDirty(pos.row, pos.row, -1);
     }
 }
 
@@ -1876,7 +2120,7 @@ std::vector<FindResult> TextBuffer::findAll(const std::string& needle, const Fin
 
 bool TextBuffer::replace(const std::string& needle, const std::string& replacement, 
                          const FindOptions& options) {
-    if (!hasSelection() || needle.empty()) return false;
+    if (!hasSelection() || needle.empty() || readOnly_) return false;
     
     // Check if selection matches needle
     std::string selected = getSelectedText();
@@ -1916,7 +2160,7 @@ bool TextBuffer::replace(const std::string& needle, const std::string& replaceme
 
 std::size_t TextBuffer::replaceAll(const std::string& needle, const std::string& replacement,
                                    const FindOptions& options) {
-    if (needle.empty()) return 0;
+    if (needle.empty() || readOnly_) return 0;
     
     std::size_t count = 0;
     
@@ -2007,6 +2251,7 @@ bool TextBuffer::addHyperlinkAt(std::size_t startOffset, std::size_t endOffset,
               });
     
     version_++;
+    anchorsChanged();
     return true;
 }
 
@@ -2017,6 +2262,7 @@ bool TextBuffer::editHyperlink(std::size_t offset, const std::string& newUrl,
             link.url = newUrl;
             link.tooltip = newTooltip;
             version_++;
+            anchorsChanged();
             return true;
         }
     }
@@ -2028,6 +2274,7 @@ bool TextBuffer::removeHyperlink(std::size_t offset) {
         if (it->contains(offset)) {
             hyperlinks_.erase(it);
             version_++;
+            anchorsChanged();
             return true;
         }
     }
@@ -2078,6 +2325,7 @@ std::vector<const Hyperlink*> TextBuffer::hyperlinksInRange(std::size_t startOff
 }
 
 void TextBuffer::adjustHyperlinkOffsets(std::size_t pos, std::ptrdiff_t delta) {
+    if (hyperlinks_.empty()) return;
     for (auto it = hyperlinks_.begin(); it != hyperlinks_.end();) {
         // If deletion removes the entire hyperlink
         if (delta < 0 && pos <= it->startOffset && 
@@ -2117,6 +2365,7 @@ void TextBuffer::adjustHyperlinkOffsets(std::size_t pos, std::ptrdiff_t delta) {
             ++it;
         }
     }
+    anchorsChanged();
 }
 
 // ============================================================================
@@ -2156,6 +2405,7 @@ bool TextBuffer::addBookmarkAt(const std::string& name, std::size_t offset) {
              });
     
     version_++;
+    anchorsChanged();
     return true;
 }
 
@@ -2164,6 +2414,7 @@ bool TextBuffer::removeBookmark(const std::string& name) {
         if (it->name == name) {
             bookmarks_.erase(it);
             version_++;
+            anchorsChanged();
             return true;
         }
     }
@@ -2204,7 +2455,7 @@ std::vector<TextBuffer::OutlineEntry> TextBuffer::getOutline() const {
     std::vector<OutlineEntry> outline;
     
     for (std::size_t i = 0; i < line_spans_.size(); ++i) {
-        ParagraphStyle style = line_spans_[i].style;
+        ParagraphStyle style = formatOf(i).style;
         
         // Only include headings and titles in the outline
         if (style == ParagraphStyle::Normal) {
@@ -2291,6 +2542,7 @@ const Bookmark* TextBuffer::bookmarkNear(std::size_t offset, std::size_t toleran
 }
 
 void TextBuffer::adjustBookmarkOffsets(std::size_t pos, std::ptrdiff_t delta) {
+    if (bookmarks_.empty()) return;
     for (auto it = bookmarks_.begin(); it != bookmarks_.end();) {
         // If deletion removes the bookmark position
         if (delta < 0 && pos <= it->offset && 
@@ -2311,6 +2563,14 @@ void TextBuffer::adjustBookmarkOffsets(std::size_t pos, std::ptrdiff_t delta) {
     
     // Re-sort after adjustments
     std::sort(bookmarks_.begin(), bookmarks_.end());
+    anchorsChanged();
+}
+
+void TextBuffer::restoreAnchors(std::vector<Hyperlink> links, std::vector<Bookmark> bookmarks) {
+    hyperlinks_ = std::move(links);
+    bookmarks_ = std::move(bookmarks);
+    version_++;
+    anchorsChanged();
 }
 
 // ============================================================================
@@ -2351,6 +2611,7 @@ void TextBuffer::insertTableOfContents() {
 static SectionSettings defaultSectionSettings;
 
 void TextBuffer::insertSectionBreak(SectionBreakType type) {
+    if (readOnly_) return;
     // Insert a page break first
     insertPageBreak();
     
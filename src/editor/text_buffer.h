@@ -2,8 +2,11 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "document_settings.h"
@@ -105,10 +108,39 @@ class CommandHistory {
     std::vector<std::unique_ptr<EditCommand>> redoStack_;
 };
 
+struct ParagraphFormat;
+
+// Receives every change to a TextBuffer's characters, document style,
+// paragraph formats and anchors, as byte offsets and rows into the text
+// (e.g. to journal edits for crash recovery)
+class TextEditListener {
+   public:
+    virtual ~TextEditListener() = default;
+    virtual void onInsert(std::size_t offset, std::string_view text) = 0;
+    virtual void onErase(std::size_t offset, std::size_t count) = 0;
+    // The whole text was replaced (setText / setTextFrom)
+    virtual void onReset(const TextBuffer& buffer) = 0;
+    virtual void onStyleChanged(const TextStyle& style) = 0;
+    // A row's paragraph format was set, or a row was inserted with a
+    // non-default one. Rows split off by an inserted newline follow the
+    // row holding it; rows joined by an erase keep the upper row's format.
+    virtual void onLineFormatChanged(std::size_t row, const ParagraphFormat& format) = 0;
+    // Hyperlinks or bookmarks were added, removed, edited or moved by an edit
+    virtual void onAnchorsChanged(const TextBuffer& buffer) = 0;
+};
+
 // TextStyle is now defined in document_settings.h
 
-// Line metadata for SoA layout - stores offset and length instead of copying
-// strings
+// Where a line's text sits in the character buffer. This is all the
+// per-line array holds (16 bytes), so shifting offsets after an edit walks
+// nothing else; paragraph formats live in a ParagraphFormatTable.
+struct LineExtent {
+    std::size_t offset = 0;  // Start offset in the character buffer
+    std::size_t length = 0;  // Length of line (excluding newline)
+};
+
+// A line's extent together with its paragraph format, as returned by
+// TextBuffer::lineSpan. Assembled on request; not how lines are stored.
 struct LineSpan {
     std::size_t offset = 0;  // Start offset in the character buffer
     std::size_t length = 0;  // Length of line (excluding newline)
@@ -137,6 +169,67 @@ struct LineSpan {
     int dropCapLines = 2;  // Number of lines the drop cap spans
 };
 
+// The paragraph fields of a LineSpan, for storing them apart from the text
+// (e.g. sparsely, for the few lines of a LargeDocument that are not default)
+struct ParagraphFormat {
+    ParagraphStyle style = ParagraphStyle::Normal;
+    TextAlignment alignment = TextAlignment::Left;
+    int leftIndent = 0;
+    int firstLineIndent = 0;
+    float lineSpacing = 1.0f;
+    int spaceBefore = 0;
+    int spaceAfter = 0;
+    ListType listType = ListType::None;
+    int listLevel = 0;
+    int listNumber = 1;
+    bool hasPageBreakBefore = false;
+    bool hasDropCap = false;
+    int dropCapLines = 2;
+
+    bool operator==(const ParagraphFormat&) const = default;
+    bool isDefault() const { return *this == ParagraphFormat{}; }
+};
+
+// Each distinct ParagraphFormat stored once; lines refer to it by id.
+// Nearly every line of a document uses DEFAULT_ID, and the rest share a
+// handful of heading / list formats.
+class ParagraphFormatTable {
+   public:
+    using Id = std::uint32_t;
+    static constexpr Id DEFAULT_ID = 0;
+
+    ParagraphFormatTable() { clear(); }
+
+    // Id of format, adding it if it is new
+    Id intern(const ParagraphFormat& format);
+    const ParagraphFormat& operator[](Id id) const { return formats_[id]; }
+    std::size_t size() const { return formats_.size(); }
+
+    // Back to only the default format
+    void clear();
+    // Drop formats no line uses, rewriting lineIds to the new ids
+    void compact(std::vector<Id>& lineIds);
+
+   private:
+    struct Hash {
+        std::size_t operator()(const ParagraphFormat& format) const;
+    };
+
+    std::vector<ParagraphFormat> formats_;
+    std::unordered_map<ParagraphFormat, Id, Hash> ids_;
+};
+
+// Rows touched by edits since the last takeDirtyLines() call.
+// Rows before first are unchanged; rows after last are unchanged but have
+// moved by lineDelta (new row r was old row r - lineDelta).
+struct DirtyLines {
+    bool any = false;   // Something changed since the last take
+    bool all = false;   // Everything must be treated as changed (setText)
+    std::size_t first = 0;
+    std::size_t last = 0;
+    std::ptrdiff_t lineDelta = 0;
+};
+
 // Word count and document statistics
 struct TextStats {
     std::size_t characters = 0;  // Excludes newlines
@@ -170,6 +263,12 @@ class GapBuffer {
     // Get entire buffer as string (for compatibility)
     std::string toString() const;
 
+    // The content as its two contiguous runs, without copying
+    std::string_view beforeGap() const { return {buffer_.data(), gap_start_}; }
+    std::string_view afterGap() const {
+        return {buffer_.data() + gap_end_, buffer_.size() - gap_end_};
+    }
+
     void clear();
 
     // Reserve capacity for bulk loading (avoids reallocations)
@@ -180,6 +279,14 @@ class GapBuffer {
     
     // Bulk load - replaces all content efficiently (for initial file loading)
     void setContent(const char* data, std::size_t len);
+    // Same, dropping every `skip` byte on the way in (still a single copy)
+    void setContentWithout(const char* data, std::size_t len, char skip);
+    // Bulk load by letting write() produce up to maxLen bytes directly in
+    // storage (no staging string). write returns the byte count written, or
+    // npos on failure, which leaves the buffer empty. `skip` bytes are
+    // squeezed out afterwards in place.
+    using ContentWriter = std::function<std::size_t(char* out)>;
+    bool fillContentWithout(std::size_t maxLen, const ContentWriter& write, char skip);
 
     // Performance tracking
     std::size_t gapMoves() const { return gap_moves_; }
@@ -210,6 +317,8 @@ class TextBuffer {
 
     // Get line content as string_view-like access (offset + length)
     LineSpan lineSpan(std::size_t row) const;
+    // Just the offset and length, without copying the paragraph format
+    LineExtent lineExtent(std::size_t row) const;
 
     // Get line content as string (for compatibility - involves copy)
     std::string lineString(std::size_t row) const;
@@ -231,8 +340,29 @@ class TextBuffer {
 
     void insertChar(char ch);
     void insertText(const std::string& text);
-    void setText(const std::string& text);
+    void setText(std::string_view text);
+    // setText for producers that can write straight into the buffer's storage
+    // (e.g. decoding the "text" string of a mapped .wpdoc). write gets room
+    // for maxLength bytes and returns how many it wrote, or npos on failure.
+    // Returns false on failure, leaving the buffer empty.
+    bool setTextFrom(std::size_t maxLength, const GapBuffer::ContentWriter& write);
+    // Append text read after the first screen of a progressive load (see
+    // ProgressiveLoader). newlines are the offsets of every '\n' in text,
+    // found off the UI thread; text has no CRs. Not recorded for undo, and
+    // the caret and selection stay where they are.
+    void appendLoadedText(std::string_view text, const std::vector<std::size_t>& newlines);
+    // Room for a document of this many bytes, so appends do not reallocate
+    void reserveText(std::size_t bytes) { chars_.reserve(bytes); }
+    // Increments when the whole text is replaced (setText / setTextFrom)
+    std::uint64_t loadGeneration() const { return loadGeneration_; }
+    // A read-only buffer ignores every change to its characters (typing,
+    // deleting, replace, undo); setText still loads new text, and
+    // paragraph formatting still applies
+    void setReadOnly(bool readOnly) { readOnly_ = readOnly; }
+    bool readOnly() const { return readOnly_; }
     std::string getText() const;
+    // Visit the text in contiguous chunks (at most two) without copying it
+    void forEachTextChunk(const std::function<void(std::string_view)>& visit) const;
     TextStats stats() const;
     TextStyle textStyle() const;
     void setTextStyle(const TextStyle& style);
@@ -295,6 +425,12 @@ class TextBuffer {
     int lineListLevel(std::size_t row) const;
     int lineListNumber(std::size_t row) const;
     
+    // All paragraph fields of a line at once
+    ParagraphFormat lineFormat(std::size_t row) const;
+    void setLineFormat(std::size_t row, const ParagraphFormat& format);
+    // Distinct paragraph formats in use (or left over), default included
+    std::size_t paragraphFormatCount() const { return formats_.size(); }
+
     // Page break methods
     void insertPageBreak();  // Insert a page break before the current line
     bool hasPageBreakBefore(std::size_t row) const;  // Check if line has page break before it
@@ -395,7 +531,9 @@ class TextBuffer {
     bool hasBookmark(const std::string& name) const;  // Check if bookmark exists
     const Bookmark* bookmarkNear(std::size_t offset, std::size_t tolerance) const;  // Find nearby bookmark
     const std::vector<Bookmark>& bookmarks() const { return bookmarks_; }  // All bookmarks
-    void clearBookmarks() { bookmarks_.clear(); version_++; }  // Remove all bookmarks
+    void clearBookmarks() { bookmarks_.clear(); version_++; anchorsChanged(); }  // Remove all bookmarks
+    // Replace every hyperlink and bookmark at once (e.g. journal recovery)
+    void restoreAnchors(std::vector<Hyperlink> links, std::vector<Bookmark> bookmarks);
     
     // Footnote methods for document footnotes with auto-numbering
     bool addFootnote(const std::string& content);  // Add footnote at current caret, returns footnote number
@@ -439,10 +577,19 @@ class TextBuffer {
     PerfStats perfStats() const;
     void resetPerfStats();
 
+    // Observer for text and style edits (not owned; nullptr to detach)
+    void setEditListener(TextEditListener* listener) { editListener_ = listener; }
+    TextEditListener* editListener() const { return editListener_; }
+
     // Version counter - increments on every modification
     // Used by RenderCache to detect when rebuild is needed
     std::uint64_t version() const { return version_; }
 
+    // Return and reset the range of rows edited since the last call.
+    // Used by background checkers to re-examine only changed paragraphs.
+    DirtyLines takeDirtyLines();
+    const DirtyLines& dirtyLines() const { return dirty_; }
+
     // Undo/Redo support
     bool canUndo() const { return history_.canUndo(); }
     bool canRedo() const { return history_.canRedo(); }
@@ -464,7 +611,8 @@ class TextBuffer {
    private:
     void ensureNonEmpty();
     void clampCaret();
-    void rebuildLineIndex();
+    // Update the line index after erasing `erased` bytes from start to end
+    void collapseLines(CaretPosition start, CaretPosition end, std::size_t erased);
     std::size_t positionToOffset(const CaretPosition& pos) const;
     CaretPosition offsetToPosition(std::size_t offset) const;
     static int comparePositions(const CaretPosition& a, const CaretPosition& b);
@@ -473,7 +621,37 @@ class TextBuffer {
     // Used when inserting/deleting characters to maintain line_spans_
     // consistency
     void shiftLineOffsetsFrom(std::size_t startRow, std::ptrdiff_t delta);
-    
+
+    // Paragraph format of a row (row must exist). Formats are shared, so
+    // changes go through setFormat / editFormat, which intern the result.
+    const ParagraphFormat& formatOf(std::size_t row) const {
+        return formats_[line_formats_[row]];
+    }
+    void setFormat(std::size_t row, const ParagraphFormat& format);
+    template <typename Edit>
+    void editFormat(std::size_t row, Edit edit) {
+        ParagraphFormat format = formatOf(row);
+        edit(format);
+        setFormat(row, format);
+    }
+    // Keep line_spans_ and line_formats_ the same length
+    void insertLine(std::size_t row, LineExtent extent, ParagraphFormatTable::Id format);
+    void eraseLine(std::size_t row);
+    void clearLines();
+    
+    // Record that rows [first, last] (post-edit) changed and that the line
+    // count changed by lineDelta; merges with any pending dirty range
+    void markLinesDirty(std::size_t first, std::size_t last, std::ptrdiff_t lineDelta);
+    void indexLoadedText();
+
+    // Every change to chars_ after loading goes through these so the edit
+    // listener sees it
+    void insertIntoStorage(std::size_t offset, char ch);
+    void eraseFromStorage(std::size_t offset, std::size_t count);
+    void anchorsChanged() {
+        if (editListener_) editListener_->onAnchorsChanged(*this);
+    }
+
     // Renumber lists from a starting row (for numbered lists)
     void renumberListsFrom(std::size_t startRow);
 
@@ -484,7 +662,9 @@ class TextBuffer {
     void adjustBookmarkOffsets(std::size_t pos, std::ptrdiff_t delta);
 
     GapBuffer chars_;                   // Contiguous character storage
-    std::vector<LineSpan> line_spans_;  // SoA line metadata
+    std::vector<LineExtent> line_spans_;  // SoA line metadata (hot: offsets)
+    std::vector<ParagraphFormatTable::Id> line_formats_;  // Cold: one id per line
+    ParagraphFormatTable formats_;
     std::vector<Hyperlink> hyperlinks_; // Hyperlinks in the document
     std::vector<Bookmark> bookmarks_;   // Bookmarks for internal navigation
     std::vector<Footnote> footnotes_;   // Footnotes with auto-numbering
@@ -496,6 +676,14 @@ class TextBuffer {
     TextStyle style_;
     PerfStats stats_;
     std::uint64_t version_ = 0;       // Increments on every modification
+    std::uint64_t loadGeneration_ = 0;
+    bool readOnly_ = false;
+    // stats() for statsVersion_ (appendLoadedText extends it in place)
+    mutable TextStats statsCache_;
+    mutable std::uint64_t statsVersion_ = ~std::uint64_t{0};
+    mutable bool statsEndsInWord_ = false;
+    DirtyLines dirty_{true, true, 0, 0, 0};  // Rows edited since last take
     mutable CommandHistory history_;  // Undo/redo command history
     bool recordingHistory_ = true;    // Whether to record commands for undo
+    TextEditListener* editListener_ = nullptr;
 };
@@ -123,7 +123,7 @@ void RenderCache::rebuild(const TextBuffer &buffer,
     last_visible_row_ = 0;
 
     for (std::size_t row = 0; row < lineCount && y < max_y; ++row) {
-        LineSpan span = buffer.lineSpan(row);
+        LineExtent span = buffer.lineExtent(row);
 
         CachedLine cached;
         cached.source_row = row;
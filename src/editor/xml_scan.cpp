@@ -0,0 +1,207 @@
+#include "xml_scan.h"
+
+#include <cstdint>
+
+namespace xml_scan {
+
+namespace {
+
+bool isSpace(char ch) { return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r'; }
+
+bool isNameEnd(char ch) { return isSpace(ch) || ch == '/' || ch == '>' || ch == '='; }
+
+void appendUtf8(std::uint32_t cp, std::string& out) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// The reference between '&' and ';' (exclusive), appended decoded.
+// False if it is not one we know.
+bool decodeReference(std::string_view name, std::string& out) {
+    if (name == "lt") {
+        out += '<';
+    } else if (name == "gt") {
+        out += '>';
+    } else if (name == "amp") {
+        out += '&';
+    } else if (name == "quot") {
+        out += '"';
+    } else if (name == "apos") {
+        out += '\'';
+    } else if (name.size() > 1 && name[0] == '#') {
+        bool hex = name[1] == 'x' || name[1] == 'X';
+        std::string_view digits = name.substr(hex ? 2 : 1);
+        if (digits.empty() || digits.size() > 8) return false;
+        std::uint32_t cp = 0;
+        for (char ch : digits) {
+            std::uint32_t digit;
+            if (ch >= '0' && ch <= '9') {
+                digit = static_cast<std::uint32_t>(ch - '0');
+            } else if (hex && ch >= 'a' && ch <= 'f') {
+                digit = static_cast<std::uint32_t>(ch - 'a' + 10);
+            } else if (hex && ch >= 'A' && ch <= 'F') {
+                digit = static_cast<std::uint32_t>(ch - 'A' + 10);
+            } else {
+                return false;
+            }
+            cp = cp * (hex ? 16 : 10) + digit;
+        }
+        if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return false;
+        appendUtf8(cp, out);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+std::string_view Attributes::get(std::string_view name) const {
+    for (const auto& [key, value] : items_) {
+        if (key == name) return value;
+    }
+    return {};
+}
+
+bool Attributes::has(std::string_view name) const {
+    for (const auto& item : items_) {
+        if (item.first == name) return true;
+    }
+    return false;
+}
+
+std::string Attributes::text(std::string_view name) const {
+    std::string out;
+    decodeEntities(get(name), out);
+    return out;
+}
+
+void decodeEntities(std::string_view raw, std::string& out) {
+    std::size_t pos = 0;
+    while (pos < raw.size()) {
+        std::size_t amp = raw.find('&', pos);
+        if (amp == std::string_view::npos) {
+            out.append(raw.substr(pos));
+            return;
+        }
+        out.append(raw.substr(pos, amp - pos));
+        std::size_t semi = raw.find(';', amp + 1);
+        if (semi == std::string_view::npos || semi - amp > 12 ||
+            !decodeReference(raw.substr(amp + 1, semi - amp - 1), out)) {
+            out += '&';
+            pos = amp + 1;
+        } else {
+            pos = semi + 1;
+        }
+    }
+}
+
+bool parse(std::string_view xml, Handler& handler, std::string* error) {
+    auto fail = [&](const char* message, std::size_t at) {
+        if (error) *error = std::string(message) + " at byte " + std::to_string(at);
+        return false;
+    };
+    Attributes attributes;
+    std::string decoded;  // Reused for character data with references
+    std::size_t pos = 0;
+
+    while (pos < xml.size()) {
+        std::size_t lt = xml.find('<', pos);
+        std::size_t textEnd = lt == std::string_view::npos ? xml.size() : lt;
+        if (textEnd > pos) {
+            std::string_view text = xml.substr(pos, textEnd - pos);
+            if (text.find('&') == std::string_view::npos) {
+                handler.characters(text);
+            } else {
+                decoded.clear();
+                decodeEntities(text, decoded);
+                handler.characters(decoded);
+            }
+        }
+        if (lt == std::string_view::npos) break;
+        pos = lt + 1;
+        if (pos >= xml.size()) return fail("unexpected end of input", lt);
+
+        std::string_view rest = xml.substr(pos);
+        if (rest.starts_with("!--")) {
+            std::size_t end = xml.find("-->", pos + 3);
+            if (end == std::string_view::npos) return fail("unterminated comment", lt);
+            pos = end + 3;
+        } else if (rest.starts_with("![CDATA[")) {
+            std::size_t end = xml.find("]]>", pos + 8);
+            if (end == std::string_view::npos) return fail("unterminated CDATA", lt);
+            if (end > pos + 8) handler.characters(xml.substr(pos + 8, end - pos - 8));
+            pos = end + 3;
+        } else if (rest[0] == '?' || rest[0] == '!') {
+            std::size_t end = xml.find('>', pos);
+            if (end == std::string_view::npos) return fail("unterminated declaration", lt);
+            pos = end + 1;
+        } else if (rest[0] == '/') {
+            std::size_t end = xml.find('>', pos);
+            if (end == std::string_view::npos) return fail("unterminated end tag", lt);
+            std::string_view name = xml.substr(pos + 1, end - pos - 1);
+            while (!name.empty() && isSpace(name.back())) name.remove_suffix(1);
+            handler.endElement(name);
+            pos = end + 1;
+        } else {
+            std::size_t nameEnd = pos;
+            while (nameEnd < xml.size() && !isNameEnd(xml[nameEnd])) nameEnd++;
+            if (nameEnd == pos) return fail("missing element name", lt);
+            std::string_view name = xml.substr(pos, nameEnd - pos);
+            attributes.items_.clear();
+            pos = nameEnd;
+            bool empty = false;
+            for (;;) {
+                while (pos < xml.size() && isSpace(xml[pos])) pos++;
+                if (pos >= xml.size()) return fail("unterminated start tag", lt);
+                if (xml[pos] == '>') {
+                    pos++;
+                    break;
+                }
+                if (xml[pos] == '/') {
+                    if (pos + 1 >= xml.size() || xml[pos + 1] != '>') {
+                        return fail("stray '/' in start tag", pos);
+                    }
+                    empty = true;
+                    pos += 2;
+                    break;
+                }
+                std::size_t keyEnd = pos;
+                while (keyEnd < xml.size() && !isNameEnd(xml[keyEnd])) keyEnd++;
+                std::string_view key = xml.substr(pos, keyEnd - pos);
+                pos = keyEnd;
+                while (pos < xml.size() && isSpace(xml[pos])) pos++;
+                if (key.empty() || pos >= xml.size() || xml[pos] != '=') {
+                    return fail("malformed attribute", pos);
+                }
+                pos++;
+                while (pos < xml.size() && isSpace(xml[pos])) pos++;
+                if (pos >= xml.size() || (xml[pos] != '"' && xml[pos] != '\'')) {
+                    return fail("unquoted attribute value", pos);
+                }
+                std::size_t close = xml.find(xml[pos], pos + 1);
+                if (close == std::string_view::npos) return fail("unterminated attribute", pos);
+                attributes.items_.emplace_back(key, xml.substr(pos + 1, close - pos - 1));
+                pos = close + 1;
+            }
+            handler.startElement(name, attributes);
+            if (empty) handler.endElement(name);
+        }
+    }
+    return true;
+}
+
+}  // namespace xml_scan
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Minimal forward-only (SAX style) XML scanner, for the parts of zip-based
+// documents we import (word/document.xml, content.xml, ...). Like
+// json_scan it works on a borrowed buffer and builds no tree: the handler
+// sees each start tag, end tag and run of character data as it is passed.
+//
+// Names are reported as written, prefix included ("w:p", "text:h"); the
+// files we read always use their format's usual prefixes. Comments,
+// processing instructions and the DOCTYPE are skipped, CDATA is passed as
+// character data, and nesting is not checked.
+namespace xml_scan {
+
+class Handler;
+
+// An element's attributes, valid only during startElement. Values are raw;
+// text() decodes entity and character references.
+class Attributes {
+   public:
+    // Raw value, or empty if the attribute is absent
+    std::string_view get(std::string_view name) const;
+    bool has(std::string_view name) const;
+    std::string text(std::string_view name) const;
+
+    std::size_t size() const { return items_.size(); }
+    const std::pair<std::string_view, std::string_view>& operator[](std::size_t i) const {
+        return items_[i];
+    }
+
+   private:
+    friend bool parse(std::string_view, Handler&, std::string*);
+    std::vector<std::pair<std::string_view, std::string_view>> items_;
+};
+
+class Handler {
+   public:
+    virtual ~Handler() = default;
+    // An empty element (<a/>) is a startElement followed by an endElement
+    virtual void startElement(std::string_view name, const Attributes& attributes) {
+        (void)name;
+        (void)attributes;
+    }
+    virtual void endElement(std::string_view name) { (void)name; }
+    // Decoded character data; one run may arrive in several pieces
+    virtual void characters(std::string_view text) { (void)text; }
+};
+
+// Scan the whole document. Returns false (with a message in error) on
+// malformed markup; events already delivered stay delivered.
+bool parse(std::string_view xml, Handler& handler, std::string* error = nullptr);
+
+// Append raw with &lt; &gt; &amp; &quot; &apos; and &#N; / &#xN; replaced.
+// Unknown references are copied as they are.
+void decodeEntities(std::string_view raw, std::string& out);
+
+}  // namespace xml_scan
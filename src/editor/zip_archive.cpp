@@ -0,0 +1,142 @@
+#include "zip_archive.h"
+
+#include <algorithm>
+
+#include "flate.h"
+
+namespace {
+
+constexpr std::uint32_t END_OF_DIRECTORY = 0x06054b50;
+constexpr std::uint32_t DIRECTORY_ENTRY = 0x02014b50;
+constexpr std::uint32_t LOCAL_HEADER = 0x04034b50;
+constexpr std::size_t END_OF_DIRECTORY_SIZE = 22;
+constexpr std::uint16_t STORED = 0;
+constexpr std::uint16_t DEFLATED = 8;
+
+std::uint16_t read16(std::string_view data, std::size_t at) {
+    return static_cast<std::uint16_t>(static_cast<unsigned char>(data[at]) |
+                                      (static_cast<unsigned char>(data[at + 1]) << 8));
+}
+
+std::uint32_t read32(std::string_view data, std::size_t at) {
+    return static_cast<std::uint32_t>(read16(data, at)) |
+           (static_cast<std::uint32_t>(read16(data, at + 2)) << 16);
+}
+
+}  // namespace
+
+bool ZipArchive::open(const std::string& path) {
+    close();
+    if (!file_.open(path)) {
+        error_ = file_.error();
+        return false;
+    }
+    std::string_view data = file_.view();
+    auto fail = [&](const char* message) {
+        error_ = std::string(message) + ": " + path;
+        file_.close();
+        entries_.clear();
+        return false;
+    };
+    if (data.size() < END_OF_DIRECTORY_SIZE) return fail("Not a zip file");
+
+    // The end record is last, followed by a comment of up to 64 KB
+    std::size_t lowest = data.size() > END_OF_DIRECTORY_SIZE + 0xFFFF
+                             ? data.size() - END_OF_DIRECTORY_SIZE - 0xFFFF
+                             : 0;
+    std::size_t end = std::string_view::npos;
+    for (std::size_t at = data.size() - END_OF_DIRECTORY_SIZE + 1; at-- > lowest;) {
+        if (read32(data, at) == END_OF_DIRECTORY) {
+            end = at;
+            break;
+        }
+    }
+    if (end == std::string_view::npos) return fail("Not a zip file");
+
+    std::size_t count = read16(data, end + 10);
+    std::size_t at = read32(data, end + 16);
+    if (count == 0xFFFF || at == 0xFFFFFFFF) return fail("Zip64 archives are not supported");
+    entries_.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        if (at + 46 > data.size() || read32(data, at) != DIRECTORY_ENTRY) {
+            return fail("Damaged zip directory");
+        }
+        Entry entry;
+        entry.method = read16(data, at + 10);
+        entry.compressedSize = read32(data, at + 20);
+        entry.size = read32(data, at + 24);
+        std::size_t nameLength = read16(data, at + 28);
+        std::size_t extraLength = read16(data, at + 30);
+        std::size_t commentLength = read16(data, at + 32);
+        entry.localHeader = read32(data, at + 42);
+        if (at + 46 + nameLength > data.size()) return fail("Damaged zip directory");
+        entry.name = std::string(data.substr(at + 46, nameLength));
+        entries_.push_back(std::move(entry));
+        at += 46 + nameLength + extraLength + commentLength;
+    }
+    return true;
+}
+
+void ZipArchive::close() {
+    file_.close();
+    entries_.clear();
+    error_.clear();
+}
+
+std::vector<std::string> ZipArchive::names() const {
+    std::vector<std::string> names;
+    names.reserve(entries_.size());
+    for (const Entry& entry : entries_) names.push_back(entry.name);
+    return names;
+}
+
+const ZipArchive::Entry* ZipArchive::find(std::string_view name) const {
+    // Writers put the main part near the front and archives hold a few
+    // dozen entries, so a linear scan is all this needs
+    auto it = std::find_if(entries_.begin(), entries_.end(),
+                           [&](const Entry& entry) { return entry.name == name; });
+    return it == entries_.end() ? nullptr : &*it;
+}
+
+bool ZipArchive::read(std::string_view name, std::string& out) {
+    out.clear();
+    const Entry* entry = find(name);
+    if (!entry) {
+        error_ = "Missing zip entry: " + std::string(name);
+        return false;
+    }
+    std::string_view data = file_.view();
+    std::size_t at = entry->localHeader;
+    if (at + 30 > data.size() || read32(data, at) != LOCAL_HEADER) {
+        error_ = "Damaged zip entry: " + entry->name;
+        return false;
+    }
+    // The local header's name and extra field may differ in length from
+    // the directory's copy
+    std::size_t begin = at + 30 + read16(data, at + 26) + read16(data, at + 28);
+    if (begin > data.size() || data.size() - begin < entry->compressedSize) {
+        error_ = "Truncated zip entry: " + entry->name;
+        return false;
+    }
+    std::string_view compressed = data.substr(begin, entry->compressedSize);
+
+    bool decoded = false;
+    if (entry->method == STORED) {
+        out.assign(compressed);
+        decoded = true;
+    } else if (entry->method == DEFLATED) {
+        out.reserve(entry->size);
+        // The directory's size bounds the output, so a zip bomb stops
+        // at that size instead of expanding until memory runs out
+        decoded = flate::inflate(compressed, out, entry->size);
+    } else {
+        error_ = "Unsupported compression in zip entry: " + entry->name;
+        return false;
+    }
+    if (!decoded || out.size() != entry->size) {
+        error_ = "Damaged zip entry: " + entry->name;
+        out.clear();
+        return false;
+    }
+    return true;
+}
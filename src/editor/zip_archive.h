@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mapped_file.h"
+
+// Read-only access to the entries of a zip file (the container of .docx
+// and .odt documents). The file is mapped and only its central directory
+// is read up front; an entry is inflated (flate::inflate) when asked for.
+//
+// Stored and deflated entries are supported, which is all office documents
+// use. Zip64, encryption and multi-disk archives are not. CRCs are not
+// checked: a damaged deflate stream nearly always fails to decode or comes
+// out the wrong size, and both are reported.
+class ZipArchive {
+   public:
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return file_.isOpen(); }
+    const std::string& error() const { return error_; }
+
+    bool contains(std::string_view name) const { return find(name) != nullptr; }
+    std::vector<std::string> names() const;
+
+    // Replace out with the entry's contents. False (and error()) if it is
+    // missing or cannot be decoded.
+    bool read(std::string_view name, std::string& out);
+
+   private:
+    struct Entry {
+        std::string name;
+        std::uint16_t method = 0;
+        std::uint32_t compressedSize = 0;
+        std::uint32_t size = 0;
+        std::uint32_t localHeader = 0;
+    };
+    const Entry* find(std::string_view name) const;
+
+    MappedFile file_;
+    std::vector<Entry> entries_;
+    std::string error_;
+};
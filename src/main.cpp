@@ -1,6 +1,9 @@
 #include <argh.h>
 
+#include <charconv>
 #include <chrono>
+#include <cstdio>
+#include <thread>
 #include <filesystem>
 #include <fstream>
 #include <format>
@@ -13,7 +16,12 @@
 #include "ecs/menu_ui_system.h"
 #include "ecs/render_system.h"
 #include "ecs/test_systems.h"
+#include "editor/dictionary.h"
 #include "editor/document_io.h"
+#include "editor/edit_journal.h"
+#include "editor/export/batch_convert.h"
+#include "editor/find_in_files.h"
+#include "editor/spellcheck.h"
 #include "editor/text_buffer.h"
 #include "editor/text_layout.h"
 #include "input/action_map.h"
@@ -74,6 +82,13 @@ int main(int argc, char* argv[]) {
     std::string testScriptPath;
     std::string testScriptDir;  // For batch mode
     float e2eTimeout = 30.0f;  // Default 30 second timeout for E2E tests
+    std::string findInFilesFolder;  // Headless --find-in-files=<folder>
+    std::string findPattern;
+    unsigned int threads = 0;  // --threads=N for the headless worker pools
+    std::string convertFormatName;  // Headless --convert=<pdf|html|rtf>
+    bool convertRequested = false;  // Even with an empty format, which is reported
+    std::string buildDictionaryPath;  // Headless --build-dictionary=<words.txt>
+    std::string outputPath;
     // Parse --screenshot-dir, --frame-limit, --test-script, and --test-script-dir arguments
     // argh uses the params() map for named parameters
     for (auto& [name, value] : cmdl.params()) {
@@ -88,12 +103,41 @@ int main(int argc, char* argv[]) {
             testScriptDir = value;
         } else if (name == "e2e-timeout") {
             e2eTimeout = std::stof(value);
+        } else if (name == "build-dictionary") {
+            buildDictionaryPath = value;
+        } else if (name == "output") {
+            outputPath = value;
+        } else if (name == "find-in-files") {
+            findInFilesFolder = value;
+        } else if (name == "pattern") {
+            findPattern = value;
+        } else if (name == "threads") {
+            const char* end = value.data() + value.size();
+            auto [parsed, ec] = std::from_chars(value.data(), end, threads);
+            if (ec != std::errc() || parsed != end) {
+                LOG_WARNING("--threads: '%s' is not a thread count (0 = one per core)",
+                            value.c_str());
+                return 1;
+            }
+        } else if (name == "convert") {
+            convertFormatName = value;
+            convertRequested = true;
         } else if (name == "e2e-debug") {
             // Value can be "true", "1", or just present
             // This is handled below after scriptRunner is set up
         }
     }
 
+    // Written with a space ("--convert pdf"), these come through as flags
+    // and their value as a positional argument (a file to open or convert);
+    // stop rather than run the wrong mode
+    for (const char* option : {"--convert", "--threads", "--output"}) {
+        if (cmdl[option]) {
+            LOG_WARNING("%s needs a value: %s=<value>", option, option);
+            return 1;
+        }
+    }
+
     // #region agent log
     {
         std::ostringstream data;
@@ -172,6 +216,145 @@ int main(int argc, char* argv[]) {
         return totalMs <= 100.0 ? 0 : 1;
     }
 
+    // Headless dictionary compiler: word list -> memory-mappable .dawg
+    // Usage: --build-dictionary=<words.txt> [--output=<words.dawg>]
+    if (!buildDictionaryPath.empty()) {
+        if (outputPath.empty()) {
+            outputPath = std::filesystem::path(buildDictionaryPath)
+                             .replace_extension(".dawg")
+                             .string();
+        }
+        auto buildStart = std::chrono::high_resolution_clock::now();
+        std::vector<std::string> words = Dictionary::readWordList(
+            buildDictionaryPath,
+            [](const std::string& word) { return SpellChecker::normalizeWord(word); });
+        std::size_t wordCount = words.size();
+        std::string error;
+        if (!Dictionary::buildFile(std::move(words), outputPath, &error)) {
+            LOG_WARNING("build-dictionary failed: %s", error.c_str());
+            return 1;
+        }
+        Dictionary built;
+        if (!built.load(outputPath)) {
+            LOG_WARNING("build-dictionary verify failed: %s", built.error().c_str());
+            return 1;
+        }
+        auto buildMs = std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::high_resolution_clock::now() - buildStart)
+                           .count() /
+                       1000.0;
+        LOG_INFO("dictionary=%s,input_words=%zu,words=%zu,nodes=%zu,edges=%zu,"
+                 "bytes=%zu,build_ms=%.3f",
+                 outputPath.c_str(), wordCount, built.size(), built.nodeCount(),
+                 built.edgeCount(), built.memoryBytes(), buildMs);
+        return 0;
+    }
+
+    // Headless find-in-files: search a folder and print matches as they are
+    // found (path:line:column: preview), followed by a CSV-friendly summary.
+    // Usage: --find-in-files=<folder> --pattern=<text> [--threads=N]
+    //        [--case-sensitive] [--whole-word] [--regex] [--quiet]
+    if (!findInFilesFolder.empty()) {
+        FindInFilesOptions options;
+        options.find.caseSensitive = cmdl["--case-sensitive"];
+        options.find.wholeWord = cmdl["--whole-word"];
+        options.find.useRegex = cmdl["--regex"];
+        options.threadCount = threads;
+        bool quiet = cmdl["--quiet"];
+
+        FindInFiles search;
+        if (!search.start(findInFilesFolder, findPattern, options)) {
+            LOG_WARNING("find-in-files failed: %s", search.error().c_str());
+            return 1;
+        }
+
+        std::vector<FileMatch> batch;
+        auto printBatch = [&]() {
+            batch.clear();
+            search.drainResults(batch);
+            if (quiet) return;
+            for (const auto& match : batch) {
+                std::printf("%s:%zu:%zu: %s\n", match.path.c_str(), match.line + 1,
+                            match.column + 1, match.preview.c_str());
+            }
+        };
+        while (search.isRunning()) {
+            printBatch();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        search.wait();
+        printBatch();
+        std::fflush(stdout);
+
+        FindInFilesStats stats = search.stats();
+        double mbPerSec = stats.elapsedMs > 0.0
+            ? (static_cast<double>(stats.bytesScanned) / (1024.0 * 1024.0)) /
+                  (stats.elapsedMs / 1000.0)
+            : 0.0;
+        LOG_INFO(
+            "folder=%s,pattern=%s,files=%zu,files_matched=%zu,matches=%zu,"
+            "bytes=%zu,search_ms=%.3f,mb_per_s=%.1f",
+            findInFilesFolder.c_str(), findPattern.c_str(), stats.filesTotal,
+            stats.filesWithMatches, stats.matches, stats.bytesScanned,
+            stats.elapsedMs, mbPerSec);
+        return 0;
+    }
+
+    // Headless batch converter: every file, directory (by extension) or glob
+    // given is loaded and exported on a worker pool, printing one line per
+    // file (status, timings, peak RSS) and a CSV-friendly summary. Outputs
+    // go next to their inputs unless --output names a directory.
+    // Usage: --convert=<pdf|html|rtf> [--output=<dir>] [--threads=N]
+    //        [--quiet] <file|dir|glob>...
+    if (convertRequested) {
+        ConvertOptions options;
+        if (!parseConvertFormat(convertFormatName, options.format)) {
+            LOG_WARNING("convert: unknown format '%s' (pdf, html or rtf)",
+                        convertFormatName.c_str());
+            return 1;
+        }
+        options.outputDir = outputPath;
+        options.threadCount = threads;
+        bool quiet = cmdl["--quiet"];
+
+        const auto& positional = cmdl.pos_args();
+        std::vector<std::string> arguments(positional.begin() + 1, positional.end());
+        std::vector<std::string> unmatched;
+        std::vector<ConvertInput> inputs = collectConvertInputs(arguments, options, &unmatched);
+        for (const auto& argument : unmatched) {
+            LOG_WARNING("convert: nothing matches %s", argument.c_str());
+        }
+        if (inputs.empty()) {
+            LOG_WARNING("convert: no input files");
+            return 1;
+        }
+
+        ConvertStats stats = convertFiles(inputs, options, [&](const ConvertResult& converted) {
+            if (converted.result.success) {
+                if (quiet) return;
+                std::printf("ok %s -> %s load_ms=%.3f export_ms=%.3f bytes=%zu peak_rss_kb=%zu\n",
+                            converted.input.c_str(), converted.output.c_str(),
+                            converted.loadMs, converted.exportMs, converted.outputBytes,
+                            converted.peakRssKb);
+            } else {
+                std::printf("FAILED %s: %s\n", converted.input.c_str(),
+                            converted.result.error.c_str());
+            }
+            std::fflush(stdout);
+        });
+
+        double filesPerSec = stats.elapsedMs > 0.0
+            ? static_cast<double>(stats.files) / (stats.elapsedMs / 1000.0)
+            : 0.0;
+        LOG_INFO(
+            "convert=%s,files=%zu,failed=%zu,unmatched=%zu,input_bytes=%zu,"
+            "output_bytes=%zu,convert_ms=%.3f,files_per_s=%.1f,peak_rss_kb=%zu",
+            convertFormatName.c_str(), stats.files, stats.failed, unmatched.size(),
+            stats.inputBytes, stats.outputBytes, stats.elapsedMs, filesPerSec,
+            stats.peakRssKb);
+        return stats.failed == 0 && unmatched.empty() ? 0 : 1;
+    }
+
     {
         SCOPED_TIMER("Settings load");
         Settings::get().load_save_file(800, 600);
@@ -203,14 +386,25 @@ int main(int argc, char* argv[]) {
     // Add document component
     auto& docComp = editorEntity.addComponent<ecs::DocumentComponent>();
     docComp.filePath = loadFile;
+    ecs::installImageCodecs(docComp.images.cache());
     if (testModeEnabled) {
         docComp.autoSaveIntervalSeconds = 0.0;
         docComp.lastAutoSaveTime = -1.0;
     }
 
     // Load file if specified
-    if (!loadFile.empty() && std::filesystem::exists(loadFile)) {
-        auto result = loadTextFileEx(docComp.buffer, loadFile);
+    if (!loadFile.empty() && LargeDocument::wantsFile(loadFile)) {
+        // Too big for the buffer: a read-only window onto the mapped file
+        auto result = ecs::document::openLargeFile(docComp, loadFile);
+        if (!result.success) {
+            LOG_WARNING("Failed to open large file: %s", result.error.c_str());
+        }
+    } else if (!loadFile.empty() && std::filesystem::exists(loadFile)) {
+        // Large files show their first screen before the rest is read;
+        // settings are discarded as loadTextFileEx does
+        DocumentSettings loadedSettings;
+        docComp.loader = std::make_unique<ProgressiveLoader>();
+        auto result = docComp.loader->start(docComp.buffer, loadedSettings, loadFile);
         if (!result.success) {
             LOG_WARNING("Failed to load file: %s", result.error.c_str());
         }
@@ -241,7 +435,43 @@ int main(int argc, char* argv[]) {
     // Auto-save recovery (only when no file is explicitly opened, skip in test mode)
     // Note: Toast notification is deferred until after systems are registered
     bool recoveredAutoSave = false;
+    std::string journalPath = docComp.autoSavePath + ".journal";
+    bool loadCheckpoint = true;
     if (!testModeEnabled && docComp.filePath.empty() &&
+        std::filesystem::exists(journalPath)) {
+        // Last checkpoint (or saved file) plus the edits journaled after it
+        TextBuffer recovered;
+        DocumentSettings recoveredSettings = docComp.docSettings;
+        JournalRecovery recovery = recoverFromJournal(
+            journalPath, docComp.autoSavePath, recovered, recoveredSettings);
+        LOG_INFO("journal recovery base=%s,records=%zu,previous=%s,error=%s",
+                 recovery.basePath.c_str(), recovery.recordsReplayed,
+                 recovery.usedPrevious ? "true" : "false", recovery.error.c_str());
+        loadCheckpoint = !recovery.recovered && !recovery.error.empty();
+        if (recovery.recovered) {
+            docComp.buffer.setText(recovered.getText());
+            docComp.buffer.setTextStyle(recovered.textStyle());
+            for (std::size_t row = 0; row < recovered.lineCount(); ++row) {
+                ParagraphFormat format = recovered.lineFormat(row);
+                if (!format.isDefault()) docComp.buffer.setLineFormat(row, format);
+            }
+            docComp.buffer.restoreAnchors(recovered.hyperlinks(), recovered.bookmarks());
+            docComp.docSettings = recoveredSettings;
+            docComp.isDirty = true;
+            recoveredAutoSave = true;
+        } else if (!recovery.error.empty()) {
+            // Keep the journal for a later look instead of letting
+            // AutoSaveSystem's first rebase delete it, and fall back to the
+            // last checkpoint below. If it cannot be moved, journaling stays
+            // off this session rather than overwrite it.
+            if (!setAsideJournal(journalPath)) {
+                LOG_WARNING("Could not set aside journal %s; autosave disabled",
+                            journalPath.c_str());
+                docComp.autoSaveEnabled = false;
+            }
+        }
+    }
+    if (loadCheckpoint && !testModeEnabled && docComp.filePath.empty() &&
         std::filesystem::exists(docComp.autoSavePath)) {
         auto result = loadDocumentEx(docComp.buffer, docComp.docSettings,
                                      docComp.autoSavePath);
@@ -276,14 +506,24 @@ int main(int argc, char* argv[]) {
         std::make_unique<ecs::CaretBlinkSystem>());
     systemManager.register_update_system(
         std::make_unique<ecs::LayoutUpdateSystem>());
+    systemManager.register_update_system(
+        std::make_unique<ecs::ProgressiveLoadSystem>());
     systemManager.register_update_system(
         std::make_unique<ecs::TextInputSystem>());
     systemManager.register_update_system(
         std::make_unique<ecs::KeyboardShortcutSystem>());
     systemManager.register_update_system(
         std::make_unique<ecs::AutoSaveSystem>());
+    systemManager.register_update_system(
+        std::make_unique<ecs::SaveCompletionSystem>());
+    systemManager.register_update_system(
+        std::make_unique<ecs::ExportCompletionSystem>());
+    systemManager.register_update_system(
+        std::make_unique<ecs::SpellCheckSystem>());
     systemManager.register_update_system(
         std::make_unique<ecs::NavigationSystem>());
+    systemManager.register_update_system(
+        std::make_unique<ecs::LargeFileSystem>());
     
     // Toast notification systems (update and layout)
     ui_imm::registerToastSystems(systemManager);
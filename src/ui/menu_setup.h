@@ -58,7 +58,8 @@ inline std::vector<win95::Menu> createMenuBar(
                       {"Find Previous", "Shift+F3", true, false, nullptr},// 15
                       {"Replace...", "Ctrl+H", true, false, nullptr},     // 16
                       {"", "", false, true, nullptr},                     // 17 Separator
-                      {"Go To Bookmark...", "", true, false, nullptr}};   // 18
+                      {"Go To Bookmark...", "", true, false, nullptr},    // 18
+                      {"Find in Files...", "", true, false, nullptr}};     // 19
     menus.push_back(editMenu);
 
     // View menu
@@ -62,7 +62,8 @@ inline std::vector<MenuData> createMenuBarData() {
                       {"Find Previous", "Shift+F3", true, false},
                       {"Replace...", "Ctrl+H", true, false},
                       {"", "", false, true},  // Separator
-                      {"Go To Bookmark...", "", true, false}};
+                      {"Go To Bookmark...", "", true, false},
+                      {"Find in Files...", "", true, false}};
     menus.push_back(editMenu);
 
     // View menu
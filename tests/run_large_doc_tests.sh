@@ -1,9 +1,10 @@
 #!/bin/bash
-# Run E2E tests on large documents (War and Peace)
+# Run E2E tests on large documents (War and Peace, and a generated 1 GB log)
 # Tests scrolling, navigation, menus, and editing
 
 WORDPROC="./output/wordproc.exe"
 WAR_AND_PEACE="test_files/public_domain/war_and_peace.txt"
+LARGE_LOG="output/large_1gb.log"
 SCREENSHOT_DIR="output/e2e_large_doc"
 
 # Colors
@@ -39,10 +40,11 @@ failed=0
 run_test() {
     local test_name=$1
     local script_path=$2
+    local file=${3:-$WAR_AND_PEACE}
     
     echo -n "  Running $test_name... "
     
-    if $WORDPROC "$WAR_AND_PEACE" --test-mode --test-script="$script_path" --screenshot-dir="$SCREENSHOT_DIR" --e2e-timeout=60 2>&1; then
+    if $WORDPROC "$file" --test-mode --test-script="$script_path" --screenshot-dir="$SCREENSHOT_DIR" --e2e-timeout=60 2>&1; then
         echo -e "${GREEN}PASS${NC}"
         ((passed++))
     else
@@ -57,6 +59,33 @@ run_test "Scroll and Navigation" "tests/e2e_scripts/e2e_large_doc_scroll.e2e"
 # Run menu interactions test
 run_test "Menu Interactions" "tests/e2e_scripts/e2e_large_doc_menus.e2e"
 
+# 1 GB log: opens as a read-only window over the mapped file
+if [ ! -f "$LARGE_LOG" ]; then
+    echo "  Generating $LARGE_LOG..."
+    awk 'BEGIN {
+        for (i = 0; i < 14000000; i++)
+            printf "2024-01-01 12:%02d:%02d INFO worker-%d request %d served in %d ms\n",
+                   (i / 60) % 60, i % 60, i % 16, i, i % 997
+    }' > "$LARGE_LOG"
+fi
+run_test "1 GB Log" "tests/e2e_scripts/e2e_large_log_1gb.e2e" "$LARGE_LOG"
+
+# Memory stays at the index plus one window, not the file size
+if [ -x /usr/bin/time ]; then
+    rss_kb=$(/usr/bin/time -f "%M" $WORDPROC "$LARGE_LOG" --test-mode \
+        --test-script="tests/e2e_scripts/e2e_large_log_1gb.e2e" \
+        --screenshot-dir="$SCREENSHOT_DIR" --e2e-timeout=60 2>&1 >/dev/null | tail -n 1)
+    echo -n "  1 GB Log peak RSS: ${rss_kb} KB... "
+    # Mapped pages count toward RSS while they are read; well under the file
+    if [ "${rss_kb:-0}" -gt 0 ] && [ "$rss_kb" -lt 768000 ]; then
+        echo -e "${GREEN}PASS${NC}"
+        ((passed++))
+    else
+        echo -e "${RED}FAIL${NC}"
+        ((failed++))
+    fi
+fi
+
 echo ""
 echo "=============================================="
 echo "Summary: $passed passed, $failed failed"
@@ -0,0 +1,199 @@
+#include "spellcheck_reference.h"
+
+#include <algorithm>
+#include <cctype>
+#include <string_view>
+#include <utility>
+
+namespace {
+
+std::size_t editDistance(std::string_view a, std::string_view b) {
+    std::vector<std::size_t> row(b.size() + 1);
+    for (std::size_t j = 0; j <= b.size(); ++j) row[j] = j;
+    for (std::size_t i = 1; i <= a.size(); ++i) {
+        std::size_t diagonal = row[0];
+        row[0] = i;
+        for (std::size_t j = 1; j <= b.size(); ++j) {
+            std::size_t above = row[j];
+            row[j] = std::min({row[j] + 1, row[j - 1] + 1,
+                               diagonal + (a[i - 1] == b[j - 1] ? 0 : 1)});
+            diagonal = above;
+        }
+    }
+    return row[b.size()];
+}
+
+void checkDoubleSpaces(const std::string& text, std::vector<GrammarError>& errors) {
+    for (std::size_t i = 0; i + 1 < text.size(); ++i) {
+        if (text[i] == ' ' && text[i + 1] == ' ') {
+            // Count consecutive spaces
+            std::size_t end = i + 2;
+            while (end < text.size() && text[end] == ' ') {
+                ++end;
+            }
+
+            GrammarError error;
+            error.offset = i;
+            error.length = end - i;
+            error.text = text.substr(i, end - i);
+            error.message = "Multiple consecutive spaces";
+            error.suggestion = " ";
+            error.ruleId = "DOUBLE_SPACE";
+            errors.push_back(std::move(error));
+
+            i = end - 1;  // Skip past the spaces
+        }
+    }
+}
+
+void checkCapitalization(const std::string& text, std::vector<GrammarError>& errors) {
+    bool sentenceStart = true;
+
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        char ch = text[i];
+
+        if (ch == '.' || ch == '!' || ch == '?') {
+            sentenceStart = true;
+        } else if (std::isalpha(static_cast<unsigned char>(ch))) {
+            if (sentenceStart) {
+                if (std::islower(static_cast<unsigned char>(ch))) {
+                    // Find word boundary
+                    std::size_t end = i + 1;
+                    while (end < text.size() &&
+                           std::isalpha(static_cast<unsigned char>(text[end]))) {
+                        ++end;
+                    }
+
+                    GrammarError error;
+                    error.offset = i;
+                    error.length = end - i;
+                    error.text = text.substr(i, end - i);
+                    error.message = "Sentence should start with capital letter";
+                    std::string suggestion = error.text;
+                    suggestion[0] = static_cast<char>(
+                        std::toupper(static_cast<unsigned char>(suggestion[0])));
+                    error.suggestion = suggestion;
+                    error.ruleId = "SENTENCE_CAPITALIZATION";
+                    errors.push_back(std::move(error));
+                }
+                sentenceStart = false;
+            }
+        } else if (ch != ' ' && ch != '\n' && ch != '\t') {
+            sentenceStart = false;
+        }
+    }
+}
+
+void checkRepeatedWords(const std::string& text, std::vector<GrammarError>& errors) {
+    auto words = SpellChecker::extractWords(text);
+
+    for (std::size_t i = 1; i < words.size(); ++i) {
+        const auto& prev = words[i - 1];
+        const auto& curr = words[i];
+
+        // Check if same word repeated
+        std::string prevNorm = SpellChecker::normalizeWord(prev.second);
+        std::string currNorm = SpellChecker::normalizeWord(curr.second);
+
+        if (prevNorm == currNorm && !prevNorm.empty()) {
+            GrammarError error;
+            error.offset = prev.first;
+            error.length = curr.first + curr.second.size() - prev.first;
+            error.text = text.substr(error.offset, error.length);
+            error.message = "Repeated word";
+            error.suggestion = prev.second;
+            error.ruleId = "REPEATED_WORD";
+            errors.push_back(std::move(error));
+        }
+    }
+}
+
+void checkCommonErrors(const std::string& text, std::vector<GrammarError>& errors) {
+    std::string textLower;
+    textLower.reserve(text.size());
+    for (char ch : text) {
+        textLower += static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    }
+
+    for (const auto& phrase : commonErrorPhrases()) {
+        std::size_t pos = 0;
+        const std::string& wrongLower = phrase.wrong;
+        while ((pos = textLower.find(wrongLower, pos)) != std::string::npos) {
+            // Check word boundaries
+            bool startOk = (pos == 0 ||
+                            !SpellChecker::isWordChar(text[pos - 1]));
+            bool endOk = (pos + wrongLower.size() >= text.size() ||
+                          !SpellChecker::isWordChar(text[pos + wrongLower.size()]));
+
+            if (startOk && endOk) {
+                GrammarError error;
+                error.offset = pos;
+                error.length = wrongLower.size();
+                error.text = text.substr(pos, wrongLower.size());
+                error.message = phrase.message;
+                error.suggestion = phrase.correct;
+                error.ruleId = "COMMON_ERRORS";
+                errors.push_back(std::move(error));
+            }
+            pos += wrongLower.size();
+        }
+    }
+}
+
+}  // namespace
+
+std::vector<std::string> linearSuggestions(const SpellChecker& checker, const std::string& word,
+                                           std::size_t maxSuggestions) {
+    std::string normalized = SpellChecker::normalizeWord(word);
+    if (normalized.empty() || checker.isCorrect(word)) return {};
+
+    std::vector<std::pair<std::size_t, std::string>> candidates;
+    std::size_t maxDistance = std::min<std::size_t>(3, normalized.size() / 2 + 1);
+
+    auto consider = [&](std::string_view dictWord) {
+        if (dictWord.size() > normalized.size() + maxDistance ||
+            dictWord.size() + maxDistance < normalized.size()) {
+            return true;
+        }
+        std::size_t dist = editDistance(normalized, dictWord);
+        if (dist > 0 && dist <= maxDistance) candidates.emplace_back(dist, std::string(dictWord));
+        return true;
+    };
+    checker.dictionary().forEachWithPrefix("", consider);
+    for (const auto& userWord : checker.userDictionary()) consider(userWord);
+
+    // By distance, then alphabetically; a user word may also be in the
+    // dictionary
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::vector<std::string> result;
+    for (std::size_t i = 0; i < candidates.size() && i < maxSuggestions; ++i) {
+        result.push_back(std::move(candidates[i].second));
+    }
+    return result;
+}
+
+std::vector<GrammarError> multiPassGrammarCheck(const GrammarChecker& checker,
+                                                const std::string& text) {
+    std::vector<GrammarError> errors;
+
+    if (checker.isRuleEnabled("DOUBLE_SPACE")) {
+        checkDoubleSpaces(text, errors);
+    }
+    if (checker.isRuleEnabled("SENTENCE_CAPITALIZATION")) {
+        checkCapitalization(text, errors);
+    }
+    if (checker.isRuleEnabled("REPEATED_WORD")) {
+        checkRepeatedWords(text, errors);
+    }
+    if (checker.isRuleEnabled("COMMON_ERRORS")) {
+        checkCommonErrors(text, errors);
+    }
+
+    // Sort by offset
+    std::sort(errors.begin(), errors.end(),
+              [](const auto& a, const auto& b) { return a.offset < b.offset; });
+
+    return errors;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+// Straightforward reference implementations the spell and grammar checkers'
+// fast paths are tested and benchmarked against. They are not shipped.
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "../src/editor/spellcheck.h"
+
+// Suggestions by brute force: edit distance against every dictionary and
+// user word. Returns the same list as SpellChecker::getSuggestions.
+std::vector<std::string> linearSuggestions(const SpellChecker& checker, const std::string& word,
+                                           std::size_t maxSuggestions = 5);
+
+// Grammar check with one full scan of the text per built-in rule. Reports
+// the same errors as GrammarChecker::checkText, honouring disabled rules.
+std::vector<GrammarError> multiPassGrammarCheck(const GrammarChecker& checker,
+                                                const std::string& text);
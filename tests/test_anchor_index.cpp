@@ -0,0 +1,202 @@
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "../src/editor/drawing.h"
+#include "../src/editor/equation.h"
+#include "../src/editor/image.h"
+#include "catch2/catch.hpp"
+
+namespace {
+
+DocumentImage imageAt(std::size_t line, float height = 20.0f) {
+    DocumentImage image;
+    image.anchorLine = line;
+    image.originalWidth = image.displayWidth = 40.0f;
+    image.originalHeight = image.displayHeight = height;
+    return image;
+}
+
+std::vector<std::size_t> anchorLines(const ImageCollection& images) {
+    std::vector<std::size_t> lines;
+    for (const DocumentImage& image : images.images()) lines.push_back(image.anchorLine);
+    return lines;
+}
+
+}  // namespace
+
+TEST_CASE("Anchored objects stay sorted by line", "[anchor_index]") {
+    ImageCollection images;
+    std::size_t late = images.addImage(imageAt(30));
+    std::size_t early = images.addImage(imageAt(2));
+    std::size_t middle = images.addImage(imageAt(10));
+    std::size_t sameLine = images.addImage(imageAt(10));
+
+    REQUIRE(anchorLines(images) == std::vector<std::size_t>{2, 10, 10, 30});
+    // Insertion order is kept within a line
+    REQUIRE(images.imagesAtLine(10)[0].id == middle);
+    REQUIRE(images.imagesAtLine(10)[1].id == sameLine);
+    REQUIRE(images.imagesInRange(0, 9).size() == 1);
+    REQUIRE(images.imagesInRange(3, 2).empty());
+
+    SECTION("inserting lines moves only the tail") {
+        images.shiftAnchorsFrom(10, 5);
+        REQUIRE(anchorLines(images) == std::vector<std::size_t>{2, 15, 15, 35});
+        REQUIRE(images.getImage(early)->anchorLine == 2);
+    }
+
+    SECTION("deleting lines merges the tail back into order") {
+        // Lines 3..24 removed: 30 becomes 8, and 10 clamps to 0
+        images.shiftAnchorsFrom(5, -22);
+        REQUIRE(anchorLines(images) == std::vector<std::size_t>{0, 0, 2, 8});
+        REQUIRE(images.images()[3].id == late);
+        REQUIRE(images.imagesAtLine(0).size() == 2);
+    }
+}
+
+TEST_CASE("Anchor bounds cull and hit test laid-out rectangles", "[anchor_index]") {
+    ImageCollection images;
+    images.addImage(imageAt(0));
+    std::size_t tall = images.addImage(imageAt(2, 200.0f));  // Rows 40..240 at 20px lines
+    images.addImage(imageAt(50));
+    std::vector<std::size_t> visible;
+
+    SECTION("a tall image anchored above the view is still visible") {
+        images.imagesOverlapping(100.0f, 200.0f, 20.0f, 1.0f, visible);
+        REQUIRE(visible.size() == 1);
+        REQUIRE(images.images()[visible[0]].id == tall);
+    }
+
+    SECTION("the whole document in drawing order") {
+        images.imagesOverlapping(0.0f, 2000.0f, 20.0f, 1.0f, visible);
+        REQUIRE(visible == std::vector<std::size_t>{0, 1, 2});
+    }
+
+    SECTION("zoom and line height change the layout") {
+        images.imagesOverlapping(100.0f, 200.0f, 20.0f, 0.25f, visible);
+        REQUIRE(visible.empty());  // The tall image is now 50 high: rows 40..90
+        images.imagesOverlapping(1000.0f, 1010.0f, 20.0f, 1.0f, visible);
+        REQUIRE(visible.size() == 1);  // Line 50 starts at 1000
+    }
+
+    SECTION("hit testing") {
+        REQUIRE(images.imageAt(10.0f, 100.0f, 20.0f, 1.0f)->id == tall);
+        REQUIRE(images.imageAt(50.0f, 100.0f, 20.0f, 1.0f) == nullptr);  // Right of it
+        REQUIRE(images.imageAt(10.0f, 300.0f, 20.0f, 1.0f) == nullptr);
+    }
+
+    SECTION("the index follows edits") {
+        images.shiftAnchorsFrom(1, 10);
+        REQUIRE(images.imageAt(10.0f, 100.0f, 20.0f, 1.0f) == nullptr);
+        REQUIRE(images.imageAt(10.0f, 300.0f, 20.0f, 1.0f)->id == tall);
+        REQUIRE(images.editImage(tall, [](DocumentImage& image) { image.displayWidth = 80.0f; }));
+        REQUIRE(images.imageAt(50.0f, 300.0f, 20.0f, 1.0f)->id == tall);
+        images.removeImage(tall);
+        REQUIRE(images.imageAt(10.0f, 300.0f, 20.0f, 1.0f) == nullptr);
+        REQUIRE_FALSE(images.editImage(tall, [](DocumentImage&) {}));
+    }
+}
+
+TEST_CASE("Anchored objects draw in the order they were added", "[anchor_index]") {
+    ImageCollection images;
+    std::size_t below = images.addImage(imageAt(3, 100.0f));  // Rows 60..160
+    std::size_t above = images.addImage(imageAt(1, 100.0f));  // Rows 20..120, added later
+    std::vector<std::size_t> visible;
+
+    auto drawn = [&] {
+        images.imagesOverlapping(0.0f, 1000.0f, 20.0f, 1.0f, visible);
+        std::vector<std::size_t> ids;
+        for (std::size_t index : visible) ids.push_back(images.images()[index].id);
+        return ids;
+    };
+    REQUIRE(images.images()[0].id == above);  // Sorted by line for lookup only
+    REQUIRE(drawn() == std::vector<std::size_t>{below, above});
+    REQUIRE(images.imageAt(10.0f, 100.0f, 20.0f, 1.0f)->id == above);
+
+    // Moving text past one anchor reorders the vector, not the stacking
+    images.shiftAnchorsFrom(2, -3);  // Clamps it to line 0
+    REQUIRE(images.images()[0].id == below);
+    REQUIRE(drawn() == std::vector<std::size_t>{below, above});
+    REQUIRE(images.imageAt(10.0f, 60.0f, 20.0f, 1.0f)->id == above);
+}
+
+TEST_CASE("Drawings and equations use the anchor index", "[anchor_index]") {
+    DrawingCollection drawings;
+    DocumentDrawing line;
+    line.anchorLine = 4;
+    line.x = 100.0f;
+    line.y = 30.0f;
+    line.width = -50.0f;  // Drawn right to left and upwards
+    line.height = -20.0f;
+    std::size_t id = drawings.addDrawing(line);
+    DocumentDrawing box;
+    box.anchorLine = 1;
+    drawings.addDrawing(box);
+
+    REQUIRE(drawings.drawings()[0].anchorLine == 1);
+    REQUIRE(drawings.drawingAt(75.0f, 4 * 10.0f + 25.0f, 10.0f, 1.0f)->id == id);
+    REQUIRE(drawings.drawingAt(75.0f, 4 * 10.0f + 15.0f, 10.0f, 1.0f)->id != id);  // Box on top
+    REQUIRE(drawings.drawingAt(110.0f, 4 * 10.0f + 25.0f, 10.0f, 1.0f) == nullptr);
+    std::vector<std::size_t> visible;
+    drawings.drawingsOverlapping(55.0f, 60.0f, 10.0f, 1.0f, visible);
+    REQUIRE(visible == std::vector<std::size_t>{1, 0});  // The line was added first
+
+    EquationCollection equations;
+    DocumentEquation eq;
+    eq.anchorLine = 9;
+    equations.addEquation(eq);
+    eq.anchorLine = 3;
+    equations.addEquation(eq);
+    REQUIRE(equations.equations()[0].anchorLine == 3);
+    REQUIRE(equations.equationsInRange(0, 5).size() == 1);
+    equations.shiftAnchorsFrom(4, -4);
+    REQUIRE(equations.equationsAtLine(5).size() == 1);
+    REQUIRE(equations.equationsAtLine(3).size() == 1);
+}
+
+TEST_CASE("Anchor index benchmark", "[anchor_index][benchmark]") {
+    // 20k images of mixed heights on a 100k-line document, one every five
+    // lines, added in document order as a loader does
+    ImageCollection images;
+    for (std::size_t i = 0; i < 20000; ++i) {
+        images.addImage(imageAt(i * 5, 30.0f + static_cast<float>(i % 5) * 40.0f));
+    }
+    std::vector<std::size_t> visible;
+    images.imagesOverlapping(0.0f, 1.0f, 16.0f, 1.0f, visible);  // Build the index
+
+    // Scrolling: one culling query per frame
+    auto start = std::chrono::high_resolution_clock::now();
+    std::size_t drawn = 0;
+    for (std::size_t frame = 0; frame < 10000; ++frame) {
+        float top = static_cast<float>(frame * 160);
+        images.imagesOverlapping(top, top + 800.0f, 16.0f, 1.0f, visible);
+        drawn += visible.size();
+    }
+    auto scrolled = std::chrono::high_resolution_clock::now();
+
+    // Mouse moves: one hit test each
+    std::size_t hits = 0;
+    for (std::size_t i = 0; i < 10000; ++i) {
+        float y = static_cast<float>(i * 160 + 8);
+        if (images.imageAt(20.0f, y, 16.0f, 1.0f)) ++hits;
+    }
+    auto hitTested = std::chrono::high_resolution_clock::now();
+
+    // Typing Enter near the end of the document
+    for (std::size_t i = 0; i < 1000; ++i) images.shiftAnchorsFrom(99000, 1);
+    auto shifted = std::chrono::high_resolution_clock::now();
+
+    REQUIRE(drawn > 0);
+    REQUIRE(hits > 0);
+    REQUIRE(images.imagesAtLine(99995 + 1000).size() == 1);
+
+    auto ms = [](auto a, auto b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+    std::printf("\n=== Anchor Index Benchmark ===\n");
+    std::printf("  20000 images, 10000 culling queries: %.2f ms (%zu drawn)\n",
+                ms(start, scrolled), drawn);
+    std::printf("  10000 hit tests: %.2f ms\n", ms(scrolled, hitTested));
+    std::printf("  1000 line inserts near the end: %.2f ms\n", ms(hitTested, shifted));
+    REQUIRE(ms(start, scrolled) < 1000.0);
+}
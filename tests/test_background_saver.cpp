@@ -0,0 +1,159 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include "../src/editor/background_saver.h"
+#include "../src/editor/document_io.h"
+#include "catch2/catch.hpp"
+#include "test_helpers.h"
+
+namespace {
+std::string loadedText(const std::string& path) {
+    TextBuffer buffer;
+    loadTextFile(buffer, path);
+    return buffer.getText();
+}
+}  // namespace
+
+TEST_CASE("BackgroundSaver writes snapshots off the calling thread", "[background_saver]") {
+    TempDirGuard guard("wordproc_save_test");
+    std::string path = (guard.dir / "doc.wpdoc").string();
+
+    TextBuffer buffer;
+    buffer.setText("Saved in the background");
+    DocumentSettings settings;
+    settings.textStyle.italic = true;
+
+    BackgroundSaver saver;
+    saver.requestSave(buffer, settings, path, SaveKind::Manual);
+
+    // Edits after the request do not leak into the snapshot
+    std::uint64_t snapshotVersion = buffer.version();
+    buffer.insertText(" (edited)");
+    saver.waitIdle();
+
+    auto outcomes = saver.takeCompleted();
+    REQUIRE(outcomes.size() == 1);
+    REQUIRE(outcomes[0].result.success);
+    REQUIRE(outcomes[0].path == path);
+    REQUIRE(outcomes[0].kind == SaveKind::Manual);
+    REQUIRE(outcomes[0].bufferVersion == snapshotVersion);
+    REQUIRE(outcomes[0].latencyMs >= outcomes[0].writeMs);
+    REQUIRE(loadedText(path) == "Saved in the background");
+
+    TextBuffer loaded;
+    DocumentSettings loadedSettings;
+    REQUIRE(loadDocumentEx(loaded, loadedSettings, path).success);
+    REQUIRE(loadedSettings.textStyle.italic);
+
+    REQUIRE(saver.takeCompleted().empty());
+    REQUIRE(saver.queueDepth() == 0);
+    REQUIRE_FALSE(saver.isSaving(path));
+    REQUIRE(saver.stats().completed == 1);
+}
+
+TEST_CASE("BackgroundSaver coalesces queued saves of the same path", "[background_saver]") {
+    TempDirGuard guard("wordproc_save_test");
+    std::string path = (guard.dir / "busy.wpdoc").string();
+
+    std::string text;
+    for (int i = 0; i < 20000; ++i) {
+        text += "Line " + std::to_string(i) + " of a document that takes a moment to save\n";
+    }
+    TextBuffer buffer;
+    buffer.setText(text);
+
+    BackgroundSaver saver;
+    const int requests = 20;
+    for (int i = 0; i < requests; ++i) {
+        buffer.insertChar('x');
+        saver.requestSave(buffer, DocumentSettings{}, path,
+                          i == 1 ? SaveKind::Manual : SaveKind::AutoSave);
+    }
+    saver.waitIdle();
+
+    auto outcomes = saver.takeCompleted();
+    BackgroundSaverStats stats = saver.stats();
+    REQUIRE(stats.requested == requests);
+    REQUIRE(outcomes.size() + stats.coalesced == requests);
+    REQUIRE(stats.coalesced > 0);  // Requests arrive faster than the writes
+
+    // The last write holds the newest snapshot, and the manual request
+    // folded into a queued autosave still reports as manual
+    REQUIRE(outcomes.back().bufferVersion == buffer.version());
+    REQUIRE(loadedText(path) == buffer.getText());
+    bool sawManual = false;
+    for (const auto& outcome : outcomes) sawManual |= outcome.kind == SaveKind::Manual;
+    REQUIRE(sawManual);
+}
+
+TEST_CASE("BackgroundSaver reports failures and drains on destruction", "[background_saver]") {
+    TempDirGuard guard("wordproc_save_test");
+
+    SECTION("failed writes come back with an error") {
+        std::string blocker = (guard.dir / "not_a_dir").string();
+        { std::ofstream(blocker) << "file"; }
+
+        TextBuffer buffer;
+        buffer.setText("nowhere to go");
+        BackgroundSaver saver;
+        saver.requestSave(buffer, DocumentSettings{}, blocker + "/doc.wpdoc", SaveKind::AutoSave);
+        saver.waitIdle();
+
+        auto outcomes = saver.takeCompleted();
+        REQUIRE(outcomes.size() == 1);
+        REQUIRE_FALSE(outcomes[0].result.success);
+        REQUIRE_FALSE(outcomes[0].result.error.empty());
+        REQUIRE(saver.stats().failed == 1);
+    }
+
+    SECTION("queued saves are written before the saver goes away") {
+        TextBuffer buffer;
+        std::vector<std::string> paths;
+        {
+            BackgroundSaver saver;
+            for (int i = 0; i < 5; ++i) {
+                paths.push_back((guard.dir / ("doc" + std::to_string(i) + ".wpdoc")).string());
+                buffer.setText("document " + std::to_string(i));
+                saver.requestSave(buffer, DocumentSettings{}, paths.back(), SaveKind::Manual);
+            }
+        }
+        for (int i = 0; i < 5; ++i) {
+            REQUIRE(loadedText(paths[static_cast<std::size_t>(i)]) ==
+                    "document " + std::to_string(i));
+        }
+    }
+}
+
+TEST_CASE("BackgroundSaver benchmark - UI thread cost", "[background_saver][benchmark]") {
+    TextBuffer buffer;
+    if (!loadTextFile(buffer, "test_files/public_domain/war_and_peace.txt")) {
+        WARN("Skipping: war_and_peace.txt not found");
+        return;
+    }
+    TempDirGuard guard("wordproc_save_test");
+    std::string path = (guard.dir / "war_and_peace.wpdoc").string();
+
+    auto syncStart = std::chrono::high_resolution_clock::now();
+    REQUIRE(saveDocumentEx(buffer, DocumentSettings{}, path).success);
+    auto syncEnd = std::chrono::high_resolution_clock::now();
+
+    BackgroundSaver saver;
+    auto asyncStart = std::chrono::high_resolution_clock::now();
+    saver.requestSave(buffer, DocumentSettings{}, path, SaveKind::AutoSave);
+    auto asyncEnd = std::chrono::high_resolution_clock::now();
+    saver.waitIdle();
+    auto outcomes = saver.takeCompleted();
+    REQUIRE(outcomes.size() == 1);
+    REQUIRE(outcomes[0].result.success);
+
+    auto ms = [](auto start, auto end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+    std::printf("\n=== Background Save Benchmark ===\n");
+    std::printf("  Synchronous save (frame blocked): %.2f ms\n", ms(syncStart, syncEnd));
+    std::printf("  requestSave (frame blocked): %.2f ms\n", ms(asyncStart, asyncEnd));
+    std::printf("  Worker write: %.2f ms, latency: %.2f ms\n", outcomes[0].writeMs,
+                outcomes[0].latencyMs);
+}
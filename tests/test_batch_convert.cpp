@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/editor/export/batch_convert.h"
+#include "catch2/catch.hpp"
+#include "test_helpers.h"
+
+namespace {
+std::vector<std::string> relatives(const std::vector<ConvertInput>& inputs) {
+    std::vector<std::string> names;
+    for (const auto& input : inputs) names.push_back(input.relative);
+    return names;
+}
+}  // namespace
+
+TEST_CASE("globMatch handles *, ? and **", "[batch_convert]") {
+    REQUIRE(globMatch("*.wpdoc", "a.wpdoc"));
+    REQUIRE_FALSE(globMatch("*.wpdoc", "a.txt"));
+    REQUIRE_FALSE(globMatch("*.wpdoc", "dir/a.wpdoc"));
+    REQUIRE(globMatch("dir/?.txt", "dir/a.txt"));
+    REQUIRE_FALSE(globMatch("dir/?.txt", "dir/ab.txt"));
+    REQUIRE_FALSE(globMatch("dir?a.txt", "dir/a.txt"));
+    REQUIRE(globMatch("docs/**/*.wpdoc", "docs/a.wpdoc"));
+    REQUIRE(globMatch("docs/**/*.wpdoc", "docs/2024/01/a.wpdoc"));
+    REQUIRE_FALSE(globMatch("docs/**/*.wpdoc", "other/a.wpdoc"));
+    REQUIRE(globMatch("**", "any/depth/file"));
+    REQUIRE(globMatch("a*b*c", "aXXbYYc"));
+    REQUIRE_FALSE(globMatch("a*b*c", "aXXbYY"));
+}
+
+TEST_CASE("collectConvertInputs expands files, directories and globs", "[batch_convert]") {
+    TempDirGuard guard("wordproc_convert_test");
+    guard.write("a.wpdoc", "{}");
+    guard.write("b.txt", "b");
+    guard.write("skip.png", "x");
+    guard.write("sub/c.md", "c");
+    guard.write("sub/deeper/d.txt", "d");
+    ConvertOptions options;
+
+    SECTION("a directory picks up known extensions recursively") {
+        auto inputs = collectConvertInputs({guard.dir.string()}, options);
+        REQUIRE(relatives(inputs) ==
+                std::vector<std::string>{"a.wpdoc", "b.txt", "sub/c.md", "sub/deeper/d.txt"});
+        options.recursive = false;
+        inputs = collectConvertInputs({guard.dir.string()}, options);
+        REQUIRE(relatives(inputs) == std::vector<std::string>{"a.wpdoc", "b.txt"});
+    }
+
+    SECTION("globs, explicit files and duplicates") {
+        std::vector<std::string> unmatched;
+        auto inputs = collectConvertInputs(
+            {guard.path("**/*.txt"), guard.path("b.txt"), guard.path("skip.png"),
+             guard.path("*.none"), guard.path("missing.wpdoc")},
+            options, &unmatched);
+        // skip.png is used because it was named outright
+        REQUIRE(relatives(inputs) ==
+                std::vector<std::string>{"b.txt", "skip.png", "sub/deeper/d.txt"});
+        REQUIRE(unmatched == std::vector<std::string>{guard.path("*.none"),
+                                                      guard.path("missing.wpdoc")});
+    }
+}
+
+TEST_CASE("convertFiles converts on a worker pool", "[batch_convert]") {
+    TempDirGuard guard("wordproc_convert_test");
+    for (int i = 0; i < 6; ++i) {
+        guard.write("in/doc" + std::to_string(i) + ".txt",
+                    "Document " + std::to_string(i) + "\nSecond <line> & more\n");
+    }
+    guard.write("in/nested/notes.md", "Notes");
+    ConvertOptions options;
+    options.format = ConvertFormat::Html;
+    options.threadCount = 2;
+    options.outputDir = guard.path("out");
+
+    auto inputs = collectConvertInputs({guard.path("in")}, options);
+    REQUIRE(inputs.size() == 7);
+    std::vector<std::string> reported;
+    ConvertStats stats = convertFiles(inputs, options, [&](const ConvertResult& converted) {
+        REQUIRE(converted.result.success);
+        REQUIRE(converted.outputBytes > 0);
+        REQUIRE(converted.peakRssKb > 0);
+        reported.push_back(converted.input);
+    });
+    REQUIRE(stats.files == 7);
+    REQUIRE(stats.failed == 0);
+    REQUIRE(reported.size() == 7);
+    REQUIRE(stats.peakRssKb > 0);
+
+    // Outputs mirror the layout below the input directory
+    REQUIRE(readBytes(guard.path("out/doc3.html")).find("Second &lt;line&gt; &amp; more") !=
+            std::string::npos);
+    REQUIRE(std::filesystem::exists(guard.path("out/nested/notes.html")));
+
+    SECTION("without an output directory files are written alongside") {
+        options.format = ConvertFormat::Rtf;
+        options.outputDir.clear();
+        stats = convertFiles({{guard.path("in/doc0.txt"), "doc0.txt"}}, options);
+        REQUIRE(stats.failed == 0);
+        REQUIRE(readBytes(guard.path("in/doc0.rtf")).rfind("{\\rtf1", 0) == 0);
+    }
+
+    SECTION("failures are reported and counted") {
+        std::vector<ConvertResult> results;
+        stats = convertFiles({{guard.path("in/broken.wpdoc"), "broken.wpdoc"},
+                              {guard.path("in/doc1.txt"), "doc1.txt"}},
+                             options, [&](const ConvertResult& converted) {
+                                 results.push_back(converted);
+                             });
+        REQUIRE(stats.files == 2);
+        REQUIRE(stats.failed == 1);
+        auto broken = std::find_if(results.begin(), results.end(), [](const ConvertResult& r) {
+            return r.input.find("broken") != std::string::npos;
+        });
+        REQUIRE(broken != results.end());
+        REQUIRE_FALSE(broken->result.success);
+        REQUIRE_FALSE(broken->result.error.empty());
+    }
+}
+
+TEST_CASE("parseConvertFormat accepts pdf, html and rtf", "[batch_convert]") {
+    ConvertFormat format = ConvertFormat::Pdf;
+    REQUIRE(parseConvertFormat("HTML", format));
+    REQUIRE(format == ConvertFormat::Html);
+    REQUIRE(std::string(convertFormatExtension(format)) == ".html");
+    REQUIRE(parseConvertFormat("rtf", format));
+    REQUIRE(format == ConvertFormat::Rtf);
+    REQUIRE_FALSE(parseConvertFormat("docx", format));
+    REQUIRE(format == ConvertFormat::Rtf);
+}
@@ -0,0 +1,296 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/editor/binary_document.h"
+#include "../src/editor/document_io.h"
+#include "../src/editor/lz_block.h"
+#include "catch2/catch.hpp"
+#include "test_helpers.h"
+
+namespace {
+std::string roundTrip(const std::string& input) {
+    std::string packed = lz_block::compress(input);
+    std::string unpacked(input.size(), '\0');
+    REQUIRE(lz_block::decompress(packed, unpacked.data(), unpacked.size()));
+    return unpacked;
+}
+
+// Overwrite a little-endian field of the .wpdb table of contents entry at
+// index and reseal the table's checksum, so only the field is wrong
+void patchSectionEntry(std::string& bytes, std::size_t index, std::size_t field,
+                       std::uint64_t value) {
+    auto getFixed = [&](std::size_t at, int width) {
+        std::uint64_t result = 0;
+        for (int i = 0; i < width; ++i) {
+            result |= static_cast<std::uint64_t>(static_cast<unsigned char>(bytes[at + i])) << (8 * i);
+        }
+        return result;
+    };
+    auto putFixed = [&](std::size_t at, std::uint64_t v, int width) {
+        for (int i = 0; i < width; ++i) bytes[at + i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+    };
+    std::size_t trailer = bytes.size() - 16;
+    std::size_t tocOffset = getFixed(trailer, 8);
+    putFixed(tocOffset + index * 48 + field, value, 8);
+
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = tocOffset; i < trailer; ++i) {
+        hash ^= static_cast<unsigned char>(bytes[i]);
+        hash *= 16777619u;
+    }
+    putFixed(trailer + 12, hash, 4);
+}
+}  // namespace
+
+TEST_CASE("lz_block round-trips and rejects damaged input", "[binary_document]") {
+    REQUIRE(roundTrip("").empty());
+    REQUIRE(roundTrip("abc") == "abc");
+
+    std::string repetitive;
+    for (int i = 0; i < 5000; ++i) repetitive += "the quick brown fox " + std::to_string(i % 7);
+    REQUIRE(roundTrip(repetitive) == repetitive);
+    REQUIRE(lz_block::compress(repetitive).size() < repetitive.size() / 4);
+
+    // Runs longer than their offset (overlapping copies) and long literals
+    std::string runs(100000, 'a');
+    runs += std::string(300, 'b');
+    REQUIRE(roundTrip(runs) == runs);
+
+    std::mt19937 rng(7);
+    std::string noise(70000, '\0');
+    for (char& ch : noise) ch = static_cast<char>(rng());
+    REQUIRE(roundTrip(noise) == noise);
+
+    std::string packed = lz_block::compress(repetitive);
+    std::string out(repetitive.size(), '\0');
+    REQUIRE_FALSE(lz_block::decompress(packed, out.data(), out.size() - 1));
+    for (std::size_t cut = 0; cut < packed.size(); cut += 97) {
+        REQUIRE_FALSE(lz_block::decompress(std::string_view(packed).substr(0, cut), out.data(),
+                                           out.size()));
+    }
+}
+
+TEST_CASE(".wpdb round-trips losslessly with .wpdoc", "[binary_document]") {
+    TempDirGuard guard("wordproc_wpdb_test");
+    std::string wpdoc = (guard.dir / "doc.wpdoc").string();
+    std::string wpdb = (guard.dir / "doc.wpdb").string();
+    std::string again = (guard.dir / "again.wpdoc").string();
+
+    TextBuffer buffer;
+    std::string text;
+    for (int i = 0; i < 3000; ++i) {
+        text += "Paragraph " + std::to_string(i) + " with \"quotes\", tabs\tand \xC3\xA9\n";
+    }
+    text += "last line without newline";
+    buffer.setText(text);
+
+    DocumentSettings settings;
+    settings.textStyle.italic = true;
+    settings.textStyle.fontSize = 21;
+    settings.textStyle.textColor = {10, 20, 30, 255};
+    settings.pageSettings.mode = PageMode::Paged;
+    settings.pageSettings.pageMargin = 33.5f;
+    settings.tabWidth = 2;
+    TableList tables;
+    Table table(2, 3);
+    table.cell(1, 2).content = "corner";
+    tables.emplace_back(5, table);
+    tables.emplace_back(900, Table(1, 1));
+    REQUIRE(saveDocumentWithTables(buffer, settings, tables, wpdoc).success);
+
+    // .wpdoc -> .wpdb -> .wpdoc
+    TextBuffer loaded;
+    DocumentSettings loadedSettings;
+    TableList loadedTables;
+    REQUIRE(loadDocumentWithTables(loaded, loadedSettings, loadedTables, wpdoc).success);
+    REQUIRE(saveDocumentWithTables(loaded, loadedSettings, loadedTables, wpdb).success);
+    REQUIRE(BinaryDocumentReader::hasMagic(readBytes(wpdb)));
+    REQUIRE(std::filesystem::file_size(wpdb) < std::filesystem::file_size(wpdoc));
+
+    TextBuffer binary;
+    DocumentSettings binarySettings;
+    TableList binaryTables;
+    DocumentResult result = loadDocumentWithTables(binary, binarySettings, binaryTables, wpdb);
+    REQUIRE(result.success);
+    REQUIRE_FALSE(result.usedFallback);
+    REQUIRE(binary.getText() == text);
+    REQUIRE(binary.textStyle().italic);
+    REQUIRE(binaryTables.size() == 2);
+    REQUIRE(binaryTables[0].second.cell(1, 2).content == "corner");
+
+    REQUIRE(saveDocumentWithTables(binary, binarySettings, binaryTables, again).success);
+    REQUIRE(readBytes(again) == readBytes(wpdoc));
+
+    SECTION("uncompressed containers read the same") {
+        BinaryDocumentWriter writer;
+        REQUIRE(writer.open(wpdb));
+        writer.setCompression(false);
+        writer.addText({std::string_view(text)});
+        REQUIRE(writer.commit());
+        TextBuffer raw;
+        DocumentSettings rawSettings;
+        REQUIRE(loadDocumentEx(raw, rawSettings, wpdb).success);
+        REQUIRE(raw.getText() == text);
+    }
+}
+
+TEST_CASE(".wpdb reads the visible lines without decoding the rest", "[binary_document]") {
+    TempDirGuard guard("wordproc_wpdb_test");
+    std::string path = (guard.dir / "lines.wpdb").string();
+
+    TextBuffer buffer;
+    std::string text;
+    for (int i = 0; i < 20000; ++i) text += "line " + std::to_string(i) + " of the document\n";
+    buffer.setText(text);
+    REQUIRE(saveDocumentEx(buffer, DocumentSettings{}, path).success);
+
+    BinaryDocumentReader reader;
+    REQUIRE(reader.open(path));
+    REQUIRE(reader.sectionsDecoded() == 0);
+    REQUIRE(reader.lineCount() == buffer.lineCount());
+    REQUIRE(reader.textSize() == text.size());
+
+    std::string lines;
+    REQUIRE(reader.readLines(12000, 3, lines));
+    REQUIRE(lines == "line 12000 of the document\nline 12001 of the document\n"
+                     "line 12002 of the document");
+    REQUIRE(reader.sectionsDecoded() <= 2);
+
+    REQUIRE(reader.readLines(buffer.lineCount() - 2, 10, lines));
+    REQUIRE(lines == "line 19999 of the document\n");
+
+    std::vector<std::size_t> lengths;
+    REQUIRE(reader.readLineLengths(lengths));
+    REQUIRE(lengths.size() == buffer.lineCount());
+    for (std::size_t row = 0; row < lengths.size(); row += 997) {
+        REQUIRE(lengths[row] == buffer.lineSpan(row).length);
+    }
+
+    DocumentSettings settings;
+    REQUIRE(loadBinaryDocumentSettings(reader, settings).success);
+
+    SECTION("empty document") {
+        TextBuffer empty;
+        REQUIRE(saveDocumentEx(empty, DocumentSettings{}, path).success);
+        REQUIRE(reader.open(path));
+        REQUIRE(reader.lineCount() == 1);
+        REQUIRE(reader.readLines(0, 5, lines));
+        REQUIRE(lines.empty());
+    }
+}
+
+TEST_CASE(".wpdb damage is reported, not loaded as text", "[binary_document]") {
+    TempDirGuard guard("wordproc_wpdb_test");
+    std::string path = (guard.dir / "damaged.wpdb").string();
+
+    TextBuffer buffer;
+    std::string text;
+    for (int i = 0; i < 2000; ++i) text += "sentence number " + std::to_string(i) + ". ";
+    buffer.setText(text);
+    REQUIRE(saveDocumentEx(buffer, DocumentSettings{}, path).success);
+    std::string bytes = readBytes(path);
+
+    SECTION("truncated") {
+        writeBytes(path, bytes.substr(0, bytes.size() / 2));
+        TextBuffer loaded;
+        DocumentSettings settings;
+        DocumentResult result = loadDocumentEx(loaded, settings, path);
+        REQUIRE_FALSE(result.success);
+        REQUIRE_FALSE(result.error.empty());
+    }
+
+    SECTION("section sizes the stored bytes cannot hold") {
+        BinaryDocumentReader reader;
+        REQUIRE(reader.open(path));
+        const auto& sections = reader.sections();
+        std::size_t text = 0;
+        while (sections[text].type != WpdbSection::TextChunk) ++text;
+        REQUIRE(sections[text].codec == WpdbCodec::Lz);
+        std::uint64_t storedSize = sections[text].storedSize;
+        reader = BinaryDocumentReader{};
+
+        // rawSize is at byte 24 of an entry
+        for (std::uint64_t rawSize : {lz_block::maxDecompressedSize(storedSize) + 1,
+                                      std::uint64_t{1} << 40, ~std::uint64_t{0}}) {
+            std::string damaged = bytes;
+            patchSectionEntry(damaged, text, 24, rawSize);
+            writeBytes(path, damaged);
+            REQUIRE_FALSE(reader.open(path));
+            REQUIRE(reader.error() == "Damaged .wpdb section entry");
+
+            TextBuffer loaded;
+            DocumentSettings settings;
+            DocumentResult result = loadDocumentEx(loaded, settings, path);
+            REQUIRE_FALSE(result.success);
+            REQUIRE(loaded.getText().empty());
+        }
+    }
+
+    SECTION("flipped byte in the text") {
+        std::size_t middle = bytes.size() / 2;  // Inside the text chunk
+        bytes[middle] = static_cast<char>(bytes[middle] ^ 0x40);
+        writeBytes(path, bytes);
+        TextBuffer loaded;
+        DocumentSettings settings;
+        DocumentResult result = loadDocumentEx(loaded, settings, path);
+        REQUIRE_FALSE(result.success);
+        REQUIRE(loaded.getText().empty());
+    }
+}
+
+TEST_CASE(".wpdb benchmark - size, load and first screen", "[binary_document][benchmark]") {
+    TextBuffer buffer;
+    if (!loadTextFile(buffer, "test_files/public_domain/war_and_peace.txt")) {
+        WARN("Skipping: war_and_peace.txt not found");
+        return;
+    }
+    TempDirGuard guard("wordproc_wpdb_test");
+    std::string wpdoc = (guard.dir / "war_and_peace.wpdoc").string();
+    std::string wpdb = (guard.dir / "war_and_peace.wpdb").string();
+    REQUIRE(saveDocumentEx(buffer, DocumentSettings{}, wpdoc).success);
+
+    auto ms = [](auto start, auto end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+    auto saveStart = std::chrono::high_resolution_clock::now();
+    REQUIRE(saveDocumentEx(buffer, DocumentSettings{}, wpdb).success);
+    auto saveEnd = std::chrono::high_resolution_clock::now();
+
+    double loadMs[2] = {0, 0};
+    const std::string* paths[2] = {&wpdoc, &wpdb};
+    for (int i = 0; i < 2; ++i) {
+        TextBuffer loaded;
+        DocumentSettings settings;
+        auto start = std::chrono::high_resolution_clock::now();
+        REQUIRE(loadDocumentEx(loaded, settings, *paths[i]).success);
+        auto end = std::chrono::high_resolution_clock::now();
+        loadMs[i] = ms(start, end);
+        REQUIRE(loaded.getText().size() == buffer.getText().size());
+    }
+
+    // What a window needs before the rest arrives: settings and ~60 lines
+    auto firstStart = std::chrono::high_resolution_clock::now();
+    BinaryDocumentReader reader;
+    REQUIRE(reader.open(wpdb));
+    DocumentSettings settings;
+    REQUIRE(loadBinaryDocumentSettings(reader, settings).success);
+    std::string visible;
+    REQUIRE(reader.readLines(30000, 60, visible));
+    auto firstEnd = std::chrono::high_resolution_clock::now();
+
+    std::printf("\n=== .wpdb Benchmark ===\n");
+    std::printf("  .wpdoc: %ju KiB, full load %.2f ms\n",
+                static_cast<std::uintmax_t>(std::filesystem::file_size(wpdoc) / 1024),
+                loadMs[0]);
+    std::printf("  .wpdb:  %ju KiB, full load %.2f ms, save %.2f ms (%zu sections)\n",
+                static_cast<std::uintmax_t>(std::filesystem::file_size(wpdb) / 1024), loadMs[1],
+                ms(saveStart, saveEnd), reader.sections().size());
+    std::printf("  .wpdb first screen (settings + 60 lines): %.2f ms, %zu sections decoded\n",
+                ms(firstStart, firstEnd), reader.sectionsDecoded());
+}
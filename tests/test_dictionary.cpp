@@ -0,0 +1,214 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <unordered_set>
+
+#include "../src/editor/dictionary.h"
+#include "../src/editor/spellcheck.h"
+#include "catch2/catch.hpp"
+#include "test_helpers.h"
+
+namespace {
+// Deterministic pseudo-words with realistic shared prefixes/suffixes
+std::vector<std::string> syntheticWords(std::size_t count, unsigned seed = 42) {
+    static const char* stems[] = {"read", "writ", "edit", "form", "print", "page",
+                                  "line", "word", "text", "font", "spell", "check"};
+    static const char* suffixes[] = {"", "s", "ed", "er", "ers", "ing", "able", "ly"};
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::vector<std::string> words;
+    words.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::string word;
+        int extra = 1 + static_cast<int>(rng() % 4);
+        for (int j = 0; j < extra; ++j) word.push_back(static_cast<char>(letter(rng)));
+        word += stems[rng() % 12];
+        word += suffixes[rng() % 8];
+        words.push_back(std::move(word));
+    }
+    return words;
+}
+}  // namespace
+
+TEST_CASE("Dictionary - membership and prefixes", "[dictionary]") {
+    Dictionary dict = Dictionary::fromWords({"tops", "tap", "top", "taps", "tap"});
+
+    REQUIRE(dict.size() == 4);
+    REQUIRE(dict.contains("tap"));
+    REQUIRE(dict.contains("taps"));
+    REQUIRE(dict.contains("top"));
+    REQUIRE(dict.contains("tops"));
+    REQUIRE_FALSE(dict.contains("ta"));
+    REQUIRE_FALSE(dict.contains("tip"));
+    REQUIRE_FALSE(dict.contains("topsy"));
+    REQUIRE_FALSE(dict.contains(""));
+
+    REQUIRE(dict.hasPrefix("to"));
+    REQUIRE_FALSE(dict.hasPrefix("tx"));
+
+    SECTION("shared suffixes are merged") {
+        // root -t-> a -{a,o}-> b -p-> c(final) -s-> d(final)
+        REQUIRE(dict.nodeCount() == 5);
+        REQUIRE(dict.edgeCount() == 5);
+    }
+
+    SECTION("prefix enumeration is sorted") {
+        std::vector<std::string> found;
+        dict.forEachWithPrefix("t", [&](std::string_view w) {
+            found.emplace_back(w);
+            return true;
+        });
+        REQUIRE(found == std::vector<std::string>{"tap", "taps", "top", "tops"});
+
+        found.clear();
+        dict.forEachWithPrefix("top", [&](std::string_view w) {
+            found.emplace_back(w);
+            return true;
+        });
+        REQUIRE(found == std::vector<std::string>{"top", "tops"});
+    }
+
+    SECTION("empty dictionary") {
+        Dictionary empty = Dictionary::fromWords({});
+        REQUIRE(empty.empty());
+        REQUIRE_FALSE(empty.contains("a"));
+    }
+}
+
+TEST_CASE("Dictionary - file round trip via mmap", "[dictionary]") {
+    TempDirGuard guard("wordproc_dict_test");
+    std::string path = guard.path("words.dawg");
+    auto words = syntheticWords(5000);
+    std::unordered_set<std::string> reference(words.begin(), words.end());
+
+    REQUIRE(Dictionary::buildFile(words, path));
+    Dictionary dict;
+    REQUIRE(dict.load(path));
+    REQUIRE(dict.size() == reference.size());
+    for (const auto& word : reference) {
+        REQUIRE(dict.contains(word));
+    }
+    // Misses: mutate each word so it cannot be in the set
+    for (const auto& word : syntheticWords(500, 7)) {
+        std::string miss = word + "zq";
+        REQUIRE(dict.contains(miss) == (reference.count(miss) > 0));
+    }
+
+    SECTION("rejects files that are not dictionaries") {
+        std::string bogus = guard.write("bogus.dawg", "not a dictionary at all, just text");
+        Dictionary bad;
+        REQUIRE_FALSE(bad.load(bogus));
+        REQUIRE_FALSE(bad.error().empty());
+    }
+
+    SECTION("a word list edited after the build makes it stale") {
+        std::string list = guard.path("words.txt");
+        REQUIRE(Dictionary::isCurrent(path, list));  // No list: the .dawg is all there is
+        std::ofstream(list) << "alpha\n";
+        auto built = std::filesystem::last_write_time(path);
+        std::filesystem::last_write_time(list, built - std::chrono::seconds(10));
+        REQUIRE(Dictionary::isCurrent(path, list));
+        std::filesystem::last_write_time(list, built + std::chrono::seconds(10));
+        REQUIRE_FALSE(Dictionary::isCurrent(path, list));
+        REQUIRE_FALSE(Dictionary::isCurrent(guard.path("missing.dawg"), list));
+    }
+
+    SECTION("rejects edge ranges and targets that point outside the file") {
+        std::string bytes = readBytes(path);
+        auto patch = [&](const std::string& name, std::size_t at, std::uint32_t value) {
+            std::string damaged = bytes;
+            std::memcpy(damaged.data() + at, &value, sizeof(value));
+            return guard.write(name, damaged);
+        };
+        std::size_t nodes = 32;  // After the header
+        std::size_t targets = nodes + (dict.nodeCount() + 1) * 4;
+        Dictionary bad;
+        REQUIRE_FALSE(bad.load(patch("range.dawg", nodes + 4, 0x7FFFFFF0u)));
+        REQUIRE_FALSE(bad.load(patch("sentinel.dawg", targets - 4,
+                                     static_cast<std::uint32_t>(dict.edgeCount() + 1))));
+        REQUIRE_FALSE(bad.load(patch("target.dawg", targets,
+                                     static_cast<std::uint32_t>(dict.nodeCount()))));
+        REQUIRE(bad.error() == "Dictionary file is truncated or corrupt");
+
+        // Header word 5 (offset 28) records the byte order it was built with
+        REQUIRE_FALSE(bad.load(patch("swapped.dawg", 28, 0x04030201u)));
+        REQUIRE(bad.error().find("byte order") != std::string::npos);
+    }
+
+    SECTION("rejects truncated files") {
+        std::string truncated = guard.path("truncated.dawg");
+        std::filesystem::copy_file(path, truncated,
+                                   std::filesystem::copy_options::overwrite_existing);
+        std::filesystem::resize_file(truncated, 64);
+        Dictionary bad;
+        REQUIRE_FALSE(bad.load(truncated));
+    }
+
+}
+
+TEST_CASE("SpellChecker - dictionary overlay", "[dictionary][spellcheck]") {
+    SpellChecker checker;
+    REQUIRE(checker.dictionarySize() > 0);
+
+    SECTION("user words layer over the read-only dictionary") {
+        REQUIRE_FALSE(checker.isCorrect("wordproc"));
+        checker.addToUserDictionary("Wordproc");
+        REQUIRE(checker.isCorrect("wordproc"));
+        REQUIRE(checker.isCorrect(std::string_view("WordProc")));
+    }
+
+    SECTION("loadDictionary accepts word lists and compiled files") {
+        TempDirGuard guard("wordproc_dict_test");
+        std::string txt = guard.write("custom.txt", "# custom list\nZephyr\nquokka\n");
+        REQUIRE(checker.loadDictionary(txt));
+        REQUIRE(checker.dictionarySize() == 2);
+        REQUIRE(checker.isCorrect("zephyr"));
+        REQUIRE_FALSE(checker.isCorrect("hello"));
+
+        std::string dawg = guard.path("custom.dawg");
+        REQUIRE(Dictionary::buildFile({"hello", "world"}, dawg));
+        REQUIRE(checker.loadDictionary(dawg));
+        REQUIRE(checker.dictionary().isMapped());
+        REQUIRE(checker.isCorrect("hello"));
+        REQUIRE_FALSE(checker.isCorrect("zephyr"));
+        REQUIRE_FALSE(checker.loadDictionary(guard.path("missing.dawg")));
+    }
+}
+
+TEST_CASE("Dictionary benchmark - compact size and lookup speed", "[dictionary][benchmark]") {
+    auto words = syntheticWords(200000);
+    std::unordered_set<std::string> reference(words.begin(), words.end());
+
+    auto buildStart = std::chrono::high_resolution_clock::now();
+    Dictionary dict = Dictionary::fromWords(words);
+    auto buildEnd = std::chrono::high_resolution_clock::now();
+
+    // Rough unordered_set footprint: node + string header + heap payload
+    std::size_t setBytes = reference.bucket_count() * sizeof(void*);
+    for (const auto& w : reference) {
+        setBytes += sizeof(void*) * 2 + sizeof(std::string) + (w.size() > 15 ? w.size() + 1 : 0);
+    }
+
+    auto lookupStart = std::chrono::high_resolution_clock::now();
+    std::size_t hits = 0;
+    for (const auto& w : words) hits += dict.contains(w) ? 1 : 0;
+    auto lookupEnd = std::chrono::high_resolution_clock::now();
+
+    double buildMs = std::chrono::duration<double, std::milli>(buildEnd - buildStart).count();
+    double lookupUs = std::chrono::duration<double, std::micro>(lookupEnd - lookupStart).count();
+
+    std::printf("\n=== DAWG Dictionary Benchmark ===\n");
+    std::printf("  Words: %zu unique\n", dict.size());
+    std::printf("  Nodes: %zu, edges: %zu\n", dict.nodeCount(), dict.edgeCount());
+    std::printf("  DAWG bytes: %zu (unordered_set est. %zu, %.1fx smaller)\n",
+                dict.memoryBytes(), setBytes,
+                static_cast<double>(setBytes) / static_cast<double>(dict.memoryBytes()));
+    std::printf("  Build: %.1f ms\n", buildMs);
+    std::printf("  Lookup: %.3f us/word\n", lookupUs / static_cast<double>(words.size()));
+
+    REQUIRE(hits == words.size());
+    REQUIRE(dict.memoryBytes() < setBytes);
+}
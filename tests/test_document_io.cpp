@@ -1,30 +1,50 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
+#include <string>
+#include <vector>
 
+#include <nlohmann/json.hpp>
+
+#include "../src/editor/atomic_file.h"
 #include "../src/editor/document_io.h"
 #include "catch2/catch.hpp"
+#include "test_helpers.h"
 
 namespace {
-// Helper to create a temp directory for tests
-std::filesystem::path test_dir() {
-    auto dir = std::filesystem::temp_directory_path() / "wordproc_test";
-    std::filesystem::create_directories(dir);
-    return dir;
+// Peak resident set size in KiB (Linux). resetPeakRss() restarts the
+// high-water mark so a single load can be measured; it returns false where
+// that is not supported and the numbers are then process-wide.
+bool resetPeakRss() {
+    std::ofstream refs("/proc/self/clear_refs");
+    refs << "5";
+    refs.flush();
+    return refs.good();
+}
+
+long peakRssKb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) return std::stol(line.substr(6));
+    }
+    return -1;
 }
 
-// Helper to clean up after tests
-struct TestDirGuard {
-    std::filesystem::path dir;
-    TestDirGuard() : dir(test_dir()) {}
-    ~TestDirGuard() {
-        std::error_code ec;
-        std::filesystem::remove_all(dir, ec);
+long currentRssKb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) return std::stol(line.substr(6));
     }
-};
+    return -1;
+}
 }  // namespace
 
 TEST_CASE("saveTextFile and loadTextFile roundtrip", "[document_io]") {
-    TestDirGuard guard;
+    TempDirGuard guard("wordproc_test");
     std::string path = (guard.dir / "test_doc.wpdoc").string();
 
     SECTION("save and load plain text") {
@@ -107,7 +127,7 @@ TEST_CASE("saveTextFile and loadTextFile roundtrip", "[document_io]") {
 }
 
 TEST_CASE("loadTextFile handles plain text files", "[document_io]") {
-    TestDirGuard guard;
+    TempDirGuard guard("wordproc_test");
     std::string path = (guard.dir / "plain.txt").string();
 
     SECTION("loads plain text as-is when not JSON") {
@@ -120,10 +140,59 @@ TEST_CASE("loadTextFile handles plain text files", "[document_io]") {
         REQUIRE(loadTextFile(buffer, path));
         REQUIRE(buffer.getText() == "Just plain text");
     }
+
+    SECTION("strips CRs and indexes lines") {
+        {
+            std::ofstream ofs(path, std::ios::binary);
+            ofs << "first\r\nsecond\r\n\r\nlast line\r\n";
+        }
+
+        TextBuffer buffer;
+        REQUIRE(loadTextFile(buffer, path));
+        REQUIRE(buffer.getText() == "first\nsecond\n\nlast line\n");
+        REQUIRE(buffer.lineCount() == 5);
+        REQUIRE(buffer.lineString(1) == "second");
+        REQUIRE(buffer.lineString(2).empty());
+        REQUIRE(buffer.lineString(3) == "last line");
+        REQUIRE(buffer.lineString(4).empty());
+    }
+
+    SECTION("empty file loads as a single empty line") {
+        { std::ofstream ofs(path); }
+
+        TextBuffer buffer;
+        buffer.setText("previous\ncontent");
+        REQUIRE(loadTextFile(buffer, path));
+        REQUIRE(buffer.getText().empty());
+        REQUIRE(buffer.lineCount() == 1);
+    }
+}
+
+TEST_CASE("loadTextFile benchmark - large plain text", "[document_io][benchmark]") {
+    const std::string path = "test_files/public_domain/war_and_peace.txt";
+    if (!std::filesystem::exists(path)) {
+        WARN("Skipping: " << path << " not found");
+        return;
+    }
+
+    TextBuffer buffer;
+    auto start = std::chrono::high_resolution_clock::now();
+    REQUIRE(loadTextFile(buffer, path));
+    auto end = std::chrono::high_resolution_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+    std::printf("\n=== Plain Text Load Benchmark ===\n");
+    std::printf("  File: %s (%ju bytes)\n", path.c_str(),
+                static_cast<std::uintmax_t>(std::filesystem::file_size(path)));
+    std::printf("  Lines: %zu\n", buffer.lineCount());
+    std::printf("  Load: %.2f ms\n", ms);
+
+    REQUIRE(buffer.lineCount() > 10000);
+    REQUIRE(buffer.getText().find('\r') == std::string::npos);
 }
 
 TEST_CASE("saveTextFile creates parent directories", "[document_io]") {
-    TestDirGuard guard;
+    TempDirGuard guard("wordproc_test");
     std::string path = (guard.dir / "subdir" / "nested" / "doc.wpdoc").string();
 
     TextBuffer buffer;
@@ -139,7 +208,7 @@ TEST_CASE("loadTextFile returns false for missing file", "[document_io]") {
 }
 
 TEST_CASE("saveDocumentEx and loadDocumentEx roundtrip with full settings", "[document_io]") {
-    TestDirGuard guard;
+    TempDirGuard guard("wordproc_test");
     std::string path = (guard.dir / "full_doc.wpdoc").string();
 
     SECTION("save and load preserves page settings") {
@@ -222,7 +291,7 @@ TEST_CASE("DocumentSettings separation from app settings", "[document_io]") {
     // This test verifies the concept: document settings are per-document,
     // not global app settings. Each document maintains its own settings.
     
-    TestDirGuard guard;
+    TempDirGuard guard("wordproc_test");
     std::string path1 = (guard.dir / "doc1.wpdoc").string();
     std::string path2 = (guard.dir / "doc2.wpdoc").string();
     
@@ -254,3 +323,291 @@ TEST_CASE("DocumentSettings separation from app settings", "[document_io]") {
     REQUIRE(loadedSettings2.pageSettings.mode == PageMode::Pageless);
     REQUIRE(loadedSettings2.textStyle.fontSize == 18);
 }
+
+TEST_CASE("loadDocumentEx streams .wpdoc members", "[document_io]") {
+    TempDirGuard guard("wordproc_test");
+    std::string path = (guard.dir / "stream.wpdoc").string();
+    auto write = [&](const std::string &contents) {
+        std::ofstream ofs(path, std::ios::binary);
+        ofs << contents;
+    };
+
+    SECTION("escapes and CRs in the text field") {
+        write(R"({"style": {"bold": true, "fontSize": 20}, "text": "a\tb\r\nc \"q\" \u00e9\\", )"
+              R"("version": 1, "unknown": [1, {"x": "}"}]})");
+        TextBuffer buffer;
+        DocumentSettings settings;
+        DocumentResult result = loadDocumentEx(buffer, settings, path);
+        REQUIRE(result.success);
+        REQUIRE_FALSE(result.usedFallback);
+        REQUIRE(buffer.getText() == "a\tb\nc \"q\" \xC3\xA9\\");
+        REQUIRE(buffer.lineCount() == 2);
+        REQUIRE(settings.textStyle.bold);
+        REQUIRE(settings.textStyle.fontSize == 20);
+    }
+
+    SECTION("missing text falls back to the raw file") {
+        write(R"({"version": 1, "style": {"bold": true}})");
+        TextBuffer buffer;
+        DocumentSettings settings;
+        DocumentResult result = loadDocumentEx(buffer, settings, path);
+        REQUIRE(result.success);
+        REQUIRE(result.usedFallback);
+        REQUIRE(buffer.getText() == R"({"version": 1, "style": {"bold": true}})");
+    }
+
+    SECTION("malformed documents load as plain text") {
+        for (const std::string bad : {R"({"version": 1, "text": "truncated)",
+                                      R"({"text": "raw
+newline"})",
+                                      R"({"text": 42})", R"({"text": "ok", "style": {"bold": tru}})"}) {
+            write(bad);
+            TextBuffer buffer;
+            DocumentSettings settings;
+            DocumentResult result = loadDocumentEx(buffer, settings, path);
+            REQUIRE(result.success);
+            REQUIRE(result.usedFallback);
+            REQUIRE(buffer.getText() == bad);
+        }
+    }
+
+    SECTION("tables are read entry by entry") {
+        TextBuffer buffer;
+        buffer.setText("Intro\nTable below\n");
+        Table table(2, 3);
+        table.cell(1, 2).content = "corner";
+        TableList tables;
+        tables.emplace_back(1, table);
+        tables.emplace_back(2, Table(1, 1));
+        REQUIRE(saveDocumentWithTables(buffer, DocumentSettings{}, tables, path).success);
+
+        TextBuffer loaded;
+        DocumentSettings settings;
+        TableList loadedTables;
+        REQUIRE(loadDocumentWithTables(loaded, settings, loadedTables, path).success);
+        REQUIRE(loaded.getText() == buffer.getText());
+        REQUIRE(loadedTables.size() == 2);
+        REQUIRE(loadedTables[0].first == 1);
+        REQUIRE(loadedTables[0].second.cell(1, 2).content == "corner");
+        REQUIRE(loadedTables[1].first == 2);
+    }
+}
+
+TEST_CASE("loadDocumentEx handles the test_files corpus", "[document_io]") {
+    auto load = [](const std::string &path, TextBuffer &buffer) {
+        DocumentSettings settings;
+        return loadDocumentEx(buffer, settings, path);
+    };
+    if (!std::filesystem::exists("test_files/should_pass")) {
+        WARN("Skipping: test_files not found");
+        return;
+    }
+
+    TextBuffer buffer;
+    DocumentResult styled = load("test_files/should_pass/unicode.wpdoc", buffer);
+    REQUIRE(styled.success);
+    REQUIRE_FALSE(styled.usedFallback);
+    REQUIRE(buffer.getText().rfind("Unicode test: ", 0) == 0);
+
+    DocumentResult multiline = load("test_files/should_pass/multiline.wpdoc", buffer);
+    REQUIRE(multiline.success);
+    REQUIRE(buffer.lineCount() == 6);
+    REQUIRE(buffer.lineString(5) == "\tTabbed line");
+
+    for (const char *name : {"malformed_json.wpdoc", "missing_text.wpdoc", "truncated.wpdoc"}) {
+        DocumentResult result = load(std::string("test_files/should_fail/") + name, buffer);
+        REQUIRE(result.success);
+        REQUIRE(result.usedFallback);
+    }
+
+    DocumentResult future = load("test_files/should_fail/wrong_version.wpdoc", buffer);
+    REQUIRE(future.usedFallback);
+    REQUIRE(future.error.find("Unsupported document version") != std::string::npos);
+    REQUIRE(buffer.getText() == "Future version that doesn't exist yet");
+}
+
+TEST_CASE("loadDocumentEx benchmark - load time and peak RSS", "[document_io][benchmark]") {
+    if (!std::filesystem::exists("test_files")) {
+        WARN("Skipping: test_files not found");
+        return;
+    }
+    TempDirGuard guard("wordproc_test");
+
+    std::vector<std::string> paths;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator("test_files")) {
+        std::string ext = entry.path().extension().string();
+        if (entry.is_regular_file() && (ext == ".txt" || ext == ".md" || ext == ".wpdoc")) {
+            paths.push_back(entry.path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    // The corpus has no large .wpdoc, so save the largest text as one
+    std::string bigDoc = (guard.dir / "war_and_peace.wpdoc").string();
+    {
+        TextBuffer source;
+        if (loadTextFile(source, "test_files/public_domain/war_and_peace.txt")) {
+            REQUIRE(saveTextFile(source, bigDoc));
+            paths.push_back(bigDoc);
+        }
+    }
+
+    std::printf("\n=== Document Load Benchmark ===\n");
+    std::printf("  %-48s %10s %9s %12s\n", "file", "bytes", "load ms", "peak +KiB");
+    long bigPeakKb = -1;
+    std::uintmax_t bigSize = 0;
+    for (const auto &path : paths) {
+        std::uintmax_t size = std::filesystem::file_size(path);
+        bool peakReset = resetPeakRss();
+        long baseKb = currentRssKb();
+
+        auto start = std::chrono::high_resolution_clock::now();
+        {
+            TextBuffer buffer;
+            DocumentSettings settings;
+            loadDocumentEx(buffer, settings, path);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end - start).count();
+        long peakKb = peakReset ? peakRssKb() - baseKb : -1;
+
+        std::printf("  %-48s %10ju %9.2f %12ld\n", path.c_str(),
+                    static_cast<std::uintmax_t>(size), ms, peakKb);
+        if (path == bigDoc) {
+            bigPeakKb = peakKb;
+            bigSize = size;
+        }
+    }
+
+    if (bigPeakKb >= 0) {
+        // Mapped file pages plus the decoded text; a DOM parse held several
+        // more copies of the document
+        std::printf("  Large .wpdoc peak: %.2fx file size\n",
+                    static_cast<double>(bigPeakKb) * 1024.0 / static_cast<double>(bigSize));
+        REQUIRE(static_cast<std::uintmax_t>(bigPeakKb) * 1024 < 3 * bigSize);
+    }
+}
+
+TEST_CASE("saveDocumentEx streams the same JSON as a full dump", "[document_io]") {
+    TempDirGuard guard("wordproc_test");
+    std::string path = (guard.dir / "streamed.wpdoc").string();
+    auto readFile = [&]() {
+        std::ifstream ifs(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    };
+
+    TextBuffer buffer;
+    buffer.setText("Quote \" and \\ backslash\n\ttab, bell \x07, del \x7f\ncaf\xC3\xA9 \xF0\x9F\x98\x80");
+    buffer.setCaret({1, 3});
+    buffer.insertChar('!');  // Leave the gap in the middle of the text
+
+    DocumentSettings settings;
+    settings.textStyle.bold = true;
+    settings.fontRequirements.push_back({"NotoSansKR", {ScriptRequirement::Korean}});
+
+    SECTION("plain document") {
+        REQUIRE(saveDocumentEx(buffer, settings, path).success);
+        std::string contents = readFile();
+        nlohmann::json parsed = nlohmann::json::parse(contents);
+        REQUIRE(contents == parsed.dump(2));
+        REQUIRE(parsed.at("text").get<std::string>() == buffer.getText());
+        REQUIRE(parsed.at("style").at("bold").get<bool>());
+    }
+
+    SECTION("with tables") {
+        TableList tables;
+        tables.emplace_back(0, Table(2, 2));
+        REQUIRE(saveDocumentWithTables(buffer, settings, tables, path).success);
+        std::string contents = readFile();
+        nlohmann::json parsed = nlohmann::json::parse(contents);
+        REQUIRE(contents == parsed.dump(2));
+        REQUIRE(parsed.at("tables").size() == 1);
+    }
+
+    SECTION("empty document") {
+        TextBuffer empty;
+        REQUIRE(saveDocumentEx(empty, settings, path).success);
+        REQUIRE(nlohmann::json::parse(readFile()).at("text") == "");
+    }
+}
+
+TEST_CASE("saveDocumentEx replaces files atomically", "[document_io]") {
+    TempDirGuard guard("wordproc_test");
+    std::string path = (guard.dir / "atomic.wpdoc").string();
+    auto entries = [&]() {
+        std::size_t count = 0;
+        for ([[maybe_unused]] const auto &entry : std::filesystem::directory_iterator(guard.dir)) {
+            ++count;
+        }
+        return count;
+    };
+
+    TextBuffer first;
+    first.setText("first version");
+    REQUIRE(saveTextFile(first, path));
+    TextBuffer second;
+    second.setText("second version");
+    REQUIRE(saveTextFile(second, path));
+
+    TextBuffer loaded;
+    REQUIRE(loadTextFile(loaded, path));
+    REQUIRE(loaded.getText() == "second version");
+    REQUIRE(entries() == 1);  // No temporary files left behind
+
+    SECTION("an abandoned write leaves the old file intact") {
+        {
+            AtomicFileWriter writer(path);
+            REQUIRE(writer.isOpen());
+            writer.write("{\"text\": \"half writ");
+            REQUIRE(entries() == 2);
+        }
+        REQUIRE(entries() == 1);
+        REQUIRE(loadTextFile(loaded, path));
+        REQUIRE(loaded.getText() == "second version");
+    }
+
+    SECTION("large writes go through") {
+        std::string big(3 * AtomicFileWriter::BUFFER_SIZE + 17, 'x');
+        AtomicFileWriter writer(path + ".raw");
+        writer.write("head");
+        writer.write(big);
+        writer.put('!');
+        REQUIRE(writer.commit());
+        REQUIRE(std::filesystem::file_size(path + ".raw") == big.size() + 5);
+    }
+
+    SECTION("unwritable targets report an error") {
+        AtomicFileWriter writer((guard.dir / "missing" / "dir" / "doc.wpdoc").string());
+        REQUIRE_FALSE(writer.isOpen());
+        REQUIRE_FALSE(writer.commit());
+        REQUIRE_FALSE(writer.error().empty());
+    }
+}
+
+TEST_CASE("saveDocumentEx benchmark - save time and peak RSS", "[document_io][benchmark]") {
+    TextBuffer buffer;
+    if (!loadTextFile(buffer, "test_files/public_domain/war_and_peace.txt")) {
+        WARN("Skipping: war_and_peace.txt not found");
+        return;
+    }
+    TempDirGuard guard("wordproc_test");
+    std::string path = (guard.dir / "war_and_peace.wpdoc").string();
+
+    bool peakReset = resetPeakRss();
+    long baseKb = currentRssKb();
+    auto start = std::chrono::high_resolution_clock::now();
+    REQUIRE(saveDocumentEx(buffer, DocumentSettings{}, path).success);
+    auto end = std::chrono::high_resolution_clock::now();
+    long peakKb = peakReset ? peakRssKb() - baseKb : -1;
+
+    std::uintmax_t size = std::filesystem::file_size(path);
+    std::printf("\n=== Document Save Benchmark ===\n");
+    std::printf("  Output: %ju bytes\n", static_cast<std::uintmax_t>(size));
+    std::printf("  Save: %.2f ms\n", std::chrono::duration<double, std::milli>(end - start).count());
+    std::printf("  Peak RSS growth: %ld KiB\n", peakKb);
+
+    if (peakKb >= 0) {
+        // Only the write buffer and the settings DOM; no copy of the text
+        REQUIRE(static_cast<std::uintmax_t>(peakKb) * 1024 < size / 4);
+    }
+}
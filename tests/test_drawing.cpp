@@ -207,7 +207,7 @@ TEST_CASE("DrawingCollection", "[drawing]") {
         
         auto atLine10 = coll.drawingsAtLine(10);
         REQUIRE(atLine10.size() == 1);
-        REQUIRE(atLine10[0]->shapeType == ShapeType::Rectangle);
+        REQUIRE(atLine10[0].shapeType == ShapeType::Rectangle);
         
         auto atLine7 = coll.drawingsAtLine(7);
         REQUIRE(atLine7.empty());
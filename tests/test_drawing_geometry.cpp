@@ -0,0 +1,346 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "../src/editor/drawing.h"
+#include "catch2/catch.hpp"
+
+using drawing_geometry::Mesh;
+using drawing_geometry::Vertex;
+
+namespace {
+
+float signedArea(const Vertex& a, const Vertex& b, const Vertex& c) {
+    return ((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x)) / 2.0f;
+}
+
+// Total area of a triangle list; every triangle must wind the way
+// raylib's DrawTriangle draws (negative signed area with y down)
+float area(const std::vector<Vertex>& triangles) {
+    REQUIRE(triangles.size() % 3 == 0);
+    float total = 0.0f;
+    for (std::size_t i = 0; i < triangles.size(); i += 3) {
+        float a = signedArea(triangles[i], triangles[i + 1], triangles[i + 2]);
+        REQUIRE(a < 0.0f);
+        total -= a;
+    }
+    return total;
+}
+
+DocumentDrawing shape(ShapeType type, float width = 100.0f, float height = 50.0f) {
+    DocumentDrawing drawing;
+    drawing.shapeType = type;
+    drawing.width = width;
+    drawing.height = height;
+    drawing.strokeWidth = 2.0f;
+    return drawing;
+}
+
+Mesh tessellated(const DocumentDrawing& drawing, float zoom = 1.0f) {
+    Mesh mesh;
+    drawing_geometry::tessellate(drawing, zoom, mesh);
+    return mesh;
+}
+
+}  // namespace
+
+TEST_CASE("Drawing fills are triangulated", "[drawing_geometry]") {
+    SECTION("rectangles, triangles and ellipses") {
+        DocumentDrawing rect = shape(ShapeType::Rectangle);
+        rect.filled = true;
+        REQUIRE(area(tessellated(rect).fill) == Approx(5000.0f));
+
+        DocumentDrawing flipped = shape(ShapeType::Rectangle, -100.0f, -50.0f);
+        flipped.filled = true;
+        REQUIRE(area(tessellated(flipped).fill) == Approx(5000.0f));
+
+        DocumentDrawing tri = shape(ShapeType::Triangle);
+        tri.filled = true;
+        REQUIRE(area(tessellated(tri).fill) == Approx(2500.0f));
+
+        DocumentDrawing ellipse = shape(ShapeType::Ellipse);
+        ellipse.filled = true;
+        REQUIRE(area(tessellated(ellipse).fill) == Approx(3.14159f * 50.0f * 25.0f).epsilon(0.01));
+    }
+
+    SECTION("rounded corners cut the corner squares down to quarter circles") {
+        DocumentDrawing rounded = shape(ShapeType::RoundedRect);
+        rounded.filled = true;
+        rounded.cornerRadius = 10.0f;
+        float expected = 5000.0f - (4.0f - 3.14159f) * 100.0f;
+        REQUIRE(area(tessellated(rounded).fill) == Approx(expected).epsilon(0.01));
+        rounded.cornerRadius = 500.0f;  // Clamped to a stadium
+        REQUIRE(area(tessellated(rounded).fill) > 0.0f);
+    }
+
+    SECTION("a concave freehand outline") {
+        DocumentDrawing freeform = shape(ShapeType::FreeformLine);
+        freeform.filled = true;
+        // An L: 30x30 square minus its 20x20 top right
+        freeform.points = {{0, 0}, {10, 0}, {10, 20}, {30, 20}, {30, 30}, {0, 30}, {0, 0}};
+        REQUIRE(area(tessellated(freeform).fill) == Approx(500.0f));
+    }
+
+    SECTION("lines and unfilled shapes have no fill") {
+        REQUIRE(tessellated(shape(ShapeType::Line)).fill.empty());
+        REQUIRE(tessellated(shape(ShapeType::Ellipse)).fill.empty());
+    }
+
+    SECTION("rotation turns the shape about its center") {
+        DocumentDrawing rect = shape(ShapeType::Rectangle);
+        rect.filled = true;
+        rect.rotation = 90.0f;
+        Mesh mesh = tessellated(rect);
+        REQUIRE(area(mesh.fill) == Approx(5000.0f));
+        float top = 1e9f;
+        for (const Vertex& v : mesh.fill) top = std::min(top, v.y);
+        REQUIRE(top == Approx(-25.0f));  // 100 wide is now 100 tall around y = 25
+    }
+}
+
+TEST_CASE("Drawing strokes follow width, style and arrowheads", "[drawing_geometry]") {
+    DocumentDrawing line = shape(ShapeType::Line, 100.0f, 0.0f);
+    line.strokeWidth = 4.0f;
+
+    SECTION("a solid line is one quad") {
+        Mesh mesh = tessellated(line);
+        REQUIRE(mesh.stroke.size() == 6);
+        REQUIRE(area(mesh.stroke) == Approx(400.0f));
+    }
+
+    SECTION("dashes cover part of the line") {
+        line.lineStyle = LineStyle::Dashed;  // 16 on, 8 off
+        Mesh mesh = tessellated(line);
+        REQUIRE(mesh.stroke.size() == 5 * 6);
+        REQUIRE(area(mesh.stroke) == Approx(4.0f * (16.0f * 4 + 4.0f)));
+        line.lineStyle = LineStyle::Dotted;
+        REQUIRE(tessellated(line).stroke.size() == 13 * 6);
+    }
+
+    SECTION("closed outlines are mitered all the way round") {
+        DocumentDrawing rect = shape(ShapeType::Rectangle);
+        // Outer 102x52 minus inner 98x48
+        REQUIRE(area(tessellated(rect).stroke) == Approx(102.0f * 52.0f - 98.0f * 48.0f));
+    }
+
+    SECTION("arrowheads") {
+        DocumentDrawing arrow = shape(ShapeType::Arrow, 100.0f, 0.0f);
+        arrow.strokeWidth = 2.0f;
+        arrow.startArrow = ArrowStyle::None;
+        arrow.endArrow = ArrowStyle::Standard;
+        // Head 8 long and 8 wide; the line stops at its base
+        REQUIRE(area(tessellated(arrow).stroke) == Approx(92.0f * 2.0f + 32.0f));
+        arrow.startArrow = ArrowStyle::Circle;
+        arrow.endArrow = ArrowStyle::Diamond;
+        REQUIRE(tessellated(arrow).stroke.size() > 6 + 6 + 8 * 3);
+        arrow.width = 5.0f;  // Shorter than its heads: no line between them
+        REQUIRE(area(tessellated(arrow).stroke) < 32.0f + 3.15f * 16.0f);
+    }
+
+    SECTION("nothing to stroke") {
+        line.strokeWidth = 0.0f;
+        REQUIRE(tessellated(line).stroke.empty());
+        DocumentDrawing empty = shape(ShapeType::FreeformLine);
+        REQUIRE(tessellated(empty).stroke.empty());
+    }
+}
+
+TEST_CASE("Curves get finer in higher zoom buckets", "[drawing_geometry]") {
+    REQUIRE(drawing_geometry::zoomBucket(1.0f) == 0);
+    REQUIRE(drawing_geometry::zoomBucket(1.2f) == 1);
+    REQUIRE(drawing_geometry::zoomBucket(2.0f) == 2);
+    REQUIRE(drawing_geometry::zoomBucket(0.5f) == -2);
+    REQUIRE(drawing_geometry::zoomBucket(0.0f) == 0);
+
+    DocumentDrawing ellipse = shape(ShapeType::Ellipse, 200.0f, 200.0f);
+    ellipse.filled = true;
+    std::size_t small = tessellated(ellipse, 0.5f).fill.size();
+    std::size_t large = tessellated(ellipse, 4.0f).fill.size();
+    REQUIRE(small < large);
+    // Same bucket, same triangles
+    REQUIRE(tessellated(ellipse, 1.1f).fill.size() == tessellated(ellipse, 1.4f).fill.size());
+}
+
+TEST_CASE("Drawing geometry is cached until the drawing changes", "[drawing_geometry]") {
+    DrawingCollection drawings;
+    DocumentDrawing rect = shape(ShapeType::Rectangle);
+    rect.filled = true;
+    std::size_t rectId = drawings.addDrawing(rect);
+    drawings.addDrawing(shape(ShapeType::Ellipse));
+    const DrawingCollection& view = drawings;
+
+    view.geometry(0, 1.0f);
+    view.geometry(1, 1.0f);
+    REQUIRE(view.geometryCache().builds() == 2);
+
+    SECTION("frames without edits reuse every mesh") {
+        for (int frame = 0; frame < 10; ++frame) {
+            view.geometry(0, 1.0f);
+            view.geometry(1, 0.8f);  // Same bucket as 1.0
+        }
+        REQUIRE(view.geometryCache().builds() == 2);
+    }
+
+    SECTION("editing one drawing rebuilds only it") {
+        drawings.editDrawing(rectId, [](DocumentDrawing& drawing) { drawing.width = 60.0f; });
+        REQUIRE(area(view.geometry(0, 1.0f).fill) == Approx(3000.0f));
+        view.geometry(1, 1.0f);
+        REQUIRE(view.geometryCache().builds() == 3);
+    }
+
+    SECTION("colors and anchors are not part of the geometry") {
+        drawings.editDrawing(rectId,
+                             [](DocumentDrawing& drawing) { drawing.fillColor = DrawingColors::Red; });
+        drawings.shiftAnchorsFrom(0, 3);
+        view.geometry(0, 1.0f);
+        view.geometry(1, 1.0f);
+        REQUIRE(view.geometryCache().builds() == 2);
+    }
+
+    SECTION("another zoom bucket rebuilds") {
+        view.geometry(0, 2.0f);
+        REQUIRE(view.geometryCache().builds() == 3);
+    }
+
+    SECTION("removed drawings leave the cache") {
+        drawings.removeDrawing(rectId);
+        REQUIRE(view.geometryCache().size() == 1);
+        drawings.clear();
+        REQUIRE(view.geometryCache().size() == 0);
+    }
+}
+
+TEST_CASE("Drawing extents cover everything drawn", "[drawing_geometry]") {
+    auto covers = [](const DocumentDrawing& drawing) {
+        drawing_geometry::Extent box = drawing_geometry::extent(drawing);
+        for (float zoom : {0.5f, 1.0f, 4.0f}) {
+            Mesh mesh = tessellated(drawing, zoom);
+            for (const auto* part : {&mesh.fill, &mesh.stroke}) {
+                for (const Vertex& v : *part) {
+                    if (v.x < box.left || v.x > box.right || v.y < box.top || v.y > box.bottom) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    };
+
+    DocumentDrawing rect = shape(ShapeType::Rectangle);
+    rect.strokeWidth = 12.0f;
+    rect.rotation = 30.0f;
+    REQUIRE(covers(rect));
+
+    DocumentDrawing arrow = shape(ShapeType::Arrow, 4.0f, 0.0f);  // Shorter than its heads
+    arrow.startArrow = ArrowStyle::Open;
+    arrow.endArrow = ArrowStyle::Circle;
+    arrow.strokeWidth = 5.0f;
+    REQUIRE(covers(arrow));
+    REQUIRE(drawing_geometry::extent(arrow).top < -10.0f);
+
+    DocumentDrawing freehand = shape(ShapeType::FreeformLine, 10.0f, 10.0f);
+    freehand.points = {{200.0f, 300.0f}, {260.0f, 240.0f}, {230.0f, 330.0f}};
+    freehand.filled = true;
+    freehand.lineStyle = LineStyle::Dashed;
+    REQUIRE(covers(freehand));
+    REQUIRE(drawing_geometry::extent(freehand).left > 190.0f);
+
+    // Culling and hit testing use the extent, not x/y/width/height
+    DrawingCollection drawings;
+    drawings.addDrawing(freehand);
+    std::vector<std::size_t> visible;
+    drawings.drawingsOverlapping(280.0f, 290.0f, 16.0f, 1.0f, visible);
+    REQUIRE(visible.size() == 1);
+    REQUIRE(drawings.drawingAt(230.0f, 300.0f, 16.0f, 1.0f) != nullptr);
+    REQUIRE(drawings.drawingAt(5.0f, 5.0f, 16.0f, 1.0f) == nullptr);
+    drawings.drawingsOverlapping(280.0f, 290.0f, 16.0f, 2.0f, visible);
+    REQUIRE(visible.empty());  // At 2x the points are past row 460
+}
+
+TEST_CASE("Drawing geometry frame benchmark", "[drawing_geometry][benchmark]") {
+    // 600 shapes of every kind plus 40 freehand strokes of 2000 points,
+    // half of those filled, spread over a 2000-line document
+    DrawingCollection drawings;
+    const ShapeType types[] = {ShapeType::Line,        ShapeType::Rectangle, ShapeType::Ellipse,
+                               ShapeType::Arrow,       ShapeType::RoundedRect,
+                               ShapeType::Triangle};
+    const LineStyle styles[] = {LineStyle::Solid, LineStyle::Dashed, LineStyle::Dotted,
+                                LineStyle::DashDot};
+    for (std::size_t i = 0; i < 600; ++i) {
+        DocumentDrawing drawing = shape(types[i % 6], 80.0f + static_cast<float>(i % 7) * 20.0f,
+                                        60.0f + static_cast<float>(i % 5) * 15.0f);
+        drawing.anchorLine = i * 3;
+        drawing.lineStyle = styles[i % 4];
+        drawing.filled = i % 2 == 0;
+        drawing.cornerRadius = 12.0f;
+        drawing.rotation = static_cast<float>(i % 3) * 15.0f;
+        drawing.startArrow = ArrowStyle::Circle;
+        drawings.addDrawing(drawing);
+    }
+    for (std::size_t s = 0; s < 40; ++s) {
+        DocumentDrawing stroke = shape(ShapeType::FreeformLine, 300.0f, 300.0f);
+        stroke.anchorLine = s * 50;
+        stroke.filled = s % 2 == 0;
+        stroke.lineStyle = s % 3 == 0 ? LineStyle::Dashed : LineStyle::Solid;
+        for (std::size_t p = 0; p < 2000; ++p) {
+            // A wobbly closed loop, as drawn by hand
+            float t = static_cast<float>(p) * 2.0f * 3.14159265f / 2000.0f;
+            float r = 120.0f + 20.0f * std::sin(t * 9.0f + static_cast<float>(s));
+            stroke.points.push_back({150.0f + r * std::cos(t), 150.0f + r * std::sin(t)});
+        }
+        drawings.addDrawing(stroke);
+    }
+
+    // Scroll through the document one 40-line screen per frame, at 16px
+    // lines, the way renderDrawings picks and draws
+    const DrawingCollection& view = drawings;
+    constexpr int FRAMES = 150;
+    std::vector<std::size_t> visible;
+    std::size_t triangles = 0;
+    auto frame = [&](int f, bool cached, Mesh& scratch) {
+        float top = static_cast<float>(f % 50) * 640.0f;
+        view.drawingsOverlapping(top, top + 640.0f, 16.0f, 1.0f, visible);
+        for (std::size_t index : visible) {
+            const Mesh* mesh = &scratch;
+            if (cached) {
+                mesh = &view.geometry(index, 1.0f);
+            } else {
+                drawing_geometry::tessellate(view.drawings()[index], 1.0f, scratch);
+            }
+            triangles += (mesh->fill.size() + mesh->stroke.size()) / 3;
+        }
+    };
+
+    Mesh scratch;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int f = 0; f < FRAMES; ++f) frame(f, false, scratch);
+    auto uncached = std::chrono::high_resolution_clock::now();
+    for (int f = 0; f < 50; ++f) frame(f, true, scratch);  // First pass builds every mesh
+    auto warmed = std::chrono::high_resolution_clock::now();
+    std::size_t builds = view.geometryCache().builds();
+    for (int f = 0; f < FRAMES; ++f) frame(f, true, scratch);
+    auto cached = std::chrono::high_resolution_clock::now();
+
+    // An edit between frames re-tessellates only the edited drawing
+    drawings.editDrawing(drawings.drawings()[0].id,
+                         [](DocumentDrawing& drawing) { drawing.width += 5.0f; });
+    frame(0, true, scratch);
+    auto edited = std::chrono::high_resolution_clock::now();
+
+    REQUIRE(triangles > 0);
+    REQUIRE(builds == drawings.count());
+    REQUIRE(view.geometryCache().builds() == builds + 1);
+
+    auto ms = [](auto a, auto b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+    std::printf("\n=== Drawing Geometry Benchmark ===\n");
+    std::printf("  %zu drawings, %d frames\n", drawings.count(), FRAMES);
+    std::printf("  Tessellating every frame: %.3f ms/frame\n", ms(start, uncached) / FRAMES);
+    std::printf("  First pass, building %zu meshes: %.3f ms/frame\n", builds,
+                ms(uncached, warmed) / 50);
+    std::printf("  Cached geometry: %.3f ms/frame\n", ms(warmed, cached) / FRAMES);
+    std::printf("  Frame after an edit: %.3f ms\n", ms(cached, edited));
+    REQUIRE(ms(warmed, cached) < ms(start, uncached));
+}
@@ -0,0 +1,398 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+
+#include "../src/editor/document_io.h"
+#include "../src/editor/edit_journal.h"
+#include "catch2/catch.hpp"
+#include "test_helpers.h"
+
+namespace {
+// Typing, deleting, caret jumps, undo and style changes in a repeatable mix
+void randomEdits(TextBuffer& buffer, std::mt19937& rng, int count) {
+    for (int i = 0; i < count; ++i) {
+        int op = static_cast<int>(rng() % 100);
+        if (op < 55) {
+            buffer.insertChar(static_cast<char>('a' + rng() % 26));
+        } else if (op < 60) {
+            buffer.insertChar('\n');
+        } else if (op < 70) {
+            buffer.backspace();
+        } else if (op < 75) {
+            buffer.del();
+        } else if (op < 88) {
+            std::size_t row = rng() % buffer.lineCount();
+            std::size_t length = buffer.lineSpan(row).length;
+            buffer.setCaret({row, length == 0 ? 0 : rng() % (length + 1)});
+        } else if (op < 93) {
+            buffer.undo();
+        } else if (op < 95) {
+            buffer.insertText("pasted text");
+        } else {
+            TextStyle style = buffer.textStyle();
+            style.bold = !style.bold;
+            style.fontSize = 12 + static_cast<int>(rng() % 12);
+            buffer.setTextStyle(style);
+        }
+    }
+}
+}  // namespace
+
+TEST_CASE("EditJournal replays to the same text and style", "[edit_journal]") {
+    TempDirGuard guard("wordproc_journal_test");
+    std::string journalPath = (guard.dir / "doc.journal").string();
+
+    TextBuffer buffer;
+    EditJournal journal(journalPath);
+    REQUIRE(journal.rebase(buffer, "", false));
+    buffer.setEditListener(&journal);
+
+    std::mt19937 rng(1234);
+    for (int frame = 0; frame < 200; ++frame) {
+        randomEdits(buffer, rng, 25);
+        REQUIRE(journal.flush());
+    }
+    buffer.setText("Replaced wholesale\nand then edited");
+    buffer.setCaret({1, 3});
+    randomEdits(buffer, rng, 200);
+    REQUIRE(journal.sync());
+
+    // Merging keeps the journal far below one record per keystroke
+    REQUIRE(journal.recordCount() > 0);
+    REQUIRE(journal.recordCount() < 200 * 25);
+
+    TextBuffer recovered;
+    DocumentSettings settings;
+    JournalRecovery recovery = recoverFromJournal(journalPath, "", recovered, settings);
+    REQUIRE(recovery.error.empty());
+    REQUIRE(recovery.recovered);
+    REQUIRE_FALSE(recovery.usedPrevious);
+    REQUIRE(recovery.recordsReplayed == journal.recordCount());
+    REQUIRE(recovered.getText() == buffer.getText());
+    REQUIRE(recovered.textStyle().bold == buffer.textStyle().bold);
+    REQUIRE(recovered.textStyle().fontSize == buffer.textStyle().fontSize);
+    REQUIRE(settings.textStyle.fontSize == buffer.textStyle().fontSize);
+}
+
+TEST_CASE("EditJournal replays paragraph formats and anchors", "[edit_journal]") {
+    TempDirGuard guard("wordproc_journal_test");
+    std::string journalPath = (guard.dir / "doc.journal").string();
+    std::string checkpoint = (guard.dir / "autosave.wpdoc").string();
+
+    TextBuffer buffer;
+    buffer.setText("Title\nbody\nmore body");
+    buffer.setCaret({0, 0});
+    buffer.setCurrentParagraphStyle(ParagraphStyle::Title);
+    buffer.addBookmarkAt("top", 0);
+    EditJournal journal(journalPath);
+    buffer.setEditListener(&journal);
+    // The checkpoint holds only the text; the journal restates the rest
+    REQUIRE(saveDocumentEx(buffer, DocumentSettings{}, checkpoint).success);
+    REQUIRE(journal.rebase(buffer, checkpoint, false));
+    REQUIRE(journal.recordCount() == 0);
+
+    std::mt19937 rng(99);
+    for (int frame = 0; frame < 100; ++frame) {
+        randomEdits(buffer, rng, 10);
+        std::size_t row = rng() % buffer.lineCount();
+        buffer.setCaret({row, 0});
+        switch (rng() % 6) {
+            case 0: buffer.setCurrentParagraphStyle(ParagraphStyle::Heading2); break;
+            case 1: buffer.toggleBulletedList(); break;
+            case 2: buffer.setCurrentAlignment(TextAlignment::Center); break;
+            case 3: buffer.insertChar('\n'); break;  // Splits carry list formats along
+            case 4: {
+                std::size_t offset = buffer.caretOffset();
+                std::size_t end = std::min(offset + 4, buffer.getText().size());
+                buffer.addHyperlinkAt(offset, end, "https://example.com/" + std::to_string(frame));
+            } break;
+            default:
+                buffer.addBookmarkAt("mark" + std::to_string(frame), buffer.caretOffset());
+                break;
+        }
+        REQUIRE(journal.flush());
+    }
+    REQUIRE(journal.sync());
+
+    TextBuffer recovered;
+    DocumentSettings settings;
+    JournalRecovery recovery = recoverFromJournal(journalPath, checkpoint, recovered, settings);
+    REQUIRE(recovery.error.empty());
+    REQUIRE(recovered.getText() == buffer.getText());
+    REQUIRE(recovered.lineCount() == buffer.lineCount());
+    for (std::size_t row = 0; row < buffer.lineCount(); ++row) {
+        INFO("row " << row);
+        REQUIRE(recovered.lineFormat(row) == buffer.lineFormat(row));
+    }
+    REQUIRE(recovered.hyperlinks() == buffer.hyperlinks());
+    REQUIRE(recovered.bookmarks() == buffer.bookmarks());
+    REQUIRE(recovered.getBookmark("top") != nullptr);
+}
+
+TEST_CASE("EditJournal merges keystrokes into compact records", "[edit_journal]") {
+    TempDirGuard guard("wordproc_journal_test");
+    std::string journalPath = (guard.dir / "doc.journal").string();
+
+    TextBuffer buffer;
+    EditJournal journal(journalPath);
+    REQUIRE(journal.rebase(buffer, "", false));
+    buffer.setEditListener(&journal);
+    buffer.setText("Hello");
+    REQUIRE(journal.flush());
+    const std::size_t base = journal.recordCount();
+
+    SECTION("a typed word is one record") {
+        buffer.insertText(" world");
+        REQUIRE(journal.flush());
+        REQUIRE(journal.recordCount() == base + 1);
+    }
+
+    SECTION("backspacing over fresh typing shortens the pending insert") {
+        buffer.insertText(" wrold");
+        for (int i = 0; i < 4; ++i) buffer.backspace();
+        buffer.insertText("orld");
+        REQUIRE(journal.flush());
+        REQUIRE(journal.recordCount() == base + 1);
+    }
+
+    SECTION("a run of backspaces is one record") {
+        for (int i = 0; i < 5; ++i) buffer.backspace();
+        REQUIRE(journal.flush());
+        REQUIRE(journal.recordCount() == base + 1);
+        REQUIRE(buffer.getText().empty());
+    }
+
+    SECTION("re-applying the same style is not journaled") {
+        TextStyle style = buffer.textStyle();
+        for (int i = 0; i < 10; ++i) buffer.setTextStyle(style);
+        style.italic = true;
+        buffer.setTextStyle(style);
+        REQUIRE(journal.flush());
+        REQUIRE(journal.recordCount() == base + 1);
+    }
+
+    TextBuffer recovered;
+    DocumentSettings settings;
+    recoverFromJournal(journalPath, "", recovered, settings);
+    REQUIRE(recovered.getText() == buffer.getText());
+}
+
+TEST_CASE("EditJournal recovery stops at a torn or corrupt record", "[edit_journal]") {
+    TempDirGuard guard("wordproc_journal_test");
+    std::string journalPath = (guard.dir / "doc.journal").string();
+
+    TextBuffer buffer;
+    EditJournal journal(journalPath);
+    REQUIRE(journal.rebase(buffer, "", false));
+    buffer.setEditListener(&journal);
+
+    buffer.insertText("durable line\n");
+    REQUIRE(journal.flush());
+    std::string durableText = buffer.getText();
+    std::size_t durableSize = std::filesystem::file_size(journalPath);
+
+    buffer.setCaret({0, 0});
+    buffer.insertText("lost in the crash ");
+    REQUIRE(journal.flush());
+    std::string bytes = readBytes(journalPath);
+    REQUIRE(bytes.size() > durableSize);
+
+    SECTION("truncated mid-record") {
+        for (std::size_t cut = durableSize; cut < bytes.size(); ++cut) {
+            writeBytes(journalPath, bytes.substr(0, cut));
+            TextBuffer recovered;
+            DocumentSettings settings;
+            JournalRecovery recovery = recoverFromJournal(journalPath, "", recovered, settings);
+            REQUIRE(recovery.error.empty());
+            REQUIRE(recovered.getText() == durableText);
+        }
+    }
+
+    SECTION("flipped byte in the last record") {
+        bytes[bytes.size() - 6] ^= 0x20;
+        writeBytes(journalPath, bytes);
+        TextBuffer recovered;
+        DocumentSettings settings;
+        recoverFromJournal(journalPath, "", recovered, settings);
+        REQUIRE(recovered.getText() == durableText);
+    }
+
+    SECTION("missing journal leaves the buffer alone") {
+        std::filesystem::remove(journalPath);
+        TextBuffer untouched;
+        untouched.setText("keep me");
+        DocumentSettings settings;
+        JournalRecovery recovery = recoverFromJournal(journalPath, "", untouched, settings);
+        REQUIRE_FALSE(recovery.recovered);
+        REQUIRE_FALSE(recovery.error.empty());
+        REQUIRE(untouched.getText() == "keep me");
+    }
+
+    SECTION("an unrecoverable journal is set aside, not deleted") {
+        // Its base is gone, so it cannot be replayed
+        EditJournal orphan(journalPath);
+        REQUIRE(orphan.rebase(buffer, (guard.dir / "gone.wpdoc").string(), false));
+        orphan.onInsert(0, "edits");
+        REQUIRE(orphan.flush());
+        std::string orphanBytes = readBytes(journalPath);
+        TextBuffer untouched;
+        DocumentSettings settings;
+        JournalRecovery recovery = recoverFromJournal(journalPath, "", untouched, settings);
+        REQUIRE_FALSE(recovery.error.empty());
+
+        REQUIRE(setAsideJournal(journalPath));
+        REQUIRE_FALSE(std::filesystem::exists(journalPath));
+        REQUIRE(readBytes(journalPath + ".unrecovered") == orphanBytes);
+
+        // A fresh journal at the same path leaves the set-aside copy alone
+        EditJournal next(journalPath);
+        REQUIRE(next.rebase(buffer, "", false));
+        REQUIRE(readBytes(journalPath + ".unrecovered") == orphanBytes);
+    }
+}
+
+TEST_CASE("EditJournal checkpoints chain through the previous journal", "[edit_journal]") {
+    TempDirGuard guard("wordproc_journal_test");
+    std::string journalPath = (guard.dir / "doc.journal").string();
+    std::string checkpoint = (guard.dir / "autosave.wpdoc").string();
+
+    TextBuffer buffer;
+    EditJournal journal(journalPath);
+    REQUIRE(journal.rebase(buffer, "", false));
+    buffer.setEditListener(&journal);
+    buffer.insertText("before the checkpoint\n");
+
+    // Start the checkpoint: the journal rotates before the base is written
+    REQUIRE(journal.rebase(buffer, checkpoint, true));
+    REQUIRE(journal.hasPrevious());
+    buffer.insertText("after the checkpoint");
+    REQUIRE(journal.flush());
+
+    auto recover = [&](JournalRecovery& recovery) {
+        TextBuffer recovered;
+        DocumentSettings settings;
+        recovery = recoverFromJournal(journalPath, checkpoint, recovered, settings);
+        return recovered.getText();
+    };
+
+    SECTION("crash before the checkpoint is written") {
+        JournalRecovery recovery;
+        REQUIRE(recover(recovery) == buffer.getText());
+        REQUIRE(recovery.usedPrevious);
+        REQUIRE(recovery.basePath.empty());
+    }
+
+    SECTION("crash after the checkpoint is written") {
+        // Snapshot of the text the rebase hashed
+        TextBuffer snapshot;
+        snapshot.setText("before the checkpoint\n");
+        REQUIRE(saveDocumentEx(snapshot, DocumentSettings{}, checkpoint).success);
+        journal.dropPrevious();
+        REQUIRE_FALSE(journal.hasPrevious());
+
+        JournalRecovery recovery;
+        REQUIRE(recover(recovery) == buffer.getText());
+        REQUIRE_FALSE(recovery.usedPrevious);
+        REQUIRE(recovery.basePath == checkpoint);
+        REQUIRE(recovery.recordsReplayed == 1);
+    }
+
+    SECTION("failed checkpoint folds back into the previous journal") {
+        REQUIRE(journal.abandonRebase());
+        REQUIRE_FALSE(journal.hasPrevious());
+        buffer.insertText(", still journaled");
+        REQUIRE(journal.flush());
+
+        JournalRecovery recovery;
+        REQUIRE(recover(recovery) == buffer.getText());
+        REQUIRE(recovery.basePath.empty());
+        REQUIRE_FALSE(recovery.usedPrevious);
+    }
+
+    SECTION("a saved document with changed contents is not used as a base") {
+        TextBuffer other;
+        other.setText("somebody else's text");
+        REQUIRE(saveDocumentEx(other, DocumentSettings{}, checkpoint).success);
+        std::filesystem::remove(journal.previousPath());
+
+        JournalRecovery recovery;
+        TextBuffer recovered;
+        DocumentSettings settings;
+        recovery = recoverFromJournal(journalPath, checkpoint, recovered, settings);
+        REQUIRE_FALSE(recovery.recovered);
+        REQUIRE_FALSE(recovery.error.empty());
+    }
+}
+
+TEST_CASE("EditJournal benchmark - throughput and recovery", "[edit_journal][benchmark]") {
+    TextBuffer buffer;
+    if (!loadTextFile(buffer, "test_files/public_domain/war_and_peace.txt")) {
+        WARN("Skipping: war_and_peace.txt not found");
+        return;
+    }
+    TempDirGuard guard("wordproc_journal_test");
+    std::string journalPath = (guard.dir / "doc.journal").string();
+    std::string checkpoint = (guard.dir / "checkpoint.wpdoc").string();
+
+    auto ms = [](auto start, auto end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+
+    auto checkpointStart = std::chrono::high_resolution_clock::now();
+    REQUIRE(saveDocumentEx(buffer, DocumentSettings{}, checkpoint).success);
+    auto checkpointEnd = std::chrono::high_resolution_clock::now();
+
+    EditJournal journal(journalPath);
+    REQUIRE(journal.rebase(buffer, checkpoint, false));
+    buffer.setEditListener(&journal);
+
+    // Bursts of typing at scattered places, flushed as the frame loop would
+    std::mt19937 rng(42);
+    const int frames = 500;
+    const int keysPerFrame = 10;
+    double editMs = 0.0;
+    double flushMs = 0.0;
+    for (int frame = 0; frame < frames; ++frame) {
+        if (frame % 20 == 0) {
+            std::size_t row = rng() % buffer.lineCount();
+            buffer.setCaret({row, 0});
+        }
+        auto editStart = std::chrono::high_resolution_clock::now();
+        for (int key = 0; key < keysPerFrame; ++key) {
+            if (key == keysPerFrame - 1 && frame % 3 == 0) {
+                buffer.backspace();
+            } else {
+                buffer.insertChar(static_cast<char>('a' + rng() % 26));
+            }
+        }
+        auto flushStart = std::chrono::high_resolution_clock::now();
+        REQUIRE(journal.flush());
+        auto flushEnd = std::chrono::high_resolution_clock::now();
+        editMs += ms(editStart, flushStart);
+        flushMs += ms(flushStart, flushEnd);
+    }
+    REQUIRE(journal.sync());
+
+    auto recoverStart = std::chrono::high_resolution_clock::now();
+    TextBuffer recovered;
+    DocumentSettings settings;
+    JournalRecovery recovery = recoverFromJournal(journalPath, checkpoint, recovered, settings);
+    auto recoverEnd = std::chrono::high_resolution_clock::now();
+    REQUIRE(recovery.recovered);
+    REQUIRE(recovered.getText() == buffer.getText());
+
+    const int keystrokes = frames * keysPerFrame;
+    std::printf("\n=== Edit Journal Benchmark ===\n");
+    std::printf("  Full checkpoint (old autosave cost): %.2f ms, %zu KiB\n",
+                ms(checkpointStart, checkpointEnd),
+                static_cast<std::size_t>(std::filesystem::file_size(checkpoint) / 1024));
+    std::printf("  %d keystrokes over %d frames: %zu records, %llu bytes journaled\n", keystrokes,
+                frames, journal.recordCount(),
+                static_cast<unsigned long long>(journal.bytesWritten()));
+    std::printf("  Editing: %.2f ms, journal flushes: %.2f ms (%.1f us/frame)\n", editMs, flushMs,
+                flushMs * 1000.0 / frames);
+    std::printf("  Recovery (load checkpoint + replay %zu records): %.2f ms\n",
+                recovery.recordsReplayed, ms(recoverStart, recoverEnd));
+}
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/editor/document_io.h"
+#include "../src/editor/export/export_html.h"
+#include "../src/editor/export/export_pdf.h"
+#include "../src/editor/export/export_pipeline.h"
+#include "catch2/catch.hpp"
+#include "test_helpers.h"
+
+namespace {
+std::string longText(int paragraphs) {
+    std::string text;
+    for (int i = 0; i < paragraphs; ++i) {
+        text += "Paragraph " + std::to_string(i) +
+                " has <markup> & enough words in it to wrap across more than one line of "
+                "the page before the next paragraph begins.\n";
+    }
+    return text;
+}
+}  // namespace
+
+TEST_CASE("OrderedEncoder returns results in submission order", "[export_pipeline]") {
+    for (unsigned int threads : {1u, 4u}) {
+        OrderedEncoder encoder(threads);
+        REQUIRE(encoder.threadCount() == threads);
+        std::vector<std::string> out;
+        std::string result;
+        for (int i = 0; i < 200; ++i) {
+            encoder.submit([i] {
+                // Early jobs take longest, so they finish out of order
+                if (i % 7 == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+                return std::to_string(i);
+            });
+            if (encoder.pending() >= encoder.window() && encoder.next(result)) {
+                out.push_back(result);
+            }
+        }
+        while (encoder.next(result)) out.push_back(result);
+
+        REQUIRE(out.size() == 200);
+        for (int i = 0; i < 200; ++i) REQUIRE(out[i] == std::to_string(i));
+        REQUIRE_FALSE(encoder.next(result));
+    }
+}
+
+TEST_CASE("Parallel export matches single-threaded output", "[export_pipeline]") {
+    TempDirGuard guard("wordproc_pipeline_test");
+    TextBuffer buffer;
+    buffer.setText(longText(600));
+    ParagraphFormat heading;
+    heading.style = ParagraphStyle::Heading1;
+    buffer.setLineFormat(0, heading);
+    ParagraphFormat broken;
+    broken.hasPageBreakBefore = true;
+    buffer.setLineFormat(300, broken);
+    DocumentSettings settings;
+    settings.textStyle.font = "Garamond";
+
+    SECTION("PDF") {
+        PdfExportOptions single;
+        single.threadCount = 1;
+        PdfExportOptions parallel;
+        parallel.threadCount = 4;
+        ExportProgress progress;
+        parallel.progress = &progress;
+
+        REQUIRE(exportDocumentPdf(buffer, settings, guard.path("single.pdf"), single).success);
+        REQUIRE(exportDocumentPdf(buffer, settings, guard.path("parallel.pdf"), parallel).success);
+        std::string pdf = readBytes(guard.path("parallel.pdf"));
+        REQUIRE(pdf == readBytes(guard.path("single.pdf")));
+        REQUIRE(progress.rowsDone.load() == buffer.lineCount());
+        REQUIRE(progress.rowsTotal.load() == buffer.lineCount());
+        REQUIRE(progress.pagesWritten.load() == countOf(pdf, "/Type /Page "));
+        REQUIRE(progress.fraction() == 1.0);
+    }
+
+    SECTION("HTML") {
+        ExportOptions single;
+        single.threadCount = 1;
+        ExportOptions parallel;
+        parallel.threadCount = 4;
+        REQUIRE(exportDocumentHtml(buffer, settings, guard.path("single.html"), single).success);
+        REQUIRE(
+            exportDocumentHtml(buffer, settings, guard.path("parallel.html"), parallel).success);
+        std::string html = readBytes(guard.path("parallel.html"));
+        REQUIRE(html == readBytes(guard.path("single.html")));
+        REQUIRE(html.find("&lt;markup&gt; &amp;") != std::string::npos);
+    }
+}
+
+TEST_CASE("Cancelled export leaves no file", "[export_pipeline]") {
+    TempDirGuard guard("wordproc_pipeline_test");
+    TextBuffer buffer;
+    buffer.setText(longText(2000));
+    DocumentSettings settings;
+    ExportProgress progress;
+    progress.cancel();
+
+    PdfExportOptions pdfOptions;
+    pdfOptions.progress = &progress;
+    DocumentResult pdf = exportDocumentPdf(buffer, settings, guard.path("c.pdf"), pdfOptions);
+    REQUIRE_FALSE(pdf.success);
+    REQUIRE(pdf.error == "Export cancelled");
+    REQUIRE_FALSE(std::filesystem::exists(guard.path("c.pdf")));
+
+    ExportOptions htmlOptions;
+    htmlOptions.progress = &progress;
+    DocumentResult html = exportDocumentHtml(buffer, settings, guard.path("c.html"), htmlOptions);
+    REQUIRE_FALSE(html.success);
+    REQUIRE(html.error == "Export cancelled");
+    REQUIRE_FALSE(std::filesystem::exists(guard.path("c.html")));
+}
+
+TEST_CASE("BackgroundExporter exports a snapshot off the calling thread", "[export_pipeline]") {
+    TempDirGuard guard("wordproc_pipeline_test");
+    TextBuffer buffer;
+    buffer.setText(longText(400));
+    ParagraphFormat title;
+    title.style = ParagraphStyle::Title;
+    buffer.setLineFormat(0, title);
+    DocumentSettings settings;
+
+    BackgroundExporter exporter;
+    std::string path = guard.path("background.pdf");
+    REQUIRE(exporter.start(buffer, path,
+                           [&settings, &path](const TextBuffer& snapshot, ExportProgress& progress) {
+                               PdfExportOptions options;
+                               options.progress = &progress;
+                               return exportDocumentPdf(snapshot, settings, path, options);
+                           }));
+    // Edits after start() do not reach the export
+    buffer.setText("Replaced");
+
+    while (exporter.isRunning()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::optional<DocumentResult> result = exporter.takeResult();
+    REQUIRE(result.has_value());
+    REQUIRE(result->success);
+    REQUIRE_FALSE(exporter.takeResult().has_value());
+    REQUIRE(exporter.progress().rowsDone.load() == 401);
+    std::string pdf = readBytes(path);
+    REQUIRE(countOf(pdf, "/Type /Page ") > 1);
+
+    // A second export can start once the first is done
+    std::string second = guard.path("second.html");
+    REQUIRE(exporter.start(buffer, second,
+                           [&settings, &second](const TextBuffer& snapshot, ExportProgress&) {
+                               return exportDocumentHtml(snapshot, settings, second);
+                           }));
+    while (exporter.isRunning()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    REQUIRE(exporter.takeResult()->success);
+    REQUIRE(readBytes(second).find("Replaced") != std::string::npos);
+}
+
+TEST_CASE("Export throughput benchmark - public domain corpus",
+          "[export_pipeline][benchmark]") {
+    TempDirGuard guard("wordproc_pipeline_test");
+    DocumentSettings settings;
+    settings.textStyle.font = "Garamond";
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator("test_files/public_domain")) {
+        if (entry.path().extension() == ".txt") files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+    REQUIRE_FALSE(files.empty());
+
+    std::printf("\n=== Export Throughput Benchmark ===\n");
+    std::printf("  %-28s %6s %12s %12s\n", "File", "Pages", "1 thread", "All threads");
+    double totalPages = 0.0, seconds1 = 0.0, secondsN = 0.0;
+    for (const auto& file : files) {
+        TextBuffer buffer;
+        DocumentResult loaded = loadTextFileEx(buffer, file.string());
+        REQUIRE(loaded.success);
+
+        double seconds[2] = {0.0, 0.0};
+        std::size_t pages = 0;
+        for (int run = 0; run < 2; ++run) {
+            PdfExportOptions options;
+            options.threadCount = run == 0 ? 1 : 0;
+            ExportProgress progress;
+            options.progress = &progress;
+            auto start = std::chrono::high_resolution_clock::now();
+            REQUIRE(exportDocumentPdf(buffer, settings, guard.path("bench.pdf"), options).success);
+            seconds[run] = std::chrono::duration<double>(
+                               std::chrono::high_resolution_clock::now() - start)
+                               .count();
+            pages = progress.pagesWritten.load();
+        }
+        std::printf("  %-28s %6zu %8.0f p/s %8.0f p/s\n", file.filename().string().c_str(),
+                    pages, static_cast<double>(pages) / seconds[0],
+                    static_cast<double>(pages) / seconds[1]);
+        totalPages += static_cast<double>(pages);
+        seconds1 += seconds[0];
+        secondsN += seconds[1];
+    }
+    std::printf("  %-28s %6.0f %8.0f p/s %8.0f p/s (%u threads)\n", "Total", totalPages,
+                totalPages / seconds1, totalPages / secondsN, std::thread::hardware_concurrency());
+}
@@ -0,0 +1,280 @@
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include "../src/editor/document_io.h"
+#include "../src/editor/find_in_files.h"
+#include "../src/editor/json_scan.h"
+#include "catch2/catch.hpp"
+#include "test_helpers.h"
+
+TEST_CASE("json_scan decodes strings and walks members", "[find_in_files][json_scan]") {
+    SECTION("decodeString handles escapes and unicode") {
+        std::string json = R"("a\"b\\c\né😀")";
+        std::string out;
+        REQUIRE(json_scan::decodeString(json, 0, out) == json.size());
+        REQUIRE(out == "a\"b\\c\n\xC3\xA9\xF0\x9F\x98\x80");
+    }
+
+    SECTION("decodeString rejects truncated input") {
+        std::string out;
+        REQUIRE(json_scan::decodeString(R"("unterminated)", 0, out) == json_scan::npos);
+        REQUIRE(json_scan::decodeString(R"("bad \x escape")", 0, out) == json_scan::npos);
+    }
+
+    SECTION("decodeString can write into caller storage") {
+        std::string json = R"("tab\there \u00e9\ud83d\ude00 end")";
+        std::string storage(json.size(), '\0');
+        std::size_t written = 0;
+        REQUIRE(json_scan::decodeString(json, 0, storage.data(), written) == json.size());
+        storage.resize(written);
+        REQUIRE(storage == "tab\there \xC3\xA9\xF0\x9F\x98\x80 end");
+    }
+
+    SECTION("forEachElementAt visits array elements") {
+        std::string json = R"([1, "two", {"three": [3]}, []])";
+        std::vector<std::string> elements;
+        REQUIRE(json_scan::forEachElementAt(json, 0, [&](std::size_t b, std::size_t e) {
+            elements.push_back(json.substr(b, e - b));
+            return true;
+        }));
+        REQUIRE(elements == std::vector<std::string>{"1", "\"two\"", R"({"three": [3]})", "[]"});
+        REQUIRE_FALSE(json_scan::forEachElementAt("[1, 2", 0, [](std::size_t, std::size_t) {
+            return true;
+        }));
+    }
+
+    SECTION("findMember skips nested values") {
+        std::string json =
+            R"({"style": {"text": "nested"}, "list": [1, "]", {"a": 2}], "text": "top"})";
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        REQUIRE(json_scan::findMember(json, "text", begin, end));
+        REQUIRE(json.substr(begin, end - begin) == "\"top\"");
+        REQUIRE_FALSE(json_scan::findMember(json, "missing", begin, end));
+    }
+
+    SECTION("malformed objects are reported") {
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        REQUIRE_FALSE(json_scan::findMember(R"({"text": )", "text", begin, end));
+        REQUIRE_FALSE(json_scan::findMember("not json", "text", begin, end));
+    }
+}
+
+TEST_CASE("extractSearchableText reads the wpdoc text field", "[find_in_files]") {
+    TempDirGuard guard("wordproc_find_test");
+    TextBuffer buffer;
+    buffer.setText("Chapter One\nThe \"quick\" fox\tjumps");
+    std::string path = (guard.dir / "chapter.wpdoc").string();
+    REQUIRE(saveTextFile(buffer, path));
+
+    std::ifstream in(path, std::ios::binary);
+    std::string raw((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::string scratch;
+    REQUIRE(extractSearchableText(path, raw, scratch) == buffer.getText());
+
+    SECTION("plain text is returned without copying") {
+        std::string text = "plain";
+        std::string unused;
+        auto view = extractSearchableText("notes.txt", text, unused);
+        REQUIRE(view.data() == text.data());
+    }
+
+    SECTION("malformed wpdoc falls back to raw bytes") {
+        std::string broken = R"({"text": "abc)";
+        std::string unused;
+        REQUIRE(extractSearchableText("broken.wpdoc", broken, unused) == broken);
+    }
+}
+
+TEST_CASE("searchText honours find options", "[find_in_files]") {
+    std::vector<std::size_t> offsets;
+    auto collect = [&](std::size_t offset, std::size_t) { offsets.push_back(offset); };
+
+    SECTION("case insensitive by default") {
+        FindOptions options;
+        REQUIRE(searchText("Cat cat CAT", "cat", options, 100, collect) == 3);
+        REQUIRE(offsets == std::vector<std::size_t>{0, 4, 8});
+    }
+
+    SECTION("case sensitive") {
+        FindOptions options;
+        options.caseSensitive = true;
+        REQUIRE(searchText("Cat cat CAT", "cat", options, 100, collect) == 1);
+        REQUIRE(offsets == std::vector<std::size_t>{4});
+    }
+
+    SECTION("whole word") {
+        FindOptions options;
+        options.wholeWord = true;
+        REQUIRE(searchText("cat concat cats cat", "cat", options, 100, collect) == 2);
+        REQUIRE(offsets == std::vector<std::size_t>{0, 16});
+    }
+
+    SECTION("regex") {
+        FindOptions options;
+        options.useRegex = true;
+        REQUIRE(searchText("a1 b22 c333", "[0-9]+", options, 100, collect) == 3);
+        REQUIRE(offsets == std::vector<std::size_t>{1, 4, 8});
+    }
+
+    SECTION("match cap") {
+        FindOptions options;
+        REQUIRE(searchText("aaaaaa", "a", options, 2, collect) == 2);
+    }
+
+    SECTION("agrees with TextBuffer::findAll") {
+        TextBuffer buffer;
+        buffer.setText("the cat sat on the mat\nthe end, theatre");
+        FindOptions options;
+        std::size_t count =
+            searchText(buffer.getText(), "the", options, 1000, collect);
+        REQUIRE(count == buffer.findAll("the", options).size());
+    }
+}
+
+TEST_CASE("SearchPattern compiles once and reports bad patterns", "[find_in_files]") {
+    FindOptions options;
+    options.useRegex = true;
+    SearchPattern pattern("[0-9]+", options);
+    REQUIRE(pattern.valid());
+    std::size_t count = 0;
+    auto collect = [&](std::size_t, std::size_t) { ++count; };
+    REQUIRE(pattern.search("a1 b22", 100, collect) == 2);
+    REQUIRE(pattern.search("c333", 100, collect) == 1);  // Same compiled expression
+    REQUIRE(count == 3);
+
+    REQUIRE_FALSE(SearchPattern("([", options).valid());
+    REQUIRE_FALSE(SearchPattern("([", options).error().empty());
+    REQUIRE_FALSE(SearchPattern("", FindOptions{}).valid());
+}
+
+TEST_CASE("searchFile reports line, column and preview", "[find_in_files]") {
+    TempDirGuard guard("wordproc_find_test");
+    std::string path = guard.write("notes.txt", "first line\nsecond needle here\n\nneedle");
+
+    auto matches = searchFile(path, "needle");
+    REQUIRE(matches.size() == 2);
+    REQUIRE(matches[0].line == 1);
+    REQUIRE(matches[0].column == 7);
+    REQUIRE(matches[0].preview == "second needle here");
+    REQUIRE(matches[1].line == 3);
+    REQUIRE(matches[1].column == 0);
+    REQUIRE(matches[1].offset == 31);
+}
+
+TEST_CASE("findInFiles searches a folder in parallel", "[find_in_files]") {
+    TempDirGuard guard("wordproc_find_test");
+    for (int i = 0; i < 24; ++i) {
+        TextBuffer buffer;
+        buffer.setText("Chapter " + std::to_string(i) + "\nThe dragon " +
+                       (i % 3 == 0 ? "awoke" : "slept") + ".");
+        REQUIRE(saveTextFile(buffer, (guard.dir / ("ch" + std::to_string(i) + ".wpdoc")).string()));
+    }
+    guard.write("notes/outline.txt", "The dragon awoke in chapter zero");
+    guard.write("ignored.bin", "dragon awoke");
+
+    FindInFilesOptions options;
+    options.threadCount = 4;
+    FindInFilesStats stats;
+    auto matches = findInFiles(guard.dir.string(), "awoke", options, &stats);
+
+    REQUIRE(stats.filesTotal == 25);
+    REQUIRE(stats.filesSearched == 25);
+    REQUIRE(stats.matches == 9);
+    REQUIRE(matches.size() == 9);
+    REQUIRE(std::is_sorted(matches.begin(), matches.end(),
+                           [](const FileMatch& a, const FileMatch& b) { return a.path < b.path; }));
+    for (const auto& match : matches) {
+        REQUIRE(match.preview.find("awoke") != std::string::npos);
+    }
+
+    SECTION("non-recursive search skips subfolders") {
+        options.recursive = false;
+        REQUIRE(findInFiles(guard.dir.string(), "awoke", options).size() == 8);
+    }
+}
+
+TEST_CASE("FindInFiles streams results and can be cancelled", "[find_in_files]") {
+    TempDirGuard guard("wordproc_find_test");
+    std::vector<std::string> files;
+    for (int i = 0; i < 16; ++i) {
+        files.push_back(guard.write("f" + std::to_string(i) + ".txt", "alpha beta alpha"));
+    }
+
+    SECTION("callback and drain see every match") {
+        FindInFiles search;
+        std::atomic<std::size_t> streamed{0};
+        search.setFileResultCallback(
+            [&](const std::vector<FileMatch>& matches) { streamed += matches.size(); });
+        REQUIRE(search.startFiles(files, "alpha"));
+        search.wait();
+        REQUIRE_FALSE(search.isRunning());
+
+        std::vector<FileMatch> drained;
+        REQUIRE(search.drainResults(drained) == 32);
+        REQUIRE(streamed == 32);
+        REQUIRE(search.drainResults(drained) == 0);
+    }
+
+    SECTION("a folder is listed on the search thread") {
+        FindInFiles search;
+        REQUIRE(search.start(guard.dir.string(), "beta"));
+        search.wait();
+        REQUIRE(search.stats().filesTotal == files.size());
+        REQUIRE(search.stats().filesSearched == files.size());
+
+        std::vector<FileMatch> drained;
+        REQUIRE(search.drainResults(drained) == files.size());
+
+        // A missing folder finishes with nothing found rather than failing
+        REQUIRE(search.start((guard.dir / "missing").string(), "beta"));
+        search.wait();
+        REQUIRE_FALSE(search.isRunning());
+        REQUIRE(search.stats().filesTotal == 0);
+    }
+
+    SECTION("invalid regex is rejected up front") {
+        FindInFiles search;
+        FindInFilesOptions options;
+        options.find.useRegex = true;
+        REQUIRE_FALSE(search.startFiles(files, "([", options));
+        REQUIRE_FALSE(search.error().empty());
+    }
+
+    SECTION("starting again replaces a running search") {
+        FindInFiles search;
+        FindInFilesOptions options;
+        options.threadCount = 2;
+        std::atomic<bool> slow{true};
+        search.setFileResultCallback([&](const std::vector<FileMatch>&) {
+            if (slow) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        });
+        REQUIRE(search.startFiles(files, "alpha", options));
+        REQUIRE(search.isRunning());
+        slow = false;
+        REQUIRE(search.startFiles(files, "beta", options));
+        search.wait();
+
+        // Only the second search's hits and counts are reported
+        std::vector<FileMatch> drained;
+        REQUIRE(search.drainResults(drained) == files.size());
+        for (const FileMatch& match : drained) REQUIRE(match.length == 4);
+        REQUIRE(search.stats().filesSearched == files.size());
+        REQUIRE_FALSE(search.wasCancelled());
+    }
+
+    SECTION("cancel stops remaining files") {
+        FindInFiles search;
+        FindInFilesOptions options;
+        options.threadCount = 1;
+        search.setFileResultCallback([&](const std::vector<FileMatch>&) { search.cancel(); });
+        REQUIRE(search.startFiles(files, "alpha", options));
+        search.wait();
+        REQUIRE(search.wasCancelled());
+        REQUIRE(search.stats().filesSearched < files.size());
+    }
+}
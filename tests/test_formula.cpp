@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "../src/editor/document_io.h"
+#include "../src/editor/formula.h"
+#include "../src/editor/table.h"
+#include "catch2/catch.hpp"
+
+namespace {
+
+// Fixed grid of cell texts for evaluating programs directly
+class GridCells : public formula::Cells {
+   public:
+    GridCells(std::size_t rows, std::size_t cols) : cols_(cols), text_(rows * cols) {}
+    void set(std::size_t row, std::size_t col, std::string text) {
+        text_[row * cols_ + col] = std::move(text);
+    }
+    std::size_t rowCount() const override { return text_.size() / cols_; }
+    std::size_t colCount() const override { return cols_; }
+    formula::Value value(std::size_t row, std::size_t col) const override {
+        return formula::valueOfText(text_[row * cols_ + col]);
+    }
+
+   private:
+    std::size_t cols_;
+    std::vector<std::string> text_;
+};
+
+formula::Value run(const std::string& source, const formula::Cells& cells) {
+    formula::Program program;
+    program.compile(source);
+    return program.evaluate(cells);
+}
+
+std::string show(const std::string& source, const formula::Cells& cells) {
+    return formula::format(run(source, cells));
+}
+
+}  // namespace
+
+TEST_CASE("Formula arithmetic and functions", "[formula]") {
+    GridCells cells(4, 3);
+    cells.set(0, 0, "1");
+    cells.set(1, 0, "2");
+    cells.set(2, 0, "3.5");
+    cells.set(3, 0, "note");
+    cells.set(0, 1, "10");
+
+    SECTION("operators and precedence") {
+        REQUIRE(show("=1+2*3", cells) == "7");
+        REQUIRE(show("=(1+2)*3", cells) == "9");
+        REQUIRE(show("=2^3^2", cells) == "512");
+        REQUIRE(show("=-A1+B1/4", cells) == "1.5");
+        REQUIRE(show("= 0.1 + 0.2", cells) == "0.3");
+        REQUIRE(show("=-0*1", cells) == "0");
+    }
+
+    SECTION("references, with and without $") {
+        REQUIRE(show("=a1+$B$1", cells) == "11");
+        REQUIRE(show("=C1", cells) == "");  // Blank cell
+        REQUIRE(show("=C1+1", cells) == "1");
+    }
+
+    SECTION("aggregates skip blank and text cells") {
+        REQUIRE(show("=SUM(A1:A4)", cells) == "6.5");
+        REQUIRE(show("=sum(A4:A1, 1)", cells) == "7.5");
+        REQUIRE(show("=COUNT(A1:C4)", cells) == "4");
+        REQUIRE(show("=AVERAGE(A1:A2)", cells) == "1.5");
+        REQUIRE(show("=MIN(A1:B4)", cells) == "1");
+        REQUIRE(show("=MAX(A1:B4)", cells) == "10");
+        REQUIRE(show("=PRODUCT(A1:A3)", cells) == "7");
+        REQUIRE(show("=ABS(-2)", cells) == "2");
+        REQUIRE(show("=ROUND(2.345; 2)", cells) == "2.35");
+        REQUIRE(show("=ROUND(1234, -2)", cells) == "1200");
+    }
+
+    SECTION("errors") {
+        REQUIRE(show("=1/0", cells) == "#DIV/0!");
+        REQUIRE(show("=A4*2", cells) == "#VALUE!");
+        REQUIRE(show("=AVERAGE(C1:C4)", cells) == "#DIV/0!");
+        REQUIRE(show("=Z99", cells) == "#REF!");
+        REQUIRE(show("=SUM(A1:A99)", cells) == "#REF!");
+        REQUIRE(show("=FOO(1)", cells) == "#NAME?");
+        REQUIRE(show("=1+", cells) == "#ERROR!");
+        REQUIRE(show("=(1", cells) == "#ERROR!");
+        REQUIRE(show("=A1:A2", cells) == "#ERROR!");
+        REQUIRE(show("=ABS(1, 2)", cells) == "#ERROR!");
+    }
+
+    SECTION("compile reports why it failed") {
+        formula::Program program;
+        std::string message;
+        REQUIRE_FALSE(program.compile("=SUM(A1", &message));
+        REQUIRE(message == "Missing ')'");
+        REQUIRE(program.compile("=SUM(A1:B2)+C3"));
+        REQUIRE(program.references().size() == 2);
+        REQUIRE(program.references()[0].lastCol == 1);
+    }
+
+    SECTION("values round trip through their text") {
+        REQUIRE(formula::valueOfText("#DIV/0!").error == formula::Error::DivideByZero);
+        REQUIRE(formula::valueOfText(" 42 ").number == 42.0);
+        REQUIRE(formula::valueOfText("42 apples").kind == formula::Value::Kind::Text);
+        REQUIRE(formula::valueOfText("").kind == formula::Value::Kind::Blank);
+    }
+}
+
+TEST_CASE("Formula references shift with rows and columns", "[formula]") {
+    auto shifted = [](std::string source, formula::Shift shift) {
+        formula::Program program;
+        program.compile(source);
+        program.shift(shift, source);
+        return source;
+    };
+    formula::Shift insertRow{true, 2, 1};
+    formula::Shift deleteRow{true, 2, -1};
+    formula::Shift deleteCol{false, 0, -1};
+
+    REQUIRE(shifted("=A1+A3", insertRow) == "=A1+A4");
+    REQUIRE(shifted("=SUM(B2:B40)", insertRow) == "=SUM(B2:B41)");
+    REQUIRE(shifted("= sum( $B$3 : C10 ) *2", insertRow) == "= sum( $B$4:C11 ) *2");
+    REQUIRE(shifted("=SUM(A10:A1)", deleteRow) == "=SUM(A9:A1)");  // Written ends kept
+    REQUIRE(shifted("=A3*2", deleteRow) == "=#REF!*2");
+    REQUIRE(shifted("=SUM(A3:B3)+A4", deleteRow) == "=SUM(#REF!)+A3");
+    REQUIRE(shifted("=SUM(A1:C1)", deleteCol) == "=SUM(A1:B1)");
+    REQUIRE(shifted("=A1+1", deleteCol) == "=#REF!+1");
+    REQUIRE(shifted("=AB7", {false, 0, 1}) == "=AC7");
+    REQUIRE(shifted("=Z1", {false, 0, 1}) == "=AA1");
+
+    formula::Program program;
+    std::string source = "=A1+B1";
+    program.compile(source);
+    REQUIRE_FALSE(program.shift(insertRow, source));  // Nothing below row 2
+    REQUIRE(source == "=A1+B1");
+
+    GridCells cells(2, 2);
+    REQUIRE(show("=#REF!+1", cells) == "#REF!");
+    REQUIRE(show("=SUM(1, #ref!)", cells) == "#REF!");
+}
+
+TEST_CASE("Formula graph orders only dirty cells", "[formula]") {
+    // Cells of a 1x5 row: B = A+1, C = B+1, E = D+1
+    formula::Graph graph;
+    auto add = [&](std::size_t cell, const char* source) {
+        formula::Program program;
+        program.compile(source);
+        graph.set(cell, std::move(program), 1, 5);
+    };
+    add(1, "=A1+1");
+    add(2, "=B1+1");
+    add(4, "=D1+1");
+
+    std::vector<std::size_t> order;
+    std::vector<std::size_t> cyclic;
+    graph.dirtyOrder({0}, order, cyclic);
+    REQUIRE(order == std::vector<std::size_t>{1, 2});
+    REQUIRE(cyclic.empty());
+
+    graph.dirtyOrder({3}, order, cyclic);
+    REQUIRE(order == std::vector<std::size_t>{4});
+
+    graph.fullOrder(order, cyclic);
+    REQUIRE(order.size() == 3);
+    REQUIRE(std::find(order.begin(), order.end(), 1) <
+            std::find(order.begin(), order.end(), 2));
+
+    graph.erase(1);
+    graph.dirtyOrder({0}, order, cyclic);
+    REQUIRE(order.empty());
+}
+
+TEST_CASE("Table formulas recalculate on edit", "[formula][table]") {
+    Table table(4, 2);
+    table.setCellContent(0, 0, "10");
+    table.setCellContent(1, 0, "20");
+    table.setCellContent(2, 0, "30");
+    table.setCellContent(3, 0, "=SUM(A1:A3)");
+    table.setCellContent(3, 1, "=A4*1.2");
+
+    REQUIRE(table.hasFormulas());
+    REQUIRE(table.getCellContent(3, 0) == "60");
+    REQUIRE(table.getCellContent(3, 1) == "72");
+    REQUIRE(table.cell(3, 0).formula == "=SUM(A1:A3)");
+
+    SECTION("editing an input updates the chain") {
+        table.setCellContent(1, 0, "25");
+        REQUIRE(table.getCellContent(3, 0) == "65");
+        REQUIRE(table.getCellContent(3, 1) == "78");
+    }
+
+    SECTION("replacing a formula with text drops it") {
+        table.setCellContent(3, 0, "total");
+        REQUIRE(table.cell(3, 0).formula.empty());
+        REQUIRE(table.getCellContent(3, 1) == "#VALUE!");
+    }
+
+    SECTION("circular references are reported") {
+        table.setCellContent(0, 1, "=B2");
+        table.setCellContent(1, 1, "=B1+A1");
+        REQUIRE(table.getCellContent(0, 1) == "#CYCLE!");
+        REQUIRE(table.getCellContent(1, 1) == "#CYCLE!");
+        table.setCellContent(0, 1, "5");
+        REQUIRE(table.getCellContent(1, 1) == "15");
+    }
+
+    SECTION("formulas and their references follow inserted rows") {
+        table.insertRowAbove(0);
+        REQUIRE(table.cell(4, 0).formula == "=SUM(A2:A4)");
+        REQUIRE(table.getCellContent(4, 0) == "60");
+        REQUIRE(table.cell(4, 1).formula == "=A5*1.2");
+        REQUIRE(table.getCellContent(4, 1) == "72");
+    }
+
+    SECTION("a row inserted inside a range joins it") {
+        table.insertRowBelow(1);
+        table.setCellContent(2, 0, "5");
+        REQUIRE(table.cell(4, 0).formula == "=SUM(A1:A4)");
+        REQUIRE(table.getCellContent(4, 0) == "65");
+        REQUIRE(table.getCellContent(4, 1) == "78");
+    }
+
+    SECTION("deleting rows shrinks ranges and breaks single references") {
+        table.setCellContent(0, 1, "=A2+1");
+        table.deleteRow(1);
+        REQUIRE(table.cell(2, 0).formula == "=SUM(A1:A2)");
+        REQUIRE(table.getCellContent(2, 0) == "40");
+        REQUIRE(table.cell(2, 1).formula == "=A3*1.2");
+        REQUIRE(table.getCellContent(2, 1) == "48");
+        REQUIRE(table.cell(0, 1).formula == "=#REF!+1");
+        REQUIRE(table.getCellContent(0, 1) == "#REF!");
+    }
+
+    SECTION("columns move references the same way") {
+        table.insertColumnLeft(0);
+        REQUIRE(table.cell(3, 1).formula == "=SUM(B1:B3)");
+        REQUIRE(table.cell(3, 2).formula == "=B4*1.2");
+        REQUIRE(table.getCellContent(3, 2) == "72");
+        table.deleteColumn(1);
+        REQUIRE(table.cell(3, 1).formula == "=#REF!*1.2");
+        REQUIRE(table.getCellContent(3, 1) == "#REF!");
+    }
+
+    SECTION("merging covered formula cells removes them") {
+        table.mergeCells({3, 0}, {3, 1});
+        REQUIRE(table.cell(3, 1).formula.empty());
+        REQUIRE(table.cell(3, 0).formula.empty());  // Joined text replaced the value
+        REQUIRE(table.getCellContent(3, 0) == "60 72");
+    }
+}
+
+TEST_CASE("Table formulas are saved with their values", "[formula][document_io]") {
+    auto dir = std::filesystem::temp_directory_path() / "wordproc_formula_test";
+    std::filesystem::create_directories(dir);
+    std::string path = (dir / "budget.wpdoc").string();
+
+    Table table(3, 1);
+    table.setCellContent(0, 0, "4");
+    table.setCellContent(1, 0, "6");
+    table.setCellContent(2, 0, "=A1*A2");
+    TableList tables;
+    tables.emplace_back(0, table);
+    TextBuffer buffer;
+    buffer.setText("Budget\n");
+    REQUIRE(saveDocumentWithTables(buffer, DocumentSettings{}, tables, path).success);
+
+    TextBuffer loaded;
+    DocumentSettings settings;
+    TableList loadedTables;
+    REQUIRE(loadDocumentWithTables(loaded, settings, loadedTables, path).success);
+    REQUIRE(loadedTables.size() == 1);
+    Table& copy = loadedTables[0].second;
+    REQUIRE(copy.cell(2, 0).formula == "=A1*A2");
+    REQUIRE(copy.getCellContent(2, 0) == "24");
+    REQUIRE(copy.hasFormulas());
+
+    // The loaded formula is live again
+    copy.setCellContent(0, 0, "5");
+    REQUIRE(copy.getCellContent(2, 0) == "30");
+
+    std::error_code ec;
+    std::filesystem::remove_all(dir, ec);
+}
+
+TEST_CASE("Table formula recalculation benchmark", "[formula][table][benchmark]") {
+    // 10k cells: 2000 rows of quantity, price, line total (=A*B), running
+    // total (=D(previous)+C) and running average, plus a grand total row
+    constexpr std::size_t ROWS = 2000;
+    Table table(ROWS + 1, 5);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (std::size_t r = 0; r < ROWS; ++r) {
+        std::string n = std::to_string(r + 1);
+        table.setCellContent(r, 0, std::to_string(r % 7 + 1));
+        table.setCellContent(r, 1, std::to_string(r % 13 + 1) + ".25");
+        table.setCellContent(r, 2, "=A" + n + "*B" + n);
+        table.setCellContent(r, 3, r == 0 ? "=C1" : "=D" + std::to_string(r) + "+C" + n);
+        table.setCellContent(r, 4, "=D" + n + "/" + n);
+    }
+    table.setCellContent(ROWS, 2, "=SUM(C1:C" + std::to_string(ROWS) + ")");
+    auto built = std::chrono::high_resolution_clock::now();
+
+    table.recalculate();
+    auto full = std::chrono::high_resolution_clock::now();
+    std::string total = table.getCellContent(ROWS, 2);
+    REQUIRE(total == table.getCellContent(ROWS - 1, 3));
+
+    // An edit near the bottom only touches the rows below it
+    table.setCellContent(ROWS - 10, 0, "100");
+    auto late = std::chrono::high_resolution_clock::now();
+    REQUIRE(table.getCellContent(ROWS, 2) != total);
+
+    // An edit at the top ripples down the whole running total
+    table.setCellContent(0, 0, "100");
+    auto early = std::chrono::high_resolution_clock::now();
+    REQUIRE(table.getCellContent(ROWS, 2) == table.getCellContent(ROWS - 1, 3));
+
+    auto ms = [](auto a, auto b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+    std::printf("\n=== Formula Recalculation Benchmark ===\n");
+    std::printf("  %zu cells, %zu formulas\n", (ROWS + 1) * 5, ROWS * 3 + 1);
+    std::printf("  Enter all cells: %.2f ms\n", ms(start, built));
+    std::printf("  Full recalculation: %.2f ms\n", ms(built, full));
+    std::printf("  Edit near the end: %.3f ms\n", ms(full, late));
+    std::printf("  Edit at the top: %.2f ms\n", ms(late, early));
+    REQUIRE(ms(full, late) < ms(built, full));
+    REQUIRE(ms(built, full) < 2000.0);
+}
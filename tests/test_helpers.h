@@ -0,0 +1,71 @@
+#pragma once
+
+// Helpers shared by the test files
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+#include "../src/editor/text_buffer.h"
+
+// A scratch directory under the system temp directory, emptied when the
+// guard is made and removed with its contents when it goes. Each test file
+// uses its own name so files running in one process do not collide.
+struct TempDirGuard {
+    std::filesystem::path dir;
+
+    explicit TempDirGuard(const std::string& name)
+        : dir(std::filesystem::temp_directory_path() / name) {
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+        std::filesystem::create_directories(dir);
+    }
+    ~TempDirGuard() {
+        std::error_code ec;
+        std::filesystem::remove_all(dir, ec);
+    }
+    TempDirGuard(const TempDirGuard&) = delete;
+    TempDirGuard& operator=(const TempDirGuard&) = delete;
+
+    std::string path(const std::string& name) const { return (dir / name).string(); }
+
+    // Write contents to name, creating its directories; returns its path
+    std::string write(const std::string& name, const std::string& contents) const {
+        std::filesystem::path file = dir / name;
+        std::filesystem::create_directories(file.parent_path());
+        std::ofstream(file, std::ios::binary) << contents;
+        return file.string();
+    }
+};
+
+inline std::string readBytes(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+inline void writeBytes(const std::string& path, const std::string& bytes) {
+    std::ofstream(path, std::ios::binary) << bytes;
+}
+
+// Occurrences of needle in text, overlapping ones included
+inline std::size_t countOf(const std::string& text, const std::string& needle) {
+    std::size_t count = 0;
+    for (std::size_t pos = text.find(needle); pos != std::string::npos;
+         pos = text.find(needle, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+inline ParagraphFormat listItem(ListType type, int level, int number = 1) {
+    ParagraphFormat format;
+    format.listType = type;
+    format.listLevel = level;
+    format.listNumber = number;
+    return format;
+}
@@ -0,0 +1,183 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "../src/editor/export/export_html.h"
+#include "catch2/catch.hpp"
+#include "test_helpers.h"
+
+namespace {
+std::string body(const std::string& html) {
+    std::size_t start = html.find("<body>\n");
+    std::size_t end = html.find("</body>");
+    return html.substr(start + 7, end - start - 7);
+}
+}  // namespace
+
+TEST_CASE("HTML export writes paragraph structure", "[html_export]") {
+    TempDirGuard guard("wordproc_html_test");
+    DocumentSettings settings;
+    settings.textStyle.font = "Garamond";
+    settings.textStyle.fontSize = 20;
+
+    SECTION("headings, alignment and indents") {
+        TextBuffer buffer;
+        buffer.setText("My Book\nChapter <1>\nCentered & indented\n\nBody");
+        ParagraphFormat title;
+        title.style = ParagraphStyle::Title;
+        buffer.setLineFormat(0, title);
+        ParagraphFormat heading;
+        heading.style = ParagraphStyle::Heading2;
+        heading.hasPageBreakBefore = true;
+        buffer.setLineFormat(1, heading);
+        ParagraphFormat centered;
+        centered.alignment = TextAlignment::Center;
+        centered.leftIndent = 40;
+        centered.firstLineIndent = 12;
+        centered.spaceAfter = 8;
+        centered.lineSpacing = 1.5f;
+        buffer.setLineFormat(2, centered);
+
+        std::string path = guard.path("structure.html");
+        REQUIRE(exportDocumentHtml(buffer, settings, path).success);
+        std::string html = readBytes(path);
+        REQUIRE(html.find("font-family:'Garamond',serif;font-size:20px;") != std::string::npos);
+        REQUIRE(html.find("h2{font-size:30px;font-weight:bold;}") != std::string::npos);
+        REQUIRE(body(html) ==
+                "<h1 class=\"title\">My Book</h1>\n"
+                "<h2 style=\"page-break-before:always;\">Chapter &lt;1&gt;</h2>\n"
+                "<p style=\"text-align:center;margin-left:40px;text-indent:12px;"
+                "margin-bottom:8px;line-height:1.5;\">Centered &amp; indented</p>\n"
+                "<p><br></p>\n"
+                "<p>Body</p>\n");
+    }
+
+    SECTION("nested and numbered lists") {
+        TextBuffer buffer;
+        buffer.setText("Intro\none\ntwo\ntwo.a\ntwo.b\nthree\nfirst\nsecond\nOutro");
+        buffer.setLineFormat(1, listItem(ListType::Bulleted, 0));
+        buffer.setLineFormat(2, listItem(ListType::Bulleted, 0));
+        buffer.setLineFormat(3, listItem(ListType::Numbered, 1));
+        buffer.setLineFormat(4, listItem(ListType::Numbered, 1, 2));
+        buffer.setLineFormat(5, listItem(ListType::Bulleted, 0));
+        buffer.setLineFormat(6, listItem(ListType::Numbered, 0, 4));
+        buffer.setLineFormat(7, listItem(ListType::Numbered, 0, 5));
+
+        std::string path = guard.path("lists.html");
+        REQUIRE(exportDocumentHtml(buffer, settings, path).success);
+        REQUIRE(body(readBytes(path)) ==
+                "<p>Intro</p>\n"
+                "<ul><li>one</li>\n"
+                "<li>two<ol><li>two.a</li>\n"
+                "<li>two.b</li></ol>\n"
+                "</li>\n"
+                "<li>three</li></ul>\n"
+                "<ol start=\"4\"><li>first</li>\n"
+                "<li>second</li></ol>\n"
+                "<p>Outro</p>\n");
+    }
+
+    SECTION("a list still open at the end is closed") {
+        TextBuffer buffer;
+        buffer.setText("deep");
+        buffer.setLineFormat(0, listItem(ListType::Bulleted, 2));
+        std::string path = guard.path("open.html");
+        REQUIRE(exportDocumentHtml(buffer, settings, path).success);
+        REQUIRE(body(readBytes(path)) ==
+                "<ul><li class=\"nested\"><ul><li class=\"nested\"><ul><li>deep"
+                "</li></ul>\n</li></ul>\n</li></ul>\n");
+    }
+}
+
+TEST_CASE("HTML export writes links, bookmarks and tables", "[html_export]") {
+    TempDirGuard guard("wordproc_html_test");
+    DocumentSettings settings;
+    TextBuffer buffer;
+    buffer.setText("See the site for more\nJump back\nAfter the table");
+    REQUIRE(buffer.addHyperlinkAt(8, 12, "https://example.com/?a=1&b=2", "Home \"page\""));
+    REQUIRE(buffer.addHyperlinkAt(22, 26, "#top"));
+    // One link across a paragraph break becomes one per paragraph
+    REQUIRE(buffer.addHyperlinkAt(27, 41, "#end"));
+    REQUIRE(buffer.addBookmarkAt("top", 0));
+    REQUIRE(buffer.addBookmarkAt("mid", 10));
+    REQUIRE(buffer.addBookmarkAt("eol", 31));
+
+    TableList tables;
+    Table table(2, 3);
+    table.setCellContent(0, 0, "Name");
+    table.setCellContent(0, 1, "Notes <b>");
+    table.setCellContent(1, 0, "Two\nlines");
+    table.cell(1, 0).alignment = CellAlignment::MiddleCenter;
+    REQUIRE(table.mergeCells({0, 1}, {0, 2}));
+    tables.emplace_back(2, table);
+
+    std::string path = guard.path("anchors.html");
+    REQUIRE(exportDocumentHtml(buffer, settings, tables, path).success);
+    std::string html = body(readBytes(path));
+
+    REQUIRE(html.find("<p><span id=\"top\"></span>See the "
+                      "<a href=\"https://example.com/?a=1&amp;b=2\" "
+                      "title=\"Home &quot;page&quot;\">si<span id=\"mid\"></span>te</a>"
+                      " for more</p>\n") == 0);
+    REQUIRE(html.find("<p><a href=\"#top\">Jump</a> <a href=\"#end\">back</a>"
+                      "<span id=\"eol\"></span></p>\n") != std::string::npos);
+    REQUIRE(html.find("<p><a href=\"#end\">After the</a> table</p>") != std::string::npos);
+
+    // The table comes ahead of the paragraph at its line
+    std::size_t tableAt = html.find("<table>");
+    REQUIRE(tableAt != std::string::npos);
+    REQUIRE(tableAt < html.find("After the"));
+    REQUIRE(html.find("<col style=\"width:") != std::string::npos);
+    REQUIRE(html.find("colspan=\"2\"") != std::string::npos);
+    REQUIRE(html.find(">Notes &lt;b&gt;</td>") != std::string::npos);
+    REQUIRE(html.find("text-align:center;vertical-align:middle;\">Two<br>lines</td>") !=
+            std::string::npos);
+    // Covered cells are not written
+    std::size_t firstRow = html.find("<tr>");
+    std::size_t firstRowEnd = html.find("</tr>", firstRow);
+    std::string row = html.substr(firstRow, firstRowEnd - firstRow);
+    std::size_t cells = 0;
+    for (std::size_t pos = row.find("<td"); pos != std::string::npos;
+         pos = row.find("<td", pos + 1)) {
+        cells++;
+    }
+    REQUIRE(cells == 2);
+}
+
+TEST_CASE("HTML export benchmark - multi-MB document", "[html_export][benchmark]") {
+    TempDirGuard guard("wordproc_html_test");
+    TextBuffer buffer;
+    std::string text;
+    for (int i = 0; i < 60000; ++i) {
+        text += "Paragraph " + std::to_string(i) +
+                " has a <tag>, an & and enough plain words to be a typical line of prose.\n";
+    }
+    buffer.setText(text);
+    for (std::size_t row = 0; row < buffer.lineCount(); row += 50) {
+        ParagraphFormat heading;
+        heading.style = ParagraphStyle::Heading2;
+        buffer.setLineFormat(row, heading);
+        buffer.setLineFormat(row + 1, listItem(ListType::Numbered, 0));
+        buffer.setLineFormat(row + 2, listItem(ListType::Numbered, 1));
+    }
+    DocumentSettings settings;
+
+    std::string path = guard.path("big.html");
+    auto start = std::chrono::high_resolution_clock::now();
+    REQUIRE(exportDocumentHtml(buffer, settings, path).success);
+    auto end = std::chrono::high_resolution_clock::now();
+    std::uintmax_t bytes = std::filesystem::file_size(path);
+    REQUIRE(bytes > text.size());
+    std::string html = readBytes(path);
+    REQUIRE(html.rfind("</body>\n</html>\n") == html.size() - 16);
+
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    std::printf("\n=== HTML Export Benchmark ===\n");
+    std::printf("  Input:  %zu KB, %zu paragraphs\n", text.size() / 1024, buffer.lineCount());
+    std::printf("  Output: %ju KB\n", bytes / 1024);
+    std::printf("  Export: %.2f ms (%.1f MB/s)\n", ms,
+                static_cast<double>(bytes) / (1024.0 * 1024.0) / (ms / 1000.0));
+}
@@ -148,7 +148,7 @@ TEST_CASE("ImageCollection", "[image]") {
         
         auto atLine10 = coll.imagesAtLine(10);
         REQUIRE(atLine10.size() == 1);
-        REQUIRE(atLine10[0]->filename == "img3.png");
+        REQUIRE(atLine10[0].filename == "img3.png");
         
         auto atLine7 = coll.imagesAtLine(7);
         REQUIRE(atLine7.empty());
@@ -0,0 +1,224 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "../src/editor/image.h"
+#include "../src/editor/image_cache.h"
+#include "catch2/catch.hpp"
+
+namespace {
+// Stand-in for a PNG: width and height (16-bit little-endian), a shade,
+// then padding to make the file as big as asked
+std::vector<std::uint8_t> fakeImageFile(int width, int height, std::uint8_t shade,
+                                        std::size_t size = 5) {
+    std::vector<std::uint8_t> bytes = {
+        static_cast<std::uint8_t>(width & 0xFF), static_cast<std::uint8_t>(width >> 8),
+        static_cast<std::uint8_t>(height & 0xFF), static_cast<std::uint8_t>(height >> 8), shade};
+    bytes.resize(std::max<std::size_t>(size, bytes.size()), 0);
+    return bytes;
+}
+
+bool decodeFakeImage(const std::vector<std::uint8_t>& bytes, ImagePixels& out) {
+    if (bytes.size() < 5) return false;
+    out.width = bytes[0] | (bytes[1] << 8);
+    out.height = bytes[2] | (bytes[3] << 8);
+    out.rgba.assign(static_cast<std::size_t>(out.width) * out.height * 4, bytes[4]);
+    return true;
+}
+
+std::string fakeImageBase64(int width, int height, std::uint8_t shade, std::size_t size = 5) {
+    return encodeBase64(fakeImageFile(width, height, shade, size));
+}
+}  // namespace
+
+TEST_CASE("Base64 round trip", "[image_cache]") {
+    std::vector<std::uint8_t> bytes;
+    for (int i = 0; i < 256; ++i) bytes.push_back(static_cast<std::uint8_t>(i));
+    for (std::size_t length : {0, 1, 2, 3, 4, 5, 255, 256}) {
+        std::vector<std::uint8_t> part(bytes.begin(), bytes.begin() + length);
+        auto decoded = decodeBase64(encodeBase64(part));
+        REQUIRE(decoded);
+        REQUIRE(*decoded == part);
+    }
+    REQUIRE(encodeBase64({'H', 'i'}) == "SGk=");
+    auto wrapped = decodeBase64("SGVs\nbG8g V29y\r\nbGQ=");
+    REQUIRE(wrapped);
+    REQUIRE(std::string(wrapped->begin(), wrapped->end()) == "Hello World");
+    REQUIRE_FALSE(decodeBase64("SGk*"));
+    REQUIRE_FALSE(decodeBase64("SG=k"));
+}
+
+TEST_CASE("ImageCache decodes lazily and shares identical images", "[image_cache]") {
+    ImageCache cache;
+    int decoderCalls = 0;
+    cache.setDecoder([&decoderCalls](const std::vector<std::uint8_t>& bytes, ImagePixels& out) {
+        decoderCalls++;
+        return decodeFakeImage(bytes, out);
+    });
+
+    ImageCache::Key a = cache.add(fakeImageBase64(40, 30, 200));
+    ImageCache::Key b = cache.add(fakeImageBase64(40, 30, 200));
+    ImageCache::Key c = cache.add(fakeImageBase64(40, 30, 10));
+    REQUIRE(a != 0);
+    REQUIRE(a == b);
+    REQUIRE(a != c);
+    REQUIRE(cache.imageCount() == 2);
+    REQUIRE(decoderCalls == 0);  // Nothing drawn yet
+    REQUIRE(cache.add("not base64!") == 0);
+
+    const ImagePixels* pixels = cache.pixels(a);
+    REQUIRE(pixels);
+    REQUIRE(pixels->width == 40);
+    REQUIRE(pixels->rgba[0] == 200);
+    cache.pixels(a);
+    REQUIRE(decoderCalls == 1);
+
+    // Small images are their own thumbnail
+    REQUIRE(cache.thumbnail(a) == cache.pixels(a));
+
+    // Released once per add
+    cache.release(a);
+    REQUIRE(cache.contains(a));
+    cache.release(a);
+    REQUIRE_FALSE(cache.contains(a));
+    REQUIRE(cache.base64(c) == fakeImageBase64(40, 30, 10));
+
+    SECTION("bytes that do not decode are not retried") {
+        ImageCache::Key bad = cache.addBytes({1, 2});
+        REQUIRE(cache.pixels(bad) == nullptr);
+        REQUIRE(cache.pixels(bad) == nullptr);
+        REQUIRE(decoderCalls == 2);
+    }
+}
+
+TEST_CASE("ImageCache thumbnails for zoomed-out views", "[image_cache]") {
+    ImageCache cache;
+    cache.setDecoder(decodeFakeImage);
+    ImageCache::Key key = cache.addBytes(fakeImageFile(1000, 500, 77));
+
+    const ImagePixels* thumb = cache.thumbnail(key);
+    REQUIRE(thumb);
+    REQUIRE(thumb->width == ImageCache::THUMBNAIL_SIZE);
+    REQUIRE(thumb->height == ImageCache::THUMBNAIL_SIZE / 2);
+    REQUIRE(thumb->rgba[0] == 77);
+    // Full-size pixels were only needed to make it
+    REQUIRE(cache.decodedBytes() == thumb->byteSize());
+
+    std::vector<ImageCache::TextureHandle> uploaded;
+    std::vector<std::size_t> uploadedWidths;
+    ImageCache::TextureHandle next = 1;
+    cache.setTextureHooks({[&](const ImagePixels& pixels) {
+                               uploaded.push_back(next);
+                               uploadedWidths.push_back(static_cast<std::size_t>(pixels.width));
+                               return next++;
+                           },
+                           [](ImageCache::TextureHandle) {}});
+
+    // Drawn small: the thumbnail goes to the GPU
+    ImageCache::TextureHandle small = cache.texture(key, 100, 50);
+    REQUIRE(small != 0);
+    REQUIRE(uploadedWidths.back() == ImageCache::THUMBNAIL_SIZE);
+    REQUIRE(cache.texture(key, 120, 60) == small);  // Still fits
+
+    // Drawn large: the full image replaces it
+    ImageCache::TextureHandle large = cache.texture(key, 800, 400);
+    REQUIRE(large != small);
+    REQUIRE(uploadedWidths.back() == 1000);
+    REQUIRE(cache.textureBytes() == 1000u * 500u * 4u);
+    REQUIRE(uploaded.size() == 2);
+}
+
+TEST_CASE("ImageCache keeps textures under budget", "[image_cache]") {
+    ImageCache cache;
+    cache.setDecoder(decodeFakeImage);
+    std::vector<ImageCache::TextureHandle> live;
+    ImageCache::TextureHandle next = 1;
+    cache.setTextureHooks({[&](const ImagePixels&) {
+                               live.push_back(next);
+                               return next++;
+                           },
+                           [&](ImageCache::TextureHandle handle) {
+                               live.erase(std::find(live.begin(), live.end(), handle));
+                           }});
+    const std::size_t imageBytes = 100 * 100 * 4;
+    cache.setTextureBudget(3 * imageBytes);
+
+    std::vector<ImageCache::Key> keys;
+    for (std::uint8_t i = 0; i < 6; ++i) keys.push_back(cache.addBytes(fakeImageFile(100, 100, i)));
+
+    // One frame drawing all six: nothing drawn this frame is evicted
+    for (ImageCache::Key key : keys) REQUIRE(cache.texture(key, 100, 100) != 0);
+    cache.endFrame();
+    REQUIRE(live.size() == 6);
+
+    // Next frame draws the last two: the four oldest make way for them
+    cache.texture(keys[4], 100, 100);
+    cache.texture(keys[5], 100, 100);
+    cache.endFrame();
+    REQUIRE(cache.textureBytes() <= 3 * imageBytes);
+    REQUIRE(live.size() == 3);
+
+    // Scrolling back re-uploads from the cached bytes
+    REQUIRE(cache.texture(keys[0], 100, 100) != 0);
+    cache.endFrame();
+    REQUIRE(cache.textureBytes() <= 3 * imageBytes);
+
+    // Removing the images releases their textures
+    for (ImageCache::Key key : keys) cache.release(key);
+    REQUIRE(live.empty());
+    REQUIRE(cache.textureBytes() == 0);
+}
+
+TEST_CASE("ImageCollection keeps embedded data in its cache", "[image_cache]") {
+    ImageCollection images;
+    images.cache().setDecoder(decodeFakeImage);
+
+    DocumentImage image;
+    image.base64Data = fakeImageBase64(64, 64, 5);
+    std::size_t first = images.addImage(image);
+    std::size_t second = images.addImage(image);
+
+    const DocumentImage* stored = images.getImage(first);
+    REQUIRE(stored->base64Data.empty());  // Copies of the image stay small
+    REQUIRE(stored->contentKey != 0);
+    REQUIRE(stored->hasEmbeddedData());
+    REQUIRE(images.embeddedBase64(*stored) == image.base64Data);
+    REQUIRE(images.cache().imageCount() == 1);
+    REQUIRE(images.cache().pixels(stored->contentKey)->width == 64);
+
+    images.removeImage(first);
+    REQUIRE(images.cache().contains(images.getImage(second)->contentKey));
+    images.removeImage(second);
+    REQUIRE(images.cache().imageCount() == 0);
+}
+
+TEST_CASE("ImageCache benchmark - load does not decode", "[image_cache][benchmark]") {
+    // 40 "photos" of 2 MB each: adding them is base64 only
+    std::vector<std::string> encoded;
+    for (std::uint8_t i = 0; i < 40; ++i) {
+        encoded.push_back(fakeImageBase64(1600, 1200, i, 2 * 1024 * 1024));
+    }
+
+    int decoderCalls = 0;
+    ImageCollection images;
+    images.cache().setDecoder([&decoderCalls](const std::vector<std::uint8_t>& bytes,
+                                              ImagePixels& out) {
+        decoderCalls++;
+        return decodeFakeImage(bytes, out);
+    });
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const std::string& data : encoded) {
+        DocumentImage image;
+        image.base64Data = data;
+        images.addImage(image);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    REQUIRE(decoderCalls == 0);
+    REQUIRE(images.cache().decodedBytes() == 0);
+
+    std::printf("\n=== Image Cache Benchmark (40 x 2 MB embedded) ===\n");
+    std::printf("  Load (base64 only): %.2f ms\n",
+                std::chrono::duration<double, std::milli>(end - start).count());
+    std::printf("  Encoded bytes:      %zu\n", images.cache().encodedBytes());
+}
@@ -0,0 +1,186 @@
+#include <chrono>
+#include <cstdio>
+
+#include "../src/editor/incremental_checker.h"
+#include "../src/editor/text_buffer.h"
+#include "catch2/catch.hpp"
+
+namespace {
+std::size_t countKind(const std::vector<Squiggle>& squiggles, SquiggleKind kind) {
+    std::size_t count = 0;
+    for (const auto& s : squiggles) count += (s.kind == kind) ? 1 : 0;
+    return count;
+}
+}  // namespace
+
+TEST_CASE("TextBuffer dirty line tracking", "[incremental_checker][text_buffer]") {
+    TextBuffer buffer;
+    buffer.setText("one\ntwo\nthree\nfour");
+    DirtyLines initial = buffer.takeDirtyLines();
+    REQUIRE(initial.any);
+    REQUIRE(initial.all);
+    REQUIRE_FALSE(buffer.takeDirtyLines().any);
+
+    SECTION("typing marks only the caret row") {
+        buffer.setCaret({1, 3});
+        buffer.insertChar('s');
+        DirtyLines dirty = buffer.takeDirtyLines();
+        REQUIRE(dirty.any);
+        REQUIRE_FALSE(dirty.all);
+        REQUIRE(dirty.first == 1);
+        REQUIRE(dirty.last == 1);
+        REQUIRE(dirty.lineDelta == 0);
+    }
+
+    SECTION("splitting and joining lines report the line delta") {
+        buffer.setCaret({1, 1});
+        buffer.insertChar('\n');
+        DirtyLines split = buffer.takeDirtyLines();
+        REQUIRE(split.first == 1);
+        REQUIRE(split.last == 2);
+        REQUIRE(split.lineDelta == 1);
+
+        buffer.backspace();
+        DirtyLines joined = buffer.takeDirtyLines();
+        REQUIRE(joined.first == 1);
+        REQUIRE(joined.last == 1);
+        REQUIRE(joined.lineDelta == -1);
+    }
+
+    SECTION("edits accumulate into one range") {
+        buffer.setCaret({0, 3});
+        buffer.insertChar('!');
+        buffer.setCaret({3, 0});
+        buffer.insertChar('\n');
+        DirtyLines dirty = buffer.takeDirtyLines();
+        REQUIRE(dirty.first == 0);
+        REQUIRE(dirty.last == 4);
+        REQUIRE(dirty.lineDelta == 1);
+    }
+
+    SECTION("multi-line selection delete collapses rows") {
+        buffer.setCaret({1, 1});
+        buffer.setSelectionAnchor({1, 1});
+        buffer.setCaret({3, 1});
+        buffer.updateSelectionToCaret();
+        REQUIRE(buffer.deleteSelection());
+        DirtyLines dirty = buffer.takeDirtyLines();
+        REQUIRE(dirty.first == 1);
+        REQUIRE(dirty.last == 1);
+        REQUIRE(dirty.lineDelta == -2);
+        REQUIRE(buffer.lineCount() == 2);
+    }
+
+    SECTION("undo reports its edits too") {
+        buffer.setCaret({2, 5});
+        buffer.insertChar('x');
+        buffer.takeDirtyLines();
+        buffer.undo();
+        DirtyLines dirty = buffer.takeDirtyLines();
+        REQUIRE(dirty.any);
+        REQUIRE(dirty.first == 2);
+        REQUIRE(dirty.last == 2);
+    }
+}
+
+TEST_CASE("IncrementalChecker - squiggles follow edits", "[incremental_checker]") {
+    TextBuffer buffer;
+    buffer.setText("The cat ran.\nThis is wrnog here.\nthe dog ran.\n\nAll good now.");
+
+    IncrementalChecker checker;
+    checker.flush(buffer);
+
+    REQUIRE(checker.squigglesForRow(0).empty());
+    const auto& row1 = checker.squigglesForRow(1);
+    REQUIRE(countKind(row1, SquiggleKind::Spelling) == 1);
+    REQUIRE(row1[0].column == 8);
+    REQUIRE(row1[0].length == 5);
+    REQUIRE(countKind(checker.squigglesForRow(2), SquiggleKind::Grammar) == 1);
+    REQUIRE(checker.squigglesForRow(3).empty());
+    REQUIRE(checker.squigglesForRow(4).empty());
+    REQUIRE_FALSE(checker.isRowPending(1));
+
+    SECTION("fixing a word re-checks only that paragraph") {
+        std::size_t checkedBefore = checker.stats().paragraphsChecked;
+        buffer.setCaret({1, 8});
+        buffer.setSelectionAnchor({1, 8});
+        buffer.setCaret({1, 13});
+        buffer.updateSelectionToCaret();
+        buffer.insertText("wrong");
+        checker.flush(buffer);
+
+        REQUIRE(checker.squigglesForRow(1).empty());
+        REQUIRE(checker.stats().paragraphsChecked == checkedBefore + 1);
+    }
+
+    SECTION("inserted lines shift results without re-checking") {
+        std::size_t checkedBefore = checker.stats().paragraphsChecked;
+        std::uint64_t versionBefore = checker.resultsVersion();
+        buffer.setCaret({0, 0});
+        buffer.insertChar('\n');
+        checker.flush(buffer);
+
+        // Both halves of the split hash to cached paragraphs (empty + row 0),
+        // yet the rows now show other results
+        REQUIRE(checker.stats().paragraphsChecked == checkedBefore);
+        REQUIRE(checker.resultsVersion() != versionBefore);
+        REQUIRE(countKind(checker.squigglesForRow(2), SquiggleKind::Spelling) == 1);
+        REQUIRE(countKind(checker.squigglesForRow(3), SquiggleKind::Grammar) == 1);
+    }
+
+    SECTION("unchanged text is served from the cache") {
+        std::size_t checkedBefore = checker.stats().paragraphsChecked;
+        std::string text = buffer.getText();
+        buffer.setText(text);
+        checker.flush(buffer);
+        REQUIRE(checker.stats().paragraphsChecked == checkedBefore);
+        REQUIRE(countKind(checker.squigglesForRow(1), SquiggleKind::Spelling) == 1);
+    }
+
+    SECTION("settings changes re-check everything") {
+        checker.addToUserDictionary("wrnog");
+        checker.flush(buffer);
+        REQUIRE(checker.squigglesForRow(1).empty());
+
+        checker.setGrammarEnabled(false);
+        checker.flush(buffer);
+        REQUIRE(checker.squigglesForRow(2).empty());
+    }
+}
+
+TEST_CASE("IncrementalChecker benchmark - keystroke cost", "[incremental_checker][benchmark]") {
+    std::string text;
+    for (int i = 0; i < 5000; ++i) {
+        text += "Paragraph number " + std::to_string(i) +
+                " has some text with a speling word in it.\n";
+    }
+    TextBuffer buffer;
+    buffer.setText(text);
+
+    IncrementalChecker checker;
+    auto fullStart = std::chrono::high_resolution_clock::now();
+    checker.flush(buffer);
+    auto fullEnd = std::chrono::high_resolution_clock::now();
+
+    buffer.setCaret({2500, 0});
+    const int keystrokes = 200;
+    auto typeStart = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < keystrokes; ++i) {
+        buffer.insertChar('a');
+        checker.update(buffer);
+    }
+    auto typeEnd = std::chrono::high_resolution_clock::now();
+    checker.flush(buffer);
+
+    double fullMs = std::chrono::duration<double, std::milli>(fullEnd - fullStart).count();
+    double perKeyUs = std::chrono::duration<double, std::micro>(typeEnd - typeStart).count() /
+                      keystrokes;
+
+    std::printf("\n=== Incremental Checker Benchmark ===\n");
+    std::printf("  Paragraphs: %zu\n", buffer.lineCount());
+    std::printf("  Initial check: %.1f ms\n", fullMs);
+    std::printf("  update() per keystroke: %.2f us\n", perKeyUs);
+
+    REQUIRE(countKind(checker.squigglesForRow(10), SquiggleKind::Spelling) == 1);
+    REQUIRE(checker.squigglesForRow(2500).size() >= 1);
+}
@@ -0,0 +1,196 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "../src/editor/large_document.h"
+#include "catch2/catch.hpp"
+#include "test_helpers.h"
+
+namespace {
+std::string logLine(std::size_t i) {
+    return "2024-01-01 12:00:00 INFO request " + std::to_string(i) + " served";
+}
+
+// lines of log output, CRLF every seventh line, one planted "Needle"
+std::string writeLog(const std::string& path, std::size_t lines, std::size_t needleRow) {
+    std::ofstream out(path, std::ios::binary);
+    std::string text;
+    for (std::size_t i = 0; i < lines; ++i) {
+        text += i == needleRow ? "ERROR Needle in the haystack" : logLine(i);
+        text += i % 7 == 3 ? "\r\n" : "\n";
+        if (text.size() > 1024 * 1024) {
+            out << text;
+            text.clear();
+        }
+    }
+    out << text;
+    return path;
+}
+}  // namespace
+
+TEST_CASE("LargeDocument indexes lines sparsely", "[large_document]") {
+    TempDirGuard guard("wordproc_large_test");
+    std::string path = writeLog((guard.dir / "index.log").string(), 200000, 150000);
+
+    LargeDocument doc;
+    REQUIRE(doc.open(path));
+    doc.waitForIndex();
+    REQUIRE(doc.indexed());
+    REQUIRE(doc.lineCount() == 200001);  // Trailing newline leaves an empty last line
+
+    REQUIRE(doc.line(0) == logLine(0));
+    REQUIRE(doc.line(3) == logLine(3));  // CR dropped
+    REQUIRE(doc.line(150000) == "ERROR Needle in the haystack");
+    REQUIRE(doc.line(199999) == logLine(199999));
+    REQUIRE(doc.line(200000).empty());
+    REQUIRE(doc.lineOffset(200001) == LargeDocument::npos);
+    for (std::size_t row : {0, 1, 1023, 1024, 1025, 77777, 200000}) {
+        std::uint64_t offset = doc.lineOffset(row);
+        REQUIRE(doc.rowOfOffset(offset) == row);
+        if (row > 0) REQUIRE(doc.rowOfOffset(offset - 1) == row - 1);
+    }
+
+    // One checkpoint per CHECKPOINT_LINES lines, nothing per line
+    REQUIRE(doc.memoryBytes() <= (200001 / LargeDocument::CHECKPOINT_LINES + 1) * 8);
+    REQUIRE_FALSE(LargeDocument::wantsFile(path));  // Far below THRESHOLD
+}
+
+TEST_CASE("LargeDocument window follows the view", "[large_document]") {
+    TempDirGuard guard("wordproc_large_test");
+    std::string path = writeLog((guard.dir / "window.log").string(), 50000, 40000);
+
+    LargeDocument doc;
+    REQUIRE(doc.open(path));
+    doc.waitForIndex();
+    TextBuffer buffer;
+    buffer.setReadOnly(true);
+    doc.loadWindow(buffer, 0);
+    REQUIRE(buffer.lineCount() == LargeDocument::WINDOW_LINES);
+    REQUIRE(buffer.lineString(3) == logLine(3));
+
+    buffer.insertChar('x');
+    buffer.backspace();
+    REQUIRE(buffer.lineString(0) == logLine(0));
+
+    // Nothing moves while the view is well inside the window
+    REQUIRE(doc.followView(buffer, 100, 40) == 0);
+
+    // Near the bottom edge the window re-centres on the view
+    std::size_t top = LargeDocument::WINDOW_LINES - 50;
+    buffer.setCaret({top + 5, 4});
+    std::ptrdiff_t shift = doc.followView(buffer, top, 40);
+    REQUIRE(shift < 0);
+    std::size_t newTop = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(top) + shift);
+    REQUIRE(buffer.lineString(newTop) == logLine(top));
+    REQUIRE(buffer.caret().row == newTop + 5);
+    REQUIRE(buffer.caret().column == 4);
+
+    // And back up near the top
+    shift = doc.followView(buffer, 2, 40);
+    REQUIRE(shift > 0);
+    REQUIRE(doc.windowFirst() == 0);
+
+    // The end of the file
+    doc.goToLine(buffer, doc.lineCount() - 2);
+    REQUIRE(buffer.lineString(buffer.caret().row) == logLine(49999));
+    REQUIRE(doc.windowFirst() + doc.windowLines() == doc.lineCount());
+}
+
+TEST_CASE("LargeDocument keeps only non-default paragraph formats", "[large_document]") {
+    TempDirGuard guard("wordproc_large_test");
+    std::string path = writeLog((guard.dir / "formats.log").string(), 30000, 0);
+
+    LargeDocument doc;
+    REQUIRE(doc.open(path));
+    doc.waitForIndex();
+    TextBuffer buffer;
+    doc.loadWindow(buffer, 0);
+
+    buffer.setCaret({5, 0});
+    buffer.setCurrentParagraphStyle(ParagraphStyle::Heading1);
+    buffer.setCaret({6, 0});
+    buffer.setCurrentAlignment(TextAlignment::Center);
+    buffer.setCurrentAlignment(TextAlignment::Left);  // Back to default
+
+    doc.goToLine(buffer, 20000);
+    REQUIRE(doc.formattedLines() == 1);
+    REQUIRE(doc.lineFormat(5).style == ParagraphStyle::Heading1);
+    REQUIRE(doc.lineFormat(6).isDefault());
+    REQUIRE(buffer.lineParagraphStyle(5) == ParagraphStyle::Normal);
+
+    doc.goToLine(buffer, 0);
+    REQUIRE(buffer.lineParagraphStyle(5) == ParagraphStyle::Heading1);
+}
+
+TEST_CASE("LargeDocument finds across the whole file", "[large_document]") {
+    TempDirGuard guard("wordproc_large_test");
+    std::string path = writeLog((guard.dir / "find.log").string(), 100000, 80000);
+
+    LargeDocument doc;
+    REQUIRE(doc.open(path));
+    doc.waitForIndex();
+    TextBuffer buffer;
+    doc.loadWindow(buffer, 0);
+
+    FindOptions options;
+    FindResult result = doc.findNext(buffer, "needle", options);
+    REQUIRE(result.found);
+    REQUIRE(doc.windowFirst() + result.start.row == 80000);
+    REQUIRE(result.start.column == 6);
+    REQUIRE(result.end.column == 12);
+
+    options.caseSensitive = true;
+    buffer.setCaret({0, 0});
+    doc.goToLine(buffer, 0);
+    REQUIRE_FALSE(doc.findNext(buffer, "needle", options).found);
+
+    // Backwards from the end, wrapping
+    options.caseSensitive = false;
+    doc.goToLine(buffer, 10);
+    result = doc.findPrevious(buffer, "NEEDLE", options);
+    REQUIRE(result.found);
+    REQUIRE(doc.windowFirst() + result.start.row == 80000);
+
+    // Whole words only: "request 9999" but not "request 99990"
+    options.wholeWord = true;
+    doc.goToLine(buffer, 0);
+    result = doc.findNext(buffer, "request 9999", options);
+    REQUIRE(result.found);
+    REQUIRE(doc.windowFirst() + result.start.row == 9999);
+    std::uint64_t from = doc.lineOffset(10000);
+    std::uint64_t next = doc.find("request 9999", from, true, options);
+    REQUIRE(next == LargeDocument::npos);
+    options.wrapAround = false;
+    REQUIRE(doc.find("request 9999", doc.lineOffset(9999), false, options) ==
+            LargeDocument::npos);
+}
+
+TEST_CASE("LargeDocument benchmark - open, index and find", "[large_document][benchmark]") {
+    TempDirGuard guard("wordproc_large_test");
+    std::string path = writeLog((guard.dir / "bench.log").string(), 1500000, 1400000);
+
+    auto ms = [](auto start, auto end) {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+    auto openStart = std::chrono::high_resolution_clock::now();
+    LargeDocument doc;
+    REQUIRE(doc.open(path));
+    TextBuffer buffer;
+    doc.loadWindow(buffer, 0);
+    auto firstScreen = std::chrono::high_resolution_clock::now();
+    doc.waitForIndex();
+    auto indexed = std::chrono::high_resolution_clock::now();
+
+    FindResult result = doc.findNext(buffer, "Needle", FindOptions{});
+    auto found = std::chrono::high_resolution_clock::now();
+    REQUIRE(result.found);
+
+    std::printf("\n=== Large File Benchmark (%.0f MB, %zu lines) ===\n",
+                static_cast<double>(doc.sizeBytes()) / (1024.0 * 1024.0), doc.lineCount());
+    std::printf("  First window:  %.2f ms\n", ms(openStart, firstScreen));
+    std::printf("  Line index:    %.2f ms, %zu bytes\n", ms(openStart, indexed),
+                doc.memoryBytes());
+    std::printf("  Find (whole):  %.2f ms\n", ms(indexed, found));
+}
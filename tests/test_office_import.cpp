@@ -0,0 +1,571 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/editor/document_io.h"
+#include "../src/editor/flate.h"
+#include "../src/editor/office_import.h"
+#include "../src/editor/progressive_loader.h"
+#include "../src/editor/xml_scan.h"
+#include "../src/editor/zip_archive.h"
+#include "catch2/catch.hpp"
+#include "test_helpers.h"
+
+namespace {
+// Just enough of a zip writer to build test documents (CRCs left at zero,
+// which ZipArchive does not check)
+void writeZip(const std::string& path,
+              const std::vector<std::pair<std::string, std::string>>& entries,
+              bool deflate = true) {
+    std::string zip;
+    std::string directory;
+    auto put16 = [](std::string& out, std::uint32_t value) {
+        out += static_cast<char>(value & 0xFF);
+        out += static_cast<char>((value >> 8) & 0xFF);
+    };
+    auto put32 = [&](std::string& out, std::uint32_t value) {
+        put16(out, value & 0xFFFF);
+        put16(out, value >> 16);
+    };
+    for (const auto& [name, contents] : entries) {
+        std::string data = contents;
+        std::uint16_t method = 0;
+        if (deflate) {
+            std::string zlib = flate::compress(contents);
+            data = zlib.substr(2, zlib.size() - 6);  // Raw deflate inside the zlib wrapper
+            method = 8;
+        }
+        auto offset = static_cast<std::uint32_t>(zip.size());
+        auto size = static_cast<std::uint32_t>(contents.size());
+        auto packed = static_cast<std::uint32_t>(data.size());
+        auto nameLength = static_cast<std::uint32_t>(name.size());
+        put32(zip, 0x04034b50);
+        put16(zip, 20);
+        put16(zip, 0);
+        put16(zip, method);
+        put32(zip, 0);  // Time and date
+        put32(zip, 0);  // CRC
+        put32(zip, packed);
+        put32(zip, size);
+        put16(zip, nameLength);
+        put16(zip, 0);
+        zip += name;
+        zip += data;
+
+        put32(directory, 0x02014b50);
+        put16(directory, 20);
+        put16(directory, 20);
+        put16(directory, 0);
+        put16(directory, method);
+        put32(directory, 0);
+        put32(directory, 0);
+        put32(directory, packed);
+        put32(directory, size);
+        put16(directory, nameLength);
+        put32(directory, 0);  // Extra and comment lengths
+        put32(directory, 0);  // Disk, internal attributes
+        put32(directory, 0);  // External attributes
+        put32(directory, offset);
+        directory += name;
+    }
+    auto directoryOffset = static_cast<std::uint32_t>(zip.size());
+    zip += directory;
+    put32(zip, 0x06054b50);
+    put32(zip, 0);
+    put16(zip, static_cast<std::uint32_t>(entries.size()));
+    put16(zip, static_cast<std::uint32_t>(entries.size()));
+    put32(zip, static_cast<std::uint32_t>(directory.size()));
+    put32(zip, directoryOffset);
+    put16(zip, 0);
+    std::ofstream(path, std::ios::binary) << zip;
+}
+
+const char* W = "xmlns:w=\"http://schemas.openxmlformats.org/wordprocessingml/2006/main\"";
+
+std::string docxDocument(const std::string& body) {
+    return std::string("<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n") +
+           "<w:document " + W + "><w:body>" + body + "</w:body></w:document>";
+}
+
+std::string para(const std::string& text, const std::string& properties = "") {
+    return "<w:p>" + (properties.empty() ? "" : "<w:pPr>" + properties + "</w:pPr>") +
+           "<w:r><w:t xml:space=\"preserve\">" + text + "</w:t></w:r></w:p>";
+}
+
+std::string cell(const std::string& text, const std::string& properties = "") {
+    return "<w:tc>" + (properties.empty() ? "" : "<w:tcPr>" + properties + "</w:tcPr>") +
+           para(text) + "</w:tc>";
+}
+
+const char* DOCX_STYLES =
+    "<w:styles>"
+    "<w:docDefaults><w:rPrDefault><w:rPr><w:sz w:val=\"24\"/></w:rPr></w:rPrDefault>"
+    "</w:docDefaults>"
+    "<w:style w:type=\"paragraph\" w:styleId=\"Normal\"><w:name w:val=\"Normal\"/></w:style>"
+    "<w:style w:type=\"paragraph\" w:styleId=\"Titre\"><w:name w:val=\"Title\"/></w:style>"
+    "<w:style w:type=\"paragraph\" w:styleId=\"Heading1\"><w:name w:val=\"heading 1\"/>"
+    "</w:style>"
+    "<w:style w:type=\"paragraph\" w:styleId=\"Chapter\"><w:basedOn w:val=\"Heading1\"/>"
+    "</w:style>"
+    "<w:style w:type=\"paragraph\" w:styleId=\"ListBullet\"><w:name w:val=\"List Bullet\"/>"
+    "<w:pPr><w:numPr><w:numId w:val=\"1\"/></w:numPr></w:pPr></w:style>"
+    "</w:styles>";
+
+const char* DOCX_NUMBERING =
+    "<w:numbering>"
+    "<w:abstractNum w:abstractNumId=\"0\">"
+    "<w:lvl w:ilvl=\"0\"><w:numFmt w:val=\"bullet\"/></w:lvl>"
+    "<w:lvl w:ilvl=\"1\"><w:start w:val=\"1\"/><w:numFmt w:val=\"lowerLetter\"/></w:lvl>"
+    "</w:abstractNum>"
+    "<w:abstractNum w:abstractNumId=\"1\">"
+    "<w:lvl w:ilvl=\"0\"><w:start w:val=\"3\"/><w:numFmt w:val=\"decimal\"/></w:lvl>"
+    "</w:abstractNum>"
+    "<w:num w:numId=\"1\"><w:abstractNumId w:val=\"0\"/></w:num>"
+    "<w:num w:numId=\"2\"><w:abstractNumId w:val=\"1\"/></w:num>"
+    "</w:numbering>";
+
+const char* DOCX_RELS =
+    "<Relationships>"
+    "<Relationship Id=\"rId1\" Type=\"hyperlink\" Target=\"https://example.com/?a=1&amp;b=2\" "
+    "TargetMode=\"External\"/>"
+    "<Relationship Id=\"rId2\" Type=\"image\" Target=\"media/image1.png\"/>"
+    "</Relationships>";
+
+const std::string IMAGE_BYTES = std::string("\x89PNG\r\n\x1a\n", 8) + "not really pixels";
+}  // namespace
+
+TEST_CASE("xml_scan reports elements, attributes and text", "[office_import]") {
+    struct Recorder : xml_scan::Handler {
+        std::string log;
+        void startElement(std::string_view name, const xml_scan::Attributes& attributes) override {
+            log += "<" + std::string(name);
+            for (std::size_t i = 0; i < attributes.size(); ++i) {
+                log += " " + std::string(attributes[i].first) + "=" +
+                       attributes.text(attributes[i].first);
+            }
+            log += ">";
+        }
+        void endElement(std::string_view name) override { log += "</" + std::string(name) + ">"; }
+        void characters(std::string_view text) override { log += "[" + std::string(text) + "]"; }
+    };
+
+    Recorder recorder;
+    REQUIRE(xml_scan::parse(
+        "<?xml version=\"1.0\"?><!DOCTYPE x><!-- note --><a x='1 &amp; 2' y = \"&#x41;\">"
+        "t &lt;3 &#8364;<b/><![CDATA[<raw>]]></a >",
+        recorder));
+    REQUIRE(recorder.log ==
+            "<a x=1 & 2 y=A>[t <3 \xE2\x82\xAC]<b></b>[<raw>]</a>");
+
+    std::string error;
+    Recorder broken;
+    REQUIRE_FALSE(xml_scan::parse("<a b=c>", broken, &error));
+    REQUIRE(error.find("unquoted") != std::string::npos);
+    REQUIRE_FALSE(xml_scan::parse("<a><!-- open", broken, &error));
+
+    std::string decoded;
+    xml_scan::decodeEntities("&bogus; &amp &#xD800; &#65;", decoded);
+    REQUIRE(decoded == "&bogus; &amp &#xD800; A");
+}
+
+TEST_CASE("ZipArchive reads stored and deflated entries", "[office_import]") {
+    TempDirGuard guard("wordproc_office_test");
+    std::string big(100000, 'x');
+    for (std::size_t i = 0; i < big.size(); i += 7) big[i] = static_cast<char>('a' + i % 26);
+
+    for (bool deflate : {false, true}) {
+        std::string path = guard.path(deflate ? "deflated.zip" : "stored.zip");
+        writeZip(path, {{"a.txt", "hello"}, {"dir/big.bin", big}, {"empty", ""}}, deflate);
+        ZipArchive zip;
+        REQUIRE(zip.open(path));
+        REQUIRE(zip.names() == std::vector<std::string>{"a.txt", "dir/big.bin", "empty"});
+        std::string out;
+        REQUIRE(zip.read("a.txt", out));
+        REQUIRE(out == "hello");
+        REQUIRE(zip.read("dir/big.bin", out));
+        REQUIRE(out == big);
+        REQUIRE(zip.read("empty", out));
+        REQUIRE(out.empty());
+        REQUIRE_FALSE(zip.read("missing", out));
+        REQUIRE(zip.error().find("missing") != std::string::npos);
+    }
+
+    // A directory that understates an entry's size (a zip bomb) fails the
+    // read instead of inflating past it
+    std::string bombPath = guard.path("bomb.zip");
+    writeZip(bombPath, {{"big.bin", std::string(1 << 20, 'x')}});
+    std::string bomb;
+    {
+        std::ifstream in(bombPath, std::ios::binary);
+        bomb.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::size_t directory = bomb.find("PK\x01\x02");
+    REQUIRE(directory != std::string::npos);
+    bomb.replace(directory + 24, 4, std::string("\x10\0\0\0", 4));
+    std::ofstream(bombPath, std::ios::binary | std::ios::trunc) << bomb;
+    {
+        ZipArchive zip;
+        REQUIRE(zip.open(bombPath));
+        std::string out;
+        REQUIRE_FALSE(zip.read("big.bin", out));
+        REQUIRE(out.empty());
+    }
+
+    std::string notZip = guard.path("plain.zip");
+    std::ofstream(notZip) << "just some text that is long enough to look for a directory";
+    ZipArchive zip;
+    REQUIRE_FALSE(zip.open(notZip));
+    REQUIRE_FALSE(zip.error().empty());
+}
+
+TEST_CASE("docx import maps paragraphs, lists, links, tables and images", "[office_import]") {
+    TempDirGuard guard("wordproc_office_test");
+    std::string body =
+        para("The Report", "<w:pStyle w:val=\"Titre\"/>") +
+        "<w:p><w:pPr><w:pStyle w:val=\"Chapter\"/></w:pPr><w:bookmarkStart w:id=\"0\" "
+        "w:name=\"intro\"/><w:r><w:t>Intro</w:t></w:r><w:bookmarkEnd w:id=\"0\"/>"
+        "<w:bookmarkStart w:id=\"1\" w:name=\"_GoBack\"/></w:p>" +
+        "<w:p><w:pPr><w:jc w:val=\"center\"/><w:ind w:left=\"720\" w:hanging=\"360\"/>"
+        "<w:spacing w:before=\"240\" w:after=\"120\" w:line=\"360\" w:lineRule=\"auto\"/>"
+        "<w:tabs><w:tab w:val=\"left\" w:pos=\"720\"/></w:tabs></w:pPr>"
+        "<w:r><w:t xml:space=\"preserve\">See the </w:t></w:r>"
+        "<w:hyperlink r:id=\"rId1\" w:tooltip=\"Home\"><w:r><w:t>site</w:t></w:r></w:hyperlink>"
+        "<w:r><w:tab/><w:t>now</w:t></w:r>"
+        "<w:del><w:r><w:delText>gone</w:delText></w:r></w:del>"
+        "<w:r><w:drawing><wp:inline><wp:extent cx=\"952500\" cy=\"476250\"/>"
+        "<wp:docPr id=\"1\" name=\"Picture 1\" descr=\"Logo\"/><a:graphic><a:graphicData>"
+        "<pic:pic><pic:blipFill><a:blip r:embed=\"rId2\"/></pic:blipFill></pic:pic>"
+        "</a:graphicData></a:graphic></wp:inline></w:drawing></w:r>"
+        "<w:r><w:pict><v:textbox><w:txbxContent>" + para("boxed") +
+        "</w:txbxContent></v:textbox></w:pict></w:r></w:p>" +
+        para("three", "<w:numPr><w:ilvl w:val=\"0\"/><w:numId w:val=\"2\"/></w:numPr>") +
+        para("four", "<w:numPr><w:ilvl w:val=\"0\"/><w:numId w:val=\"2\"/></w:numPr>") +
+        para("dot", "<w:pStyle w:val=\"ListBullet\"/>") +
+        para("a", "<w:pStyle w:val=\"ListBullet\"/><w:numPr><w:ilvl w:val=\"1\"/>"
+                  "<w:numId w:val=\"1\"/></w:numPr>") +
+        para("b", "<w:numPr><w:ilvl w:val=\"1\"/><w:numId w:val=\"1\"/></w:numPr>") +
+        "<w:tbl><w:tblGrid><w:gridCol w:w=\"1500\"/><w:gridCol w:w=\"3000\"/></w:tblGrid>"
+        "<w:tr>" + cell("Wide", "<w:gridSpan w:val=\"2\"/>") + "</w:tr>"
+        "<w:tr>" + cell("Tall", "<w:vMerge w:val=\"restart\"/>") + cell("C") + "</w:tr>"
+        "<w:tr>" + cell("", "<w:vMerge/>") +
+        "<w:tc><w:p><w:r><w:t>D1</w:t></w:r></w:p><w:p><w:r><w:t>D2</w:t></w:r></w:p></w:tc>"
+        "</w:tr></w:tbl>" +
+        "<w:p><w:r><w:br w:type=\"page\"/><w:t>Next page</w:t><w:br/><w:t>same para</w:t>"
+        "</w:r></w:p>" +
+        "<w:p><w:hyperlink w:anchor=\"intro\"><w:r><w:t>back</w:t></w:r></w:hyperlink>"
+        "<w:r><w:br w:type=\"page\"/><w:t>!</w:t></w:r></w:p>" +
+        para("end");
+
+    std::string path = guard.path("sample.docx");
+    writeZip(path, {{"[Content_Types].xml", "<Types/>"},
+                    {"word/document.xml", docxDocument(body)},
+                    {"word/styles.xml", DOCX_STYLES},
+                    {"word/numbering.xml", DOCX_NUMBERING},
+                    {"word/_rels/document.xml.rels", DOCX_RELS},
+                    {"word/media/image1.png", IMAGE_BYTES}});
+
+    TextBuffer buffer;
+    DocumentSettings settings;
+    TableList tables;
+    ImageCollection images;
+    DocumentResult result = importOfficeDocument(buffer, settings, tables, &images, path);
+    REQUIRE(result.success);
+    REQUIRE_FALSE(result.usedFallback);
+
+    REQUIRE(buffer.getText() ==
+            "The Report\nIntro\nSee the site\tnow\nthree\nfour\ndot\na\nb\n"
+            "Next page\nsame para\nback!\nend");
+    REQUIRE(buffer.lineFormat(0).style == ParagraphStyle::Title);
+    REQUIRE(buffer.lineFormat(1).style == ParagraphStyle::Heading1);
+
+    ParagraphFormat centered = buffer.lineFormat(2);
+    REQUIRE(centered.alignment == TextAlignment::Center);
+    REQUIRE(centered.leftIndent == 48);
+    REQUIRE(centered.firstLineIndent == -24);
+    REQUIRE(centered.spaceBefore == 16);
+    REQUIRE(centered.spaceAfter == 8);
+    REQUIRE(centered.lineSpacing == Approx(1.5f));
+
+    REQUIRE(buffer.lineFormat(3).listType == ListType::Numbered);
+    REQUIRE(buffer.lineFormat(3).listNumber == 3);
+    REQUIRE(buffer.lineFormat(4).listNumber == 4);
+    REQUIRE(buffer.lineFormat(5).listType == ListType::Bulleted);  // From its style
+    REQUIRE(buffer.lineFormat(6).listType == ListType::Numbered);
+    REQUIRE(buffer.lineFormat(6).listLevel == 1);
+    REQUIRE(buffer.lineFormat(6).listNumber == 1);
+    REQUIRE(buffer.lineFormat(7).listNumber == 2);
+
+    // The page break run starts its paragraph; the soft break splits it
+    REQUIRE(buffer.lineFormat(8).hasPageBreakBefore);
+    REQUIRE_FALSE(buffer.lineFormat(9).hasPageBreakBefore);
+    // A page break after text applies to the next paragraph
+    REQUIRE_FALSE(buffer.lineFormat(10).hasPageBreakBefore);
+    REQUIRE(buffer.lineFormat(11).hasPageBreakBefore);
+
+    REQUIRE(buffer.hyperlinks().size() == 2);
+    REQUIRE(buffer.hyperlinks()[0].url == "https://example.com/?a=1&b=2");
+    REQUIRE(buffer.hyperlinks()[0].tooltip == "Home");
+    std::string text = buffer.getText();
+    REQUIRE(text.substr(buffer.hyperlinks()[0].startOffset, 4) == "site");
+    REQUIRE(buffer.hyperlinks()[1].url == "#intro");
+    REQUIRE(text.substr(buffer.hyperlinks()[1].startOffset, 4) == "back");
+    REQUIRE(buffer.bookmarks().size() == 1);
+    REQUIRE(buffer.bookmarks()[0].name == "intro");
+    REQUIRE(buffer.bookmarks()[0].offset == text.find("Intro"));
+
+    REQUIRE(tables.size() == 1);
+    REQUIRE(tables[0].first == 8);  // Ahead of "Next page"
+    const Table& table = tables[0].second;
+    REQUIRE(table.rowCount() == 3);
+    REQUIRE(table.colCount() == 2);
+    REQUIRE(table.colWidth(0) == Approx(100.0f));
+    REQUIRE(table.colWidth(1) == Approx(200.0f));
+    REQUIRE(table.getCellContent(0, 0) == "Wide");
+    REQUIRE(table.cell(0, 0).span.colSpan == 2);
+    REQUIRE(table.getCellContent(1, 0) == "Tall");
+    REQUIRE(table.cell(1, 0).span.rowSpan == 2);
+    REQUIRE(table.isCellMerged({2, 0}));
+    REQUIRE(table.getCellContent(1, 1) == "C");
+    REQUIRE(table.getCellContent(2, 1) == "D1\nD2");
+
+    REQUIRE(images.count() == 1);
+    const DocumentImage& image = images.images()[0];
+    REQUIRE(image.anchorLine == 2);
+    REQUIRE(image.anchorColumn == std::string("See the site\tnow").size());
+    REQUIRE(image.altText == "Logo");
+    REQUIRE(image.layoutMode == ImageLayoutMode::Inline);
+    REQUIRE(image.displayWidth == Approx(100.0f));
+    REQUIRE(image.displayHeight == Approx(50.0f));
+    REQUIRE(image.hasEmbeddedData());
+
+    REQUIRE(settings.textStyle.fontSize == 16);  // 12 pt
+
+    SECTION("loadDocumentWithTables imports by extension") {
+        TextBuffer loaded;
+        DocumentSettings loadedSettings;
+        TableList loadedTables;
+        REQUIRE(loadDocumentWithTables(loaded, loadedSettings, loadedTables, path).success);
+        REQUIRE(loaded.getText() == buffer.getText());
+        REQUIRE(loadedTables.size() == 1);
+    }
+
+    SECTION("the loaders carry images through, and other formats clear them") {
+        TextBuffer loaded;
+        DocumentSettings loadedSettings;
+        ImageCollection loadedImages;
+        REQUIRE(loadDocumentEx(loaded, loadedSettings, path, &loadedImages).success);
+        REQUIRE(loadedImages.count() == 1);
+        REQUIRE(loadedImages.images()[0].altText == "Logo");
+
+        ProgressiveLoader loader;
+        loadedImages.clear();
+        REQUIRE(loader.start(loaded, loadedSettings, path, &loadedImages).success);
+        REQUIRE(loadedImages.count() == 1);
+
+        std::string plain = guard.path("plain.txt");
+        std::ofstream(plain) << "no pictures";
+        REQUIRE(loadDocumentEx(loaded, loadedSettings, plain, &loadedImages).success);
+        REQUIRE(loadedImages.count() == 0);
+    }
+}
+
+TEST_CASE("odt import maps paragraphs, lists, links, tables and images", "[office_import]") {
+    TempDirGuard guard("wordproc_office_test");
+    std::string styles =
+        "<office:document-styles><office:styles>"
+        "<style:default-style style:family=\"paragraph\">"
+        "<style:text-properties fo:font-size=\"15pt\"/></style:default-style>"
+        "<style:style style:name=\"Standard\" style:family=\"paragraph\"/>"
+        "<style:style style:name=\"Heading_20_2\" style:display-name=\"Heading 2\" "
+        "style:family=\"paragraph\" style:default-outline-level=\"2\"/>"
+        "<style:style style:name=\"Title\" style:family=\"paragraph\">"
+        "<style:paragraph-properties fo:text-align=\"center\"/></style:style>"
+        "</office:styles><office:master-styles><style:master-page><style:header>"
+        "<text:p>Header text</text:p></style:header></style:master-page></office:master-styles>"
+        "</office:document-styles>";
+    std::string content =
+        "<office:document-content><office:automatic-styles>"
+        "<style:style style:name=\"P1\" style:family=\"paragraph\" "
+        "style:parent-style-name=\"Standard\"><style:paragraph-properties "
+        "fo:text-align=\"end\" fo:margin-left=\"0.5in\" fo:text-indent=\"-0.25in\" "
+        "fo:margin-top=\"12pt\" fo:line-height=\"200%\" fo:break-before=\"page\"/>"
+        "</style:style>"
+        "<style:style style:name=\"P2\" style:family=\"paragraph\" "
+        "style:parent-style-name=\"Title\"/>"
+        "<text:list-style style:name=\"L1\">"
+        "<text:list-level-style-number text:level=\"1\"/>"
+        "<text:list-level-style-bullet text:level=\"2\"/></text:list-style>"
+        "</office:automatic-styles><office:body><office:text>\n"
+        "  <text:sequence-decls><text:sequence-decl text:name=\"x\"/></text:sequence-decls>\n"
+        "  <text:p text:style-name=\"P2\">My Title</text:p>\n"
+        "  <text:h text:style-name=\"Heading_20_2\" text:outline-level=\"2\">"
+        "<text:bookmark text:name=\"top\"/>Section</text:h>\n"
+        "  <text:p text:style-name=\"P1\">  Spread \n   out<text:s text:c=\"2\"/>text "
+        "<text:a xlink:href=\"http://example.org\" office:title=\"Tip\">link</text:a>"
+        "<text:tab/>end<text:note><text:note-citation>1</text:note-citation><text:note-body>"
+        "<text:p>Footnote</text:p></text:note-body></text:note> </text:p>\n"
+        "  <text:list text:style-name=\"L1\">\n"
+        "    <text:list-item><text:p>one</text:p>\n"
+        "      <text:list><text:list-item><text:p>sub</text:p></text:list-item></text:list>\n"
+        "    </text:list-item>\n"
+        "    <text:list-item><text:p>two</text:p><text:p>more</text:p></text:list-item>\n"
+        "  </text:list>\n"
+        "  <table:table><table:table-column table:number-columns-repeated=\"3\"/>\n"
+        "    <table:table-row><table:table-cell table:number-columns-spanned=\"2\">"
+        "<text:p>Span</text:p></table:table-cell><table:covered-table-cell/>"
+        "<table:table-cell><text:p>R</text:p></table:table-cell></table:table-row>\n"
+        "    <table:table-row><table:table-cell table:number-columns-repeated=\"3\">"
+        "<text:p>x</text:p></table:table-cell></table:table-row>\n"
+        "  </table:table>\n"
+        "  <text:p>Picture <draw:frame draw:name=\"img\" text:anchor-type=\"as-char\" "
+        "svg:width=\"1in\" svg:height=\"0.5in\"><draw:image xlink:href=\"Pictures/pic.png\"/>"
+        "<svg:title>Title</svg:title><svg:desc>A picture</svg:desc></draw:frame>after</text:p>\n"
+        "  <text:p/>\n"
+        "</office:text></office:body></office:document-content>";
+
+    std::string path = guard.path("sample.odt");
+    writeZip(path, {{"mimetype", "application/vnd.oasis.opendocument.text"},
+                    {"content.xml", content},
+                    {"styles.xml", styles},
+                    {"Pictures/pic.png", IMAGE_BYTES}});
+
+    TextBuffer buffer;
+    DocumentSettings settings;
+    TableList tables;
+    ImageCollection images;
+    REQUIRE(importOfficeDocument(buffer, settings, tables, &images, path).success);
+
+    REQUIRE(buffer.getText() ==
+            "My Title\nSection\nSpread out  text link\tend\none\nsub\ntwo\nmore\n"
+            "Picture after\n");
+    REQUIRE(buffer.lineFormat(0).style == ParagraphStyle::Title);
+    // Named styles only map to a paragraph style
+    REQUIRE(buffer.lineFormat(0).alignment == TextAlignment::Left);
+    REQUIRE(buffer.lineFormat(1).style == ParagraphStyle::Heading2);
+
+    ParagraphFormat direct = buffer.lineFormat(2);
+    REQUIRE(direct.alignment == TextAlignment::Right);
+    REQUIRE(direct.leftIndent == 48);
+    REQUIRE(direct.firstLineIndent == -24);
+    REQUIRE(direct.spaceBefore == 16);
+    REQUIRE(direct.lineSpacing == Approx(2.0f));
+    REQUIRE(direct.hasPageBreakBefore);
+
+    REQUIRE(buffer.lineFormat(3).listType == ListType::Numbered);
+    REQUIRE(buffer.lineFormat(3).listNumber == 1);
+    REQUIRE(buffer.lineFormat(4).listType == ListType::Bulleted);
+    REQUIRE(buffer.lineFormat(4).listLevel == 1);
+    REQUIRE(buffer.lineFormat(5).listNumber == 2);
+    REQUIRE(buffer.lineFormat(6).listType == ListType::None);  // Second paragraph of an item
+
+    REQUIRE(buffer.hyperlinks().size() == 1);
+    REQUIRE(buffer.hyperlinks()[0].url == "http://example.org");
+    REQUIRE(buffer.hyperlinks()[0].tooltip == "Tip");
+    std::string text = buffer.getText();
+    REQUIRE(text.substr(buffer.hyperlinks()[0].startOffset,
+                        buffer.hyperlinks()[0].endOffset - buffer.hyperlinks()[0].startOffset) ==
+            "link");
+    REQUIRE(buffer.bookmarks().size() == 1);
+    REQUIRE(buffer.bookmarks()[0].offset == text.find("Section"));
+
+    REQUIRE(tables.size() == 1);
+    REQUIRE(tables[0].first == 7);
+    const Table& table = tables[0].second;
+    REQUIRE(table.rowCount() == 2);
+    REQUIRE(table.colCount() == 3);
+    REQUIRE(table.getCellContent(0, 0) == "Span");
+    REQUIRE(table.cell(0, 0).span.colSpan == 2);
+    REQUIRE(table.getCellContent(0, 2) == "R");
+    REQUIRE(table.getCellContent(1, 0) == "x");
+    REQUIRE(table.getCellContent(1, 2) == "x");
+
+    REQUIRE(images.count() == 1);
+    REQUIRE(images.images()[0].anchorLine == 7);
+    REQUIRE(images.images()[0].anchorColumn == 8);
+    REQUIRE(images.images()[0].altText == "A picture");
+    REQUIRE(images.images()[0].displayWidth == Approx(96.0f));
+    REQUIRE(images.images()[0].layoutMode == ImageLayoutMode::Inline);
+
+    REQUIRE(settings.textStyle.fontSize == 20);  // 15 pt
+}
+
+TEST_CASE("office import reports damaged files", "[office_import]") {
+    TempDirGuard guard("wordproc_office_test");
+    TextBuffer buffer;
+    buffer.setText("unchanged");
+    DocumentSettings settings;
+    TableList tables;
+
+    std::string empty = guard.path("empty.docx");
+    writeZip(empty, {{"readme.txt", "not a document"}});
+    DocumentResult result = importOfficeDocument(buffer, settings, tables, nullptr, empty);
+    REQUIRE_FALSE(result.success);
+    REQUIRE(result.error.find("Not a Word") != std::string::npos);
+
+    std::string malformed = guard.path("malformed.docx");
+    writeZip(malformed, {{"word/document.xml", "<w:document><w:body><w:p attr></w:body>"}});
+    result = importOfficeDocument(buffer, settings, tables, nullptr, malformed);
+    REQUIRE_FALSE(result.success);
+    REQUIRE(result.error.find("word/document.xml") != std::string::npos);
+    REQUIRE(buffer.getText() == "unchanged");
+
+    result = importOfficeDocument(buffer, settings, tables, nullptr, guard.path("missing.odt"));
+    REQUIRE_FALSE(result.success);
+}
+
+TEST_CASE("docx import benchmark - 200 pages", "[office_import][benchmark]") {
+    TempDirGuard guard("wordproc_office_test");
+    // About 45 lines of prose a page, in the run-per-phrase shape Word writes
+    std::string body;
+    std::size_t paragraphs = 0;
+    for (int page = 0; page < 200; ++page) {
+        body += para("Chapter " + std::to_string(page), "<w:pStyle w:val=\"Heading1\"/>");
+        for (int p = 0; p < 8; ++p) {
+            body += "<w:p><w:pPr><w:spacing w:after=\"160\"/></w:pPr>";
+            for (int run = 0; run < 4; ++run) {
+                body += "<w:r><w:rPr><w:rFonts w:ascii=\"Calibri\"/><w:sz w:val=\"22\"/>"
+                        "</w:rPr><w:t xml:space=\"preserve\">Run " + std::to_string(run) +
+                        " of a paragraph with enough words &amp; symbols to fill a line. "
+                        "</w:t></w:r>";
+            }
+            body += "</w:p>";
+            paragraphs++;
+        }
+        body += para("item", "<w:numPr><w:ilvl w:val=\"0\"/><w:numId w:val=\"2\"/></w:numPr>");
+        if (page % 5 == 0) {
+            body += "<w:tbl><w:tblGrid><w:gridCol w:w=\"2000\"/><w:gridCol w:w=\"2000\"/>"
+                    "</w:tblGrid>";
+            for (int row = 0; row < 6; ++row) {
+                body += "<w:tr>" + cell("cell " + std::to_string(row)) + cell("value") + "</w:tr>";
+            }
+            body += "</w:tbl>";
+        }
+    }
+    std::string document = docxDocument(body);
+    std::string path = guard.path("big.docx");
+    writeZip(path, {{"word/document.xml", document},
+                    {"word/styles.xml", DOCX_STYLES},
+                    {"word/numbering.xml", DOCX_NUMBERING}});
+
+    TextBuffer buffer;
+    DocumentSettings settings;
+    TableList tables;
+    auto start = std::chrono::high_resolution_clock::now();
+    REQUIRE(importOfficeDocument(buffer, settings, tables, nullptr, path).success);
+    auto end = std::chrono::high_resolution_clock::now();
+    REQUIRE(buffer.lineCount() == 200 * 10);
+    REQUIRE(tables.size() == 40);
+
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    std::printf("\n=== DOCX Import Benchmark ===\n");
+    std::printf("  document.xml: %zu KB (zip %ju KB), %zu lines\n", document.size() / 1024,
+                std::filesystem::file_size(path) / 1024, buffer.lineCount());
+    std::printf("  Import: %.2f ms\n", ms);
+    REQUIRE(ms < 1000.0);
+}
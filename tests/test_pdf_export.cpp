@@ -0,0 +1,228 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/editor/export/export_pdf.h"
+#include "../src/editor/export/ttf_font.h"
+#include "../src/editor/flate.h"
+#include "catch2/catch.hpp"
+#include "test_helpers.h"
+
+namespace {
+const char* kFontPath = "resources/fonts/EBGaramond-Regular.ttf";
+
+// Every xref entry must point at the "N 0 obj" it names
+bool xrefMatchesObjects(const std::string& pdf) {
+    std::size_t startxref = pdf.rfind("startxref\n");
+    if (startxref == std::string::npos) return false;
+    std::size_t xref = std::stoul(pdf.substr(startxref + 10));
+    if (pdf.compare(xref, 5, "xref\n") != 0) return false;
+    std::istringstream table(pdf.substr(xref + 5));
+    std::size_t first = 0, count = 0;
+    table >> first >> count;
+    std::string offset, generation, kind;
+    table >> offset >> generation >> kind;  // Object 0, the free list head
+    for (std::size_t id = 1; id < count; ++id) {
+        if (!(table >> offset >> generation >> kind) || kind != "n") return false;
+        std::string expected = std::to_string(id) + " 0 obj\n";
+        if (pdf.compare(std::stoul(offset), expected.size(), expected) != 0) return false;
+    }
+    return true;
+}
+
+// The decoded data of the first stream after "from"
+std::string firstStream(const std::string& pdf, std::size_t from = 0) {
+    std::size_t start = pdf.find("stream\n", from);
+    std::size_t lengthAt = pdf.rfind("/Length ", start);
+    std::size_t length = std::stoul(pdf.substr(lengthAt + 8));
+    std::string data;
+    flate::decompress(std::string_view(pdf).substr(start + 7, length), data);
+    return data;
+}
+
+std::string paragraph(int n) {
+    return "Paragraph " + std::to_string(n) +
+           " runs on well past the right margin of the page so that it has to be wrapped "
+           "onto a second and probably a third line before the next one can start.";
+}
+}  // namespace
+
+TEST_CASE("Flate round trip", "[pdf_export]") {
+    std::string repetitive;
+    for (int i = 0; i < 2000; ++i) repetitive += "BT /F1 12 Tf 72 " + std::to_string(i) + " Td ";
+    std::string noisy;
+    std::uint32_t state = 12345;
+    for (int i = 0; i < 100000; ++i) {
+        state = state * 1103515245 + 12345;
+        noisy.push_back(static_cast<char>(state >> 24));
+    }
+    for (const std::string& input : {std::string(), std::string("a"), std::string(70000, 'x'),
+                                     repetitive, noisy}) {
+        std::string packed = flate::compress(input);
+        std::string unpacked;
+        REQUIRE(flate::decompress(packed, unpacked));
+        REQUIRE(unpacked == input);
+    }
+    REQUIRE(flate::compress(repetitive).size() < repetitive.size() / 4);
+    REQUIRE(flate::compress(noisy).size() < noisy.size() + 32);  // Stored, not expanded
+
+    SECTION("decodes dynamic Huffman blocks written by zlib") {
+        const unsigned char zlibStream[] = {
+            0x78, 0xDA, 0xB5, 0xCB, 0xD9, 0x11, 0x40, 0x30, 0x14, 0x46, 0xE1, 0x56, 0x7E, 0x0D,
+            0x18, 0xFB, 0xD2, 0x85, 0x07, 0x0D, 0x58, 0x42, 0x62, 0xBB, 0x84, 0x58, 0x52, 0xBD,
+            0x5B, 0x83, 0x19, 0xCF, 0xE7, 0x3B, 0xA5, 0x14, 0xD8, 0x8C, 0x6A, 0x46, 0xD4, 0x9A,
+            0xAE, 0x05, 0x1D, 0xDD, 0x18, 0xCC, 0xBC, 0xEE, 0xA0, 0x53, 0x68, 0x1C, 0x9C, 0xA7,
+            0xCA, 0x3E, 0x68, 0xA9, 0x77, 0x51, 0xFE, 0x86, 0x8B, 0x8A, 0xDD, 0xFC, 0xA0, 0x66,
+            0x74, 0xA9, 0x43, 0xA2, 0x53, 0xA7, 0xE0, 0x64, 0xC5, 0x82, 0x49, 0x6D, 0x86, 0x34,
+            0xBF, 0xFD, 0xEE, 0xC0, 0xF3, 0x83, 0x30, 0x8A, 0x93, 0x34, 0xCB, 0x3F, 0x3D, 0x2F,
+            0xDE, 0x17, 0x52, 0x24};
+        std::string expected;
+        for (int i = 0; i < 3; ++i) expected += "The quick brown fox jumps over the lazy dog. ";
+        for (int i = 0; i < 2; ++i) expected += "Pack my box with five dozen liquor jugs! 0123456789 ";
+        std::string out;
+        REQUIRE(flate::decompress(
+            std::string_view(reinterpret_cast<const char*>(zlibStream), sizeof(zlibStream)), out));
+        REQUIRE(out == expected);
+    }
+
+    SECTION("rejects corrupt input") {
+        std::string packed = flate::compress(repetitive);
+        std::string out;
+        packed[packed.size() - 1] ^= 1;  // Checksum
+        REQUIRE_FALSE(flate::decompress(packed, out));
+        out.clear();
+        REQUIRE_FALSE(flate::decompress(packed.substr(0, packed.size() / 2), out));
+        out.clear();
+        REQUIRE_FALSE(flate::inflate("\xFF\xFF\xFF", out));
+    }
+
+    SECTION("stops at the output limit") {
+        std::string packed = flate::compress(repetitive);
+        std::string_view raw = std::string_view(packed).substr(2, packed.size() - 6);
+        std::string out;
+        REQUIRE(flate::inflate(raw, out, repetitive.size()));
+        REQUIRE(out == repetitive);
+        out.clear();
+        REQUIRE_FALSE(flate::inflate(raw, out, repetitive.size() - 1));
+        REQUIRE(out.size() < repetitive.size());
+    }
+}
+
+TEST_CASE("TrueTypeFont measures and subsets", "[pdf_export]") {
+    TrueTypeFont font;
+    REQUIRE(font.loadFile(kFontPath));
+    REQUIRE_FALSE(font.postScriptName().empty());
+    TrueTypeFont::GlyphId a = font.glyphFor(U'A');
+    TrueTypeFont::GlyphId m = font.glyphFor(U'm');
+    REQUIRE(a != 0);
+    REQUIRE(font.advance(m) > font.advance(font.glyphFor(U'i')));
+    REQUIRE(font.glyphFor(0x10FFFD) == 0);
+
+    std::vector<bool> used(font.glyphCount(), false);
+    used[a] = true;
+    used[m] = true;
+    std::string subset = font.subset(used);
+    REQUIRE(subset.size() < font.fileSize() / 2);
+
+    // Loads again, with the same glyph ids and metrics
+    TrueTypeFont reloaded;
+    REQUIRE(reloaded.load(subset));
+    REQUIRE(reloaded.glyphCount() == font.glyphCount());
+    REQUIRE(reloaded.glyphFor(U'A') == a);
+    REQUIRE(reloaded.advance(m) == font.advance(m));
+    REQUIRE(reloaded.unitsPerEm() == font.unitsPerEm());
+
+    TrueTypeFont notTrueType;
+    REQUIRE_FALSE(notTrueType.load("OTTO and some bytes"));
+}
+
+TEST_CASE("PDF export paginates and embeds the font", "[pdf_export]") {
+    TempDirGuard guard("wordproc_pdf_test");
+    TextBuffer buffer;
+    std::string text;
+    for (int i = 0; i < 120; ++i) text += paragraph(i) + "\n";
+    buffer.setText(text + "Last line");
+    DocumentSettings settings;
+    settings.textStyle.font = "Garamond";
+
+    std::string path = guard.path("paged.pdf");
+    DocumentResult result = exportDocumentPdf(buffer, settings, path);
+    REQUIRE(result.success);
+    std::string pdf = readBytes(path);
+    REQUIRE(pdf.rfind("%PDF-1.5", 0) == 0);
+    REQUIRE(xrefMatchesObjects(pdf));
+
+    std::size_t pages = countOf(pdf, "/Type /Page ");
+    REQUIRE(pages > 5);
+    REQUIRE(pdf.find("/Count " + std::to_string(pages) + " ") != std::string::npos);
+
+    // Flate-compressed page content with glyph ids for the embedded font
+    REQUIRE(pdf.find("/Filter /FlateDecode") != std::string::npos);
+    std::string content = firstStream(pdf);
+    REQUIRE(content.find("Tj") != std::string::npos);
+    REQUIRE(content.find("/F1 16 Tf") != std::string::npos);
+    REQUIRE(pdf.find("/Subtype /CIDFontType2") != std::string::npos);
+    REQUIRE(pdf.find("/FontFile2") != std::string::npos);
+    REQUIRE(pdf.find("/ToUnicode") != std::string::npos);
+    // Only the glyphs used: far smaller than the 550 KB font file
+    REQUIRE(pdf.size() < 200 * 1024);
+
+    SECTION("page breaks and headings") {
+        TextBuffer shortDoc;
+        shortDoc.setText("Title\nFirst page\nSecond page");
+        ParagraphFormat heading;
+        heading.style = ParagraphStyle::Title;
+        shortDoc.setLineFormat(0, heading);
+        ParagraphFormat broken;
+        broken.hasPageBreakBefore = true;
+        shortDoc.setLineFormat(2, broken);
+
+        std::string brokenPath = guard.path("breaks.pdf");
+        REQUIRE(exportDocumentPdf(shortDoc, settings, brokenPath).success);
+        std::string out = readBytes(brokenPath);
+        REQUIRE(countOf(out, "/Type /Page ") == 2);
+        REQUIRE(firstStream(out).find("/F1 32 Tf") != std::string::npos);
+    }
+
+    SECTION("falls back to Helvetica without the font file") {
+        PdfExportOptions options;
+        options.fontDirectory = guard.path("no_fonts");
+        options.compress = false;
+        std::string plainPath = guard.path("plain.pdf");
+        REQUIRE(exportDocumentPdf(buffer, settings, plainPath, options).success);
+        std::string out = readBytes(plainPath);
+        REQUIRE(out.find("/BaseFont /Helvetica") != std::string::npos);
+        REQUIRE(out.find("(Last line) Tj") != std::string::npos);
+        REQUIRE(xrefMatchesObjects(out));
+    }
+}
+
+TEST_CASE("PDF export benchmark - 1000 pages", "[pdf_export][benchmark]") {
+    TempDirGuard guard("wordproc_pdf_test");
+    TextBuffer buffer;
+    std::string text;
+    for (int i = 0; i < 11000; ++i) text += paragraph(i) + "\n";
+    buffer.setText(text);
+    DocumentSettings settings;
+    settings.textStyle.font = "Garamond";
+
+    std::string path = guard.path("long.pdf");
+    auto start = std::chrono::high_resolution_clock::now();
+    DocumentResult result = exportDocumentPdf(buffer, settings, path);
+    auto end = std::chrono::high_resolution_clock::now();
+    REQUIRE(result.success);
+    std::string pdf = readBytes(path);
+    std::size_t pages = countOf(pdf, "/Type /Page ");
+    REQUIRE(pages >= 1000);
+    REQUIRE(xrefMatchesObjects(pdf));
+
+    std::printf("\n=== PDF Export Benchmark ===\n");
+    std::printf("  Pages:     %zu\n", pages);
+    std::printf("  Export:    %.2f ms\n",
+                std::chrono::duration<double, std::milli>(end - start).count());
+    std::printf("  File size: %zu KB\n", pdf.size() / 1024);
+}
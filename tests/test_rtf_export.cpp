@@ -0,0 +1,350 @@
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/editor/export/export_rtf.h"
+#include "catch2/catch.hpp"
+#include "test_helpers.h"
+
+namespace {
+void appendUtf8(std::string& out, std::uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+// What a reader sees of one paragraph or table cell
+struct RtfParagraph {
+    std::string text;
+    std::vector<std::string> controls;  // Control words since \pard, with parameters
+    std::vector<std::string> fields;    // HYPERLINK instructions
+    std::vector<std::pair<std::string, std::size_t>> bookmarks;  // Name, text position
+    bool inTable = false;
+    bool has(const std::string& control) const {
+        for (const auto& c : controls) {
+            if (c == control) return true;
+        }
+        return false;
+    }
+};
+
+// Just enough of an RTF reader to read back what the exporter writes:
+// groups, control words, \u escapes, fields and bookmarks. Header tables
+// and list marker text are skipped the way a word processor skips them.
+struct RtfReader {
+    std::vector<RtfParagraph> paragraphs;
+    std::vector<RtfParagraph> cells;
+
+    explicit RtfReader(const std::string& rtf) {
+        enum class Dest { Text, Skip, Field, BookmarkStart };
+        std::vector<Dest> stack{Dest::Text};
+        RtfParagraph current;
+        std::string captured;
+        std::uint32_t highSurrogate = 0;
+        auto emit = [&](const std::string& text) {
+            if (stack.back() == Dest::Text) current.text += text;
+            if (stack.back() == Dest::Field || stack.back() == Dest::BookmarkStart) captured += text;
+        };
+        std::size_t i = 0;
+        bool groupStart = false;
+        while (i < rtf.size()) {
+            char ch = rtf[i];
+            if (ch == '{') {
+                stack.push_back(stack.back());
+                groupStart = true;
+                i++;
+                continue;
+            }
+            if (ch == '}') {
+                // The end of the destination itself, not a group inside it
+                Dest dest = stack.back();
+                stack.pop_back();
+                if (dest != stack.back()) {
+                    if (dest == Dest::Field) current.fields.push_back(captured);
+                    if (dest == Dest::BookmarkStart) {
+                        current.bookmarks.emplace_back(captured, current.text.size());
+                    }
+                }
+                i++;
+                continue;
+            }
+            if (ch == '\r' || ch == '\n') {
+                i++;
+                continue;
+            }
+            if (ch != '\\') {
+                emit(std::string(1, ch));
+                groupStart = false;
+                i++;
+                continue;
+            }
+            // Control symbol or word
+            char next = rtf[i + 1];
+            if (next == '\\' || next == '{' || next == '}') {
+                emit(std::string(1, next));
+                i += 2;
+                continue;
+            }
+            if (next == '*') {
+                i += 2;
+                // \*\bkmkstart and \*\fldinst are read; other optional
+                // destinations are skipped
+                std::size_t end = rtf.find_first_of(" \\{}", i + 1);
+                std::string word = rtf.substr(i + 1, end - i - 1);
+                if (word == "bkmkstart") {
+                    stack.back() = Dest::BookmarkStart;
+                } else if (word == "fldinst") {
+                    stack.back() = Dest::Field;
+                } else {
+                    stack.back() = Dest::Skip;
+                }
+                captured.clear();
+                i = end;
+                if (rtf[i] == ' ') i++;
+                continue;
+            }
+            std::size_t start = i + 1;
+            std::size_t end = start;
+            while (end < rtf.size() && std::isalpha(static_cast<unsigned char>(rtf[end]))) end++;
+            std::string word = rtf.substr(start, end - start);
+            std::size_t paramEnd = end;
+            if (paramEnd < rtf.size() && rtf[paramEnd] == '-') paramEnd++;
+            while (paramEnd < rtf.size() && std::isdigit(static_cast<unsigned char>(rtf[paramEnd]))) {
+                paramEnd++;
+            }
+            std::string param = rtf.substr(end, paramEnd - end);
+            i = paramEnd;
+            if (i < rtf.size() && rtf[i] == ' ') i++;
+
+            if (groupStart && (word == "fonttbl" || word == "colortbl" || word == "stylesheet" ||
+                               word == "pntext")) {
+                stack.back() = Dest::Skip;
+            }
+            groupStart = false;
+            if (word == "fldinst") {
+                stack.back() = Dest::Field;
+                captured.clear();
+            } else if (word == "u") {
+                int value = std::stoi(param);
+                auto unit = static_cast<std::uint32_t>(value < 0 ? value + 0x10000 : value);
+                if (unit >= 0xD800 && unit < 0xDC00) {
+                    highSurrogate = unit;
+                } else {
+                    std::string utf8;
+                    if (unit >= 0xDC00 && unit < 0xE000) {
+                        unit = 0x10000 + ((highSurrogate - 0xD800) << 10) + (unit - 0xDC00);
+                    }
+                    appendUtf8(utf8, unit);
+                    emit(utf8);
+                }
+                i++;  // The one-character fallback (\uc1)
+            } else if (word == "tab") {
+                emit("\t");
+            } else if (word == "line") {
+                emit("\n");
+            } else if (word == "pard") {
+                current.controls.clear();
+                current.inTable = false;
+            } else if (word == "intbl") {
+                current.inTable = true;
+            } else if (word == "par" || word == "cell") {
+                (word == "par" ? paragraphs : cells).push_back(current);
+                current.text.clear();
+                current.fields.clear();
+                current.bookmarks.clear();
+            } else if (stack.back() == Dest::Text) {
+                current.controls.push_back(word + param);
+            }
+        }
+    }
+};
+
+}  // namespace
+
+TEST_CASE("RTF export round trips text and paragraph formats", "[rtf_export]") {
+    TempDirGuard guard("wordproc_rtf_test");
+    TextBuffer buffer;
+    buffer.setText(
+        "A Title\n"
+        "Braces {like} these \\ and\ttabs\n"
+        "Caf\xC3\xA9 \xE2\x80\x94 \xF0\x9F\x98\x80 \xE4\xB8\x89\n"
+        "Centered\n"
+        "\n"
+        "Bullet\n"
+        "Number\n"
+        "New page with a link and more");
+    ParagraphFormat title;
+    title.style = ParagraphStyle::Title;
+    buffer.setLineFormat(0, title);
+    ParagraphFormat heading;
+    heading.style = ParagraphStyle::Heading2;
+    buffer.setLineFormat(1, heading);
+    ParagraphFormat centered;
+    centered.alignment = TextAlignment::Center;
+    centered.leftIndent = 36;
+    centered.firstLineIndent = 18;
+    centered.spaceBefore = 6;
+    centered.spaceAfter = 12;
+    centered.lineSpacing = 1.5f;
+    buffer.setLineFormat(3, centered);
+    buffer.setLineFormat(5, listItem(ListType::Bulleted, 1));
+    buffer.setLineFormat(6, listItem(ListType::Numbered, 0, 3));
+    ParagraphFormat broken;
+    broken.hasPageBreakBefore = true;
+    buffer.setLineFormat(7, broken);
+
+    std::size_t lastLine = buffer.lineExtent(7).offset;
+    REQUIRE(buffer.addHyperlinkAt(lastLine + 16, lastLine + 20, "https://example.com/a\"b"));
+    REQUIRE(buffer.addHyperlinkAt(lastLine, lastLine + 3, "#top"));
+    REQUIRE(buffer.addBookmarkAt("top", 2));
+    REQUIRE(buffer.addBookmarkAt("end", buffer.getText().size()));
+
+    DocumentSettings settings;
+    settings.textStyle.font = "Garamond";
+    settings.textStyle.fontSize = 12;
+    std::string path = guard.path("round_trip.rtf");
+    REQUIRE(exportDocumentRtf(buffer, settings, path).success);
+    std::string rtf = readBytes(path);
+    REQUIRE(rtf.rfind("{\\rtf1\\ansi", 0) == 0);
+    REQUIRE(rtf.find("{\\fonttbl{\\f0\\fnil Garamond;}}") != std::string::npos);
+    REQUIRE(rtf.find("{\\s3\\outlinelevel0\\f0\\fs42\\b\\sbasedon0\\snext0 Heading 1;}") !=
+            std::string::npos);
+    // Only ASCII in the file
+    for (char ch : rtf) REQUIRE(static_cast<unsigned char>(ch) < 0x80);
+
+    RtfReader reader(rtf);
+    REQUIRE(reader.paragraphs.size() == buffer.lineCount());
+    for (std::size_t row = 0; row < buffer.lineCount(); ++row) {
+        REQUIRE(reader.paragraphs[row].text == buffer.lineString(row));
+    }
+
+    const auto& p = reader.paragraphs;
+    REQUIRE(p[0].has("s1"));
+    REQUIRE(p[0].has("fs48"));
+    REQUIRE(p[0].has("b"));
+    REQUIRE(p[1].has("s4"));
+    REQUIRE(p[1].has("outlinelevel1"));
+    REQUIRE(p[2].has("s0"));
+    REQUIRE(p[2].has("fs24"));
+    REQUIRE_FALSE(p[2].has("b"));
+    REQUIRE(p[3].has("qc"));
+    REQUIRE(p[3].has("li720"));
+    REQUIRE(p[3].has("fi360"));
+    REQUIRE(p[3].has("sb120"));
+    REQUIRE(p[3].has("sa240"));
+    REQUIRE(p[3].has("sl360"));
+    REQUIRE(p[3].has("slmult1"));
+    REQUIRE(p[5].has("li720"));
+    REQUIRE(p[5].has("fi-360"));
+    REQUIRE(p[6].has("li360"));
+    REQUIRE(rtf.find("{\\pntext\\f0 3.\\tab}{\\*\\pn\\pnlvlbody\\pndec\\pnstart3") !=
+            std::string::npos);
+    REQUIRE(p[7].has("pagebb"));
+    REQUIRE_FALSE(p[6].has("pagebb"));
+
+    REQUIRE(p[7].fields.size() == 2);
+    REQUIRE(p[7].fields[0] == "HYPERLINK \\l \"top\"");
+    REQUIRE(p[7].fields[1] == "HYPERLINK \"https://example.com/a'b\"");
+    REQUIRE(p[0].bookmarks.size() == 1);
+    REQUIRE(p[0].bookmarks[0] == std::make_pair(std::string("top"), std::size_t{2}));
+    REQUIRE(p[7].bookmarks.size() == 1);
+    REQUIRE(p[7].bookmarks[0].second == buffer.lineString(7).size());
+}
+
+TEST_CASE("RTF export writes tables at their line", "[rtf_export]") {
+    TempDirGuard guard("wordproc_rtf_test");
+    TextBuffer buffer;
+    buffer.setText("Before\nAfter");
+    Table table(2, 3);
+    table.setCellContent(0, 0, "Name");
+    table.setCellContent(0, 1, "Wide {cell}");
+    table.setCellContent(1, 0, "Two\nlines");
+    table.cell(1, 2).backgroundColor = TextColor{255, 255, 0, 255};
+    REQUIRE(table.mergeCells({0, 1}, {0, 2}));
+    TableList tables;
+    tables.emplace_back(1, table);
+
+    DocumentSettings settings;
+    std::string path = guard.path("table.rtf");
+    REQUIRE(exportDocumentRtf(buffer, settings, tables, path).success);
+    std::string rtf = readBytes(path);
+    RtfReader reader(rtf);
+
+    REQUIRE(reader.paragraphs.size() == 2);
+    REQUIRE(reader.cells.size() == 6);
+    REQUIRE(reader.cells[0].text == "Name");
+    REQUIRE(reader.cells[1].text == "Wide {cell}");
+    REQUIRE(reader.cells[2].text.empty());
+    REQUIRE(reader.cells[3].text == "Two\nlines");
+    for (const auto& cell : reader.cells) REQUIRE(cell.inTable);
+    std::size_t rows = 0;
+    for (std::size_t pos = rtf.find("\\row\n"); pos != std::string::npos;
+         pos = rtf.find("\\row\n", pos + 1)) {
+        rows++;
+    }
+    REQUIRE(rows == 2);
+    REQUIRE(rtf.find("\\clmgf") != std::string::npos);
+    REQUIRE(rtf.find("\\clmrg") != std::string::npos);
+    REQUIRE(rtf.find("\\red255\\green255\\blue0;") != std::string::npos);
+    REQUIRE(rtf.find("\\clcbpat3") != std::string::npos);
+    // The table comes between the two paragraphs
+    REQUIRE(rtf.find("Before\\par") < rtf.find("\\trowd"));
+    REQUIRE(rtf.find("\\row") < rtf.find("After\\par"));
+}
+
+TEST_CASE("RTF export benchmark - throughput", "[rtf_export][benchmark]") {
+    TempDirGuard guard("wordproc_rtf_test");
+    TextBuffer buffer;
+    std::string text;
+    for (int i = 0; i < 120000; ++i) {
+        text += "Paragraph " + std::to_string(i) +
+                " with {braces}, a back\\slash, caf\xC3\xA9 and enough plain prose to fill a line.\n";
+    }
+    buffer.setText(text);
+    // Move the gap into the middle so text is read from both sides of it
+    buffer.setCaret(CaretPosition{buffer.lineCount() / 2, 3});
+    buffer.insertText("x");
+    for (std::size_t row = 0; row < buffer.lineCount(); row += 40) {
+        ParagraphFormat heading;
+        heading.style = ParagraphStyle::Heading2;
+        buffer.setLineFormat(row, heading);
+        buffer.setLineFormat(row + 1, listItem(ListType::Bulleted, 0));
+    }
+    DocumentSettings settings;
+
+    std::string path = guard.path("big.rtf");
+    auto start = std::chrono::high_resolution_clock::now();
+    REQUIRE(exportDocumentRtf(buffer, settings, path).success);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::string rtf = readBytes(path);
+    RtfReader reader(rtf);
+    REQUIRE(reader.paragraphs.size() == buffer.lineCount());
+    std::size_t middle = buffer.lineCount() / 2;
+    REQUIRE(reader.paragraphs[middle].text == buffer.lineString(middle));
+    REQUIRE(reader.paragraphs[middle + 1].text == buffer.lineString(middle + 1));
+
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    std::printf("\n=== RTF Export Benchmark ===\n");
+    std::printf("  Input:  %zu KB, %zu paragraphs\n", text.size() / 1024, buffer.lineCount());
+    std::printf("  Output: %zu KB\n", rtf.size() / 1024);
+    std::printf("  Export: %.2f ms (%.1f MB/s of text)\n", ms,
+                static_cast<double>(text.size()) / (1024.0 * 1024.0) / (ms / 1000.0));
+}
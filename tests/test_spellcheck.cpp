@@ -1,6 +1,15 @@
 #include "../src/editor/spellcheck.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <tuple>
+
 #include "catch2/catch.hpp"
+#include "spellcheck_reference.h"
 
 // ============================================================================
 // SpellChecker Tests
@@ -252,6 +261,122 @@ TEST_CASE("SpellChecker - checkWord function", "[spellcheck]") {
     }
 }
 
+namespace {
+// Misspell a word with one or two random edits
+std::string misspell(const std::string& word, std::mt19937& rng) {
+    std::string out = word;
+    int edits = 1 + static_cast<int>(rng() % 2);
+    for (int e = 0; e < edits && !out.empty(); ++e) {
+        std::size_t pos = rng() % out.size();
+        char letter = static_cast<char>('a' + rng() % 26);
+        switch (rng() % 4) {
+            case 0: out[pos] = letter; break;
+            case 1: out.insert(out.begin() + static_cast<long>(pos), letter); break;
+            case 2: out.erase(pos, 1); break;
+            default:
+                if (pos + 1 < out.size()) std::swap(out[pos], out[pos + 1]);
+                break;
+        }
+    }
+    return out;
+}
+}  // namespace
+
+TEST_CASE("SpellChecker - Indexed suggestions match brute force", "[spellcheck]") {
+    SpellChecker checker;
+    checker.addToUserDictionary("wordproc");
+    checker.addToUserDictionary("the");  // Duplicate of a dictionary word
+
+    std::vector<std::string> words;
+    checker.dictionary().forEachWithPrefix("", [&](std::string_view w) {
+        words.emplace_back(w);
+        return true;
+    });
+    REQUIRE_FALSE(words.empty());
+
+    std::mt19937 rng(1234);
+    std::size_t compared = 0;
+    for (int i = 0; i < 400; ++i) {
+        std::string typo = misspell(words[rng() % words.size()], rng);
+        for (std::size_t k : {1u, 3u, 5u, 10u}) {
+            REQUIRE(checker.getSuggestions(typo, k) == linearSuggestions(checker, typo, k));
+        }
+        ++compared;
+    }
+    REQUIRE(compared == 400);
+
+    SECTION("user words are suggested") {
+        auto suggestions = checker.getSuggestions("wordprok");
+        REQUIRE(std::find(suggestions.begin(), suggestions.end(), "wordproc") !=
+                suggestions.end());
+    }
+
+    SECTION("zero suggestions requested") {
+        REQUIRE(checker.getSuggestions("teh", 0).empty());
+    }
+}
+
+TEST_CASE("SpellChecker benchmark - indexed vs brute-force suggestions",
+          "[spellcheck][benchmark]") {
+    // Large synthetic dictionary so the difference is visible
+    auto dir = std::filesystem::temp_directory_path() / "wordproc_suggest_bench";
+    std::filesystem::create_directories(dir);
+    std::string listPath = (dir / "words.txt").string();
+
+    // Pseudo-words built from common stems and suffixes give a dictionary
+    // about as dense as a real word list
+    static const char* stems[] = {"read", "writ", "edit", "form", "print", "page",
+                                  "line", "word", "text", "font", "spell", "check"};
+    static const char* suffixes[] = {"", "s", "ed", "er", "ers", "ing", "able", "ly"};
+    std::mt19937 rng(99);
+    std::vector<std::string> words;
+    {
+        std::ofstream out(listPath);
+        for (int i = 0; i < 100000; ++i) {
+            std::string w;
+            std::size_t extra = 1 + rng() % 3;
+            for (std::size_t j = 0; j < extra; ++j) w.push_back(static_cast<char>('a' + rng() % 26));
+            w += stems[rng() % 12];
+            w += suffixes[rng() % 8];
+            out << w << '\n';
+            words.push_back(std::move(w));
+        }
+    }
+
+    SpellChecker checker;
+    REQUIRE(checker.loadDictionary(listPath));
+
+    std::vector<std::string> typos;
+    for (int i = 0; i < 50; ++i) {
+        std::string typo = misspell(words[rng() % words.size()], rng);
+        if (!checker.isCorrect(typo)) typos.push_back(typo);
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::size_t indexedCount = 0;
+    for (const auto& typo : typos) indexedCount += checker.getSuggestions(typo).size();
+    auto mid = std::chrono::high_resolution_clock::now();
+    std::size_t linearCount = 0;
+    for (const auto& typo : typos) linearCount += linearSuggestions(checker, typo).size();
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double indexedUs = std::chrono::duration<double, std::micro>(mid - start).count() /
+                       static_cast<double>(typos.size());
+    double linearUs = std::chrono::duration<double, std::micro>(end - mid).count() /
+                      static_cast<double>(typos.size());
+
+    std::printf("\n=== Suggestion Benchmark (%zu words, %zu typos) ===\n",
+                checker.dictionarySize(), typos.size());
+    std::printf("  Indexed (DAWG Levenshtein): %.1f us/word\n", indexedUs);
+    std::printf("  Brute force:                %.1f us/word\n", linearUs);
+    std::printf("  Speedup: %.1fx\n", linearUs / indexedUs);
+
+    REQUIRE(indexedCount == linearCount);
+    REQUIRE(indexedUs < linearUs);
+
+    std::filesystem::remove_all(dir);
+}
+
 // ============================================================================
 // GrammarChecker Tests
 // ============================================================================
@@ -431,6 +556,166 @@ TEST_CASE("GrammarChecker - Combined checks", "[grammar]") {
     }
 }
 
+namespace {
+// Random prose mixing the phrases and punctuation every built-in rule reacts to
+std::string grammarFuzzText(std::mt19937& rng, std::size_t pieces) {
+    static const char* parts[] = {
+        "the", "The", "THE", "a", "quick", "fox", "could of", "Could Of", "alot",
+        "alots", "xalot", "thier", "wierd", "your welcome", "seperate", "don't",
+        "'tis", "''", "it's", "its", "42", "done", "should   of", "would of",
+        "occurence", "occurenced", "untill"};
+    static const char* separators[] = {" ", " ", " ", "  ", "   ", ". ", "! ", "? ",
+                                       ".", ", ", "\n", "\t", ".\n", " - ", "\r\n"};
+    std::string text;
+    for (std::size_t i = 0; i < pieces; ++i) {
+        text += parts[rng() % (sizeof(parts) / sizeof(parts[0]))];
+        text += separators[rng() % (sizeof(separators) / sizeof(separators[0]))];
+    }
+    return text;
+}
+
+std::vector<GrammarError> canonicalOrder(std::vector<GrammarError> errors) {
+    std::sort(errors.begin(), errors.end(), [](const auto& a, const auto& b) {
+        return std::tie(a.offset, a.ruleId, a.length, a.text) <
+               std::tie(b.offset, b.ruleId, b.length, b.text);
+    });
+    return errors;
+}
+}  // namespace
+
+TEST_CASE("GrammarChecker - single pass matches multi-pass reference", "[grammar]") {
+    GrammarChecker checker;
+    std::mt19937 rng(1234);
+
+    for (int round = 0; round < 300; ++round) {
+        std::string text = grammarFuzzText(rng, 1 + rng() % 40);
+        auto single = canonicalOrder(checker.checkText(text));
+        auto multi = canonicalOrder(multiPassGrammarCheck(checker, text));
+
+        INFO("text: " << text);
+        REQUIRE(single.size() == multi.size());
+        for (std::size_t i = 0; i < single.size(); ++i) {
+            REQUIRE(single[i].offset == multi[i].offset);
+            REQUIRE(single[i].length == multi[i].length);
+            REQUIRE(single[i].ruleId == multi[i].ruleId);
+            REQUIRE(single[i].text == multi[i].text);
+            REQUIRE(single[i].message == multi[i].message);
+            REQUIRE(single[i].suggestion == multi[i].suggestion);
+        }
+    }
+
+    SECTION("disabled rules are skipped by both paths") {
+        checker.disableRule("REPEATED_WORD");
+        checker.disableRule("COMMON_ERRORS");
+        std::string text = "the the could of alot.  hello";
+        REQUIRE(canonicalOrder(checker.checkText(text)).size() ==
+                multiPassGrammarCheck(checker, text).size());
+    }
+}
+
+TEST_CASE("GrammarChecker - pluggable rules and profiling", "[grammar]") {
+    GrammarChecker checker;
+
+    SECTION("phrase matcher finds overlapping phrases in one pass") {
+        PhraseMatcher matcher({"he", "she", "hers", "his"});
+        std::vector<std::pair<std::size_t, std::size_t>> hits;  // (end, phrase)
+        std::string text = "ushers";
+        std::uint32_t state = 0;
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            state = matcher.step(state, text[i]);
+            for (auto it = matcher.matchesBegin(state); it != matcher.matchesEnd(state); ++it) {
+                hits.emplace_back(i + 1, *it);
+            }
+        }
+        std::sort(hits.begin(), hits.end());
+        REQUIRE(hits == std::vector<std::pair<std::size_t, std::size_t>>{
+                            {4, 0}, {4, 1}, {6, 2}});
+    }
+
+    SECTION("custom phrase rule") {
+        checker.addRule(std::make_shared<PhraseRule>(
+            "HOUSE_STYLE",
+            std::vector<GrammarPhrase>{{"e-mail", "email", "House style is \"email\""},
+                                       {"web site", "website", "House style is \"website\""}}));
+        REQUIRE(checker.availableRules().size() == 5);
+
+        auto errors = checker.checkText("Send an E-mail about the web site.");
+        std::vector<std::string> suggestions;
+        for (const auto& e : errors) {
+            if (e.ruleId == "HOUSE_STYLE") suggestions.push_back(e.suggestion);
+        }
+        REQUIRE(suggestions == std::vector<std::string>{"email", "website"});
+
+        checker.disableRule("HOUSE_STYLE");
+        for (const auto& e : checker.checkText("Send an e-mail.")) {
+            REQUIRE(e.ruleId != "HOUSE_STYLE");
+        }
+    }
+
+    SECTION("replacing a built-in rule by id") {
+        checker.addRule(std::make_shared<PhraseRule>(
+            "COMMON_ERRORS", std::vector<GrammarPhrase>{{"irregardless", "regardless", "Nonstandard"}}));
+        REQUIRE(checker.availableRules().size() == 4);
+        auto errors = checker.checkText("Irregardless, alot happened.");
+        REQUIRE(errors.size() == 1);
+        REQUIRE(errors[0].suggestion == "regardless");
+    }
+
+    SECTION("profile accumulates per-rule counters") {
+        GrammarProfile profile;
+        checker.checkText("hello  the the world. Could of done it.", &profile);
+        checker.checkText("Fine text here.", &profile);
+
+        REQUIRE(profile.runs == 2);
+        REQUIRE(profile.tokens > 0);
+        REQUIRE(profile.rules.size() == 4);
+        REQUIRE(profile.find("DOUBLE_SPACE")->errors == 1);
+        REQUIRE(profile.find("REPEATED_WORD")->errors == 1);
+        REQUIRE(profile.find("COMMON_ERRORS")->errors == 1);
+        REQUIRE(profile.find("SENTENCE_CAPITALIZATION")->errors == 1);
+        REQUIRE(profile.find("MISSING") == nullptr);
+    }
+}
+
+TEST_CASE("GrammarChecker benchmark - single pass vs multi-pass", "[grammar][benchmark]") {
+    // Mostly clean prose with an occasional mistake every few sentences
+    static const char* words[] = {"quick", "brown", "fox", "jumps", "over", "lazy",
+                                  "dog", "and", "then", "runs", "away", "from", "home"};
+    GrammarChecker checker;
+    std::mt19937 rng(99);
+    std::string text;
+    for (int sentence = 0; sentence < 25000; ++sentence) {
+        text += "The";
+        for (int w = 0; w < 10; ++w) {
+            text += ' ';
+            text += words[rng() % (sizeof(words) / sizeof(words[0]))];
+        }
+        text += (sentence % 50 == 0) ? " could of  alot. " : ". ";
+    }
+
+    auto singleStart = std::chrono::high_resolution_clock::now();
+    GrammarProfile profile;
+    auto single = checker.checkText(text, &profile);
+    auto singleEnd = std::chrono::high_resolution_clock::now();
+    auto multi = multiPassGrammarCheck(checker, text);
+    auto multiEnd = std::chrono::high_resolution_clock::now();
+
+    double singleMs = std::chrono::duration<double, std::milli>(singleEnd - singleStart).count();
+    double multiMs = std::chrono::duration<double, std::milli>(multiEnd - singleEnd).count();
+
+    std::printf("\n=== Grammar Engine Benchmark (%zu KB, %zu tokens) ===\n",
+                text.size() / 1024, profile.tokens);
+    std::printf("  Single pass: %.1f ms (tokenize %.1f ms)\n", singleMs,
+                static_cast<double>(profile.tokenizeNanoseconds) / 1e6);
+    for (const auto& rule : profile.rules) {
+        std::printf("    %-24s %8.1f ms  %zu errors\n", rule.ruleId.c_str(),
+                    static_cast<double>(rule.nanoseconds) / 1e6, rule.errors);
+    }
+    std::printf("  Multi-pass:  %.1f ms\n", multiMs);
+
+    REQUIRE(single.size() == multi.size());
+}
+
 // ============================================================================
 // SpellingError struct tests
 // ============================================================================
@@ -1,3 +1,6 @@
+#include <chrono>
+#include <cstdio>
+
 #include "../src/editor/table.h"
 #include "catch2/catch.hpp"
 
@@ -444,6 +447,122 @@ TEST_CASE("Table cellAtPoint", "[table]") {
     }
 }
 
+TEST_CASE("Table geometry follows structure changes", "[table]") {
+    Table table(3, 3);
+    table.setColWidth(0, 50.0f);
+    table.setColWidth(1, 60.0f);
+    table.setColWidth(2, 70.0f);
+    table.setRowHeight(0, 20.0f);
+    table.setRowHeight(1, 30.0f);
+    table.setRowHeight(2, 40.0f);
+    table.setCellContent(1, 1, "middle");
+    table.setCellContent(2, 2, "corner");
+
+    SECTION("inserting a column shifts later cells and offsets") {
+        table.insertColumnLeft(1);
+        REQUIRE(table.colCount() == 4);
+        REQUIRE(table.getCellContent(1, 2) == "middle");
+        REQUIRE(table.getCellContent(2, 3) == "corner");
+        REQUIRE(table.getCellContent(1, 1).empty());
+        REQUIRE(table.cellBounds({0, 2}).x == 150.0f);  // 50 + 100 (default)
+        REQUIRE(table.totalWidth() == 280.0f);
+        REQUIRE(table.cellAtPoint(149.0f, 0.0f).col == 1);
+    }
+
+    SECTION("deleting a column keeps the other cells in place") {
+        table.deleteColumn(0);
+        REQUIRE(table.colCount() == 2);
+        REQUIRE(table.getCellContent(1, 0) == "middle");
+        REQUIRE(table.getCellContent(2, 1) == "corner");
+        REQUIRE(table.cellBounds({2, 1}).x == 60.0f);
+        REQUIRE(table.totalWidth() == 130.0f);
+    }
+
+    SECTION("inserting and deleting rows updates y offsets") {
+        table.insertRowAbove(0);
+        REQUIRE(table.getCellContent(2, 1) == "middle");
+        REQUIRE(table.cellBounds({3, 2}).y == 74.0f);  // 24 (default) + 20 + 30
+        table.deleteRow(1);
+        REQUIRE(table.cellBounds({2, 2}).y == 54.0f);
+        REQUIRE(table.getCellContent(2, 2) == "corner");
+        REQUIRE(table.totalHeight() == 94.0f);
+    }
+
+    SECTION("cellAtPoint clamps past the far edges") {
+        CellPosition pos = table.cellAtPoint(1000.0f, 1000.0f);
+        REQUIRE(pos.row == 2);
+        REQUIRE(pos.col == 2);
+    }
+}
+
+TEST_CASE("Table visibleRows", "[table]") {
+    Table table(4, 2);  // Rows 24 high: 0-24, 24-48, 48-72, 72-96
+
+    SECTION("range covering part of the table") {
+        auto rows = table.visibleRows(30.0f, 60.0f);
+        REQUIRE(rows.first == 1);
+        REQUIRE(rows.last == 3);
+    }
+
+    SECTION("row edges are not counted as overlap") {
+        auto rows = table.visibleRows(24.0f, 48.0f);
+        REQUIRE(rows.first == 1);
+        REQUIRE(rows.last == 2);
+    }
+
+    SECTION("range larger than the table") {
+        auto rows = table.visibleRows(-100.0f, 1000.0f);
+        REQUIRE(rows.first == 0);
+        REQUIRE(rows.last == 4);
+    }
+
+    SECTION("range outside the table is empty") {
+        auto above = table.visibleRows(-50.0f, 0.0f);
+        REQUIRE(above.first == above.last);
+        auto below = table.visibleRows(96.0f, 200.0f);
+        REQUIRE(below.first == below.last);
+    }
+}
+
+TEST_CASE("Table large hit test benchmark", "[table][benchmark]") {
+    Table table(500, 20);
+    for (std::size_t r = 0; r < table.rowCount(); ++r) {
+        table.setRowHeight(r, 20.0f + static_cast<float>(r % 3));
+    }
+
+    // One frame's worth of work: bounds for every visible cell plus a hit
+    // test per cell, repeated for a scroll through the whole table
+    auto start = std::chrono::high_resolution_clock::now();
+    std::size_t hits = 0;
+    for (float top = 0.0f; top < table.totalHeight(); top += 500.0f) {
+        auto rows = table.visibleRows(top, top + 800.0f);
+        for (std::size_t r = rows.first; r < rows.last; ++r) {
+            for (std::size_t c = 0; c < table.colCount(); ++c) {
+                auto bounds = table.cellBounds({r, c});
+                CellPosition pos = table.cellAtPoint(bounds.x + 1.0f, bounds.y + 1.0f);
+                if (pos.row == r && pos.col == c) ++hits;
+            }
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    REQUIRE(hits > 0);
+
+    std::size_t all = 0;
+    for (std::size_t r = 0; r < table.rowCount(); ++r) {
+        for (std::size_t c = 0; c < table.colCount(); ++c) {
+            auto bounds = table.cellBounds({r, c});
+            CellPosition pos = table.cellAtPoint(bounds.x + 1.0f, bounds.y + 1.0f);
+            if (pos.row == r && pos.col == c) ++all;
+        }
+    }
+    REQUIRE(all == 500 * 20);
+
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    std::printf("\n=== Table Hit Test Benchmark ===\n");
+    std::printf("  500x20 table, %zu visible-cell hit tests: %.2f ms\n", hits, ms);
+    REQUIRE(ms < 100.0);
+}
+
 TEST_CASE("Table borders", "[table]") {
     Table table(2, 2);
 
@@ -1656,3 +1656,80 @@ TEST_CASE("Page breaks", "[text_buffer][pagebreak]") {
         REQUIRE(buffer.hasPageBreakBefore(buffer.caret().row));
     }
 }
+
+TEST_CASE("Paragraph formats are shared between lines", "[text_buffer][format]") {
+    static_assert(sizeof(LineExtent) == 16, "per-line hot record stays small");
+
+    TextBuffer buffer;
+    std::string text;
+    for (int i = 0; i < 1000; ++i) text += "Line " + std::to_string(i) + "\n";
+    buffer.setText(text);
+    REQUIRE(buffer.paragraphFormatCount() == 1);  // Everything is default
+
+    SECTION("identical formats are stored once") {
+        for (std::size_t row = 10; row < 20; ++row) {
+            buffer.setCaret({row, 0});
+            buffer.setCurrentParagraphStyle(ParagraphStyle::Heading2);
+            buffer.setCurrentAlignment(TextAlignment::Center);
+        }
+        // Default, Heading2 on its way to centred, and the final format
+        REQUIRE(buffer.paragraphFormatCount() == 3);
+        REQUIRE(buffer.lineParagraphStyle(15) == ParagraphStyle::Heading2);
+        REQUIRE(buffer.lineAlignment(19) == TextAlignment::Center);
+        REQUIRE(buffer.lineSpan(19).alignment == TextAlignment::Center);
+        REQUIRE(buffer.lineAlignment(20) == TextAlignment::Left);
+
+        // Changing one line leaves the others sharing the format alone
+        buffer.setCaret({12, 0});
+        buffer.setCurrentAlignment(TextAlignment::Right);
+        REQUIRE(buffer.lineAlignment(11) == TextAlignment::Center);
+        REQUIRE(buffer.lineAlignment(12) == TextAlignment::Right);
+    }
+
+    SECTION("formats follow their lines through edits") {
+        buffer.setCaret({500, 0});
+        buffer.setCurrentParagraphStyle(ParagraphStyle::Title);
+        buffer.setCaret({501, 0});
+        buffer.increaseIndent(40);
+
+        // Join two earlier lines, then split one: rows below move
+        buffer.setCaret({100, 0});
+        buffer.backspace();
+        REQUIRE(buffer.lineParagraphStyle(499) == ParagraphStyle::Title);
+        REQUIRE(buffer.lineLeftIndent(500) == 40);
+        buffer.setCaret({0, 2});
+        buffer.insertChar('\n');
+        REQUIRE(buffer.lineParagraphStyle(500) == ParagraphStyle::Title);
+        REQUIRE(buffer.lineLeftIndent(501) == 40);
+
+        // A selection spanning lines rebuilds the index
+        buffer.setCaret({2, 0});
+        buffer.setSelectionAnchor({2, 0});
+        buffer.setCaret({5, 0});
+        buffer.updateSelectionToCaret();
+        buffer.deleteSelection();
+        REQUIRE(buffer.lineParagraphStyle(497) == ParagraphStyle::Title);
+        REQUIRE(buffer.lineLeftIndent(498) == 40);
+        REQUIRE(buffer.lineParagraphStyle(496) == ParagraphStyle::Normal);
+
+        // New text starts over with defaults only
+        buffer.setText("fresh");
+        REQUIRE(buffer.paragraphFormatCount() == 1);
+        REQUIRE(buffer.lineParagraphStyle(0) == ParagraphStyle::Normal);
+    }
+
+    SECTION("renumbering a long list does not pile up formats") {
+        for (std::size_t row = 0; row < 1000; ++row) {
+            buffer.setCaret({row, 0});
+            buffer.toggleNumberedList();
+        }
+        REQUIRE(buffer.lineListNumber(999) == 1000);
+        for (int pass = 0; pass < 5; ++pass) {
+            buffer.setCaret({0, 0});
+            buffer.increaseListLevel();
+            buffer.decreaseListLevel();
+        }
+        REQUIRE(buffer.lineListNumber(999) == 1000);
+        REQUIRE(buffer.paragraphFormatCount() <= 2 * buffer.lineCount());
+    }
+}